@@ -0,0 +1,58 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "chunkplanner.h"
+
+#include <cassert>
+
+namespace WebmUtil
+{
+
+bool ChunkPlanner::Plan(Source& source,
+                        long long duration,
+                        int count,
+                        chunks_t& chunks)
+{
+    assert(duration > 0);
+    assert(count > 0);
+
+    chunks.clear();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const long long nominal = duration * i / count;
+        const long long start = source.Seek(nominal);
+
+        if (start < 0)
+            return false;
+
+        // A start that isn't past the previous one is the same keyframe
+        // (or one before it), so that range is already covered.  A start
+        // at or past the end means there's nothing left to encode.
+
+        if (!chunks.empty() && (start <= chunks.back().start))
+            continue;
+
+        if (start >= duration)
+            break;
+
+        if (!chunks.empty())
+            chunks.back().stop = start;
+
+        Chunk c;
+
+        c.start = start;
+        c.stop = duration;
+
+        chunks.push_back(c);
+    }
+
+    return true;
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,66 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_CHUNKPLANNER_HPP__
+#define __WEBMDSHOW_COMMON_CHUNKPLANNER_HPP__
+
+#pragma once
+
+#include <vector>
+
+// Splits the input of a chunked encode into time ranges, one per encoder.
+//
+// A demuxer doesn't start where it's asked to: webmsplit, for example,
+// starts from the keyframe at or before the seek time, and its timestamps
+// are relative to that keyframe.  So each range starts where the source
+// actually starts after a seek to the nominal start, and that is the time
+// that the chunk's timestamps are offset by when the chunks are stitched.
+// When keyframes are further apart than the nominal ranges, several of
+// them start from the same frame; those are merged, so that no frame is
+// encoded twice.
+//
+// All times are in 100-ns units.
+
+namespace WebmUtil
+{
+
+class ChunkPlanner
+{
+    ChunkPlanner(const ChunkPlanner&);
+    ChunkPlanner& operator=(const ChunkPlanner&);
+
+public:
+
+    class Source
+    {
+    public:
+        // Seeks to |time|, and returns the time of the first frame that
+        // will be delivered from there, or < 0 if the seek failed.
+        virtual long long Seek(long long time) = 0;
+
+    protected:
+        virtual ~Source() {}
+    };
+
+    struct Chunk
+    {
+        long long start;  // as the source reported it
+        long long stop;   // the start of the next chunk, or the duration
+    };
+
+    typedef std::vector<Chunk> chunks_t;
+
+    // Plans at most |count| chunks, of about equal length, that together
+    // cover [0, duration).  Returns false if a seek failed.
+    static bool Plan(Source&, long long duration, int count, chunks_t&);
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_CHUNKPLANNER_HPP__
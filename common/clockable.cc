@@ -9,10 +9,42 @@
 #include "clockable.h"
 #include <vfwmsgs.h>
 #include <cassert>
+#include "lockprofiler.h"
+
+
+namespace
+{
+
+HRESULT GetResult(WebmUtil::HybridLock::Result result)
+{
+    typedef WebmUtil::HybridLock lock_t;
+
+    switch (result)
+    {
+        case lock_t::kOk:
+            return S_OK;
+
+        case lock_t::kTimeout:
+            return VFW_E_TIMEOUT;
+
+        case lock_t::kNotInitialized:
+            return VFW_E_WRONG_STATE;
+
+        case lock_t::kNotOwner:
+            return HRESULT_FROM_WIN32(ERROR_NOT_OWNER);
+
+        case lock_t::kWaitFailed:
+        default:
+            return E_FAIL;
+    }
+}
+
+}  //end anon namespace
 
 
 CLockable::CLockable() :
-    m_hMutex(0)
+    m_site(0),
+    m_acquired(0)
 {
 }
 
@@ -25,73 +57,81 @@ CLockable::~CLockable()
 
 HRESULT CLockable::Init()
 {
-    if (m_hMutex)  //weird
+    if (m_lock.IsInitialized())  //weird
         return S_FALSE;
 
-    m_hMutex = CreateMutex(0, 0, 0);
-
-    if (m_hMutex)
+    if (m_lock.Init())
         return S_OK;
 
     const DWORD e = GetLastError();
-    return HRESULT_FROM_WIN32(e);
+    return e ? HRESULT_FROM_WIN32(e) : E_OUTOFMEMORY;
 }
 
 
 HRESULT CLockable::Final()
 {
-    if (m_hMutex == 0)
+    if (!m_lock.IsInitialized())
         return S_FALSE;
 
-    const BOOL b = CloseHandle(m_hMutex);
-    m_hMutex = 0;
+    m_lock.Final();
+    return S_OK;
+}
 
-    if (b)
-        return S_OK;
 
-    const DWORD e = GetLastError();
-    return HRESULT_FROM_WIN32(e);
+HRESULT CLockable::Seize(DWORD timeout_ms)
+{
+    return Seize(timeout_ms, WEBMUTIL_RETURN_ADDRESS());
 }
 
 
-HRESULT CLockable::Seize(DWORD timeout_ms)
+HRESULT CLockable::Seize(DWORD timeout_ms, const void* site)
 {
-    if (m_hMutex == 0)
-        return VFW_E_WRONG_STATE;
+    using WebmUtil::HybridLock;
+    using WebmUtil::LockProfiler;
 
-    DWORD index;
+    if (!LockProfiler::IsEnabled())
+        return GetResult(m_lock.Acquire(timeout_ms));
 
-    const HRESULT hr = CoWaitForMultipleHandles(
-                            0,  //wait flags
-                            timeout_ms,
-                            1,
-                            &m_hMutex,
-                            &index);
+    HybridLock::WaitInfo info;
 
-    //despite the "S" in this name, this is an error
-    if (hr == RPC_S_CALLPENDING)
-        return VFW_E_TIMEOUT;
+    const HybridLock::Result result = m_lock.Acquire(timeout_ms, &info);
 
-    if (FAILED(hr))
-        return hr;
+    if (result == HybridLock::kNotInitialized)
+        return GetResult(result);
+
+    if (result != HybridLock::kOk)
+    {
+        LockProfiler::OnAcquire(site, info, false);
+        return GetResult(result);
+    }
+
+    if (m_lock.GetRecursionCount() == 1)  //outermost
+    {
+        LockProfiler::OnAcquire(site, info, true);
+
+        m_site = site;
+        m_acquired = HybridLock::GetTicks();
+    }
 
-    assert(index == 0);
     return S_OK;
 }
 
 
 HRESULT CLockable::Release()
 {
-    if (m_hMutex == 0)
-        return VFW_E_WRONG_STATE;
+    using WebmUtil::HybridLock;
 
-    const BOOL b = ReleaseMutex(m_hMutex);
+    if (m_site &&
+        m_lock.IsOwnedByCurrentThread() &&
+        (m_lock.GetRecursionCount() == 1))
+    {
+        const long long hold = HybridLock::GetTicks() - m_acquired;
+        WebmUtil::LockProfiler::OnRelease(m_site, hold);
 
-    if (b)
-        return S_OK;
+        m_site = 0;
+    }
 
-    const DWORD e = GetLastError();
-    return HRESULT_FROM_WIN32(e);
+    return GetResult(m_lock.Release());
 }
 
 
@@ -115,7 +155,7 @@ HRESULT CLockable::Lock::Seize(CLockable* pLockable)
     if (m_pLockable)
         return VFW_E_WRONG_STATE;
 
-    const HRESULT hr = pLockable->Seize(5000);
+    const HRESULT hr = pLockable->Seize(5000, WEBMUTIL_RETURN_ADDRESS());
 
     if (FAILED(hr))
         return hr;
@@ -8,6 +8,12 @@
 
 #pragma once
 #include <objbase.h>
+#include "hybridlock.h"
+
+//Seize waits for at most timeout_ms, returning VFW_E_TIMEOUT on expiry.
+//The lock is recursive, as the kernel mutex it used to wrap was, and an
+//uncontended Seize/Release pair never leaves user mode (see HybridLock).
+//Set WEBMDSHOW_LOCK_PROFILE to profile the lock sites (see LockProfiler).
 
 class CLockable
 {
@@ -46,6 +52,13 @@ public:
 
 private:
 
-    HANDLE m_hMutex;
+    HRESULT Seize(DWORD timeout_ms, const void* site);
+
+    WebmUtil::HybridLock m_lock;
+
+    //The site and time of the outermost acquisition, when it is profiled
+    //(these are only touched by the owner).
+    const void* m_site;
+    long long m_acquired;
 
 };
@@ -79,6 +79,19 @@ HRESULT CMediaSample::Factory::Destroy(CMemAllocator*)
 }
 
 
+bool CMediaSample::Factory::IsLockFree()
+{
+    //Initialize and Finalize touch the sample itself, except that Finalize
+    //also releases the owner of memory attached to the sample (the
+    //webmsplit reader's frame lock, for in-place frames).  That release
+    //only makes interlocked decrements of counts the lock shares with the
+    //reader, and releases the source's page buffers (which takes that
+    //allocator's own lock, never ours), so it doesn't need our lock.
+
+    return true;
+}
+
+
 HRESULT CMediaSample::CreateAllocator(IMemAllocator** pp)
 {
     if (pp == 0)
@@ -166,6 +179,34 @@ HRESULT CMediaSample::Finalize()
     MediaTypeUtil::Free(m_pmt);
     m_pmt = 0;
 
+    return Attach(0, 0, 0);  //release external memory
+}
+
+
+HRESULT CMediaSample::Attach(BYTE* ptr, long len, IUnknown* pOwner)
+{
+    if ((ptr != 0) && (len < 0))
+        return E_INVALIDARG;
+
+    if (pOwner)
+        pOwner->AddRef();
+
+    if (m_pExtOwner)
+        m_pExtOwner->Release();  //unlocks the external memory
+
+    m_pExtOwner = pOwner;
+
+    if (ptr == 0)
+    {
+        m_ext_ptr = 0;
+        m_ext_len = 0;
+    }
+    else
+    {
+        m_ext_ptr = ptr;
+        m_ext_len = len;
+    }
+
     return S_OK;
 }
 
@@ -183,6 +224,9 @@ CMediaSample::CMediaSample(CMemAllocator* p) :
     m_buf(0),
     m_buflen(0),
     m_off(0),
+    m_ext_ptr(0),
+    m_ext_len(0),
+    m_pExtOwner(0),
     m_pmt(0)
 {
 }
@@ -211,6 +255,9 @@ HRESULT CMediaSample::QueryInterface(const IID& iid, void** ppv)
     else if (iid == __uuidof(IMemSample))
         pUnk = static_cast<IMemSample*>(this);
 
+    else if (iid == __uuidof(IExternalBufferSample))
+        pUnk = static_cast<IExternalBufferSample*>(this);
+
     else
     {
         pUnk = 0;
@@ -245,6 +292,12 @@ HRESULT CMediaSample::GetPointer(BYTE** pp)
 
     BYTE*& p = *pp;
 
+    if (m_ext_ptr)
+    {
+        p = m_ext_ptr;
+        return S_OK;
+    }
+
     assert(m_buf);
     assert(m_buflen >= 0);
     assert(m_off >= 0);
@@ -268,6 +321,9 @@ HRESULT CMediaSample::GetPointer(BYTE** pp)
 
 long CMediaSample::GetSize()
 {
+    if (m_ext_ptr)
+        return m_ext_len;
+
     assert(m_off <= m_buflen);
 
     const long size = m_buflen - m_off;
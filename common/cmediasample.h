@@ -9,9 +9,11 @@
 #pragma once
 #include "cmemallocator.h"
 #include "imemsample.h"
+#include "iexternalbuffersample.h"
 
 class CMediaSample : public IMediaSample,
-                     public IMemSample
+                     public IMemSample,
+                     public IExternalBufferSample
 {
     CMediaSample(const CMediaSample&);
     CMediaSample& operator=(const CMediaSample&);
@@ -30,6 +32,7 @@ protected:
         HRESULT FinalizeSample(IMemSample*);
         HRESULT DestroySample(IMemSample*);
         HRESULT Destroy(CMemAllocator*);
+        bool IsLockFree();
     };
 
 public:
@@ -47,6 +50,10 @@ public:
     HRESULT STDMETHODCALLTYPE Finalize();
     HRESULT STDMETHODCALLTYPE Destroy();
 
+    //IExternalBufferSample interface:
+
+    HRESULT STDMETHODCALLTYPE Attach(BYTE*, long, IUnknown*);
+
     //IMediaSample interface:
 
     HRESULT STDMETHODCALLTYPE GetPointer(
@@ -117,6 +124,10 @@ private:
     long m_buflen;  //how much memory was allocated
     long m_off;     //to satisfy alignment requirements
 
+    BYTE* m_ext_ptr;  //non-null when attached to external memory
+    long m_ext_len;
+    IUnknown* m_pExtOwner;
+
     AM_MEDIA_TYPE* m_pmt;
 
 };
@@ -10,6 +10,7 @@
 #include "cmemallocator.h"
 #include <vfwmsgs.h>
 #include <cassert>
+#include <climits>
 #include <new>
 
 
@@ -40,9 +41,12 @@ CMemAllocator::CMemAllocator(ISampleFactory* pFactory) :
     m_pSampleFactory(pFactory),
     m_cRef(1),
     m_cActive(-1),  //means "properties not set"
-    m_bCommitted(false)
+    m_cWaiters(0),
+    m_state(0)
 {
-    m_hCond = CreateEvent(0, 0, 0, 0);
+    //A semaphore rather than an auto-reset event, so that Decommit can
+    //wake every thread waiting in GetBuffer, not just one of them.
+    m_hCond = CreateSemaphore(0, 0, LONG_MAX, 0);
     assert(m_hCond);  //TODO
 
     const HRESULT hr = CLockable::Init();
@@ -54,8 +58,20 @@ CMemAllocator::CMemAllocator(ISampleFactory* pFactory) :
 CMemAllocator::~CMemAllocator()
 {
     assert(m_cActive <= 0);
-    assert(m_samples.empty());
-    assert(!m_bCommitted);
+    assert(!IsCommitted());
+    assert(m_cWaiters == 0);
+
+    typedef samples_t::const_iterator iter_t;
+
+    iter_t i = m_samples.begin();
+    const iter_t j = m_samples.end();
+
+    while (i != j)
+    {
+        const IMemSample* const pSample = *i++;
+        pSample;
+        assert(pSample == 0);
+    }
 
     const BOOL b = CloseHandle(m_hCond);
     b;
@@ -122,7 +138,7 @@ HRESULT CMemAllocator::SetProperties(
     if (FAILED(hr))
         return hr;
 
-    if (m_bCommitted)
+    if (IsCommitted())
         return VFW_E_ALREADY_COMMITTED;
 
     if (m_cActive > 0)
@@ -132,7 +148,7 @@ HRESULT CMemAllocator::SetProperties(
     {
         m_props.cBuffers = 0;
         m_props.cbBuffer = 0;
-        m_props.cbAlign = 1;
+        m_props.cbAlign = kMinAlign;
         m_props.cbPrefix = 0;
     }
     else
@@ -145,8 +161,13 @@ HRESULT CMemAllocator::SetProperties(
         if (m_props.cbBuffer < 0)
             m_props.cbBuffer = 0;
 
-        if (m_props.cbAlign <= 0)
-            m_props.cbAlign = 1;
+        //Align every buffer to (at least) a cache line, so that samples
+        //in use by different threads never share one, and so that SIMD
+        //code can use aligned loads and stores.  This is always a legal
+        //answer, since the actual alignment may exceed the preferred one.
+
+        if (m_props.cbAlign < kMinAlign)
+            m_props.cbAlign = kMinAlign;
 
         if (m_props.cbPrefix < 0)
             m_props.cbPrefix = 0;
@@ -190,7 +211,7 @@ HRESULT CMemAllocator::Commit()
     if (FAILED(hr))
         return hr;
 
-    if (m_bCommitted)
+    if (IsCommitted())
         return S_OK;
 
     if (m_cActive > 0)
@@ -199,17 +220,25 @@ HRESULT CMemAllocator::Commit()
     if (m_cActive < 0)
         return VFW_E_SIZENOTSET;
 
-    assert(m_samples.empty());
+    //Samples left over from the previous commit have all been destroyed,
+    //either by Decommit or when they were returned.
+    m_samples.clear();
+
+    if (!m_free.Init(m_props.cBuffers))
+        return E_OUTOFMEMORY;
 
     for (long i = 0; i < m_props.cBuffers; ++i)
     {
         hr = CreateSample();
 
         if (FAILED(hr))
+        {
+            DestroySamples();
             return hr;
+        }
     }
 
-    m_bCommitted = true;
+    m_state |= kCommitted;
 
     return S_OK;
 }
@@ -238,22 +267,26 @@ HRESULT CMemAllocator::Decommit()
     if (FAILED(hr))
         return hr;
 
-    m_bCommitted = false;
+    m_state &= ~kCommitted;
 
-    while (!m_samples.empty())
-    {
-        IMemSample* const sample = m_samples.front();
-        assert(sample);
+    //Threads that were already using the free list when we cleared the
+    //flag get to finish.  They never block while they are doing so, and
+    //new ones will see the flag, so this doesn't take long.
 
-        m_samples.pop_front();
+    while (m_state != 0)
+        SwitchToThread();
 
-        hr = m_pSampleFactory->DestroySample(sample);
-        assert(SUCCEEDED(hr));
-    }
+    DestroySamples();
 
-    const BOOL b = SetEvent(m_hCond);
-    b;
-    assert(b);
+    //Wake up everybody waiting in GetBuffer, so they can see that the
+    //allocator has been decommitted.
+
+    if (const long n = m_cWaiters)
+    {
+        const BOOL b = ReleaseSemaphore(m_hCond, n, 0);
+        b;
+        assert(b);
+    }
 
     return S_OK;
 }
@@ -268,57 +301,45 @@ HRESULT CMemAllocator::GetBuffer(
     if (pp == 0)
         return E_POINTER;
 
-    Lock lock;
-
-    if (flags & AM_GBF_NOWAIT)
-    {
-        const HRESULT hr = lock.Seize(this);
-
-        if (FAILED(hr))
-            return hr;
-
-        if (!m_bCommitted)
-            return VFW_E_NOT_COMMITTED;
+    IMediaSample*& p = *pp;
+    p = 0;
 
-        assert(m_cActive >= 0);
+    const bool bLockFree = m_pSampleFactory->IsLockFree();
 
-        if (m_cActive >= m_props.cBuffers)  //no samples available
-            return VFW_E_TIMEOUT;
-    }
-    else
+    for (;;)
     {
-        for (;;)
+        Lock lock;
+
+        if (!bLockFree)
         {
-            HRESULT hr = lock.Seize(this);
+            const HRESULT hr = lock.Seize(this);
 
             if (FAILED(hr))
                 return hr;
+        }
 
-            if (!m_bCommitted)
-                return VFW_E_NOT_COMMITTED;
+        if (!Enter())
+            return VFW_E_NOT_COMMITTED;
 
-            assert(m_cActive >= 0);
+        const long index = m_free.Pop();
 
-            if (m_cActive < m_props.cBuffers)
-                break;
+        if (index >= 0)
+        {
+            p = GetSample(index);
+            Leave();
 
-            lock.Release();
+            break;
+        }
 
-            DWORD index;
-            hr = CoWaitForMultipleHandles(
-                    0, //wait all
-                    INFINITE,
-                    1,
-                    &m_hCond,
-                    &index);
+        Leave();
 
-            assert(hr == S_OK);
-            assert(index == 0);
-        }
-    }
+        if (flags & AM_GBF_NOWAIT)  //no samples available
+            return VFW_E_TIMEOUT;
 
-    IMediaSample*& p = *pp;
-    p = GetSample();
+        lock.Release();
+
+        Wait();
+    }
 
     AddRef();  //the contribution of this (active) sample
 
@@ -335,36 +356,77 @@ HRESULT CMemAllocator::ReleaseBuffer(IMediaSample* p)
     //assert(p->m_cRef == 0);
     //assert(p->m_pAllocator == this);
 
-    Lock lock;
+    IMemSample* pSample;
 
-    HRESULT hr = lock.Seize(this);
+    HRESULT hr = p->QueryInterface(&pSample);
+    assert(SUCCEEDED(hr));
+    assert(pSample);
 
-    if (FAILED(hr))
-        return hr;
+    //NOTE: we don't bother releasing the IMemSample ptr, because the
+    //sample is in the process of being returned to us.  We don't want
+    //to trigger another call to ReleaseBuffer from IMediaSample::Release.
 
-    assert(m_cActive > 0);
-    --m_cActive;
+    const bool bLockFree = m_pSampleFactory->IsLockFree();
 
-    IMemSample* pSample;
+    Lock lock;
 
-    hr = p->QueryInterface(&pSample);
-    assert(SUCCEEDED(hr));
-    assert(pSample);
+    if (!bLockFree)
+    {
+        hr = lock.Seize(this);
+
+        if (FAILED(hr))
+            return hr;
+    }
+
+    assert(m_cActive > 0);
 
     hr = m_pSampleFactory->FinalizeSample(pSample);
     assert(SUCCEEDED(hr));
 
-    if (m_bCommitted)
-        m_samples.push_back(pSample);
+    if (Enter())
+    {
+        const long index = FindSample(pSample);
+        assert(index >= 0);
+
+        //The sample stops being active before it goes back on the free
+        //list, where another thread might get it immediately.  Commit
+        //can't observe the count in between, since we're still a user.
+        --m_cActive;
+
+        m_free.Push(index);
+        Leave();
+
+        //Pair with the fence in Wait: either the waiter sees the sample
+        //we just pushed, or we see the waiter.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_cWaiters > 0)
+        {
+            const BOOL b = ReleaseSemaphore(m_hCond, 1, 0);
+            b;
+            assert(b);
+        }
+    }
     else
     {
+        if (bLockFree)
+        {
+            hr = lock.Seize(this);
+            assert(SUCCEEDED(hr));  //TODO
+        }
+
+        const long index = FindSample(pSample);
+        assert(index >= 0);
+
+        m_samples[index] = 0;
+
         hr = m_pSampleFactory->DestroySample(pSample);
         assert(SUCCEEDED(hr));
-    }
 
-    const BOOL b = SetEvent(m_hCond);
-    b;
-    assert(b);
+        //Only now that the sample has been destroyed is it no longer
+        //active; Commit relies on this ordering.
+        --m_cActive;
+    }
 
     //Release lock now, in case this sample is holding
     //the last reference to this allocator.
@@ -385,6 +447,63 @@ HRESULT CMemAllocator::ReleaseBuffer(IMediaSample* p)
 }
 
 
+bool CMemAllocator::IsCommitted() const
+{
+    return ((m_state & kCommitted) != 0);
+}
+
+
+bool CMemAllocator::Enter()
+{
+    //Registering as a user and then checking the flag pairs with
+    //Decommit clearing the flag and then checking for users.
+
+    const long state = m_state.fetch_add(kUser);
+
+    if (state & kCommitted)
+        return true;
+
+    m_state -= kUser;
+    return false;
+}
+
+
+void CMemAllocator::Leave()
+{
+    const long state = m_state.fetch_sub(kUser);
+    state;
+    assert(state >= kUser);
+}
+
+
+void CMemAllocator::Wait()
+{
+    //Check again after announcing ourselves, since a sample (or a
+    //Decommit) might have arrived just before we did, and its thread
+    //would not have known to signal us.
+
+    ++m_cWaiters;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (IsCommitted() && m_free.IsEmpty())
+    {
+        DWORD index;
+        const HRESULT hr = CoWaitForMultipleHandles(
+                            0, //wait all
+                            INFINITE,
+                            1,
+                            &m_hCond,
+                            &index);
+        hr;
+        assert(hr == S_OK);
+        assert(index == 0);
+    }
+
+    --m_cWaiters;
+}
+
+
 HRESULT CMemAllocator::CreateSample()
 {
     IMemSample* pSample;
@@ -397,28 +516,55 @@ HRESULT CMemAllocator::CreateSample()
     assert(pSample);
     assert(pSample->GetCount() == 0);
 
+    const long index = static_cast<long>(m_samples.size());
+
     m_samples.push_back(pSample);
+    m_free.Push(index);
 
     return S_OK;
 }
 
 
-IMediaSample* CMemAllocator::GetSample()
+void CMemAllocator::DestroySamples()
 {
-    assert(m_cActive >= 0);
-    assert(m_cActive < m_props.cBuffers);
-    assert(!m_samples.empty());
+    //Destroys the samples on the free list.  The outstanding ones are
+    //destroyed as they are returned.
 
-    IMemSample* const p = m_samples.front();
-    assert(p);
+    for (;;)
+    {
+        const long index = m_free.Pop();
+
+        if (index < 0)
+            break;
 
-    m_samples.pop_front();
+        IMemSample*& pSample = m_samples[index];
+        assert(pSample);
+
+        const HRESULT hr = m_pSampleFactory->DestroySample(pSample);
+        hr;
+        assert(SUCCEEDED(hr));
+
+        pSample = 0;
+    }
+}
+
+
+IMediaSample* CMemAllocator::GetSample(long index)
+{
+    assert(index >= 0);
+    assert(index < long(m_samples.size()));
+
+    IMemSample* const p = m_samples[index];
+    assert(p);
 
     HRESULT hr = m_pSampleFactory->InitializeSample(p);
     assert(SUCCEEDED(hr));
     assert(p->GetCount() == 0);
 
-    ++m_cActive;
+    const long n = ++m_cActive;
+    n;
+    assert(n > 0);
+    assert(n <= m_props.cBuffers);
 
     IMediaSample* pSample;
 
@@ -429,3 +575,20 @@ IMediaSample* CMemAllocator::GetSample()
 
     return pSample;
 }
+
+
+long CMemAllocator::FindSample(IMemSample* pSample) const
+{
+    //The pool is small (a handful of samples), so a scan is cheaper
+    //than keeping an index in each sample.
+
+    const long n = static_cast<long>(m_samples.size());
+
+    for (long i = 0; i < n; ++i)
+    {
+        if (m_samples[i] == pSample)
+            return i;
+    }
+
+    return -1;
+}
@@ -10,7 +10,9 @@
 #include <strmif.h>
 #include "clockable.h"
 #include "imemsample.h"
-#include <list>
+#include "lockfreestack.h"
+#include <atomic>
+#include <vector>
 
 class CMemAllocator : public IMemAllocator,
                       public CLockable
@@ -27,8 +29,17 @@ public:
         virtual HRESULT FinalizeSample(IMemSample*) = 0;
         virtual HRESULT DestroySample(IMemSample*) = 0;
         virtual HRESULT Destroy(CMemAllocator*) = 0;
+
+        //Returns true if InitializeSample and FinalizeSample touch only
+        //the sample itself, so that GetBuffer and ReleaseBuffer can call
+        //them without holding the allocator's lock.
+        virtual bool IsLockFree() = 0;
     };
 
+    //Buffers are aligned to at least this many bytes (a cache line),
+    //whatever alignment the caller asks for.
+    enum { kMinAlign = 64 };
+
 protected:
 
     explicit CMemAllocator(ISampleFactory*);
@@ -72,15 +83,32 @@ public:
 private:
 
     ULONG m_cRef;
-    HANDLE m_hCond;
+    HANDLE m_hCond;  //semaphore, signalled when a sample is returned
     ALLOCATOR_PROPERTIES m_props;
-    bool m_bCommitted;
-    long m_cActive;
+    std::atomic<long> m_cActive;
+    std::atomic<long> m_cWaiters;
+
+    //The committed flag, plus a count of the threads that are using the
+    //free list (on the GetBuffer and ReleaseBuffer paths) without
+    //holding the lock.  Decommit waits for them to finish.
+    std::atomic<long> m_state;
 
-    typedef std::list<IMemSample*> samples_t;
+    enum { kCommitted = 1, kUser = 2 };
+
+    //All of the samples, including the ones that are outstanding.  The
+    //free list holds indexes into this array.
+    typedef std::vector<IMemSample*> samples_t;
     samples_t m_samples;
+    WebmUtil::LockFreeStack m_free;
+
+    bool IsCommitted() const;
+    bool Enter();
+    void Leave();
+    void Wait();
 
     HRESULT CreateSample();
-    IMediaSample* GetSample();
+    void DestroySamples();
+    IMediaSample* GetSample(long);
+    long FindSample(IMemSample*) const;
 
 };
@@ -145,9 +145,9 @@ HRESULT CVP8Sample::SampleFactory::FinalizeSample(IMemSample* p)
     assert(p);
 
     //Note that FinalizeSample is called by the allocator while
-    //it holds its own lock.  There's no special locking we need
-    //to here, because the allocator owns the sample factory
-    //object it was given when it (the allocator) was created.
+    //it holds its own lock (see IsLockFree).  There's no special
+    //locking we need to here, because the allocator owns the sample
+    //factory object it was given when it (the allocator) was created.
 
     IVP8Sample* pSample;
 
@@ -188,6 +188,12 @@ HRESULT CVP8Sample::SampleFactory::Destroy(CMemAllocator*)
 }
 
 
+bool CVP8Sample::SampleFactory::IsLockFree()
+{
+    return false;  //the frame pool is shared by all of the samples
+}
+
+
 void CVP8Sample::SampleFactory::PurgePool()
 {
     while (!m_pool.empty())
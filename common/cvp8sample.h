@@ -114,6 +114,7 @@ protected:
         HRESULT FinalizeSample(IMemSample*);
         HRESULT DestroySample(IMemSample*);
         HRESULT Destroy(CMemAllocator*);
+        bool IsLockFree();
 
         typedef std::list<IVP8Sample::Frame> frames_t;
         frames_t m_pool;  //for reuse
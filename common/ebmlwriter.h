@@ -0,0 +1,354 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_EBMLWRITER_HPP__
+#define __WEBMDSHOW_COMMON_EBMLWRITER_HPP__
+
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include "chromium/base/basictypes.h"
+#include "webmconstants.h"
+
+// EBML elements whose layout is known when the muxer is compiled.  The ID
+// of an element, the width of its size field and, for numbers, the length
+// of its payload are template arguments, so the length of each element is
+// a compile-time constant (and so is that of a run of them), and storing
+// one is a short run of byte stores, with nothing left to decide.  The
+// EbmlScratchBuf and EbmlIO::File writers, by contrast, check each ID and
+// size as they write, and append a byte (or call IStream::Write) at a
+// time.
+//
+// Each element type has a static Store, which writes the element at |p|
+// and returns the end of it.  EbmlWriter strings elements together in a
+// buffer, typically one on the stack that is sized from their kLength:
+//
+//   typedef EbmlMaster<kEbmlVideoSettingsID, 2> Video;
+//   typedef EbmlUInt<kEbmlVideoWidth, 2> Width;
+//
+//   uint8 buf[Video::kHeaderLength + Width::kLength];
+//   EbmlWriter w(buf, sizeof(buf));
+//
+//   uint8* const video = w.Begin<Video>();
+//   w.Write<Width>(width);
+//   w.End<Video>(video);
+//
+// A master element's size is written as "unknown" by Begin, and patched
+// in by End, so a master that's never ended (a live cluster) is still
+// valid.
+
+namespace WebmUtil
+{
+
+// Stores the low |N| bytes of a value, most significant first.
+template <int N>
+struct EbmlBigEndian
+{
+    static void Store(uint8* p, uint64 val)
+    {
+        p[N - 1] = static_cast<uint8>(val);
+        EbmlBigEndian<N - 1>::Store(p, val >> 8);
+    }
+};
+
+template <>
+struct EbmlBigEndian<0>
+{
+    static void Store(uint8*, uint64)
+    {
+    }
+};
+
+// An element ID; the marker bit of the first byte gives its length.
+template <uint32 ID>
+struct EbmlElementID
+{
+    enum
+    {
+        kLength = (ID > 0xFFFFFF) ? 4 : (ID > 0xFFFF) ? 3 : (ID > 0xFF) ? 2 : 1
+    };
+
+    static_assert((ID >> (7 * kLength)) == 1, "not a valid EBML ID");
+
+    static uint8* Store(uint8* p)
+    {
+        EbmlBigEndian<kLength>::Store(p, ID);
+        return p + kLength;
+    }
+};
+
+// A size field (a varying-size integer) of |N| bytes.
+template <int N>
+struct EbmlSize
+{
+    static_assert((N >= 1) && (N <= 8), "EBML sizes are 1 to 8 bytes");
+
+    enum { kLength = N };
+
+    static uint64 GetMarker()
+    {
+        return GG_ULONGLONG(1) << (7 * N);
+    }
+
+    // The largest size that can be stored (all ones means unknown).
+    static uint64 GetMax()
+    {
+        return GetMarker() - 2;
+    }
+
+    static uint8* Store(uint8* p, uint64 size)
+    {
+        assert(size <= GetMax());
+
+        EbmlBigEndian<N>::Store(p, size | GetMarker());
+        return p + N;
+    }
+
+    static uint8* StoreUnknown(uint8* p)
+    {
+        EbmlBigEndian<N>::Store(p, (GetMarker() << 1) - 1);
+        return p + N;
+    }
+};
+
+// An unsigned integer element, with an |N| byte payload.
+template <uint32 ID, int N>
+struct EbmlUInt
+{
+    static_assert((N >= 1) && (N <= 8), "EBML integers are 1 to 8 bytes");
+
+    enum { kLength = EbmlElementID<ID>::kLength + 1 + N };
+
+    static uint8* Store(uint8* p, uint64 val)
+    {
+        assert((val >> (4 * N) >> (4 * N)) == 0);  // fits in N bytes
+
+        p = EbmlElementID<ID>::Store(p);
+        p = EbmlSize<1>::Store(p, N);
+
+        EbmlBigEndian<N>::Store(p, val);
+        return p + N;
+    }
+};
+
+// An unsigned integer element whose payload length is only known when
+// it's written (1 to 8 bytes).
+template <uint32 ID>
+struct EbmlVarUInt
+{
+    enum { kMaxLength = EbmlElementID<ID>::kLength + 1 + 8 };
+
+    static uint8* Store(uint8* p, uint64 val, int size)
+    {
+        switch (size)
+        {
+            case 1:
+                return EbmlUInt<ID, 1>::Store(p, val);
+            case 2:
+                return EbmlUInt<ID, 2>::Store(p, val);
+            case 3:
+                return EbmlUInt<ID, 3>::Store(p, val);
+            case 4:
+                return EbmlUInt<ID, 4>::Store(p, val);
+            case 5:
+                return EbmlUInt<ID, 5>::Store(p, val);
+            case 6:
+                return EbmlUInt<ID, 6>::Store(p, val);
+            case 7:
+                return EbmlUInt<ID, 7>::Store(p, val);
+            case 8:
+                return EbmlUInt<ID, 8>::Store(p, val);
+            default:
+                assert(false);
+                return p;
+        }
+    }
+};
+
+// A 4-byte float element.
+template <uint32 ID>
+struct EbmlFloat
+{
+    enum { kLength = EbmlElementID<ID>::kLength + 1 + 4 };
+
+    static uint8* Store(uint8* p, float val)
+    {
+        uint32 bits;
+        memcpy(&bits, &val, sizeof(bits));
+
+        return EbmlUInt<ID, 4>::Store(p, bits);
+    }
+};
+
+// A string element of up to 126 bytes (so its size fits in one byte).
+template <uint32 ID>
+struct EbmlString
+{
+    enum { kMaxLength = EbmlElementID<ID>::kLength + 1 + 0x7E };
+
+    static int32 GetLength(int32 len)
+    {
+        return EbmlElementID<ID>::kLength + 1 + len;
+    }
+
+    static uint8* Store(uint8* p, const char* str, int32 len)
+    {
+        assert(len >= 0);
+
+        p = EbmlElementID<ID>::Store(p);
+        p = EbmlSize<1>::Store(p, len);
+
+        memcpy(p, str, len);
+        return p + len;
+    }
+};
+
+// A Void element, with an |N| byte payload of zeros.
+template <int N>
+struct EbmlVoid
+{
+    static_assert((N >= 0) && (N <= 0x7E), "use a wider size field");
+
+    enum { kLength = 1 + 1 + N };
+
+    static uint8* Store(uint8* p)
+    {
+        p = EbmlElementID<kEbmlVoidID>::Store(p);
+        p = EbmlSize<1>::Store(p, N);
+
+        memset(p, 0, N);
+        return p + N;
+    }
+};
+
+// The header of a master element: its ID, and a size field of |N| bytes.
+template <uint32 ID, int N>
+struct EbmlMaster
+{
+    enum { kHeaderLength = EbmlElementID<ID>::kLength + N };
+
+    // Stores the ID, and the size as unknown.
+    static uint8* Store(uint8* p)
+    {
+        return EbmlSize<N>::StoreUnknown(EbmlElementID<ID>::Store(p));
+    }
+
+    // Stores the size in the header at |p|.
+    static void SetSize(uint8* p, uint64 size)
+    {
+        EbmlSize<N>::Store(p + EbmlElementID<ID>::kLength, size);
+    }
+};
+
+// Writes elements one after another into a buffer that the caller owns.
+class EbmlWriter
+{
+public:
+    EbmlWriter(uint8* buf, int32 length) :
+        buf_(buf),
+        ptr_(buf),
+        end_(buf + length)
+    {
+        assert(buf);
+        assert(length >= 0);
+    }
+
+    template <class Element>
+    void Write(uint64 val)
+    {
+        Element::Store(Reserve(Element::kLength), val);
+    }
+
+    template <class Element>
+    void WriteFloat(float val)
+    {
+        Element::Store(Reserve(Element::kLength), val);
+    }
+
+    template <uint32 ID>
+    void WriteVarUInt(uint64 val, int size)
+    {
+        EbmlVarUInt<ID>::Store(Reserve(EbmlElementID<ID>::kLength + 1 + size),
+                               val,
+                               size);
+    }
+
+    template <uint32 ID>
+    void WriteString(const char* str, int32 len)
+    {
+        EbmlString<ID>::Store(Reserve(EbmlString<ID>::GetLength(len)),
+                              str,
+                              len);
+    }
+
+    template <int N>
+    void WriteVoid()
+    {
+        EbmlVoid<N>::Store(Reserve(EbmlVoid<N>::kLength));
+    }
+
+    void Write(const void* data, int32 len)
+    {
+        memcpy(Reserve(len), data, len);
+    }
+
+    // Returns the start of the master, to pass to End.
+    template <class Master>
+    uint8* Begin()
+    {
+        uint8* const p = Reserve(Master::kHeaderLength);
+        Master::Store(p);
+
+        return p;
+    }
+
+    // Sets the size of the master at |p| to what has been written since.
+    template <class Master>
+    void End(uint8* p)
+    {
+        assert(p >= buf_);
+        assert(p + Master::kHeaderLength <= ptr_);
+
+        Master::SetSize(p, ptr_ - (p + Master::kHeaderLength));
+    }
+
+    const uint8* GetBufferPtr() const
+    {
+        return buf_;
+    }
+
+    int32 GetLength() const
+    {
+        return static_cast<int32>(ptr_ - buf_);
+    }
+
+private:
+    // Returns where the next |length| bytes go, and moves past them.
+    uint8* Reserve(int32 length)
+    {
+        assert(length >= 0);
+        assert(end_ - ptr_ >= length);
+
+        uint8* const p = ptr_;
+        ptr_ += length;
+
+        return p;
+    }
+
+    uint8* const buf_;
+    uint8* ptr_;
+    uint8* const end_;
+
+    DISALLOW_COPY_AND_ASSIGN(EbmlWriter);
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_EBMLWRITER_HPP__
@@ -0,0 +1,447 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "hybridlock.h"
+
+#include <cassert>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <objbase.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+inline void CpuRelax()
+{
+#if defined(_WIN32)
+    YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+long GetProcessorCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return static_cast<long>(info.dwNumberOfProcessors);
+#else
+    return static_cast<long>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+}  // namespace
+
+#ifdef _WIN32
+
+//An auto-reset event.  The wait goes through CoWaitForMultipleHandles,
+//so that an STA thread keeps pumping while it waits.
+
+class HybridLock::Parker
+{
+    Parker(const Parker&);
+    Parker& operator=(const Parker&);
+
+public:
+
+    Parker() : m_hEvent(0)
+    {
+    }
+
+    ~Parker()
+    {
+        if (m_hEvent)
+        {
+            const BOOL b = CloseHandle(m_hEvent);
+            b;
+            assert(b);
+        }
+    }
+
+    bool Init()
+    {
+        m_hEvent = CreateEvent(0, FALSE, FALSE, 0);
+        return (m_hEvent != 0);
+    }
+
+    Result Wait(unsigned long timeout_ms)
+    {
+        DWORD index;
+
+        const HRESULT hr = CoWaitForMultipleHandles(
+                                0,  //wait flags
+                                timeout_ms,
+                                1,
+                                &m_hEvent,
+                                &index);
+
+        //despite the "S" in this name, this is an error
+        if (hr == RPC_S_CALLPENDING)
+            return kTimeout;
+
+        if (FAILED(hr))
+            return kWaitFailed;
+
+        return kOk;
+    }
+
+    void Wake()
+    {
+        const BOOL b = SetEvent(m_hEvent);
+        b;
+        assert(b);
+    }
+
+private:
+
+    HANDLE m_hEvent;
+
+};
+
+#else
+
+//An auto-reset event, built from a mutex and a condition variable.
+
+class HybridLock::Parker
+{
+    Parker(const Parker&);
+    Parker& operator=(const Parker&);
+
+public:
+
+    Parker() : m_signaled(false)
+    {
+    }
+
+    bool Init()
+    {
+        return true;
+    }
+
+    Result Wait(unsigned long timeout_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (timeout_ms == kInfinite)
+        {
+            while (!m_signaled)
+                m_cond.wait(lock);
+        }
+        else
+        {
+            const std::chrono::milliseconds timeout(timeout_ms);
+
+            if (!m_cond.wait_for(lock, timeout, [this] { return m_signaled; }))
+                return kTimeout;
+        }
+
+        m_signaled = false;
+        return kOk;
+    }
+
+    void Wake()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_signaled = true;
+        }
+
+        m_cond.notify_one();
+    }
+
+private:
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_signaled;
+
+};
+
+#endif  // _WIN32
+
+
+HybridLock::HybridLock() :
+    m_state(kUnlocked),
+    m_owner(0),
+    m_recursion(0),
+    m_spin(kMinSpin),
+    m_max_spin(0),
+    m_parker(0)
+{
+}
+
+
+HybridLock::~HybridLock()
+{
+    Final();
+}
+
+
+bool HybridLock::Init()
+{
+    if (m_parker)  //weird
+        return true;
+
+    Parker* const parker = new (std::nothrow) Parker;
+
+    if (parker == 0)
+        return false;
+
+    if (!parker->Init())
+    {
+        delete parker;
+        return false;
+    }
+
+    //Spinning on a uniprocessor only burns the owner's time slice.
+    m_max_spin = (GetProcessorCount() > 1) ? kMaxSpin : 0;
+
+    m_parker = parker;
+    return true;
+}
+
+
+void HybridLock::Final()
+{
+    delete m_parker;
+    m_parker = 0;
+}
+
+
+bool HybridLock::IsInitialized() const
+{
+    return (m_parker != 0);
+}
+
+
+HybridLock::Result HybridLock::Acquire(
+    unsigned long timeout_ms,
+    WaitInfo* info)
+{
+    if (info)
+    {
+        info->contended = false;
+        info->wait_ticks = 0;
+    }
+
+    if (m_parker == 0)
+        return kNotInitialized;
+
+    const unsigned long tid = GetCurrentThreadId();
+
+    if (m_owner.load(std::memory_order_relaxed) == tid)
+    {
+        ++m_recursion;
+        return kOk;
+    }
+
+    long state = kUnlocked;
+
+    if (!m_state.compare_exchange_strong(
+            state,
+            kLocked,
+            std::memory_order_acquire))
+    {
+        const long long t0 = GetTicks();
+
+        const Result result = TrySpin() ? kOk : Park(timeout_ms);
+
+        if (info)
+        {
+            info->contended = true;
+            info->wait_ticks = GetTicks() - t0;
+        }
+
+        if (result != kOk)
+            return result;
+    }
+
+    assert(m_owner.load(std::memory_order_relaxed) == 0);
+    assert(m_recursion == 0);
+
+    m_owner.store(tid, std::memory_order_relaxed);
+    m_recursion = 1;
+
+    return kOk;
+}
+
+
+HybridLock::Result HybridLock::Release()
+{
+    if (m_parker == 0)
+        return kNotInitialized;
+
+    if (m_owner.load(std::memory_order_relaxed) != GetCurrentThreadId())
+        return kNotOwner;
+
+    assert(m_recursion > 0);
+
+    if (--m_recursion > 0)
+        return kOk;
+
+    m_owner.store(0, std::memory_order_relaxed);
+
+    //Only pay for the wake-up when somebody might be parked.
+    if (m_state.exchange(kUnlocked, std::memory_order_release) ==
+        kLockedWithWaiters)
+    {
+        m_parker->Wake();
+    }
+
+    return kOk;
+}
+
+
+bool HybridLock::IsOwnedByCurrentThread() const
+{
+    return (m_owner.load(std::memory_order_relaxed) == GetCurrentThreadId());
+}
+
+
+long HybridLock::GetRecursionCount() const
+{
+    return m_recursion;
+}
+
+
+bool HybridLock::TrySpin()
+{
+    if (m_max_spin <= 0)
+        return false;
+
+    //Spin for up to twice the recent average, so the count can grow when
+    //spinning pays off, and decays when it doesn't.
+    const long spin = m_spin.load(std::memory_order_relaxed);
+    long max_spin = 2 * spin + 10;
+
+    if (max_spin > m_max_spin)
+        max_spin = m_max_spin;
+
+    long n = 0;
+
+    while (n < max_spin)
+    {
+        if (m_state.load(std::memory_order_relaxed) == kUnlocked)
+        {
+            long state = kUnlocked;
+
+            if (m_state.compare_exchange_weak(
+                    state,
+                    kLocked,
+                    std::memory_order_acquire))
+            {
+                m_spin.store(spin + (n - spin) / 8, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        CpuRelax();
+        ++n;
+    }
+
+    m_spin.store(spin + (n - spin) / 8, std::memory_order_relaxed);
+    return false;
+}
+
+
+HybridLock::Result HybridLock::Park(unsigned long timeout_ms)
+{
+    const long long start = GetTicks();
+    const long long freq = GetTicksPerSecond();
+
+    //Marking the lock as having waiters before we park guarantees that the
+    //owner will wake us.  When the exchange returns kUnlocked we own the
+    //lock (still marked as having waiters, which at worst costs the next
+    //release a spurious wake-up).
+
+    while (m_state.exchange(kLockedWithWaiters, std::memory_order_acquire) !=
+           kUnlocked)
+    {
+        unsigned long wait_ms = timeout_ms;
+
+        if (timeout_ms != kInfinite)
+        {
+            const long long elapsed_ms = (GetTicks() - start) * 1000 / freq;
+
+            if (elapsed_ms >= static_cast<long long>(timeout_ms))
+                return kTimeout;
+
+            wait_ms = timeout_ms - static_cast<unsigned long>(elapsed_ms);
+        }
+
+        const Result result = m_parker->Wait(wait_ms);
+
+        if (result == kWaitFailed)
+            return result;
+
+        //On kTimeout, try once more before reporting it.
+    }
+
+    return kOk;
+}
+
+
+long long HybridLock::GetTicks()
+{
+#ifdef _WIN32
+    LARGE_INTEGER t;
+
+    const BOOL b = QueryPerformanceCounter(&t);
+    b;
+    assert(b);
+
+    return t.QuadPart;
+#else
+    using namespace std::chrono;
+
+    const steady_clock::duration t = steady_clock::now().time_since_epoch();
+    return duration_cast<nanoseconds>(t).count();
+#endif
+}
+
+
+long long HybridLock::GetTicksPerSecond()
+{
+#ifdef _WIN32
+    LARGE_INTEGER f;
+
+    const BOOL b = QueryPerformanceFrequency(&f);
+    b;
+    assert(b);
+
+    return f.QuadPart;
+#else
+    return 1000000000LL;
+#endif
+}
+
+
+unsigned long HybridLock::GetCurrentThreadId()
+{
+#ifdef _WIN32
+    return ::GetCurrentThreadId();
+#else
+    return static_cast<unsigned long>(pthread_self());
+#endif
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,120 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_HYBRIDLOCK_HPP__
+#define __WEBMDSHOW_COMMON_HYBRIDLOCK_HPP__
+
+#pragma once
+
+#include <atomic>
+
+// A recursive lock that stays in user mode unless it has to wait.
+//
+// An uncontended acquisition is a single compare-and-swap.  A thread that
+// finds the lock held first spins for a while (on multiprocessor machines
+// only), and then parks on an event until the owner wakes it up.  The
+// spin count adapts to how long the lock is typically held, the same way
+// glibc's adaptive mutex does.
+//
+// The lock state follows the usual three-state design (unlocked, locked,
+// locked with waiters), so the owner only signals the event when somebody
+// is actually parked on it.
+//
+// Parking is the only platform-specific part (see Parker).  On Windows the
+// wait is made using CoWaitForMultipleHandles, so a thread in an STA keeps
+// dispatching COM calls while it waits, as it did when CLockable waited on
+// a kernel mutex.  Elsewhere a mutex/condition variable pair is used.
+
+namespace WebmUtil
+{
+
+class HybridLock
+{
+    HybridLock(const HybridLock&);
+    HybridLock& operator=(const HybridLock&);
+
+public:
+
+    enum { kInfinite = 0xFFFFFFFF };
+
+    enum Result
+    {
+        kOk = 0,
+        kTimeout = 1,
+        kWaitFailed = 2,  // the platform wait failed (e.g. a COM error)
+        kNotInitialized = 3,
+        kNotOwner = 4
+    };
+
+    HybridLock();
+    ~HybridLock();
+
+    // Creates the event that waiters park on.  Returns false if it could
+    // not be created.
+    bool Init();
+    void Final();
+    bool IsInitialized() const;
+
+    struct WaitInfo
+    {
+        bool contended;        // the lock was not free on the first try
+        long long wait_ticks;  // time spent spinning and parked
+    };
+
+    // Acquires the lock, waiting at most timeout_ms milliseconds.  The
+    // lock is recursive: the owner may acquire it again, and must release
+    // it as many times.  The (optional) info describes the wait.
+    Result Acquire(unsigned long timeout_ms, WaitInfo* info = 0);
+
+    Result Release();
+
+    bool IsOwnedByCurrentThread() const;
+
+    // How many times the owner holds the lock (only meaningful when called
+    // by the owner).
+    long GetRecursionCount() const;
+
+    // Monotonic clock used by the lock and the profiler.
+    static long long GetTicks();
+    static long long GetTicksPerSecond();
+
+    static unsigned long GetCurrentThreadId();
+
+private:
+
+    enum
+    {
+        kUnlocked = 0,
+        kLocked = 1,
+        kLockedWithWaiters = 2
+    };
+
+    enum
+    {
+        kMinSpin = 16,
+        kMaxSpin = 4000
+    };
+
+    class Parker;
+
+    std::atomic<long> m_state;
+    std::atomic<unsigned long> m_owner;
+    long m_recursion;  // touched only by the owner
+    std::atomic<long> m_spin;  // adaptive spin count (only a hint)
+    long m_max_spin;  // 0 on a uniprocessor
+
+    Parker* m_parker;
+
+    bool TrySpin();
+    Result Park(unsigned long timeout_ms);
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_HYBRIDLOCK_HPP__
@@ -0,0 +1,24 @@
+// Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+
+//A media sample that can be made to point to memory it does not own,
+//instead of its own buffer.  The owner object is held by the sample,
+//and released when the sample returns to its allocator (or when the
+//sample is detached by attaching a null pointer).
+
+[
+    uuid(ED31110B-5211-11DF-94AF-0026B977EEAA)
+]
+interface IExternalBufferSample : IUnknown
+{
+
+    virtual HRESULT Attach(BYTE* ptr, long len, IUnknown* pOwner) = 0;
+
+};
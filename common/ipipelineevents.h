@@ -0,0 +1,28 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "pipelineevents.h"
+
+//Implemented by the webm filters that make decisions of their own while
+//the graph runs (the VP8/VP9 encoder's speed governor, for instance), so
+//that a client can log them alongside IPipelineStats.  Events are
+//returned oldest first, and each one only once.
+
+[
+    uuid(ED31110F-5211-11DF-94AF-0026B977EEAA)
+]
+interface IPipelineEvents : IUnknown
+{
+
+    typedef WebmUtil::PipelineEvents::Event Event;
+
+    //Returns S_FALSE when there are no more events.
+    virtual HRESULT STDMETHODCALLTYPE GetEvent(Event* pEvent) = 0;
+
+};
@@ -0,0 +1,34 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "pipelinestats.h"
+
+//Implemented by each of the webm filters, so that a client can tell which
+//filter in a graph is the bottleneck.  A filter reports on each of its
+//streams (normally one per pin), in pin order.  The counters run from the
+//time the filter is created (or last reset), and may be read while the
+//graph is running.
+
+[
+    uuid(ED31110E-5211-11DF-94AF-0026B977EEAA)
+]
+interface IPipelineStats : IUnknown
+{
+
+    typedef WebmUtil::PipelineStats::Snapshot Snapshot;
+
+    virtual ULONG STDMETHODCALLTYPE GetStreamCount() = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetStreamStats(
+        ULONG index,
+        Snapshot* pStats) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE ResetStats() = 0;
+
+};
@@ -55,4 +55,36 @@ bool LibyuvScaleI420(uint32_t width, uint32_t height,
   return true;
 }
 
+bool LibyuvConvertYUY2ToI420(const uint8_t* source, int stride,
+                             uint32_t width, uint32_t height,
+                             vpx_image_t** target_image) {
+  vpx_image_t* target = *target_image;
+  if (target != NULL && (target->d_h != height || target->d_w != width)) {
+    vpx_img_free(target);
+    target = NULL;
+  }
+
+  if (target == NULL) {
+    target = vpx_img_alloc(NULL, VPX_IMG_FMT_I420, width, height, 16);
+    if (target == NULL) {
+      assert(target && "Out of memory.");
+      return false;
+    }
+  }
+
+  const int convert_status = libyuv::YUY2ToI420(
+      source, stride,
+      target->planes[VPX_PLANE_Y], target->stride[VPX_PLANE_Y],
+      target->planes[VPX_PLANE_U], target->stride[VPX_PLANE_U],
+      target->planes[VPX_PLANE_V], target->stride[VPX_PLANE_V],
+      width, height);
+  if (convert_status != 0) {
+    assert(convert_status == 0 && "libyuv::YUY2ToI420 failed.");
+    return false;
+  }
+
+  *target_image = target;
+  return true;
+}
+
 }  // namespace webmdshow
\ No newline at end of file
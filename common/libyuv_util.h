@@ -21,6 +21,13 @@ namespace webmdshow {
 bool LibyuvScaleI420(uint32_t width, uint32_t height,
                      const vpx_image_t* source, vpx_image_t** target);
 
+// Converts the packed YUY2 image at |source| (|width|x|height|, with rows
+// |stride| bytes apart) to VPX_IMG_FMT_I420. |target| will be allocated if
+// necessary. Caller owns any allocated memory. Returns true upon success.
+bool LibyuvConvertYUY2ToI420(const uint8_t* source, int stride,
+                             uint32_t width, uint32_t height,
+                             vpx_image_t** target);
+
 }  // namespace webmdshow
 
 #endif  // WEBMDSHOW_COMMON_LIBYUV_UTIL_H_
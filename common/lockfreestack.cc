@@ -0,0 +1,148 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "lockfreestack.h"
+
+#include <cassert>
+#include <new>
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+//The low half of the head is the top index plus 1 (0 means empty), and the
+//high half is the tag.
+
+inline unsigned long GetTop(unsigned long long head)
+{
+    return static_cast<unsigned long>(head & 0xFFFFFFFF);
+}
+
+inline unsigned long long MakeHead(
+    unsigned long long old_head,
+    unsigned long top)
+{
+    const unsigned long long tag = (old_head >> 32) + 1;
+    return (tag << 32) | top;
+}
+
+}  // namespace
+
+
+LockFreeStack::LockFreeStack() :
+    m_head(0),
+    m_next(0),
+    m_capacity(0)
+{
+}
+
+
+LockFreeStack::~LockFreeStack()
+{
+    delete[] m_next;
+}
+
+
+bool LockFreeStack::Init(long capacity)
+{
+    assert(capacity >= 0);
+
+    if (capacity != m_capacity)
+    {
+        delete[] m_next;
+        m_next = 0;
+        m_capacity = 0;
+
+        if (capacity > 0)
+        {
+            m_next = new (std::nothrow) std::atomic<long>[capacity];
+
+            if (m_next == 0)
+                return false;
+        }
+
+        m_capacity = capacity;
+    }
+
+    for (long i = 0; i < m_capacity; ++i)
+        m_next[i].store(0, std::memory_order_relaxed);
+
+    m_head.store(0);
+
+    return true;
+}
+
+
+long LockFreeStack::GetCapacity() const
+{
+    return m_capacity;
+}
+
+
+void LockFreeStack::Push(long index)
+{
+    assert(index >= 0);
+    assert(index < m_capacity);
+
+    head_t head = m_head.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        m_next[index].store(GetTop(head), std::memory_order_relaxed);
+
+        const head_t new_head = MakeHead(head, index + 1);
+
+        if (m_head.compare_exchange_weak(
+                head,
+                new_head,
+                std::memory_order_release,
+                std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+
+long LockFreeStack::Pop()
+{
+    head_t head = m_head.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        const unsigned long top = GetTop(head);
+
+        if (top == 0)
+            return -1;
+
+        //If another thread pops this entry (and maybe pushes it back) in
+        //the meantime, the tag will have changed, and the CAS fails.
+        const long next = m_next[top - 1].load(std::memory_order_relaxed);
+
+        const head_t new_head = MakeHead(head, next);
+
+        if (m_head.compare_exchange_weak(
+                head,
+                new_head,
+                std::memory_order_acquire,
+                std::memory_order_acquire))
+        {
+            return static_cast<long>(top) - 1;
+        }
+    }
+}
+
+
+bool LockFreeStack::IsEmpty() const
+{
+    return (GetTop(m_head.load(std::memory_order_acquire)) == 0);
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,65 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_LOCKFREESTACK_HPP__
+#define __WEBMDSHOW_COMMON_LOCKFREESTACK_HPP__
+
+#pragma once
+
+#include <atomic>
+
+// A bounded stack of the integers 0 .. capacity-1, which any number of
+// threads can push and pop without taking a lock.  The integers are
+// indices into an array owned by the caller; CMemAllocator uses one as the
+// free list of its sample pool.
+//
+// The links live in a side array (one per index), and the head packs the
+// top index together with a tag that changes on every update, so a pop
+// cannot be fooled when the top is popped and pushed back between its
+// read of the head and its compare-and-swap (the ABA problem).
+
+namespace WebmUtil
+{
+
+class LockFreeStack
+{
+    LockFreeStack(const LockFreeStack&);
+    LockFreeStack& operator=(const LockFreeStack&);
+
+public:
+
+    LockFreeStack();
+    ~LockFreeStack();
+
+    // Sets the capacity, and empties the stack.  This must not be called
+    // while other threads are using the stack.
+    bool Init(long capacity);
+
+    long GetCapacity() const;
+
+    // Each index may be on the stack at most once.
+    void Push(long index);
+
+    // Returns -1 when the stack is empty.
+    long Pop();
+
+    bool IsEmpty() const;
+
+private:
+
+    typedef unsigned long long head_t;
+
+    std::atomic<head_t> m_head;
+    std::atomic<long>* m_next;  // index + 1 of the entry below, or 0
+    long m_capacity;
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_LOCKFREESTACK_HPP__
@@ -0,0 +1,355 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "lockprofiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+struct Entry
+{
+    std::atomic<const void*> address;
+    std::atomic<long long> acquisitions;
+    std::atomic<long long> contentions;
+    std::atomic<long long> timeouts;
+    std::atomic<long long> wait_ticks;
+    std::atomic<long long> max_wait_ticks;
+    std::atomic<long long> hold_ticks;
+    std::atomic<long long> max_hold_ticks;
+};
+
+//Zero-initialized, because it has static storage duration.
+Entry s_entries[LockProfiler::kMaxSites];
+
+std::atomic<long long> s_dropped;
+
+bool ReadEnvironment()
+{
+    const char name[] = "WEBMDSHOW_LOCK_PROFILE";
+
+#ifdef _WIN32
+    char value[8];
+
+    const DWORD n = GetEnvironmentVariableA(name, value, sizeof value);
+
+    if ((n == 0) || (n >= sizeof value))
+        return (n != 0);
+#else
+    const char* const value = getenv(name);
+
+    if (value == 0)
+        return false;
+#endif
+
+    return (strcmp(value, "0") != 0);
+}
+
+std::atomic<bool> s_enabled(ReadEnvironment());
+
+inline void Add(std::atomic<long long>& total, long long value)
+{
+    total.fetch_add(value, std::memory_order_relaxed);
+}
+
+inline void Max(std::atomic<long long>& max_value, long long value)
+{
+    long long old_value = max_value.load(std::memory_order_relaxed);
+
+    while ((value > old_value) &&
+           !max_value.compare_exchange_weak(old_value,
+                                            value,
+                                            std::memory_order_relaxed))
+    {
+    }
+}
+
+//Open addressing with linear probing; entries are claimed (never freed,
+//except by Reset) by a compare-and-swap of the address.
+Entry* Find(const void* address)
+{
+    if (address == 0)
+        return 0;
+
+    typedef unsigned long long key_t;
+    const key_t key = reinterpret_cast<key_t>(address);
+
+    const int n = LockProfiler::kMaxSites;
+    int idx = static_cast<int>(((key >> 4) * 0x9E3779B97F4A7C15ULL) >> 54) % n;
+
+    for (int i = 0; i < n; ++i)
+    {
+        Entry& e = s_entries[idx];
+
+        const void* cur = e.address.load(std::memory_order_acquire);
+
+        if (cur == address)
+            return &e;
+
+        if (cur == 0)
+        {
+            if (e.address.compare_exchange_strong(cur, address))
+                return &e;
+
+            if (cur == address)  //somebody else claimed it for us
+                return &e;
+        }
+
+        if (++idx >= n)
+            idx = 0;
+    }
+
+    s_dropped.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+std::string FormatAddress(const void* address)
+{
+    std::ostringstream os;
+
+#ifdef _WIN32
+    HMODULE hModule;
+
+    const DWORD flags = GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                        GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT;
+
+    char path[MAX_PATH];
+
+    if (GetModuleHandleExA(flags, static_cast<LPCSTR>(address), &hModule) &&
+        GetModuleFileNameA(hModule, path, MAX_PATH))
+    {
+        const char* name = strrchr(path, '\\');
+        name = name ? name + 1 : path;
+
+        const char* const ext = strrchr(name, '.');
+        const size_t len = ext ? size_t(ext - name) : strlen(name);
+
+        const ULONG_PTR offset = ULONG_PTR(address) - ULONG_PTR(hModule);
+
+        os << std::string(name, len) << "+0x" << std::hex << offset;
+        return os.str();
+    }
+#endif
+
+    os << address;
+    return os.str();
+}
+
+bool WorseThan(const LockProfiler::Site& lhs, const LockProfiler::Site& rhs)
+{
+    return (lhs.wait_ticks > rhs.wait_ticks);
+}
+
+//Writes the report when the module unloads, if the profiler was used.
+class Reporter
+{
+public:
+
+    ~Reporter()
+    {
+        if (LockProfiler::GetSites(0, 0) == 0)
+            return;
+
+        std::ostringstream os;
+        LockProfiler::Print(os);
+
+#ifdef _WIN32
+        std::istringstream is(os.str());
+        std::string line;
+
+        while (std::getline(is, line))
+        {
+            line += '\n';
+            OutputDebugStringA(line.c_str());
+        }
+#else
+        fputs(os.str().c_str(), stderr);
+#endif
+    }
+
+};
+
+Reporter s_reporter;
+
+}  // namespace
+
+
+bool LockProfiler::IsEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+
+void LockProfiler::Enable(bool enable)
+{
+    s_enabled.store(enable);
+}
+
+
+void LockProfiler::OnAcquire(
+    const void* site,
+    const HybridLock::WaitInfo& info,
+    bool acquired)
+{
+    Entry* const e = Find(site);
+
+    if (e == 0)
+        return;
+
+    if (acquired)
+        Add(e->acquisitions, 1);
+    else
+        Add(e->timeouts, 1);
+
+    if (info.contended)
+    {
+        Add(e->contentions, 1);
+        Add(e->wait_ticks, info.wait_ticks);
+        Max(e->max_wait_ticks, info.wait_ticks);
+    }
+}
+
+
+void LockProfiler::OnRelease(const void* site, long long hold_ticks)
+{
+    Entry* const e = Find(site);
+
+    if (e == 0)
+        return;
+
+    Add(e->hold_ticks, hold_ticks);
+    Max(e->max_hold_ticks, hold_ticks);
+}
+
+
+int LockProfiler::GetSites(Site* sites, int max_count)
+{
+    int count = 0;
+
+    for (int i = 0; i < kMaxSites; ++i)
+    {
+        const Entry& e = s_entries[i];
+
+        const void* const address = e.address.load(std::memory_order_acquire);
+
+        if (address == 0)
+            continue;
+
+        if (sites == 0)  //just count them
+        {
+            ++count;
+            continue;
+        }
+
+        if (count >= max_count)
+            break;
+
+        Site& s = sites[count++];
+
+        s.address = address;
+        s.acquisitions = e.acquisitions.load(std::memory_order_relaxed);
+        s.contentions = e.contentions.load(std::memory_order_relaxed);
+        s.timeouts = e.timeouts.load(std::memory_order_relaxed);
+        s.wait_ticks = e.wait_ticks.load(std::memory_order_relaxed);
+        s.max_wait_ticks = e.max_wait_ticks.load(std::memory_order_relaxed);
+        s.hold_ticks = e.hold_ticks.load(std::memory_order_relaxed);
+        s.max_hold_ticks = e.max_hold_ticks.load(std::memory_order_relaxed);
+    }
+
+    return count;
+}
+
+
+long long LockProfiler::GetDroppedCount()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+
+void LockProfiler::Reset()
+{
+    //Counts from acquisitions that are in progress may be lost.
+
+    for (int i = 0; i < kMaxSites; ++i)
+    {
+        Entry& e = s_entries[i];
+
+        e.acquisitions.store(0);
+        e.contentions.store(0);
+        e.timeouts.store(0);
+        e.wait_ticks.store(0);
+        e.max_wait_ticks.store(0);
+        e.hold_ticks.store(0);
+        e.max_hold_ticks.store(0);
+        e.address.store(0);
+    }
+
+    s_dropped.store(0);
+}
+
+
+void LockProfiler::Print(std::ostream& os)
+{
+    std::vector<Site> sites(kMaxSites);
+
+    const int count = GetSites(&sites[0], kMaxSites);
+    sites.resize(count);
+
+    std::sort(sites.begin(), sites.end(), WorseThan);
+
+    const double us_per_tick = 1000000.0 / HybridLock::GetTicksPerSecond();
+
+    os << "lock profile: " << count << " sites";
+
+    if (const long long dropped = GetDroppedCount())
+        os << " (" << dropped << " acquisitions not recorded)";
+
+    os << "\n"
+       << "site acquisitions contentions timeouts"
+       << " wait[us] max_wait[us] hold[us] max_hold[us]\n";
+
+    os << std::fixed << std::setprecision(1);
+
+    typedef std::vector<Site>::const_iterator iter_t;
+
+    iter_t i = sites.begin();
+    const iter_t j = sites.end();
+
+    while (i != j)
+    {
+        const Site& s = *i++;
+
+        os << FormatAddress(s.address)
+           << ' ' << s.acquisitions
+           << ' ' << s.contentions
+           << ' ' << s.timeouts
+           << ' ' << s.wait_ticks * us_per_tick
+           << ' ' << s.max_wait_ticks * us_per_tick
+           << ' ' << s.hold_ticks * us_per_tick
+           << ' ' << s.max_hold_ticks * us_per_tick
+           << '\n';
+    }
+}
+
+}  // namespace WebmUtil
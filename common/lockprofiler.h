@@ -0,0 +1,96 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_LOCKPROFILER_HPP__
+#define __WEBMDSHOW_COMMON_LOCKPROFILER_HPP__
+
+#pragma once
+
+#include <ostream>
+
+#include "hybridlock.h"
+
+// Opt-in lock contention profiler.  For each lock site it records how many
+// times the lock was taken there, how many of those times it was contended
+// (and how many timed out), how long the thread waited, and how long the
+// lock was then held.
+//
+// A lock site is identified by the return address of the function that
+// took the lock (e.g. CLockable::Lock::Seize), so no call site has to be
+// annotated.  When printing, an address is shown relative to the module
+// that contains it, so it can be resolved with the module's PDB (e.g.
+// "ln vp8decoder+0x1234" in WinDbg).
+//
+// The profiler is off unless WEBMDSHOW_LOCK_PROFILE is set (to anything but
+// "0") in the environment when the module is loaded, or it is turned on by
+// calling Enable.  When it is off, the cost is one flag test per
+// acquisition.  When it was on, the report is written to the debugger (to
+// stderr on other platforms) when the module unloads.
+//
+// The sites are kept in a fixed-size table updated with atomic operations,
+// so recording never takes a lock itself.
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#define WEBMUTIL_RETURN_ADDRESS() _ReturnAddress()
+#else
+#define WEBMUTIL_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace WebmUtil
+{
+
+class LockProfiler
+{
+    LockProfiler();
+
+public:
+
+    enum { kMaxSites = 1024 };
+
+    struct Site
+    {
+        const void* address;
+        long long acquisitions;
+        long long contentions;
+        long long timeouts;
+        long long wait_ticks;      // HybridLock::GetTicks units
+        long long max_wait_ticks;
+        long long hold_ticks;
+        long long max_hold_ticks;
+    };
+
+    static bool IsEnabled();
+    static void Enable(bool);
+
+    // Called after each (outermost) acquisition attempt.
+    static void OnAcquire(const void* site,
+                          const HybridLock::WaitInfo&,
+                          bool acquired);
+
+    // Called when the lock taken at site is released for good.
+    static void OnRelease(const void* site, long long hold_ticks);
+
+    // Copies (at most max_count of) the sites recorded so far, and returns
+    // how many were copied.  Sites that did not fit in the table are not
+    // recorded, but they are counted (see GetDroppedCount).
+    static int GetSites(Site* sites, int max_count);
+    static long long GetDroppedCount();
+
+    static void Reset();
+
+    // Writes a table of the sites, worst (total wait time) first.  Times
+    // are in microseconds.
+    static void Print(std::ostream&);
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_LOCKPROFILER_HPP__
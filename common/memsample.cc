@@ -0,0 +1,289 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <vfwmsgs.h>
+#include "memsample.h"
+#include <cassert>
+#include <new>
+
+namespace WebmUtil
+{
+
+MemSample::Pool::Pool(long size) : m_size(size)
+{
+    assert(m_size > 0);
+}
+
+
+MemSample::Pool::~Pool()
+{
+    assert(m_free.size() == m_samples.size());  //all were released
+
+    while (!m_samples.empty())
+    {
+        delete m_samples.back();
+        m_samples.pop_back();
+    }
+}
+
+
+MemSample* MemSample::Pool::GetSample()
+{
+    MemSample* pSample;
+
+    if (!m_free.empty())
+    {
+        pSample = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        pSample = new (std::nothrow) MemSample(this, m_size);
+        assert(pSample);  //TODO
+
+        m_samples.push_back(pSample);
+        m_free.reserve(m_samples.size());  //so Release doesn't allocate
+    }
+
+    pSample->Init();
+    return pSample;
+}
+
+
+long MemSample::Pool::GetSize() const
+{
+    return m_size;
+}
+
+
+ULONG MemSample::Pool::GetCount() const
+{
+    return static_cast<ULONG>(m_samples.size());
+}
+
+
+MemSample::MemSample(Pool* pPool, long size) :
+    m_pPool(pPool),
+    m_cRef(0),
+    m_buf(size)
+{
+    //The payload is never decoded, but it shouldn't be all zeros either.
+
+    unsigned int x = 0x12345678;
+
+    for (long i = 0; i < size; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        m_buf[i] = static_cast<BYTE>(x >> 24);
+    }
+}
+
+
+MemSample::~MemSample()
+{
+    assert(m_cRef == 0);
+}
+
+
+void MemSample::Init()
+{
+    assert(m_cRef == 0);
+
+    m_cRef = 1;
+    m_actual = 0;
+    m_time = 0;
+    m_start = 0;
+    m_stop = 0;
+    m_sync = false;
+    m_preroll = false;
+    m_discontinuity = false;
+}
+
+
+HRESULT MemSample::QueryInterface(REFIID iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = static_cast<IMediaSample*>(this);
+
+    else if (iid == __uuidof(IMediaSample))
+        pUnk = static_cast<IMediaSample*>(this);
+
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG MemSample::AddRef()
+{
+    return ++m_cRef;
+}
+
+
+ULONG MemSample::Release()
+{
+    assert(m_cRef > 0);
+
+    if (--m_cRef > 0)
+        return m_cRef;
+
+    m_pPool->m_free.push_back(this);
+    return 0;
+}
+
+
+HRESULT MemSample::GetPointer(BYTE** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    *pp = &m_buf[0];
+    return S_OK;
+}
+
+
+long MemSample::GetSize()
+{
+    return static_cast<long>(m_buf.size());
+}
+
+
+HRESULT MemSample::GetTime(REFERENCE_TIME* pstart, REFERENCE_TIME* pstop)
+{
+    if (m_time == 0)
+        return VFW_E_SAMPLE_TIME_NOT_SET;
+
+    if (pstart)
+        *pstart = m_start;
+
+    if (m_time == 1)
+        return VFW_S_NO_STOP_TIME;
+
+    if (pstop)
+        *pstop = m_stop;
+
+    return S_OK;
+}
+
+
+HRESULT MemSample::SetTime(REFERENCE_TIME* pstart, REFERENCE_TIME* pstop)
+{
+    if (pstart == 0)
+    {
+        m_time = 0;
+        return S_OK;
+    }
+
+    m_start = *pstart;
+
+    if (pstop == 0)
+        m_time = 1;
+    else
+    {
+        m_stop = *pstop;
+        m_time = 2;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT MemSample::IsSyncPoint()
+{
+    return m_sync ? S_OK : S_FALSE;
+}
+
+
+HRESULT MemSample::SetSyncPoint(BOOL b)
+{
+    m_sync = bool(b != 0);
+    return S_OK;
+}
+
+
+HRESULT MemSample::IsPreroll()
+{
+    return m_preroll ? S_OK : S_FALSE;
+}
+
+
+HRESULT MemSample::SetPreroll(BOOL b)
+{
+    m_preroll = bool(b != 0);
+    return S_OK;
+}
+
+
+long MemSample::GetActualDataLength()
+{
+    return m_actual;
+}
+
+
+HRESULT MemSample::SetActualDataLength(long len)
+{
+    if ((len < 0) || (len > GetSize()))
+        return E_INVALIDARG;
+
+    m_actual = len;
+    return S_OK;
+}
+
+
+HRESULT MemSample::GetMediaType(AM_MEDIA_TYPE** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    *pp = 0;
+    return S_FALSE;  //the type never changes
+}
+
+
+HRESULT MemSample::SetMediaType(AM_MEDIA_TYPE* pmt)
+{
+    return (pmt == 0) ? S_OK : E_NOTIMPL;
+}
+
+
+HRESULT MemSample::IsDiscontinuity()
+{
+    return m_discontinuity ? S_OK : S_FALSE;
+}
+
+
+HRESULT MemSample::SetDiscontinuity(BOOL b)
+{
+    m_discontinuity = bool(b != 0);
+    return S_OK;
+}
+
+
+HRESULT MemSample::GetMediaTime(LONGLONG*, LONGLONG*)
+{
+    return VFW_E_MEDIA_TIME_NOT_SET;
+}
+
+
+HRESULT MemSample::SetMediaTime(LONGLONG*, LONGLONG*)
+{
+    return S_OK;
+}
+
+}  //end namespace WebmUtil
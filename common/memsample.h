@@ -0,0 +1,99 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <vector>
+
+namespace WebmUtil
+{
+
+//A media sample with its own buffer.  Samples come from a pool, and are
+//returned to it (not destroyed) when their last reference is released,
+//as they would be with a DirectShow allocator.  The pool grows as
+//required, so after a warm-up run its user allocates nothing itself.
+//Like the portable headers, it is for the tools and tests that are built
+//without the Windows SDK (webmbench and oggtowebm).
+
+class MemSample : public IMediaSample
+{
+    MemSample(const MemSample&);
+    MemSample& operator=(const MemSample&);
+
+public:
+
+    class Pool
+    {
+        Pool(const Pool&);
+        Pool& operator=(const Pool&);
+
+    public:
+
+        explicit Pool(long size);  //of each buffer
+        ~Pool();
+
+        //Returns a sample (with one reference) whose buffer is filled
+        //with arbitrary bytes.
+        MemSample* GetSample();
+
+        long GetSize() const;
+        ULONG GetCount() const;  //samples created
+
+    private:
+
+        const long m_size;
+
+        typedef std::vector<MemSample*> samples_t;
+        samples_t m_samples;
+        samples_t m_free;
+
+        friend class MemSample;
+
+    };
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+    HRESULT STDMETHODCALLTYPE GetPointer(BYTE**);
+    long STDMETHODCALLTYPE GetSize();
+    HRESULT STDMETHODCALLTYPE GetTime(REFERENCE_TIME*, REFERENCE_TIME*);
+    HRESULT STDMETHODCALLTYPE SetTime(REFERENCE_TIME*, REFERENCE_TIME*);
+    HRESULT STDMETHODCALLTYPE IsSyncPoint();
+    HRESULT STDMETHODCALLTYPE SetSyncPoint(BOOL);
+    HRESULT STDMETHODCALLTYPE IsPreroll();
+    HRESULT STDMETHODCALLTYPE SetPreroll(BOOL);
+    long STDMETHODCALLTYPE GetActualDataLength();
+    HRESULT STDMETHODCALLTYPE SetActualDataLength(long);
+    HRESULT STDMETHODCALLTYPE GetMediaType(AM_MEDIA_TYPE**);
+    HRESULT STDMETHODCALLTYPE SetMediaType(AM_MEDIA_TYPE*);
+    HRESULT STDMETHODCALLTYPE IsDiscontinuity();
+    HRESULT STDMETHODCALLTYPE SetDiscontinuity(BOOL);
+    HRESULT STDMETHODCALLTYPE GetMediaTime(LONGLONG*, LONGLONG*);
+    HRESULT STDMETHODCALLTYPE SetMediaTime(LONGLONG*, LONGLONG*);
+
+private:
+
+    MemSample(Pool*, long size);
+    virtual ~MemSample();
+
+    void Init();
+
+    Pool* const m_pPool;
+    ULONG m_cRef;
+    std::vector<BYTE> m_buf;
+    long m_actual;
+    int m_time;  //0 = none, 1 = start only, 2 = start and stop
+    REFERENCE_TIME m_start;
+    REFERENCE_TIME m_stop;
+    bool m_sync;
+    bool m_preroll;
+    bool m_discontinuity;
+
+};
+
+}  //end namespace WebmUtil
@@ -0,0 +1,76 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "oggpacketclock.h"
+
+#include <cassert>
+
+namespace WebmUtil
+{
+
+OggPacketClock::OggPacketClock(unsigned long sample_rate) :
+    m_sample_rate(sample_rate),
+    m_granule_pos(0)
+{
+    assert(m_sample_rate > 0);
+}
+
+
+bool OggPacketClock::OnPage(long long granule_pos, long count, times_t& times)
+{
+    assert(count > 0);
+
+    if (granule_pos < 0)  // EOS, with nothing to say how long these are
+    {
+        const Times t = { GetTime(m_granule_pos), -1 };
+        times.assign(count, t);
+
+        return true;
+    }
+
+    if (granule_pos < m_granule_pos)
+        return false;
+
+    const long long total = granule_pos - m_granule_pos;
+
+    times.resize(count);
+
+    // Each packet ends where the next one starts, and the last one ends
+    // exactly at the page's granule position.
+
+    for (long i = 0; i < count; ++i)
+    {
+        const long long curr = m_granule_pos + (total * i) / count;
+        const long long next = m_granule_pos + (total * (i + 1)) / count;
+
+        times[i].start = GetTime(curr);
+        times[i].stop = GetTime(next);
+    }
+
+    m_granule_pos = granule_pos;
+
+    return true;
+}
+
+
+long long OggPacketClock::GetGranulePos() const
+{
+    return m_granule_pos;
+}
+
+
+long long OggPacketClock::GetTime(long long samples) const
+{
+    // Split the conversion so that it can't overflow.
+    const long long sec = samples / m_sample_rate;
+    const long long rem = samples % m_sample_rate;
+
+    return sec * 10000000 + rem * 10000000 / m_sample_rate;
+}
+
+}  // namespace WebmUtil
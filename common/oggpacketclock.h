@@ -0,0 +1,70 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_OGGPACKETCLOCK_HPP__
+#define __WEBMDSHOW_COMMON_OGGPACKETCLOCK_HPP__
+
+#pragma once
+
+#include <vector>
+
+// Timestamps Ogg packets the way the Ogg source filter does.  A page's
+// granule position is the sample count at the end of the last packet
+// that completes on it, and nothing says where the packets before that
+// one end, so the samples since the previous page are spread evenly over
+// the packets that the page completes.  The first page starts at 0.
+//
+// All times are in 100-ns units.
+
+namespace WebmUtil
+{
+
+class OggPacketClock
+{
+    OggPacketClock(const OggPacketClock&);
+    OggPacketClock& operator=(const OggPacketClock&);
+
+public:
+
+    struct Times
+    {
+        long long start;
+        long long stop;  // < 0 if unknown
+    };
+
+    typedef std::vector<Times> times_t;
+
+    explicit OggPacketClock(unsigned long sample_rate);
+
+    // Times the |count| packets that end on a page whose granule position
+    // is |granule_pos|, and moves the clock to the end of that page.
+    //
+    // A negative granule_pos means that the stream ended on a page that
+    // completed no packet: its packets all start where the previous page
+    // ended, and their stop times are unknown.
+    //
+    // Returns false, and leaves the clock where it was, if granule_pos is
+    // before the end of the previous page.
+    bool OnPage(long long granule_pos, long count, times_t&);
+
+    // The granule position at the end of the last page (0 before the
+    // first one).
+    long long GetGranulePos() const;
+
+    long long GetTime(long long samples) const;
+
+private:
+
+    const unsigned long m_sample_rate;
+    long long m_granule_pos;
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_OGGPACKETCLOCK_HPP__
@@ -0,0 +1,99 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "pipelineevents.h"
+#include "pipelinestats.h"
+
+#include <cassert>
+
+namespace
+{
+
+void Copy(wchar_t* dst, int len, const wchar_t* src)
+{
+    assert(len > 0);
+
+    int i = 0;
+
+    if (src)
+    {
+        while ((i < len - 1) && (src[i] != L'\0'))
+        {
+            dst[i] = src[i];
+            ++i;
+        }
+    }
+
+    dst[i] = L'\0';
+}
+
+}  // namespace
+
+namespace WebmUtil
+{
+
+PipelineEvents::PipelineEvents() : m_dropped(0)
+{
+}
+
+
+void PipelineEvents::Post(
+    const wchar_t* name,
+    const wchar_t* type,
+    const wchar_t* text)
+{
+    Event e;
+
+    e.time_us = PipelineStats::GetMicroseconds();
+
+    Copy(e.name, kNameLength, name);
+    Copy(e.type, kNameLength, type);
+    Copy(e.text, kTextLength, text);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_events.size() >= kMaxEvents)
+    {
+        m_events.pop_front();
+        ++m_dropped;
+    }
+
+    m_events.push_back(e);
+}
+
+
+bool PipelineEvents::Get(Event& e)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_events.empty())
+        return false;
+
+    e = m_events.front();
+    m_events.pop_front();
+
+    return true;
+}
+
+
+long long PipelineEvents::GetDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+
+void PipelineEvents::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_events.clear();
+    m_dropped = 0;
+}
+
+}  // namespace WebmUtil
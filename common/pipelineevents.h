@@ -0,0 +1,72 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_PIPELINEEVENTS_HPP__
+#define __WEBMDSHOW_COMMON_PIPELINEEVENTS_HPP__
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+// Things that a filter decided while the graph ran (an encoder changing
+// its speed, say), kept until a monitor collects them (see
+// IPipelineEvents).  Where PipelineStats counts, this records each event
+// on its own, with the time it happened and a description.
+//
+// The streaming thread posts the events and another thread takes them,
+// so the queue is locked.  It holds the most recent kMaxEvents; older
+// ones are dropped (and counted) if nobody collects them.
+
+namespace WebmUtil
+{
+
+class PipelineEvents
+{
+    PipelineEvents(const PipelineEvents&);
+    PipelineEvents& operator=(const PipelineEvents&);
+
+public:
+
+    enum
+    {
+        kNameLength = 32,
+        kTextLength = 160,
+        kMaxEvents = 64
+    };
+
+    struct Event
+    {
+        long long time_us;  // PipelineStats::GetMicroseconds
+        wchar_t name[kNameLength];  // of the stream (normally the pin id)
+        wchar_t type[kNameLength];  // what kind of event, e.g. "speed"
+        wchar_t text[kTextLength];
+    };
+
+    PipelineEvents();
+
+    // The strings are truncated to fit.
+    void Post(const wchar_t* name, const wchar_t* type, const wchar_t* text);
+
+    // Removes the oldest event.  Returns false if there are none.
+    bool Get(Event&);
+
+    long long GetDropped() const;
+    void Clear();
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::deque<Event> m_events;
+    long long m_dropped;
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_PIPELINEEVENTS_HPP__
@@ -0,0 +1,209 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "pipelinestats.h"
+
+#include <cassert>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+namespace WebmUtil
+{
+
+PipelineStats::PipelineStats(const wchar_t* name)
+{
+    assert(name);
+
+    int i = 0;
+
+    while ((i < kNameLength - 1) && (name[i] != L'\0'))
+    {
+        m_name[i] = name[i];
+        ++i;
+    }
+
+    m_name[i] = L'\0';
+
+    Reset();
+}
+
+
+void PipelineStats::Reset()
+{
+    m_samples_in = 0;
+    m_bytes_in = 0;
+    m_samples_out = 0;
+    m_bytes_out = 0;
+    m_processed = 0;
+    m_process_us = 0;
+    m_process_max_us = 0;
+
+    for (int i = 0; i < kHistogramBuckets; ++i)
+        m_histogram[i] = 0;
+
+    m_queue_depth = 0;
+    m_queue_max = 0;
+    m_starved = 0;
+}
+
+
+void PipelineStats::OnInput(long bytes)
+{
+    ++m_samples_in;
+
+    if (bytes > 0)
+        m_bytes_in += bytes;
+}
+
+
+void PipelineStats::OnOutput(long bytes)
+{
+    ++m_samples_out;
+
+    if (bytes > 0)
+        m_bytes_out += bytes;
+}
+
+
+void PipelineStats::OnProcess(long long us)
+{
+    if (us < 0)  // the clock can't go backwards, but be safe
+        us = 0;
+
+    ++m_processed;
+    m_process_us += us;
+    ++m_histogram[GetBucket(us)];
+
+    long long max_us = m_process_max_us.load();
+
+    while ((us > max_us) &&
+           !m_process_max_us.compare_exchange_weak(max_us, us))
+    {
+    }
+}
+
+
+void PipelineStats::OnQueueDepth(long depth)
+{
+    m_queue_depth = depth;
+
+    long max_depth = m_queue_max.load();
+
+    while ((depth > max_depth) &&
+           !m_queue_max.compare_exchange_weak(max_depth, depth))
+    {
+    }
+}
+
+
+void PipelineStats::OnStarved()
+{
+    ++m_starved;
+}
+
+
+void PipelineStats::OnWait(long long us)
+{
+    if (us >= kStarvedUs)
+        ++m_starved;
+}
+
+
+void PipelineStats::GetSnapshot(Snapshot& s) const
+{
+    memcpy(s.name, m_name, sizeof s.name);
+
+    s.samples_in = m_samples_in;
+    s.bytes_in = m_bytes_in;
+    s.samples_out = m_samples_out;
+    s.bytes_out = m_bytes_out;
+    s.processed = m_processed;
+    s.process_us = m_process_us;
+    s.process_max_us = m_process_max_us;
+
+    for (int i = 0; i < kHistogramBuckets; ++i)
+        s.histogram[i] = m_histogram[i];
+
+    s.queue_depth = m_queue_depth;
+    s.queue_max = m_queue_max;
+    s.starved = m_starved;
+}
+
+
+int PipelineStats::GetBucket(long long us)
+{
+    int bucket = 0;
+
+    while ((us > 0) && (bucket < kHistogramBuckets - 1))
+    {
+        us >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+
+long long PipelineStats::GetMicroseconds()
+{
+#ifdef _WIN32
+    LARGE_INTEGER t;
+    LARGE_INTEGER f;
+
+    BOOL b = QueryPerformanceCounter(&t);
+    b;
+    assert(b);
+
+    b = QueryPerformanceFrequency(&f);
+    assert(b);
+
+    // Split the conversion so that it can't overflow.
+    const long long sec = t.QuadPart / f.QuadPart;
+    const long long rem = t.QuadPart % f.QuadPart;
+
+    return sec * 1000000 + rem * 1000000 / f.QuadPart;
+#else
+    using namespace std::chrono;
+
+    const steady_clock::duration t = steady_clock::now().time_since_epoch();
+    return duration_cast<microseconds>(t).count();
+#endif
+}
+
+
+PipelineStats::Timer::Timer(PipelineStats& stats) :
+    m_stats(stats),
+    m_start(GetMicroseconds())
+{
+}
+
+
+PipelineStats::Timer::~Timer()
+{
+    m_stats.OnProcess(GetMicroseconds() - m_start);
+}
+
+
+PipelineStats::WaitTimer::WaitTimer(PipelineStats& stats) :
+    m_stats(stats),
+    m_start(GetMicroseconds())
+{
+}
+
+
+PipelineStats::WaitTimer::~WaitTimer()
+{
+    m_stats.OnWait(GetMicroseconds() - m_start);
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,134 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_PIPELINESTATS_HPP__
+#define __WEBMDSHOW_COMMON_PIPELINESTATS_HPP__
+
+#pragma once
+
+#include <atomic>
+
+// Throughput counters for one stream (one pin) of a filter: how many
+// samples and bytes came in and went out, how long each sample took to
+// process, how deep the stream's queue is, and how often the stream was
+// starved (had to wait for input, or for a buffer to deliver into).
+//
+// The streaming thread updates the counters while the graph runs, and
+// another thread takes snapshots of them (see IPipelineStats), so every
+// counter is an atomic.  A snapshot is consistent counter by counter, but
+// not across counters, which is all that a periodic report needs.
+
+namespace WebmUtil
+{
+
+class PipelineStats
+{
+    PipelineStats(const PipelineStats&);
+    PipelineStats& operator=(const PipelineStats&);
+
+public:
+
+    enum
+    {
+        kNameLength = 32,
+        kHistogramBuckets = 20,
+        kStarvedUs = 1000  // a wait at least this long counts as starved
+    };
+
+    struct Snapshot
+    {
+        wchar_t name[kNameLength];
+        long long samples_in;
+        long long bytes_in;
+        long long samples_out;
+        long long bytes_out;
+        long long processed;       // number of timed calls
+        long long process_us;      // total time spent in them
+        long long process_max_us;
+
+        // Bucket 0 counts calls that took less than 1us, bucket i (i > 0)
+        // those that took [2^(i-1), 2^i) us; the last bucket also counts
+        // everything longer.
+        long long histogram[kHistogramBuckets];
+
+        long queue_depth;  // as last reported
+        long queue_max;
+        long long starved;
+    };
+
+    // The name identifies the stream in reports (normally the pin id).
+    explicit PipelineStats(const wchar_t* name);
+
+    void Reset();
+
+    void OnInput(long bytes);
+    void OnOutput(long bytes);
+    void OnProcess(long long us);
+    void OnQueueDepth(long depth);
+    void OnStarved();
+    void OnWait(long long us);
+
+    void GetSnapshot(Snapshot&) const;
+
+    static int GetBucket(long long us);
+
+    // Monotonic clock, in microseconds.
+    static long long GetMicroseconds();
+
+    // Times the scope it lives in, as one processed call.
+    class Timer
+    {
+        Timer(const Timer&);
+        Timer& operator=(const Timer&);
+
+        PipelineStats& m_stats;
+        const long long m_start;
+
+    public:
+
+        explicit Timer(PipelineStats&);
+        ~Timer();
+    };
+
+    // Times a call that might block (for a buffer, say), and counts the
+    // stream as starved if it did.
+    class WaitTimer
+    {
+        WaitTimer(const WaitTimer&);
+        WaitTimer& operator=(const WaitTimer&);
+
+        PipelineStats& m_stats;
+        const long long m_start;
+
+    public:
+
+        explicit WaitTimer(PipelineStats&);
+        ~WaitTimer();
+    };
+
+private:
+
+    wchar_t m_name[kNameLength];
+
+    std::atomic<long long> m_samples_in;
+    std::atomic<long long> m_bytes_in;
+    std::atomic<long long> m_samples_out;
+    std::atomic<long long> m_bytes_out;
+    std::atomic<long long> m_processed;
+    std::atomic<long long> m_process_us;
+    std::atomic<long long> m_process_max_us;
+    std::atomic<long long> m_histogram[kHistogramBuckets];
+    std::atomic<long> m_queue_depth;
+    std::atomic<long> m_queue_max;
+    std::atomic<long long> m_starved;
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_PIPELINESTATS_HPP__
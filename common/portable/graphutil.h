@@ -0,0 +1,27 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+
+//Shadows common/graphutil.h, whose graph helpers need the real DirectShow
+//interfaces.  The parser only uses the FourCC GUIDs, which are defined in
+//webmportable.cc.
+
+#include "webmportable.h"
+
+namespace GraphUtil
+{
+    struct FourCCGUID : GUID
+    {
+        explicit FourCCGUID(const char*);
+        explicit FourCCGUID(DWORD);
+
+        static bool IsFourCC(const GUID&);
+    };
+
+}  //end namespace GraphUtil
@@ -0,0 +1,24 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+
+//Shadows common/iexternalbuffersample.h, since the MSVC uuid attribute
+//doesn't parse elsewhere.  Keep the two in step.
+
+#include "webmportable.h"
+
+interface IExternalBufferSample : IUnknown
+{
+    //ED31110B-5211-11DF-94AF-0026B977EEAA
+    WEBM_PORTABLE_IID(0xED31110B, 0x5211, 0x11DF,
+                      0x94, 0xAF, 0x00, 0x26, 0xB9, 0x77, 0xEE, 0xAA)
+
+    virtual HRESULT Attach(BYTE* ptr, long len, IUnknown* pOwner) = 0;
+
+};
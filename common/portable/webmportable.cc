@@ -0,0 +1,253 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "webmportable.h"
+#include "comreg.h"
+#include "graphutil.h"
+#include "versionhandling.h"
+#include <cassert>
+#include <ostream>
+
+namespace WebmMuxLib
+{
+    HMODULE s_hModule = 0;  //normally set in the DLL entry point
+}
+
+
+int WideCharToMultiByte(
+    UINT code_page,
+    DWORD,
+    const wchar_t* src,
+    int cch,
+    char* dst,
+    int cb,
+    const char*,
+    BOOL*)
+{
+    assert(code_page == CP_UTF8);
+    (void)code_page;  //only checked by the assert
+    assert(src);
+
+    if (cch < 0)
+        cch = static_cast<int>(wcslen(src)) + 1;  //include the NUL
+
+    int n = 0;
+
+    for (int i = 0; i < cch; ++i)
+    {
+        unsigned long c = static_cast<unsigned long>(src[i]);
+
+        if (c > 0x10FFFF)
+            c = 0xFFFD;
+
+        BYTE buf[4];
+        int len;
+
+        if (c < 0x80)
+        {
+            buf[0] = BYTE(c);
+            len = 1;
+        }
+        else if (c < 0x800)
+        {
+            buf[0] = BYTE(0xC0 | (c >> 6));
+            buf[1] = BYTE(0x80 | (c & 0x3F));
+            len = 2;
+        }
+        else if (c < 0x10000)
+        {
+            buf[0] = BYTE(0xE0 | (c >> 12));
+            buf[1] = BYTE(0x80 | ((c >> 6) & 0x3F));
+            buf[2] = BYTE(0x80 | (c & 0x3F));
+            len = 3;
+        }
+        else
+        {
+            buf[0] = BYTE(0xF0 | (c >> 18));
+            buf[1] = BYTE(0x80 | ((c >> 12) & 0x3F));
+            buf[2] = BYTE(0x80 | ((c >> 6) & 0x3F));
+            buf[3] = BYTE(0x80 | (c & 0x3F));
+            len = 4;
+        }
+
+        if (cb > 0)  //else just count the bytes
+        {
+            if ((n + len) > cb)
+                return 0;  //insufficient buffer
+
+            memcpy(dst + n, buf, len);
+        }
+
+        n += len;
+    }
+
+    return n;
+}
+
+
+int MultiByteToWideChar(
+    UINT code_page,
+    DWORD,
+    const char* src_,
+    int cb,
+    wchar_t* dst,
+    int cch)
+{
+    assert(code_page == CP_UTF8);
+    (void)code_page;  //only checked by the assert
+    assert(src_);
+
+    const BYTE* const src = reinterpret_cast<const BYTE*>(src_);
+
+    if (cb < 0)
+        cb = static_cast<int>(strlen(src_)) + 1;  //include the NUL
+
+    int n = 0;
+    int i = 0;
+
+    while (i < cb)
+    {
+        const BYTE b = src[i++];
+
+        unsigned long c;
+        int more;
+
+        if (b < 0x80)
+        {
+            c = b;
+            more = 0;
+        }
+        else if ((b & 0xE0) == 0xC0)
+        {
+            c = b & 0x1F;
+            more = 1;
+        }
+        else if ((b & 0xF0) == 0xE0)
+        {
+            c = b & 0x0F;
+            more = 2;
+        }
+        else if ((b & 0xF8) == 0xF0)
+        {
+            c = b & 0x07;
+            more = 3;
+        }
+        else
+        {
+            c = 0xFFFD;  //invalid lead byte
+            more = 0;
+        }
+
+        while ((more > 0) && (i < cb) && ((src[i] & 0xC0) == 0x80))
+        {
+            c = (c << 6) | (src[i++] & 0x3F);
+            --more;
+        }
+
+        if (more > 0)  //truncated sequence
+            c = 0xFFFD;
+
+        if (cch > 0)  //else just count the characters
+        {
+            if (n >= cch)
+                return 0;  //insufficient buffer
+
+            dst[n] = static_cast<wchar_t>(c);
+        }
+
+        ++n;
+    }
+
+    return n;
+}
+
+
+//The module file name and its version resource don't exist here, so the
+//muxing app is reported as version 0.
+
+HRESULT ComReg::ComRegGetModuleFileName(HMODULE, std::wstring& result)
+{
+    result = L"webmbench";
+    return S_OK;
+}
+
+
+void VersionHandling::GetVersion(
+    const wchar_t*,
+    WORD& major,
+    WORD& minor,
+    WORD& revision,
+    WORD& build)
+{
+    major = 0;
+    minor = 0;
+    revision = 0;
+    build = 0;
+}
+
+
+void VersionHandling::GetVersion(const wchar_t* fname, std::wostream& os)
+{
+    WORD major, minor, revision, build;
+    VersionHandling::GetVersion(fname, major, minor, revision, build);
+
+    os << major
+       << L'.'
+       << minor
+       << L'.'
+       << revision
+       << L'.'
+       << build;
+}
+
+
+namespace GraphUtil
+{
+
+//As in common/graphutil.cc.
+
+FourCCGUID::FourCCGUID(const char* str)
+{
+    assert(strlen(str) == 4);
+    memcpy(&Data1, str, 4);
+    Data2 = 0x0000;
+    Data3 = 0x0010;
+    Data4[0] = 0x80;
+    Data4[1] = 0x00;
+    Data4[2] = 0x00;
+    Data4[3] = 0xAA;
+    Data4[4] = 0x00;
+    Data4[5] = 0x38;
+    Data4[6] = 0x9B;
+    Data4[7] = 0x71;
+}
+
+
+FourCCGUID::FourCCGUID(DWORD Data1_)
+{
+    Data1 = Data1_;
+    Data2 = 0x0000;
+    Data3 = 0x0010;
+    Data4[0] = 0x80;
+    Data4[1] = 0x00;
+    Data4[2] = 0x00;
+    Data4[3] = 0xAA;
+    Data4[4] = 0x00;
+    Data4[5] = 0x38;
+    Data4[6] = 0x9B;
+    Data4[7] = 0x71;
+}
+
+
+bool FourCCGUID::IsFourCC(const GUID& guid)
+{
+    const FourCCGUID base(guid.Data1);
+    return (guid == base);
+}
+
+}  //end namespace GraphUtil
@@ -0,0 +1,457 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_WEBMPORTABLE_H__
+#define __WEBMDSHOW_COMMON_WEBMPORTABLE_H__
+
+#pragma once
+
+//Minimal stand-ins for the parts of the Windows SDK (COM, DirectShow and
+//the Win32 string conversions) that the muxer and parser libraries use,
+//so that they can be built unmodified on other platforms.  This header is
+//force-included (-include) into each translation unit, and the headers
+//next to it (strmif.h, windows.h, etc.) shadow the SDK headers of the
+//same name.  Only what the host-built tools (webmbench and oggtowebm) and
+//the common tests need is declared here: it is not an emulation layer,
+//and the filters themselves remain Windows-only.
+
+#ifdef _WIN32
+#error webmportable.h is for non-Windows builds only
+#endif
+
+#include <alloca.h>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <ostream>  // the sources expect <windows.h> to provide it
+
+#define __int64 long long
+#define __noop ((void)0)
+#define interface struct
+
+#define STDMETHODCALLTYPE
+#define WINAPI
+#define CALLBACK
+
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int DWORD;
+typedef unsigned int ULONG;
+typedef unsigned int UINT;
+typedef int LONG;
+typedef int BOOL;
+typedef int INT;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef long long LONGLONG;
+typedef unsigned long long ULONGLONG;
+typedef LONGLONG REFERENCE_TIME;
+typedef int HRESULT;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef wchar_t WCHAR;
+typedef char CHAR;
+
+#define TRUE 1
+#define FALSE 0
+
+#define S_OK                    ((HRESULT)0)
+#define S_FALSE                 ((HRESULT)1)
+#define E_NOTIMPL               ((HRESULT)0x80004001)
+#define E_NOINTERFACE           ((HRESULT)0x80004002)
+#define E_POINTER               ((HRESULT)0x80004003)
+#define E_FAIL                  ((HRESULT)0x80004005)
+#define E_UNEXPECTED            ((HRESULT)0x8000FFFF)
+#define E_OUTOFMEMORY           ((HRESULT)0x8007000E)
+#define E_INVALIDARG            ((HRESULT)0x80070057)
+
+#define STG_E_INVALIDFUNCTION   ((HRESULT)0x80030001)
+#define STG_E_MEDIUMFULL        ((HRESULT)0x80030070)
+
+#define VFW_S_NO_MORE_ITEMS         ((HRESULT)0x00040103)
+#define VFW_S_NO_STOP_TIME          ((HRESULT)0x00040270)
+#define VFW_E_INVALIDMEDIATYPE      ((HRESULT)0x80040200)
+#define VFW_E_TYPE_NOT_ACCEPTED     ((HRESULT)0x8004022A)
+#define VFW_E_BUFFER_UNDERFLOW      ((HRESULT)0x80040250)
+#define VFW_E_INVALID_FILE_FORMAT   ((HRESULT)0x8004022F)
+#define VFW_E_SAMPLE_TIME_NOT_SET   ((HRESULT)0x80040249)
+#define VFW_E_MEDIA_TIME_NOT_SET    ((HRESULT)0x80040251)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define CP_UTF8 65001
+#define CHARS_IN_GUID 39
+
+struct GUID
+{
+    DWORD Data1;
+    WORD Data2;
+    WORD Data3;
+    BYTE Data4[8];
+};
+
+typedef GUID IID;
+typedef GUID CLSID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+typedef const CLSID& REFCLSID;
+
+inline bool operator==(const GUID& lhs, const GUID& rhs)
+{
+    return (memcmp(&lhs, &rhs, sizeof(GUID)) == 0);
+}
+
+inline bool operator!=(const GUID& lhs, const GUID& rhs)
+{
+    return !(lhs == rhs);
+}
+
+const GUID GUID_NULL = { 0, 0, 0, { 0, 0, 0, 0, 0, 0, 0, 0 } };
+
+//__uuidof is a compiler extension of MSVC.  Here each interface declares
+//its IID as a static member function, and the macro looks it up.
+
+template<class T>
+inline const IID& webm_uuidof()
+{
+    return T::webm_iid();
+}
+
+#define __uuidof(T) webm_uuidof<T>()
+
+#define WEBM_PORTABLE_IID(d1, d2, d3, b0, b1, b2, b3, b4, b5, b6, b7) \
+    static const IID& webm_iid() \
+    { \
+        static const IID iid = \
+            { d1, d2, d3, { b0, b1, b2, b3, b4, b5, b6, b7 } }; \
+        return iid; \
+    }
+
+union LARGE_INTEGER
+{
+    struct
+    {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+
+    LONGLONG QuadPart;
+};
+
+union ULARGE_INTEGER
+{
+    struct
+    {
+        DWORD LowPart;
+        DWORD HighPart;
+    };
+
+    ULONGLONG QuadPart;
+};
+
+struct TLIBATTR;  //for comreg.h
+
+struct RECT
+{
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+inline BOOL SetRectEmpty(RECT* r)
+{
+    r->left = r->top = r->right = r->bottom = 0;
+    return TRUE;
+}
+
+interface IUnknown
+{
+    WEBM_PORTABLE_IID(0x00000000, 0x0000, 0x0000,
+                      0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46)
+
+    virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void**) = 0;
+    virtual ULONG STDMETHODCALLTYPE AddRef() = 0;
+    virtual ULONG STDMETHODCALLTYPE Release() = 0;
+
+    template<class Q>
+    HRESULT QueryInterface(Q** pp)
+    {
+        return QueryInterface(__uuidof(Q), reinterpret_cast<void**>(pp));
+    }
+
+protected:
+    virtual ~IUnknown() {}
+};
+
+enum STREAM_SEEK
+{
+    STREAM_SEEK_SET = 0,
+    STREAM_SEEK_CUR = 1,
+    STREAM_SEEK_END = 2
+};
+
+interface ISequentialStream : IUnknown
+{
+    WEBM_PORTABLE_IID(0x0C733A30, 0x2A1C, 0x11CE,
+                      0xAD, 0xE5, 0x00, 0xAA, 0x00, 0x44, 0x77, 0x3D)
+
+    virtual HRESULT STDMETHODCALLTYPE Read(void*, ULONG, ULONG*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Write(const void*, ULONG, ULONG*) = 0;
+};
+
+//Only the subset of IStream that EbmlIO uses.
+
+interface IStream : ISequentialStream
+{
+    WEBM_PORTABLE_IID(0x0000000C, 0x0000, 0x0000,
+                      0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46)
+
+    virtual HRESULT STDMETHODCALLTYPE Seek(
+        LARGE_INTEGER,
+        DWORD,
+        ULARGE_INTEGER*) = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER) = 0;
+};
+
+struct AM_MEDIA_TYPE
+{
+    GUID majortype;
+    GUID subtype;
+    BOOL bFixedSizeSamples;
+    BOOL bTemporalCompression;
+    ULONG lSampleSize;
+    GUID formattype;
+    IUnknown* pUnk;
+    ULONG cbFormat;
+    BYTE* pbFormat;
+};
+
+enum AM_SEEKING_SEEKING_FLAGS
+{
+    AM_SEEKING_NoPositioning = 0,
+    AM_SEEKING_AbsolutePositioning = 0x1,
+    AM_SEEKING_RelativePositioning = 0x2,
+    AM_SEEKING_IncrementalPositioning = 0x3,
+    AM_SEEKING_PositioningBitsMask = 0x3,
+    AM_SEEKING_SeekToKeyFrame = 0x4,
+    AM_SEEKING_ReturnTime = 0x8,
+    AM_SEEKING_Segment = 0x10,
+    AM_SEEKING_NoFlush = 0x20
+};
+
+struct ALLOCATOR_PROPERTIES
+{
+    long cBuffers;
+    long cbBuffer;
+    long cbAlign;
+    long cbPrefix;
+};
+
+interface IMediaSample : IUnknown
+{
+    WEBM_PORTABLE_IID(0x56A8689A, 0x0AD4, 0x11CE,
+                      0xB0, 0x3A, 0x00, 0x20, 0xAF, 0x0B, 0xA7, 0x70)
+
+    virtual HRESULT STDMETHODCALLTYPE GetPointer(BYTE**) = 0;
+    virtual long STDMETHODCALLTYPE GetSize() = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetTime(
+        REFERENCE_TIME*,
+        REFERENCE_TIME*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetTime(
+        REFERENCE_TIME*,
+        REFERENCE_TIME*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE IsSyncPoint() = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetSyncPoint(BOOL) = 0;
+    virtual HRESULT STDMETHODCALLTYPE IsPreroll() = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetPreroll(BOOL) = 0;
+    virtual long STDMETHODCALLTYPE GetActualDataLength() = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetActualDataLength(long) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetMediaType(AM_MEDIA_TYPE**) = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetMediaType(AM_MEDIA_TYPE*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE IsDiscontinuity() = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetDiscontinuity(BOOL) = 0;
+    virtual HRESULT STDMETHODCALLTYPE GetMediaTime(LONGLONG*, LONGLONG*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE SetMediaTime(LONGLONG*, LONGLONG*) = 0;
+};
+
+//The media type enumerator is declared (CMediaTypes derives from it) but
+//never created by the host-built tools, so the pin is left opaque.
+
+interface IPin : IUnknown
+{
+    WEBM_PORTABLE_IID(0x56A86891, 0x0AD4, 0x11CE,
+                      0xB0, 0x3A, 0x00, 0x20, 0xAF, 0x0B, 0xA7, 0x70)
+};
+
+interface IEnumMediaTypes : IUnknown
+{
+    WEBM_PORTABLE_IID(0x89C31040, 0x846B, 0x11CE,
+                      0x97, 0xD3, 0x00, 0xAA, 0x00, 0x55, 0x59, 0x5A)
+
+    virtual HRESULT STDMETHODCALLTYPE Next(
+        ULONG,
+        AM_MEDIA_TYPE**,
+        ULONG*) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Skip(ULONG) = 0;
+    virtual HRESULT STDMETHODCALLTYPE Reset() = 0;
+    virtual HRESULT STDMETHODCALLTYPE Clone(IEnumMediaTypes**) = 0;
+};
+
+struct BITMAPINFOHEADER
+{
+    DWORD biSize;
+    LONG biWidth;
+    LONG biHeight;
+    WORD biPlanes;
+    WORD biBitCount;
+    DWORD biCompression;
+    DWORD biSizeImage;
+    LONG biXPelsPerMeter;
+    LONG biYPelsPerMeter;
+    DWORD biClrUsed;
+    DWORD biClrImportant;
+};
+
+struct VIDEOINFOHEADER
+{
+    RECT rcSource;
+    RECT rcTarget;
+    DWORD dwBitRate;
+    DWORD dwBitErrorRate;
+    REFERENCE_TIME AvgTimePerFrame;
+    BITMAPINFOHEADER bmiHeader;
+};
+
+struct VIDEOINFOHEADER2
+{
+    RECT rcSource;
+    RECT rcTarget;
+    DWORD dwBitRate;
+    DWORD dwBitErrorRate;
+    REFERENCE_TIME AvgTimePerFrame;
+    DWORD dwInterlaceFlags;
+    DWORD dwCopyProtectFlags;
+    DWORD dwPictAspectRatioX;
+    DWORD dwPictAspectRatioY;
+    DWORD dwControlFlags;
+    DWORD dwReserved2;
+    BITMAPINFOHEADER bmiHeader;
+};
+
+#pragma pack(push, 1)
+struct WAVEFORMATEX
+{
+    WORD wFormatTag;
+    WORD nChannels;
+    DWORD nSamplesPerSec;
+    DWORD nAvgBytesPerSec;
+    WORD nBlockAlign;
+    WORD wBitsPerSample;
+    WORD cbSize;
+};
+#pragma pack(pop)
+
+#define WAVE_FORMAT_PCM 1
+#define WAVE_FORMAT_IEEE_FLOAT 3
+
+const GUID MEDIATYPE_Video =
+    { 0x73646976, 0x0000, 0x0010,
+      { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+
+const GUID MEDIATYPE_Audio =
+    { 0x73647561, 0x0000, 0x0010,
+      { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+
+const GUID MEDIATYPE_Stream =
+    { 0xE436EB83, 0x524F, 0x11CE,
+      { 0x9F, 0x53, 0x00, 0x20, 0xAF, 0x0B, 0xA7, 0x70 } };
+
+const GUID MEDIASUBTYPE_PCM =
+    { 0x00000001, 0x0000, 0x0010,
+      { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+
+const GUID MEDIASUBTYPE_IEEE_FLOAT =
+    { 0x00000003, 0x0000, 0x0010,
+      { 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 } };
+
+const GUID FORMAT_VideoInfo =
+    { 0x05589F80, 0xC356, 0x11CE,
+      { 0xBF, 0x01, 0x00, 0xAA, 0x00, 0x55, 0x59, 0x5A } };
+
+const GUID FORMAT_VideoInfo2 =
+    { 0xF72A76A0, 0xEB0A, 0x11D0,
+      { 0xAC, 0xE4, 0x00, 0x00, 0xC0, 0xCC, 0x16, 0xBA } };
+
+const GUID FORMAT_WaveFormatEx =
+    { 0x05589F81, 0xC356, 0x11CE,
+      { 0xBF, 0x01, 0x00, 0xAA, 0x00, 0x55, 0x59, 0x5A } };
+
+//COM task memory, atomics and string conversion.
+
+inline void* CoTaskMemAlloc(size_t cb)
+{
+    return malloc(cb);
+}
+
+inline void CoTaskMemFree(void* p)
+{
+    free(p);
+}
+
+inline LONG InterlockedIncrement(volatile LONG* p)
+{
+    return __sync_add_and_fetch(p, 1);
+}
+
+inline LONG InterlockedDecrement(volatile LONG* p)
+{
+    return __sync_sub_and_fetch(p, 1);
+}
+
+inline ULONG InterlockedIncrement(volatile ULONG* p)
+{
+    return __sync_add_and_fetch(p, 1);
+}
+
+inline ULONG InterlockedDecrement(volatile ULONG* p)
+{
+    return __sync_sub_and_fetch(p, 1);
+}
+
+#define _malloca(cb) alloca(cb)
+#define _freea(p) ((void)(p))
+#define _stricmp strcasecmp
+
+//Only CP_UTF8 is supported.  wchar_t is UTF-32 on these platforms, not
+//UTF-16 as on Windows.
+
+int WideCharToMultiByte(
+    UINT code_page,
+    DWORD flags,
+    const wchar_t* src,
+    int cch,
+    char* dst,
+    int cb,
+    const char* default_char,
+    BOOL* used_default_char);
+
+int MultiByteToWideChar(
+    UINT code_page,
+    DWORD flags,
+    const char* src,
+    int cb,
+    wchar_t* dst,
+    int cch);
+
+#endif  //__WEBMDSHOW_COMMON_WEBMPORTABLE_H__
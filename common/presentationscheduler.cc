@@ -0,0 +1,194 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "presentationscheduler.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace WebmUtil
+{
+
+PresentationScheduler::PresentationScheduler()
+{
+    Init(kDefaultSlots);
+}
+
+bool PresentationScheduler::Init(int slots)
+{
+    if ((slots <= 0) || (slots > kMaxSlots))
+        return false;
+
+    m_slots = slots;
+    Reset();
+
+    return true;
+}
+
+void PresentationScheduler::Reset()
+{
+    m_read = 0;
+    m_count = 0;
+    m_acquired = -1;
+    m_showing = false;
+
+    memset(m_pts, 0, sizeof m_pts);
+    memset(&m_stats, 0, sizeof m_stats);
+}
+
+int PresentationScheduler::GetSlotCount() const
+{
+    return m_slots;
+}
+
+int PresentationScheduler::GetQueuedCount() const
+{
+    return m_count;
+}
+
+bool PresentationScheduler::IsFull() const
+{
+    return (m_count >= m_slots);
+}
+
+PresentationScheduler::Decision PresentationScheduler::Admit(
+    long long pts,
+    long long now,
+    bool droppable)
+{
+    ++m_stats.admitted;
+
+    if (now - pts <= kLateSkip)
+        return kDecodeAndQueue;
+
+    //Far enough behind that the frame would only be dropped at display
+    //time.  Don't spend the time decoding it, unless we have to.
+
+    if (droppable)
+    {
+        ++m_stats.skipped;
+        return kSkip;
+    }
+
+    ++m_stats.discarded;
+    return kDecodeOnly;
+}
+
+int PresentationScheduler::AcquireSlot()
+{
+    assert(m_acquired < 0);
+
+    if (IsFull())
+        return -1;
+
+    m_acquired = GetSlot(m_count);
+    return m_acquired;
+}
+
+void PresentationScheduler::CommitSlot(int slot, long long pts)
+{
+    assert(slot == m_acquired);
+    assert(!IsFull());
+
+    m_pts[slot] = pts;
+    m_acquired = -1;
+
+    ++m_count;
+    ++m_stats.queued;
+}
+
+void PresentationScheduler::CancelSlot(int slot)
+{
+    assert(slot == m_acquired);
+    (void)slot;  // only checked by the assert
+
+    m_acquired = -1;
+}
+
+PresentationScheduler::Action PresentationScheduler::GetNext(
+    long long now,
+    int& slot,
+    long long& wait)
+{
+    slot = -1;
+    wait = 0;
+
+    assert(!m_showing);
+
+    if (m_count == 0)
+        return kActionNone;
+
+    //Drop frames that are too late, as long as the frame after them is
+    //due as well (so there is something better to show instead).
+
+    while (m_count > 1)
+    {
+        const long long late = now - m_pts[m_read];
+        const long long next = m_pts[GetSlot(1)];
+
+        if ((late <= kLateDrop) || (next > now + kEarly))
+            break;
+
+        Pop();
+        ++m_stats.dropped;
+    }
+
+    const long long pts = m_pts[m_read];
+
+    if (pts > now + kEarly)
+    {
+        wait = pts - now;
+        return kActionWait;
+    }
+
+    const long long drift = now - pts;
+    const long long abs_drift = (drift < 0) ? -drift : drift;
+
+    m_stats.last_drift = drift;
+    m_stats.total_drift += abs_drift;
+
+    if (abs_drift > m_stats.max_drift)
+        m_stats.max_drift = abs_drift;
+
+    ++m_stats.shown;
+
+    m_showing = true;
+    slot = m_read;
+
+    return kActionShow;
+}
+
+void PresentationScheduler::ReleaseSlot(int slot)
+{
+    assert(m_showing);
+    assert(slot == m_read);
+    (void)slot;  // only checked by the assert
+
+    m_showing = false;
+    Pop();
+}
+
+const PresentationScheduler::Stats& PresentationScheduler::GetStats() const
+{
+    return m_stats;
+}
+
+int PresentationScheduler::GetSlot(int index) const
+{
+    return (m_read + index) % m_slots;
+}
+
+void PresentationScheduler::Pop()
+{
+    assert(m_count > 0);
+
+    m_read = GetSlot(1);
+    --m_count;
+}
+
+}  // namespace WebmUtil
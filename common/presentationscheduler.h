@@ -0,0 +1,123 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_PRESENTATIONSCHEDULER_HPP__
+#define __WEBMDSHOW_COMMON_PRESENTATIONSCHEDULER_HPP__
+
+#pragma once
+
+// Decides when a player shows its decoded video frames, against a master
+// clock (normally the audio clock: the position of the samples the audio
+// device has played), and which frames it should not bother with when it
+// falls behind.
+//
+// The scheduler keeps the bookkeeping for a fixed ring of frame slots; the
+// player owns the frame buffers themselves (one per slot).  The decoder
+// side asks whether to decode a frame at all (Admit), fills a slot
+// (AcquireSlot, CommitSlot), and the presentation side asks what to do now
+// (GetNext), shows the frame in the slot it is given, and returns the slot
+// (ReleaseSlot).  Frames that are too late to show are dropped, the
+// oldest first, as long as a newer frame is also due.
+//
+// Like VpxQualityGovernor, this is a plain state machine: it knows nothing
+// about SDL or libvpx, takes the clock as an argument (in milliseconds),
+// and the caller is expected to serialize access to it.
+
+namespace WebmUtil
+{
+
+class PresentationScheduler
+{
+    PresentationScheduler(const PresentationScheduler&);
+    PresentationScheduler& operator=(const PresentationScheduler&);
+
+public:
+
+    enum
+    {
+        kMaxSlots = 16,
+        kDefaultSlots = 5,
+        kEarly = 2,        // show a frame up to this early (ms)
+        kLateDrop = 40,    // this late, drop it if a newer frame is due
+        kLateSkip = 60     // this late before decoding: skip or discard
+    };
+
+    enum Decision
+    {
+        kDecodeAndQueue,   // decode the frame, and queue it for display
+        kDecodeOnly,       // too late, but other frames depend on it
+        kSkip              // too late, and nothing depends on it
+    };
+
+    enum Action
+    {
+        kActionNone,       // nothing queued
+        kActionWait,       // the next frame is not due yet
+        kActionShow        // show the frame in the slot
+    };
+
+    struct Stats
+    {
+        long admitted;
+        long skipped;      // not decoded
+        long discarded;    // decoded, but not queued
+        long queued;
+        long shown;
+        long dropped;      // queued, but too late to show
+        long long last_drift;   // clock - timestamp of the last frame shown
+        long long max_drift;    // largest absolute drift
+        long long total_drift;  // sum of absolute drifts (for the mean)
+    };
+
+    PresentationScheduler();
+
+    // Sets the number of slots (at most kMaxSlots), empties the ring, and
+    // clears the statistics.
+    bool Init(int slots);
+    void Reset();
+
+    int GetSlotCount() const;
+    int GetQueuedCount() const;
+    bool IsFull() const;
+
+    // Decoder side.  |droppable| says whether any later frame depends on
+    // this one (see VpxFrameInfo::droppable); pass false when unknown.
+    Decision Admit(long long pts, long long now, bool droppable);
+
+    // Returns the slot to decode into, or -1 when the ring is full.  Only
+    // one slot can be acquired at a time.
+    int AcquireSlot();
+    void CommitSlot(int slot, long long pts);
+    void CancelSlot(int slot);
+
+    // Presentation side.  On kActionShow |slot| is the slot to show (to be
+    // returned with ReleaseSlot once it has been shown); on kActionWait
+    // |wait| is how long until it is due.
+    Action GetNext(long long now, int& slot, long long& wait);
+    void ReleaseSlot(int slot);
+
+    const Stats& GetStats() const;
+
+private:
+
+    int m_slots;
+    int m_read;     // oldest queued slot
+    int m_count;    // queued slots, including the one being shown
+    int m_acquired; // slot being filled, or -1
+    bool m_showing; // the oldest slot has been handed out by GetNext
+    long long m_pts[kMaxSlots];
+    Stats m_stats;
+
+    int GetSlot(int index) const;
+    void Pop();
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_PRESENTATIONSCHEDULER_HPP__
@@ -0,0 +1,137 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "readscheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace WebmUtil
+{
+
+ReadScheduler::ReadScheduler(long page_size)
+    : m_page_size(page_size),
+      m_max_reads(1),
+      m_prefetch_pages(0)
+{
+    assert(m_page_size > 0);
+}
+
+void ReadScheduler::SetLimits(int max_reads, int prefetch_pages)
+{
+    assert(max_reads > 0);
+    assert(prefetch_pages >= 0);
+
+    m_max_reads = max_reads;
+    m_prefetch_pages = prefetch_pages;
+}
+
+long ReadScheduler::GetPageSize() const
+{
+    return m_page_size;
+}
+
+int ReadScheduler::GetMaxReads() const
+{
+    return m_max_reads;
+}
+
+int ReadScheduler::GetPrefetchPages() const
+{
+    return m_prefetch_pages;
+}
+
+bool ReadScheduler::Schedule(long long pos,
+                             long len,
+                             long long length,
+                             const Cache& cache,
+                             std::vector<long long>& keys) const
+{
+    assert(pos >= 0);
+    assert(len > 0);
+
+    const long long first = (pos / m_page_size) * m_page_size;
+    long long end = pos + len;
+
+    if ((length >= 0) && (end > length))
+        end = length;
+
+    // The request itself.
+    int room = m_max_reads - static_cast<int>(m_reads.size());
+    bool complete = true;
+
+    long long key = first;
+
+    for (; key < end; key += m_page_size)
+    {
+        if (cache.IsCached(key))
+            continue;
+
+        complete = false;
+
+        if (IsReading(key))
+            continue;
+
+        if (room > 0)
+        {
+            keys.push_back(key);
+            --room;
+        }
+    }
+
+    // The pages that follow it.  The request's last page was handled
+    // above, so this starts with the page after it.
+    const long long prefetch_end =
+        key + static_cast<long long>(m_prefetch_pages) * m_page_size;
+
+    for (; (room > 0) && (key < prefetch_end); key += m_page_size)
+    {
+        if ((length >= 0) && (key >= length))
+            break;
+
+        if (cache.IsCached(key) || IsReading(key))
+            continue;
+
+        keys.push_back(key);
+        --room;
+    }
+
+    return complete;
+}
+
+void ReadScheduler::OnReadBegin(long long key)
+{
+    assert(key % m_page_size == 0);
+    assert(!IsReading(key));
+    assert(static_cast<int>(m_reads.size()) < m_max_reads);
+
+    m_reads.push_back(key);
+}
+
+void ReadScheduler::OnReadEnd(long long key)
+{
+    const std::vector<long long>::iterator i =
+        std::find(m_reads.begin(), m_reads.end(), key);
+
+    assert(i != m_reads.end());
+
+    if (i != m_reads.end())
+        m_reads.erase(i);
+}
+
+bool ReadScheduler::IsReading(long long key) const
+{
+    return std::find(m_reads.begin(), m_reads.end(), key) != m_reads.end();
+}
+
+int ReadScheduler::GetReadCount() const
+{
+    return static_cast<int>(m_reads.size());
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,91 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_READSCHEDULER_HPP__
+#define __WEBMDSHOW_COMMON_READSCHEDULER_HPP__
+
+#pragma once
+
+#include <vector>
+
+// Decides which pages of a file to read next, for a reader that keeps a
+// page cache and can have several page reads in flight at once (the Media
+// Foundation source's MkvReader).
+//
+// The reader asks for a range of bytes: the pages of the range that are
+// neither cached nor being read are read first, in file order, and then,
+// while there is room, the pages that follow the range (the parser reads
+// the file front to back, so those are the ones it will want next).  At
+// most GetMaxReads() reads are in flight at once, and reads can complete
+// in any order.
+//
+// The scheduler only keeps track of the reads in flight; the reader owns
+// the cache, and the I/O.  It doesn't depend on Windows, so that it can be
+// tested against a simulated stream.
+
+namespace WebmUtil
+{
+
+class ReadScheduler
+{
+    ReadScheduler(const ReadScheduler&);
+    ReadScheduler& operator=(const ReadScheduler&);
+
+public:
+
+    // What the scheduler needs to know about the reader's cache.
+    class Cache
+    {
+    public:
+        virtual bool IsCached(long long key) const = 0;
+
+    protected:
+        virtual ~Cache() {}
+    };
+
+    // By default, one read at a time and no prefetch, which is how the
+    // reader behaved before it had a scheduler.
+    explicit ReadScheduler(long page_size);
+
+    void SetLimits(int max_reads, int prefetch_pages);
+
+    long GetPageSize() const;
+    int GetMaxReads() const;
+    int GetPrefetchPages() const;
+
+    // For a request for [pos, pos + len) of a file of |length| bytes (or
+    // unknown length, if negative), appends to |keys| the pages to read
+    // next (each key is the offset of a page).  Returns true if every page
+    // of the request is cached, in which case only prefetch pages are
+    // returned.
+    bool Schedule(long long pos,
+                  long len,
+                  long long length,
+                  const Cache& cache,
+                  std::vector<long long>& keys) const;
+
+    void OnReadBegin(long long key);
+    void OnReadEnd(long long key);
+
+    bool IsReading(long long key) const;
+    int GetReadCount() const;
+
+private:
+
+    const long m_page_size;
+    int m_max_reads;
+    int m_prefetch_pages;
+
+    // The reads in flight.  There are only ever a few, so a vector is
+    // the cheapest set.
+    std::vector<long long> m_reads;
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_READSCHEDULER_HPP__
@@ -0,0 +1,149 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "ringbuffer.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace WebmUtil
+{
+
+RingBuffer::RingBuffer() :
+    m_buf(0),
+    m_mask(0),
+    m_read(0),
+    m_write(0)
+{
+}
+
+
+RingBuffer::~RingBuffer()
+{
+    delete[] m_buf;
+}
+
+
+bool RingBuffer::Init(size_t capacity)
+{
+    size_t size = 1;
+
+    while (size < capacity)
+    {
+        size <<= 1;
+
+        if (size == 0)  // overflow
+            return false;
+    }
+
+    if ((m_buf == 0) || (size != m_mask + 1))
+    {
+        delete[] m_buf;
+        m_buf = 0;
+        m_mask = 0;
+
+        m_buf = new (std::nothrow) unsigned char[size];
+
+        if (m_buf == 0)
+            return false;
+
+        m_mask = size - 1;
+    }
+
+    m_read.store(0, std::memory_order_relaxed);
+    m_write.store(0, std::memory_order_release);
+
+    return true;
+}
+
+
+size_t RingBuffer::GetCapacity() const
+{
+    return m_buf ? m_mask + 1 : 0;
+}
+
+
+size_t RingBuffer::GetAvailable() const
+{
+    const size_t w = m_write.load(std::memory_order_acquire);
+    const size_t r = m_read.load(std::memory_order_acquire);
+
+    return w - r;
+}
+
+
+size_t RingBuffer::GetSpace() const
+{
+    return GetCapacity() - GetAvailable();
+}
+
+
+size_t RingBuffer::Write(const void* ptr, size_t len)
+{
+    if (m_buf == 0)
+        return 0;
+
+    const size_t w = m_write.load(std::memory_order_relaxed);
+
+    // Acquire pairs with the reader's release: it is done copying out of
+    // the space we are about to overwrite.
+    const size_t r = m_read.load(std::memory_order_acquire);
+
+    const size_t space = (m_mask + 1) - (w - r);
+
+    if (len > space)
+        len = space;
+
+    if (len == 0)
+        return 0;
+
+    const size_t off = w & m_mask;
+    const size_t first = (len < (m_mask + 1) - off) ? len : (m_mask + 1) - off;
+
+    const unsigned char* const src = static_cast<const unsigned char*>(ptr);
+
+    memcpy(m_buf + off, src, first);
+    memcpy(m_buf, src + first, len - first);  // the part that wrapped
+
+    m_write.store(w + len, std::memory_order_release);
+
+    return len;
+}
+
+
+size_t RingBuffer::Read(void* ptr, size_t len)
+{
+    if (m_buf == 0)
+        return 0;
+
+    const size_t r = m_read.load(std::memory_order_relaxed);
+    const size_t w = m_write.load(std::memory_order_acquire);
+
+    const size_t available = w - r;
+
+    if (len > available)
+        len = available;
+
+    if (len == 0)
+        return 0;
+
+    const size_t off = r & m_mask;
+    const size_t first = (len < (m_mask + 1) - off) ? len : (m_mask + 1) - off;
+
+    unsigned char* const dst = static_cast<unsigned char*>(ptr);
+
+    memcpy(dst, m_buf + off, first);
+    memcpy(dst + first, m_buf, len - first);
+
+    m_read.store(r + len, std::memory_order_release);
+
+    return len;
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,82 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_RINGBUFFER_HPP__
+#define __WEBMDSHOW_COMMON_RINGBUFFER_HPP__
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// A fixed-capacity byte queue for exactly one writer thread and one reader
+// thread, which need no lock between them.
+//
+// The read and write positions only ever increase (modulo 2^N), and each
+// is stored by one side only; the capacity is a power of two, so a
+// position maps to an offset with a mask, and the difference of the two
+// positions is the number of bytes buffered, even after they wrap around.
+// Reads and writes copy in (at most) two pieces, at the end and at the
+// start of the storage.
+
+namespace WebmUtil
+{
+
+class RingBuffer
+{
+    RingBuffer(const RingBuffer&);
+    RingBuffer& operator=(const RingBuffer&);
+
+public:
+
+    RingBuffer();
+    ~RingBuffer();
+
+    // Allocates (at least) capacity bytes, rounded up to a power of two,
+    // and empties the buffer.  This must not be called while the reader or
+    // the writer are using the buffer.
+    bool Init(size_t capacity);
+
+    size_t GetCapacity() const;
+
+    // The number of bytes the reader can read.
+    size_t GetAvailable() const;
+
+    // The number of bytes the writer can write.
+    size_t GetSpace() const;
+
+    // Writer side: copies up to len bytes into the buffer, and returns how
+    // many were copied (less than len when the buffer fills up).
+    size_t Write(const void* ptr, size_t len);
+
+    // Reader side: copies up to len bytes out of the buffer, and returns
+    // how many were copied.
+    size_t Read(void* ptr, size_t len);
+
+private:
+
+    enum { kCacheLine = 64 };
+
+    unsigned char* m_buf;
+    size_t m_mask;  // capacity - 1
+
+    // Each position is written by one side only, and they are kept in
+    // separate cache lines, so the two sides don't invalidate each other's
+    // lines on every update.
+
+    char m_pad0[kCacheLine];
+    std::atomic<size_t> m_read;
+    char m_pad1[kCacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_write;
+    char m_pad2[kCacheLine - sizeof(std::atomic<size_t>)];
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_RINGBUFFER_HPP__
@@ -6,7 +6,7 @@
 // in the file PATENTS.  All contributing project authors may
 // be found in the AUTHORS file in the root of the source tree.
 
-#include <Windows.h> // TODO(tomfinegan): make Windows.h include conditional
+#include <windows.h> // TODO(tomfinegan): make Windows.h include conditional
 
 #include <cassert>
 
@@ -155,13 +155,19 @@ int WebmUtil::ScratchBuf::Rewrite(uint64 offset, const uint8* read_ptr,
     return Rewrite(static_cast<uint32>(offset), read_ptr, length);
 }
 
+uint8* WebmUtil::ScratchBuf::Append(int32 length)
+{
+    assert(length > 0);
+
+    const size_t offset = buf_.size();
+    buf_.resize(offset + length);
+
+    return &buf_[offset];
+}
+
 void WebmUtil::ScratchBuf::Write(const uint8* read_ptr, int32 length)
 {
-    int64 slen = length;
-    for (int64 i = 0; i < slen; ++i)
-    {
-        buf_.push_back(*read_ptr++);
-    }
+    buf_.insert(buf_.end(), read_ptr, read_ptr + length);
 }
 
 void WebmUtil::ScratchBuf::Write4Float(float val)
@@ -339,7 +345,7 @@ int WebmUtil::EbmlScratchBuf::RewriteUInt(uint32 offset, uint64 val,
 {
     if (size > 0)
     {
-        const uint64 bits = 1UI64 << (size * 7);
+        const uint64 bits = GG_ULONGLONG(1) << (size * 7);
         assert(val <= (bits - 2));
 
         val |= bits;
@@ -352,7 +358,7 @@ int WebmUtil::EbmlScratchBuf::RewriteUInt(uint32 offset, uint64 val,
 
         for (;;)
         {
-            bit = 1UI64 << (size * 7);
+            bit = GG_ULONGLONG(1) << (size * 7);
             const uint64 max = bit - 2;
 
             if (val <= max)
@@ -413,7 +419,7 @@ void WebmUtil::EbmlScratchBuf::WriteUInt(uint64 val, int32 size)
 {
     if (size > 0)
     {
-        const uint64 bits = 1UI64 << (size * 7);
+        const uint64 bits = GG_ULONGLONG(1) << (size * 7);
         assert(val <= (bits - 2));
 
         val |= bits;
@@ -426,7 +432,7 @@ void WebmUtil::EbmlScratchBuf::WriteUInt(uint64 val, int32 size)
 
         for (;;)
         {
-            bit = 1UI64 << (size * 7);
+            bit = GG_ULONGLONG(1) << (size * 7);
             const uint64 max = bit - 2;
 
             if (val <= max)
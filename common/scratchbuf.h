@@ -32,6 +32,11 @@ public:
     int32 Rewrite(uint32 offset, const uint8* ptr_data, int32 length);
     int32 Rewrite(uint64 offset, const uint8* ptr_data, int32 length);
 
+    // Grows the buffer by |length| bytes, and returns them for the caller
+    // to fill in (with the EbmlWriter element types, say).  The pointer is
+    // only good until the buffer next grows.
+    uint8* Append(int32 length);
+
     void Write(const uint8* ptr_data, int32 length);
     void Write4Float(float val);
     void Write1String(const char* ptr_str);
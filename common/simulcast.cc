@@ -0,0 +1,274 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "simulcast.h"
+
+#include <cassert>
+#include <cmath>
+#include <system_error>
+
+namespace WebmUtil
+{
+
+bool GetSimulcastFrameSize(int source_width,
+                           int source_height,
+                           int width,
+                           int height,
+                           int& out_width,
+                           int& out_height)
+{
+    if ((source_width <= 0) || (source_height <= 0))
+        return false;
+
+    if ((width < 0) || (height < 0))
+        return false;
+
+    if ((width == 0) && (height == 0))
+        return false;
+
+    const long long sw = source_width;
+    const long long sh = source_height;
+
+    long long w = width;
+    long long h = height;
+
+    if (w == 0)
+        w = (h * sw + sh / 2) / sh;
+    else if (h == 0)
+        h = (w * sh + sw / 2) / sw;
+
+    if ((w > sw) || (h > sh))
+    {
+        // Scale down to fit: by the width if it is further over than the
+        // height is (w/sw > h/sh), otherwise by the height.
+        if (w * sh > h * sw)
+        {
+            h = (h * sw + w / 2) / w;
+            w = sw;
+        }
+        else
+        {
+            w = (w * sh + h / 2) / h;
+            h = sh;
+        }
+    }
+
+    w &= ~1LL;
+    h &= ~1LL;
+
+    out_width = (w < 2) ? 2 : static_cast<int>(w);
+    out_height = (h < 2) ? 2 : static_cast<int>(h);
+
+    return true;
+}
+
+int GetSimulcastTargetBitrate(int source_width,
+                              int source_height,
+                              int source_bitrate,
+                              int width,
+                              int height)
+{
+    if ((source_width <= 0) || (source_height <= 0) || (source_bitrate <= 0))
+        return source_bitrate;
+
+    const double source_area = double(source_width) * source_height;
+    const double area = double(width) * height;
+
+    const double rate = source_bitrate * pow(area / source_area, 0.75);
+
+    if (rate < 1)
+        return 1;
+
+    return static_cast<int>(rate + 0.5);
+}
+
+SimulcastKeyframes::SimulcastKeyframes()
+{
+    Reset(0, 0);
+}
+
+void SimulcastKeyframes::Reset(int max_frames, long long max_interval)
+{
+    m_max_frames = (max_frames < 0) ? 0 : max_frames;
+    m_max_interval = (max_interval < 0) ? 0 : max_interval;
+    m_first = true;
+    m_frames = 0;
+    m_time = 0;
+}
+
+bool SimulcastKeyframes::IsKeyframe(long long time, bool force)
+{
+    bool key = force || m_first;
+
+    if (!key)
+    {
+        ++m_frames;
+
+        if ((m_max_frames > 0) && (m_frames >= m_max_frames))
+            key = true;
+
+        else if ((m_max_interval > 0) && (time - m_time >= m_max_interval))
+            key = true;
+    }
+
+    if (key)
+    {
+        m_first = false;
+        m_frames = 0;
+        m_time = time;
+    }
+
+    return key;
+}
+
+SimulcastWorkers::SimulcastWorkers() :
+    m_count(0),
+    m_job(0),
+    m_job_count(0),
+    m_generation(0),
+    m_busy(0),
+    m_stop(false)
+{
+}
+
+SimulcastWorkers::~SimulcastWorkers()
+{
+    Stop();
+}
+
+void SimulcastWorkers::Start(int count, bool threaded)
+{
+    assert(m_threads.empty());
+
+    m_count = (count < 0) ? 0 : count;
+    m_job = 0;
+    m_job_count = 0;
+    m_generation = 0;
+    m_busy = 0;
+    m_stop = false;
+
+    if (!threaded)
+        return;
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        try
+        {
+            m_threads.push_back(std::thread(&SimulcastWorkers::Main, this, i));
+        }
+        catch (const std::system_error&)
+        {
+            // The jobs run on the caller's thread instead.
+            Stop();
+            return;
+        }
+    }
+}
+
+void SimulcastWorkers::Stop()
+{
+    if (m_threads.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        assert(m_busy == 0);  // Wait has returned
+        m_stop = true;
+    }
+
+    m_job_cond.notify_all();
+
+    typedef std::vector<std::thread>::iterator iter_t;
+
+    for (iter_t i = m_threads.begin(); i != m_threads.end(); ++i)
+        i->join();
+
+    m_threads.clear();
+    m_stop = false;
+}
+
+int SimulcastWorkers::GetCount() const
+{
+    return m_count;
+}
+
+bool SimulcastWorkers::IsThreaded() const
+{
+    return !m_threads.empty();
+}
+
+void SimulcastWorkers::Begin(Job* job, int count)
+{
+    assert(job);
+    assert(count <= m_count);
+
+    if (m_threads.empty())
+    {
+        for (int i = 0; i < count; ++i)
+            job->Run(i);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        assert(m_busy == 0);  // the previous job has been waited for
+
+        m_job = job;
+        m_job_count = count;
+        m_busy = static_cast<int>(m_threads.size());
+        ++m_generation;
+    }
+
+    m_job_cond.notify_all();
+}
+
+void SimulcastWorkers::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_busy > 0)
+        m_done_cond.wait(lock);
+
+    m_job = 0;
+}
+
+void SimulcastWorkers::Main(int index)
+{
+    unsigned long generation = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        while (!m_stop && (m_generation == generation))
+            m_job_cond.wait(lock);
+
+        if (m_stop)
+            return;
+
+        generation = m_generation;
+
+        Job* const job = m_job;
+        const int count = m_job_count;
+
+        lock.unlock();
+
+        if (index < count)
+            job->Run(index);
+
+        lock.lock();
+
+        if (--m_busy == 0)
+            m_done_cond.notify_all();
+    }
+}
+
+}  // namespace WebmUtil
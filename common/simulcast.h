@@ -0,0 +1,138 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_SIMULCAST_HPP__
+#define __WEBMDSHOW_COMMON_SIMULCAST_HPP__
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The parts of a simulcast encode (one input, encoded at several sizes and
+// bitrates) that don't depend on DirectShow or libvpx: the size and bitrate
+// of each rendition, where the keyframes go, and the threads that run the
+// rendition encoders alongside the main one.
+
+namespace WebmUtil
+{
+
+// The size of a rendition configured as |width| by |height|, for a source
+// |source_width| by |source_height|.  A width or height of 0 follows from
+// the other, keeping the source's aspect ratio.  A rendition is never
+// larger than the source (it is scaled down to fit, keeping its own aspect
+// ratio), and its dimensions are rounded down to even numbers, as I420
+// needs.  Returns false if both are 0, or either is negative.
+bool GetSimulcastFrameSize(int source_width,
+                           int source_height,
+                           int width,
+                           int height,
+                           int& out_width,
+                           int& out_height);
+
+// The bitrate (kbps) of a rendition that wasn't given one: the source's
+// |source_bitrate|, scaled by the ratio of the areas to the power 0.75,
+// since a smaller frame needs more bits per pixel for the same quality.
+int GetSimulcastTargetBitrate(int source_width,
+                              int source_height,
+                              int source_bitrate,
+                              int width,
+                              int height);
+
+// Decides which input frames are keyframes, for all of the renditions at
+// once.  The encoders' own keyframe placement is turned off, and a
+// keyframe is forced on each of them at the frames this returns true for,
+// so that a player can switch between renditions at any keyframe.
+class SimulcastKeyframes
+{
+public:
+
+    SimulcastKeyframes();
+
+    // |max_frames| is the most frames from one keyframe to the next, and
+    // |max_interval| the longest time (in the units of the times passed to
+    // IsKeyframe); 0 means no limit.  The next frame is a keyframe.
+    void Reset(int max_frames, long long max_interval);
+
+    // Called for each frame that is encoded, in order.  |force| makes
+    // this frame a keyframe (the first frame, a discontinuity, or a
+    // request from the application).
+    bool IsKeyframe(long long time, bool force);
+
+private:
+
+    int m_max_frames;
+    long long m_max_interval;
+    bool m_first;
+    int m_frames;  // since the last keyframe
+    long long m_time;  // of the last keyframe
+
+};
+
+// Runs the rendition encoders on threads of their own.  Begin hands each
+// worker its job; the caller then encodes the main rendition, and Wait
+// returns once the workers have finished.
+//
+// Without threads (Start's |threaded| argument is false, or a thread could
+// not be created), Begin runs the jobs itself before it returns.
+class SimulcastWorkers
+{
+    SimulcastWorkers(const SimulcastWorkers&);
+    SimulcastWorkers& operator=(const SimulcastWorkers&);
+
+public:
+
+    class Job
+    {
+    public:
+        virtual void Run(int index) = 0;
+
+    protected:
+        virtual ~Job() {}
+    };
+
+    SimulcastWorkers();
+    ~SimulcastWorkers();
+
+    // Starts |count| workers.
+    void Start(int count, bool threaded);
+    void Stop();
+
+    int GetCount() const;
+    bool IsThreaded() const;
+
+    // Calls job->Run(i) for each i less than |count| (at most the number
+    // of workers), each one on its own worker.  The job must stay valid
+    // until Wait returns.
+    void Begin(Job* job, int count);
+    void Wait();
+
+private:
+
+    std::vector<std::thread> m_threads;
+    int m_count;
+
+    std::mutex m_mutex;
+    std::condition_variable m_job_cond;   // workers wait for a job
+    std::condition_variable m_done_cond;  // Wait waits for the workers
+
+    Job* m_job;
+    int m_job_count;
+    unsigned long m_generation;  // of the current job
+    int m_busy;  // workers that haven't finished the current job
+    bool m_stop;
+
+    void Main(int index);
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_SIMULCAST_HPP__
@@ -0,0 +1,294 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "speedgovernor.h"
+
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+// The load above which the encoder is made faster, and below which it is
+// comfortable.  Between the two, nothing changes.
+const double kFastLoad = 0.90;
+const double kSlowLoad = 0.60;
+
+// A backlog (in frames) above this makes the encoder faster, unless it is
+// already draining; one below kCalmBacklog is comfortable.
+const double kMaxBacklog = 2.0;
+const double kCalmBacklog = 1.0;
+
+// The weight of each frame in the smoothed load.
+const double kSmoothing = 1.0 / 8;
+
+const wchar_t* const kScaleNames[] =
+{
+    L"1/1",
+    L"4/5",
+    L"3/5",
+    L"1/2"
+};
+
+}  // namespace
+
+namespace WebmUtil
+{
+
+SpeedGovernor::SpeedGovernor()
+{
+    Settings s;
+
+    s.cpu_used_min = 0;
+    s.cpu_used_max = 0;
+    s.deadline = 0;
+    s.fast_deadline = -1;
+    s.max_scale = 0;
+
+    Reset(s, 0);
+}
+
+void SpeedGovernor::Reset(const Settings& s, int cpu_used)
+{
+    assert(s.cpu_used_min <= s.cpu_used_max);
+    assert(s.max_scale >= 0);
+    assert(s.max_scale <= kMaxScale);
+
+    m_settings = s;
+
+    if (cpu_used < s.cpu_used_min)
+        cpu_used = s.cpu_used_min;
+    else if (cpu_used > s.cpu_used_max)
+        cpu_used = s.cpu_used_max;
+
+    m_state.cpu_used = cpu_used;
+    m_state.deadline = s.deadline;
+    m_state.scale = 0;
+
+    m_load = -1;
+    m_backlog = 0;
+    m_window_backlog = 0;
+    m_min_lateness = -1;
+    m_frames = 0;
+    m_calm_windows = 0;
+    m_recover_windows = kRecoverWindows;
+    m_windows_since_slower = -1;
+    m_limit = false;
+}
+
+SpeedGovernor::Change SpeedGovernor::OnFrame(long long encode_us,
+                                             long long interval_us,
+                                             long long lateness_us)
+{
+    if (interval_us <= 0)
+        return kNone;
+
+    const double load = double(encode_us) / interval_us;
+
+    if (m_load < 0)
+        m_load = load;  // the first frame
+    else
+        m_load += (load - m_load) * kSmoothing;
+
+    if (lateness_us >= 0)
+    {
+        if ((m_min_lateness < 0) || (lateness_us < m_min_lateness))
+            m_min_lateness = lateness_us;
+
+        m_backlog = double(lateness_us - m_min_lateness) / interval_us;
+    }
+
+    if (++m_frames < kWindowFrames)
+        return kNone;
+
+    // The end of a window: at most one change per window, so that the
+    // smoothed load has had time to follow the last one.
+
+    const bool draining = (m_backlog < m_window_backlog);
+
+    m_frames = 0;
+    m_window_backlog = m_backlog;
+
+    if (m_windows_since_slower >= 0)
+        ++m_windows_since_slower;
+
+    const bool behind = (m_load > kFastLoad) ||
+                        ((m_backlog > kMaxBacklog) && !draining);
+
+    if (behind)
+    {
+        m_calm_windows = 0;
+
+        if (!Faster())
+        {
+            if (m_limit)
+                return kNone;
+
+            m_limit = true;
+            return kLimit;
+        }
+
+        // Slowing down didn't last: wait longer before trying again.
+
+        if ((m_windows_since_slower >= 0) && (m_windows_since_slower <= 2))
+        {
+            m_recover_windows *= 2;
+
+            if (m_recover_windows > kMaxRecoverWindows)
+                m_recover_windows = kMaxRecoverWindows;
+        }
+
+        m_windows_since_slower = -1;
+        return kFaster;
+    }
+
+    m_limit = false;
+
+    const bool calm = (m_load < kSlowLoad) && (m_backlog < kCalmBacklog);
+
+    if (!calm)
+    {
+        m_calm_windows = 0;
+        return kNone;
+    }
+
+    if (++m_calm_windows < m_recover_windows)
+        return kNone;
+
+    m_calm_windows = 0;
+
+    if (!Slower())
+        return kNone;
+
+    m_windows_since_slower = 0;
+    return kSlower;
+}
+
+bool SpeedGovernor::Faster()
+{
+    State& s = m_state;
+
+    if (s.cpu_used < m_settings.cpu_used_max)
+    {
+        ++s.cpu_used;
+        return true;
+    }
+
+    const long fast = m_settings.fast_deadline;
+
+    const unsigned long fast_ = static_cast<unsigned long>(fast);
+
+    if ((fast > 0) && ((s.deadline == 0) || (s.deadline > fast_)))
+    {
+        s.deadline = fast_;
+        return true;
+    }
+
+    if (s.scale < m_settings.max_scale)
+    {
+        ++s.scale;
+        return true;
+    }
+
+    return false;
+}
+
+bool SpeedGovernor::Slower()
+{
+    State& s = m_state;
+
+    if (s.scale > 0)
+    {
+        --s.scale;
+        return true;
+    }
+
+    if (s.deadline != m_settings.deadline)
+    {
+        s.deadline = m_settings.deadline;
+        return true;
+    }
+
+    if (s.cpu_used > m_settings.cpu_used_min)
+    {
+        --s.cpu_used;
+        return true;
+    }
+
+    return false;
+}
+
+const SpeedGovernor::State& SpeedGovernor::GetState() const
+{
+    return m_state;
+}
+
+double SpeedGovernor::GetLoad() const
+{
+    return (m_load < 0) ? 0 : m_load;
+}
+
+double SpeedGovernor::GetBacklog() const
+{
+    return m_backlog;
+}
+
+std::wstring SpeedGovernor::Describe(Change c, const State& before) const
+{
+    std::wostringstream os;
+
+    switch (c)
+    {
+        case kFaster:
+            os << L"faster:";
+            break;
+
+        case kSlower:
+            os << L"slower:";
+            break;
+
+        case kLimit:
+            os << L"at limit:";
+            break;
+
+        case kNone:
+        default:
+            os << L"unchanged:";
+            break;
+    }
+
+    const State& s = m_state;
+
+    if (s.cpu_used != before.cpu_used)
+        os << L" cpu_used " << before.cpu_used << L" -> " << s.cpu_used;
+
+    if (s.deadline != before.deadline)
+        os << L" deadline " << before.deadline << L" -> " << s.deadline;
+
+    if (s.scale != before.scale)
+    {
+        os << L" scale " << kScaleNames[before.scale]
+           << L" -> " << kScaleNames[s.scale];
+    }
+
+    if (c == kLimit)
+    {
+        os << L" cpu_used " << s.cpu_used
+           << L" deadline " << s.deadline
+           << L" scale " << kScaleNames[s.scale];
+    }
+
+    os << L"; load " << std::fixed << std::setprecision(0)
+       << (GetLoad() * 100) << L"%, backlog " << std::setprecision(1)
+       << m_backlog << L" frames";
+
+    return os.str();
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,124 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_SPEEDGOVERNOR_HPP__
+#define __WEBMDSHOW_COMMON_SPEEDGOVERNOR_HPP__
+
+#pragma once
+
+#include <string>
+
+// Keeps a live encode up with real time.  The encoder reports how long
+// each frame took, against the time per frame, and how late the frame was
+// (how long it waited upstream); the governor makes the encoder faster
+// when it falls behind, and gives the time back to quality once it has
+// been comfortably ahead for a while.
+//
+// The encoder gets faster a step at a time: first a higher cpu_used, up to
+// the maximum; then the fast deadline (normally realtime); then libvpx's
+// internal scaling, up to the maximum.  It gets slower in the reverse
+// order, down to the minimum cpu_used.
+//
+// Like VpxQualityGovernor, this is a plain state machine that knows
+// nothing about DirectShow or libvpx, and the caller serializes access to
+// it.  The scaling steps are those of libvpx's VPX_SCALING_MODE
+// (VP8E_NORMAL, VP8E_FOURFIVE, VP8E_THREEFIVE and VP8E_ONETWO).
+
+namespace WebmUtil
+{
+
+class SpeedGovernor
+{
+    SpeedGovernor(const SpeedGovernor&);
+    SpeedGovernor& operator=(const SpeedGovernor&);
+
+public:
+
+    enum { kMaxScale = 3 };
+
+    struct Settings
+    {
+        int cpu_used_min;
+        int cpu_used_max;
+        unsigned long deadline;  // as configured (us, 0 for best quality)
+        long fast_deadline;      // < 0 never changes the deadline
+        int max_scale;           // 0 to kMaxScale
+    };
+
+    struct State
+    {
+        int cpu_used;
+        unsigned long deadline;
+        int scale;
+    };
+
+    enum Change
+    {
+        kNone,
+        kFaster,
+        kSlower,
+        kLimit  // behind, and already as fast as the settings allow
+    };
+
+    enum
+    {
+        kWindowFrames = 12,   // frames between decisions
+        kRecoverWindows = 8,  // comfortable windows before slowing down
+        kMaxRecoverWindows = 64
+    };
+
+    SpeedGovernor();
+
+    // Starts over from |cpu_used| (the encoder's setting, clamped to the
+    // range) and the configured deadline, at full size.
+    void Reset(const Settings&, int cpu_used);
+
+    // Called for each frame encoded.  |encode_us| is the wall time that
+    // the frame took, |interval_us| the time per frame, and |lateness_us|
+    // how far past its timestamp it was encoded, or -1 if that isn't known
+    // (there's no clock).  Returns the change that GetState now reflects.
+    Change OnFrame(long long encode_us,
+                   long long interval_us,
+                   long long lateness_us);
+
+    const State& GetState() const;
+
+    // The encode time as a share of the time per frame (smoothed).
+    double GetLoad() const;
+
+    // The frames queued upstream: the lateness of the last frame, less the
+    // least that any frame has been late (the latency of the capture
+    // itself), in frames.
+    double GetBacklog() const;
+
+    // Describes the last change, from |before|, for an event log.
+    std::wstring Describe(Change, const State& before) const;
+
+private:
+
+    Settings m_settings;
+    State m_state;
+
+    double m_load;  // < 0 before the first frame
+    double m_backlog;
+    double m_window_backlog;  // at the start of the window
+    long long m_min_lateness;  // < 0 until known
+    int m_frames;  // in this window
+    int m_calm_windows;
+    int m_recover_windows;
+    int m_windows_since_slower;  // < 0 if there wasn't one
+    bool m_limit;  // the kLimit change has been reported
+
+    bool Faster();
+    bool Slower();
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_SPEEDGOVERNOR_HPP__
@@ -0,0 +1,133 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chunkplanner.h"
+
+// These build on Linux as well:
+//
+//   g++ -std=c++11 -Icommon common/chunkplanner.cc
+//       common/tests/chunkplanner_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::ChunkPlanner;
+
+namespace
+{
+
+const long long kSecond = 10000000;
+
+// Starts from the keyframe at or before the seek time, as webmsplit does.
+class KeyframeSource : public ChunkPlanner::Source
+{
+public:
+    explicit KeyframeSource(long long interval) : m_interval(interval) {}
+
+    long long Seek(long long time)
+    {
+        m_seeks.push_back(time);
+        return time - (time % m_interval);
+    }
+
+    std::vector<long long> m_seeks;
+
+private:
+    const long long m_interval;
+};
+
+// Starts exactly at the seek time.
+class ExactSource : public ChunkPlanner::Source
+{
+public:
+    long long Seek(long long time) { return time; }
+};
+
+class FailingSource : public ChunkPlanner::Source
+{
+public:
+    long long Seek(long long) { return -1; }
+};
+
+}  // namespace
+
+TEST(ChunkPlannerTest, SplitsEvenlyWhenTheSourceIsExact)
+{
+    ExactSource source;
+    ChunkPlanner::chunks_t chunks;
+
+    ASSERT_TRUE(ChunkPlanner::Plan(source, 12 * kSecond, 3, chunks));
+    ASSERT_EQ(3u, chunks.size());
+
+    EXPECT_EQ(0, chunks[0].start);
+    EXPECT_EQ(4 * kSecond, chunks[0].stop);
+    EXPECT_EQ(4 * kSecond, chunks[1].start);
+    EXPECT_EQ(8 * kSecond, chunks[1].stop);
+    EXPECT_EQ(8 * kSecond, chunks[2].start);
+    EXPECT_EQ(12 * kSecond, chunks[2].stop);
+}
+
+TEST(ChunkPlannerTest, StartsChunksOnTheKeyframeTheSourceSeeksTo)
+{
+    KeyframeSource source(3 * kSecond);
+    ChunkPlanner::chunks_t chunks;
+
+    ASSERT_TRUE(ChunkPlanner::Plan(source, 20 * kSecond, 4, chunks));
+
+    // The nominal starts are 0, 5, 10 and 15 seconds.
+    ASSERT_EQ(4u, chunks.size());
+
+    EXPECT_EQ(0, chunks[0].start);
+    EXPECT_EQ(3 * kSecond, chunks[1].start);
+    EXPECT_EQ(9 * kSecond, chunks[2].start);
+    EXPECT_EQ(15 * kSecond, chunks[3].start);
+
+    // Each chunk ends where the next one starts, so nothing is repeated.
+    for (size_t i = 1; i < chunks.size(); ++i)
+        EXPECT_EQ(chunks[i].start, chunks[i - 1].stop);
+
+    EXPECT_EQ(20 * kSecond, chunks.back().stop);
+}
+
+TEST(ChunkPlannerTest, MergesChunksWhenKeyframesAreFurtherApart)
+{
+    // A keyframe every 5 seconds, and a chunk every 2.
+    KeyframeSource source(5 * kSecond);
+    ChunkPlanner::chunks_t chunks;
+
+    ASSERT_TRUE(ChunkPlanner::Plan(source, 20 * kSecond, 10, chunks));
+    EXPECT_EQ(10u, source.m_seeks.size());
+
+    ASSERT_EQ(4u, chunks.size());
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        EXPECT_EQ(static_cast<long long>(i) * 5 * kSecond, chunks[i].start);
+        EXPECT_EQ(chunks[i].start + 5 * kSecond, chunks[i].stop);
+    }
+}
+
+TEST(ChunkPlannerTest, UsesASingleChunkWithOneKeyframe)
+{
+    KeyframeSource source(60 * kSecond);
+    ChunkPlanner::chunks_t chunks;
+
+    ASSERT_TRUE(ChunkPlanner::Plan(source, 20 * kSecond, 4, chunks));
+    ASSERT_EQ(1u, chunks.size());
+
+    EXPECT_EQ(0, chunks[0].start);
+    EXPECT_EQ(20 * kSecond, chunks[0].stop);
+}
+
+TEST(ChunkPlannerTest, FailsWhenTheSourceCannotSeek)
+{
+    FailingSource source;
+    ChunkPlanner::chunks_t chunks;
+
+    EXPECT_FALSE(ChunkPlanner::Plan(source, 20 * kSecond, 4, chunks));
+}
@@ -0,0 +1,316 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <windows.h>
+#include <strmif.h>
+#include <vfwmsgs.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cmediasample.h"
+#include "gtest/gtest.h"
+
+namespace
+{
+    class ComInit
+    {
+    public:
+        ComInit() { CoInitializeEx(0, COINIT_MULTITHREADED); }
+        ~ComInit() { CoUninitialize(); }
+    };
+
+    IMemAllocator* CreateAllocator(long cBuffers, long cbBuffer)
+    {
+        IMemAllocator* pAllocator = 0;
+
+        HRESULT hr = CMediaSample::CreateAllocator(&pAllocator);
+        EXPECT_EQ(S_OK, hr);
+
+        if (FAILED(hr))
+            return 0;
+
+        ALLOCATOR_PROPERTIES props;
+
+        props.cBuffers = cBuffers;
+        props.cbBuffer = cbBuffer;
+        props.cbAlign = 1;
+        props.cbPrefix = 0;
+
+        ALLOCATOR_PROPERTIES actual;
+
+        hr = pAllocator->SetProperties(&props, &actual);
+        EXPECT_EQ(S_OK, hr);
+
+        hr = pAllocator->Commit();
+        EXPECT_EQ(S_OK, hr);
+
+        return pAllocator;
+    }
+
+    double Percentile(std::vector<long long>& v, double p)
+    {
+        if (v.empty())
+            return 0;
+
+        const size_t n = static_cast<size_t>(p * (v.size() - 1));
+        std::nth_element(v.begin(), v.begin() + n, v.end());
+
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+
+        return 1e6 * double(v[n]) / double(freq.QuadPart);  // microseconds
+    }
+
+    long long Now()
+    {
+        LARGE_INTEGER t;
+        QueryPerformanceCounter(&t);
+
+        return t.QuadPart;
+    }
+}
+
+TEST(CMemAllocatorTest, BuffersAreCacheLineAligned)
+{
+    ComInit com;
+
+    IMemAllocator* pAllocator;
+    ASSERT_EQ(S_OK, CMediaSample::CreateAllocator(&pAllocator));
+
+    ALLOCATOR_PROPERTIES props;
+
+    props.cBuffers = 8;
+    props.cbBuffer = 1000;
+    props.cbAlign = 1;
+    props.cbPrefix = 0;
+
+    ALLOCATOR_PROPERTIES actual;
+
+    ASSERT_EQ(S_OK, pAllocator->SetProperties(&props, &actual));
+    EXPECT_EQ(long(CMemAllocator::kMinAlign), actual.cbAlign);
+    ASSERT_EQ(S_OK, pAllocator->Commit());
+
+    std::vector<IMediaSample*> samples;
+
+    for (long i = 0; i < props.cBuffers; ++i)
+    {
+        IMediaSample* pSample;
+        ASSERT_EQ(S_OK, pAllocator->GetBuffer(&pSample, 0, 0, 0));
+
+        BYTE* ptr;
+        ASSERT_EQ(S_OK, pSample->GetPointer(&ptr));
+        EXPECT_EQ(0, intptr_t(ptr) % CMemAllocator::kMinAlign);
+        EXPECT_GE(pSample->GetSize(), props.cbBuffer);
+
+        samples.push_back(pSample);
+    }
+
+    IMediaSample* pSample;
+    EXPECT_EQ(VFW_E_TIMEOUT,
+              pAllocator->GetBuffer(&pSample, 0, 0, AM_GBF_NOWAIT));
+
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i]->Release();
+
+    EXPECT_EQ(S_OK, pAllocator->GetBuffer(&pSample, 0, 0, AM_GBF_NOWAIT));
+    pSample->Release();
+
+    EXPECT_EQ(S_OK, pAllocator->Decommit());
+    pAllocator->Release();
+}
+
+TEST(CMemAllocatorTest, DecommitWakesEveryWaiter)
+{
+    ComInit com;
+
+    IMemAllocator* const pAllocator = CreateAllocator(1, 100);
+    ASSERT_TRUE(pAllocator != 0);
+
+    IMediaSample* pHeld;
+    ASSERT_EQ(S_OK, pAllocator->GetBuffer(&pHeld, 0, 0, 0));
+
+    const int kWaiters = 4;
+    std::atomic<int> woken(0);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kWaiters; ++i)
+    {
+        threads.push_back(std::thread([&]
+        {
+            ComInit com;
+
+            IMediaSample* pSample;
+            const HRESULT hr = pAllocator->GetBuffer(&pSample, 0, 0, 0);
+
+            if (hr == VFW_E_NOT_COMMITTED)
+                ++woken;
+            else if (SUCCEEDED(hr))
+                pSample->Release();
+        }));
+    }
+
+    Sleep(100);  // let them all block
+    EXPECT_EQ(S_OK, pAllocator->Decommit());
+
+    for (int i = 0; i < kWaiters; ++i)
+        threads[i].join();
+
+    EXPECT_EQ(kWaiters, woken.load());
+
+    pHeld->Release();  // destroyed, since we're decommitted
+    pAllocator->Release();
+}
+
+// Not a pass/fail test as much as a benchmark: producer threads get
+// buffers and hand them to consumer threads, which release them, with
+// fewer buffers than threads so that GetBuffer has to wait.  It reports
+// the GetBuffer and ReleaseBuffer latencies.
+TEST(CMemAllocatorTest, ProducerConsumerStress)
+{
+    ComInit com;
+
+    const int kProducers = 4;
+    const int kConsumers = 4;
+    const int kIterations = 20000;  // per producer
+    const long kBuffers = 3;
+
+    IMemAllocator* const pAllocator = CreateAllocator(kBuffers, 4096);
+    ASSERT_TRUE(pAllocator != 0);
+
+    std::mutex mutex;
+    std::deque<IMediaSample*> queue;
+    std::atomic<int> remaining(kProducers * kIterations);
+    std::atomic<int> errors(0);
+
+    std::vector<long long> get_ticks[kProducers];
+    std::vector<long long> release_ticks[kConsumers];
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < kProducers; ++t)
+    {
+        std::vector<long long>& ticks = get_ticks[t];
+
+        threads.push_back(std::thread([&]
+        {
+            ComInit com;
+            ticks.reserve(kIterations);
+
+            for (int k = 0; k < kIterations; ++k)
+            {
+                const long long start = Now();
+
+                IMediaSample* pSample;
+                const HRESULT hr = pAllocator->GetBuffer(&pSample, 0, 0, 0);
+
+                ticks.push_back(Now() - start);
+
+                if (hr != S_OK)
+                {
+                    ++errors;
+                    --remaining;
+                    continue;
+                }
+
+                BYTE* ptr;
+                pSample->GetPointer(&ptr);
+                ptr[0] = BYTE(k);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(pSample);
+            }
+        }));
+    }
+
+    for (int t = 0; t < kConsumers; ++t)
+    {
+        std::vector<long long>& ticks = release_ticks[t];
+
+        threads.push_back(std::thread([&]
+        {
+            ComInit com;
+
+            while (remaining > 0)
+            {
+                IMediaSample* pSample = 0;
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    if (!queue.empty())
+                    {
+                        pSample = queue.front();
+                        queue.pop_front();
+                    }
+                }
+
+                if (pSample == 0)
+                {
+                    SwitchToThread();
+                    continue;
+                }
+
+                const long long start = Now();
+                pSample->Release();
+                ticks.push_back(Now() - start);
+
+                --remaining;
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    EXPECT_EQ(0, errors.load());
+    EXPECT_TRUE(queue.empty());
+
+    std::vector<long long> get_all;
+    std::vector<long long> release_all;
+
+    for (int t = 0; t < kProducers; ++t)
+        get_all.insert(get_all.end(), get_ticks[t].begin(), get_ticks[t].end());
+
+    for (int t = 0; t < kConsumers; ++t)
+    {
+        const std::vector<long long>& v = release_ticks[t];
+        release_all.insert(release_all.end(), v.begin(), v.end());
+    }
+
+    printf("GetBuffer (us):     p50=%.2f p99=%.2f max=%.2f\n",
+           Percentile(get_all, 0.5),
+           Percentile(get_all, 0.99),
+           Percentile(get_all, 1.0));
+
+    printf("ReleaseBuffer (us): p50=%.2f p99=%.2f max=%.2f\n",
+           Percentile(release_all, 0.5),
+           Percentile(release_all, 0.99),
+           Percentile(release_all, 1.0));
+
+    // Every buffer came back, so we can have them all at once.
+    std::vector<IMediaSample*> samples;
+
+    for (long i = 0; i < kBuffers; ++i)
+    {
+        IMediaSample* pSample;
+        EXPECT_EQ(S_OK, pAllocator->GetBuffer(&pSample, 0, 0, AM_GBF_NOWAIT));
+        samples.push_back(pSample);
+    }
+
+    for (size_t i = 0; i < samples.size(); ++i)
+        samples[i]->Release();
+
+    EXPECT_EQ(S_OK, pAllocator->Decommit());
+    pAllocator->Release();
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "ebmlwriter.h"
+
+// These build on Linux as well (basictypes.h needs the stand-ins for the
+// Windows types in common/portable):
+//
+//   g++ -std=c++11 -Icommon/portable -include webmportable.h -Icommon
+//       -Ithird_party common/tests/ebmlwriter_tests.cc
+//       -lgtest -lgtest_main -lpthread
+
+using WebmUtil::EbmlElementID;
+using WebmUtil::EbmlFloat;
+using WebmUtil::EbmlMaster;
+using WebmUtil::EbmlSize;
+using WebmUtil::EbmlUInt;
+using WebmUtil::EbmlVarUInt;
+using WebmUtil::EbmlVoid;
+using WebmUtil::EbmlWriter;
+
+namespace
+{
+
+typedef std::vector<uint8> Bytes;
+
+Bytes GetBytes(const EbmlWriter& w)
+{
+    return Bytes(w.GetBufferPtr(), w.GetBufferPtr() + w.GetLength());
+}
+
+Bytes MakeBytes(const uint8* p, size_t n)
+{
+    return Bytes(p, p + n);
+}
+
+}  // namespace
+
+TEST(EbmlWriterTest, IDLengthsFollowTheMarkerBit)
+{
+    EXPECT_EQ(1, EbmlElementID<WebmUtil::kEbmlVoidID>::kLength);
+    EXPECT_EQ(2, EbmlElementID<WebmUtil::kEbmlTrackUIDID>::kLength);
+    EXPECT_EQ(3, EbmlElementID<WebmUtil::kEbmlTimeCodeScaleID>::kLength);
+    EXPECT_EQ(4, EbmlElementID<WebmUtil::kEbmlClusterID>::kLength);
+
+    uint8 buf[4];
+    EXPECT_EQ(buf + 4, EbmlElementID<WebmUtil::kEbmlClusterID>::Store(buf));
+
+    const uint8 expected[] = { 0x1F, 0x43, 0xB6, 0x75 };
+    EXPECT_EQ(MakeBytes(expected, 4), MakeBytes(buf, 4));
+}
+
+TEST(EbmlWriterTest, StoresSizes)
+{
+    uint8 buf[8];
+
+    EbmlSize<1>::Store(buf, 5);
+    EXPECT_EQ(0x85, buf[0]);
+
+    EbmlSize<2>::Store(buf, 0x123);
+    EXPECT_EQ(0x41, buf[0]);
+    EXPECT_EQ(0x23, buf[1]);
+
+    EXPECT_EQ(0x7Eu, EbmlSize<1>::GetMax());
+
+    // All ones is "unknown".
+    EbmlSize<1>::StoreUnknown(buf);
+    EXPECT_EQ(0xFF, buf[0]);
+
+    EbmlSize<8>::StoreUnknown(buf);
+    EXPECT_EQ(0x01, buf[0]);
+
+    for (int i = 1; i < 8; ++i)
+        EXPECT_EQ(0xFF, buf[i]);
+}
+
+TEST(EbmlWriterTest, WritesNumbers)
+{
+    typedef EbmlUInt<WebmUtil::kEbmlTrackNumberID, 1> TrackNumber;
+    typedef EbmlUInt<WebmUtil::kEbmlVideoWidth, 2> Width;
+    typedef EbmlFloat<WebmUtil::kEbmlSamplingFrequencyID> Frequency;
+
+    EXPECT_EQ(3, TrackNumber::kLength);
+    EXPECT_EQ(4, Width::kLength);
+    EXPECT_EQ(6, Frequency::kLength);
+
+    uint8 buf[TrackNumber::kLength + Width::kLength + Frequency::kLength];
+    EbmlWriter w(buf, sizeof(buf));
+
+    w.Write<TrackNumber>(1);
+    w.Write<Width>(640);
+    w.WriteFloat<Frequency>(48000.0f);  // 0x473B8000
+
+    const uint8 expected[] =
+    {
+        0xD7, 0x81, 0x01,
+        0xB0, 0x82, 0x02, 0x80,
+        0xB5, 0x84, 0x47, 0x3B, 0x80, 0x00
+    };
+
+    EXPECT_EQ(MakeBytes(expected, sizeof(expected)), GetBytes(w));
+}
+
+TEST(EbmlWriterTest, WritesNumbersOfAnyWidth)
+{
+    typedef EbmlVarUInt<WebmUtil::kEbmlTimeCodeID> Timecode;
+
+    EXPECT_EQ(10, Timecode::kMaxLength);
+
+    uint8 buf[Timecode::kMaxLength];
+
+    EXPECT_EQ(buf + 3, Timecode::Store(buf, 0x12, 1));
+    EXPECT_EQ(0xE7, buf[0]);
+    EXPECT_EQ(0x81, buf[1]);
+    EXPECT_EQ(0x12, buf[2]);
+
+    EXPECT_EQ(buf + 10, Timecode::Store(buf, 0x0102030405060708ULL, 8));
+    EXPECT_EQ(0x88, buf[1]);
+    EXPECT_EQ(0x01, buf[2]);
+    EXPECT_EQ(0x08, buf[9]);
+}
+
+TEST(EbmlWriterTest, WritesStringsAndVoids)
+{
+    uint8 buf[32];
+    EbmlWriter w(buf, sizeof(buf));
+
+    w.WriteString<WebmUtil::kEbmlDocTypeID>("webm", 4);
+    w.WriteVoid<3>();
+
+    const uint8 expected[] =
+    {
+        0x42, 0x82, 0x84, 'w', 'e', 'b', 'm',
+        0xEC, 0x83, 0x00, 0x00, 0x00
+    };
+
+    EXPECT_EQ(MakeBytes(expected, sizeof(expected)), GetBytes(w));
+    EXPECT_EQ(5, EbmlVoid<3>::kLength);
+}
+
+TEST(EbmlWriterTest, PatchesTheSizesOfMasters)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlVideoSettingsID, 2> Video;
+    typedef EbmlUInt<WebmUtil::kEbmlVideoWidth, 2> Width;
+    typedef EbmlUInt<WebmUtil::kEbmlVideoHeight, 2> Height;
+
+    EXPECT_EQ(3, Video::kHeaderLength);
+
+    uint8 buf[Video::kHeaderLength + Width::kLength + Height::kLength];
+    EbmlWriter w(buf, sizeof(buf));
+
+    uint8* const video = w.Begin<Video>();
+    EXPECT_EQ(buf, video);
+
+    // Until it's ended, the size is unknown.
+    EXPECT_EQ(0x7F, buf[1]);
+    EXPECT_EQ(0xFF, buf[2]);
+
+    w.Write<Width>(640);
+    w.Write<Height>(360);
+    w.End<Video>(video);
+
+    const uint8 expected[] =
+    {
+        0xE0, 0x40, 0x08,
+        0xB0, 0x82, 0x02, 0x80,
+        0xBA, 0x82, 0x01, 0x68
+    };
+
+    EXPECT_EQ(MakeBytes(expected, sizeof(expected)), GetBytes(w));
+}
+
+TEST(EbmlWriterTest, NestsMasters)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlTrackEntryID, 1> TrackEntry;
+    typedef EbmlMaster<WebmUtil::kEbmlAudioSettingsID, 1> Audio;
+    typedef EbmlUInt<WebmUtil::kEbmlChannelsID, 1> Channels;
+
+    uint8 buf[16];
+    EbmlWriter w(buf, sizeof(buf));
+
+    uint8* const entry = w.Begin<TrackEntry>();
+    uint8* const audio = w.Begin<Audio>();
+    w.Write<Channels>(2);
+    w.End<Audio>(audio);
+    w.End<TrackEntry>(entry);
+
+    const uint8 expected[] =
+    {
+        0xAE, 0x85,
+        0xE1, 0x83,
+        0x9F, 0x81, 0x02
+    };
+
+    EXPECT_EQ(MakeBytes(expected, sizeof(expected)), GetBytes(w));
+}
+
+TEST(EbmlWriterTest, LeavesAnUnendedMasterUnknown)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlClusterID, 1> Cluster;
+    typedef EbmlVarUInt<WebmUtil::kEbmlTimeCodeID> Timecode;
+
+    uint8 buf[Cluster::kHeaderLength + Timecode::kMaxLength];
+    EbmlWriter w(buf, sizeof(buf));
+
+    w.Begin<Cluster>();
+    w.WriteVarUInt<WebmUtil::kEbmlTimeCodeID>(0, 8);
+
+    ASSERT_EQ(15, w.GetLength());
+    EXPECT_EQ(0xFF, buf[4]);
+    EXPECT_EQ(0xE7, buf[5]);
+    EXPECT_EQ(0x88, buf[6]);
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "hybridlock.h"
+#include "lockprofiler.h"
+
+// The lock and the profiler are portable, so these also build on Linux:
+//
+//   g++ -std=c++11 -Icommon common/hybridlock.cc common/lockprofiler.cc
+//       common/tests/hybridlock_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::HybridLock;
+using WebmUtil::LockProfiler;
+
+TEST(HybridLockTest, RequiresInit)
+{
+    HybridLock lock;
+
+    EXPECT_EQ(HybridLock::kNotInitialized, lock.Acquire(0));
+    EXPECT_EQ(HybridLock::kNotInitialized, lock.Release());
+
+    ASSERT_TRUE(lock.Init());
+    EXPECT_TRUE(lock.IsInitialized());
+}
+
+TEST(HybridLockTest, IsRecursive)
+{
+    HybridLock lock;
+    ASSERT_TRUE(lock.Init());
+
+    HybridLock::WaitInfo info;
+
+    EXPECT_EQ(HybridLock::kOk, lock.Acquire(HybridLock::kInfinite, &info));
+    EXPECT_FALSE(info.contended);
+    EXPECT_EQ(HybridLock::kOk, lock.Acquire(0));
+    EXPECT_EQ(2, lock.GetRecursionCount());
+
+    EXPECT_EQ(HybridLock::kOk, lock.Release());
+    EXPECT_TRUE(lock.IsOwnedByCurrentThread());
+
+    EXPECT_EQ(HybridLock::kOk, lock.Release());
+    EXPECT_FALSE(lock.IsOwnedByCurrentThread());
+
+    EXPECT_EQ(HybridLock::kNotOwner, lock.Release());
+}
+
+TEST(HybridLockTest, TimesOutAndRejectsForeignRelease)
+{
+    HybridLock lock;
+    ASSERT_TRUE(lock.Init());
+    ASSERT_EQ(HybridLock::kOk, lock.Acquire(HybridLock::kInfinite));
+
+    HybridLock::Result acquire = HybridLock::kOk;
+    HybridLock::Result release = HybridLock::kOk;
+    HybridLock::WaitInfo info;
+
+    std::thread t([&]
+    {
+        acquire = lock.Acquire(20, &info);
+        release = lock.Release();
+    });
+
+    t.join();
+
+    EXPECT_EQ(HybridLock::kTimeout, acquire);
+    EXPECT_EQ(HybridLock::kNotOwner, release);
+    EXPECT_TRUE(info.contended);
+    EXPECT_GE(info.wait_ticks, HybridLock::GetTicksPerSecond() / 100);
+
+    EXPECT_EQ(HybridLock::kOk, lock.Release());
+}
+
+TEST(HybridLockTest, WakesParkedWaiter)
+{
+    HybridLock lock;
+    ASSERT_TRUE(lock.Init());
+    ASSERT_EQ(HybridLock::kOk, lock.Acquire(HybridLock::kInfinite));
+
+    std::atomic<bool> acquired(false);
+
+    std::thread t([&]
+    {
+        if (lock.Acquire(5000) == HybridLock::kOk)
+        {
+            acquired = true;
+            lock.Release();
+        }
+    });
+
+    // Long enough for the waiter to give up spinning and park.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired);
+
+    EXPECT_EQ(HybridLock::kOk, lock.Release());
+    t.join();
+
+    EXPECT_TRUE(acquired);
+}
+
+TEST(HybridLockTest, MutualExclusionUnderContention)
+{
+    HybridLock lock;
+    ASSERT_TRUE(lock.Init());
+
+    const int kThreads = 8;
+    const int kIterations = 20000;
+
+    long counter = 0;  // protected by the lock
+    std::atomic<int> inside(0);
+    std::atomic<int> violations(0);
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kThreads; ++i)
+    {
+        threads.push_back(std::thread([&]
+        {
+            for (int k = 0; k < kIterations; ++k)
+            {
+                ASSERT_EQ(HybridLock::kOk, lock.Acquire(HybridLock::kInfinite));
+
+                if (inside.fetch_add(1) != 0)
+                    ++violations;
+
+                ++counter;
+
+                inside.fetch_sub(1);
+                lock.Release();
+            }
+        }));
+    }
+
+    for (int i = 0; i < kThreads; ++i)
+        threads[i].join();
+
+    EXPECT_EQ(0, violations.load());
+    EXPECT_EQ(long(kThreads) * kIterations, counter);
+}
+
+TEST(LockProfilerTest, RecordsContention)
+{
+    LockProfiler::Reset();
+
+    static const char site_a = 0;
+    static const char site_b = 0;
+
+    HybridLock::WaitInfo uncontended = { false, 0 };
+    HybridLock::WaitInfo contended = { true, 100 };
+
+    LockProfiler::OnAcquire(&site_a, uncontended, true);
+    LockProfiler::OnRelease(&site_a, 10);
+    LockProfiler::OnAcquire(&site_a, contended, true);
+    LockProfiler::OnRelease(&site_a, 30);
+    LockProfiler::OnAcquire(&site_b, contended, false);
+
+    LockProfiler::Site sites[4];
+    ASSERT_EQ(2, LockProfiler::GetSites(sites, 4));
+
+    const LockProfiler::Site& a = (sites[0].address == &site_a) ? sites[0] : sites[1];
+    const LockProfiler::Site& b = (sites[0].address == &site_a) ? sites[1] : sites[0];
+
+    EXPECT_EQ(2, a.acquisitions);
+    EXPECT_EQ(1, a.contentions);
+    EXPECT_EQ(100, a.wait_ticks);
+    EXPECT_EQ(40, a.hold_ticks);
+    EXPECT_EQ(30, a.max_hold_ticks);
+
+    EXPECT_EQ(0, b.acquisitions);
+    EXPECT_EQ(1, b.timeouts);
+
+    LockProfiler::Reset();
+    EXPECT_EQ(0, LockProfiler::GetSites(0, 0));
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "lockfreestack.h"
+
+// The stack is portable, so this also builds on Linux:
+//
+//   g++ -std=c++11 -Icommon common/lockfreestack.cc
+//       common/tests/lockfreestack_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::LockFreeStack;
+
+TEST(LockFreeStackTest, IsLastInFirstOut)
+{
+    LockFreeStack stack;
+    ASSERT_TRUE(stack.Init(4));
+
+    EXPECT_TRUE(stack.IsEmpty());
+    EXPECT_EQ(-1, stack.Pop());
+
+    stack.Push(2);
+    stack.Push(0);
+    stack.Push(3);
+
+    EXPECT_FALSE(stack.IsEmpty());
+    EXPECT_EQ(3, stack.Pop());
+    EXPECT_EQ(0, stack.Pop());
+
+    stack.Push(1);
+
+    EXPECT_EQ(1, stack.Pop());
+    EXPECT_EQ(2, stack.Pop());
+    EXPECT_EQ(-1, stack.Pop());
+}
+
+TEST(LockFreeStackTest, InitEmptiesTheStack)
+{
+    LockFreeStack stack;
+    ASSERT_TRUE(stack.Init(2));
+
+    stack.Push(0);
+    stack.Push(1);
+
+    ASSERT_TRUE(stack.Init(8));
+    EXPECT_EQ(8, stack.GetCapacity());
+    EXPECT_TRUE(stack.IsEmpty());
+
+    ASSERT_TRUE(stack.Init(0));
+    EXPECT_EQ(-1, stack.Pop());
+}
+
+// Each thread repeatedly pops an index, checks that nobody else holds it,
+// and pushes it back.  A lost or duplicated index (what the ABA problem
+// would cause) shows up as a double owner, or as a missing index at the
+// end.
+TEST(LockFreeStackTest, NoIndexIsLostOrDuplicated)
+{
+    const int kIndexes = 8;
+    const int kThreads = 4;
+    const int kIterations = 100000;
+
+    LockFreeStack stack;
+    ASSERT_TRUE(stack.Init(kIndexes));
+
+    for (int i = 0; i < kIndexes; ++i)
+        stack.Push(i);
+
+    std::atomic<int> owners[kIndexes];
+
+    for (int i = 0; i < kIndexes; ++i)
+        owners[i] = 0;
+
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.push_back(std::thread([&]
+        {
+            for (int k = 0; k < kIterations; ++k)
+            {
+                const long index = stack.Pop();
+
+                if (index < 0)  // all taken by the other threads
+                    continue;
+
+                if (owners[index].fetch_add(1) != 0)
+                    ++errors;
+
+                owners[index].fetch_sub(1);
+                stack.Push(index);
+            }
+        }));
+    }
+
+    for (int t = 0; t < kThreads; ++t)
+        threads[t].join();
+
+    EXPECT_EQ(0, errors.load());
+
+    std::vector<bool> seen(kIndexes, false);
+
+    for (int i = 0; i < kIndexes; ++i)
+    {
+        const long index = stack.Pop();
+        ASSERT_GE(index, 0);
+        ASSERT_LT(index, kIndexes);
+        EXPECT_FALSE(seen[index]);
+
+        seen[index] = true;
+    }
+
+    EXPECT_TRUE(stack.IsEmpty());
+}
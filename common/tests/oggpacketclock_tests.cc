@@ -0,0 +1,146 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "gtest/gtest.h"
+#include "oggpacketclock.h"
+
+// These build on Linux as well:
+//
+//   g++ -std=c++11 -Icommon common/oggpacketclock.cc
+//       common/tests/oggpacketclock_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::OggPacketClock;
+
+namespace
+{
+
+// At this rate a sample is exactly 1000 units (0.1 ms).
+const unsigned long kRate = 10000;
+const long long kSample = 1000;
+
+}  // namespace
+
+TEST(OggPacketClockTest, SpreadsThePageEvenlyOverItsPackets)
+{
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    ASSERT_TRUE(clock.OnPage(3000, 3, times));
+    ASSERT_EQ(3u, times.size());
+
+    EXPECT_EQ(0, times[0].start);
+    EXPECT_EQ(1000 * kSample, times[0].stop);
+    EXPECT_EQ(1000 * kSample, times[1].start);
+    EXPECT_EQ(2000 * kSample, times[1].stop);
+    EXPECT_EQ(2000 * kSample, times[2].start);
+    EXPECT_EQ(3000 * kSample, times[2].stop);
+
+    EXPECT_EQ(3000, clock.GetGranulePos());
+}
+
+TEST(OggPacketClockTest, StartsTheFirstPageAtZero)
+{
+    // A first page whose granule position isn't a multiple of its packet
+    // count, as with a stream that starts part way into a block.
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    EXPECT_EQ(0, clock.GetGranulePos());
+
+    ASSERT_TRUE(clock.OnPage(10, 3, times));
+    ASSERT_EQ(3u, times.size());
+
+    EXPECT_EQ(0, times[0].start);
+    EXPECT_EQ(3 * kSample, times[0].stop);
+    EXPECT_EQ(6 * kSample, times[1].stop);
+    EXPECT_EQ(10 * kSample, times[2].stop);
+}
+
+TEST(OggPacketClockTest, StartsEachPageWhereThePreviousOneEnded)
+{
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    ASSERT_TRUE(clock.OnPage(2048, 4, times));
+
+    const long long first_end = times.back().stop;
+    EXPECT_EQ(2048 * kSample, first_end);
+
+    ASSERT_TRUE(clock.OnPage(2048 + 1000, 3, times));
+    ASSERT_EQ(3u, times.size());
+
+    EXPECT_EQ(first_end, times[0].start);
+
+    for (size_t i = 1; i < times.size(); ++i)
+    {
+        EXPECT_EQ(times[i - 1].stop, times[i].start);
+        EXPECT_LT(times[i].start, times[i].stop);
+    }
+
+    EXPECT_EQ(3048 * kSample, times.back().stop);
+    EXPECT_EQ(3048, clock.GetGranulePos());
+}
+
+TEST(OggPacketClockTest, LeavesTheStopUnknownAtEndOfStream)
+{
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    ASSERT_TRUE(clock.OnPage(3000, 3, times));
+
+    // The last page completed no packet, so there's no granule position.
+    ASSERT_TRUE(clock.OnPage(-1, 2, times));
+    ASSERT_EQ(2u, times.size());
+
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        EXPECT_EQ(3000 * kSample, times[i].start);
+        EXPECT_LT(times[i].stop, 0);
+    }
+
+    EXPECT_EQ(3000, clock.GetGranulePos());
+}
+
+TEST(OggPacketClockTest, StartsAtZeroWhenTheStreamEndsBeforeAnyPage)
+{
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    ASSERT_TRUE(clock.OnPage(-1, 1, times));
+    ASSERT_EQ(1u, times.size());
+
+    EXPECT_EQ(0, times[0].start);
+    EXPECT_LT(times[0].stop, 0);
+}
+
+TEST(OggPacketClockTest, RejectsAGranulePositionThatGoesBackwards)
+{
+    OggPacketClock clock(kRate);
+    OggPacketClock::times_t times;
+
+    ASSERT_TRUE(clock.OnPage(3000, 3, times));
+    EXPECT_FALSE(clock.OnPage(2000, 2, times));
+
+    EXPECT_EQ(3000, clock.GetGranulePos());
+
+    // The clock is where it was, so the next page still follows on.
+    ASSERT_TRUE(clock.OnPage(4000, 1, times));
+    EXPECT_EQ(3000 * kSample, times[0].start);
+}
+
+TEST(OggPacketClockTest, ConvertsLongDurationsWithoutOverflow)
+{
+    const unsigned long rate = 44100;
+    OggPacketClock clock(rate);
+
+    // A hundred years of samples.
+    const long long secs = 100LL * 365 * 24 * 3600;
+
+    EXPECT_EQ(secs * 10000000, clock.GetTime(secs * rate));
+    EXPECT_EQ(secs * 10000000 + 5000000, clock.GetTime(secs * rate + 22050));
+}
@@ -0,0 +1,237 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pipelineevents.h"
+#include "pipelinestats.h"
+
+// The counters are portable, so this also builds on Linux:
+//
+//   g++ -std=c++11 -Icommon common/pipelinestats.cc common/pipelineevents.cc
+//       common/tests/pipelinestats_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::PipelineEvents;
+using WebmUtil::PipelineStats;
+
+TEST(PipelineStatsTest, StartsEmpty)
+{
+    PipelineStats stats(L"input");
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(std::wstring(L"input"), s.name);
+    EXPECT_EQ(0, s.samples_in);
+    EXPECT_EQ(0, s.samples_out);
+    EXPECT_EQ(0, s.processed);
+    EXPECT_EQ(0, s.queue_max);
+    EXPECT_EQ(0, s.starved);
+}
+
+TEST(PipelineStatsTest, TruncatesLongNames)
+{
+    const std::wstring name(100, L'x');
+    PipelineStats stats(name.c_str());
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    const int len = static_cast<int>(std::wstring(s.name).size());
+    EXPECT_EQ(PipelineStats::kNameLength - 1, len);
+}
+
+TEST(PipelineStatsTest, CountsSamplesAndBytes)
+{
+    PipelineStats stats(L"output");
+
+    stats.OnInput(100);
+    stats.OnInput(50);
+    stats.OnOutput(30);
+    stats.OnOutput(-1);  // unknown size: counted, but adds no bytes
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(2, s.samples_in);
+    EXPECT_EQ(150, s.bytes_in);
+    EXPECT_EQ(2, s.samples_out);
+    EXPECT_EQ(30, s.bytes_out);
+}
+
+TEST(PipelineStatsTest, BucketsAreLogarithmic)
+{
+    EXPECT_EQ(0, PipelineStats::GetBucket(0));
+    EXPECT_EQ(1, PipelineStats::GetBucket(1));
+    EXPECT_EQ(2, PipelineStats::GetBucket(2));
+    EXPECT_EQ(2, PipelineStats::GetBucket(3));
+    EXPECT_EQ(3, PipelineStats::GetBucket(4));
+    EXPECT_EQ(10, PipelineStats::GetBucket(1000));
+
+    const int last = PipelineStats::kHistogramBuckets - 1;
+    EXPECT_EQ(last, PipelineStats::GetBucket(1LL << 40));
+}
+
+TEST(PipelineStatsTest, RecordsProcessingTimes)
+{
+    PipelineStats stats(L"input");
+
+    stats.OnProcess(3);
+    stats.OnProcess(1000);
+    stats.OnProcess(5);
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(3, s.processed);
+    EXPECT_EQ(1008, s.process_us);
+    EXPECT_EQ(1000, s.process_max_us);
+    EXPECT_EQ(1, s.histogram[2]);
+    EXPECT_EQ(1, s.histogram[3]);
+    EXPECT_EQ(1, s.histogram[10]);
+}
+
+TEST(PipelineStatsTest, TimerRecordsOneCall)
+{
+    PipelineStats stats(L"input");
+
+    {
+        PipelineStats::Timer timer(stats);
+    }
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(1, s.processed);
+    EXPECT_GE(s.process_us, 0);
+}
+
+TEST(PipelineStatsTest, TracksQueueDepthAndStarvation)
+{
+    PipelineStats stats(L"output");
+
+    stats.OnQueueDepth(3);
+    stats.OnQueueDepth(7);
+    stats.OnQueueDepth(2);
+    stats.OnStarved();
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(2, s.queue_depth);
+    EXPECT_EQ(7, s.queue_max);
+    EXPECT_EQ(1, s.starved);
+
+    stats.Reset();
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(0, s.queue_max);
+    EXPECT_EQ(0, s.starved);
+    EXPECT_EQ(std::wstring(L"output"), s.name);
+}
+
+TEST(PipelineStatsTest, OnlyLongWaitsCountAsStarved)
+{
+    PipelineStats stats(L"output");
+
+    stats.OnWait(0);
+    stats.OnWait(PipelineStats::kStarvedUs - 1);
+    stats.OnWait(PipelineStats::kStarvedUs);
+    stats.OnWait(50000);
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(2, s.starved);
+    EXPECT_EQ(0, s.processed);  // waits aren't processing time
+}
+
+TEST(PipelineStatsTest, ConcurrentUpdatesAreNotLost)
+{
+    PipelineStats stats(L"input");
+
+    enum { kThreads = 4, kCount = 10000 };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kThreads; ++i)
+    {
+        threads.push_back(std::thread([&stats, i]()
+        {
+            for (int j = 0; j < kCount; ++j)
+            {
+                stats.OnInput(1);
+                stats.OnProcess(j % 64);
+                stats.OnQueueDepth(i * kCount + j);
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    PipelineStats::Snapshot s;
+    stats.GetSnapshot(s);
+
+    EXPECT_EQ(kThreads * kCount, s.samples_in);
+    EXPECT_EQ(kThreads * kCount, s.bytes_in);
+    EXPECT_EQ(kThreads * kCount, s.processed);
+    EXPECT_EQ(63, s.process_max_us);
+    EXPECT_EQ(kThreads * kCount - 1, s.queue_max);
+}
+
+TEST(PipelineEventsTest, ReturnsEventsInOrder)
+{
+    PipelineEvents events;
+
+    const long long t = PipelineStats::GetMicroseconds();
+
+    events.Post(L"output", L"speed", L"faster: cpu_used 4 -> 5");
+    events.Post(L"output", L"speed", L"slower: cpu_used 5 -> 4");
+
+    PipelineEvents::Event e;
+
+    ASSERT_TRUE(events.Get(e));
+    EXPECT_EQ(std::wstring(L"output"), e.name);
+    EXPECT_EQ(std::wstring(L"speed"), e.type);
+    EXPECT_EQ(std::wstring(L"faster: cpu_used 4 -> 5"), e.text);
+    EXPECT_GE(e.time_us, t);
+
+    ASSERT_TRUE(events.Get(e));
+    EXPECT_EQ(std::wstring(L"slower: cpu_used 5 -> 4"), e.text);
+
+    EXPECT_FALSE(events.Get(e));
+}
+
+TEST(PipelineEventsTest, DropsTheOldestWhenFull)
+{
+    PipelineEvents events;
+
+    const std::wstring text(500, L'x');  // truncated
+
+    for (int i = 0; i < PipelineEvents::kMaxEvents + 3; ++i)
+        events.Post(L"output", std::to_wstring(i).c_str(), text.c_str());
+
+    EXPECT_EQ(3, events.GetDropped());
+
+    PipelineEvents::Event e;
+
+    ASSERT_TRUE(events.Get(e));
+    EXPECT_EQ(std::wstring(L"3"), e.type);
+    EXPECT_EQ(text.substr(0, PipelineEvents::kTextLength - 1), e.text);
+
+    int n = 1;
+
+    while (events.Get(e))
+        ++n;
+
+    EXPECT_EQ(static_cast<int>(PipelineEvents::kMaxEvents), n);
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "gtest/gtest.h"
+#include "presentationscheduler.h"
+
+// The scheduler is headless, so this also builds on Linux:
+//
+//   g++ -Icommon common/presentationscheduler.cc
+//       common/tests/presentationscheduler_tests.cc
+//       -lgtest -lgtest_main -lpthread
+
+using WebmUtil::PresentationScheduler;
+
+namespace
+{
+    void Queue(PresentationScheduler& scheduler, long long pts)
+    {
+        const int slot = scheduler.AcquireSlot();
+        ASSERT_GE(slot, 0);
+
+        scheduler.CommitSlot(slot, pts);
+    }
+
+    // Simulates a player at |fps| whose decoder needs |decode_ms| per
+    // frame, against a master clock that advances at real time; returns
+    // the statistics after |seconds|.
+    PresentationScheduler::Stats Simulate(int fps, int decode_ms, int seconds)
+    {
+        PresentationScheduler scheduler;
+
+        const long long duration = 1000 / fps;
+        const long long end = seconds * 1000LL;
+
+        long long decoder_free = 0;  // when the decoder can start again
+        long long pts = 0;
+
+        for (long long now = 0; now < end; ++now)
+        {
+            // The decoder runs whenever it's idle and there's room.
+            while ((decoder_free <= now) && !scheduler.IsFull())
+            {
+                const bool droppable = (pts / duration) % 3 != 0;
+                const PresentationScheduler::Decision d =
+                    scheduler.Admit(pts, now, droppable);
+
+                if (d != PresentationScheduler::kSkip)
+                    decoder_free = now + decode_ms;
+
+                if (d == PresentationScheduler::kDecodeAndQueue)
+                {
+                    const int slot = scheduler.AcquireSlot();
+                    scheduler.CommitSlot(slot, pts);
+                }
+
+                pts += duration;
+            }
+
+            int slot;
+            long long wait;
+
+            if (scheduler.GetNext(now, slot, wait) ==
+                PresentationScheduler::kActionShow)
+            {
+                scheduler.ReleaseSlot(slot);
+            }
+        }
+
+        return scheduler.GetStats();
+    }
+}
+
+TEST(PresentationSchedulerTest, WaitsForTheClock)
+{
+    PresentationScheduler scheduler;
+    int slot;
+    long long wait;
+
+    EXPECT_EQ(PresentationScheduler::kActionNone,
+              scheduler.GetNext(0, slot, wait));
+
+    Queue(scheduler, 100);
+    Queue(scheduler, 133);
+
+    EXPECT_EQ(PresentationScheduler::kActionWait,
+              scheduler.GetNext(50, slot, wait));
+    EXPECT_EQ(50, wait);
+
+    ASSERT_EQ(PresentationScheduler::kActionShow,
+              scheduler.GetNext(101, slot, wait));
+    EXPECT_EQ(1, scheduler.GetStats().last_drift);
+
+    scheduler.ReleaseSlot(slot);
+    EXPECT_EQ(1, scheduler.GetQueuedCount());
+}
+
+TEST(PresentationSchedulerTest, RingHoldsAFixedNumberOfFrames)
+{
+    PresentationScheduler scheduler;
+    ASSERT_TRUE(scheduler.Init(3));
+    EXPECT_FALSE(scheduler.Init(PresentationScheduler::kMaxSlots + 1));
+
+    Queue(scheduler, 0);
+    Queue(scheduler, 33);
+
+    const int slot = scheduler.AcquireSlot();
+    ASSERT_GE(slot, 0);
+    scheduler.CancelSlot(slot);  // e.g. the decode failed
+
+    Queue(scheduler, 66);
+
+    EXPECT_TRUE(scheduler.IsFull());
+    EXPECT_EQ(-1, scheduler.AcquireSlot());
+}
+
+TEST(PresentationSchedulerTest, DropsLateFramesWhenANewerOneIsDue)
+{
+    PresentationScheduler scheduler;
+
+    Queue(scheduler, 0);
+    Queue(scheduler, 33);
+    Queue(scheduler, 66);
+    Queue(scheduler, 100);
+
+    int slot;
+    long long wait;
+
+    // At 90ms the first two are too late, the third is due.
+    ASSERT_EQ(PresentationScheduler::kActionShow,
+              scheduler.GetNext(90, slot, wait));
+    EXPECT_EQ(24, scheduler.GetStats().last_drift);
+    EXPECT_EQ(2, scheduler.GetStats().dropped);
+
+    scheduler.ReleaseSlot(slot);
+
+    // The last one is late too, but it's all we have: show it.
+    ASSERT_EQ(PresentationScheduler::kActionShow,
+              scheduler.GetNext(200, slot, wait));
+    EXPECT_EQ(100, scheduler.GetStats().last_drift);
+    EXPECT_EQ(2, scheduler.GetStats().dropped);
+}
+
+TEST(PresentationSchedulerTest, SkipsDecodingOnlyWhatNothingNeeds)
+{
+    PresentationScheduler scheduler;
+    const long long late = PresentationScheduler::kLateSkip + 1;
+
+    EXPECT_EQ(PresentationScheduler::kDecodeAndQueue,
+              scheduler.Admit(1000, 1000 + 10, true));
+    EXPECT_EQ(PresentationScheduler::kSkip,
+              scheduler.Admit(1000, 1000 + late, true));
+    EXPECT_EQ(PresentationScheduler::kDecodeOnly,
+              scheduler.Admit(1000, 1000 + late, false));
+
+    EXPECT_EQ(3, scheduler.GetStats().admitted);
+    EXPECT_EQ(1, scheduler.GetStats().skipped);
+    EXPECT_EQ(1, scheduler.GetStats().discarded);
+}
+
+TEST(PresentationSchedulerTest, KeepsUpWhenTheDecoderDoes)
+{
+    const PresentationScheduler::Stats stats = Simulate(30, 10, 10);
+
+    EXPECT_EQ(0, stats.dropped);
+    EXPECT_EQ(0, stats.skipped);
+    EXPECT_GE(stats.shown, 299);
+    EXPECT_LE(stats.max_drift, PresentationScheduler::kEarly);
+}
+
+// A decoder that can only manage ~25 frames per second of a 30 fps
+// stream: instead of drifting further and further behind the clock, the
+// player sheds frames, and stays close to it.
+TEST(PresentationSchedulerTest, ShedsFramesInsteadOfDrifting)
+{
+    const PresentationScheduler::Stats stats = Simulate(30, 40, 20);
+
+    EXPECT_GT(stats.dropped + stats.skipped, 0);
+    EXPECT_LE(stats.max_drift, PresentationScheduler::kLateSkip + 40);
+    EXPECT_LE(stats.total_drift / stats.shown,
+              PresentationScheduler::kLateDrop + 40);
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "readscheduler.h"
+
+// The scheduler is portable, so this also builds on Linux:
+//
+//   g++ -std=c++11 -Icommon common/readscheduler.cc
+//       common/tests/readscheduler_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::ReadScheduler;
+
+namespace
+{
+
+const long kPageSize = 4096;
+
+class FakeCache : public ReadScheduler::Cache
+{
+public:
+    bool IsCached(long long key) const
+    {
+        return m_keys.count(key) != 0;
+    }
+
+    std::set<long long> m_keys;
+};
+
+// A byte stream with a round trip of |latency_ms| per read, plus up to
+// |jitter_ms| more, so that reads complete out of order.  The parser asks
+// for the file in |request| byte pieces, front to back, and waits for each
+// piece before it asks for the next one.  Returns how long (simulated) it
+// took to read the whole file.
+long long Simulate(int max_reads,
+                   int prefetch_pages,
+                   long long length,
+                   long request,
+                   int latency_ms,
+                   int jitter_ms)
+{
+    ReadScheduler s(kPageSize);
+    s.SetLimits(max_reads, prefetch_pages);
+
+    FakeCache cache;
+    std::multimap<long long, long long> reads;  // completion time -> key
+    unsigned int seed = 1;
+
+    long long now_ms = 0;
+
+    for (long long pos = 0; pos < length; pos += request)
+    {
+        for (;;)
+        {
+            std::vector<long long> keys;
+
+            const bool complete = s.Schedule(pos, request, length, cache, keys);
+
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                const long long key = keys[i];
+
+                EXPECT_LT(key, length);
+                EXPECT_FALSE(cache.IsCached(key));
+                EXPECT_FALSE(s.IsReading(key));
+
+                s.OnReadBegin(key);
+
+                seed = seed * 1103515245 + 12345;
+                const int jitter = jitter_ms ? (seed >> 16) % jitter_ms : 0;
+
+                reads.insert(std::make_pair(now_ms + latency_ms + jitter, key));
+            }
+
+            EXPECT_LE(s.GetReadCount(), max_reads);
+
+            if (complete)
+                break;
+
+            // Wait for the next read to complete.
+            EXPECT_FALSE(reads.empty());
+
+            if (reads.empty())
+                return -1;
+
+            now_ms = reads.begin()->first;
+
+            const long long key = reads.begin()->second;
+            reads.erase(reads.begin());
+
+            s.OnReadEnd(key);
+            cache.m_keys.insert(key);
+        }
+    }
+
+    return now_ms;
+}
+
+}  // namespace
+
+TEST(ReadSchedulerTest, DefaultsToOneReadAndNoPrefetch)
+{
+    ReadScheduler s(kPageSize);
+
+    EXPECT_EQ(1, s.GetMaxReads());
+    EXPECT_EQ(0, s.GetPrefetchPages());
+
+    FakeCache cache;
+    std::vector<long long> keys;
+
+    EXPECT_FALSE(s.Schedule(100, 3 * kPageSize, -1, cache, keys));
+    ASSERT_EQ(1u, keys.size());
+    EXPECT_EQ(0, keys[0]);
+
+    s.OnReadBegin(0);
+    keys.clear();
+
+    EXPECT_FALSE(s.Schedule(100, 3 * kPageSize, -1, cache, keys));
+    EXPECT_TRUE(keys.empty());  // the one read is in flight
+}
+
+TEST(ReadSchedulerTest, RequestBeforePrefetch)
+{
+    ReadScheduler s(kPageSize);
+    s.SetLimits(4, 8);
+
+    FakeCache cache;
+    cache.m_keys.insert(kPageSize);
+
+    std::vector<long long> keys;
+
+    // Pages 0 to 2 are requested, and page 1 is cached.
+    EXPECT_FALSE(s.Schedule(10, 3 * kPageSize - 20, -1, cache, keys));
+
+    ASSERT_EQ(4u, keys.size());
+    EXPECT_EQ(0, keys[0]);
+    EXPECT_EQ(2 * kPageSize, keys[1]);
+    EXPECT_EQ(3 * kPageSize, keys[2]);  // prefetch
+    EXPECT_EQ(4 * kPageSize, keys[3]);
+}
+
+TEST(ReadSchedulerTest, CompleteRequestOnlyPrefetches)
+{
+    ReadScheduler s(kPageSize);
+    s.SetLimits(8, 2);
+
+    FakeCache cache;
+    cache.m_keys.insert(0);
+
+    std::vector<long long> keys;
+
+    EXPECT_TRUE(s.Schedule(0, kPageSize, -1, cache, keys));
+
+    ASSERT_EQ(2u, keys.size());
+    EXPECT_EQ(kPageSize, keys[0]);
+    EXPECT_EQ(2 * kPageSize, keys[1]);
+
+    s.OnReadBegin(keys[0]);
+    s.OnReadBegin(keys[1]);
+    keys.clear();
+
+    // Nothing new to prefetch until the parser moves on.
+    EXPECT_TRUE(s.Schedule(0, kPageSize, -1, cache, keys));
+    EXPECT_TRUE(keys.empty());
+
+    s.OnReadEnd(kPageSize);
+    EXPECT_EQ(1, s.GetReadCount());
+    EXPECT_FALSE(s.IsReading(kPageSize));
+    EXPECT_TRUE(s.IsReading(2 * kPageSize));
+}
+
+TEST(ReadSchedulerTest, StopsAtEndOfFile)
+{
+    ReadScheduler s(kPageSize);
+    s.SetLimits(16, 16);
+
+    FakeCache cache;
+    std::vector<long long> keys;
+
+    const long long length = 2 * kPageSize + 1;
+
+    EXPECT_FALSE(s.Schedule(0, kPageSize, length, cache, keys));
+
+    ASSERT_EQ(3u, keys.size());
+    EXPECT_EQ(2 * kPageSize, keys[2]);
+}
+
+TEST(ReadSchedulerTest, SerialWithDefaults)
+{
+    // One round trip per page, as the reader used to do.
+    const long long length = 64 * kPageSize;
+
+    EXPECT_EQ(64 * 50, Simulate(1, 0, length, 4 * kPageSize, 50, 0));
+}
+
+TEST(ReadSchedulerTest, HidesLatency)
+{
+    const long long length = 1024 * kPageSize;  // 4MB
+    const long request = 4 * kPageSize;
+
+    const long long serial = Simulate(1, 0, length, request, 50, 20);
+    const long long parallel = Simulate(8, 32, length, request, 50, 20);
+
+    ASSERT_GT(serial, 0);
+    ASSERT_GT(parallel, 0);
+
+    // Eight reads in flight should be close to eight times as fast.
+    EXPECT_LT(parallel * 6, serial);
+}
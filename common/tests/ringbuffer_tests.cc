@@ -0,0 +1,148 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "ringbuffer.h"
+
+// The ring is portable, so this also builds on Linux:
+//
+//   g++ -std=c++11 -O2 -Icommon common/ringbuffer.cc
+//       common/tests/ringbuffer_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::RingBuffer;
+
+TEST(RingBufferTest, RoundsCapacityUpToAPowerOfTwo)
+{
+    RingBuffer ring;
+
+    EXPECT_EQ(0u, ring.GetCapacity());
+    EXPECT_EQ(0u, ring.Write("x", 1));
+
+    ASSERT_TRUE(ring.Init(1000));
+    EXPECT_EQ(1024u, ring.GetCapacity());
+    EXPECT_EQ(0u, ring.GetAvailable());
+    EXPECT_EQ(1024u, ring.GetSpace());
+}
+
+TEST(RingBufferTest, StopsWhenFullOrEmpty)
+{
+    RingBuffer ring;
+    ASSERT_TRUE(ring.Init(8));
+
+    const char in[] = "0123456789";
+    char out[16] = { 0 };
+
+    EXPECT_EQ(0u, ring.Read(out, sizeof out));
+    EXPECT_EQ(8u, ring.Write(in, 10));
+    EXPECT_EQ(0u, ring.GetSpace());
+    EXPECT_EQ(0u, ring.Write(in, 1));
+
+    EXPECT_EQ(3u, ring.Read(out, 3));
+    EXPECT_EQ(std::string("012"), std::string(out, 3));
+    EXPECT_EQ(5u, ring.GetAvailable());
+}
+
+TEST(RingBufferTest, CopiesAcrossTheWrap)
+{
+    RingBuffer ring;
+    ASSERT_TRUE(ring.Init(8));
+
+    char out[8];
+
+    EXPECT_EQ(6u, ring.Write("abcdef", 6));
+    EXPECT_EQ(6u, ring.Read(out, 6));
+
+    // This one starts two bytes before the end of the storage.
+    EXPECT_EQ(7u, ring.Write("ghijklm", 7));
+    EXPECT_EQ(1u, ring.GetSpace());
+
+    EXPECT_EQ(7u, ring.Read(out, sizeof out));
+    EXPECT_EQ(std::string("ghijklm"), std::string(out, 7));
+    EXPECT_EQ(0u, ring.GetAvailable());
+}
+
+// One thread writes a numbered stream in odd-sized pieces while another
+// reads it back in differently sized pieces; any lost, duplicated or
+// reordered byte breaks the sequence.  Also reports the throughput.
+TEST(RingBufferTest, PreservesTheStreamAcrossThreads)
+{
+    const size_t kTotal = 64 * 1024 * 1024;
+
+    RingBuffer ring;
+    ASSERT_TRUE(ring.Init(16 * 1024));
+
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    std::thread writer([&]
+    {
+        std::vector<unsigned char> buf(3001);
+        size_t pos = 0;
+
+        while (pos < kTotal)
+        {
+            size_t len = buf.size();
+
+            if (len > kTotal - pos)
+                len = kTotal - pos;
+
+            for (size_t i = 0; i < len; ++i)
+                buf[i] = static_cast<unsigned char>((pos + i) % 251);
+
+            size_t done = 0;
+
+            while (done < len)
+            {
+                const size_t n = ring.Write(&buf[done], len - done);
+
+                if (n == 0)
+                    std::this_thread::yield();
+
+                done += n;
+            }
+
+            pos += len;
+        }
+    });
+
+    std::vector<unsigned char> buf(4096 + 17);
+    size_t pos = 0;
+    size_t errors = 0;
+
+    while (pos < kTotal)
+    {
+        const size_t n = ring.Read(&buf[0], buf.size());
+
+        if (n == 0)
+            std::this_thread::yield();
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (buf[i] != static_cast<unsigned char>((pos + i) % 251))
+                ++errors;
+        }
+
+        pos += n;
+    }
+
+    writer.join();
+
+    const double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(0u, errors);
+    EXPECT_EQ(0u, ring.GetAvailable());
+
+    printf("%.1f MB/s through the ring\n", kTotal / seconds / (1 << 20));
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include "gtest/gtest.h"
+#include "simulcast.h"
+
+// These build on Linux as well:
+//
+//   g++ -std=c++11 -Icommon common/simulcast.cc common/tests/simulcast_tests.cc
+//       -lgtest -lgtest_main -lpthread
+
+using WebmUtil::GetSimulcastFrameSize;
+using WebmUtil::GetSimulcastTargetBitrate;
+using WebmUtil::SimulcastKeyframes;
+using WebmUtil::SimulcastWorkers;
+
+namespace
+{
+
+class RecordingJob : public SimulcastWorkers::Job
+{
+public:
+    RecordingJob() : m_runs(0), m_caller(std::this_thread::get_id()) {}
+
+    void Run(int index)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_indexes.insert(index);
+        ++m_runs;
+
+        if (std::this_thread::get_id() != m_caller)
+            m_threads.insert(std::this_thread::get_id());
+    }
+
+    std::mutex m_mutex;
+    std::set<int> m_indexes;
+    int m_runs;
+    const std::thread::id m_caller;
+    std::set<std::thread::id> m_threads;
+};
+
+// Each job waits until all of them are running, which can only happen if
+// they run at the same time.
+class RendezvousJob : public SimulcastWorkers::Job
+{
+public:
+    explicit RendezvousJob(int count) : m_count(count), m_arrived(0) {}
+
+    void Run(int)
+    {
+        ++m_arrived;
+
+        while (m_arrived < m_count)
+            std::this_thread::yield();
+    }
+
+    const int m_count;
+    std::atomic<int> m_arrived;
+};
+
+}  // namespace
+
+TEST(SimulcastTest, FrameSizeKeepsAspect)
+{
+    int w, h;
+
+    ASSERT_TRUE(GetSimulcastFrameSize(1920, 1080, 0, 720, w, h));
+    EXPECT_EQ(1280, w);
+    EXPECT_EQ(720, h);
+
+    ASSERT_TRUE(GetSimulcastFrameSize(1920, 1080, 0, 360, w, h));
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(360, h);
+
+    ASSERT_TRUE(GetSimulcastFrameSize(1920, 1080, 640, 0, w, h));
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(360, h);
+
+    // Given both, the rendition has its own aspect ratio.
+    ASSERT_TRUE(GetSimulcastFrameSize(1920, 1080, 640, 480, w, h));
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(480, h);
+
+    // Odd sizes are rounded down to even.
+    ASSERT_TRUE(GetSimulcastFrameSize(1366, 768, 0, 361, w, h));
+    EXPECT_EQ(642, w);
+    EXPECT_EQ(360, h);
+}
+
+TEST(SimulcastTest, FrameSizeIsNeverLargerThanSource)
+{
+    int w, h;
+
+    ASSERT_TRUE(GetSimulcastFrameSize(1280, 720, 0, 1080, w, h));
+    EXPECT_EQ(1280, w);
+    EXPECT_EQ(720, h);
+
+    // A 4:3 rendition of a 16:9 source is limited by the height...
+    ASSERT_TRUE(GetSimulcastFrameSize(1280, 720, 1440, 1080, w, h));
+    EXPECT_EQ(960, w);
+    EXPECT_EQ(720, h);
+
+    // ... and a wider one by the width.
+    ASSERT_TRUE(GetSimulcastFrameSize(640, 480, 1920, 1080, w, h));
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(360, h);
+}
+
+TEST(SimulcastTest, FrameSizeRejectsBadConfig)
+{
+    int w = -1, h = -1;
+
+    EXPECT_FALSE(GetSimulcastFrameSize(1920, 1080, 0, 0, w, h));
+    EXPECT_FALSE(GetSimulcastFrameSize(1920, 1080, -640, 360, w, h));
+    EXPECT_FALSE(GetSimulcastFrameSize(0, 1080, 640, 360, w, h));
+    EXPECT_EQ(-1, w);
+    EXPECT_EQ(-1, h);
+}
+
+TEST(SimulcastTest, BitrateFollowsArea)
+{
+    EXPECT_EQ(2000, GetSimulcastTargetBitrate(1920, 1080, 2000, 1920, 1080));
+
+    // A ninth of the area gets more than a ninth of the bits.
+    const int rate = GetSimulcastTargetBitrate(1920, 1080, 2000, 640, 360);
+    EXPECT_EQ(385, rate);
+    EXPECT_GT(rate, 2000 / 9);
+
+    EXPECT_EQ(1089, GetSimulcastTargetBitrate(1920, 1080, 2000, 1280, 720));
+
+    // Never 0, which libvpx would take as "use the default".
+    EXPECT_EQ(1, GetSimulcastTargetBitrate(1920, 1080, 1, 16, 16));
+}
+
+TEST(SimulcastTest, KeyframesAtFrameLimit)
+{
+    SimulcastKeyframes k;
+    k.Reset(4, 0);
+
+    const bool expected[] =
+    {
+        true, false, false, false,
+        true, false, false, false,
+        true
+    };
+
+    for (int i = 0; i < 9; ++i)
+        EXPECT_EQ(expected[i], k.IsKeyframe(i * 333, false)) << i;
+}
+
+TEST(SimulcastTest, KeyframesForcedRestartTheCount)
+{
+    SimulcastKeyframes k;
+    k.Reset(4, 0);
+
+    EXPECT_TRUE(k.IsKeyframe(0, false));
+    EXPECT_FALSE(k.IsKeyframe(1, false));
+    EXPECT_TRUE(k.IsKeyframe(2, true));   // e.g. a discontinuity
+    EXPECT_FALSE(k.IsKeyframe(3, false));
+    EXPECT_FALSE(k.IsKeyframe(4, false));
+    EXPECT_FALSE(k.IsKeyframe(5, false));
+    EXPECT_TRUE(k.IsKeyframe(6, false));  // four frames after the last
+}
+
+TEST(SimulcastTest, KeyframesAtTimeLimit)
+{
+    SimulcastKeyframes k;
+    k.Reset(0, 1000);
+
+    EXPECT_TRUE(k.IsKeyframe(0, false));
+    EXPECT_FALSE(k.IsKeyframe(400, false));
+    EXPECT_FALSE(k.IsKeyframe(999, false));
+    EXPECT_TRUE(k.IsKeyframe(1200, false));  // a frame was dropped upstream
+    EXPECT_FALSE(k.IsKeyframe(2100, false));
+    EXPECT_TRUE(k.IsKeyframe(2200, false));
+}
+
+TEST(SimulcastTest, KeyframesWithNoLimit)
+{
+    SimulcastKeyframes k;
+    k.Reset(0, 0);
+
+    EXPECT_TRUE(k.IsKeyframe(0, false));
+
+    for (int i = 1; i < 1000; ++i)
+        ASSERT_FALSE(k.IsKeyframe(i, false));
+
+    k.Reset(0, 0);
+    EXPECT_TRUE(k.IsKeyframe(5000, false));
+}
+
+TEST(SimulcastTest, WorkersRunEachJobOnce)
+{
+    SimulcastWorkers workers;
+    workers.Start(3, true);
+    ASSERT_TRUE(workers.IsThreaded());
+
+    for (int n = 0; n < 100; ++n)
+    {
+        RecordingJob job;
+
+        workers.Begin(&job, 3);
+        workers.Wait();
+
+        ASSERT_EQ(3, job.m_runs);
+        ASSERT_EQ(3u, job.m_indexes.size());
+        ASSERT_EQ(3u, job.m_threads.size());
+    }
+
+    // Fewer jobs than workers.
+    RecordingJob job;
+
+    workers.Begin(&job, 1);
+    workers.Wait();
+
+    EXPECT_EQ(1, job.m_runs);
+    EXPECT_EQ(1u, job.m_indexes.count(0));
+
+    workers.Stop();
+}
+
+TEST(SimulcastTest, WorkersRunConcurrently)
+{
+    SimulcastWorkers workers;
+    workers.Start(3, true);
+
+    RendezvousJob job(4);
+
+    workers.Begin(&job, 3);
+    job.Run(3);  // the caller's own share
+    workers.Wait();
+
+    EXPECT_EQ(4, job.m_arrived);
+}
+
+TEST(SimulcastTest, WorkersWithoutThreads)
+{
+    SimulcastWorkers workers;
+    workers.Start(2, false);
+    EXPECT_FALSE(workers.IsThreaded());
+    EXPECT_EQ(2, workers.GetCount());
+
+    RecordingJob job;
+
+    workers.Begin(&job, 2);
+    EXPECT_EQ(2, job.m_runs);  // before Begin returned
+    workers.Wait();
+
+    EXPECT_TRUE(job.m_threads.empty());
+}
@@ -0,0 +1,229 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "speedgovernor.h"
+
+// These build on Linux as well:
+//
+//   g++ -std=c++11 -Icommon common/speedgovernor.cc
+//       common/tests/speedgovernor_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::SpeedGovernor;
+
+namespace
+{
+
+const long long kInterval = 33333;  // 30 fps
+const unsigned long kGood = 1000000;
+const unsigned long kRealtime = 1;
+
+SpeedGovernor::Settings GetSettings(int cpu_min, int cpu_max, int max_scale)
+{
+    SpeedGovernor::Settings s;
+
+    s.cpu_used_min = cpu_min;
+    s.cpu_used_max = cpu_max;
+    s.deadline = kGood;
+    s.fast_deadline = kRealtime;
+    s.max_scale = max_scale;
+
+    return s;
+}
+
+// Feeds |count| frames that took |load| of the frame time, and returns the
+// changes there were.
+std::string Feed(SpeedGovernor& g,
+                 int count,
+                 double load,
+                 long long lateness_us = -1)
+{
+    std::string changes;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const long long us = static_cast<long long>(kInterval * load);
+
+        switch (g.OnFrame(us, kInterval, lateness_us))
+        {
+            case SpeedGovernor::kFaster:
+                changes += '+';
+                break;
+
+            case SpeedGovernor::kSlower:
+                changes += '-';
+                break;
+
+            case SpeedGovernor::kLimit:
+                changes += '!';
+                break;
+
+            case SpeedGovernor::kNone:
+            default:
+                break;
+        }
+    }
+
+    return changes;
+}
+
+}  // namespace
+
+TEST(SpeedGovernorTest, StartsFromTheConfiguredSpeed)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(4, 16, 0), 6);
+
+    EXPECT_EQ(6, g.GetState().cpu_used);
+    EXPECT_EQ(kGood, g.GetState().deadline);
+    EXPECT_EQ(0, g.GetState().scale);
+
+    // Clamped to the range.
+    g.Reset(GetSettings(4, 16, 0), -17);
+    EXPECT_EQ(4, g.GetState().cpu_used);
+}
+
+TEST(SpeedGovernorTest, HoldsSteadyBetweenTheThresholds)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(0, 16, 3), 4);
+
+    EXPECT_EQ("", Feed(g, 1000, 0.75));
+    EXPECT_EQ(4, g.GetState().cpu_used);
+}
+
+TEST(SpeedGovernorTest, SpeedsUpOneStepPerWindow)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(4, 6, 2), 4);
+
+    const int w = SpeedGovernor::kWindowFrames;
+
+    // Never more than one change per window.
+    EXPECT_EQ("+", Feed(g, w, 1.5));
+    EXPECT_EQ(5, g.GetState().cpu_used);
+
+    EXPECT_EQ("+", Feed(g, w, 1.5));
+    EXPECT_EQ(6, g.GetState().cpu_used);
+
+    // cpu_used is at its maximum: next, the deadline...
+    EXPECT_EQ("+", Feed(g, w, 1.5));
+    EXPECT_EQ(kRealtime, g.GetState().deadline);
+
+    // ... then the scaling, up to its maximum.
+    EXPECT_EQ("++", Feed(g, 2 * w, 1.5));
+    EXPECT_EQ(2, g.GetState().scale);
+
+    // The limit is reported once.
+    EXPECT_EQ("!", Feed(g, 10 * w, 1.5));
+}
+
+TEST(SpeedGovernorTest, SlowsDownInReverseOnceComfortable)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(4, 5, 1), 4);
+
+    const int w = SpeedGovernor::kWindowFrames;
+
+    EXPECT_EQ("+++", Feed(g, 3 * w, 2.0));
+
+    const SpeedGovernor::State& s = g.GetState();
+    EXPECT_EQ(5, s.cpu_used);
+    EXPECT_EQ(kRealtime, s.deadline);
+    EXPECT_EQ(1, s.scale);
+
+    // Nothing until the encoder has been comfortable for a while (the
+    // smoothed load takes a few windows to come down, too).
+    EXPECT_EQ("", Feed(g, SpeedGovernor::kRecoverWindows * w, 0.3));
+
+    EXPECT_EQ("-", Feed(g, SpeedGovernor::kRecoverWindows * w, 0.3));
+    EXPECT_EQ(0, s.scale);
+
+    EXPECT_EQ("-", Feed(g, SpeedGovernor::kRecoverWindows * w, 0.3));
+    EXPECT_EQ(kGood, s.deadline);
+
+    EXPECT_EQ("-", Feed(g, SpeedGovernor::kRecoverWindows * w, 0.3));
+    EXPECT_EQ(4, s.cpu_used);
+
+    // Never slower than the minimum.
+    EXPECT_EQ("", Feed(g, 10 * SpeedGovernor::kRecoverWindows * w, 0.3));
+    EXPECT_EQ(4, s.cpu_used);
+}
+
+TEST(SpeedGovernorTest, BacksOffWhenSlowingDownDoesNotLast)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(4, 16, 0), 8);
+
+    const int w = SpeedGovernor::kWindowFrames;
+    const int r = SpeedGovernor::kRecoverWindows;
+
+    // Comfortable for long enough to slow down once...
+    EXPECT_EQ("-", Feed(g, (r + 1) * w, 0.5));
+    EXPECT_EQ(7, g.GetState().cpu_used);
+
+    // ... but that was too slow.
+    EXPECT_EQ("+", Feed(g, w, 1.2));
+    EXPECT_EQ(8, g.GetState().cpu_used);
+
+    // It now takes twice as long to try again (after the smoothed load
+    // has come back down).
+    EXPECT_EQ("", Feed(g, (2 * r - 1) * w, 0.5));
+    EXPECT_EQ("-", Feed(g, 4 * w, 0.5));
+}
+
+TEST(SpeedGovernorTest, SpeedsUpWhenFramesPileUpUpstream)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(0, 16, 0), 4);
+
+    const int w = SpeedGovernor::kWindowFrames;
+
+    // The capture itself takes 50 ms; that isn't a backlog.
+    EXPECT_EQ("", Feed(g, 4 * w, 0.8, 50000));
+    EXPECT_EQ(0, g.GetBacklog());
+
+    // Frames start to queue up (the load looks fine, but upstream is
+    // blocked on us).
+    EXPECT_EQ("+", Feed(g, w, 0.8, 50000 + 3 * kInterval));
+    EXPECT_EQ(5, g.GetState().cpu_used);
+    EXPECT_DOUBLE_EQ(3, g.GetBacklog());
+
+    // Once the backlog drains, there's no need to go faster still.
+    EXPECT_EQ("", Feed(g, w, 0.8, 50000 + 2 * kInterval));
+    EXPECT_EQ(5, g.GetState().cpu_used);
+}
+
+TEST(SpeedGovernorTest, LeavesTheDeadlineAloneIfAsked)
+{
+    SpeedGovernor::Settings s = GetSettings(4, 4, 0);
+    s.fast_deadline = -1;
+
+    SpeedGovernor g;
+    g.Reset(s, 4);
+
+    EXPECT_EQ("!", Feed(g, 10 * SpeedGovernor::kWindowFrames, 2.0));
+    EXPECT_EQ(kGood, g.GetState().deadline);
+}
+
+TEST(SpeedGovernorTest, DescribesTheChange)
+{
+    SpeedGovernor g;
+    g.Reset(GetSettings(4, 16, 0), 4);
+
+    const SpeedGovernor::State before = g.GetState();
+
+    ASSERT_EQ("+", Feed(g, SpeedGovernor::kWindowFrames, 1.5));
+
+    const std::wstring text = g.Describe(SpeedGovernor::kFaster, before);
+
+    EXPECT_EQ(0u, text.find(L"faster: cpu_used 4 -> 5; load 150%"))
+        << std::string(text.begin(), text.end());
+}
@@ -0,0 +1,204 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include "gtest/gtest.h"
+#include "videopreview.h"
+
+// These build on Linux as well:
+//
+//   g++ -std=c++11 -Icommon common/videopreview.cc
+//       common/tests/videopreview_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::GetPreviewFrameSize;
+using WebmUtil::PreviewPacer;
+using WebmUtil::PreviewWorker;
+
+namespace
+{
+
+const long long kSecond = 10000000;  // 100 ns units, as in DirectShow
+
+// Counts the frames due out of |count| frames at |fps|.
+int CountDue(PreviewPacer& p, int count, double fps, long long jitter = 0)
+{
+    int n = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        long long t = static_cast<long long>(i * kSecond / fps);
+
+        if (i % 2)
+            t -= jitter;
+
+        if (p.IsDue(t))
+            ++n;
+    }
+
+    return n;
+}
+
+// Blocks in Run until released.
+class Gate
+{
+public:
+    Gate() : m_open(false), m_runs(0), m_deleted(0) {}
+
+    void Open()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_cond.notify_all();
+    }
+
+    void WaitOpen()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_open)
+            m_cond.wait(lock);
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_open;
+    std::atomic<int> m_runs;
+    std::atomic<int> m_deleted;
+};
+
+class GateJob : public PreviewWorker::Job
+{
+public:
+    explicit GateJob(Gate& g) : m_gate(g) {}
+    ~GateJob() { ++m_gate.m_deleted; }
+
+    void Run()
+    {
+        ++m_gate.m_runs;
+        m_gate.WaitOpen();
+    }
+
+private:
+    Gate& m_gate;
+};
+
+}  // namespace
+
+TEST(VideoPreviewTest, FitsWithinTheMaximumSize)
+{
+    int w, h;
+
+    GetPreviewFrameSize(3840, 2160, 1280, 720, w, h);
+    EXPECT_EQ(1280, w);
+    EXPECT_EQ(720, h);
+
+    // Portrait: the height is the limit.
+    GetPreviewFrameSize(1080, 1920, 1280, 720, w, h);
+    EXPECT_EQ(404, w);  // 405, rounded down to even
+    EXPECT_EQ(720, h);
+
+    // Only one limit.
+    GetPreviewFrameSize(1920, 1080, 0, 540, w, h);
+    EXPECT_EQ(960, w);
+    EXPECT_EQ(540, h);
+
+    // Never larger than the source, nor odd.
+    GetPreviewFrameSize(641, 361, 1280, 720, w, h);
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(360, h);
+
+    GetPreviewFrameSize(640, 360, 0, 0, w, h);
+    EXPECT_EQ(640, w);
+    EXPECT_EQ(360, h);
+}
+
+TEST(VideoPreviewTest, ShowsEveryFrameWithoutALimit)
+{
+    PreviewPacer p;
+    EXPECT_EQ(100, CountDue(p, 100, 30));
+}
+
+TEST(VideoPreviewTest, ThinsOutTheFrames)
+{
+    PreviewPacer p;
+
+    p.Reset(kSecond / 15);
+    EXPECT_EQ(150, CountDue(p, 300, 30));
+
+    // Not a divisor of the input rate.
+    p.Reset(kSecond / 20);
+    EXPECT_EQ(200, CountDue(p, 300, 30));
+
+    // Slower input than the limit.
+    p.Reset(kSecond / 30);
+    EXPECT_EQ(150, CountDue(p, 150, 15));
+}
+
+TEST(VideoPreviewTest, ToleratesJitter)
+{
+    PreviewPacer p;
+
+    // Every other frame is 1 ms early.
+    p.Reset(kSecond / 30);
+    EXPECT_EQ(300, CountDue(p, 300, 30, 10000));
+
+    p.Reset(kSecond / 15);
+    EXPECT_EQ(150, CountDue(p, 300, 30, 10000));
+}
+
+TEST(VideoPreviewTest, StartsOverWhenTimeGoesBack)
+{
+    PreviewPacer p;
+    p.Reset(kSecond / 10);
+
+    EXPECT_TRUE(p.IsDue(100 * kSecond));
+    EXPECT_FALSE(p.IsDue(100 * kSecond + kSecond / 30));
+
+    // A new segment.
+    EXPECT_TRUE(p.IsDue(0));
+    EXPECT_FALSE(p.IsDue(kSecond / 30));
+}
+
+TEST(VideoPreviewTest, DropsJobsWhileBusy)
+{
+    Gate g;
+    PreviewWorker w;
+
+    // Not started.
+    EXPECT_FALSE(w.Post(new GateJob(g)));
+    EXPECT_EQ(1, g.m_deleted);
+
+    ASSERT_TRUE(w.Start());
+
+    EXPECT_TRUE(w.Post(new GateJob(g)));
+    EXPECT_TRUE(w.IsBusy());
+
+    // The caller never waits.
+    for (int i = 0; i < 10; ++i)
+        EXPECT_FALSE(w.Post(new GateJob(g)));
+
+    EXPECT_EQ(10, w.GetDropped());
+    EXPECT_EQ(11, g.m_deleted);
+
+    g.Open();
+
+    while (w.IsBusy())
+        std::this_thread::yield();
+
+    EXPECT_EQ(1, g.m_runs);
+    EXPECT_EQ(12, g.m_deleted);
+
+    EXPECT_TRUE(w.Post(new GateJob(g)));
+
+    w.Stop();
+
+    EXPECT_EQ(13, g.m_deleted);
+    EXPECT_FALSE(w.IsBusy());
+}
@@ -0,0 +1,430 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vorbis/codec.h"
+#include "vorbisencodepipeline.h"
+
+// The pipeline is portable, and the tests bring their own stand-in for
+// the four libvorbis calls it makes, so this also builds on Linux:
+//
+//   g++ -std=c++11 -Icommon -Ithird_party/libvorbis -Ithird_party/libogg
+//       -Icommon/portable
+//       common/vorbisencodepipeline.cc common/pipelinestats.cc
+//       common/tests/vorbisencodepipeline_tests.cc
+//       -lgtest -lgtest_main -lpthread
+
+using WebmUtil::VorbisEncodePipeline;
+
+namespace
+{
+
+// The stand-in encoder.  Like libvorbis, it picks each block's size from
+// the signal, and carries a peak from the analysis of one block into the
+// blockout of the next, so its packets depend on the calls being made in
+// order.  It also checks that no two calls overlap.
+
+struct FakeEncoder
+{
+    int channels;
+    std::vector<std::vector<float> > pcm;  // not yet blocked out
+    std::vector<float*> buffer;
+    std::vector<std::vector<float> > storage;
+    bool eof;
+    bool done;
+    long long granulepos;
+    long long sequence;
+    float peak;
+
+    std::atomic<int> callers;
+    std::atomic<int> overlaps;
+    std::atomic<bool> fail;
+    std::atomic<int> delay_us;
+};
+
+struct FakeBlock
+{
+    std::vector<std::vector<float> > pcm;
+    float peak;
+    std::vector<unsigned char> packet;
+};
+
+FakeEncoder& GetEncoder(vorbis_dsp_state* v)
+{
+    return *static_cast<FakeEncoder*>(v->backend_state);
+}
+
+class Call
+{
+    FakeEncoder& m_enc;
+
+public:
+
+    explicit Call(FakeEncoder& enc) : m_enc(enc)
+    {
+        if (m_enc.callers++ != 0)
+            ++m_enc.overlaps;
+    }
+
+    ~Call()
+    {
+        --m_enc.callers;
+    }
+};
+
+enum { kLong = 2048, kShort = 256, kLookahead = 512 };
+
+// A block is short if it starts on a transient.
+long GetBlockSize(const FakeEncoder& enc)
+{
+    return (std::fabs(enc.pcm[0][0]) > 0.95f) ? kShort : kLong;
+}
+
+}  // namespace
+
+float** vorbis_analysis_buffer(vorbis_dsp_state* v, int vals)
+{
+    FakeEncoder& enc = GetEncoder(v);
+    const Call call(enc);
+
+    enc.storage.assign(enc.channels, std::vector<float>(vals));
+    enc.buffer.resize(enc.channels);
+
+    for (int i = 0; i < enc.channels; ++i)
+        enc.buffer[i] = &enc.storage[i][0];
+
+    return &enc.buffer[0];
+}
+
+int vorbis_analysis_wrote(vorbis_dsp_state* v, int vals)
+{
+    FakeEncoder& enc = GetEncoder(v);
+    const Call call(enc);
+
+    if (vals == 0)
+    {
+        enc.eof = true;
+        return 0;
+    }
+
+    for (int i = 0; i < enc.channels; ++i)
+        enc.pcm[i].insert(enc.pcm[i].end(),
+                          enc.storage[i].begin(),
+                          enc.storage[i].begin() + vals);
+
+    return 0;
+}
+
+int vorbis_analysis_blockout(vorbis_dsp_state* v, vorbis_block* vb)
+{
+    FakeEncoder& enc = GetEncoder(v);
+    const Call call(enc);
+
+    if (enc.fail)
+        return -1;
+
+    if (enc.done)
+        return 0;
+
+    const long avail = static_cast<long>(enc.pcm[0].size());
+
+    if (avail == 0 && !enc.eof)
+        return 0;
+
+    long size = (avail > 0) ? GetBlockSize(enc) : 0;
+
+    if (!enc.eof && (avail < size + kLookahead))
+        return 0;
+
+    if (size > avail)
+        size = avail;
+
+    FakeBlock& b = *static_cast<FakeBlock*>(vb->internal);
+
+    b.pcm.resize(enc.channels);
+
+    for (int i = 0; i < enc.channels; ++i)
+    {
+        b.pcm[i].assign(enc.pcm[i].begin(), enc.pcm[i].begin() + size);
+        enc.pcm[i].erase(enc.pcm[i].begin(), enc.pcm[i].begin() + size);
+    }
+
+    // As vorbis_analysis_blockout does with the ampmax.
+    if (b.peak > enc.peak)
+        enc.peak = b.peak;
+
+    enc.peak *= 0.9f;
+    b.peak = enc.peak;
+
+    enc.granulepos += size;
+    vb->granulepos = enc.granulepos;
+    vb->sequence = enc.sequence++;
+    vb->eofflag = enc.eof && enc.pcm[0].empty();
+
+    if (vb->eofflag)
+        enc.done = true;
+
+    return 1;
+}
+
+int vorbis_analysis(vorbis_block* vb, ogg_packet* op)
+{
+    FakeEncoder& enc = GetEncoder(vb->vd);
+    const Call call(enc);
+
+    if (enc.delay_us)
+        std::this_thread::sleep_for(std::chrono::microseconds(enc.delay_us));
+
+    FakeBlock& b = *static_cast<FakeBlock*>(vb->internal);
+
+    unsigned int hash = 2166136261u;
+
+    for (size_t i = 0; i < b.pcm.size(); ++i)
+        for (size_t j = 0; j < b.pcm[i].size(); ++j)
+        {
+            float x = b.pcm[i][j];
+
+            if (std::fabs(x) > b.peak)
+                b.peak = std::fabs(x);
+
+            x -= b.peak * 0.5f;  // the peak shapes the output
+
+            unsigned int bits;
+            memcpy(&bits, &x, sizeof bits);
+
+            hash = (hash ^ bits) * 16777619u;
+        }
+
+    b.packet.assign(8 + hash % 64, static_cast<unsigned char>(hash >> 8));
+    memcpy(&b.packet[0], &hash, sizeof hash);
+    memcpy(&b.packet[4], &b.peak, sizeof b.peak);
+
+    op->packet = &b.packet[0];
+    op->bytes = static_cast<long>(b.packet.size());
+    op->b_o_s = 0;
+    op->e_o_s = vb->eofflag;
+    op->granulepos = vb->granulepos;
+    op->packetno = vb->sequence;
+
+    return 0;
+}
+
+namespace
+{
+
+// The objects that vorbis_analysis_init and vorbis_block_init would set
+// up, for the stand-in.
+class Encoder
+{
+public:
+
+    explicit Encoder(int channels)
+    {
+        memset(&m_dsp, 0, sizeof m_dsp);
+        memset(&m_block, 0, sizeof m_block);
+
+        m_enc.channels = channels;
+        m_enc.pcm.resize(channels);
+        m_enc.eof = false;
+        m_enc.done = false;
+        m_enc.granulepos = 0;
+        m_enc.sequence = 3;  // after the headers
+        m_enc.peak = 0;
+        m_enc.callers = 0;
+        m_enc.overlaps = 0;
+        m_enc.fail = false;
+        m_enc.delay_us = 0;
+
+        m_fake_block.peak = 0;
+
+        m_dsp.backend_state = &m_enc;
+        m_block.vd = &m_dsp;
+        m_block.internal = &m_fake_block;
+    }
+
+    vorbis_dsp_state m_dsp;
+    vorbis_block m_block;
+    FakeEncoder m_enc;
+    FakeBlock m_fake_block;
+};
+
+// Multichannel content with transients, so that the block sizes vary.
+std::vector<float> MakeContent(int channels, long frames)
+{
+    std::vector<float> pcm(static_cast<size_t>(frames) * channels);
+    unsigned int seed = 1;
+
+    for (long i = 0; i < frames; ++i)
+        for (int c = 0; c < channels; ++c)
+        {
+            seed = seed * 1103515245 + 12345;
+            const float noise = float((seed >> 16) & 0x7FFF) / 32768 - 0.5f;
+
+            float x = 0.3f * std::sin(0.01f * (c + 1) * i) + 0.1f * noise;
+
+            if (i % 9000 == 0)
+                x = 0.99f;
+
+            pcm[i * channels + c] = x;
+        }
+
+    return pcm;
+}
+
+// Encodes |pcm| in chunks of varying size, as a capture source would
+// deliver it, and returns the packets.
+VorbisEncodePipeline::packets_t Encode(const std::vector<float>& pcm,
+                                       int channels,
+                                       bool threaded,
+                                       long max_pending)
+{
+    Encoder e(channels);
+    VorbisEncodePipeline p;
+
+    EXPECT_TRUE(p.Start(&e.m_dsp, &e.m_block, channels, threaded, max_pending,
+                        0));
+
+    EXPECT_EQ(threaded, p.IsThreaded());
+
+    const long frames = static_cast<long>(pcm.size() / channels);
+    VorbisEncodePipeline::packets_t packets;
+
+    long pos = 0;
+    unsigned int seed = 7;
+
+    while (pos < frames)
+    {
+        seed = seed * 1103515245 + 12345;
+        long n = 64 + (seed >> 16) % 4000;
+
+        if (n > frames - pos)
+            n = frames - pos;
+
+        EXPECT_TRUE(p.Write(&pcm[pos * channels], n));
+        EXPECT_LE(p.GetPendingFrames(), std::max(max_pending, n));
+
+        pos += n;
+
+        EXPECT_TRUE(p.Read(packets, false));
+    }
+
+    EXPECT_TRUE(p.WriteEnd());
+    EXPECT_TRUE(p.Read(packets, true));
+
+    p.Stop();
+
+    EXPECT_EQ(0, e.m_enc.overlaps);
+
+    return packets;
+}
+
+}  // namespace
+
+TEST(VorbisEncodePipelineTest, ThreadedMatchesSerial)
+{
+    const int channels = 8;
+    const std::vector<float> pcm = MakeContent(channels, 5 * 48000);
+
+    const VorbisEncodePipeline::packets_t serial =
+        Encode(pcm, channels, false, 48000);
+
+    const VorbisEncodePipeline::packets_t threaded =
+        Encode(pcm, channels, true, 48000);
+
+    ASSERT_FALSE(serial.empty());
+    ASSERT_EQ(serial.size(), threaded.size());
+
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+        EXPECT_EQ(serial[i].data, threaded[i].data) << "packet " << i;
+        EXPECT_EQ(serial[i].granulepos, threaded[i].granulepos);
+        EXPECT_EQ(serial[i].packetno, threaded[i].packetno);
+        EXPECT_EQ(serial[i].eos, threaded[i].eos);
+    }
+
+    EXPECT_TRUE(serial.back().eos);
+    EXPECT_EQ(5 * 48000, serial.back().granulepos);
+}
+
+TEST(VorbisEncodePipelineTest, WriteWaitsForRoom)
+{
+    const int channels = 6;
+    const std::vector<float> pcm = MakeContent(channels, 48000);
+
+    Encoder e(channels);
+    e.m_enc.delay_us = 200;
+
+    VorbisEncodePipeline p;
+    ASSERT_TRUE(p.Start(&e.m_dsp, &e.m_block, channels, true, 4096, 0));
+
+    for (long pos = 0; pos < 48000; pos += 1000)
+    {
+        ASSERT_TRUE(p.Write(&pcm[pos * channels], 1000));
+        EXPECT_LE(p.GetPendingFrames(), 4096);
+    }
+
+    p.Stop();
+
+    EXPECT_EQ(0, p.GetPendingFrames());
+    EXPECT_FALSE(p.Write(&pcm[0], 1000));  // stopped
+}
+
+TEST(VorbisEncodePipelineTest, StopDiscardsInputAndPackets)
+{
+    const int channels = 2;
+    const std::vector<float> pcm = MakeContent(channels, 48000);
+
+    Encoder e(channels);
+    e.m_enc.delay_us = 1000;
+
+    VorbisEncodePipeline p;
+    ASSERT_TRUE(p.Start(&e.m_dsp, &e.m_block, channels, true, 48000, 0));
+
+    ASSERT_TRUE(p.Write(&pcm[0], 24000));
+    ASSERT_TRUE(p.Write(&pcm[24000 * channels], 24000));
+
+    p.Stop();  // doesn't wait for the queued input to be encoded
+
+    VorbisEncodePipeline::packets_t packets;
+
+    EXPECT_TRUE(p.Read(packets, true));
+    EXPECT_TRUE(packets.empty());
+    EXPECT_EQ(0, p.GetPendingFrames());
+}
+
+TEST(VorbisEncodePipelineTest, ReportsFailure)
+{
+    const int channels = 2;
+    const std::vector<float> pcm = MakeContent(channels, 48000);
+
+    for (int threaded = 0; threaded < 2; ++threaded)
+    {
+        Encoder e(channels);
+        e.m_enc.fail = true;
+
+        VorbisEncodePipeline p;
+        ASSERT_TRUE(p.Start(&e.m_dsp, &e.m_block, channels, threaded != 0,
+                            48000, 0));
+
+        p.Write(&pcm[0], 24000);  // fails now, or on the worker
+
+        VorbisEncodePipeline::packets_t packets;
+
+        EXPECT_FALSE(p.Read(packets, true));
+        EXPECT_FALSE(p.Write(&pcm[0], 24000));
+        EXPECT_FALSE(p.WriteEnd());
+    }
+}
@@ -0,0 +1,227 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vorbisoutput.h"
+
+// The renderers are portable, so this also builds on Linux:
+//
+//   g++ -std=c++11 -Icommon common/vorbisoutput.cc
+//       common/tests/vorbisoutput_tests.cc -lgtest -lgtest_main -lpthread
+
+namespace VorbisOutput = WebmMfVorbisDecLib::VorbisOutput;
+
+namespace
+{
+
+// What the decoder used to do, in two passes: reorder and interleave (in
+// VorbisDecoder::ReorderAndInterleaveBlock_), then downmix and convert (in
+// WebmMfVorbisDec::PostProcessSamples).  The renderers have to match it.
+
+const int kWaveOrder[9][8] =
+{
+    { 0 },
+    { 0 },
+    { 0, 1 },
+    { 0, 2, 1 },
+    { 0, 1, 2, 3 },
+    { 0, 2, 1, 3, 4 },
+    { 0, 2, 1, 5, 3, 4 },
+    { 0, 2, 1, 6, 5, 3, 4 },
+    { 0, 2, 1, 7, 5, 6, 3, 4 }
+};
+
+short ToShort(float x)
+{
+    int val = static_cast<int>(std::floor(x * 32767.f + .5f));
+    if (val > 32767)
+        val = 32767;
+    else if (val < -32768)
+        val = -32768;
+    return static_cast<short>(val);
+}
+
+void Reference(const std::vector<std::vector<float> >& planes,
+               int offset,
+               int frames,
+               int channels_out,
+               std::vector<float>& out)
+{
+    const int channels_in = static_cast<int>(planes.size());
+
+    for (int i = offset; i < offset + frames; ++i)
+    {
+        float s[8];
+
+        for (int c = 0; c < channels_in; ++c)
+            s[c] = planes[kWaveOrder[channels_in][c]][i];
+
+        if (channels_out == channels_in || channels_out == 6)
+        {
+            for (int c = 0; c < channels_out; ++c)
+                out.push_back(s[c]);
+
+            continue;
+        }
+
+        float left = 0.0f;
+        float right = 0.0f;
+
+        switch (channels_in)
+        {
+        case 8:
+            left = s[0] + s[3] + s[2] * 0.7f + s[4] * 0.7f + s[6] * 0.7f;
+            right = s[1] + s[3] + s[2] * 0.7f + s[5] * 0.7f + s[7] * 0.7f;
+            break;
+        case 7:
+            left = s[0] + s[3] + s[2] * 0.7f + s[4] * 0.7f + s[6] * 0.7f;
+            right = s[1] + s[3] + s[2] * 0.7f + s[5] * 0.7f + s[6] * 0.7f;
+            break;
+        case 6:
+            left = s[0] + s[3] + s[2] * 0.7f + s[4] * 0.7f;
+            right = s[1] + s[3] + s[2] * 0.7f + s[5] * 0.7f;
+            break;
+        case 5:
+            left = s[0] + s[2] * 0.7f + s[3] * 0.7f;
+            right = s[1] + s[2] * 0.7f + s[4] * 0.7f;
+            break;
+        case 4:
+            left = s[0] + s[2] * 0.7f + s[3] * 0.7f;
+            right = s[1] + s[2] * 0.7f + s[3] * 0.7f;
+            break;
+        case 3:
+            left = s[0] + s[2] * 0.7f;
+            right = s[1] + s[2] * 0.7f;
+            break;
+        }
+
+        out.push_back(left);
+        out.push_back(right);
+    }
+}
+
+// Samples mostly in [-1, 1], with some that clip, and some that land
+// exactly on a rounding boundary.
+std::vector<std::vector<float> > MakePlanes(int channels, int frames)
+{
+    std::vector<std::vector<float> > planes(channels);
+    unsigned int x = 0x2545F491;
+
+    for (int c = 0; c < channels; ++c)
+    {
+        for (int i = 0; i < frames; ++i)
+        {
+            x = x * 1103515245 + 12345;
+            float val = (static_cast<int>(x >> 8) % 2400 - 1200) / 1000.0f;
+
+            if (i % 17 == 0)
+                val = (static_cast<int>(x >> 20) % 64 - 32 + 0.5f) / 32767.f;
+
+            planes[c].push_back(val);
+        }
+    }
+
+    return planes;
+}
+
+void ExpectMatches(int channels_in, int channels_out)
+{
+    const int kFrames = 103;  // not a multiple of 4
+    const int kOffset = 5;
+
+    const std::vector<std::vector<float> > planes =
+        MakePlanes(channels_in, kOffset + kFrames);
+
+    std::vector<const float*> ptrs;
+    for (int c = 0; c < channels_in; ++c)
+        ptrs.push_back(&planes[c][0]);
+
+    std::vector<float> expected;
+    Reference(planes, kOffset, kFrames, channels_out, expected);
+
+    const size_t count = static_cast<size_t>(kFrames) * channels_out;
+    ASSERT_EQ(count, expected.size());
+
+    VorbisOutput::Renderer render =
+        VorbisOutput::GetRenderer(channels_in, channels_out,
+                                  VorbisOutput::kFloat);
+    ASSERT_TRUE(render != NULL);
+
+    std::vector<float> out_float(count);
+    render(&ptrs[0], channels_in, kOffset, kFrames, &out_float[0]);
+
+    render = VorbisOutput::GetRenderer(channels_in, channels_out,
+                                       VorbisOutput::kInt16);
+    ASSERT_TRUE(render != NULL);
+
+    std::vector<short> out_short(count);
+    render(&ptrs[0], channels_in, kOffset, kFrames, &out_short[0]);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        // bit for bit, not just close
+        EXPECT_EQ(0, memcmp(&expected[i], &out_float[i], sizeof(float)))
+            << channels_in << " to " << channels_out << ", sample " << i;
+        EXPECT_EQ(ToShort(expected[i]), out_short[i])
+            << channels_in << " to " << channels_out << ", sample " << i;
+    }
+}
+
+}  // namespace
+
+TEST(VorbisOutputTest, ReordersAndInterleaves)
+{
+    for (int channels = 1; channels <= 8; ++channels)
+        ExpectMatches(channels, channels);
+}
+
+TEST(VorbisOutputTest, DownmixesToStereo)
+{
+    for (int channels = 3; channels <= 8; ++channels)
+        ExpectMatches(channels, 2);
+}
+
+TEST(VorbisOutputTest, FoldsTo51)
+{
+    ExpectMatches(7, 6);
+    ExpectMatches(8, 6);
+}
+
+TEST(VorbisOutputTest, OnlySupportedConversions)
+{
+    EXPECT_TRUE(VorbisOutput::GetRenderer(2, 1, VorbisOutput::kFloat) == NULL);
+    EXPECT_TRUE(VorbisOutput::GetRenderer(6, 4, VorbisOutput::kInt16) == NULL);
+    EXPECT_TRUE(VorbisOutput::GetRenderer(2, 6, VorbisOutput::kFloat) == NULL);
+    EXPECT_TRUE(VorbisOutput::GetRenderer(12, 12, VorbisOutput::kInt16) != NULL);
+}
+
+TEST(VorbisOutputTest, ClampsAndHandlesNaN)
+{
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float in[] = { 2.0f, -2.0f, nan, 1.0f, -1.0f, 0.99999f, 1e30f };
+    const int kFrames = sizeof(in) / sizeof(in[0]);
+
+    const float* const planes[] = { in };
+    short out[kFrames];
+
+    VorbisOutput::GetRenderer(1, 1, VorbisOutput::kInt16)(planes, 1, 0,
+                                                          kFrames, out);
+
+    EXPECT_EQ(32767, out[0]);
+    EXPECT_EQ(-32768, out[1]);
+    EXPECT_EQ(-32768, out[2]);
+    EXPECT_EQ(32767, out[3]);
+    EXPECT_EQ(-32767, out[4]);
+    EXPECT_EQ(ToShort(0.99999f), out[5]);
+    EXPECT_EQ(32767, out[6]);
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "gtest/gtest.h"
+#include "vp9tiling.h"
+
+// These build on Linux as well:
+//
+//   g++ -Icommon common/vp9tiling.cc common/tests/vp9tiling_tests.cc
+//       -lgtest -lgtest_main -lpthread
+
+using WebmUtil::GetVP9AutoLog2TileColumns;
+using WebmUtil::GetVP9AutoThreadCount;
+using WebmUtil::GetVP9MaxLog2TileColumns;
+using WebmUtil::GetVP9MinLog2TileColumns;
+
+TEST(VP9TilingTest, ColumnLimitsFollowWidth)
+{
+    // A column is at least 256 pixels wide (4 superblocks).
+    EXPECT_EQ(0, GetVP9MaxLog2TileColumns(176));
+    EXPECT_EQ(0, GetVP9MaxLog2TileColumns(320));
+    EXPECT_EQ(1, GetVP9MaxLog2TileColumns(640));
+    EXPECT_EQ(2, GetVP9MaxLog2TileColumns(1280));
+    EXPECT_EQ(2, GetVP9MaxLog2TileColumns(1920));
+    EXPECT_EQ(3, GetVP9MaxLog2TileColumns(3840));
+    EXPECT_EQ(4, GetVP9MaxLog2TileColumns(7680));
+
+    // ... and at most 4096 pixels wide (64 superblocks).
+    EXPECT_EQ(0, GetVP9MinLog2TileColumns(1920));
+    EXPECT_EQ(0, GetVP9MinLog2TileColumns(4096));
+    EXPECT_EQ(1, GetVP9MinLog2TileColumns(4160));
+    EXPECT_EQ(2, GetVP9MinLog2TileColumns(16384));
+}
+
+TEST(VP9TilingTest, AutoColumnsGiveEachThreadOne)
+{
+    EXPECT_EQ(0, GetVP9AutoLog2TileColumns(1920, 0));
+    EXPECT_EQ(0, GetVP9AutoLog2TileColumns(1920, 1));
+    EXPECT_EQ(1, GetVP9AutoLog2TileColumns(1920, 2));
+    EXPECT_EQ(2, GetVP9AutoLog2TileColumns(1920, 3));  // rounds up
+    EXPECT_EQ(2, GetVP9AutoLog2TileColumns(1920, 4));
+
+    // The width caps it.
+    EXPECT_EQ(2, GetVP9AutoLog2TileColumns(1920, 16));
+    EXPECT_EQ(3, GetVP9AutoLog2TileColumns(3840, 16));
+    EXPECT_EQ(0, GetVP9AutoLog2TileColumns(320, 8));
+
+    // A very wide frame needs columns even with one thread.
+    EXPECT_EQ(1, GetVP9AutoLog2TileColumns(8192, 1));
+}
+
+TEST(VP9TilingTest, AutoThreadsStopAtColumns)
+{
+    EXPECT_EQ(1, GetVP9AutoThreadCount(1920, 0));
+    EXPECT_EQ(1, GetVP9AutoThreadCount(1920, 1));
+    EXPECT_EQ(2, GetVP9AutoThreadCount(1920, 2));
+    EXPECT_EQ(3, GetVP9AutoThreadCount(1920, 3));
+    EXPECT_EQ(4, GetVP9AutoThreadCount(1920, 16));
+    EXPECT_EQ(8, GetVP9AutoThreadCount(3840, 16));
+    EXPECT_EQ(1, GetVP9AutoThreadCount(320, 16));
+}
@@ -0,0 +1,732 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "vpxframeparser.h"
+
+// These tests have no dependencies beyond the parser itself, so they also
+// build on Linux (from the root of the tree):
+//
+//   g++ -Icommon common/vpxframeparser.cc
+//       common/tests/vpxframeparser_tests.cc -lgtest -lgtest_main -lpthread
+//
+// The benchmark at the end runs over IVF files listed (separated by ';') in
+// the VPXFRAMEPARSER_IVF environment variable, and is skipped otherwise.
+
+using WebmUtil::VpxFrameInfo;
+
+namespace
+{
+    typedef std::vector<unsigned char> Packet;
+
+    // VP8 bool encoder (RFC 6386 section 7.3), so that tests can produce
+    // frame headers without libvpx.
+    class BoolEncoder
+    {
+    public:
+        BoolEncoder() : range_(255), bottom_(0), bit_count_(24) {}
+
+        void WriteBool(int prob, bool bit)
+        {
+            const unsigned int split = 1 + (((range_ - 1) * prob) >> 8);
+
+            if (bit)
+            {
+                bottom_ += split;
+                range_ -= split;
+            }
+            else
+            {
+                range_ = split;
+            }
+
+            while (range_ < 128)
+            {
+                range_ <<= 1;
+
+                if (bottom_ & (1u << 31))
+                    AddOne();
+
+                bottom_ <<= 1;
+
+                if (!--bit_count_)
+                {
+                    buf_.push_back(static_cast<unsigned char>(bottom_ >> 24));
+                    bottom_ &= (1 << 24) - 1;
+                    bit_count_ = 8;
+                }
+            }
+        }
+
+        void WriteFlag(bool bit) { WriteBool(128, bit); }
+
+        void WriteLiteral(unsigned int val, int bits)
+        {
+            while (bits-- > 0)
+                WriteFlag(((val >> bits) & 1) != 0);
+        }
+
+        const Packet& Flush()
+        {
+            int c = bit_count_;
+            unsigned int v = bottom_;
+
+            if (v & (1u << (32 - c)))
+                AddOne();
+
+            v <<= c & 7;
+            c >>= 3;
+
+            while (--c >= 0)
+                v <<= 8;
+
+            c = 4;
+
+            while (--c >= 0)
+            {
+                buf_.push_back(static_cast<unsigned char>(v >> 24));
+                v <<= 8;
+            }
+
+            return buf_;
+        }
+
+    private:
+        void AddOne()
+        {
+            std::vector<unsigned char>::reverse_iterator i = buf_.rbegin();
+
+            while ((i != buf_.rend()) && (*i == 255))
+            {
+                *i = 0;
+                ++i;
+            }
+
+            if (i != buf_.rend())
+                ++*i;
+        }
+
+        unsigned int range_;
+        unsigned int bottom_;
+        int bit_count_;
+        Packet buf_;
+    };
+
+    struct VP8Params
+    {
+        bool key;
+        bool show;
+        bool segmentation_update;
+        bool refresh_golden;
+        bool refresh_altref;
+        int copy_to_golden;
+        bool refresh_entropy;
+        bool refresh_last;
+    };
+
+    Packet MakeVP8Frame(const VP8Params& p, int width, int height)
+    {
+        BoolEncoder bc;
+
+        if (p.key)
+        {
+            bc.WriteLiteral(0, 1);  // color_space
+            bc.WriteLiteral(0, 1);  // clamping_type
+        }
+
+        bc.WriteFlag(p.segmentation_update);  // segmentation_enabled
+
+        if (p.segmentation_update)
+        {
+            bc.WriteFlag(true);  // update_mb_segmentation_map
+            bc.WriteFlag(false);  // update_segment_feature_data
+
+            for (int i = 0; i < 3; ++i)
+            {
+                bc.WriteFlag(true);
+                bc.WriteLiteral(200, 8);
+            }
+        }
+
+        bc.WriteLiteral(0, 1);   // filter_type
+        bc.WriteLiteral(32, 6);  // loop_filter_level
+        bc.WriteLiteral(3, 3);   // sharpness_level
+        bc.WriteFlag(true);      // loop_filter_adj_enable
+        bc.WriteFlag(false);     // mode_ref_lf_delta_update
+        bc.WriteLiteral(0, 2);   // log2_nbr_of_dct_partitions
+        bc.WriteLiteral(60, 7);  // y_ac_qi
+
+        for (int i = 0; i < 5; ++i)
+        {
+            bc.WriteFlag(i == 2);
+
+            if (i == 2)
+            {
+                bc.WriteLiteral(5, 4);
+                bc.WriteFlag(true);
+            }
+        }
+
+        if (p.key)
+        {
+            bc.WriteFlag(p.refresh_entropy);
+        }
+        else
+        {
+            bc.WriteFlag(p.refresh_golden);
+            bc.WriteFlag(p.refresh_altref);
+
+            if (!p.refresh_golden)
+                bc.WriteLiteral(p.copy_to_golden, 2);
+
+            if (!p.refresh_altref)
+                bc.WriteLiteral(0, 2);
+
+            bc.WriteLiteral(0, 1);  // sign_bias_golden
+            bc.WriteLiteral(0, 1);  // sign_bias_alternate
+            bc.WriteFlag(p.refresh_entropy);
+            bc.WriteFlag(p.refresh_last);
+        }
+
+        // Stand-in for the rest of the first partition (the mode and
+        // motion vector probabilities, and the macroblock headers).
+        for (int i = 0; i < 64; ++i)
+            bc.WriteBool(200, (i % 3) == 0);
+
+        const Packet& part = bc.Flush();
+        const unsigned int size = static_cast<unsigned int>(part.size());
+
+        Packet frame;
+
+        const unsigned int tag = (p.key ? 0 : 1) | (p.show ? 0x10 : 0) |
+                                 (size << 5);
+
+        frame.push_back(static_cast<unsigned char>(tag));
+        frame.push_back(static_cast<unsigned char>(tag >> 8));
+        frame.push_back(static_cast<unsigned char>(tag >> 16));
+
+        if (p.key)
+        {
+            frame.push_back(0x9D);
+            frame.push_back(0x01);
+            frame.push_back(0x2A);
+            frame.push_back(static_cast<unsigned char>(width));
+            frame.push_back(static_cast<unsigned char>(width >> 8));
+            frame.push_back(static_cast<unsigned char>(height));
+            frame.push_back(static_cast<unsigned char>(height >> 8));
+        }
+
+        frame.insert(frame.end(), part.begin(), part.end());
+
+        for (int i = 0; i < 16; ++i)  // token partition
+            frame.push_back(0x5A);
+
+        return frame;
+    }
+
+    class BitWriter
+    {
+    public:
+        BitWriter() : bits_(0) {}
+
+        void Write(unsigned int val, int bits)
+        {
+            while (bits-- > 0)
+            {
+                if ((bits_ & 7) == 0)
+                    buf_.push_back(0);
+
+                if ((val >> bits) & 1)
+                    buf_.back() |= 0x80 >> (bits_ & 7);
+
+                ++bits_;
+            }
+        }
+
+        const Packet& Get() const { return buf_; }
+
+    private:
+        Packet buf_;
+        long bits_;
+    };
+
+    struct VP9Params
+    {
+        bool show_existing;
+        bool key;
+        bool show;
+        bool intra_only;
+        bool error_resilient;
+        unsigned int refresh_flags;
+        bool refresh_context;
+    };
+
+    Packet MakeVP9Frame(const VP9Params& p, int width, int height)
+    {
+        BitWriter bw;
+
+        bw.Write(2, 2);  // frame_marker
+        bw.Write(0, 2);  // profile 0
+        bw.Write(p.show_existing ? 1 : 0, 1);
+
+        if (p.show_existing)
+        {
+            bw.Write(3, 3);
+            return bw.Get();
+        }
+
+        bw.Write(p.key ? 0 : 1, 1);
+        bw.Write(p.show ? 1 : 0, 1);
+        bw.Write(p.error_resilient ? 1 : 0, 1);
+
+        if (p.key)
+        {
+            bw.Write(0x498342, 24);
+            bw.Write(2, 3);  // color_space (BT.709)
+            bw.Write(0, 1);  // color_range
+            bw.Write(width - 1, 16);
+            bw.Write(height - 1, 16);
+            bw.Write(0, 1);  // render_and_frame_size_different
+        }
+        else
+        {
+            if (!p.show)
+                bw.Write(p.intra_only ? 1 : 0, 1);
+
+            if (!p.error_resilient)
+                bw.Write(0, 2);  // reset_frame_context
+
+            if (p.intra_only)
+            {
+                bw.Write(0x498342, 24);
+                bw.Write(p.refresh_flags, 8);
+                bw.Write(width - 1, 16);
+                bw.Write(height - 1, 16);
+                bw.Write(0, 1);
+            }
+            else
+            {
+                bw.Write(p.refresh_flags, 8);
+
+                for (int i = 0; i < 3; ++i)
+                    bw.Write(i, 3 + 1);
+
+                bw.Write(1, 1);  // found_ref
+                bw.Write(0, 1);  // render_and_frame_size_different
+                bw.Write(1, 1);  // allow_high_precision_mv
+                bw.Write(1, 1);  // is_filter_switchable
+            }
+        }
+
+        if (!p.error_resilient)
+        {
+            bw.Write(p.refresh_context ? 1 : 0, 1);
+            bw.Write(0, 1);  // frame_parallel_decoding_mode
+        }
+
+        bw.Write(0, 2);   // frame_context_idx
+        bw.Write(10, 6);  // filter_level
+        bw.Write(0, 3);   // sharpness
+        bw.Write(1, 1);   // mode_ref_delta_enabled
+        bw.Write(0, 1);   // mode_ref_delta_update
+        bw.Write(100, 8); // base_q_idx
+        bw.Write(0, 3);   // no delta q
+        bw.Write(0, 1);   // segmentation_enabled
+        bw.Write(0, 6);   // tile info
+        bw.Write(1234, 16);  // header_size_in_bytes
+
+        Packet frame = bw.Get();
+
+        for (int i = 0; i < 32; ++i)  // compressed header and tiles
+            frame.push_back(0xA5);
+
+        return frame;
+    }
+
+    Packet MakeSuperframe(const Packet& f0, const Packet& f1)
+    {
+        const unsigned char marker = 0xC0 | (1 << 3) | 1;  // 2 frames, mag 2
+
+        Packet sf(f0);
+        sf.insert(sf.end(), f1.begin(), f1.end());
+
+        sf.push_back(marker);
+
+        const size_t sizes[2] = { f0.size(), f1.size() };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            sf.push_back(static_cast<unsigned char>(sizes[i]));
+            sf.push_back(static_cast<unsigned char>(sizes[i] >> 8));
+        }
+
+        sf.push_back(marker);
+
+        return sf;
+    }
+
+    int Parse(int codec, const Packet& packet, VpxFrameInfo& info)
+    {
+        return WebmUtil::ParseVpxFrame(codec,
+                                       &packet[0],
+                                       static_cast<long>(packet.size()),
+                                       info);
+    }
+}
+
+TEST(VpxFrameParserTest, VP8KeyFrame)
+{
+    const VP8Params p = { true, true, false, false, false, 0, true, true };
+    const Packet frame = MakeVP8Frame(p, 1280, 720);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_TRUE(info.key);
+    EXPECT_TRUE(info.show_frame);
+    EXPECT_FALSE(info.droppable);
+    EXPECT_EQ(1280, info.width);
+    EXPECT_EQ(720, info.height);
+    EXPECT_EQ(7u, info.refresh_flags);
+}
+
+TEST(VpxFrameParserTest, VP8InterFrameFlags)
+{
+    const VP8Params p = { false, true, false, true, false, 0, true, true };
+    const Packet frame = MakeVP8Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_FALSE(info.key);
+    EXPECT_EQ(0, info.width);
+    EXPECT_EQ(unsigned(WebmUtil::kVP8RefreshLast |
+                       WebmUtil::kVP8RefreshGolden),
+              info.refresh_flags);
+    EXPECT_TRUE(info.refresh_entropy);
+    EXPECT_FALSE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP8CopyToGoldenCountsAsRefresh)
+{
+    const VP8Params p = { false, true, false, false, false, 1, false, false };
+    const Packet frame = MakeVP8Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_EQ(unsigned(WebmUtil::kVP8RefreshGolden), info.refresh_flags);
+    EXPECT_FALSE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP8DroppableFrame)
+{
+    const VP8Params p = { false, true, false, false, false, 0, false, false };
+    const Packet frame = MakeVP8Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_EQ(0u, info.refresh_flags);
+    EXPECT_TRUE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP8SegmentationUpdateIsNotDroppable)
+{
+    const VP8Params p = { false, true, true, false, false, 0, false, false };
+    const Packet frame = MakeVP8Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_EQ(0u, info.refresh_flags);
+    EXPECT_FALSE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP8InvisibleAltRef)
+{
+    const VP8Params p = { false, false, false, false, true, 0, false, false };
+    const Packet frame = MakeVP8Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP8, frame, info));
+
+    EXPECT_FALSE(info.show_frame);
+    EXPECT_EQ(unsigned(WebmUtil::kVP8RefreshAltRef), info.refresh_flags);
+}
+
+TEST(VpxFrameParserTest, VP8Truncated)
+{
+    const VP8Params p = { true, true, false, false, false, 0, true, true };
+    const Packet frame = MakeVP8Frame(p, 320, 240);
+
+    VpxFrameInfo info;
+
+    for (long len = 0; len < 12; ++len)
+    {
+        EXPECT_EQ(WebmUtil::kVpxParseTruncated,
+                  WebmUtil::ParseVP8Frame(&frame[0], len, info));
+    }
+
+    Packet bad(frame);
+    bad[4] = 0;
+
+    EXPECT_EQ(WebmUtil::kVpxParseCorrupt,
+              Parse(WebmUtil::kVpxCodecVP8, bad, info));
+}
+
+TEST(VpxFrameParserTest, VP9KeyFrame)
+{
+    const VP9Params p = { false, true, true, false, false, 0, true };
+    const Packet frame = MakeVP9Frame(p, 1920, 1080);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, frame, info));
+
+    EXPECT_TRUE(info.key);
+    EXPECT_TRUE(info.show_frame);
+    EXPECT_EQ(1920, info.width);
+    EXPECT_EQ(1080, info.height);
+    EXPECT_EQ(0xFFu, info.refresh_flags);
+    EXPECT_EQ(1, info.frames);
+}
+
+TEST(VpxFrameParserTest, VP9InterFrames)
+{
+    const VP9Params ref = { false, false, true, false, false, 0x01, false };
+    const VP9Params nonref = { false, false, true, false, false, 0, false };
+    const VP9Params ctx = { false, false, true, false, false, 0, true };
+
+    VpxFrameInfo info;
+
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, MakeVP9Frame(ref, 0, 0), info));
+    EXPECT_FALSE(info.key);
+    EXPECT_EQ(0x01u, info.refresh_flags);
+    EXPECT_FALSE(info.droppable);
+
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, MakeVP9Frame(nonref, 0, 0), info));
+    EXPECT_TRUE(info.droppable);
+
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, MakeVP9Frame(ctx, 0, 0), info));
+    EXPECT_TRUE(info.refresh_entropy);
+    EXPECT_FALSE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP9IntraOnly)
+{
+    const VP9Params p = { false, false, false, true, false, 0x04, false };
+    const Packet frame = MakeVP9Frame(p, 640, 360);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, frame, info));
+
+    EXPECT_FALSE(info.key);
+    EXPECT_TRUE(info.intra_only);
+    EXPECT_EQ(640, info.width);
+    EXPECT_EQ(360, info.height);
+    EXPECT_EQ(0x04u, info.refresh_flags);
+}
+
+TEST(VpxFrameParserTest, VP9ShowExistingFrame)
+{
+    const VP9Params p = { true, false, false, false, false, 0, false };
+    const Packet frame = MakeVP9Frame(p, 0, 0);
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, frame, info));
+
+    EXPECT_TRUE(info.show_existing);
+    EXPECT_TRUE(info.show_frame);
+    EXPECT_TRUE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, VP9Superframe)
+{
+    const VP9Params altref = { false, false, false, false, false, 0x04, true };
+    const VP9Params shown = { false, false, true, false, false, 0, false };
+
+    const Packet sf = MakeSuperframe(MakeVP9Frame(altref, 0, 0),
+                                     MakeVP9Frame(shown, 0, 0));
+
+    VpxFrameInfo info;
+    ASSERT_EQ(WebmUtil::kVpxParseOk,
+              Parse(WebmUtil::kVpxCodecVP9, sf, info));
+
+    EXPECT_EQ(2, info.frames);
+    EXPECT_TRUE(info.show_frame);
+    EXPECT_EQ(0x04u, info.refresh_flags);
+    EXPECT_FALSE(info.droppable);
+}
+
+TEST(VpxFrameParserTest, BatchApi)
+{
+    const VP8Params key = { true, true, false, false, false, 0, true, true };
+    const VP8Params drop = { false, true, false, false, false, 0, false, false };
+
+    const Packet p0 = MakeVP8Frame(key, 176, 144);
+    const Packet p1 = MakeVP8Frame(drop, 0, 0);
+    const unsigned char garbage[2] = { 0, 0 };
+
+    const unsigned char* const packets[3] = { &p0[0], &p1[0], garbage };
+    const long lengths[3] = { static_cast<long>(p0.size()),
+                              static_cast<long>(p1.size()),
+                              2 };
+
+    VpxFrameInfo infos[3];
+    int status[3];
+
+    EXPECT_EQ(2, WebmUtil::ParseVpxFrames(WebmUtil::kVpxCodecVP8,
+                                          packets, lengths, 3,
+                                          infos, status));
+
+    EXPECT_EQ(WebmUtil::kVpxParseOk, status[0]);
+    EXPECT_EQ(WebmUtil::kVpxParseOk, status[1]);
+    EXPECT_EQ(WebmUtil::kVpxParseTruncated, status[2]);
+    EXPECT_TRUE(infos[0].key);
+    EXPECT_TRUE(infos[1].droppable);
+}
+
+namespace
+{
+    // Reads all of the frames of an IVF file.  Returns the codec, or 0.
+    int ReadIvf(const char* path, std::vector<Packet>& frames)
+    {
+        FILE* const file = fopen(path, "rb");
+
+        if (file == NULL)
+            return 0;
+
+        unsigned char hdr[32];
+        int codec = 0;
+
+        if ((fread(hdr, 1, 32, file) == 32) && (memcmp(hdr, "DKIF", 4) == 0))
+        {
+            if (memcmp(hdr + 8, "VP80", 4) == 0)
+                codec = WebmUtil::kVpxCodecVP8;
+            else if (memcmp(hdr + 8, "VP90", 4) == 0)
+                codec = WebmUtil::kVpxCodecVP9;
+        }
+
+        unsigned char frame_hdr[12];
+
+        while (codec && (fread(frame_hdr, 1, 12, file) == 12))
+        {
+            const unsigned long size = frame_hdr[0] |
+                                       (frame_hdr[1] << 8) |
+                                       (frame_hdr[2] << 16) |
+                                       (frame_hdr[3] << 24);
+
+            Packet frame(size);
+
+            if (size && (fread(&frame[0], 1, size, file) != size))
+                break;
+
+            frames.push_back(frame);
+        }
+
+        fclose(file);
+        return codec;
+    }
+}
+
+TEST(VpxFrameParserTest, IvfCorpusBenchmark)
+{
+    const char* const env = getenv("VPXFRAMEPARSER_IVF");
+
+    if (env == NULL)
+        return;  // no corpus
+
+    std::string list(env);
+    std::string::size_type pos = 0;
+
+    while (pos <= list.size())
+    {
+        std::string::size_type end = list.find(';', pos);
+
+        if (end == std::string::npos)
+            end = list.size();
+
+        const std::string path = list.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (path.empty())
+            continue;
+
+        std::vector<Packet> frames;
+        const int codec = ReadIvf(path.c_str(), frames);
+
+        ASSERT_NE(0, codec) << path;
+        ASSERT_FALSE(frames.empty()) << path;
+
+        const int count = static_cast<int>(frames.size());
+
+        std::vector<const unsigned char*> packets(count);
+        std::vector<long> lengths(count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            packets[i] = frames[i].empty() ? NULL : &frames[i][0];
+            lengths[i] = static_cast<long>(frames[i].size());
+        }
+
+        std::vector<VpxFrameInfo> infos(count);
+        std::vector<int> status(count);
+
+        enum { kIterations = 100 };
+
+        const clock_t start = clock();
+        int parsed = 0;
+
+        for (int i = 0; i < kIterations; ++i)
+        {
+            parsed = WebmUtil::ParseVpxFrames(codec, &packets[0],
+                                              &lengths[0], count,
+                                              &infos[0], &status[0]);
+        }
+
+        const double secs = double(clock() - start) / CLOCKS_PER_SEC;
+
+        int keys = 0;
+        int hidden = 0;
+        int droppable = 0;
+
+        for (int i = 0; i < count; ++i)
+        {
+            keys += infos[i].key ? 1 : 0;
+            hidden += infos[i].show_frame ? 0 : 1;
+            droppable += infos[i].droppable ? 1 : 0;
+        }
+
+        EXPECT_TRUE(infos[0].key) << path;
+        EXPECT_EQ(count, parsed) << path;
+
+        printf("%s: %d frames (%d key, %d hidden, %d droppable), "
+               "%.1f ns/frame\n",
+               path.c_str(), count, keys, hidden, droppable,
+               secs * 1e9 / (double(count) * kIterations));
+    }
+}
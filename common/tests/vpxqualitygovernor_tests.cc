@@ -0,0 +1,183 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "vpxframeparser.h"
+#include "vpxqualitygovernor.h"
+
+// Like the frame parser tests, these also build on Linux:
+//
+//   g++ -Icommon common/vpxframeparser.cc common/vpxqualitygovernor.cc
+//       common/tests/vpxqualitygovernor_tests.cc -lgtest -lgtest_main -lpthread
+
+using WebmUtil::VpxFrameInfo;
+using WebmUtil::VpxQualityGovernor;
+
+namespace
+{
+    const long long kMillisecond = 10000;
+
+    VpxFrameInfo MakeInfo(bool droppable)
+    {
+        VpxFrameInfo info;
+        memset(&info, 0, sizeof info);
+
+        info.codec = WebmUtil::kVpxCodecVP8;
+        info.show_frame = true;
+        info.droppable = droppable;
+        info.refresh_flags = droppable ? 0 : WebmUtil::kVP8RefreshLast;
+
+        return info;
+    }
+
+    void Frames(VpxQualityGovernor& governor, int count)
+    {
+        const VpxFrameInfo info = MakeInfo(false);
+
+        for (int i = 0; i < count; ++i)
+            governor.OnFrame(&info);
+    }
+}
+
+TEST(VpxQualityGovernorTest, StartsAtFullQuality)
+{
+    VpxQualityGovernor governor;
+
+    EXPECT_EQ(VpxQualityGovernor::kLevelFull, governor.GetLevel());
+    EXPECT_TRUE(governor.IsEnabled());
+
+    const VpxFrameInfo info = MakeInfo(true);
+    EXPECT_TRUE(governor.OnFrame(&info));
+    EXPECT_EQ(1, governor.GetStats().decoded);
+}
+
+TEST(VpxQualityGovernorTest, StepsDownOneLevelAtATime)
+{
+    VpxQualityGovernor governor;
+    const long long late = 50 * kMillisecond;
+
+    EXPECT_FALSE(governor.OnNotify(late));  // nothing decoded yet
+
+    Frames(governor, VpxQualityGovernor::kHoldFrames);
+    EXPECT_TRUE(governor.OnNotify(late));
+    EXPECT_EQ(VpxQualityGovernor::kLevelReducedPostProc, governor.GetLevel());
+
+    // The new level has not had time to take effect.
+    EXPECT_FALSE(governor.OnNotify(late));
+
+    Frames(governor, VpxQualityGovernor::kHoldFrames);
+    EXPECT_TRUE(governor.OnNotify(late));
+    EXPECT_EQ(VpxQualityGovernor::kLevelNoPostProc, governor.GetLevel());
+
+    Frames(governor, VpxQualityGovernor::kHoldFrames);
+    EXPECT_TRUE(governor.OnNotify(late));
+    EXPECT_EQ(VpxQualityGovernor::kLevelSkipDroppable, governor.GetLevel());
+
+    Frames(governor, VpxQualityGovernor::kHoldFrames);
+    EXPECT_FALSE(governor.OnNotify(late));
+    EXPECT_EQ(3, governor.GetStats().step_downs);
+    EXPECT_EQ(late, governor.GetStats().max_late);
+}
+
+TEST(VpxQualityGovernorTest, SevereLatenessSkipsStraightToDropping)
+{
+    VpxQualityGovernor governor;
+
+    EXPECT_TRUE(governor.OnNotify(500 * kMillisecond));
+    EXPECT_EQ(VpxQualityGovernor::kLevelSkipDroppable, governor.GetLevel());
+}
+
+TEST(VpxQualityGovernorTest, SkipsOnlyDroppableFrames)
+{
+    VpxQualityGovernor governor;
+    governor.OnNotify(500 * kMillisecond);
+
+    const VpxFrameInfo ref = MakeInfo(false);
+    const VpxFrameInfo drop = MakeInfo(true);
+
+    EXPECT_TRUE(governor.OnFrame(&ref));
+    EXPECT_FALSE(governor.OnFrame(&drop));
+    EXPECT_TRUE(governor.OnFrame(&ref));
+    EXPECT_TRUE(governor.OnFrame(0));  // unparsed frames are decoded
+
+    EXPECT_EQ(4, governor.GetStats().frames);
+    EXPECT_EQ(3, governor.GetStats().decoded);
+    EXPECT_EQ(1, governor.GetStats().skipped);
+}
+
+TEST(VpxQualityGovernorTest, LimitsConsecutiveSkips)
+{
+    VpxQualityGovernor governor;
+    governor.OnNotify(500 * kMillisecond);
+
+    const VpxFrameInfo drop = MakeInfo(true);
+
+    for (int i = 0; i < VpxQualityGovernor::kMaxConsecutiveSkips; ++i)
+        EXPECT_FALSE(governor.OnFrame(&drop));
+
+    EXPECT_TRUE(governor.OnFrame(&drop));
+    EXPECT_FALSE(governor.OnFrame(&drop));
+}
+
+TEST(VpxQualityGovernorTest, RecoversGradually)
+{
+    VpxQualityGovernor governor;
+    governor.OnNotify(500 * kMillisecond);
+
+    const int n = VpxQualityGovernor::kRecoverNotifications;
+
+    for (int i = 1; i < n; ++i)
+        EXPECT_FALSE(governor.OnNotify(-5 * kMillisecond));
+
+    EXPECT_TRUE(governor.OnNotify(-5 * kMillisecond));
+    EXPECT_EQ(VpxQualityGovernor::kLevelNoPostProc, governor.GetLevel());
+
+    // Being a little late interrupts the recovery, without stepping down.
+    for (int i = 1; i < n; ++i)
+        governor.OnNotify(0);
+
+    EXPECT_FALSE(governor.OnNotify(10 * kMillisecond));
+    EXPECT_EQ(VpxQualityGovernor::kLevelNoPostProc, governor.GetLevel());
+
+    for (int i = 1; i < n; ++i)
+        EXPECT_FALSE(governor.OnNotify(0));
+
+    EXPECT_TRUE(governor.OnNotify(0));
+    EXPECT_EQ(VpxQualityGovernor::kLevelReducedPostProc, governor.GetLevel());
+    EXPECT_EQ(2, governor.GetStats().step_ups);
+}
+
+TEST(VpxQualityGovernorTest, RecoversWhenReportsStop)
+{
+    VpxQualityGovernor governor;
+    governor.OnNotify(500 * kMillisecond);
+
+    Frames(governor, VpxQualityGovernor::kQuietFrames);
+    EXPECT_EQ(VpxQualityGovernor::kLevelNoPostProc, governor.GetLevel());
+
+    Frames(governor, 2 * VpxQualityGovernor::kQuietFrames);
+    EXPECT_EQ(VpxQualityGovernor::kLevelFull, governor.GetLevel());
+}
+
+TEST(VpxQualityGovernorTest, DisabledStaysAtFullQuality)
+{
+    VpxQualityGovernor governor;
+    governor.OnNotify(500 * kMillisecond);
+
+    governor.SetEnabled(false);
+    EXPECT_EQ(VpxQualityGovernor::kLevelFull, governor.GetLevel());
+
+    EXPECT_FALSE(governor.OnNotify(500 * kMillisecond));
+    EXPECT_EQ(VpxQualityGovernor::kLevelFull, governor.GetLevel());
+
+    const VpxFrameInfo drop = MakeInfo(true);
+    EXPECT_TRUE(governor.OnFrame(&drop));
+    EXPECT_EQ(2, governor.GetStats().notifications);
+}
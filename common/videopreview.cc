@@ -0,0 +1,194 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "videopreview.h"
+
+#include <cassert>
+#include <system_error>
+
+namespace WebmUtil
+{
+
+void GetPreviewFrameSize(int source_width,
+                         int source_height,
+                         int max_width,
+                         int max_height,
+                         int& out_width,
+                         int& out_height)
+{
+    assert(source_width > 0);
+    assert(source_height > 0);
+
+    long long w = source_width;
+    long long h = source_height;
+
+    if ((max_width > 0) && (w > max_width))
+    {
+        h = h * max_width / w;
+        w = max_width;
+    }
+
+    if ((max_height > 0) && (h > max_height))
+    {
+        w = w * max_height / h;
+        h = max_height;
+    }
+
+    w &= ~1LL;
+    h &= ~1LL;
+
+    out_width = (w < 2) ? 2 : static_cast<int>(w);
+    out_height = (h < 2) ? 2 : static_cast<int>(h);
+}
+
+PreviewPacer::PreviewPacer()
+{
+    Reset(0);
+}
+
+void PreviewPacer::Reset(long long interval)
+{
+    m_interval = (interval < 0) ? 0 : interval;
+    m_first = true;
+    m_next = 0;
+}
+
+bool PreviewPacer::IsDue(long long time)
+{
+    if (m_interval <= 0)
+        return true;
+
+    // A frame that's a little early still counts, so that jitter in the
+    // times doesn't make us skip the frame after it too.
+
+    const long long slack = m_interval / 8;
+
+    if (!m_first && (time + slack < m_next) && (time >= m_next - m_interval))
+        return false;
+
+    if (m_first || (time < m_next - m_interval))  // the times went back
+        m_next = time;
+
+    m_first = false;
+    m_next += m_interval;
+
+    if (m_next <= time)  // there was a gap
+        m_next = time + m_interval;
+
+    return true;
+}
+
+PreviewWorker::PreviewWorker() :
+    m_job(0),
+    m_stop(false),
+    m_dropped(0)
+{
+}
+
+PreviewWorker::~PreviewWorker()
+{
+    Stop();
+}
+
+bool PreviewWorker::Start()
+{
+    assert(!m_thread.joinable());
+
+    m_job = 0;
+    m_stop = false;
+    m_dropped = 0;
+
+    try
+    {
+        m_thread = std::thread(&PreviewWorker::Main, this);
+    }
+    catch (const std::system_error&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+void PreviewWorker::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_cond.notify_all();
+    m_thread.join();
+
+    delete m_job;  // posted, but not yet run
+    m_job = 0;
+}
+
+bool PreviewWorker::IsBusy() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (m_job != 0);
+}
+
+bool PreviewWorker::Post(Job* job)
+{
+    assert(job);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_thread.joinable() && !m_stop && (m_job == 0))
+        {
+            m_job = job;
+            m_cond.notify_all();
+
+            return true;
+        }
+
+        ++m_dropped;
+    }
+
+    delete job;
+    return false;
+}
+
+long long PreviewWorker::GetDropped() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
+
+void PreviewWorker::Main()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        while (!m_stop && (m_job == 0))
+            m_cond.wait(lock);
+
+        if (m_stop)
+            return;
+
+        Job* const job = m_job;
+
+        lock.unlock();
+
+        job->Run();
+        delete job;
+
+        lock.lock();
+
+        m_job = 0;  // idle again
+    }
+}
+
+}  // namespace WebmUtil
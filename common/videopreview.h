@@ -0,0 +1,114 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VIDEOPREVIEW_HPP__
+#define __WEBMDSHOW_COMMON_VIDEOPREVIEW_HPP__
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// The parts of an encoder's preview output that don't depend on DirectShow:
+// the size the preview is shown at, which frames it shows, and the thread
+// that renders them.  A preview is only for a monitor window, so it is
+// scaled down and thinned out, and rendered off the encoding thread; when
+// the preview can't keep up, its frames are dropped rather than making the
+// encoder wait.
+
+namespace WebmUtil
+{
+
+// The size of the preview of a |source_width| by |source_height| source:
+// scaled down (keeping the aspect ratio) to fit within |max_width| by
+// |max_height|, where 0 means no limit, and never larger than the source.
+// The dimensions are rounded down to even numbers, as YV12 needs.
+void GetPreviewFrameSize(int source_width,
+                         int source_height,
+                         int max_width,
+                         int max_height,
+                         int& out_width,
+                         int& out_height);
+
+// Picks the frames to show, so that at most one is shown per interval.
+// The times are those of the frames (any units, as long as the interval
+// is in the same ones).
+class PreviewPacer
+{
+public:
+
+    PreviewPacer();
+
+    // 0 shows every frame.  The next frame is shown.
+    void Reset(long long interval);
+
+    // Called for each frame, in order.
+    bool IsDue(long long time);
+
+private:
+
+    long long m_interval;
+    bool m_first;
+    long long m_next;  // the earliest time of the next frame to show
+
+};
+
+// Runs one preview job at a time on a thread of its own.  Post hands a job
+// to the thread only if the thread is idle; otherwise the job is dropped,
+// so the caller never waits for the preview.
+class PreviewWorker
+{
+    PreviewWorker(const PreviewWorker&);
+    PreviewWorker& operator=(const PreviewWorker&);
+
+public:
+
+    class Job
+    {
+    public:
+        virtual ~Job() {}
+        virtual void Run() = 0;
+    };
+
+    PreviewWorker();
+    ~PreviewWorker();
+
+    // Returns false if the thread could not be created.
+    bool Start();
+
+    // Waits for the job that is running, if there is one.  Whatever the
+    // job is waiting on must be released first.
+    void Stop();
+
+    bool IsBusy() const;
+
+    // Takes ownership of |job|.  Returns false (and deletes the job) if
+    // the worker is busy or isn't running.
+    bool Post(Job* job);
+
+    long long GetDropped() const;
+
+private:
+
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    Job* m_job;  // posted, or running
+    bool m_stop;
+    long long m_dropped;
+
+    void Main();
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_VIDEOPREVIEW_HPP__
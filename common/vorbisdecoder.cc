@@ -32,7 +32,7 @@ namespace WebmMfVorbisDecLib
 
 VorbisDecoder::VorbisDecoder() :
   m_ogg_packet_count(0),
-  m_bytes_per_sample(sizeof(float))
+  m_pcm_offset(0)
 {
     ::memset(&m_vorbis_info, 0, sizeof vorbis_info);
     ::memset(&m_vorbis_comment, 0, sizeof vorbis_comment);
@@ -109,6 +109,10 @@ int VorbisDecoder::CreateDecoder(const BYTE** const ptr_headers,
     assert(m_vorbis_info.rate > 0);
     assert(m_vorbis_info.channels > 0);
 
+    m_pcm.resize(m_vorbis_info.channels);
+    m_pcm_planes.resize(m_vorbis_info.channels);
+    m_pcm_offset = 0;
+
     return S_OK;
 }
 
@@ -151,7 +155,9 @@ void VorbisDecoder::DestroyDecoder()
     // note, from vorbis decoder sample: vorbis_info_clear must be last call
     vorbis_info_clear(&m_vorbis_info);
 
-    m_output_samples.clear();
+    m_pcm.clear();
+    m_pcm_planes.clear();
+    m_pcm_offset = 0;
 }
 
 int VorbisDecoder::Decode(BYTE* ptr_samples, UINT32 length)
@@ -171,11 +177,10 @@ int VorbisDecoder::Decode(BYTE* ptr_samples, UINT32 length)
     if (status != 0)
       return E_FAIL;
 
-    // Consume all PCM samples from libvorbis
-    // Notes:
-    // - channel reordering is performed only when necessary
-    // - all streams w/>2 channels require inteleaving
-    return ReorderAndInterleave_();
+    // Consume all PCM samples from libvorbis.  They're kept as libvorbis
+    // returns them (planar, in the Vorbis channel order) until they're
+    // rendered.
+    return StorePcm_();
 }
 
 int VorbisDecoder::GetOutputSamplesAvailable(UINT32* ptr_num_samples_available)
@@ -183,47 +188,58 @@ int VorbisDecoder::GetOutputSamplesAvailable(UINT32* ptr_num_samples_available)
     if (!ptr_num_samples_available)
         return E_INVALIDARG;
 
-    const pcm_samples_t::size_type samples_size = m_output_samples.size();
-    const UINT32 total_samples_available = static_cast<UINT32>(samples_size);
-    const UINT32 channels = m_vorbis_info.channels;
-
-    if (channels > 1)
+    if (m_pcm.empty())
     {
-        // caller wants the total samples, not the size of the sample vector
-        *ptr_num_samples_available =
-            (total_samples_available + (channels - 1)) / channels;
-    }
-    else
-    {
-        // for mono the size of the samples vector is the number of samples
-        *ptr_num_samples_available = total_samples_available;
+        *ptr_num_samples_available = 0;
+        return S_OK;
     }
 
+    // every channel holds the same number of samples
+    const pcm_samples_t::size_type samples_size = m_pcm[0].size();
+    assert(samples_size >= m_pcm_offset);
+
+    *ptr_num_samples_available =
+        static_cast<UINT32>(samples_size) - m_pcm_offset;
+
     return S_OK;
 }
 
-int VorbisDecoder::ConsumeOutputSamples(float* ptr_out_sample_buffer,
+int VorbisDecoder::ConsumeOutputSamples(VorbisOutput::Renderer render,
+                                        void* ptr_out,
                                         UINT32 blocks_to_consume)
 {
-    if (!ptr_out_sample_buffer || !blocks_to_consume)
+    if (!render || !ptr_out || !blocks_to_consume)
         return E_INVALIDARG;
 
-    if (m_output_samples.empty())
+    UINT32 blocks_available = 0;
+    GetOutputSamplesAvailable(&blocks_available);
+
+    if (blocks_available == 0)
         return MF_E_TRANSFORM_NEED_MORE_INPUT;
 
-    const UINT32 samples_to_consume = blocks_to_consume *
-                                      m_vorbis_info.channels;
+    assert(blocks_to_consume <= blocks_available);
+    if (blocks_to_consume > blocks_available)
+        return E_INVALIDARG;
+
+    const int channels = m_vorbis_info.channels;
+    assert(m_pcm.size() == static_cast<size_t>(channels));
 
-    const UINT32 bytes_to_copy = samples_to_consume * m_bytes_per_sample;
-    ::memcpy(ptr_out_sample_buffer, &m_output_samples[0], bytes_to_copy);
+    for (int channel = 0; channel < channels; ++channel)
+        m_pcm_planes[channel] = &m_pcm[channel][0];
 
-    typedef pcm_samples_t::const_iterator pcm_iterator;
-    pcm_iterator pcm_begin = m_output_samples.begin();
+    render(&m_pcm_planes[0], channels, m_pcm_offset, blocks_to_consume,
+           ptr_out);
 
-    assert(samples_to_consume <= m_output_samples.size());
-    const pcm_iterator pcm_end = pcm_begin + samples_to_consume;
+    m_pcm_offset += blocks_to_consume;
 
-    m_output_samples.erase(pcm_begin, pcm_end);
+    if (m_pcm_offset == m_pcm[0].size())
+    {
+        // everything has been consumed; keep the buffers' capacity
+        for (int channel = 0; channel < channels; ++channel)
+            m_pcm[channel].clear();
+
+        m_pcm_offset = 0;
+    }
 
     return S_OK;
 }
@@ -231,125 +247,42 @@ int VorbisDecoder::ConsumeOutputSamples(float* ptr_out_sample_buffer,
 void VorbisDecoder::Flush()
 {
     vorbis_synthesis_restart(&m_vorbis_state);
-    m_output_samples.clear();
+
+    for (size_t channel = 0; channel < m_pcm.size(); ++channel)
+        m_pcm[channel].clear();
+
+    m_pcm_offset = 0;
 }
 
-void VorbisDecoder::ReorderAndInterleaveBlock_(float** ptr_blocks, int sample)
+int VorbisDecoder::StorePcm_()
 {
-    const int vorbis_channels = m_vorbis_info.channels;
-    assert(vorbis_channels > 0);
-
-    // On channel ordering, from the vorbis spec:
-    // http://xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-800004.3.9
-    // one channel
-    //   the stream is monophonic
-    // two channels
-    //   the stream is stereo. channel order: left, right
-    // three channels
-    //   the stream is a 1d-surround encoding. channel order: left, center,
-    //   right
-    // four channels
-    //   the stream is quadraphonic surround. channel order: front left, front
-    //   right, rear left, rear right
-    // five channels
-    //   the stream is five-channel surround. channel order: front left,
-    //   center, front right, rear left, rear right
-    // six channels
-    //   the stream is 5.1 surround. channel order: front left, center,
-    //   front right, rear left, rear right, LFE
-    // seven channels
-    //   the stream is 6.1 surround. channel order: front left, center,
-    //   front right, side left, side right, rear center, LFE
-    // eight channels
-    //   the stream is 7.1 surround. channel order: front left, center,
-    //   front right, side left, side right, rear left, rear right, LFE
-    // greater than eight channels
-    //   channel use and order is defined by the application
+    const int channels = m_vorbis_info.channels;
+    assert(m_pcm.size() == static_cast<size_t>(channels));
 
-    switch (vorbis_channels)
+    // Drop the samples that have already been consumed, so that the buffers
+    // don't grow.  Usually there are none left to move.
+    if (m_pcm_offset > 0)
     {
-        case 3:
-            m_output_samples.push_back(ptr_blocks[0][sample]); // FL
-            m_output_samples.push_back(ptr_blocks[2][sample]); // FR
-            m_output_samples.push_back(ptr_blocks[1][sample]); // FC
-            break;
-        case 5:
-            m_output_samples.push_back(ptr_blocks[0][sample]); // FL
-            m_output_samples.push_back(ptr_blocks[2][sample]); // FR
-            m_output_samples.push_back(ptr_blocks[1][sample]); // FC
-            m_output_samples.push_back(ptr_blocks[3][sample]); // BL
-            m_output_samples.push_back(ptr_blocks[4][sample]); // BR
-            break;
-        case 6:
-            // WebM Vorbis decode multi-channel ordering
-            // 5.1 Vorbis to PCM (Decoding)
-            // Vorbis                PCM
-            // 0 Front Left   => 0 Front Left
-            // 1 Front Center => 2 Front Right
-            // 2 Front Right  => 1 Front Center
-            // 3 Back Left    => 5 LFE
-            // 4 Back Right   => 3 Back Left
-            // 5 LFE          => 4 Back Right
-            m_output_samples.push_back(ptr_blocks[0][sample]); // FL
-            m_output_samples.push_back(ptr_blocks[2][sample]); // FR
-            m_output_samples.push_back(ptr_blocks[1][sample]); // FC
-            m_output_samples.push_back(ptr_blocks[5][sample]); // LFE
-            m_output_samples.push_back(ptr_blocks[3][sample]); // BL
-            m_output_samples.push_back(ptr_blocks[4][sample]); // BR
-            break;
-        case 7:
-            m_output_samples.push_back(ptr_blocks[0][sample]); // FL
-            m_output_samples.push_back(ptr_blocks[2][sample]); // FR
-            m_output_samples.push_back(ptr_blocks[1][sample]); // FC
-            m_output_samples.push_back(ptr_blocks[6][sample]); // LFE
-            m_output_samples.push_back(ptr_blocks[5][sample]); // BC
-            m_output_samples.push_back(ptr_blocks[3][sample]); // SL
-            m_output_samples.push_back(ptr_blocks[4][sample]); // SR
-            break;
-        case 8:
-            // 7.1 Vorbis to PCM (Decoding)
-            // Vorbis             PCM
-            // 0 Front Left   => 0 Front Left
-            // 1 Front Center => 2 Front Right
-            // 2 Front Right  => 1 Front Center
-            // 3 Side Left    => 7 LFE
-            // 4 Side Right   => 5 Back Left
-            // 5 Back Left    => 6 Back Right
-            // 6 Back Right   => 3 Side Left
-            // 7 LFE          => 4 Side Right
-            m_output_samples.push_back(ptr_blocks[0][sample]); // FL
-            m_output_samples.push_back(ptr_blocks[2][sample]); // FR
-            m_output_samples.push_back(ptr_blocks[1][sample]); // FC
-            m_output_samples.push_back(ptr_blocks[7][sample]); // LFE
-            m_output_samples.push_back(ptr_blocks[5][sample]); // BL
-            m_output_samples.push_back(ptr_blocks[6][sample]); // BR
-            m_output_samples.push_back(ptr_blocks[3][sample]); // SL
-            m_output_samples.push_back(ptr_blocks[4][sample]); // SR
-            break;
-        case 1:
-        case 2:
-        case 4:
-        default:
-            // For mono/stereo/quadrophonic stereo/>8 channels: output in the
-            // order libvorbis uses.  It's correct for the formats named, and
-            // at present the Vorbis spec says streams w/>8 channels have user
-            // defined channel order.
-            for (int channel = 0; channel < vorbis_channels; ++channel)
-                m_output_samples.push_back(ptr_blocks[channel][sample]);
-    }
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            pcm_samples_t& pcm = m_pcm[channel];
+            pcm.erase(pcm.begin(), pcm.begin() + m_pcm_offset);
+        }
 
+        m_pcm_offset = 0;
+    }
 
-}
-
-int VorbisDecoder::ReorderAndInterleave_()
-{
     int samples = 0;
     float** pp_pcm;
     vorbis_dsp_state* const ptr_state = &m_vorbis_state;
     while ((samples = vorbis_synthesis_pcmout(ptr_state, &pp_pcm)) > 0)
     {
-        for (int sample = 0; sample < samples; ++sample)
-            ReorderAndInterleaveBlock_(pp_pcm, sample);
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            const float* const ptr_block = pp_pcm[channel];
+            pcm_samples_t& pcm = m_pcm[channel];
+            pcm.insert(pcm.end(), ptr_block, ptr_block + samples);
+        }
 
         vorbis_synthesis_read(ptr_state, samples);
     }
@@ -10,6 +10,7 @@
 #define _MEDIAFOUNDATION_WEBMMFVORBISDEC_VORBISDECODER_HPP_
 
 #include "vorbis/codec.h"
+#include "vorbisoutput.h"
 
 namespace WebmMfVorbisDecLib
 {
@@ -31,7 +32,12 @@ public:
     int Decode(BYTE* ptr_samples, UINT32 length);
 
     int GetOutputSamplesAvailable(UINT32* ptr_num_samples_available);
-    int ConsumeOutputSamples(float* ptr_out_sample_buffer,
+
+    // Renders |blocks_to_consume| sample blocks into |ptr_out| with |render|
+    // (see VorbisOutput::GetRenderer), which reorders, interleaves, downmixes
+    // and converts them in one pass.
+    int ConsumeOutputSamples(VorbisOutput::Renderer render,
+                             void* ptr_out,
                              UINT32 blocks_to_consume);
     void Flush();
 
@@ -49,8 +55,7 @@ public:
 private:
     int NextOggPacket_(const BYTE* ptr_packet, DWORD packet_size);
 
-    void ReorderAndInterleaveBlock_(float** ptr_blocks, int sample);
-    int ReorderAndInterleave_();
+    int StorePcm_();
 
     ogg_packet m_ogg_packet;
     DWORD m_ogg_packet_count;
@@ -60,12 +65,15 @@ private:
     vorbis_dsp_state m_vorbis_state; // decoder state
     vorbis_block m_vorbis_block; // working space for packet->PCM decode
 
-    const int m_bytes_per_sample;
-
     WAVEFORMATEX m_wave_format;
 
+    // The decoded samples that haven't been consumed yet: one buffer per
+    // channel, in the Vorbis order, as libvorbis returns them.  The reorder
+    // is left to the renderer.
     typedef std::vector<float> pcm_samples_t;
-    pcm_samples_t m_output_samples;
+    std::vector<pcm_samples_t> m_pcm;
+    UINT32 m_pcm_offset;  // sample blocks consumed from the front of |m_pcm|
+    std::vector<const float*> m_pcm_planes;
 
     // disallow copy and assign
     DISALLOW_COPY_AND_ASSIGN(VorbisDecoder);
@@ -0,0 +1,392 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vorbisencodepipeline.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include "pipelinestats.h"
+#include "vorbis/codec.h"
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+// Moves the packets, without copying their data.
+void Append(VorbisEncodePipeline::packets_t& src,
+            VorbisEncodePipeline::packets_t& dst)
+{
+    while (!src.empty())
+    {
+        VorbisEncodePipeline::Packet& p = src.front();
+
+        dst.push_back(VorbisEncodePipeline::Packet());
+        VorbisEncodePipeline::Packet& q = dst.back();
+
+        q.data.swap(p.data);
+        q.granulepos = p.granulepos;
+        q.packetno = p.packetno;
+        q.eos = p.eos;
+
+        src.pop_front();
+    }
+}
+
+}  // namespace
+
+VorbisEncodePipeline::VorbisEncodePipeline()
+    : m_dsp(0),
+      m_block(0),
+      m_channels(0),
+      m_max_pending(0),
+      m_stats(0),
+      m_threaded(false),
+      m_running(false),
+      m_busy(false),
+      m_error(false),
+      m_pending(0)
+{
+}
+
+VorbisEncodePipeline::~VorbisEncodePipeline()
+{
+    Stop();
+
+    while (!m_free.empty())
+    {
+        delete m_free.back();
+        m_free.pop_back();
+    }
+}
+
+bool VorbisEncodePipeline::Start(vorbis_dsp_state* dsp,
+                                 vorbis_block* block,
+                                 int channels,
+                                 bool threaded,
+                                 long max_pending,
+                                 PipelineStats* stats)
+{
+    assert(dsp);
+    assert(block);
+    assert(channels > 0);
+    assert(max_pending > 0);
+    assert(!m_running);
+
+    m_dsp = dsp;
+    m_block = block;
+    m_channels = channels;
+    m_max_pending = max_pending;
+    m_stats = stats;
+
+    m_threaded = threaded;
+    m_running = true;
+    m_busy = false;
+    m_error = false;
+    m_pending = 0;
+
+    if (!m_threaded)
+        return true;
+
+    try
+    {
+        m_thread = std::thread(&VorbisEncodePipeline::Main, this);
+    }
+    catch (const std::system_error&)
+    {
+        m_running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void VorbisEncodePipeline::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_input_cond.notify_all();
+    m_space_cond.notify_all();
+    m_packet_cond.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+    Clear();
+
+    m_dsp = 0;
+    m_block = 0;
+    m_stats = 0;
+}
+
+bool VorbisEncodePipeline::IsThreaded() const
+{
+    return m_threaded;
+}
+
+bool VorbisEncodePipeline::Write(const float* interleaved, long frames)
+{
+    assert(interleaved);
+    assert(frames > 0);
+
+    if (!m_threaded)
+    {
+        if (!m_running || m_error)
+            return false;
+
+        // The caller's buffer goes straight to libvorbis, as it did
+        // before there was a pipeline.
+        if (!Encode(interleaved, frames))
+            m_error = true;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Append(m_encoded, m_packets);
+
+        return !m_error;
+    }
+
+    Chunk* const c = GetChunk();
+
+    if (c == 0)
+        return false;
+
+    const size_t count = static_cast<size_t>(frames) * m_channels;
+
+    c->pcm.assign(interleaved, interleaved + count);
+    c->frames = frames;
+
+    return Queue(c);
+}
+
+bool VorbisEncodePipeline::WriteEnd()
+{
+    if (!m_threaded)
+    {
+        if (!m_running || m_error)
+            return false;
+
+        if (!Encode(0, 0))
+            m_error = true;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Append(m_encoded, m_packets);
+
+        return !m_error;
+    }
+
+    Chunk* const c = GetChunk();
+
+    if (c == 0)
+        return false;
+
+    c->pcm.clear();
+    c->frames = 0;
+
+    return Queue(c);
+}
+
+bool VorbisEncodePipeline::Read(packets_t& packets, bool wait)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (wait)
+    {
+        while (m_running && !m_error && (!m_input.empty() || m_busy))
+            m_packet_cond.wait(lock);
+    }
+
+    Append(m_packets, packets);
+
+    return !m_error;
+}
+
+long VorbisEncodePipeline::GetPendingFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+VorbisEncodePipeline::Chunk* VorbisEncodePipeline::GetChunk()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_running || m_error)
+        return 0;
+
+    if (m_free.empty())
+        return new (std::nothrow) Chunk;
+
+    Chunk* const c = m_free.back();
+    m_free.pop_back();
+
+    return c;
+}
+
+bool VorbisEncodePipeline::Queue(Chunk* c)
+{
+    assert(c);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // A chunk larger than the limit still goes in when the queue is
+    // empty, or it would never go in at all.
+    while (m_running &&
+           !m_error &&
+           (m_pending > 0) &&
+           (m_pending + c->frames > m_max_pending))
+    {
+        m_space_cond.wait(lock);
+    }
+
+    if (!m_running || m_error)
+    {
+        m_free.push_back(c);
+        return false;
+    }
+
+    m_input.push_back(c);
+    m_pending += c->frames;
+
+    lock.unlock();
+    m_input_cond.notify_one();
+
+    return true;
+}
+
+void VorbisEncodePipeline::Main()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        while (m_running && m_input.empty())
+            m_input_cond.wait(lock);
+
+        if (!m_running)
+            return;
+
+        Chunk* const c = m_input.front();
+        m_input.pop_front();
+
+        m_pending -= c->frames;
+        m_busy = true;
+
+        m_space_cond.notify_all();
+
+        lock.unlock();
+
+        const bool ok = Encode(c->frames ? &c->pcm[0] : 0, c->frames);
+
+        lock.lock();
+
+        m_free.push_back(c);
+        m_busy = false;
+
+        Append(m_encoded, m_packets);
+
+        if (!ok)
+            m_error = true;
+
+        m_packet_cond.notify_all();
+
+        if (!ok)
+        {
+            m_space_cond.notify_all();  // a waiting Write fails now
+            return;
+        }
+    }
+}
+
+bool VorbisEncodePipeline::Encode(const float* interleaved, long frames)
+{
+    assert(m_dsp);
+    assert(m_block);
+
+    if (frames > 0)
+    {
+        float** const dst = vorbis_analysis_buffer(m_dsp, frames);
+
+        if (dst == 0)
+            return false;
+
+        const float* src = interleaved;
+
+        for (long i = 0; i < frames; ++i)
+            for (int channel = 0; channel < m_channels; ++channel)
+            {
+                memcpy(dst[channel] + i, src, sizeof(float));
+                ++src;
+            }
+
+        if (vorbis_analysis_wrote(m_dsp, frames) != 0)
+            return false;
+    }
+    else if (vorbis_analysis_wrote(m_dsp, 0) != 0)  // means "EOS"
+        return false;
+
+    for (;;)
+    {
+        int status = vorbis_analysis_blockout(m_dsp, m_block);
+
+        if (status < 0)
+            return false;
+
+        if (status == 0)  // no block available
+            return true;
+
+        ogg_packet pkt;
+
+        if (m_stats)
+        {
+            const PipelineStats::Timer timer(*m_stats);
+            status = vorbis_analysis(m_block, &pkt);
+        }
+        else
+            status = vorbis_analysis(m_block, &pkt);
+
+        if (status != 0)
+            return false;
+
+        m_encoded.push_back(Packet());
+        Packet& p = m_encoded.back();
+
+        p.data.assign(pkt.packet, pkt.packet + pkt.bytes);
+        p.granulepos = pkt.granulepos;
+        p.packetno = pkt.packetno;
+        p.eos = (pkt.e_o_s != 0);
+
+        if (p.eos)
+            return true;
+    }
+}
+
+void VorbisEncodePipeline::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    while (!m_input.empty())
+    {
+        m_free.push_back(m_input.front());
+        m_input.pop_front();
+    }
+
+    m_pending = 0;
+    m_packets.clear();
+    m_encoded.clear();
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,155 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VORBISENCODEPIPELINE_HPP__
+#define __WEBMDSHOW_COMMON_VORBISENCODEPIPELINE_HPP__
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct vorbis_dsp_state;
+struct vorbis_block;
+
+// Runs libvorbis analysis (vorbis_analysis_buffer and _wrote, and the
+// vorbis_analysis_blockout/vorbis_analysis loop) on a worker thread, so
+// that the thread that delivers the PCM only has to copy it into a queue.
+//
+// The blocks themselves can't be analyzed in parallel, not if the packets
+// are to be the same as the serial encoder's: vorbis_analysis_blockout
+// folds the peak amplitude that the analysis of the previous block found
+// into the global psychoacoustic state, and that state shapes the noise
+// masking of the next block.  So there is exactly one worker, and it makes
+// the same libvorbis calls, on the same chunks of input, in the same order
+// as the serial loop did; the packets are identical by construction.
+// What the worker buys is overlap: the analysis runs alongside whatever
+// the delivering thread does upstream, and alongside the delivery of the
+// packets downstream.
+//
+// Without a thread (Start's threaded argument is false), Write encodes
+// before it returns, which is how the encoder behaved before it had a
+// pipeline.
+//
+// Input is bounded: Write waits while more than max_pending frames are
+// queued.  The packets are kept until Read takes them.
+
+namespace WebmUtil
+{
+
+class PipelineStats;
+
+class VorbisEncodePipeline
+{
+    VorbisEncodePipeline(const VorbisEncodePipeline&);
+    VorbisEncodePipeline& operator=(const VorbisEncodePipeline&);
+
+public:
+
+    // A copy of an ogg_packet (whose data belongs to the vorbis_block, and
+    // is overwritten by the next analysis).
+    struct Packet
+    {
+        std::vector<unsigned char> data;
+        long long granulepos;
+        long long packetno;
+        bool eos;
+    };
+
+    typedef std::deque<Packet> packets_t;
+
+    VorbisEncodePipeline();
+    ~VorbisEncodePipeline();
+
+    // Starts encoding with |dsp| and |block|, which the caller has set up
+    // (vorbis_analysis_init and vorbis_block_init), and must not touch
+    // again until Stop returns.  If |stats| isn't null, each analysis is
+    // timed on it, from whichever thread makes it.  Returns false if the
+    // worker could not be started.
+    bool Start(vorbis_dsp_state* dsp,
+               vorbis_block* block,
+               int channels,
+               bool threaded,
+               long max_pending,
+               PipelineStats* stats);
+
+    // Discards the queued input and the packets not yet read, and waits
+    // for the worker to exit.  A Write that is waiting returns false.
+    void Stop();
+
+    bool IsThreaded() const;
+
+    // Queues |frames| interleaved frames of float PCM.  Returns false if
+    // the pipeline isn't running, or libvorbis failed.
+    bool Write(const float* interleaved, long frames);
+
+    // Signals the end of the stream; the last packet has eos set.
+    bool WriteEnd();
+
+    // Moves the packets encoded so far to the end of |packets|.  With
+    // |wait|, first waits until all of the input written so far has been
+    // encoded (after WriteEnd, that includes the eos packet).  Returns
+    // false if libvorbis failed.
+    bool Read(packets_t& packets, bool wait);
+
+    // The number of frames queued but not yet given to libvorbis.
+    long GetPendingFrames() const;
+
+private:
+
+    struct Chunk
+    {
+        std::vector<float> pcm;  // interleaved
+        long frames;             // 0 means end of stream
+    };
+
+    typedef std::deque<Chunk*> chunks_t;
+
+    vorbis_dsp_state* m_dsp;
+    vorbis_block* m_block;
+    int m_channels;
+    long m_max_pending;
+    PipelineStats* m_stats;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_input_cond;   // worker waits for input
+    std::condition_variable m_space_cond;   // Write waits for room
+    std::condition_variable m_packet_cond;  // Read waits for the worker
+
+    std::thread m_thread;
+    bool m_threaded;
+    bool m_running;
+    bool m_busy;   // the worker has a chunk out of the queue
+    bool m_error;
+
+    chunks_t m_input;
+    long m_pending;  // frames in m_input
+    std::vector<Chunk*> m_free;
+
+    packets_t m_packets;
+    packets_t m_encoded;  // worker-side, moved to m_packets under the lock
+
+    Chunk* GetChunk();
+    bool Queue(Chunk*);
+    void Main();
+
+    // Hands the frames (none, for the end of the stream) to libvorbis,
+    // and collects the packets it produces into m_encoded.  This is the
+    // serial encoder loop; only one thread ever runs it.
+    bool Encode(const float* interleaved, long frames);
+
+    void Clear();
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_VORBISENCODEPIPELINE_HPP__
@@ -0,0 +1,408 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vorbisoutput.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || \
+    defined(__SSE2__)
+#define VORBISOUTPUT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace WebmMfVorbisDecLib
+{
+namespace VorbisOutput
+{
+namespace
+{
+
+// For each channel count, the Vorbis channel that goes to each position in
+// the WAVE order.  On channel ordering, from the Vorbis spec:
+// http://xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-800004.3.9
+const int kVorbisChannel[9][8] =
+{
+    { 0 },
+    { 0 },
+    { 0, 1 },                   // L R
+    { 0, 2, 1 },                // FL FR FC
+    { 0, 1, 2, 3 },             // FL FR BL BR
+    { 0, 2, 1, 3, 4 },          // FL FR FC BL BR
+    { 0, 2, 1, 5, 3, 4 },       // FL FR FC LFE BL BR
+    { 0, 2, 1, 6, 5, 3, 4 },    // FL FR FC LFE BC SL SR
+    { 0, 2, 1, 7, 5, 6, 3, 4 }  // FL FR FC LFE BL BR SL SR
+};
+
+// The level at which the center and surround channels are mixed into left
+// and right when downmixing to stereo.
+const float kMixLevel = 0.7f;
+
+// A mixer takes a frame in the WAVE order and produces an output frame.
+// The mixers are templates so that the scalar path (T is float) and the
+// SSE2 path (T is Vec4, four frames at a time) share the arithmetic, and so
+// give the same results.
+
+template <int kChannels>
+struct Copy
+{
+    enum { kIn = kChannels, kOut = kChannels };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        for (int i = 0; i < kChannels; ++i)
+            d[i] = s[i];
+    }
+};
+
+// Folds 6.1 or 7.1 to 5.1 by keeping the first six channels.
+template <int kChannels>
+struct Fold51
+{
+    enum { kIn = kChannels, kOut = 6 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        for (int i = 0; i < kOut; ++i)
+            d[i] = s[i];
+    }
+};
+
+template <int kChannels>
+struct Downmix;
+
+template <>
+struct Downmix<3>
+{
+    enum { kIn = 3, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[2] * kMixLevel;
+        d[1] = s[1] + s[2] * kMixLevel;
+    }
+};
+
+template <>
+struct Downmix<4>
+{
+    enum { kIn = 4, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[2] * kMixLevel + s[3] * kMixLevel;
+        d[1] = s[1] + s[2] * kMixLevel + s[3] * kMixLevel;
+    }
+};
+
+template <>
+struct Downmix<5>
+{
+    enum { kIn = 5, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[2] * kMixLevel + s[3] * kMixLevel;
+        d[1] = s[1] + s[2] * kMixLevel + s[4] * kMixLevel;
+    }
+};
+
+template <>
+struct Downmix<6>
+{
+    enum { kIn = 6, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[3] + s[2] * kMixLevel + s[4] * kMixLevel;
+        d[1] = s[1] + s[3] + s[2] * kMixLevel + s[5] * kMixLevel;
+    }
+};
+
+template <>
+struct Downmix<7>
+{
+    enum { kIn = 7, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[3] + s[2] * kMixLevel + s[4] * kMixLevel +
+               s[6] * kMixLevel;
+        d[1] = s[1] + s[3] + s[2] * kMixLevel + s[5] * kMixLevel +
+               s[6] * kMixLevel;
+    }
+};
+
+template <>
+struct Downmix<8>
+{
+    enum { kIn = 8, kOut = 2 };
+
+    template <typename T>
+    static void Mix(const T* s, T* d)
+    {
+        d[0] = s[0] + s[3] + s[2] * kMixLevel + s[4] * kMixLevel +
+               s[6] * kMixLevel;
+        d[1] = s[1] + s[3] + s[2] * kMixLevel + s[5] * kMixLevel +
+               s[7] * kMixLevel;
+    }
+};
+
+inline void Convert(float x, float* ptr_out)
+{
+    *ptr_out = x;
+}
+
+inline void Convert(float x, short* ptr_out)
+{
+    const float t = x * 32767.f + .5f;
+
+    if (!(t >= -32768.f))  // also catches NaN
+        *ptr_out = -32768;
+    else if (t >= 32767.f)
+        *ptr_out = 32767;
+    else
+        *ptr_out = static_cast<short>(std::floor(t));
+}
+
+#ifdef VORBISOUTPUT_SSE2
+
+struct Vec4
+{
+    __m128 v;
+};
+
+inline Vec4 operator+(const Vec4& a, const Vec4& b)
+{
+    const Vec4 r = { _mm_add_ps(a.v, b.v) };
+    return r;
+}
+
+inline Vec4 operator*(const Vec4& a, float b)
+{
+    const Vec4 r = { _mm_mul_ps(a.v, _mm_set1_ps(b)) };
+    return r;
+}
+
+// Convert(float, short*) for four samples, before the narrowing.
+inline __m128i ToInt32(__m128 x)
+{
+    __m128 t = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(32767.f)),
+                          _mm_set1_ps(.5f));
+
+    // MAXPS returns its second operand when the first is NaN, so NaN
+    // becomes -32768 here too.
+    t = _mm_max_ps(t, _mm_set1_ps(-32768.f));
+    t = _mm_min_ps(t, _mm_set1_ps(32767.f));
+
+    // SSE2 has no floor: truncate, then step down where truncation rounded
+    // up (the comparison mask is -1 in those lanes).
+    const __m128i i = _mm_cvttps_epi32(t);
+    const __m128 up = _mm_cmplt_ps(t, _mm_cvtepi32_ps(i));
+
+    return _mm_add_epi32(i, _mm_castps_si128(up));
+}
+
+// Writes four output frames, interleaved.
+template <int kChannels>
+struct Writer
+{
+    static void Write(const Vec4* out, float* ptr_out)
+    {
+        float lanes[kChannels][4];
+
+        for (int c = 0; c < kChannels; ++c)
+            _mm_storeu_ps(lanes[c], out[c].v);
+
+        for (int i = 0; i < 4; ++i)
+            for (int c = 0; c < kChannels; ++c)
+                *ptr_out++ = lanes[c][i];
+    }
+
+    static void Write(const Vec4* out, short* ptr_out)
+    {
+        short lanes[kChannels][8];
+
+        for (int c = 0; c < kChannels; ++c)
+        {
+            const __m128i i = ToInt32(out[c].v);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[c]),
+                             _mm_packs_epi32(i, i));
+        }
+
+        for (int i = 0; i < 4; ++i)
+            for (int c = 0; c < kChannels; ++c)
+                *ptr_out++ = lanes[c][i];
+    }
+};
+
+// Stereo is the common case, and interleaves without going through memory.
+template <>
+struct Writer<2>
+{
+    static void Write(const Vec4* out, float* ptr_out)
+    {
+        _mm_storeu_ps(ptr_out, _mm_unpacklo_ps(out[0].v, out[1].v));
+        _mm_storeu_ps(ptr_out + 4, _mm_unpackhi_ps(out[0].v, out[1].v));
+    }
+
+    static void Write(const Vec4* out, short* ptr_out)
+    {
+        const __m128i left = ToInt32(out[0].v);
+        const __m128i right = ToInt32(out[1].v);
+
+        const __m128i lo = _mm_unpacklo_epi32(left, right);
+        const __m128i hi = _mm_unpackhi_epi32(left, right);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr_out),
+                         _mm_packs_epi32(lo, hi));
+    }
+};
+
+#endif  // VORBISOUTPUT_SSE2
+
+template <class Mixer, typename Sample>
+void Render(const float* const* planes,
+            int channels,
+            int offset,
+            int frames,
+            void* ptr_out)
+{
+    enum { kIn = Mixer::kIn, kOut = Mixer::kOut };
+
+    assert(channels == kIn);
+#ifdef NDEBUG
+    (void)channels;  // only checked by the assert
+#endif
+
+    const float* src[kIn];
+
+    for (int c = 0; c < kIn; ++c)
+        src[c] = planes[kVorbisChannel[kIn][c]] + offset;
+
+    Sample* dst = static_cast<Sample*>(ptr_out);
+    int i = 0;
+
+#ifdef VORBISOUTPUT_SSE2
+    for (; i + 4 <= frames; i += 4)
+    {
+        Vec4 in[kIn];
+
+        for (int c = 0; c < kIn; ++c)
+            in[c].v = _mm_loadu_ps(src[c] + i);
+
+        Vec4 out[kOut];
+        Mixer::Mix(in, out);
+
+        Writer<kOut>::Write(out, dst);
+        dst += 4 * kOut;
+    }
+#endif
+
+    for (; i < frames; ++i)
+    {
+        float in[kIn];
+
+        for (int c = 0; c < kIn; ++c)
+            in[c] = src[c][i];
+
+        float out[kOut];
+        Mixer::Mix(in, out);
+
+        for (int c = 0; c < kOut; ++c)
+            Convert(out[c], dst++);
+    }
+}
+
+// More than 8 channels: the order is up to the application, so the
+// channels are only interleaved (and converted).
+template <typename Sample>
+void RenderAny(const float* const* planes,
+               int channels,
+               int offset,
+               int frames,
+               void* ptr_out)
+{
+    Sample* dst = static_cast<Sample*>(ptr_out);
+
+    for (int i = offset; i < offset + frames; ++i)
+        for (int c = 0; c < channels; ++c)
+            Convert(planes[c][i], dst++);
+}
+
+struct Entry
+{
+    int channels_in;
+    int channels_out;
+    Renderer renderers[2];  // by SampleFormat
+};
+
+const Entry kEntries[] =
+{
+    { 1, 1, { &Render<Copy<1>, float>, &Render<Copy<1>, short> } },
+    { 2, 2, { &Render<Copy<2>, float>, &Render<Copy<2>, short> } },
+    { 3, 3, { &Render<Copy<3>, float>, &Render<Copy<3>, short> } },
+    { 4, 4, { &Render<Copy<4>, float>, &Render<Copy<4>, short> } },
+    { 5, 5, { &Render<Copy<5>, float>, &Render<Copy<5>, short> } },
+    { 6, 6, { &Render<Copy<6>, float>, &Render<Copy<6>, short> } },
+    { 7, 7, { &Render<Copy<7>, float>, &Render<Copy<7>, short> } },
+    { 8, 8, { &Render<Copy<8>, float>, &Render<Copy<8>, short> } },
+    { 3, 2, { &Render<Downmix<3>, float>, &Render<Downmix<3>, short> } },
+    { 4, 2, { &Render<Downmix<4>, float>, &Render<Downmix<4>, short> } },
+    { 5, 2, { &Render<Downmix<5>, float>, &Render<Downmix<5>, short> } },
+    { 6, 2, { &Render<Downmix<6>, float>, &Render<Downmix<6>, short> } },
+    { 7, 2, { &Render<Downmix<7>, float>, &Render<Downmix<7>, short> } },
+    { 8, 2, { &Render<Downmix<8>, float>, &Render<Downmix<8>, short> } },
+    { 7, 6, { &Render<Fold51<7>, float>, &Render<Fold51<7>, short> } },
+    { 8, 6, { &Render<Fold51<8>, float>, &Render<Fold51<8>, short> } }
+};
+
+}  // namespace
+
+Renderer GetRenderer(int channels_in, int channels_out, SampleFormat format)
+{
+    if (format != kFloat && format != kInt16)
+        return NULL;
+
+    if (channels_in > 8 && channels_out == channels_in)
+    {
+        if (format == kFloat)
+            return &RenderAny<float>;
+        else
+            return &RenderAny<short>;
+    }
+
+    const size_t count = sizeof(kEntries) / sizeof(kEntries[0]);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Entry& e = kEntries[i];
+
+        if (e.channels_in == channels_in && e.channels_out == channels_out)
+            return e.renderers[format];
+    }
+
+    return NULL;
+}
+
+int GetSampleSize(SampleFormat format)
+{
+    return (format == kFloat) ? sizeof(float) : sizeof(short);
+}
+
+}  // namespace VorbisOutput
+}  // namespace WebmMfVorbisDecLib
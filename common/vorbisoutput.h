@@ -0,0 +1,63 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VORBISOUTPUT_HPP__
+#define __WEBMDSHOW_COMMON_VORBISOUTPUT_HPP__
+
+#pragma once
+
+namespace WebmMfVorbisDecLib
+{
+
+// The output stage of the Vorbis decoder.  libvorbis returns one buffer of
+// float samples per channel, in the Vorbis channel order.  A renderer takes
+// frames from those buffers and, in a single pass:
+// - reorders the channels into the WAVE order (see
+//   VorbisDecoder::GetChannelMask),
+// - interleaves them,
+// - downmixes to stereo, or folds to 5.1, when there are fewer output
+//   channels than input channels,
+// - and clamps and converts to 16-bit PCM when the output isn't float.
+//
+// There is one renderer per combination of input channels, output
+// channels, and sample format that the decoder supports.  Each is
+// specialized at compile time, and processes four frames at a time with
+// SSE2 where it is available.  The result is the same either way, and the
+// same as the separate reorder and post-processing passes that the decoder
+// used to make.
+namespace VorbisOutput
+{
+
+enum SampleFormat
+{
+    kFloat,  // 32-bit IEEE float
+    kInt16   // 16-bit PCM
+};
+
+// |planes| holds |channels| buffers, in the Vorbis order.  |frames| frames
+// are rendered from |offset| into |ptr_out|.
+typedef void (*Renderer)(const float* const* planes,
+                         int channels,
+                         int offset,
+                         int frames,
+                         void* ptr_out);
+
+// Returns NULL if the combination isn't supported.  Any channel count can be
+// rendered without a downmix (channels in the order libvorbis uses when
+// there are more than 8); the downmixes are 3 to 8 channels to stereo, and 7
+// or 8 channels to 5.1.
+Renderer GetRenderer(int channels_in, int channels_out, SampleFormat format);
+
+// Returns the size of one output sample of |format|.
+int GetSampleSize(SampleFormat format);
+
+}  // namespace VorbisOutput
+
+}  // namespace WebmMfVorbisDecLib
+
+#endif  // __WEBMDSHOW_COMMON_VORBISOUTPUT_HPP__
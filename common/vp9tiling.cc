@@ -0,0 +1,93 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vp9tiling.h"
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+const int kMinTileWidthSb64 = 4;
+const int kMaxTileWidthSb64 = 64;
+
+// The width of the frame in 64x64 superblocks, rounded up as libvpx does
+// (through 8x8 mode info units).
+int GetSb64Columns(int width)
+{
+    if (width <= 0)
+        return 0;
+
+    const int mi_cols = (width + 7) >> 3;
+    return (mi_cols + 7) >> 3;
+}
+
+}  // namespace
+
+int GetVP9MinLog2TileColumns(int width)
+{
+    const int sb64_cols = GetSb64Columns(width);
+
+    int min_log2 = 0;
+
+    while ((kMaxTileWidthSb64 << min_log2) < sb64_cols)
+        ++min_log2;
+
+    return min_log2;
+}
+
+int GetVP9MaxLog2TileColumns(int width)
+{
+    const int sb64_cols = GetSb64Columns(width);
+
+    int max_log2 = 1;
+
+    while ((sb64_cols >> max_log2) >= kMinTileWidthSb64)
+        ++max_log2;
+
+    --max_log2;
+
+    return (max_log2 > kVP9MaxLog2TileColumns) ?
+           kVP9MaxLog2TileColumns :
+           max_log2;
+}
+
+int GetVP9AutoLog2TileColumns(int width, int threads)
+{
+    // Round up, so that with (say) 3 threads each one has a column,
+    // rather than one of them having nothing to do.
+    int log2 = 0;
+
+    while ((1 << log2) < threads)
+        ++log2;
+
+    const int min_log2 = GetVP9MinLog2TileColumns(width);
+
+    if (log2 < min_log2)
+        return min_log2;
+
+    const int max_log2 = GetVP9MaxLog2TileColumns(width);
+
+    if (log2 > max_log2)
+        return max_log2;
+
+    return log2;
+}
+
+int GetVP9AutoThreadCount(int width, int processors)
+{
+    if (processors <= 1)
+        return 1;
+
+    const int columns = 1 << GetVP9MaxLog2TileColumns(width);
+
+    return (processors < columns) ? processors : columns;
+}
+
+}  // namespace WebmUtil
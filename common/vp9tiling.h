@@ -0,0 +1,51 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VP9TILING_HPP__
+#define __WEBMDSHOW_COMMON_VP9TILING_HPP__
+
+#pragma once
+
+// The "auto" settings of the VP9 encoder's tile columns and thread count.
+//
+// The VP9 encoder threads across tile columns: each column of a frame is
+// encoded by one thread, so threads beyond the number of columns sit idle,
+// and an encode with one column (libvpx's default) runs on one thread no
+// matter what g_threads says.  How many columns a frame can have depends on
+// its width: a column is between 4 and 64 superblocks (256 and 4096
+// pixels) wide.  Tile columns are expressed as log2, as VP9E_SET_TILE_COLUMNS
+// takes them.
+//
+// These mirror the limits in libvpx (vp9_tile_common.c), which clamps the
+// setting to them anyway; they are here so that the auto settings agree
+// with what the encoder will actually do.
+
+namespace WebmUtil
+{
+
+enum
+{
+    kVP9MaxLog2TileColumns = 6  // 64 columns
+};
+
+// The smallest and largest tile column settings for a frame |width|
+// pixels wide.
+int GetVP9MinLog2TileColumns(int width);
+int GetVP9MaxLog2TileColumns(int width);
+
+// The tile column setting for an encode with |threads| threads: enough
+// columns for each thread to have one, as far as the width allows.
+int GetVP9AutoLog2TileColumns(int width, int threads);
+
+// The number of threads worth asking for: one per column that the width
+// allows, but no more than there are |processors|.
+int GetVP9AutoThreadCount(int width, int processors);
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_VP9TILING_HPP__
@@ -0,0 +1,768 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vpxframeparser.h"
+
+#include <cassert>
+#include <cstring>
+
+// Droppable frames: a frame is reported as droppable only when skipping it
+// cannot change how any later frame decodes.  Besides the reference buffers
+// that means the entropy context, and (because they persist too) the
+// segmentation and loop filter delta state.  This is stricter than libvpx's
+// VPX_FRAME_IS_DROPPABLE, which only looks at the reference buffers, but it
+// matches what the encoder produces for the droppable layers of a temporally
+// scalable stream (see VP8_EFLAG_NO_UPD_ENTROPY).
+
+namespace WebmUtil
+{
+
+namespace
+{
+
+// VP8 bool decoder, as described in RFC 6386 section 7.
+class BoolDecoder
+{
+public:
+    BoolDecoder(const unsigned char* ptr_data, long length) :
+        ptr_(ptr_data),
+        end_(ptr_data + length),
+        value_(0),
+        range_(255),
+        bit_count_(0),
+        past_end_(0)
+    {
+        value_ = ReadByte() << 8;
+        value_ |= ReadByte();
+    }
+
+    int ReadBool(int prob)
+    {
+        const unsigned int split = 1 + (((range_ - 1) * prob) >> 8);
+        const unsigned int big_split = split << 8;
+
+        int bit;
+
+        if (value_ >= big_split)
+        {
+            bit = 1;
+            range_ -= split;
+            value_ -= big_split;
+        }
+        else
+        {
+            bit = 0;
+            range_ = split;
+        }
+
+        while (range_ < 128)
+        {
+            value_ <<= 1;
+            range_ <<= 1;
+
+            if (++bit_count_ == 8)
+            {
+                bit_count_ = 0;
+                value_ |= ReadByte();
+            }
+        }
+
+        return bit;
+    }
+
+    bool ReadFlag()
+    {
+        return ReadBool(128) != 0;
+    }
+
+    unsigned int ReadLiteral(int bits)
+    {
+        unsigned int val = 0;
+
+        while (bits-- > 0)
+            val = (val << 1) | ReadBool(128);
+
+        return val;
+    }
+
+    // Reads an optional, signed, field, and discards it.
+    bool SkipOptionalSigned(int bits)
+    {
+        if (!ReadFlag())
+            return false;
+
+        ReadLiteral(bits);
+        ReadFlag();  // sign
+
+        return true;
+    }
+
+    // The decoder reads two bytes ahead of what has been decoded, so it is
+    // only an error if it has gone further than that past the end.
+    bool Overrun() const
+    {
+        return past_end_ > 2;
+    }
+
+private:
+    unsigned int ReadByte()
+    {
+        if (ptr_ < end_)
+            return *ptr_++;
+
+        ++past_end_;
+        return 0;
+    }
+
+    const unsigned char* ptr_;
+    const unsigned char* const end_;
+    unsigned int value_;
+    unsigned int range_;
+    int bit_count_;
+    int past_end_;
+};
+
+// MSB-first reader for the VP9 uncompressed header.
+class BitReader
+{
+public:
+    BitReader(const unsigned char* ptr_data, long length) :
+        ptr_(ptr_data),
+        length_(length),
+        bit_offset_(0),
+        overrun_(false)
+    {
+    }
+
+    unsigned int Read(int bits)
+    {
+        unsigned int val = 0;
+
+        while (bits-- > 0)
+        {
+            const long byte_offset = bit_offset_ >> 3;
+
+            int bit = 0;
+
+            if (byte_offset < length_)
+                bit = (ptr_[byte_offset] >> (7 - (bit_offset_ & 7))) & 1;
+            else
+                overrun_ = true;
+
+            ++bit_offset_;
+            val = (val << 1) | bit;
+        }
+
+        return val;
+    }
+
+    bool ReadFlag()
+    {
+        return Read(1) != 0;
+    }
+
+    bool Overrun() const
+    {
+        return overrun_;
+    }
+
+private:
+    const unsigned char* const ptr_;
+    const long length_;
+    long bit_offset_;
+    bool overrun_;
+};
+
+void ResetInfo(int codec, VpxFrameInfo& info)
+{
+    memset(&info, 0, sizeof info);
+    info.codec = codec;
+    info.frames = 1;
+}
+
+bool ReadVP9SyncCode(BitReader& reader)
+{
+    return (reader.Read(8) == 0x49) &&
+           (reader.Read(8) == 0x83) &&
+           (reader.Read(8) == 0x42);
+}
+
+bool ReadVP9ColorConfig(BitReader& reader, int profile)
+{
+    enum { kColorSpaceSRGB = 7 };
+
+    if (profile >= 2)
+        reader.Read(1);  // ten_or_twelve_bit
+
+    const unsigned int color_space = reader.Read(3);
+
+    if (color_space != kColorSpaceSRGB)
+    {
+        reader.Read(1);  // color_range
+
+        if ((profile == 1) || (profile == 3))
+        {
+            reader.Read(2);  // subsampling_x, subsampling_y
+
+            if (reader.ReadFlag())  // reserved_zero
+                return false;
+        }
+    }
+    else if ((profile == 1) || (profile == 3))
+    {
+        if (reader.ReadFlag())  // reserved_zero
+            return false;
+    }
+    else
+    {
+        return false;  // sRGB requires 4:4:4, which profile 0 and 2 lack
+    }
+
+    return true;
+}
+
+void ReadVP9FrameSize(BitReader& reader, int& width, int& height)
+{
+    width = reader.Read(16) + 1;
+    height = reader.Read(16) + 1;
+}
+
+void SkipVP9RenderSize(BitReader& reader)
+{
+    if (reader.ReadFlag())  // render_and_frame_size_different
+        reader.Read(32);
+}
+
+// Returns true if the loop filter deltas are updated.
+bool ReadVP9LoopFilter(BitReader& reader)
+{
+    reader.Read(6);  // filter_level
+    reader.Read(3);  // sharpness
+
+    bool update = false;
+
+    if (reader.ReadFlag())  // mode_ref_delta_enabled
+    {
+        if (reader.ReadFlag())  // mode_ref_delta_update
+        {
+            for (int i = 0; i < 4 + 2; ++i)  // 4 ref deltas, 2 mode deltas
+            {
+                if (reader.ReadFlag())
+                {
+                    reader.Read(6 + 1);  // su(6)
+                    update = true;
+                }
+            }
+        }
+    }
+
+    return update;
+}
+
+void SkipVP9Quantization(BitReader& reader)
+{
+    reader.Read(8);  // base_q_idx
+
+    for (int i = 0; i < 3; ++i)  // delta_q_y_dc, delta_q_uv_dc, delta_q_uv_ac
+    {
+        if (reader.ReadFlag())
+            reader.Read(4 + 1);  // su(4)
+    }
+}
+
+// Returns true if the segmentation map or feature data is updated.
+bool ReadVP9Segmentation(BitReader& reader)
+{
+    if (!reader.ReadFlag())  // segmentation_enabled
+        return false;
+
+    bool update = false;
+
+    if (reader.ReadFlag())  // update_map
+    {
+        update = true;
+
+        for (int i = 0; i < 7; ++i)  // tree probs
+        {
+            if (reader.ReadFlag())
+                reader.Read(8);
+        }
+
+        if (reader.ReadFlag())  // temporal_update
+        {
+            for (int i = 0; i < 3; ++i)  // pred probs
+            {
+                if (reader.ReadFlag())
+                    reader.Read(8);
+            }
+        }
+    }
+
+    if (reader.ReadFlag())  // update_data
+    {
+        update = true;
+
+        reader.Read(1);  // abs_or_delta_update
+
+        static const int kFeatureBits[4] = { 8, 6, 2, 0 };
+        static const bool kFeatureSigned[4] = { true, true, false, false };
+
+        for (int segment = 0; segment < 8; ++segment)
+        {
+            for (int feature = 0; feature < 4; ++feature)
+            {
+                if (!reader.ReadFlag())  // feature_enabled
+                    continue;
+
+                reader.Read(kFeatureBits[feature]);
+
+                if (kFeatureSigned[feature])
+                    reader.Read(1);
+            }
+        }
+    }
+
+    return update;
+}
+
+// Parses a single (not super) frame.
+int ParseVP9SingleFrame(const unsigned char* ptr_data,
+                        long length,
+                        VpxFrameInfo& info)
+{
+    ResetInfo(kVpxCodecVP9, info);
+
+    if (length <= 0)
+        return kVpxParseTruncated;
+
+    BitReader reader(ptr_data, length);
+
+    if (reader.Read(2) != 2)  // frame_marker
+        return kVpxParseCorrupt;
+
+    int profile = reader.Read(1);
+    profile |= reader.Read(1) << 1;
+
+    if ((profile == 3) && reader.ReadFlag())  // reserved_zero
+        return kVpxParseCorrupt;
+
+    info.profile = profile;
+
+    if (reader.ReadFlag())  // show_existing_frame
+    {
+        reader.Read(3);  // frame_to_show_map_idx
+
+        info.show_existing = true;
+        info.show_frame = true;
+        info.droppable = true;
+
+        return reader.Overrun() ? kVpxParseTruncated : kVpxParseOk;
+    }
+
+    info.key = !reader.ReadFlag();  // frame_type
+    info.show_frame = reader.ReadFlag();
+
+    const bool error_resilient = reader.ReadFlag();
+
+    unsigned int reset_frame_context = 0;
+
+    if (info.key)
+    {
+        if (!ReadVP9SyncCode(reader))
+            return kVpxParseCorrupt;
+
+        if (!ReadVP9ColorConfig(reader, profile))
+            return kVpxParseCorrupt;
+
+        ReadVP9FrameSize(reader, info.width, info.height);
+        SkipVP9RenderSize(reader);
+
+        info.refresh_flags = 0xFF;
+    }
+    else
+    {
+        if (!info.show_frame)
+            info.intra_only = reader.ReadFlag();
+
+        if (!error_resilient)
+            reset_frame_context = reader.Read(2);
+
+        if (info.intra_only)
+        {
+            if (!ReadVP9SyncCode(reader))
+                return kVpxParseCorrupt;
+
+            if ((profile > 0) && !ReadVP9ColorConfig(reader, profile))
+                return kVpxParseCorrupt;
+
+            info.refresh_flags = reader.Read(8);
+
+            ReadVP9FrameSize(reader, info.width, info.height);
+            SkipVP9RenderSize(reader);
+        }
+        else
+        {
+            info.refresh_flags = reader.Read(8);
+
+            for (int i = 0; i < 3; ++i)
+                reader.Read(3 + 1);  // ref_frame_idx, ref_frame_sign_bias
+
+            bool found_ref = false;
+
+            for (int i = 0; (i < 3) && !found_ref; ++i)
+                found_ref = reader.ReadFlag();
+
+            if (!found_ref)  // else size is that of the reference
+                ReadVP9FrameSize(reader, info.width, info.height);
+
+            SkipVP9RenderSize(reader);
+
+            reader.Read(1);  // allow_high_precision_mv
+
+            if (!reader.ReadFlag())  // is_filter_switchable
+                reader.Read(2);  // raw_interpolation_filter
+        }
+    }
+
+    if (!error_resilient)
+    {
+        info.refresh_entropy = reader.ReadFlag();  // refresh_frame_context
+        reader.Read(1);  // frame_parallel_decoding_mode
+    }
+
+    reader.Read(2);  // frame_context_idx
+
+    const bool lf_update = ReadVP9LoopFilter(reader);
+    SkipVP9Quantization(reader);
+    const bool seg_update = ReadVP9Segmentation(reader);
+
+    if (reader.Overrun())
+        return kVpxParseTruncated;
+
+    // Intra-only and error resilient frames reset the saved probability
+    // contexts (see setup_past_independence in the VP9 spec).
+
+    const bool resets_context = info.key ||
+                                info.intra_only ||
+                                error_resilient ||
+                                (reset_frame_context >= 2);
+
+    info.droppable = (info.refresh_flags == 0) &&
+                     !info.refresh_entropy &&
+                     !resets_context &&
+                     !lf_update &&
+                     !seg_update;
+
+    return kVpxParseOk;
+}
+
+// Merges the info for the next frame of a superframe into the info for the
+// superframe as a whole.
+void MergeVP9Info(const VpxFrameInfo& frame, VpxFrameInfo& info)
+{
+    ++info.frames;
+
+    if (frame.key || frame.intra_only)
+    {
+        info.width = frame.width;
+        info.height = frame.height;
+    }
+
+    info.key |= frame.key;
+    info.intra_only |= frame.intra_only;
+    info.show_frame |= frame.show_frame;
+    info.show_existing |= frame.show_existing;
+    info.refresh_entropy |= frame.refresh_entropy;
+    info.droppable &= frame.droppable;
+    info.refresh_flags |= frame.refresh_flags;
+}
+
+}  // namespace
+
+
+int ParseVP8Frame(const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info)
+{
+    if ((ptr_data == NULL) || (length < 0))
+        return kVpxParseInvalidArg;
+
+    ResetInfo(kVpxCodecVP8, info);
+
+    // RFC 6386 section 9.1: the 3-byte frame tag.
+
+    if (length < 3)
+        return kVpxParseTruncated;
+
+    const unsigned int tag = ptr_data[0] |
+                             (ptr_data[1] << 8) |
+                             (ptr_data[2] << 16);
+
+    info.key = !(tag & 1);
+    info.profile = (tag >> 1) & 7;
+    info.show_frame = ((tag >> 4) & 1) != 0;
+
+    const long first_part_size = tag >> 5;
+
+    if (info.profile > 3)
+        return kVpxParseCorrupt;
+
+    long offset = 3;
+
+    if (info.key)
+    {
+        if (length < 10)
+            return kVpxParseTruncated;
+
+        if ((ptr_data[3] != 0x9D) ||
+            (ptr_data[4] != 0x01) ||
+            (ptr_data[5] != 0x2A))
+        {
+            return kVpxParseCorrupt;
+        }
+
+        // The top 2 bits of each dimension are the (ignored) scale.
+        info.width = (ptr_data[6] | (ptr_data[7] << 8)) & 0x3FFF;
+        info.height = (ptr_data[8] | (ptr_data[9] << 8)) & 0x3FFF;
+
+        offset = 10;
+    }
+
+    if (first_part_size > (length - offset))
+        return kVpxParseTruncated;
+
+    // RFC 6386 section 9.2 - 9.7: the frame header, in the first partition.
+
+    BoolDecoder bd(ptr_data + offset, first_part_size);
+
+    if (info.key)
+    {
+        bd.ReadLiteral(1);  // color_space
+        bd.ReadLiteral(1);  // clamping_type
+    }
+
+    bool state_update = false;  // segmentation or loop filter deltas
+
+    if (bd.ReadFlag())  // segmentation_enabled
+    {
+        const bool update_map = bd.ReadFlag();
+        const bool update_data = bd.ReadFlag();
+
+        if (update_data)
+        {
+            bd.ReadFlag();  // segment_feature_mode
+
+            for (int i = 0; i < 4; ++i)
+                bd.SkipOptionalSigned(7);  // quantizer
+
+            for (int i = 0; i < 4; ++i)
+                bd.SkipOptionalSigned(6);  // loop filter level
+        }
+
+        if (update_map)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                if (bd.ReadFlag())
+                    bd.ReadLiteral(8);  // segment_prob
+            }
+        }
+
+        state_update = update_map || update_data;
+    }
+
+    bd.ReadLiteral(1);  // filter_type
+    bd.ReadLiteral(6);  // loop_filter_level
+    bd.ReadLiteral(3);  // sharpness_level
+
+    if (bd.ReadFlag())  // loop_filter_adj_enable
+    {
+        if (bd.ReadFlag())  // mode_ref_lf_delta_update
+        {
+            for (int i = 0; i < 4 + 4; ++i)  // ref_frame and mb_mode deltas
+            {
+                if (bd.SkipOptionalSigned(6))
+                    state_update = true;
+            }
+        }
+    }
+
+    bd.ReadLiteral(2);  // log2_nbr_of_dct_partitions
+
+    bd.ReadLiteral(7);  // y_ac_qi
+
+    for (int i = 0; i < 5; ++i)  // y_dc, y2_dc, y2_ac, uv_dc, uv_ac deltas
+        bd.SkipOptionalSigned(4);
+
+    if (info.key)
+    {
+        info.refresh_entropy = bd.ReadFlag();
+        info.refresh_flags =
+            kVP8RefreshLast | kVP8RefreshGolden | kVP8RefreshAltRef;
+    }
+    else
+    {
+        const bool refresh_golden = bd.ReadFlag();
+        const bool refresh_altref = bd.ReadFlag();
+
+        unsigned int copy_to_golden = 0;
+        unsigned int copy_to_altref = 0;
+
+        if (!refresh_golden)
+            copy_to_golden = bd.ReadLiteral(2);
+
+        if (!refresh_altref)
+            copy_to_altref = bd.ReadLiteral(2);
+
+        bd.ReadLiteral(1);  // sign_bias_golden
+        bd.ReadLiteral(1);  // sign_bias_alternate
+
+        info.refresh_entropy = bd.ReadFlag();
+
+        const bool refresh_last = bd.ReadFlag();
+
+        if (refresh_last)
+            info.refresh_flags |= kVP8RefreshLast;
+
+        if (refresh_golden || copy_to_golden)
+            info.refresh_flags |= kVP8RefreshGolden;
+
+        if (refresh_altref || copy_to_altref)
+            info.refresh_flags |= kVP8RefreshAltRef;
+    }
+
+    if (bd.Overrun())
+        return kVpxParseTruncated;
+
+    info.droppable = !info.key &&
+                     (info.refresh_flags == 0) &&
+                     !info.refresh_entropy &&
+                     !state_update;
+
+    return kVpxParseOk;
+}
+
+
+int ParseVP9Frame(const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info)
+{
+    if ((ptr_data == NULL) || (length < 0))
+        return kVpxParseInvalidArg;
+
+    if (length == 0)
+    {
+        ResetInfo(kVpxCodecVP9, info);
+        return kVpxParseTruncated;
+    }
+
+    // Superframe index (VP9 bitstream spec, annex B): the last byte of the
+    // packet is a marker, which is repeated as the first byte of the index.
+
+    const unsigned char marker = ptr_data[length - 1];
+
+    if ((marker & 0xE0) == 0xC0)
+    {
+        const int frames = (marker & 7) + 1;
+        const int mag = ((marker >> 3) & 3) + 1;
+        const long index_size = 2 + mag * frames;
+
+        if ((length >= index_size) &&
+            (ptr_data[length - index_size] == marker))
+        {
+            const unsigned char* ptr_index = ptr_data + length - index_size + 1;
+            const unsigned char* ptr_frame = ptr_data;
+
+            long remaining = length - index_size;
+
+            for (int i = 0; i < frames; ++i)
+            {
+                long frame_size = 0;
+
+                for (int j = 0; j < mag; ++j)
+                    frame_size |= static_cast<long>(*ptr_index++) << (j * 8);
+
+                if (frame_size > remaining)
+                    return kVpxParseTruncated;
+
+                VpxFrameInfo frame;
+
+                const int status =
+                    ParseVP9SingleFrame(ptr_frame, frame_size, frame);
+
+                if (status != kVpxParseOk)
+                    return status;
+
+                if (i == 0)
+                    info = frame;
+                else
+                    MergeVP9Info(frame, info);
+
+                ptr_frame += frame_size;
+                remaining -= frame_size;
+            }
+
+            return kVpxParseOk;
+        }
+    }
+
+    return ParseVP9SingleFrame(ptr_data, length, info);
+}
+
+
+int ParseVpxFrame(int codec,
+                  const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info)
+{
+    switch (codec)
+    {
+        case kVpxCodecVP8:
+            return ParseVP8Frame(ptr_data, length, info);
+
+        case kVpxCodecVP9:
+            return ParseVP9Frame(ptr_data, length, info);
+
+        default:
+            return kVpxParseInvalidArg;
+    }
+}
+
+
+int ParseVpxFrames(int codec,
+                   const unsigned char* const* ptr_packets,
+                   const long* ptr_lengths,
+                   int count,
+                   VpxFrameInfo* ptr_infos,
+                   int* ptr_status)
+{
+    if ((ptr_packets == NULL) || (ptr_lengths == NULL) || (ptr_infos == NULL))
+        return 0;
+
+    if ((codec != kVpxCodecVP8) && (codec != kVpxCodecVP9))
+        return 0;
+
+    int parsed = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int status = (codec == kVpxCodecVP8) ?
+            ParseVP8Frame(ptr_packets[i], ptr_lengths[i], ptr_infos[i]) :
+            ParseVP9Frame(ptr_packets[i], ptr_lengths[i], ptr_infos[i]);
+
+        if (ptr_status)
+            ptr_status[i] = status;
+
+        if (status == kVpxParseOk)
+            ++parsed;
+    }
+
+    return parsed;
+}
+
+}  // namespace WebmUtil
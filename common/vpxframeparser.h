@@ -0,0 +1,99 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VPXFRAMEPARSER_HPP__
+#define __WEBMDSHOW_COMMON_VPXFRAMEPARSER_HPP__
+
+#pragma once
+
+// Parses just enough of a compressed VP8 or VP9 frame to learn what kind of
+// frame it is, without decoding it.  Nothing is allocated, and the parser
+// has no dependencies on Windows or on libvpx, so it can be used by the
+// decoders, the splitter, and the muxer alike.
+//
+// VP8: the frame tag and the keyframe start code are in the clear, but the
+// reference buffer update flags are bool-coded in the first partition, so a
+// (small) bool decoder is run over the frame header, up to refresh_last.
+//
+// VP9: everything we need is in the uncompressed header.  A packet can be a
+// superframe (typically a hidden alt-ref followed by a shown frame); the
+// frames in the superframe index are parsed individually, and their results
+// are merged (see VpxFrameInfo).
+
+namespace WebmUtil
+{
+
+enum VpxCodec
+{
+    kVpxCodecVP8 = 8,
+    kVpxCodecVP9 = 9
+};
+
+enum VpxParseStatus
+{
+    kVpxParseOk = 0,
+    kVpxParseInvalidArg = -1,
+    kVpxParseTruncated = -2,
+    kVpxParseCorrupt = -3
+};
+
+// Reference buffer bits in VpxFrameInfo::refresh_flags.  For VP8 these are
+// the last, golden, and alt-ref buffers.  For VP9 the value is the
+// refresh_frame_flags field (one bit for each of the eight slots).
+enum
+{
+    kVP8RefreshLast = 1,
+    kVP8RefreshGolden = 2,
+    kVP8RefreshAltRef = 4
+};
+
+struct VpxFrameInfo
+{
+    int codec;             // VpxCodec
+    int profile;           // VP8 version, or VP9 profile
+    int frames;            // >1 for a VP9 superframe
+    bool key;              // keyframe (for a superframe: any frame)
+    bool intra_only;       // VP9 intra-only (not key) frame
+    bool show_frame;       // false for a hidden alt-ref
+    bool show_existing;    // VP9 show_existing_frame
+    bool refresh_entropy;  // probabilities persist past this frame
+    bool droppable;        // decoding it changes no persistent state
+    unsigned refresh_flags;
+    int width;             // only known for key (and intra-only) frames,
+    int height;            //   else 0
+};
+
+// Parses one packet.  On success the info is filled in and kVpxParseOk is
+// returned; otherwise a (negative) VpxParseStatus is returned, and the info
+// is unspecified.
+int ParseVpxFrame(int codec,
+                  const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info);
+
+int ParseVP8Frame(const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info);
+
+int ParseVP9Frame(const unsigned char* ptr_data,
+                  long length,
+                  VpxFrameInfo& info);
+
+// Batch API: parses count packets.  The status of each packet is written
+// to ptr_status (which may be NULL).  Returns the number of packets that
+// were parsed successfully.
+int ParseVpxFrames(int codec,
+                   const unsigned char* const* ptr_packets,
+                   const long* ptr_lengths,
+                   int count,
+                   VpxFrameInfo* ptr_infos,
+                   int* ptr_status);
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_VPXFRAMEPARSER_HPP__
@@ -0,0 +1,157 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "vpxqualitygovernor.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "vpxframeparser.h"
+
+namespace WebmUtil
+{
+
+VpxQualityGovernor::VpxQualityGovernor() :
+    m_enabled(true)
+{
+    Reset();
+}
+
+void VpxQualityGovernor::Reset()
+{
+    m_level = kLevelFull;
+    m_frames_since_change = 0;
+    m_frames_since_notify = 0;
+    m_on_time = 0;
+    m_consecutive_skips = 0;
+
+    ResetStats();
+}
+
+void VpxQualityGovernor::ResetStats()
+{
+    memset(&m_stats, 0, sizeof m_stats);
+}
+
+void VpxQualityGovernor::SetEnabled(bool enabled)
+{
+    m_enabled = enabled;
+
+    if (!m_enabled)
+        SetLevel(kLevelFull);
+}
+
+bool VpxQualityGovernor::IsEnabled() const
+{
+    return m_enabled;
+}
+
+int VpxQualityGovernor::GetLevel() const
+{
+    return m_level;
+}
+
+const VpxQualityGovernor::Stats& VpxQualityGovernor::GetStats() const
+{
+    return m_stats;
+}
+
+bool VpxQualityGovernor::OnNotify(long long late)
+{
+    ++m_stats.notifications;
+
+    if (late > m_stats.max_late)
+        m_stats.max_late = late;
+
+    m_frames_since_notify = 0;
+
+    if (!m_enabled)
+        return false;
+
+    const int old_level = m_level;
+
+    if (late > kSevereLate)
+    {
+        m_on_time = 0;
+
+        if (m_level < kLevelSkipDroppable)
+            SetLevel(kLevelSkipDroppable);
+    }
+    else if (late > kStepDownLate)
+    {
+        m_on_time = 0;
+
+        //Give the previous step a few frames to take effect, before
+        //deciding that it wasn't enough.
+
+        if ((m_level < kLevelSkipDroppable) &&
+            (m_frames_since_change >= kHoldFrames))
+        {
+            SetLevel(m_level + 1);
+        }
+    }
+    else if (late <= kRecoverLate)
+    {
+        if ((m_level > kLevelFull) && (++m_on_time >= kRecoverNotifications))
+            SetLevel(m_level - 1);
+    }
+    else
+        m_on_time = 0;  //a little late: hold the current level
+
+    return (m_level != old_level);
+}
+
+bool VpxQualityGovernor::OnFrame(const VpxFrameInfo* info)
+{
+    ++m_stats.frames;
+    ++m_stats.frames_at_level[m_level];
+    ++m_frames_since_change;
+
+    //A renderer that stops sending reports is (presumably) keeping up;
+    //don't let us get stuck at a degraded level.
+
+    if ((m_level > kLevelFull) && (++m_frames_since_notify >= kQuietFrames))
+        SetLevel(m_level - 1);
+
+    if ((m_level >= kLevelSkipDroppable) &&
+        (info != 0) &&
+        info->droppable &&
+        (m_consecutive_skips < kMaxConsecutiveSkips))
+    {
+        ++m_consecutive_skips;
+        ++m_stats.skipped;
+
+        return false;
+    }
+
+    m_consecutive_skips = 0;
+    ++m_stats.decoded;
+
+    return true;
+}
+
+void VpxQualityGovernor::SetLevel(int level)
+{
+    assert(level >= kLevelFull);
+    assert(level < kLevelCount);
+
+    if (level == m_level)
+        return;
+
+    if (level > m_level)
+        ++m_stats.step_downs;
+    else
+        ++m_stats.step_ups;
+
+    m_level = level;
+    m_frames_since_change = 0;
+    m_frames_since_notify = 0;
+    m_on_time = 0;
+}
+
+}  // namespace WebmUtil
@@ -0,0 +1,111 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#ifndef __WEBMDSHOW_COMMON_VPXQUALITYGOVERNOR_HPP__
+#define __WEBMDSHOW_COMMON_VPXQUALITYGOVERNOR_HPP__
+
+#pragma once
+
+// Decides how much work a video decoder should shed, given the lateness
+// that the renderer reports (IQualityControl::Notify).  The governor is a
+// plain state machine: it knows nothing about DirectShow or libvpx, and the
+// caller is expected to serialize access to it.
+//
+// While the renderer is late the governor steps down one level at a time:
+// first the post-processing is reduced, then it is turned off entirely, and
+// finally frames that nothing else depends on (VpxFrameInfo::droppable) are
+// not decoded at all.  Once the renderer is back on time, the governor
+// steps back up, again one level at a time, and more slowly than it came
+// down, so that it does not oscillate between levels.
+
+namespace WebmUtil
+{
+
+struct VpxFrameInfo;
+
+class VpxQualityGovernor
+{
+    VpxQualityGovernor(const VpxQualityGovernor&);
+    VpxQualityGovernor& operator=(const VpxQualityGovernor&);
+
+public:
+
+    enum Level
+    {
+        kLevelFull = 0,          // post-processing as configured
+        kLevelReducedPostProc,   // deblocking only
+        kLevelNoPostProc,        // no post-processing
+        kLevelSkipDroppable,     // no post-processing, skip droppable frames
+        kLevelCount
+    };
+
+    // Lateness is in reftime units (100ns), as in Quality::Late.
+    enum
+    {
+        kStepDownLate = 40 * 10000,   // late by more than this: step down
+        kSevereLate = 200 * 10000,    // go straight to kLevelSkipDroppable
+        kRecoverLate = 0,             // at or below this: on time
+        kHoldFrames = 8,              // frames between two step downs
+        kRecoverNotifications = 30,   // on-time reports per step up
+        kQuietFrames = 60,            // frames without a report per step up
+        kMaxConsecutiveSkips = 3      // so the renderer still gets frames
+    };
+
+    struct Stats
+    {
+        long notifications;
+        long long max_late;
+        long frames;
+        long decoded;
+        long skipped;
+        long step_downs;
+        long step_ups;
+        long frames_at_level[kLevelCount];
+    };
+
+    VpxQualityGovernor();
+
+    // Returns to full quality, and clears the statistics.
+    void Reset();
+    void ResetStats();
+
+    // When disabled the governor stays at kLevelFull, but it still
+    // counts notifications and frames.
+    void SetEnabled(bool);
+    bool IsEnabled() const;
+
+    // Called with the lateness of each quality report (positive when the
+    // renderer is behind).  Returns true if the level changed.
+    bool OnNotify(long long late);
+
+    // Called for each compressed frame, before it is decoded.  Returns true
+    // if the frame should be decoded, false if it should be skipped.  The
+    // info may be NULL (the frame was not, or could not be, parsed), in
+    // which case the frame is always decoded.
+    bool OnFrame(const VpxFrameInfo* info);
+
+    int GetLevel() const;
+    const Stats& GetStats() const;
+
+private:
+
+    bool m_enabled;
+    int m_level;
+    long m_frames_since_change;
+    long m_frames_since_notify;
+    long m_on_time;
+    long m_consecutive_skips;
+    Stats m_stats;
+
+    void SetLevel(int);
+
+};
+
+}  // namespace WebmUtil
+
+#endif  // __WEBMDSHOW_COMMON_VPXQUALITYGOVERNOR_HPP__
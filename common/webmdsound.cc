@@ -26,183 +26,121 @@ const UINT32 kF32BytesPerSample = sizeof(float);
 const UINT32 kF32BitsPerSample = kF32BytesPerSample * 8;
 const UINT32 kS16BytesPerSample = sizeof(INT16);
 const UINT32 kS16BitsPerSample = kS16BytesPerSample * 8;
+// Seconds of audio that |AudioPlaybackDevice::ptr_audio_buf_| can hold.
+const UINT32 kAudioBufferSeconds = 2;
+// Number of times per pass through the DirectSound buffer that DirectSound
+// wakes |DSoundWriterThread_|.
+const DWORD kNotificationPositions = 4;
+// Backstop for the writer thread's wait: DirectSound sends no notifications
+// while paused, or when the buffer does not support them.
+const DWORD kWriterWaitMs = 100;
+// How long |WriteAudioBuffer| waits for room before giving up.
+const DWORD kWriteWaitMs = 2000;
 
-// Note: AudioBufferTemplate is not in use!!
-template <class SampleType>
-AudioBufferTemplate<SampleType>::AudioBufferTemplate():
-  sample_size_(sizeof SampleType)
+AudioBuffer::AudioBuffer():
+  sample_size_(0)
 {
-    DBGLOG("ctor, sample_size_=" << sample_size_);
+    DBGLOG("ctor");
 }
 
-template <class SampleType>
-AudioBufferTemplate<SampleType>::~AudioBufferTemplate()
+AudioBuffer::~AudioBuffer()
 {
     DBGLOG("dtor");
 }
 
-template <class SampleType>
-HRESULT AudioBufferTemplate<SampleType>::Read(UINT32 out_buf_size,
-                                              UINT32* ptr_bytes_written,
-                                              SampleType* ptr_samples)
+HRESULT AudioBuffer::Init(UINT32 capacity_in_bytes)
 {
-    if (!out_buf_size || !ptr_bytes_written || !ptr_samples)
+    if (!sample_size_ || capacity_in_bytes < sample_size_)
     {
         return E_INVALIDARG;
     }
-    if (audio_buf_.empty())
+    // The ring rounds its capacity up to a power of two, which keeps it a
+    // whole number of (2 or 4 byte) samples.
+    if (!ring_.Init(capacity_in_bytes))
     {
-        DBGLOG("buffer empty");
-        return S_FALSE;
-    }
-    UINT32 aud_bytes_available = SamplesToBytes(audio_buf_.size());
-    UINT32 bytes_to_copy = out_buf_size >= aud_bytes_available ?
-        aud_bytes_available : out_buf_size;
-    void* ptr_out_data = reinterpret_cast<void*>(ptr_samples);
-    HRESULT hr = ::memcpy_s(ptr_out_data, max_bytes, &audio_buf_[0],
-                            bytes_to_copy);
-    if (SUCCEEDED(hr))
-    {
-        UINT32 samples_to_erase = BytesToSamples(bytes_to_copy);
-        audio_buf_.erase(audio_buf_[0], audio_buf_[samples_to_erase]);
+        DBGLOG("ERROR no memory for ring buffer.");
+        return E_OUTOFMEMORY;
     }
-    return hr;
+    return S_OK;
 }
 
-template <class SampleType>
-HRESULT AudioBufferTemplate<SampleType>::Write(SampleType* ptr_samples,
-                                               UINT32 length_in_bytes)
+HRESULT AudioBuffer::Available(UINT32* ptr_num_samples, UINT32* ptr_num_bytes)
 {
-    if (!ptr_samples || !length_in_bytes)
+    if (!ptr_num_samples || !ptr_num_bytes)
     {
         return E_INVALIDARG;
     }
-    UINT32 num_samples = BytesToSamples(length_in_bytes);
-    audio_buf_.insert(audio_buf_.end(), num_samples, ptr_samples);
-    return hr;
-}
-
-AudioBuffer::AudioBuffer():
-  sample_size_(0)
-{
-    DBGLOG("ctor");
-}
-
-AudioBuffer::~AudioBuffer()
-{
-    DBGLOG("dtor");
-}
-
-F32AudioBuffer::F32AudioBuffer()
-{
-    AudioBuffer::sample_size_ = kF32BytesPerSample;
-    assert(kF32BytesPerSample == 4);
-    DBGLOG("ctor");
-}
-
-F32AudioBuffer::~F32AudioBuffer()
-{
-    DBGLOG("dtor");
+    const UINT64 num_samples = BytesToSamples(ring_.GetAvailable());
+    *ptr_num_samples = static_cast<UINT32>(num_samples);
+    *ptr_num_bytes = static_cast<UINT32>(SamplesToBytes(num_samples));
+    return S_OK;
 }
 
-HRESULT F32AudioBuffer::Read(UINT32 out_buf_size, UINT32* ptr_bytes_written,
-                             void* ptr_samples)
+HRESULT AudioBuffer::Read(UINT32 out_buf_size, UINT32* ptr_bytes_written,
+                          void* ptr_samples)
 {
     if (!out_buf_size || !ptr_bytes_written || !ptr_samples)
     {
         return E_INVALIDARG;
     }
-    if (audio_buf_.empty())
+    *ptr_bytes_written = 0;
+    const UINT64 bytes_to_copy =
+        SamplesToBytes(BytesToSamples(out_buf_size));
+    const size_t bytes_copied =
+        ring_.Read(ptr_samples, static_cast<size_t>(bytes_to_copy));
+    if (!bytes_copied)
     {
-        DBGLOG("buffer empty");
         return S_FALSE;
     }
-    UINT64 aud_bytes_available = SamplesToBytes(audio_buf_.size());
-    UINT64 bytes_to_copy = out_buf_size >= aud_bytes_available ?
-        aud_bytes_available : out_buf_size;
-    void* ptr_out_data = reinterpret_cast<void*>(ptr_samples);
-    HRESULT hr = ::memcpy_s(ptr_out_data, out_buf_size, &audio_buf_[0],
-                            bytes_to_copy);
-    if (SUCCEEDED(hr))
-    {
-        UINT64 samples_to_erase = BytesToSamples(bytes_to_copy);
-        audio_buf_.erase(audio_buf_.begin(), audio_buf_.begin()+samples_to_erase);
-    }
-    return hr;
+    *ptr_bytes_written = static_cast<UINT32>(bytes_copied);
+    return S_OK;
 }
 
-HRESULT F32AudioBuffer::Write(const void* const ptr_samples,
-                              UINT32 length_in_bytes,
-                              UINT32* ptr_samples_written)
+HRESULT AudioBuffer::Write(const void* const ptr_samples,
+                           UINT32 length_in_bytes,
+                           UINT32* ptr_samples_written)
 {
     if (!ptr_samples || !length_in_bytes || !ptr_samples_written)
     {
         return E_INVALIDARG;
     }
-    UINT64 num_samples = BytesToSamples(length_in_bytes);
-    typedef const float* const f32_read_ptr;
-    f32_read_ptr ptr_fp_samples = reinterpret_cast<f32_read_ptr>(ptr_samples);
-    audio_buf_.insert(audio_buf_.end(), num_samples, *ptr_fp_samples);
-    *ptr_samples_written = static_cast<UINT32>(num_samples);
-    return S_OK;
+    // Only whole samples go in, so that the consumer never sees half of one.
+    const UINT64 space = SamplesToBytes(BytesToSamples(ring_.GetSpace()));
+    const UINT64 bytes = SamplesToBytes(BytesToSamples(length_in_bytes));
+    const size_t bytes_to_copy =
+        static_cast<size_t>(bytes < space ? bytes : space);
+    const size_t bytes_copied = ring_.Write(ptr_samples, bytes_to_copy);
+    assert(bytes_copied == bytes_to_copy);
+    *ptr_samples_written = static_cast<UINT32>(BytesToSamples(bytes_copied));
+    return bytes_copied == bytes ? S_OK : S_FALSE;
 }
 
-S16AudioBuffer::S16AudioBuffer()
+F32AudioBuffer::F32AudioBuffer()
 {
-    AudioBuffer::sample_size_ = kS16BytesPerSample;
-    assert(kS16BytesPerSample == 2);
+    AudioBuffer::sample_size_ = kF32BytesPerSample;
+    assert(kF32BytesPerSample == 4);
     DBGLOG("ctor");
 }
 
-S16AudioBuffer::~S16AudioBuffer()
+F32AudioBuffer::~F32AudioBuffer()
 {
     DBGLOG("dtor");
 }
 
-HRESULT S16AudioBuffer::Read(UINT32 out_buf_size, UINT32* ptr_bytes_written,
-                             void* ptr_samples)
+S16AudioBuffer::S16AudioBuffer()
 {
-    if (!out_buf_size || !ptr_bytes_written || !ptr_samples)
-    {
-        return E_INVALIDARG;
-    }
-    if (audio_buf_.empty())
-    {
-        DBGLOG("buffer empty");
-        return S_FALSE;
-    }
-    UINT64 aud_bytes_available = SamplesToBytes(audio_buf_.size());
-    UINT64 bytes_to_copy = out_buf_size >= aud_bytes_available ?
-        aud_bytes_available : out_buf_size;
-    void* ptr_out_data = reinterpret_cast<void*>(ptr_samples);
-    HRESULT hr = ::memcpy_s(ptr_out_data, out_buf_size, &audio_buf_[0],
-                            bytes_to_copy);
-    if (SUCCEEDED(hr))
-    {
-        UINT64 samples_to_erase = BytesToSamples(bytes_to_copy);
-        audio_buf_.erase(audio_buf_.begin(),
-                         audio_buf_.begin()+samples_to_erase);
-    }
-    return hr;
+    AudioBuffer::sample_size_ = kS16BytesPerSample;
+    assert(kS16BytesPerSample == 2);
+    DBGLOG("ctor");
 }
 
-HRESULT S16AudioBuffer::Write(const void* const ptr_samples,
-                              UINT32 length_in_bytes,
-                              UINT32* ptr_samples_written)
+S16AudioBuffer::~S16AudioBuffer()
 {
-    if (!ptr_samples || !length_in_bytes || !ptr_samples_written)
-    {
-        return E_INVALIDARG;
-    }
-    UINT64 num_samples = BytesToSamples(length_in_bytes);
-    typedef const INT16* const s16_read_ptr;
-    s16_read_ptr ptr_s16_samples = reinterpret_cast<s16_read_ptr>(ptr_samples);
-    audio_buf_.insert(audio_buf_.end(), num_samples, *ptr_s16_samples);
-    *ptr_samples_written = (UINT32)num_samples;
-    return S_OK;
+    DBGLOG("dtor");
 }
 
 AudioPlaybackDevice::AudioPlaybackDevice():
+  block_align_(0),
   dsound_buffer_size_(0),
   hwnd_(NULL),
   play_cursor_(0),
@@ -212,14 +150,25 @@ AudioPlaybackDevice::AudioPlaybackDevice():
   ptr_dsound_thread_(NULL),
   samples_buffered_(0),
   samples_played_(0),
-  state_(STATE_STOPPED)
+  space_event_(NULL),
+  state_(STATE_STOPPED),
+  wake_event_(NULL),
+  write_offset_(0)
 {
 }
 
 AudioPlaybackDevice::~AudioPlaybackDevice()
 {
-    WebmUtil::safe_rel(ptr_dsound_);
     WebmUtil::safe_rel(ptr_dsound_buf_);
+    WebmUtil::safe_rel(ptr_dsound_);
+    if (wake_event_)
+    {
+        CloseHandle(wake_event_);
+    }
+    if (space_event_)
+    {
+        CloseHandle(space_event_);
+    }
 }
 
 HRESULT AudioPlaybackDevice::Open(HWND hwnd,
@@ -247,8 +196,14 @@ HRESULT AudioPlaybackDevice::Open(HWND hwnd,
     {
         return hr;
     }
-    CHK(hr, CreateAudioBuffer_(ptr_wfx->Format.wFormatTag,
-                               ptr_wfx->Format.wBitsPerSample));
+    wake_event_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+    space_event_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!wake_event_ || !space_event_)
+    {
+        DBGLOG("ERROR cannot create events.");
+        return E_OUTOFMEMORY;
+    }
+    CHK(hr, CreateAudioBuffer_(ptr_wfx));
     if (FAILED(hr))
     {
         return hr;
@@ -263,7 +218,7 @@ HRESULT AudioPlaybackDevice::Open(HWND hwnd,
 
 HRESULT AudioPlaybackDevice::Start()
 {
-    if (STATE_STOPPED != state_)
+    if (STATE_STOPPED != GetState_())
     {
         DBGLOG("ERROR Already started.");
         return E_UNEXPECTED;
@@ -295,20 +250,20 @@ HRESULT AudioPlaybackDevice::Start()
                                     reinterpret_cast<void*>(this)));
     if (SUCCEEDED(hr))
     {
-        state_ = STATE_STARTED;
+        SetState_(STATE_STARTED);
     }
     return hr;
 }
 
 HRESULT AudioPlaybackDevice::Stop()
 {
-    if (state_ == STATE_STOPPED)
+    if (GetState_() == STATE_STOPPED)
     {
         DBGLOG("ERROR Already stopped.");
         return E_UNEXPECTED;
     }
     HRESULT hr = S_OK;
-    if (STATE_PLAY == state_)
+    if (STATE_PLAY == GetState_())
     {
         CHK(hr, Pause());
         if (FAILED(hr))
@@ -324,20 +279,22 @@ HRESULT AudioPlaybackDevice::Stop()
         {
             return hr;
         }
+        // and wake it up, so it notices now
+        SetEvent(wake_event_);
         // wait for |DSoundWriterThread_| to signal
         CHK(hr, ptr_dsound_thread_event_->Wait());
         if (FAILED(hr))
         {
             return hr;
         }
-        state_ = STATE_STOPPED;
+        SetState_(STATE_STOPPED);
     }
     return hr;
 }
 
 HRESULT AudioPlaybackDevice::Pause()
 {
-    if (STATE_PLAY != state_)
+    if (STATE_PLAY != GetState_())
     {
         DBGLOG("ERROR wrong state, not playing.");
         return E_UNEXPECTED;
@@ -346,14 +303,15 @@ HRESULT AudioPlaybackDevice::Pause()
     CHK(hr, ptr_dsound_buf_->Stop());
     if (SUCCEEDED(hr))
     {
-        state_ = STATE_PAUSE;
+        SetState_(STATE_PAUSE);
     }
     return hr;
 }
 
 HRESULT AudioPlaybackDevice::Play()
 {
-    bool wrong_state = (STATE_PAUSE != state_ && STATE_STARTED != state_);
+    const AudioPlaybackState state = GetState_();
+    bool wrong_state = (STATE_PAUSE != state && STATE_STARTED != state);
     if (wrong_state)
     {
         DBGLOG("ERROR wrong state.");
@@ -363,7 +321,9 @@ HRESULT AudioPlaybackDevice::Play()
     CHK(hr, ptr_dsound_buf_->Play(0, 0, DSBPLAY_LOOPING));
     if (SUCCEEDED(hr))
     {
-        state_ = STATE_PLAY;
+        SetState_(STATE_PLAY);
+        // |DSoundWriterThread_| doesn't write while paused; have it catch up
+        SetEvent(wake_event_);
     }
     return hr;
 }
@@ -386,21 +346,48 @@ HRESULT AudioPlaybackDevice::WriteAudioBuffer(const void* const ptr_samples,
         DBGLOG("ERROR less than 1 sample in user input buffer");
         return E_INVALIDARG;
     }
-    Lock lock;
+    // No lock: |ptr_audio_buf_| is a single-producer/single-consumer ring,
+    // and we are its producer (|DSoundWriterThread_| is the consumer).  The
+    // counter and the state are read and written with interlocked
+    // operations.
+    const BYTE* ptr_in = reinterpret_cast<const BYTE*>(ptr_samples);
+    UINT32 bytes_left = length_in_bytes;
     HRESULT hr = S_OK;
-    CHK(hr, lock.Seize(this));
-    if (FAILED(hr))
-    {
-        return hr;
-    }
-    UINT32 samples_written = 0;
-    CHK(hr, ptr_audio_buf_->Write(ptr_samples, length_in_bytes,
-                                  &samples_written));
-    if (SUCCEEDED(hr))
+    for (;;)
     {
-        samples_buffered_ += samples_written;
+        UINT32 samples_written = 0;
+        CHK(hr, ptr_audio_buf_->Write(ptr_in, bytes_left, &samples_written));
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        if (samples_written)
+        {
+            InterlockedExchangeAdd64(&samples_buffered_, samples_written);
+            const UINT32 bytes_written =
+                (UINT32)ptr_audio_buf_->SamplesToBytes(samples_written);
+            ptr_in += bytes_written;
+            bytes_left -= bytes_written;
+            SetEvent(wake_event_);
+        }
+        if (S_OK == hr || bytes_left < ptr_audio_buf_->GetSampleSize())
+        {
+            return S_OK;
+        }
+        if (STATE_PLAY != GetState_())
+        {
+            // Nothing will make room until playback resumes.
+            DBGLOG("buffer full, dropped " << bytes_left << " bytes");
+            return S_FALSE;
+        }
+        // Full: wait for |DSoundWriterThread_| to move some samples into the
+        // DirectSound buffer.
+        if (WAIT_OBJECT_0 != WaitForSingleObject(space_event_, kWriteWaitMs))
+        {
+            DBGLOG("ERROR timed out waiting for room in the buffer");
+            return HRESULT_FROM_WIN32(WAIT_TIMEOUT);
+        }
     }
-    return hr;
 }
 
 HRESULT AudioPlaybackDevice::WriteDSoundBuffer_()
@@ -424,62 +411,85 @@ HRESULT AudioPlaybackDevice::WriteDSoundBuffer_()
     {
         return hr;
     }
+    UpdateSamplesPlayed_();
     if (!samples_available)
     {
-        DBGLOG("no samples in buffer");
         return S_FALSE;
     }
-    // adjust |bytes_available| to ensure we avoid trying to lock a portion
-    // of |ptr_dsound_buf_| that's larger than the entire buffer
-    bytes_available = bytes_available > dsound_buffer_size_ ?
-        dsound_buffer_size_ : bytes_available;
-    // We own our internal lock, try to lock the dsound buffer...
-    DWORD write_offset = 0; // ignored by dsound because we set the
-                            // DSBLOCK_FROMWRITECURSOR flag
+    DWORD play_cursor = 0, write_cursor = 0;
+    CHK(hr, ptr_dsound_buf_->GetCurrentPosition(&play_cursor, &write_cursor));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    // We may write anywhere from the write cursor up to the play cursor,
+    // wrapping around the end of the buffer.  When the two are equal
+    // (stopped, or never started) that's the entire buffer.
+    const DWORD size = dsound_buffer_size_;
+    DWORD writable = (play_cursor + size - write_cursor) % size;
+    if (!writable)
+    {
+        writable = size;
+    }
+    // How far ahead of the write cursor we have already written.  If that's
+    // outside of the writable region, the play cursor has overtaken us (an
+    // underrun), and we resume at the write cursor.
+    DWORD ahead = (write_offset_ + size - write_cursor) % size;
+    if (ahead >= writable)
+    {
+        DBGLOG("underrun");
+        write_offset_ = write_cursor;
+        ahead = 0;
+    }
+    // Leave a block free, so that a full buffer can't look like an empty
+    // one the next time around.
+    DWORD space = writable - ahead;
+    space = space > block_align_ ? space - block_align_ : 0;
+    DWORD bytes_to_write = bytes_available < space ? bytes_available : space;
+    bytes_to_write -= bytes_to_write % block_align_;
+    if (!bytes_to_write)
+    {
+        // DirectSound buffer full, let it play out for a bit.
+        return S_FALSE;
+    }
     // DirectSound buffers are circular, so we might get two write pointers
     // back.  When we do, we must write to both if Lock gives us two non-null
-    // pointers to satisfy our |length_in_bytes| requirement.
+    // pointers to satisfy our |bytes_to_write| requirement.
     void* ptr_write1 = NULL;
     void* ptr_write2 = NULL;
     DWORD write_space1 = 0;
     DWORD write_space2 = 0;
-    // Always lock the dsound buffer at the current write cursor position
-    DWORD lock_flags = DSBLOCK_FROMWRITECURSOR;
-    CHK(hr, ptr_dsound_buf_->Lock(write_offset, bytes_available, &ptr_write1,
+    CHK(hr, ptr_dsound_buf_->Lock(write_offset_, bytes_to_write, &ptr_write1,
                                   &write_space1, &ptr_write2, &write_space2,
-                                  lock_flags));
+                                  0));
     if (FAILED(hr))
     {
         DBGLOG("ERROR Lock failed.");
         return hr;
     }
-    bool buffer_full = (write_space1 + write_space2) == 0;
-    if (buffer_full)
-    {
-        UpdateSamplesPlayed_();
-        return S_FALSE;
-    }
+    // Each region is filled by one bulk copy out of the ring (which may
+    // itself be split in two where the ring wraps).
     UINT32 bytes_written1 = 0;
-    if (ptr_write1)
+    if (ptr_write1 && write_space1)
     {
-        const UINT32 bytes_to_write =
-            write_space1 > bytes_available ? bytes_available : write_space1;
-        CHK(hr, ptr_audio_buf_->Read(bytes_to_write, &bytes_written1,
+        CHK(hr, ptr_audio_buf_->Read(write_space1, &bytes_written1,
                                      ptr_write1));
     }
     UINT32 bytes_written2 = 0;
-    UINT32 bytes_left = bytes_available - write_space1;
-    if (ptr_write2 && bytes_available > write_space1 && bytes_left)
+    if (ptr_write2 && write_space2 && bytes_written1 == write_space1)
     {
         CHK(hr, ptr_audio_buf_->Read(write_space2, &bytes_written2,
                                      ptr_write2));
     }
     CHK(hr, ptr_dsound_buf_->Unlock(ptr_write1, bytes_written1, ptr_write2,
                                     bytes_written2));
-    UpdateSamplesPlayed_();
-    //DBGLOG("bytes_written1=" << bytes_written1
-    //    << "bytes_written2=" << bytes_written2
-    //    << "total bytes written=" << bytes_written1 + bytes_written2);
+    const DWORD bytes_written = bytes_written1 + bytes_written2;
+    write_offset_ = (write_offset_ + bytes_written) % size;
+    if (bytes_written)
+    {
+        // |WriteAudioBuffer| may be waiting for room.
+        SetEvent(space_event_);
+    }
     return hr;
 }
 
@@ -493,7 +503,7 @@ void AudioPlaybackDevice::UpdateSamplesPlayed_()
     if (play_cursor < play_cursor_)
     {
         // wrapped
-        bytes_played = play_cursor + play_cursor_ - dsound_buffer_size_;
+        bytes_played = play_cursor + dsound_buffer_size_ - play_cursor_;
     }
     else
     {
@@ -504,7 +514,8 @@ void AudioPlaybackDevice::UpdateSamplesPlayed_()
         // store total samples played in |samples_played_| for user playback
         // timing
         UINT64 samples_played = ptr_audio_buf_->BytesToSamples(bytes_played);
-        samples_played_ += samples_played;
+        InterlockedExchangeAdd64(&samples_played_,
+                                 static_cast<LONGLONG>(samples_played));
         //DBGLOG("samples_played=" << samples_played);
     }
     //DBGLOG("total samples_played_=" << samples_played_);
@@ -531,34 +542,31 @@ DWORD AudioPlaybackDevice::DSoundWriterThread_(void* ptr_this)
             CHK(hr, apd_event->Set());
             break;
         }
-        if (STATE_PLAY == ptr_apd->state_)
+        if (STATE_PLAY == ptr_apd->GetState_())
         {
-            // we intentionally ignore the return values other than S_FALSE from
-            // |WriteDsoundBuffer_|, though we log failures for sanity's sake in
-            // debug mode
+            // we intentionally ignore the return values from
+            // |WriteDsoundBuffer_|, though we log failures for sanity's sake
+            // in debug mode
             CHK(hr, ptr_apd->WriteDSoundBuffer_());
-            // and now we yield
-            if (S_FALSE == hr)
-            {
-                // direct sound buffer full, let it play out for a bit
-                Sleep(1);
-            }
-            else
-            {
-                Sleep(0);
-            }
-        }
-        else
-        {
-            // paused or stopping, just sleep for a millisecond
-            Sleep(1);
         }
+        // Sleep until the play cursor passes a notification position (i.e.
+        // there's room in the DirectSound buffer), samples arrive, or we're
+        // told to stop.
+        WaitForSingleObject(ptr_apd->wake_event_, kWriterWaitMs);
     }
     return EXIT_SUCCESS;
 }
 
-HRESULT AudioPlaybackDevice::CreateAudioBuffer_(WORD fmt_tag, WORD bits)
+HRESULT AudioPlaybackDevice::CreateAudioBuffer_(
+    const WAVEFORMATEXTENSIBLE* const ptr_wfx)
 {
+    if (!ptr_wfx)
+    {
+        DBGLOG("NULL WAVEFORMATEX!");
+        return E_INVALIDARG;
+    }
+    const WORD fmt_tag = ptr_wfx->Format.wFormatTag;
+    const WORD bits = ptr_wfx->Format.wBitsPerSample;
     if (WAVE_FORMAT_PCM != fmt_tag && WAVE_FORMAT_IEEE_FLOAT != fmt_tag)
     {
         DBGLOG("ERROR unsupported format tag");
@@ -579,7 +587,12 @@ HRESULT AudioPlaybackDevice::CreateAudioBuffer_(WORD fmt_tag, WORD bits)
         DBGLOG("ERROR unsupported sample size");
         return E_INVALIDARG;
     }
-    return ptr_audio_buf_.get() ? S_OK : E_OUTOFMEMORY;
+    if (!ptr_audio_buf_.get())
+    {
+        return E_OUTOFMEMORY;
+    }
+    return ptr_audio_buf_->Init(
+        ptr_wfx->Format.nAvgBytesPerSec * kAudioBufferSeconds);
 }
 
 HRESULT AudioPlaybackDevice::CreateDirectSoundBuffer_(
@@ -606,8 +619,15 @@ HRESULT AudioPlaybackDevice::CreateDirectSoundBuffer_(
     aud_buffer_desc.guid3DAlgorithm = DS3DALG_DEFAULT;
     aud_buffer_desc.lpwfxFormat = (WAVEFORMATEX*)ptr_wfx;
     dsound_buffer_size_ = ptr_wfx->Format.nAvgBytesPerSec;
+    block_align_ = ptr_wfx->Format.nBlockAlign;
+    if (!block_align_ || dsound_buffer_size_ < block_align_)
+    {
+        DBGLOG("bad block alignment!");
+        return E_INVALIDARG;
+    }
     aud_buffer_desc.dwBufferBytes = dsound_buffer_size_;
-    aud_buffer_desc.dwFlags = DSBCAPS_GETCURRENTPOSITION2;
+    aud_buffer_desc.dwFlags = DSBCAPS_GETCURRENTPOSITION2 |
+                              DSBCAPS_CTRLPOSITIONNOTIFY;
     // Obtain our IDirectSoundBuffer8 interface pointer, |ptr_dsound_buf_|, by:
     // 1. Create an IDirectSoundBuffer.
     // 2. Call QueryInterface on the IDirectSoundBuffer instance to obtain the
@@ -619,13 +639,49 @@ HRESULT AudioPlaybackDevice::CreateDirectSoundBuffer_(
     {
         return hr;
     }
-    void* ptr_dsound_buf8 = reinterpret_cast<void*>(ptr_dsound_buf_);
+    void* ptr_dsound_buf8 = NULL;
     CHK(hr, ptr_dsbuf->QueryInterface(IID_IDirectSoundBuffer8,
                                       &ptr_dsound_buf8));
+    ptr_dsbuf->Release();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    ptr_dsound_buf_ = reinterpret_cast<IDirectSoundBuffer8*>(ptr_dsound_buf8);
+    CHK(hr, SetNotificationPositions_());
+    if (FAILED(hr))
+    {
+        // Not fatal: |DSoundWriterThread_| falls back to polling, every
+        // |kWriterWaitMs|.
+        DBGLOG("WARNING no position notifications.");
+    }
+    return S_OK;
+}
+
+HRESULT AudioPlaybackDevice::SetNotificationPositions_()
+{
+    IDirectSoundNotify8* ptr_notify = NULL;
+    HRESULT hr;
+    CHK(hr, ptr_dsound_buf_->QueryInterface(
+        IID_IDirectSoundNotify8, reinterpret_cast<void**>(&ptr_notify)));
     if (FAILED(hr))
     {
         return hr;
     }
+    // Evenly spaced, block aligned positions, which all signal the same
+    // event: each one means another part of the buffer has played, and can
+    // be refilled.
+    const DWORD interval = dsound_buffer_size_ / kNotificationPositions;
+    DSBPOSITIONNOTIFY positions[kNotificationPositions];
+    for (DWORD i = 0; i < kNotificationPositions; ++i)
+    {
+        const DWORD offset = i * interval;
+        positions[i].dwOffset = offset - offset % block_align_;
+        positions[i].hEventNotify = wake_event_;
+    }
+    CHK(hr, ptr_notify->SetNotificationPositions(kNotificationPositions,
+                                                 positions));
+    ptr_notify->Release();
     return hr;
 }
 
@@ -11,6 +11,8 @@
 
 #include <dsound.h>
 
+#include "ringbuffer.h"
+
 namespace WebmDirectX
 {
 
@@ -22,50 +24,37 @@ enum AudioPlaybackState
     STATE_PAUSE = 3
 };
 
-// Note: AudioBufferTemplate is not in use!!
-template <class SampleType>
-class AudioBufferTemplate
-{
-public:
-    AudioBufferTemplate();
-    ~AudioBufferTemplate();
-    HRESULT Read(UINT32 max_bytes, UINT32* ptr_bytes_written,
-                 SampleType* ptr_out_data);
-    HRESULT Write(SampleType* ptr_data, UINT32 length_in_bytes);
-    UINT32 BytesToSamples(UINT32 num_bytes)
-    {
-        return num_bytes + (sample_size_ - 1) / sample_size;
-    };
-    UINT32 SamplesToBytes(UINT32 num_samples)
-    {
-        return num_samples * sample_size_;
-    };
-private:
-    const UINT32 sample_size_;
-    typedef std::vector<SampleType> SampleBuffer;
-    SampleBuffer audio_buf_;
-    DISALLOW_COPY_AND_ASSIGN(AudioBufferTemplate);
-};
-
+// Holds the samples between |AudioPlaybackDevice::WriteAudioBuffer| and the
+// thread that copies them into the DirectSound buffer.  The storage is a
+// fixed-size single-producer/single-consumer ring (WebmUtil::RingBuffer), so
+// the two threads don't need a lock, and reads and writes cost a copy of the
+// samples, not an erase from the front of a vector.
 class AudioBuffer
 {
 public:
     AudioBuffer();
     virtual ~AudioBuffer();
-    virtual HRESULT Available(UINT32* ptr_num_samples, 
-                              UINT32* ptr_num_bytes) = 0;
+    // Allocates room for (at least) |capacity_in_bytes| bytes.  Not thread
+    // safe.
+    HRESULT Init(UINT32 capacity_in_bytes);
+    virtual HRESULT Available(UINT32* ptr_num_samples,
+                              UINT32* ptr_num_bytes);
     UINT32 GetSampleSize()
     {
         return sample_size_;
     };
+    // Consumer: copies at most |max_bytes| bytes (whole samples only) to
+    // |ptr_out_data|.  Returns S_FALSE when the buffer is empty.
     virtual HRESULT Read(UINT32 max_bytes, UINT32* ptr_bytes_written,
-                         void* ptr_out_data) = 0;
+                         void* ptr_out_data);
+    // Producer: copies as many whole samples as fit.  Returns S_FALSE when
+    // only some of them (or none) fit.
     virtual HRESULT Write(const void* const ptr_data,
                           UINT32 length_in_bytes,
-                          UINT32* ptr_samples_written) = 0;
+                          UINT32* ptr_samples_written);
     UINT64 BytesToSamples(UINT64 num_bytes)
     {
-        return num_bytes + (sample_size_ - 1) / sample_size_;
+        return num_bytes / sample_size_;
     };
     UINT64 SamplesToBytes(UINT64 num_samples)
     {
@@ -73,6 +62,7 @@ public:
     };
     UINT32 sample_size_;
 private:
+    WebmUtil::RingBuffer ring_;
     DISALLOW_COPY_AND_ASSIGN(AudioBuffer);
 };
 
@@ -81,32 +71,7 @@ class F32AudioBuffer : public AudioBuffer
 public:
     F32AudioBuffer();
     virtual ~F32AudioBuffer();
-    virtual HRESULT Available(UINT32* ptr_num_samples, 
-                              UINT32* ptr_num_bytes)
-    {
-        if (!ptr_num_samples || !ptr_num_bytes)
-        {
-            return E_INVALIDARG;
-        }
-        *ptr_num_samples = (UINT32)audio_buf_.size();
-        if (*ptr_num_samples)
-        {
-            *ptr_num_bytes = (UINT32)SamplesToBytes(*ptr_num_samples);
-        }
-        else
-        {
-            *ptr_num_bytes = 0;
-        }
-        return S_OK;
-    };
-    virtual HRESULT Read(UINT32 max_bytes, UINT32* ptr_bytes_written,
-                         void* ptr_out_data);
-    virtual HRESULT Write(const void* const ptr_data,
-                          UINT32 length_in_bytes,
-                          UINT32* ptr_samples_written);
 private:
-    typedef std::vector<float> SampleBuffer;
-    SampleBuffer audio_buf_;
     DISALLOW_COPY_AND_ASSIGN(F32AudioBuffer);
 };
 
@@ -115,32 +80,7 @@ class S16AudioBuffer : public AudioBuffer
 public:
     S16AudioBuffer();
     virtual ~S16AudioBuffer();
-    virtual HRESULT Available(UINT32* ptr_num_samples, 
-                              UINT32* ptr_num_bytes)
-    {
-        if (!ptr_num_samples || !ptr_num_bytes)
-        {
-            return E_INVALIDARG;
-        }
-        *ptr_num_samples = (UINT32)audio_buf_.size();
-        if (*ptr_num_samples)
-        {
-            *ptr_num_bytes = (UINT32)SamplesToBytes(*ptr_num_samples);
-        }
-        else
-        {
-            *ptr_num_bytes = 0;
-        }
-        return S_OK;
-    };
-    virtual HRESULT Read(UINT32 max_bytes, UINT32* ptr_bytes_written,
-                         void* ptr_out_data);
-    virtual HRESULT Write(const void* const ptr_data,
-                          UINT32 length_in_bytes,
-                          UINT32* ptr_samples_written);
 private:
-    typedef std::vector<INT16> SampleBuffer;
-    SampleBuffer audio_buf_;
     DISALLOW_COPY_AND_ASSIGN(S16AudioBuffer);
 };
 
@@ -154,28 +94,56 @@ public:
     HRESULT Play();
     HRESULT Start();
     HRESULT Stop();
+    // Buffers the samples for playback.  Call from one thread only.  While
+    // playing, this waits for room when the buffer is full; otherwise it
+    // buffers what fits, and returns S_FALSE if that wasn't everything.
     HRESULT WriteAudioBuffer(const void* const ptr_samples,
                              UINT32 length_in_bytes);
     HRESULT GetMediaTimePlayed(INT64* ptr_100ns_ticks_played);
+    // The counters are updated without the device lock (see
+    // |samples_buffered_|), so these may be called from any thread.
     UINT64 GetSamplesBuffered() const
     {
-        return samples_buffered_;
+        return LoadCount_(&samples_buffered_);
     };
     UINT64 GetSamplesPlayed() const
     {
-        return samples_played_;
+        return LoadCount_(&samples_played_);
     };
 private:
     // TODO(tomfinegan): hide implementation w/opaque ptr (would be nice if
     //                   the public interface worked w/SDL too)
     static DWORD DSoundWriterThread_(void* ptr_this);
-    HRESULT CreateAudioBuffer_(WORD fmt_tag, WORD bits);
+    HRESULT CreateAudioBuffer_(const WAVEFORMATEXTENSIBLE* const ptr_wfx);
     HRESULT CreateDirectSoundBuffer_(
         const WAVEFORMATEXTENSIBLE* const ptr_wfx);
+    HRESULT SetNotificationPositions_();
     HRESULT WriteDSoundBuffer_();
     void UpdateSamplesPlayed_();
-    AudioPlaybackState state_;
+    // Reads a 64-bit counter in one piece, which a plain read doesn't do
+    // on 32-bit builds.
+    static UINT64 LoadCount_(const volatile LONGLONG* ptr_count)
+    {
+        return InterlockedCompareExchange64(
+            const_cast<volatile LONGLONG*>(ptr_count), 0, 0);
+    };
+    AudioPlaybackState GetState_() const
+    {
+        return static_cast<AudioPlaybackState>(state_);
+    };
+    void SetState_(AudioPlaybackState state)
+    {
+        InterlockedExchange(&state_, state);
+    };
+    // An |AudioPlaybackState|; read by |WriteAudioBuffer| and
+    // |DSoundWriterThread_| while another thread changes it.
+    volatile LONG state_;
     DWORD play_cursor_;
+    // Where the next write to |ptr_dsound_buf_| goes.  We keep track of this
+    // ourselves: writing at the write cursor would overwrite samples that
+    // have not been played yet.
+    DWORD write_offset_;
+    DWORD block_align_;
     HWND hwnd_;
     IDirectSound8* ptr_dsound_;
     IDirectSoundBuffer8* ptr_dsound_buf_;
@@ -184,9 +152,17 @@ private:
     //                   |ptr_dsound_thread_event_|
     std::auto_ptr<WebmMfUtil::EventWaiter> ptr_dsound_thread_event_;
     std::auto_ptr<WebmMfUtil::SimpleThread> ptr_dsound_thread_;
+    // Wakes |DSoundWriterThread_|; set by DirectSound when the play cursor
+    // passes a notification position, and when samples are written.
+    HANDLE wake_event_;
+    // Set by |DSoundWriterThread_| when it makes room in |ptr_audio_buf_|.
+    HANDLE space_event_;
     UINT32 dsound_buffer_size_;
-    UINT64 samples_buffered_;
-    UINT64 samples_played_;
+    // Each counter has a single writer (|WriteAudioBuffer| and
+    // |DSoundWriterThread_| respectively), and is read from other threads;
+    // both are updated with interlocked operations.
+    volatile LONGLONG samples_buffered_;
+    volatile LONGLONG samples_played_;
     DISALLOW_COPY_AND_ASSIGN(AudioPlaybackDevice);
 };
 
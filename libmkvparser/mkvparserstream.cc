@@ -10,6 +10,7 @@
 #include "mkvparserstream.h"
 #include "mkvparser.hpp"
 #include "mkvparserstreamreader.h"
+#include "iexternalbuffersample.h"
 #include <cassert>
 #include <sstream>
 #include <iomanip>
@@ -618,6 +619,89 @@ HRESULT Stream::PopulateSamples(const samples_t& samples)
 }
 
 
+long Stream::ReadFrame(
+    const BlockEntry* pBE,
+    int idx,
+    IMediaSample* pSample) const
+{
+    assert(pBE);
+    assert(!pBE->EOS());
+    assert(pSample);
+
+    const Block* const pBlock = pBE->GetBlock();
+    assert(pBlock);
+
+    const Block::Frame& f = pBlock->GetFrame(idx);
+
+    const LONG srcsize = f.len;
+    assert(srcsize >= 0);
+
+    IMkvReader* const pReader_ = m_pTrack->m_pSegment->m_pReader;
+
+    using mkvparser::IStreamReader;
+    IStreamReader* const pReader = static_cast<IStreamReader*>(pReader_);
+
+    //The pages of the current block are already locked (see SetCurr),
+    //so the only thing the reader has to determine here is whether
+    //the frame payload is contiguous in memory.  If it is, then the
+    //sample points directly into the page cache, and the pages stay
+    //locked until the downstream filter releases the sample.
+
+    IExternalBufferSample* pExt;
+
+    HRESULT hr = pSample->QueryInterface(&pExt);
+
+    if (SUCCEEDED(hr))
+    {
+        unsigned char* ptr;
+        IUnknown* pOwner;
+
+        hr = pReader->LockFrame(f, ptr, pOwner);
+
+        if (hr == S_OK)
+        {
+            assert(ptr);
+            assert(pOwner);
+
+            hr = pExt->Attach(ptr, srcsize, pOwner);
+            assert(SUCCEEDED(hr));
+
+            pOwner->Release();  //sample holds its own reference
+        }
+
+        pExt->Release();
+
+        if (hr == S_OK)
+        {
+            hr = pSample->SetActualDataLength(srcsize);
+            assert(SUCCEEDED(hr));
+
+            return srcsize;
+        }
+    }
+
+    const long tgtsize = pSample->GetSize();
+    tgtsize;
+    assert(tgtsize >= 0);
+    assert(tgtsize >= srcsize);
+
+    BYTE* ptr;
+
+    hr = pSample->GetPointer(&ptr);  //read srcsize bytes
+    assert(SUCCEEDED(hr));
+    assert(ptr);
+
+    const long status = f.Read(pReader, ptr);
+    status;
+    assert(status == 0);  //all bytes were read
+
+    hr = pSample->SetActualDataLength(srcsize);
+    assert(SUCCEEDED(hr));
+
+    return srcsize;
+}
+
+
 //bool Stream::SendPreroll(IMediaSample*)
 //{
 //    return false;
@@ -90,6 +90,11 @@ protected:
                 const BlockEntry*,
                 const samples_t&) const = 0;
 
+    //Makes the sample refer to the payload of the frame (of the given
+    //block) in place, if the reader allows it, else copies the payload
+    //into the sample's own buffer.  Returns the payload length.
+    long ReadFrame(const BlockEntry*, int idx, IMediaSample*) const;
+
 private:
 
     const BlockEntry* m_pLocked;
@@ -512,7 +512,6 @@ void AudioStream::OnPopulateSample(
     assert(start_ns >= base_ns);
 
     Segment* const pSegment = m_pTrack->m_pSegment;
-    IMkvReader* const pFile = pSegment->m_pReader;
 
     __int64 stop_ns;
 
@@ -565,26 +564,11 @@ void AudioStream::OnPopulateSample(
     {
         IMediaSample* const pSample = samples[idx];
 
-        const Block::Frame& f = pCurrBlock->GetFrame(idx);
-
-        const LONG srcsize = f.len;
+        const long srcsize = ReadFrame(m_pCurr, idx, pSample);
+        srcsize;
         assert(srcsize >= 0);
 
-        const long tgtsize = pSample->GetSize();
-        tgtsize;
-        assert(tgtsize >= 0);
-        assert(tgtsize >= srcsize);
-
-        BYTE* ptr;
-
-        HRESULT hr = pSample->GetPointer(&ptr);
-        assert(SUCCEEDED(hr));
-        assert(ptr);
-
-        const long status = f.Read(pFile, ptr);
-        assert(status == 0);  //all bytes were read
-
-        hr = pSample->SetActualDataLength(srcsize);
+        HRESULT hr;
 
         hr = pSample->SetPreroll(FALSE);
         assert(SUCCEEDED(hr));
@@ -21,4 +21,15 @@ void IStreamReader::UnlockPages(const BlockEntry*)
 {
 }
 
+HRESULT IStreamReader::LockFrame(
+    const Block::Frame&,
+    unsigned char*& ptr,
+    IUnknown*& pOwner)
+{
+    ptr = 0;
+    pOwner = 0;
+
+    return S_FALSE;  //caller must copy
+}
+
 }  //end namespace mkvparser
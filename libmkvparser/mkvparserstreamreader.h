@@ -17,6 +17,15 @@ namespace mkvparser
         virtual HRESULT LockPages(const BlockEntry*);
         virtual void UnlockPages(const BlockEntry*);
 
+        //Returns S_OK if the frame payload can be read in place, in
+        //which case ptr points to it, and the owner (whose reference
+        //the caller now holds) keeps the memory locked until it is
+        //released.  Returns S_FALSE when the frame must be copied.
+        virtual HRESULT LockFrame(
+                            const Block::Frame&,
+                            unsigned char*& ptr,
+                            IUnknown*& pOwner);
+
     };
 
 }  //end namespace mkvparser
@@ -368,7 +368,6 @@ void VideoStream::OnPopulateSample(
     //assert(base_ns >= 0);
 
     Segment* const pSegment = m_pTrack->m_pSegment;
-    IMkvReader* const pFile = pSegment->m_pReader;
 
     const bool bKey = pCurrBlock->IsKey();
     assert(!m_bDiscontinuity || bKey);
@@ -423,26 +422,11 @@ void VideoStream::OnPopulateSample(
     {
         IMediaSample* const pSample = samples[idx];
 
-        const Block::Frame& f = pCurrBlock->GetFrame(idx);
-
-        const LONG srcsize = f.len;
+        const long srcsize = ReadFrame(m_pCurr, idx, pSample);
+        srcsize;
         assert(srcsize >= 0);
 
-        const long tgtsize = pSample->GetSize();
-        tgtsize;
-        assert(tgtsize >= 0);
-        assert(tgtsize >= srcsize);
-
-        BYTE* ptr;
-
-        HRESULT hr = pSample->GetPointer(&ptr);  //read srcsize bytes
-        assert(SUCCEEDED(hr));
-        assert(ptr);
-
-        const long status = f.Read(pFile, ptr);
-        assert(status == 0);  //all bytes were read
-
-        hr = pSample->SetActualDataLength(srcsize);
+        HRESULT hr;
 
         hr = pSample->SetPreroll(bInvisible ? TRUE : FALSE);
         assert(SUCCEEDED(hr));
@@ -0,0 +1,624 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "makewebmapp.h"
+#include "batchrunner.h"
+#include "jsonwriter.h"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <process.h>
+#include <shellapi.h>
+#include "webmtypes.h"
+#include "vp8encoderidl.h"
+#include "webmmuxidl.h"
+using std::wcout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+using std::string;
+using std::wstring;
+using std::ostringstream;
+using JsonWriter::WriteString;
+using JsonWriter::WriteNumber;
+
+extern HANDLE g_hQuit;
+
+
+BatchRunner::BatchRunner() :
+    m_next(-1),
+    m_done(0),
+    m_freq(1)
+{
+    InitializeCriticalSection(&m_cs);
+
+    LARGE_INTEGER f;
+
+    if (QueryPerformanceFrequency(&f) && (f.QuadPart > 0))
+        m_freq = f.QuadPart;
+}
+
+
+BatchRunner::~BatchRunner()
+{
+    Unload();
+    DeleteCriticalSection(&m_cs);
+}
+
+
+int BatchRunner::operator()(
+    const wchar_t* batch,
+    int workers,
+    const wchar_t* report)
+{
+    assert(batch);
+
+    int status = Load(batch);
+
+    if (status)
+        return status;
+
+    const int njobs = static_cast<int>(m_jobs.size());
+
+    if (njobs <= 0)
+    {
+        wcout << L"Batch file \"" << batch << L"\" lists no jobs." << endl;
+        return 1;
+    }
+
+    if (workers <= 0)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        workers = static_cast<int>(info.dwNumberOfProcessors);
+    }
+
+    if (workers > njobs)
+        workers = njobs;
+
+    if (workers > CmdLine::kMaxBatchJobs)
+        workers = CmdLine::kMaxBatchJobs;
+
+    wcout << L"Running " << njobs
+          << L" job" << (njobs == 1 ? L"" : L"s")
+          << L" (" << workers << L" at a time)."
+          << endl;
+
+    Preload();
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
+    m_next = -1;
+    m_done = 0;
+
+    std::vector<HANDLE> threads;
+
+    for (int i = 0; i < workers; ++i)
+    {
+        const uintptr_t h = _beginthreadex(
+                                0,  //security
+                                0,  //stack size
+                                &BatchRunner::ThreadProc,
+                                this,
+                                0,  //run immediately
+                                0);  //thread id
+
+        if (h == 0)
+            break;
+
+        threads.push_back(reinterpret_cast<HANDLE>(h));
+    }
+
+    if (threads.empty())
+    {
+        wcout << L"Unable to create batch worker threads." << endl;
+
+        Unload();
+        return 1;
+    }
+
+    //The threads all finish once the jobs have been taken (or the user
+    //quits, in which case the running jobs stop early).  There can't
+    //be more than kMaxBatchJobs of them, which is the wait limit.
+
+    const DWORD nh = static_cast<DWORD>(threads.size());
+
+    const DWORD dw = WaitForMultipleObjects(nh, &threads[0], TRUE, INFINITE);
+    dw;
+    assert(dw < (WAIT_OBJECT_0 + nh));
+
+    for (DWORD i = 0; i < nh; ++i)
+    {
+        const BOOL b = CloseHandle(threads[i]);
+        b;
+        assert(b);
+    }
+
+    LARGE_INTEGER stop;
+    QueryPerformanceCounter(&stop);
+
+    Unload();
+
+    const double wall_sec = double(stop.QuadPart - start.QuadPart) / m_freq;
+
+    int failed = 0;
+
+    for (jobs_t::const_iterator i = m_jobs.begin(); i != m_jobs.end(); ++i)
+    {
+        if (i->status != 0)
+            ++failed;
+    }
+
+    wcout << L"Batch complete: "
+          << (njobs - failed) << L" of " << njobs << L" succeeded ("
+          << fixed << setprecision(1) << wall_sec << L" s)."
+          << endl;
+
+    wstring path;
+
+    if (report)
+        path = report;
+    else
+    {
+        path = batch;
+        path += L".report.json";
+    }
+
+    status = WriteReport(path.c_str(), wall_sec);
+
+    if (status)
+        return status;
+
+    return failed ? 1 : 0;
+}
+
+
+int BatchRunner::Load(const wchar_t* batch)
+{
+    FILE* f;
+
+    errno_t e = _wfopen_s(&f, batch, L"rb");
+
+    if (e)
+    {
+        wcout << L"Unable to open batch file \"" << batch << L"\"." << endl;
+        return 1;
+    }
+
+    std::vector<char> buf;
+
+    for (;;)
+    {
+        char tmp[4096];
+
+        const size_t n = fread(tmp, 1, sizeof tmp, f);
+
+        if (n == 0)
+            break;
+
+        buf.insert(buf.end(), tmp, tmp + n);
+    }
+
+    fclose(f);
+
+    //The batch file is either UTF-16 (with a BOM, as saved by Notepad
+    //"Unicode") or UTF-8 (with or without a BOM); plain ASCII is UTF-8.
+
+    wstring text;
+
+    const size_t len = buf.size();
+
+    if ((len >= 2) && (buf[0] == '\xFF') && (buf[1] == '\xFE'))
+    {
+        if (len > 2)
+        {
+            const wchar_t* const ptr = reinterpret_cast<wchar_t*>(&buf[2]);
+            text.assign(ptr, (len - 2) / sizeof(wchar_t));
+        }
+    }
+    else if (len > 0)
+    {
+        size_t off = 0;
+
+        if ((len >= 3) &&
+            (buf[0] == '\xEF') &&
+            (buf[1] == '\xBB') &&
+            (buf[2] == '\xBF'))
+        {
+            off = 3;
+        }
+
+        int n = 0;
+
+        if (len > off)
+        {
+            n = MultiByteToWideChar(
+                    CP_UTF8,
+                    0,
+                    &buf[off],
+                    static_cast<int>(len - off),
+                    0,
+                    0);
+        }
+
+        if (n > 0)
+        {
+            text.resize(n);
+
+            MultiByteToWideChar(
+                CP_UTF8,
+                0,
+                &buf[off],
+                static_cast<int>(len - off),
+                &text[0],
+                n);
+        }
+    }
+
+    m_jobs.clear();
+
+    wstring::size_type pos = 0;
+    int line = 0;
+
+    while (pos < text.length())
+    {
+        wstring::size_type end = text.find(L'\n', pos);
+
+        if (end == wstring::npos)
+            end = text.length();
+
+        wstring str = text.substr(pos, end - pos);
+        pos = end + 1;
+        ++line;
+
+        const wstring::size_type first = str.find_first_not_of(L" \t\r");
+
+        if (first == wstring::npos)  //blank line
+            continue;
+
+        if (str[first] == L'#')  //comment
+            continue;
+
+        const wstring::size_type last = str.find_last_not_of(L" \t\r");
+        assert(last != wstring::npos);
+
+        Job job;
+
+        job.line = line;
+        job.cmdline = str.substr(first, last + 1 - first);
+        job.status = -1;
+        job.wall_sec = 0;
+        job.media_sec = -1;
+        job.framerate = -1;
+        job.output_bytes = -1;
+
+        m_jobs.push_back(job);
+    }
+
+    return 0;
+}
+
+
+void BatchRunner::Preload()
+{
+    assert(m_factories.empty());
+
+    //These are the filters that makewebm creates by CLSID.  (The decoders
+    //upstream of the encoders are found by the graph builder, and so are
+    //loaded by the first job that needs them, and stay loaded because
+    //the other jobs still hold them.)
+
+    const CLSID* const clsids[] =
+    {
+        &CLSID_FilterGraphNoThread,
+        &WebmTypes::CLSID_WebmSplit,
+        &WebmTypes::CLSID_WebmOggSource,
+        &WebmTypes::CLSID_WebmVorbisEncoder,
+        &CLSID_VP8Encoder,
+        &CLSID_WebmMux,
+        &CLSID_FileWriter
+    };
+
+    enum { n = sizeof(clsids) / sizeof(clsids[0]) };
+
+    for (int i = 0; i < n; ++i)
+    {
+        IClassFactory* pFactory;
+
+        const HRESULT hr = CoGetClassObject(
+                            *clsids[i],
+                            CLSCTX_INPROC_SERVER,
+                            0,
+                            __uuidof(IClassFactory),
+                            (void**)&pFactory);
+
+        if (FAILED(hr))  //the job that needs it will report the error
+            continue;
+
+        const HRESULT hrLock = pFactory->LockServer(TRUE);
+
+        if (FAILED(hrLock))
+        {
+            pFactory->Release();
+            continue;
+        }
+
+        m_factories.push_back(pFactory);
+    }
+}
+
+
+void BatchRunner::Unload()
+{
+    while (!m_factories.empty())
+    {
+        IClassFactory* const pFactory = m_factories.back();
+        m_factories.pop_back();
+
+        pFactory->LockServer(FALSE);
+        pFactory->Release();
+    }
+}
+
+
+unsigned BatchRunner::ThreadProc(void* pv)
+{
+    BatchRunner* const pRunner = static_cast<BatchRunner*>(pv);
+    assert(pRunner);
+
+    //Each job's graph lives on the thread that built it, and is run from
+    //that thread's message loop (see App::RunGraph).
+
+    const HRESULT hr = CoInitialize(0);
+
+    if (FAILED(hr))
+        return 1;
+
+    pRunner->Main();
+
+    CoUninitialize();
+
+    return 0;
+}
+
+
+void BatchRunner::Main()
+{
+    const LONG njobs = static_cast<LONG>(m_jobs.size());
+
+    for (;;)
+    {
+        if (WaitForSingleObject(g_hQuit, 0) == WAIT_OBJECT_0)
+            return;
+
+        const LONG index = InterlockedIncrement(&m_next);
+
+        if (index >= njobs)
+            return;
+
+        Job& job = m_jobs[index];
+
+        Run(job);
+
+        const LONG done = InterlockedIncrement(&m_done);
+
+        EnterCriticalSection(&m_cs);
+
+        wcout << L"[" << done << L"/" << njobs << L"] line " << job.line
+              << (job.status ? L" FAILED: " : L" done: ")
+              << (job.output.empty() ? job.cmdline : job.output)
+              << L" (" << fixed << setprecision(1) << job.wall_sec << L" s";
+
+        if ((job.media_sec > 0) && (job.framerate > 0) && (job.wall_sec > 0))
+        {
+            const double frames = job.media_sec * job.framerate;
+
+            wcout << L", " << setprecision(1)
+                  << (frames / job.wall_sec) << L" fps";
+        }
+
+        wcout << L")" << endl;
+
+        LeaveCriticalSection(&m_cs);
+    }
+}
+
+
+void BatchRunner::Run(Job& job)
+{
+    //The job's command line is parsed the same way as our own, so quoting
+    //rules are the same as at the command prompt.
+
+    const wstring cmdline = L"makewebm " + job.cmdline;
+
+    int argc;
+    wchar_t** const argv_ = CommandLineToArgvW(cmdline.c_str(), &argc);
+
+    if (argv_ == 0)
+    {
+        job.status = 1;
+        return;
+    }
+
+    //CmdLine::Parse rearranges the argv array, so it gets a copy.
+
+    std::vector<wchar_t*> argv(argv_, argv_ + argc);
+    argv.push_back(0);
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
+    App app;
+    app.SetBatchJob();
+
+    job.status = app(argc, &argv[0]);
+
+    LARGE_INTEGER stop;
+    QueryPerformanceCounter(&stop);
+
+    LocalFree(argv_);
+
+    job.wall_sec = double(stop.QuadPart - start.QuadPart) / m_freq;
+
+    const App::Result& result = app.GetResult();
+
+    job.output = result.output;
+    job.media_sec = result.media_sec;
+    job.framerate = result.framerate;
+
+    if (job.output.empty())
+        return;
+
+    WIN32_FILE_ATTRIBUTE_DATA data;
+
+    const BOOL b = GetFileAttributesEx(
+                    job.output.c_str(),
+                    GetFileExInfoStandard,
+                    &data);
+
+    if (b)
+    {
+        ULARGE_INTEGER size;
+
+        size.LowPart = data.nFileSizeLow;
+        size.HighPart = data.nFileSizeHigh;
+
+        job.output_bytes = static_cast<__int64>(size.QuadPart);
+    }
+}
+
+
+int BatchRunner::WriteReport(const wchar_t* path, double wall_sec) const
+{
+    ostringstream os;
+
+    os << "{\n";
+    os << "  \"wall_sec\": ";
+    WriteNumber(os, wall_sec, 3);
+    os << ",\n";
+    os << "  \"jobs\": [";
+
+    for (jobs_t::size_type i = 0; i < m_jobs.size(); ++i)
+    {
+        const Job& job = m_jobs[i];
+
+        os << (i ? ",\n" : "\n");
+        os << "    {\n";
+
+        os << "      \"line\": " << job.line << ",\n";
+
+        os << "      \"command\": ";
+        WriteString(os, job.cmdline);
+        os << ",\n";
+
+        os << "      \"output\": ";
+
+        if (job.output.empty())
+            os << "null";
+        else
+            WriteString(os, job.output);
+
+        os << ",\n";
+
+        os << "      \"status\": ";
+
+        if (job.status < 0)
+            os << "\"skipped\"";
+        else if (job.status == 0)
+            os << "\"ok\"";
+        else
+            os << "\"failed\"";
+
+        os << ",\n";
+
+        const bool bRan = (job.status >= 0);
+
+        os << "      \"wall_sec\": ";
+        WriteNumber(os, bRan ? job.wall_sec : -1, 3);
+        os << ",\n";
+
+        os << "      \"media_sec\": ";
+        WriteNumber(os, job.media_sec, 3);
+        os << ",\n";
+
+        //Frames encoded per second of wall time (from the duration that
+        //was encoded and the frame rate of the input), and how much
+        //faster than real time that was.
+
+        double fps = -1;
+        double speed = -1;
+
+        if (bRan && (job.wall_sec > 0) && (job.media_sec >= 0))
+        {
+            speed = job.media_sec / job.wall_sec;
+
+            if (job.framerate > 0)
+                fps = speed * job.framerate;
+        }
+
+        os << "      \"fps\": ";
+        WriteNumber(os, fps, 2);
+        os << ",\n";
+
+        os << "      \"speed\": ";
+        WriteNumber(os, speed, 3);
+        os << ",\n";
+
+        os << "      \"output_bytes\": ";
+
+        if (job.output_bytes < 0)
+            os << "null";
+        else
+            os << job.output_bytes;
+
+        os << ",\n";
+
+        double kbps = -1;
+
+        if ((job.output_bytes >= 0) && (job.media_sec > 0))
+            kbps = double(job.output_bytes) * 8 / 1000 / job.media_sec;
+
+        os << "      \"bitrate_kbps\": ";
+        WriteNumber(os, kbps, 1);
+        os << "\n";
+
+        os << "    }";
+    }
+
+    os << "\n  ]\n";
+    os << "}\n";
+
+    FILE* f;
+
+    const errno_t e = _wfopen_s(&f, path, L"wb");
+
+    if (e)
+    {
+        wcout << L"Unable to create batch report \"" << path << L"\"." << endl;
+        return 1;
+    }
+
+    const string s = os.str();
+    const size_t n = fwrite(s.data(), 1, s.length(), f);
+
+    fclose(f);
+
+    if (n != s.length())
+    {
+        wcout << L"Unable to write batch report \"" << path << L"\"." << endl;
+        return 1;
+    }
+
+    wcout << L"Batch report: " << path << endl;
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <objbase.h>
+#include <string>
+#include <vector>
+
+//Runs the jobs listed in a batch file, several at a time, in this process.
+//
+//Each (non-blank) line of the batch file holds the command line of one
+//job, exactly as it would be passed to makewebm (input, output and
+//encoder options); lines beginning with '#' are comments.  Each job gets a
+//graph of its own, built and run on one of the worker threads.  A filter
+//instance can't be shared between graphs, so what is shared instead are
+//the filter DLLs: their class factories are created once, up front, and
+//kept locked for the life of the batch, so that building a job's graph
+//doesn't have to find and load the filters again.
+//
+//When the batch completes, a report (in JSON) is written with the wall
+//time, frame rate and output bitrate of each job.
+
+class BatchRunner
+{
+    BatchRunner(const BatchRunner&);
+    BatchRunner& operator=(const BatchRunner&);
+
+public:
+
+    BatchRunner();
+    ~BatchRunner();
+
+    //Workers <= 0 means one per processor; report can be NULL, to use a
+    //name derived from the batch file.  Returns 0 if every job succeeded.
+    int operator()(const wchar_t* batch, int workers, const wchar_t* report);
+
+private:
+
+    struct Job
+    {
+        int line;
+        std::wstring cmdline;
+        std::wstring output;
+        int status;         //exit status of the job (-1 if never run)
+        double wall_sec;
+        double media_sec;   //-1 if unknown
+        double framerate;   //-1 if unknown
+        __int64 output_bytes;  //-1 if no output
+    };
+
+    typedef std::vector<Job> jobs_t;
+    jobs_t m_jobs;
+
+    volatile LONG m_next;
+    volatile LONG m_done;
+    CRITICAL_SECTION m_cs;  //serializes the console
+    __int64 m_freq;
+
+    typedef std::vector<IClassFactory*> factories_t;
+    factories_t m_factories;
+
+    int Load(const wchar_t*);
+    void Preload();
+    void Unload();
+
+    static unsigned __stdcall ThreadProc(void*);
+    void Main();
+    void Run(Job&);
+
+    int WriteReport(const wchar_t*, double) const;
+
+};
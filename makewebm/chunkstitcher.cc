@@ -0,0 +1,664 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <windows.h>
+#include "chunkstitcher.h"
+#include "mkvparser.hpp"
+#include "mkvmuxer.hpp"
+#include "mkvwriter.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <new>
+using std::wcout;
+using std::endl;
+using std::wstring;
+
+namespace
+{
+    enum
+    {
+        kTrackTypeVideo = 1,
+        kTrackTypeAudio = 2
+    };
+
+    __int64 GetTime(const mkvparser::BlockEntry* pEntry)
+    {
+        assert(pEntry);
+        assert(!pEntry->EOS());
+
+        const mkvparser::Block* const pBlock = pEntry->GetBlock();
+        assert(pBlock);
+
+        return pBlock->GetTime(pEntry->GetCluster());
+    }
+
+    bool CopyTrackHeader(
+        const mkvparser::Track* pSrc,
+        mkvmuxer::Track* pDst)
+    {
+        assert(pSrc);
+        assert(pDst);
+
+        if (const char* const id = pSrc->GetCodecId())
+            pDst->set_codec_id(id);
+
+        size_t cp_size;
+        const unsigned char* const cp = pSrc->GetCodecPrivate(cp_size);
+
+        if ((cp == 0) || (cp_size == 0))
+            return true;
+
+        return pDst->SetCodecPrivate(cp, cp_size);
+    }
+}
+
+
+class ChunkStitcher::File : public mkvparser::IMkvReader
+{
+    File(const File&);
+    File& operator=(const File&);
+
+public:
+
+    File();
+    virtual ~File();
+
+    //Opens the file, and finds its (first) track of the given type.
+    int Open(const wchar_t*, long long type);
+
+    int Read(long long pos, long len, unsigned char* buf);
+    int Length(long long* total, long long* available);
+
+    const mkvparser::Track* GetTrack() const;
+
+    //These return 0 when there are no more blocks.
+    const mkvparser::BlockEntry* GetFirst() const;
+    const mkvparser::BlockEntry* GetNext(const mkvparser::BlockEntry*) const;
+
+private:
+
+    FILE* m_file;
+    long long m_length;
+    mkvparser::Segment* m_pSegment;
+    const mkvparser::Track* m_pTrack;
+
+};
+
+
+ChunkStitcher::File::File() :
+    m_file(0),
+    m_length(0),
+    m_pSegment(0),
+    m_pTrack(0)
+{
+}
+
+
+ChunkStitcher::File::~File()
+{
+    delete m_pSegment;
+
+    if (m_file)
+        fclose(m_file);
+}
+
+
+int ChunkStitcher::File::Open(const wchar_t* filename, long long type)
+{
+    assert(filename);
+    assert(m_file == 0);
+
+    if ((_wfopen_s(&m_file, filename, L"rb") != 0) || (m_file == 0))
+    {
+        m_file = 0;
+
+        wcout << L"Unable to open chunk file \"" << filename << L"\"."
+              << endl;
+
+        return 1;
+    }
+
+    if ((_fseeki64(m_file, 0, SEEK_END) != 0) ||
+        ((m_length = _ftelli64(m_file)) < 0))
+    {
+        wcout << L"Unable to determine size of chunk file \""
+              << filename << L"\"." << endl;
+
+        return 1;
+    }
+
+    long long pos = 0;
+
+    mkvparser::EBMLHeader h;
+
+    if (h.Parse(this, pos) < 0)
+    {
+        wcout << L"Chunk file \"" << filename
+              << L"\" does not have a valid EBML header." << endl;
+
+        return 1;
+    }
+
+    long status = mkvparser::Segment::CreateInstance(this, pos, m_pSegment);
+
+    if ((status != 0) || (m_pSegment == 0))
+    {
+        wcout << L"Chunk file \"" << filename
+              << L"\" does not have a valid segment." << endl;
+
+        return 1;
+    }
+
+    status = m_pSegment->Load();
+
+    if (status < 0)
+    {
+        wcout << L"Unable to load chunk file \"" << filename << L"\"."
+              << endl;
+
+        return 1;
+    }
+
+    const mkvparser::Tracks* const pTracks = m_pSegment->GetTracks();
+
+    if (pTracks)
+    {
+        const unsigned long n = pTracks->GetTracksCount();
+
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            const mkvparser::Track* const pTrack = pTracks->GetTrackByIndex(i);
+
+            if ((pTrack != 0) && (pTrack->GetType() == type))
+            {
+                m_pTrack = pTrack;
+                return 0;
+            }
+        }
+    }
+
+    wcout << L"Chunk file \"" << filename << L"\" does not have "
+          << ((type == kTrackTypeVideo) ? L"a video" : L"an audio")
+          << L" track." << endl;
+
+    return 1;
+}
+
+
+int ChunkStitcher::File::Read(long long pos, long len, unsigned char* buf)
+{
+    assert(m_file);
+
+    if ((pos < 0) || (len < 0))
+        return -1;
+
+    if (len == 0)
+        return 0;
+
+    if (_fseeki64(m_file, pos, SEEK_SET) != 0)
+        return -1;
+
+    const size_t n = fread(buf, 1, len, m_file);
+
+    return (n == size_t(len)) ? 0 : -1;
+}
+
+
+int ChunkStitcher::File::Length(long long* total, long long* available)
+{
+    if (total)
+        *total = m_length;
+
+    if (available)
+        *available = m_length;
+
+    return 0;
+}
+
+
+const mkvparser::Track* ChunkStitcher::File::GetTrack() const
+{
+    return m_pTrack;
+}
+
+
+const mkvparser::BlockEntry* ChunkStitcher::File::GetFirst() const
+{
+    assert(m_pTrack);
+
+    const mkvparser::BlockEntry* pFirst;
+
+    const long status = m_pTrack->GetFirst(pFirst);
+
+    if ((status < 0) || (pFirst == 0) || pFirst->EOS())
+        return 0;
+
+    return pFirst;
+}
+
+
+const mkvparser::BlockEntry* ChunkStitcher::File::GetNext(
+    const mkvparser::BlockEntry* pCurr) const
+{
+    assert(m_pTrack);
+    assert(pCurr);
+
+    const mkvparser::BlockEntry* pNext;
+
+    const long status = m_pTrack->GetNext(pCurr, pNext);
+
+    if ((status < 0) || (pNext == 0) || pNext->EOS())
+        return 0;
+
+    return pNext;
+}
+
+
+ChunkStitcher::ChunkStitcher() : m_pAudio(0)
+{
+}
+
+
+ChunkStitcher::~ChunkStitcher()
+{
+    Close();
+}
+
+
+void ChunkStitcher::AddVideo(const wchar_t* filename, __int64 start_ns)
+{
+    assert(filename);
+    assert(start_ns >= 0);
+    assert(m_chunks.empty() || (start_ns >= m_chunks.back().start_ns));
+
+    Chunk c;
+
+    c.filename = filename;
+    c.start_ns = start_ns;
+    c.pFile = 0;
+    c.first_ns = _I64_MAX;
+    c.stop_ns = _I64_MAX;
+
+    m_chunks.push_back(c);
+}
+
+
+void ChunkStitcher::SetAudio(const wchar_t* filename)
+{
+    assert(filename);
+    m_audio_filename = filename;
+}
+
+
+void ChunkStitcher::Close()
+{
+    typedef chunks_t::iterator iter_t;
+
+    iter_t i = m_chunks.begin();
+    const iter_t j = m_chunks.end();
+
+    while (i != j)
+    {
+        Chunk& c = *i++;
+
+        delete c.pFile;
+        c.pFile = 0;
+    }
+
+    delete m_pAudio;
+    m_pAudio = 0;
+}
+
+
+int ChunkStitcher::Open()
+{
+    const mkvparser::VideoTrack* pFormat = 0;
+
+    typedef chunks_t::iterator iter_t;
+
+    for (iter_t i = m_chunks.begin(); i != m_chunks.end(); ++i)
+    {
+        Chunk& c = *i;
+        assert(c.pFile == 0);
+
+        c.pFile = new (std::nothrow) File;
+
+        if (c.pFile == 0)
+            return 1;
+
+        int status = c.pFile->Open(c.filename.c_str(), kTrackTypeVideo);
+
+        if (status)
+            return status;
+
+        const mkvparser::VideoTrack* const pTrack =
+            static_cast<const mkvparser::VideoTrack*>(c.pFile->GetTrack());
+
+        if (pFormat == 0)
+            pFormat = pTrack;
+
+        else if ((pTrack->GetWidth() != pFormat->GetWidth()) ||
+                 (pTrack->GetHeight() != pFormat->GetHeight()) ||
+                 (strcmp(pTrack->GetCodecId(), pFormat->GetCodecId()) != 0))
+        {
+            wcout << L"Chunk file \"" << c.filename
+                  << L"\" has a different video format from the first chunk."
+                  << endl;
+
+            return 1;
+        }
+
+        const mkvparser::BlockEntry* const pFirst = c.pFile->GetFirst();
+
+        if (pFirst == 0)  //empty range
+            continue;
+
+        if (!pFirst->GetBlock()->IsKey())
+        {
+            wcout << L"Chunk file \"" << c.filename
+                  << L"\" does not begin with a keyframe."
+                  << endl;
+
+            return 1;
+        }
+
+        c.first_ns = c.start_ns + GetTime(pFirst);
+    }
+
+    //A chunk's range extends past the start of the next range, so that
+    //no frames are lost at the boundary.  The frames in the overlap are
+    //taken from the next chunk, which begins with a keyframe.
+
+    __int64 next_ns = _I64_MAX;
+
+    typedef chunks_t::reverse_iterator riter_t;
+
+    for (riter_t i = m_chunks.rbegin(); i != m_chunks.rend(); ++i)
+    {
+        Chunk& c = *i;
+
+        c.stop_ns = next_ns;
+
+        if (c.first_ns < next_ns)
+            next_ns = c.first_ns;
+    }
+
+    if (m_audio_filename.empty())
+        return 0;
+
+    m_pAudio = new (std::nothrow) File;
+
+    if (m_pAudio == 0)
+        return 1;
+
+    return m_pAudio->Open(m_audio_filename.c_str(), kTrackTypeAudio);
+}
+
+
+const mkvparser::BlockEntry* ChunkStitcher::NextVideo(
+    chunks_t::size_type& idx,
+    const mkvparser::BlockEntry* pCurr) const
+{
+    if (pCurr)
+    {
+        const Chunk& c = m_chunks[idx];
+
+        const mkvparser::BlockEntry* const pNext = c.pFile->GetNext(pCurr);
+
+        if ((pNext != 0) && ((c.start_ns + GetTime(pNext)) < c.stop_ns))
+            return pNext;
+
+        ++idx;
+    }
+
+    while (idx < m_chunks.size())
+    {
+        const Chunk& c = m_chunks[idx];
+
+        if (c.first_ns < c.stop_ns)
+            return c.pFile->GetFirst();
+
+        ++idx;  //empty, or entirely overlapped by the chunk that follows
+    }
+
+    return 0;
+}
+
+
+int ChunkStitcher::WriteBlock(
+    mkvmuxer::Segment& segment,
+    File* pFile,
+    const mkvparser::BlockEntry* pEntry,
+    unsigned long long track,
+    __int64 time_ns)
+{
+    assert(pFile);
+    assert(pEntry);
+    assert(time_ns >= 0);
+
+    const mkvparser::Block* const pBlock = pEntry->GetBlock();
+    assert(pBlock);
+
+    //Laced frames (which the muxer doesn't produce) all get the time
+    //of their block.
+
+    const int n = pBlock->GetFrameCount();
+
+    for (int i = 0; i < n; ++i)
+    {
+        const mkvparser::Block::Frame& f = pBlock->GetFrame(i);
+
+        if (f.len <= 0)
+            continue;
+
+        if (m_buf.size() < size_t(f.len))
+            m_buf.resize(f.len);
+
+        if (pFile->Read(f.pos, f.len, &m_buf[0]) < 0)
+        {
+            wcout << L"Unable to read frame from chunk file." << endl;
+            return 1;
+        }
+
+        const bool bResult = segment.AddFrame(
+                                &m_buf[0],
+                                f.len,
+                                track,
+                                time_ns,
+                                pBlock->IsKey());
+
+        if (!bResult)
+        {
+            wcout << L"Unable to write frame to output file." << endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+int ChunkStitcher::Write(FILE* f, bool verbose)
+{
+    assert(f);
+
+    mkvmuxer::MkvWriter writer(f);
+    mkvmuxer::Segment segment;
+
+    if (!segment.Init(&writer))
+    {
+        wcout << L"Unable to initialize output segment." << endl;
+        return 1;
+    }
+
+    segment.set_mode(mkvmuxer::Segment::kFile);
+    segment.OutputCues(true);
+
+    mkvmuxer::SegmentInfo* const pInfo = segment.GetSegmentInfo();
+    assert(pInfo);
+
+    pInfo->set_writing_app("makewebm");
+
+    mkvmuxer::uint64 video_track = 0;
+
+    if (!m_chunks.empty())
+    {
+        const mkvparser::VideoTrack* const pSrc =
+            static_cast<const mkvparser::VideoTrack*>(
+                m_chunks.front().pFile->GetTrack());
+
+        video_track = segment.AddVideoTrack(
+                        static_cast<int>(pSrc->GetWidth()),
+                        static_cast<int>(pSrc->GetHeight()),
+                        0);
+
+        mkvmuxer::VideoTrack* const pDst =
+            static_cast<mkvmuxer::VideoTrack*>(
+                segment.GetTrackByNumber(video_track));
+
+        if ((pDst == 0) || !CopyTrackHeader(pSrc, pDst))
+        {
+            wcout << L"Unable to create video track in output file." << endl;
+            return 1;
+        }
+
+        const double rate = pSrc->GetFrameRate();
+
+        if (rate > 0)
+            pDst->set_frame_rate(rate);
+
+        segment.CuesTrack(video_track);
+    }
+
+    mkvmuxer::uint64 audio_track = 0;
+
+    if (m_pAudio)
+    {
+        const mkvparser::AudioTrack* const pSrc =
+            static_cast<const mkvparser::AudioTrack*>(m_pAudio->GetTrack());
+
+        audio_track = segment.AddAudioTrack(
+                        static_cast<int>(pSrc->GetSamplingRate()),
+                        static_cast<int>(pSrc->GetChannels()),
+                        0);
+
+        mkvmuxer::AudioTrack* const pDst =
+            static_cast<mkvmuxer::AudioTrack*>(
+                segment.GetTrackByNumber(audio_track));
+
+        if ((pDst == 0) || !CopyTrackHeader(pSrc, pDst))
+        {
+            wcout << L"Unable to create audio track in output file." << endl;
+            return 1;
+        }
+
+        const long long depth = pSrc->GetBitDepth();
+
+        if (depth > 0)
+            pDst->set_bit_depth(depth);
+    }
+
+    //Interleave the two streams in time order, as the muxer would have.
+
+    chunks_t::size_type idx = 0;
+    const mkvparser::BlockEntry* pVideo = NextVideo(idx, 0);
+    const mkvparser::BlockEntry* pAudio = m_pAudio ? m_pAudio->GetFirst() : 0;
+
+    long video_frames = 0;
+    long audio_frames = 0;
+
+    while ((pVideo != 0) || (pAudio != 0))
+    {
+        const __int64 video_ns =
+            pVideo ? (m_chunks[idx].start_ns + GetTime(pVideo)) : _I64_MAX;
+
+        if ((pAudio != 0) && (GetTime(pAudio) < video_ns))
+        {
+            const int status = WriteBlock(
+                                segment,
+                                m_pAudio,
+                                pAudio,
+                                audio_track,
+                                GetTime(pAudio));
+
+            if (status)
+                return status;
+
+            ++audio_frames;
+            pAudio = m_pAudio->GetNext(pAudio);
+        }
+        else
+        {
+            const int status = WriteBlock(
+                                segment,
+                                m_chunks[idx].pFile,
+                                pVideo,
+                                video_track,
+                                video_ns);
+
+            if (status)
+                return status;
+
+            ++video_frames;
+            pVideo = NextVideo(idx, pVideo);
+        }
+    }
+
+    if (!segment.Finalize())
+    {
+        wcout << L"Unable to finalize output file." << endl;
+        return 1;
+    }
+
+    if (verbose)
+    {
+        wcout << L"Stitched " << m_chunks.size() << L" chunk(s): "
+              << video_frames << L" video frame(s), "
+              << audio_frames << L" audio frame(s)."
+              << endl;
+    }
+
+    return 0;
+}
+
+
+int ChunkStitcher::Stitch(const wchar_t* filename, bool verbose)
+{
+    assert(filename);
+
+    int status = Open();
+
+    if (status)
+    {
+        Close();
+        return status;
+    }
+
+    FILE* f;
+
+    if ((_wfopen_s(&f, filename, L"wb") != 0) || (f == 0))
+    {
+        wcout << L"Unable to create output file \"" << filename << L"\"."
+              << endl;
+
+        Close();
+        return 1;
+    }
+
+    status = Write(f, verbose);
+
+    fclose(f);
+    Close();
+
+    if (status)
+        DeleteFile(filename);
+
+    return status;
+}
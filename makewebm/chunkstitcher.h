@@ -0,0 +1,91 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mkvparser
+{
+    class BlockEntry;
+}
+
+namespace mkvmuxer
+{
+    class Segment;
+}
+
+//Joins the WebM files produced by the chunk encoders into a single WebM
+//file.  The frames are copied as is (nothing is re-encoded); the output
+//gets a single set of clusters, with cues for the video keyframes and a
+//duration that spans all of the chunks.
+//
+//Each video chunk holds the encoding of one time range of the input, with
+//timestamps relative to the frame that the chunk encoder's demuxer started
+//from (see WebmUtil::ChunkPlanner), and must begin with a keyframe.  The
+//ranges are allowed to overlap: a chunk's frames are used only up to the
+//first frame of the chunk that follows it.  The audio (if any) was encoded
+//in a single piece, and so is copied unchanged.
+
+class ChunkStitcher
+{
+    ChunkStitcher(const ChunkStitcher&);
+    ChunkStitcher& operator=(const ChunkStitcher&);
+
+public:
+
+    ChunkStitcher();
+    ~ChunkStitcher();
+
+    //Chunks must be added in presentation order.  The start is the time,
+    //in the input, of the frame that the chunk's timestamps are relative
+    //to; not the time that the chunk encoder was asked to start from.
+    void AddVideo(const wchar_t* filename, __int64 start_ns);
+    void SetAudio(const wchar_t* filename);
+
+    //Returns 0 on success; errors are reported on the console.
+    int Stitch(const wchar_t* filename, bool verbose);
+
+private:
+
+    class File;
+
+    struct Chunk
+    {
+        std::wstring filename;
+        __int64 start_ns;
+        File* pFile;
+        __int64 first_ns;  //time of first frame, in output time
+        __int64 stop_ns;   //first frame of next chunk, in output time
+    };
+
+    typedef std::vector<Chunk> chunks_t;
+    chunks_t m_chunks;
+
+    std::wstring m_audio_filename;
+    File* m_pAudio;
+
+    std::vector<unsigned char> m_buf;
+
+    void Close();
+    int Open();
+    int Write(FILE*, bool);
+
+    const mkvparser::BlockEntry* NextVideo(
+        chunks_t::size_type&,
+        const mkvparser::BlockEntry*) const;
+
+    int WriteBlock(
+        mkvmuxer::Segment&,
+        File*,
+        const mkvparser::BlockEntry*,
+        unsigned long long track,
+        __int64 time_ns);
+
+};
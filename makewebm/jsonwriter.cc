@@ -0,0 +1,94 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <windows.h>
+#include "jsonwriter.h"
+#include <cassert>
+#include <cstdio>
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+using std::string;
+using std::wstring;
+using std::ostringstream;
+
+namespace JsonWriter
+{
+
+static string ToUTF8(const wstring& str)
+{
+    if (str.empty())
+        return string();
+
+    const int n = WideCharToMultiByte(
+                    CP_UTF8,
+                    0,
+                    str.data(),
+                    static_cast<int>(str.length()),
+                    0,
+                    0,
+                    0,
+                    0);
+
+    if (n <= 0)
+        return string();
+
+    string result(n, '\0');
+
+    const int nn = WideCharToMultiByte(
+                    CP_UTF8,
+                    0,
+                    str.data(),
+                    static_cast<int>(str.length()),
+                    &result[0],
+                    n,
+                    0,
+                    0);
+    nn;
+    assert(nn == n);
+
+    return result;
+}
+
+
+void WriteString(ostringstream& os, const wstring& str)
+{
+    const string s = ToUTF8(str);
+
+    os << '"';
+
+    for (string::size_type i = 0; i < s.length(); ++i)
+    {
+        const char c = s[i];
+
+        if ((c == '"') || (c == '\\'))
+            os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buf[8];
+            sprintf_s(buf, "\\u%04x", static_cast<unsigned char>(c));
+
+            os << buf;
+        }
+        else
+            os << c;
+    }
+
+    os << '"';
+}
+
+
+void WriteNumber(ostringstream& os, double value, int precision)
+{
+    if (value < 0)
+        os << "null";
+    else
+        os << fixed << setprecision(precision) << value;
+}
+
+}  //end namespace JsonWriter
@@ -0,0 +1,25 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <sstream>
+#include <string>
+
+//Helpers for the JSON that makewebm writes (the batch report, and the
+//pipeline stats).
+
+namespace JsonWriter
+{
+
+//Writes the string quoted and escaped, in UTF-8.
+void WriteString(std::ostringstream&, const std::wstring&);
+
+//Negative values mean "unknown", and are written as null.
+void WriteNumber(std::ostringstream&, double value, int precision);
+
+}  //end namespace JsonWriter
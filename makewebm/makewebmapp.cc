@@ -7,6 +7,10 @@
 // be found in the AUTHORS file in the root of the source tree.
 
 #include "makewebmapp.h"
+#include "batchrunner.h"
+#include "chunkplanner.h"
+#include "chunkstitcher.h"
+#include "statssink.h"
 #include <cassert>
 #include <iostream>
 #include <iomanip>
@@ -23,6 +27,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 using std::hex;
 using std::dec;
 using std::wcout;
@@ -42,8 +47,33 @@ using GraphUtil::FindInpinAudio;
 extern HANDLE g_hQuit;
 
 
-App::App()
+App::App() : m_batch_job(false)
 {
+    m_result.media_sec = -1;
+    m_result.framerate = -1;
+}
+
+
+App::~App()
+{
+    //The temporary audio file is still open in the graph.
+
+    m_pGraph = 0;
+
+    if (!m_audio_filename.empty())
+        DeleteFile(m_audio_filename.c_str());
+}
+
+
+void App::SetBatchJob()
+{
+    m_batch_job = true;
+}
+
+
+const App::Result& App::GetResult() const
+{
+    return m_result;
 }
 
 
@@ -54,6 +84,44 @@ int App::operator()(int argc, wchar_t* argv[])
     if (status)
         return status;
 
+    if (const wchar_t* const batch = m_cmdline.GetBatchFile())
+    {
+        if (m_batch_job)
+        {
+            wcout << "A batch job cannot itself run a batch." << endl;
+            return 1;
+        }
+
+        BatchRunner runner;
+
+        return runner(
+                batch,
+                m_cmdline.GetBatchJobs(),
+                m_cmdline.GetBatchReport());
+    }
+
+    m_result.output = CmdLine::GetPath(m_cmdline.GetOutputFileName());
+
+    const int stats_ms = m_cmdline.GetPipelineStats();
+    const wchar_t* const stats_json = m_cmdline.GetPipelineStatsJson();
+
+    if ((stats_ms >= 0) || stats_json)
+    {
+        //A batch job only writes the file, since its console output
+        //would be interleaved with that of the other jobs.
+
+        const bool bConsole = (stats_ms >= 0) &&
+                              !m_batch_job &&
+                              !m_cmdline.ScriptMode();
+
+        const int interval_ms = (stats_ms >= 0) ? stats_ms : 1000;
+
+        status = m_monitor.Open(interval_ms, bConsole, stats_json);
+
+        if (status)
+            return status;
+    }
+
     const bool bVerbose = m_cmdline.GetVerbose();
 
     assert(!bool(m_pGraph));
@@ -301,8 +369,14 @@ int App::operator()(int argc, wchar_t* argv[])
     assert(bool(mon));
 #endif
 
+    if (m_cmdline.GetChunks() > 1)
+        return EncodeChunks(pDemuxOutpinVideo, pDemuxOutpinAudio);
+
     const bool bNoVideo = m_cmdline.GetNoVideo();
+    const bool bNoAudio = m_cmdline.GetNoAudio();
     const bool bTwoPass = (m_cmdline.GetTwoPass() >= 1);
+    const bool bRange = ((m_cmdline.GetStartTime() >= 0) ||
+                         (m_cmdline.GetStopTime() >= 0));
 
     if (bTwoPass && !bNoVideo)
     {
@@ -315,29 +389,53 @@ int App::operator()(int argc, wchar_t* argv[])
         if (status)
             return status;
 
+        if (bool(pDemuxOutpinAudio) && !bNoAudio)
+        {
+            status = CreateFirstPassAudio(pDemuxOutpinAudio);
+
+            if (status)
+                return status;
+        }
+
+        const bool bAudio = !m_audio_filename.empty();
+
         const GraphUtil::IMediaSeekingPtr pSeek(pEncoderOutpin);
         assert(bool(pSeek));
 
+        if (bRange)
+        {
+            status = SetRange(
+                        pDemuxOutpinVideo,
+                        bAudio ? pDemuxOutpinAudio : 0);
+
+            if (status)
+                return status;
+        }
+
         status = RunGraph(pSeek);
 
         if (status)
             return status;
 
-        IBaseFilterPtr pWriter;
+        RemoveFirstPassFilters();
 
-        hr = m_pGraph->FindFilterByName(L"writer", &pWriter);
-        assert(SUCCEEDED(hr));
-        assert(bool(pWriter));
+        if (bAudio)
+        {
+            //The encoded audio replaces the source's audio stream (which
+            //is now unconnected, and so isn't read again).
 
-        hr = m_pGraph->RemoveFilter(pWriter);
-        assert(SUCCEEDED(hr));
+            pDemuxOutpinAudio = 0;
+
+            status = OpenFirstPassAudio(&pDemuxOutpinAudio);
+
+            if (status)
+                return status;
+        }
     }
 
     {
         IBaseFilterPtr pMux;
 
-        const bool bNoAudio = m_cmdline.GetNoAudio();
-
         status = CreateMuxerGraph(
                     bTwoPass,
                     bNoVideo ? 0 : pDemuxOutpinVideo,
@@ -355,16 +453,45 @@ int App::operator()(int argc, wchar_t* argv[])
         const GraphUtil::IMediaSeekingPtr pSeek(pMux);
         assert(bool(pSeek));
 
-        LONGLONG curr = 0;
-        LONGLONG stop = 0;
+        if (bool(pDemuxOutpinVideo) && !bNoVideo)
+        {
+            AM_MEDIA_TYPE mt;
 
-        hr = pSeek->SetPositions(
-                &curr,
-                AM_SEEKING_AbsolutePositioning,
-                &stop,
-                AM_SEEKING_NoPositioning);
+            hr = pDemuxOutpinVideo->ConnectionMediaType(&mt);
 
-        assert(SUCCEEDED(hr));
+            if (SUCCEEDED(hr))
+            {
+                m_result.framerate = GetFramerate(mt);
+                MediaTypeUtil::Destroy(mt);
+            }
+        }
+
+        if (bRange)
+        {
+            //Audio encoded by the first pass already covers just the range.
+
+            const bool bSeekAudio = !bNoAudio && m_audio_filename.empty();
+
+            status = SetRange(
+                        bNoVideo ? 0 : pDemuxOutpinVideo,
+                        bSeekAudio ? pDemuxOutpinAudio : 0);
+
+            if (status)
+                return status;
+        }
+        else
+        {
+            LONGLONG curr = 0;
+            LONGLONG stop = 0;
+
+            hr = pSeek->SetPositions(
+                    &curr,
+                    AM_SEEKING_AbsolutePositioning,
+                    &stop,
+                    AM_SEEKING_NoPositioning);
+
+            assert(SUCCEEDED(hr));
+        }
 
         //TODO:
         //DWORD dw;
@@ -556,28 +683,11 @@ int App::CreateMuxerGraph(
                     return 1;
                 }
 
-                const wchar_t* const stats_filename =
-                    m_stats_filename.c_str();
-
-                hr = m_stats_file.Open(stats_filename);
-
-                if (FAILED(hr))
-                {
-                    wcout << "Unable to open stats file.\n"
-                          << hrtext(hr)
-                          << L" (0x" << hex << hr << dec << L")"
-                          << endl;
-
-                    return 1;
-                }
-
-                const BYTE* buf;
-                LONGLONG len;
+                //The encoder doesn't copy the stats, so they must stay
+                //put until the last pass is done.
 
-                hr = m_stats_file.GetView(buf, len);
-                assert(SUCCEEDED(hr));
-                assert(buf);
-                assert(len >= 0);
+                const BYTE* const buf = m_stats.empty() ? 0 : &m_stats[0];
+                const LONGLONG len = static_cast<LONGLONG>(m_stats.size());
 
                 hr = pVP8->SetTwoPassStatsBuf(buf, len);
                 assert(SUCCEEDED(hr));
@@ -888,13 +998,148 @@ int App::CreateFirstPassGraph(
     if (FAILED(hr))
         return 1;
 
+    IBaseFilterPtr pSink;
+
+    hr = StatsSink::CreateInstance(m_stats, &pSink);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to create stats sink filter instance.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    assert(bool(pSink));
+
+    hr = m_pGraph->AddFilter(pSink, L"stats");
+    assert(SUCCEEDED(hr));
+
+    m_first_pass_filters.push_back(pSink);
+
+    IPin*& pEncoderOutpin = *ppEncoderOutpin;
+
+    hr = pCompressor->FindPin(L"output", &pEncoderOutpin);
+    assert(SUCCEEDED(hr));
+    assert(pEncoderOutpin);
+
+    const GraphUtil::IPinPtr pSinkInpin = GraphUtil::FindInpin(pSink);
+    assert(bool(pSinkInpin));
+
+    hr = m_pGraph->ConnectDirect(pEncoderOutpin, pSinkInpin, 0);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to connect VPX encoder outpin to stats sink inpin"
+              << " (for two-pass stats).\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    return 0;  //success
+}
+
+
+int App::CreateFirstPassAudio(IPin* pDemuxOutpinAudio)
+{
+    assert(bool(m_pGraph));
+    assert(pDemuxOutpinAudio);
+    assert(m_audio_filename.empty());
+
+    //Ogg-to-WebM (and any other stream the muxer accepts directly) has
+    //nothing to decode, so there's nothing to save.
+
+    if (m_cmdline.GetOggToWebm() > 0)
+        return 0;
+
+    IBaseFilterPtr pMux;
+
+    HRESULT hr = pMux.CreateInstance(CLSID_WebmMux);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to create WebmMux filter instance"
+              << " (for first-pass audio).\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    assert(bool(pMux));
+
+    hr = m_pGraph->AddFilter(pMux, L"audiomux");
+    assert(SUCCEEDED(hr));
+
+    const IPinPtr pMuxInpinAudio(FindInpinAudio(pMux));
+    assert(bool(pMuxInpinAudio));
+
+    filters_t before;
+    GetFilters(before);
+
+    hr = m_pGraph->ConnectDirect(pDemuxOutpinAudio, pMuxInpinAudio, 0);
+
+    if (SUCCEEDED(hr))  //already Vorbis
+    {
+        hr = m_pGraph->RemoveFilter(pMux);  //disconnects it too
+        assert(SUCCEEDED(hr));
+
+        return 0;
+    }
+
+    hr = TranscodeAudio(pDemuxOutpinAudio, pMuxInpinAudio);
+
+    if (FAILED(hr))
+    {
+        //Let the last pass try (and report the failure, if need be).
+
+        hr = m_pGraph->RemoveFilter(pMux);
+        assert(SUCCEEDED(hr));
+
+        return 0;
+    }
+
+    //The transcoding filters were added to the graph by TranscodeAudio;
+    //they're removed again with the rest of the first-pass filters.
+
+    filters_t after;
+    GetFilters(after);
+
+    typedef filters_t::const_iterator iter_t;
+
+    for (iter_t i = after.begin(); i != after.end(); ++i)
+    {
+        const IBaseFilterPtr& f = *i;
+
+        if (std::find(before.begin(), before.end(), f) == before.end())
+            m_first_pass_filters.push_back(f);
+    }
+
+    m_first_pass_filters.push_back(pMux);
+
+    wstring path = CmdLine::GetPath(m_cmdline.GetOutputFileName());
+
+    const wstring::size_type pos = path.rfind(L'.');
+
+    if (pos != wstring::npos)
+        path.erase(pos);
+
+    path.append(L"-pass1-audio.webm");
+
     IBaseFilterPtr pWriter;
 
     hr = pWriter.CreateInstance(CLSID_FileWriter);
 
     if (FAILED(hr))
     {
-        wcout << "Unable to create writer filter instance.\n"
+        wcout << "Unable to create writer filter instance"
+              << " (for first-pass audio).\n"
               << hrtext(hr)
               << L" (0x" << hex << hr << dec << L")"
               << endl;
@@ -903,25 +1148,34 @@ int App::CreateFirstPassGraph(
     }
 
     assert(bool(pWriter));
-    assert(GraphUtil::InpinCount(pWriter) == 1);
 
-    m_pGraph->AddFilter(pWriter, L"writer");
+    hr = m_pGraph->AddFilter(pWriter, L"audiowriter");
     assert(SUCCEEDED(hr));
 
+    m_first_pass_filters.push_back(pWriter);
+
     const GraphUtil::IFileSinkFilterPtr pSink(pWriter);
     assert(bool(pSink));
 
-    const wchar_t* const filename = GetStatsFileName();
+    hr = pSink->SetFileName(path.c_str(), 0);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to set output filename (for first-pass audio)"
+              << " of file writer filter.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
 
-    if (filename == 0)
         return 1;
+    }
 
-    hr = pSink->SetFileName(filename, 0);
+    hr = GraphUtil::ConnectDirect(m_pGraph, pMux, pWriter, 0);
 
     if (FAILED(hr))
     {
-        wcout << "Unable to set output filename (for two-pass stats)"
-              << " of file writer filter.\n"
+        wcout << "Unable to connect muxer to writer"
+              << " (for first-pass audio).\n"
               << hrtext(hr)
               << L" (0x" << hex << hr << dec << L")"
               << endl;
@@ -929,21 +1183,35 @@ int App::CreateFirstPassGraph(
         return 1;
     }
 
-    IPin*& pEncoderOutpin = *ppEncoderOutpin;
+    m_audio_filename = path;
 
-    hr = pCompressor->FindPin(L"output", &pEncoderOutpin);
-    assert(SUCCEEDED(hr));
-    assert(pEncoderOutpin);
+    if (m_cmdline.GetVerbose())
+        wcout << L"First-pass audio: " << m_audio_filename << endl;
 
-    const GraphUtil::IPinPtr pWriterInpin = GraphUtil::FindInpin(pWriter);
-    assert(bool(pWriterInpin));
+    return 0;
+}
 
-    hr = m_pGraph->ConnectDirect(pEncoderOutpin, pWriterInpin, 0);
+
+int App::OpenFirstPassAudio(IPin** ppDemuxOutpinAudio)
+{
+    assert(bool(m_pGraph));
+    assert(!m_audio_filename.empty());
+    assert(ppDemuxOutpinAudio);
+    assert(*ppDemuxOutpinAudio == 0);
+
+    const GraphUtil::IGraphBuilderPtr pBuilder(m_pGraph);
+    assert(bool(pBuilder));
+
+    IBaseFilterPtr pReader;
+
+    HRESULT hr = pBuilder->AddSourceFilter(
+                    m_audio_filename.c_str(),
+                    L"pass1 audio source",
+                    &pReader);
 
     if (FAILED(hr))
     {
-        wcout << "Unable to connect VPX encoder outpin to file writer inpin"
-              << " (for two-pass stats).\n"
+        wcout << "Unable to add first-pass audio source filter to graph.\n"
               << hrtext(hr)
               << L" (0x" << hex << hr << dec << L")"
               << endl;
@@ -951,10 +1219,75 @@ int App::CreateFirstPassGraph(
         return 1;
     }
 
-    return 0;  //success
+    assert(bool(pReader));
+
+    const GraphUtil::IBaseFilterPtr pDemux =
+        AddDemuxFilter(pReader, L"pass1 audio demux");
+
+    if (!bool(pDemux))
+        return 1;
+
+    IPin*& pDemuxOutpinAudio = *ppDemuxOutpinAudio;
+
+    pDemuxOutpinAudio = FindOutpinAudio(pDemux).Detach();
+
+    if (pDemuxOutpinAudio == 0)
+    {
+        wcout << "First-pass audio demuxer does not expose"
+              << " audio output pin."
+              << endl;
+
+        return 1;
+    }
+
+    return 0;
 }
 
 
+void App::RemoveFirstPassFilters()
+{
+    assert(bool(m_pGraph));
+
+    while (!m_first_pass_filters.empty())
+    {
+        const IBaseFilterPtr f = m_first_pass_filters.back();
+        m_first_pass_filters.pop_back();
+
+        const HRESULT hr = m_pGraph->RemoveFilter(f);  //disconnects it too
+        hr;
+        assert(SUCCEEDED(hr));
+    }
+}
+
+
+void App::GetFilters(filters_t& filters) const
+{
+    assert(bool(m_pGraph));
+
+    filters.clear();
+
+    _COM_SMARTPTR_TYPEDEF(IEnumFilters, __uuidof(IEnumFilters));
+
+    IEnumFiltersPtr e;
+
+    HRESULT hr = m_pGraph->EnumFilters(&e);
+
+    if (FAILED(hr))
+        return;
+
+    for (;;)
+    {
+        IBaseFilterPtr f;
+
+        hr = e->Next(1, &f, 0);
+
+        if (hr != S_OK)
+            break;
+
+        filters.push_back(f);
+    }
+}
+
 int App::LoadGraph()
 {
     const wchar_t* const input_filename = m_cmdline.GetInputFileName();
@@ -1004,209 +1337,684 @@ int App::LoadGraph()
         return 1;
     }
 
-    const IPersistStreamPtr pPersistStream(m_pGraph);
-    assert(bool(pPersistStream));
+    const IPersistStreamPtr pPersistStream(m_pGraph);
+    assert(bool(pPersistStream));
+
+    hr = pPersistStream->Load(pStream);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to open load GraphEdit stream.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    return 0;  //success
+}
+
+
+int App::SaveGraph()
+{
+    const wchar_t* const f = m_cmdline.GetSaveGraphFile();
+
+    if (f == 0)
+        return 0;  //nothing to do here
+
+    IStoragePtr pStg;
+
+    HRESULT hr = StgCreateDocfile(
+                    f,
+                    STGM_CREATE | STGM_TRANSACTED |
+                      STGM_READWRITE | STGM_SHARE_EXCLUSIVE,
+                    0,
+                    &pStg);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to create GraphEdit storage file.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    IStreamPtr pStream;
+
+    hr = pStg->CreateStream(
+            L"ActiveMovieGraph",
+            STGM_WRITE | STGM_CREATE | STGM_SHARE_EXCLUSIVE,
+            0,
+            0,
+            &pStream);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to create GraphEdit storage stream.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    const IPersistStreamPtr pPersistStream(m_pGraph);
+    assert(bool(pPersistStream));
+
+    hr = pPersistStream->Save(pStream, TRUE);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to save GraphEdit storage stream.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    hr = pStg->Commit(STGC_DEFAULT);
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to commit GraphEdit storage stream.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    return 0;  //success
+}
+
+
+
+int App::RunGraph(IMediaSeeking* pSeek)
+{
+    assert(bool(m_pGraph));
+    assert(pSeek);
+
+    const GraphUtil::IMediaEventPtr pEvent(m_pGraph);
+    assert(bool(pEvent));
+
+    HANDLE h;
+
+    HRESULT hr = pEvent->GetEventHandle((OAEVENT*)&h);
+    assert(hr == S_OK);
+    assert(h);
+
+    enum { nh = 2 };
+    const HANDLE ha[nh] = { g_hQuit, h };
+
+    const GraphUtil::IMediaControlPtr pControl(m_pGraph);
+    assert(bool(pControl));
+
+    hr = pControl->Run();
+
+    if (FAILED(hr))
+    {
+        wcout << "Unable to run graph.\n"
+              << hrtext(hr)
+              << L" (0x" << hex << hr << dec << L")"
+              << endl;
+
+        return 1;
+    }
+
+    m_monitor.Start(m_pGraph);
+
+    //int n = 1;
+
+    m_progress = 0;
+
+    for (;;)
+    {
+        MSG msg;
+
+        while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+        {
+            assert(msg.message != WM_QUIT);
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+
+        const DWORD dw = MsgWaitForMultipleObjects(
+                            nh,
+                            ha,
+                            0,
+                            100,
+                            QS_ALLINPUT);
+
+        if (dw == WAIT_TIMEOUT)
+        {
+            if (!m_batch_job)
+                DisplayProgress(pSeek, false);
+
+            m_monitor.Poll();
+            continue;
+        }
+
+        assert(dw >= WAIT_OBJECT_0);
+        assert(dw <= (WAIT_OBJECT_0 + nh));
+
+        if (dw == WAIT_OBJECT_0)  //quit
+        {
+            //wcout << "CTRL+C detected" << endl;
+            break;
+        }
+
+        if (dw == (WAIT_OBJECT_0 + nh))  //window message
+            continue;
+
+        //media event
+
+        long code, param1, param2;
+
+        HRESULT hr = pEvent->GetEvent(&code, &param1, &param2, 0);
+        assert(hr == S_OK);
+
+        hr = pEvent->FreeEventParams(code, param1, param2);
+        assert(hr == S_OK);
+
+        if (code == EC_USERABORT) //window closed
+        {
+            //wcout << "EC_USERABORT" << endl;
+            break;
+        }
+
+        if (code == EC_COMPLETE)
+        {
+            //wcout << "EC_COMPLETE" << endl;
+            break;
+        }
+
+        //if (code == (EC_USER + 0x100))  //done muxing
+        //    break;
+    }
+
+    if (m_batch_job)
+    {
+        __int64 curr;
+
+        if (SUCCEEDED(pSeek->GetCurrentPosition(&curr)))
+            m_result.media_sec = double(curr) / 10000000;
+    }
+    else
+    {
+        DisplayProgress(pSeek, true);
+
+        if (!m_cmdline.ScriptMode())
+            wcout << endl;
+    }
+
+    m_monitor.Stop();
+
+    hr = pControl->Stop();
+    assert(SUCCEEDED(hr));
+
+    return 0;
+}
+
+
+int App::SetRange(IPin* pDemuxOutpinVideo, IPin* pDemuxOutpinAudio)
+{
+    //The muxer only allows itself to be seeked to the beginning, so the
+    //range is set on the demuxer.  Seeking one stream of a demuxer seeks
+    //all of them, but an audio stream from a separate file has a demuxer
+    //of its own.
+
+    IPin* pins[2];
+    int n = 0;
+
+    if (pDemuxOutpinVideo)
+        pins[n++] = pDemuxOutpinVideo;
+
+    if (pDemuxOutpinAudio &&
+        ((n == 0) || (m_cmdline.GetAudioInputFileName() != 0)))
+    {
+        pins[n++] = pDemuxOutpinAudio;
+    }
+
+    const int start_ms = m_cmdline.GetStartTime();
+    const int stop_ms = m_cmdline.GetStopTime();
+
+    for (int i = 0; i < n; ++i)
+    {
+        const GraphUtil::IMediaSeekingPtr pSeek(pins[i]);
+
+        if (!bool(pSeek))
+        {
+            wcout << "Demuxer does not support seeking,"
+                  << " so a time range cannot be encoded."
+                  << endl;
+
+            return 1;
+        }
+
+        LONGLONG curr = (start_ms > 0) ? LONGLONG(start_ms) * 10000 : 0;
+        LONGLONG stop = (stop_ms >= 0) ? LONGLONG(stop_ms) * 10000 : 0;
+
+        const HRESULT hr = pSeek->SetPositions(
+                            &curr,
+                            AM_SEEKING_AbsolutePositioning,
+                            &stop,
+                            (stop_ms >= 0) ?
+                                AM_SEEKING_AbsolutePositioning :
+                                AM_SEEKING_NoPositioning);
+
+        if (FAILED(hr))
+        {
+            wcout << "Unable to set time range on demuxer.\n"
+                  << hrtext(hr)
+                  << L" (0x" << hex << hr << dec << L")"
+                  << endl;
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+namespace
+{
+    //The chunk planner needs to know where the demuxer actually starts
+    //after a seek (for webmsplit, the keyframe at or before the seek time).
+
+    class SeekSource : public WebmUtil::ChunkPlanner::Source
+    {
+    public:
+        explicit SeekSource(IMediaSeeking* pSeek) : m_pSeek(pSeek) {}
+
+        long long Seek(long long time)
+        {
+            LONGLONG curr = time;
+
+            HRESULT hr = m_pSeek->SetPositions(
+                            &curr,
+                            AM_SEEKING_AbsolutePositioning,
+                            0,
+                            AM_SEEKING_NoPositioning);
+
+            if (SUCCEEDED(hr))
+                hr = m_pSeek->GetCurrentPosition(&curr);
+
+            return SUCCEEDED(hr) ? curr : -1;
+        }
+
+    private:
+        IMediaSeeking* const m_pSeek;
+    };
+}
+
+
+int App::EncodeChunks(IPin* pDemuxOutpinVideo, IPin* pDemuxOutpinAudio)
+{
+    if ((pDemuxOutpinVideo == 0) || m_cmdline.GetNoVideo())
+    {
+        wcout << "Chunked mode requires a video stream." << endl;
+        return 1;
+    }
+
+    LONGLONG duration;
 
-    hr = pPersistStream->Load(pStream);
+    const GraphUtil::IMediaSeekingPtr pSeek(pDemuxOutpinVideo);
 
-    if (FAILED(hr))
+    if (!bool(pSeek) ||
+        FAILED(pSeek->GetDuration(&duration)) ||
+        (duration <= 0))
     {
-        wcout << "Unable to open load GraphEdit stream.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
+        wcout << "Chunked mode requires an input whose duration is known."
               << endl;
 
         return 1;
     }
 
-    return 0;  //success
-}
+    const LONGLONG duration_ms = duration / 10000;
 
+    //Each chunk starts with a keyframe, so very short chunks would cost
+    //more in bitrate than they save in time.
 
-int App::SaveGraph()
-{
-    const wchar_t* const f = m_cmdline.GetSaveGraphFile();
+    LONGLONG count = m_cmdline.GetChunks();
 
-    if (f == 0)
-        return 0;  //nothing to do here
+    if (count > (duration_ms / kMinChunkDuration))
+        count = duration_ms / kMinChunkDuration;
 
-    IStoragePtr pStg;
+    if (count < 1)
+        count = 1;
 
-    HRESULT hr = StgCreateDocfile(
-                    f,
-                    STGM_CREATE | STGM_TRANSACTED |
-                      STGM_READWRITE | STGM_SHARE_EXCLUSIVE,
-                    0,
-                    &pStg);
+    //Each chunk starts from the frame that the demuxer starts from when
+    //it's seeked to the chunk's nominal start, and its timestamps are
+    //relative to that frame, so that's where the stitcher places it.
 
-    if (FAILED(hr))
+    typedef WebmUtil::ChunkPlanner::chunks_t plan_t;
+    plan_t plan;
+
+    SeekSource source(pSeek);
+
+    if (!WebmUtil::ChunkPlanner::Plan(
+            source,
+            duration,
+            static_cast<int>(count),
+            plan) || plan.empty())
     {
-        wcout << "Unable to create GraphEdit storage file.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
+        wcout << "Unable to find the start of each chunk in the input."
               << endl;
 
         return 1;
     }
 
-    IStreamPtr pStream;
+    const wstring input = CmdLine::GetPath(m_cmdline.GetInputFileName());
 
-    hr = pStg->CreateStream(
-            L"ActiveMovieGraph",
-            STGM_WRITE | STGM_CREATE | STGM_SHARE_EXCLUSIVE,
-            0,
-            0,
-            &pStream);
+    wstring base = CmdLine::GetPath(m_cmdline.GetOutputFileName());
 
-    if (FAILED(hr))
-    {
-        wcout << "Unable to create GraphEdit storage stream.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
-              << endl;
+    const wstring::size_type pos = base.rfind(L'.');
 
-        return 1;
-    }
+    if (pos != wstring::npos)
+        base.erase(pos);
 
-    const IPersistStreamPtr pPersistStream(m_pGraph);
-    assert(bool(pPersistStream));
+    wostringstream os;
 
-    hr = pPersistStream->Save(pStream, TRUE);
+    os << L" --input=\"" << input << L"\"" << m_cmdline.GetChunkArgs();
 
-    if (FAILED(hr))
-    {
-        wcout << "Unable to save GraphEdit storage stream.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
-              << endl;
+    const wstring common_args = os.str();
 
+    SECURITY_ATTRIBUTES sa = { sizeof sa, 0, TRUE };  //inheritable
+
+    const HANDLE hNull = CreateFile(
+                            L"NUL",
+                            GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            &sa,
+                            OPEN_EXISTING,
+                            0,
+                            0);
+
+    if (hNull == INVALID_HANDLE_VALUE)
+    {
+        wcout << "Unable to open null device for chunk encoders." << endl;
         return 1;
     }
 
-    hr = pStg->Commit(STGC_DEFAULT);
+    chunk_jobs_t jobs;
+    int status = 0;
 
-    if (FAILED(hr))
+    for (plan_t::size_type i = 0; i < plan.size(); ++i)
     {
-        wcout << "Unable to commit GraphEdit storage stream.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
-              << endl;
+        const WebmUtil::ChunkPlanner::Chunk& chunk = plan[i];
 
-        return 1;
+        ChunkJob job;
+
+        os.str(wstring());
+        os << base << L".chunk" << i << L".webm";
+
+        job.filename = os.str();
+        job.start = chunk.start;
+
+        //The start time is rounded up to the millisecond, so that the
+        //chunk encoder's seek lands on the same frame.
+
+        const LONGLONG start_ms = (chunk.start + 9999) / 10000;
+
+        os.str(wstring());
+        os << common_args
+           << L" --no-audio"
+           << L" --output=\"" << job.filename << L"\""
+           << L" --start-time=" << start_ms;
+
+        //The range of each chunk extends a little past the start of the
+        //next one.  The next chunk begins with a keyframe, and its first
+        //frame marks where the stitcher stops taking frames from this one.
+
+        if ((i + 1) < plan.size())
+        {
+            const LONGLONG stop_ms = (chunk.stop + 9999) / 10000;
+            os << L" --stop-time=" << (stop_ms + kChunkOverlap);
+        }
+
+        status = StartChunkJob(os.str(), hNull, job);
+
+        if (status)
+            break;
+
+        jobs.push_back(job);
     }
 
-    return 0;  //success
-}
+    if ((status == 0) && (pDemuxOutpinAudio != 0) && !m_cmdline.GetNoAudio())
+    {
+        ChunkJob job;
 
+        job.filename = base + L".audio.webm";
+        job.start = -1;
 
+        os.str(wstring());
+        os << common_args
+           << L" --no-video"
+           << L" --output=\"" << job.filename << L"\"";
 
-int App::RunGraph(IMediaSeeking* pSeek)
+        if (const wchar_t* f = m_cmdline.GetAudioInputFileName())
+            os << L" --audio-input=\"" << CmdLine::GetPath(f) << L"\"";
+
+        if (m_cmdline.GetRequireAudio())
+            os << L" --require-audio";
+
+        status = StartChunkJob(os.str(), hNull, job);
+
+        if (status == 0)
+            jobs.push_back(job);
+    }
+
+    CloseHandle(hNull);
+
+    if (status == 0)
+        status = WaitChunkJobs(jobs, false);
+    else
+        WaitChunkJobs(jobs, true);  //stop the jobs that were started
+
+    if (status == 0)
+        status = StitchChunks(jobs);
+
+    //The chunk files are only intermediate results.
+
+    typedef chunk_jobs_t::const_iterator iter_t;
+
+    for (iter_t i = jobs.begin(); i != jobs.end(); ++i)
+        DeleteFile(i->filename.c_str());
+
+    return status;
+}
+
+
+int App::StartChunkJob(
+    const wstring& args,
+    HANDLE hNull,
+    ChunkJob& job)
 {
-    assert(bool(m_pGraph));
-    assert(pSeek);
+    wchar_t* exe;
 
-    const GraphUtil::IMediaEventPtr pEvent(m_pGraph);
-    assert(bool(pEvent));
+    const errno_t e = _get_wpgmptr(&exe);
 
-    HANDLE h;
+    if ((e != 0) || (exe == 0))
+    {
+        wcout << "Unable to determine path of makewebm executable." << endl;
+        return 1;
+    }
 
-    HRESULT hr = pEvent->GetEventHandle((OAEVENT*)&h);
-    assert(hr == S_OK);
-    assert(h);
+    wstring cmdline = L"\"";
+    cmdline += exe;
+    cmdline += L"\"";
+    cmdline += args;
 
-    enum { nh = 2 };
-    const HANDLE ha[nh] = { g_hQuit, h };
+    if (m_cmdline.GetVerbose())
+        wcout << cmdline << endl;
 
-    const GraphUtil::IMediaControlPtr pControl(m_pGraph);
-    assert(bool(pControl));
+    //The chunk encoders share our console, so that they see CTRL+C too,
+    //but their progress output is discarded.
 
-    hr = pControl->Run();
+    STARTUPINFO si;
+    ZeroMemory(&si, sizeof si);
 
-    if (FAILED(hr))
+    si.cb = sizeof si;
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = hNull;
+    si.hStdOutput = hNull;
+    si.hStdError = hNull;
+
+    PROCESS_INFORMATION pi;
+
+    //CreateProcess requires a modifiable command line.
+    std::vector<wchar_t> buf(cmdline.begin(), cmdline.end());
+    buf.push_back(L'\0');
+
+    const BOOL b = CreateProcess(
+                    0,
+                    &buf[0],
+                    0,
+                    0,
+                    TRUE,  //inherit handles
+                    0,
+                    0,
+                    0,
+                    &si,
+                    &pi);
+
+    if (!b)
     {
-        wcout << "Unable to run graph.\n"
-              << hrtext(hr)
-              << L" (0x" << hex << hr << dec << L")"
+        const DWORD err = GetLastError();
+
+        wcout << "Unable to start chunk encoder.\n"
+              << hrtext(HRESULT_FROM_WIN32(err))
+              << L" (0x" << hex << err << dec << L")"
               << endl;
 
         return 1;
     }
 
-    //int n = 1;
+    CloseHandle(pi.hThread);
 
-    m_progress = 0;
+    job.hProcess = pi.hProcess;
+    job.done = false;
 
-    for (;;)
+    return 0;
+}
+
+
+int App::WaitChunkJobs(chunk_jobs_t& jobs, bool bAbort)
+{
+    const bool bScript = m_cmdline.ScriptMode();
+    const chunk_jobs_t::size_type total = jobs.size();
+
+    chunk_jobs_t::size_type done = 0;
+    int status = 0;
+
+    while (!bAbort && (done < total))
     {
-        MSG msg;
+        HANDLE ha[MAXIMUM_WAIT_OBJECTS];
+        chunk_jobs_t::size_type index[MAXIMUM_WAIT_OBJECTS];
+        DWORD nh = 0;
 
-        while (PeekMessage(&msg, 0, 0, 0, PM_REMOVE))
+        ha[nh++] = g_hQuit;
+
+        for (chunk_jobs_t::size_type i = 0; i < total; ++i)
         {
-            assert(msg.message != WM_QUIT);
-            TranslateMessage(&msg);
-            DispatchMessage(&msg);
-        }
+            if (jobs[i].done)
+                continue;
 
-        const DWORD dw = MsgWaitForMultipleObjects(
-                            nh,
-                            ha,
-                            0,
-                            100,
-                            QS_ALLINPUT);
+            assert(nh < MAXIMUM_WAIT_OBJECTS);
 
-        if (dw == WAIT_TIMEOUT)
-        {
-            DisplayProgress(pSeek, false);
-            continue;
+            index[nh] = i;
+            ha[nh++] = jobs[i].hProcess;
         }
 
-        assert(dw >= WAIT_OBJECT_0);
-        assert(dw <= (WAIT_OBJECT_0 + nh));
+        const DWORD dw = WaitForMultipleObjects(nh, ha, FALSE, INFINITE);
 
-        if (dw == WAIT_OBJECT_0)  //quit
+        if ((dw == WAIT_OBJECT_0) || (dw >= (WAIT_OBJECT_0 + nh)))
         {
-            //wcout << "CTRL+C detected" << endl;
+            status = 1;  //quit (or the wait failed)
             break;
         }
 
-        if (dw == (WAIT_OBJECT_0 + nh))  //window message
-            continue;
+        ChunkJob& job = jobs[index[dw - WAIT_OBJECT_0]];
 
-        //media event
+        DWORD code;
 
-        long code, param1, param2;
+        if (!GetExitCodeProcess(job.hProcess, &code))
+            code = DWORD(-1);
 
-        HRESULT hr = pEvent->GetEvent(&code, &param1, &param2, 0);
-        assert(hr == S_OK);
+        CloseHandle(job.hProcess);
 
-        hr = pEvent->FreeEventParams(code, param1, param2);
-        assert(hr == S_OK);
+        job.hProcess = 0;
+        job.done = true;
 
-        if (code == EC_USERABORT) //window closed
-        {
-            //wcout << "EC_USERABORT" << endl;
-            break;
-        }
+        ++done;
 
-        if (code == EC_COMPLETE)
+        if (code != 0)
         {
-            //wcout << "EC_COMPLETE" << endl;
+            wcout << "\nChunk encoder for \"" << job.filename
+                  << "\" failed (exit code " << code << ")."
+                  << endl;
+
+            status = 1;
             break;
         }
 
-        //if (code == (EC_USER + 0x100))  //done muxing
-        //    break;
+        if (bScript)
+            wcout << "CHUNKS=" << done << " TOTAL=" << total << endl;
+        else
+            wcout << L"\rencoders finished: " << done << L'/' << total << flush;
     }
 
-    DisplayProgress(pSeek, true);
-
-    if (!m_cmdline.ScriptMode())
+    if (!bScript && !bAbort && (status == 0))
         wcout << endl;
 
-    hr = pControl->Stop();
-    assert(SUCCEEDED(hr));
+    //If we're giving up, the jobs that are still running aren't going to
+    //produce anything that we can use.
 
-    return 0;
+    typedef chunk_jobs_t::iterator iter_t;
+
+    for (iter_t i = jobs.begin(); i != jobs.end(); ++i)
+    {
+        ChunkJob& job = *i;
+
+        if (job.done)
+            continue;
+
+        TerminateProcess(job.hProcess, 1);
+        WaitForSingleObject(job.hProcess, INFINITE);
+        CloseHandle(job.hProcess);
+
+        job.hProcess = 0;
+        job.done = true;
+    }
+
+    return status;
+}
+
+
+int App::StitchChunks(const chunk_jobs_t& jobs)
+{
+    ChunkStitcher stitcher;
+
+    typedef chunk_jobs_t::const_iterator iter_t;
+
+    for (iter_t i = jobs.begin(); i != jobs.end(); ++i)
+    {
+        const ChunkJob& job = *i;
+
+        if (job.start < 0)
+            stitcher.SetAudio(job.filename.c_str());
+        else
+            stitcher.AddVideo(job.filename.c_str(), job.start * 100);
+    }
+
+    return stitcher.Stitch(
+            m_cmdline.GetOutputFileName(),
+            m_cmdline.GetVerbose());
 }
 
 
@@ -3121,22 +3929,83 @@ HRESULT App::SetVP8Options(
         }
     }
 
-    return S_OK;
-}
+    const int tile_columns = m_cmdline.GetTileColumns();
+    const int frame_parallel = m_cmdline.GetFrameParallel();
 
+    if ((tile_columns >= 0) || (frame_parallel >= 0))
+    {
+        _COM_SMARTPTR_TYPEDEF(IVP9Encoder, __uuidof(IVP9Encoder));
 
-const wchar_t* App::GetStatsFileName()
-{
-    wstring path = CmdLine::GetPath(m_cmdline.GetOutputFileName());
+        const IVP9EncoderPtr pVP9(pVP8);
 
-    const wstring::size_type pos = path.rfind(L'.');
+        if (!bool(pVP9))
+        {
+            wcout << "Encoder filter instance does not support VP9 tiling.\n";
+            return E_NOINTERFACE;
+        }
 
-    if (pos == wstring::npos)
-        path.append(L"-VP8STATS.DAT");
-    else
-        path.replace(pos, path.length(), L"-VP8STATS.DAT");
+        if (tile_columns >= 0)
+        {
+            const HRESULT hr = pVP9->SetTileColumns(tile_columns);
+
+            if (FAILED(hr))
+            {
+                wcout << "Unable to set VP9 encoder tile columns.\n"
+                      << hrtext(hr)
+                      << L" (0x" << hex << hr << dec << L")"
+                      << endl;
+
+                return hr;
+            }
+        }
+
+        if (frame_parallel >= 0)
+        {
+            const HRESULT hr = pVP9->SetFrameParallel(frame_parallel);
 
-    m_stats_filename = path;
+            if (FAILED(hr))
+            {
+                wcout << "Unable to set VP9 encoder frame parallel mode.\n"
+                      << hrtext(hr)
+                      << L" (0x" << hex << hr << dec << L")"
+                      << endl;
+
+                return hr;
+            }
+        }
+    }
+
+    const int speed_governor = m_cmdline.GetSpeedGovernor();
+
+    if (speed_governor >= 0)
+    {
+        _COM_SMARTPTR_TYPEDEF(IVPXSpeedGovernor, __uuidof(IVPXSpeedGovernor));
+
+        const IVPXSpeedGovernorPtr pGovernor(pVP8);
+
+        if (!bool(pGovernor))
+        {
+            wcout << "Encoder filter instance does not support"
+                  << " the speed governor.\n";
 
-    return m_stats_filename.c_str();
+            return E_NOINTERFACE;
+        }
+
+        HRESULT hr = pGovernor->SetSpeedGovernorScaling(speed_governor);
+
+        if (SUCCEEDED(hr))
+            hr = pGovernor->SetSpeedGovernor(1);
+
+        if (FAILED(hr))
+        {
+            wcout << "Unable to set VP8 encoder speed governor.\n"
+                  << hrtext(hr)
+                  << L" (0x" << hex << hr << dec << L")"
+                  << endl;
+
+            return hr;
+        }
+    }
+
+    return S_OK;
 }
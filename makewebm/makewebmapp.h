@@ -12,10 +12,12 @@
 #include <uuids.h>
 #include "graphutil.h"
 #include "makewebmcmdline.h"
-#include "memfile.h"
+#include "pipelinemonitor.h"
 #include <amvideo.h>
 #include <dvdmedia.h>
 #include <list>
+#include <string>
+#include <vector>
 
 interface IVP8Encoder;
 
@@ -27,12 +29,31 @@ class App
 public:
 
     App();
+    ~App();
+
     int operator()(int, wchar_t*[]);
 
+    //A batch job runs quietly (on one of the batch threads), and records
+    //what it did.
+
+    struct Result
+    {
+        std::wstring output;
+        double media_sec;  //duration of the output (-1 if unknown)
+        double framerate;  //of the video (-1 if unknown)
+    };
+
+    void SetBatchJob();
+    const Result& GetResult() const;
+
 private:
 
+    bool m_batch_job;
+    Result m_result;
+
     CmdLine m_cmdline;
     GraphUtil::IFilterGraphPtr m_pGraph;
+    PipelineMonitor m_monitor;
 
     int LoadGraph();
     int SaveGraph();
@@ -47,7 +68,47 @@ private:
 
     int CreateFirstPassGraph(IPin* pDemuxVideo, IPin** pEncoderOutpin);
 
+    //In two-pass mode, the audio is encoded during the first pass (into a
+    //temporary file, which the last pass then muxes as is), and the stats
+    //are kept in memory, so the last pass only has to decode the video.
+
+    typedef std::vector<GraphUtil::IBaseFilterPtr> filters_t;
+
+    int CreateFirstPassAudio(IPin* pDemuxAudio);
+    int OpenFirstPassAudio(IPin** pDemuxAudio);
+    void RemoveFirstPassFilters();
+    void GetFilters(filters_t&) const;
+
+    std::vector<BYTE> m_stats;
+    std::wstring m_audio_filename;
+    filters_t m_first_pass_filters;
+
     int RunGraph(IMediaSeeking* pSeek);
+    int SetRange(IPin* pDemuxVideo, IPin* pDemuxAudio);
+
+    //Chunked mode: the video of each time range is encoded by a separate
+    //makewebm process, and the results are stitched together.
+
+    enum
+    {
+        kMinChunkDuration = 2000,  //milliseconds
+        kChunkOverlap = 500        //milliseconds
+    };
+
+    struct ChunkJob
+    {
+        HANDLE hProcess;
+        std::wstring filename;
+        LONGLONG start;  //source time of first frame, or -1 for audio
+        bool done;
+    };
+
+    typedef std::vector<ChunkJob> chunk_jobs_t;
+
+    int EncodeChunks(IPin* pDemuxVideo, IPin* pDemuxAudio);
+    int StartChunkJob(const std::wstring& args, HANDLE hNull, ChunkJob&);
+    int WaitChunkJobs(chunk_jobs_t&, bool bAbort);
+    int StitchChunks(const chunk_jobs_t&);
 
     static bool IsVPX(IPin*);
     static GUID GetSubtype(IPin*);
@@ -107,8 +168,4 @@ private:
 
     HRESULT SetVP8Options(IVP8Encoder*, const AM_MEDIA_TYPE*) const;
 
-    const wchar_t* GetStatsFileName();
-    std::wstring m_stats_filename;
-    MemFile m_stats_file;
-
 };
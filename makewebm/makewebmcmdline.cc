@@ -70,7 +70,18 @@ CmdLine::CmdLine() :
     m_arnr_strength(-1),
     m_arnr_type(-1),
     m_ogg_to_webm(-1),
-    m_cpu_used(-17)
+    m_cpu_used(-17),
+    m_tile_columns(-1),
+    m_frame_parallel(-1),
+    m_speed_governor(-1),
+    m_chunks(-1),
+    m_start_time(-1),
+    m_stop_time(-1),
+    m_batch(0),
+    m_batch_report(0),
+    m_batch_jobs(-1),
+    m_pipeline_stats(-1),
+    m_pipeline_stats_json(0)
 {
 }
 
@@ -81,7 +92,17 @@ void CmdLine::PrintUsage() const
 
     wcout << L"  -i, --input                     input filename\n"
           << L"  --audio-input                   audio input filename\n"
+          << L"  --batch                         "
+          << L"file listing jobs to run (one per line)\n"
+          << L"  --batch-jobs                    "
+          << L"number of batch jobs to run at once\n"
+          << L"  --batch-report                  "
+          << L"filename of batch report (JSON)\n"
           << L"  -o, --output                    output filename\n"
+          << L"  --pipeline-stats                "
+          << L"print filter throughput stats (every n ms)\n"
+          << L"  --pipeline-stats-json           "
+          << L"filename to write filter throughput stats to\n"
           << L"  --deadline                      "
           << L"max time for frame encode (in microseconds)\n"
           << L"  --decoder-buffer-size           "
@@ -144,6 +165,18 @@ void CmdLine::PrintUsage() const
           << L"  --arnr-type                     type of filter\n"
           << L"  --live                          live mode WebM output\n"
           << L"  --cpu-used                      encoder speed\n"
+          << L"  --tile-columns                  "
+          << L"VP9 tile columns, as log2 (default: auto)\n"
+          << L"  --frame-parallel                "
+          << L"VP9 frame parallel decoding mode\n"
+          << L"  --speed-governor                "
+          << L"keep up with live input (n: max scaling, 0-3)\n"
+          << L"  --chunks                        "
+          << L"encode video as this many chunks, in parallel\n"
+          << L"  --start-time                    "
+          << L"start of range to encode (in milliseconds)\n"
+          << L"  --stop-time                     "
+          << L"end of range to encode (in milliseconds)\n"
           << L"  -l, --list                      "
           << L"print switch values, but do not run app\n"
           << L"  -v, --verbose                   "
@@ -186,6 +219,39 @@ void CmdLine::PrintUsage() const
           << L"  1 (or \"realtime\") means real-time encoding\n"
           << L"  1000000 (or \"good\") means good quality (the default)\n";
 
+    wcout << L'\n'
+          << L"In batch mode, each line of the batch file holds the\n"
+          << L"arguments of one job, as they would appear on the command\n"
+          << L"line (lines that are empty or begin with # are ignored).\n"
+          << L"The jobs are run by a pool of threads within this process.\n"
+          << L"The wall time, speed and output bitrate of each job are\n"
+          << L"written to the batch report, which by default is named\n"
+          << L"after the batch file.\n";
+
+    wcout << L'\n'
+          << L"The chunks value specifies the number of time ranges that\n"
+          << L"the input is split into.  The video of each range is\n"
+          << L"encoded by its own makewebm process, starting with a\n"
+          << L"keyframe, and the audio is encoded by another process.\n"
+          << L"The results are then remuxed into a single WebM file.\n";
+
+    wcout << L'\n'
+          << L"The pipeline stats report the samples in and out of each\n"
+          << L"filter stream, the time spent processing them (on average,\n"
+          << L"at the 90th percentile, at most, and as a share of the wall\n"
+          << L"time), queue depths, and how often the stream was starved.\n"
+          << L"They're printed every second by default; the JSON file gets\n"
+          << L"one line per report.\n";
+
+    wcout << L'\n'
+          << L"In live mode, the speed governor makes the video encoder\n"
+          << L"faster when it falls behind the input (a higher cpu-used,\n"
+          << L"then the realtime deadline, then scaling the frames down,\n"
+          << L"if the speed-governor value allows), and slower again once\n"
+          << L"it has time to spare.  The scaling value is 0 (never, the\n"
+          << L"default), 1 (4/5), 2 (3/5) or 3 (1/2).  The changes are\n"
+          << L"printed with the pipeline stats.\n";
+
     wcout << '\n'
           << "TODO: MORE PARAMS TO BE DESCRIBED HERE\n";
 
@@ -269,6 +335,26 @@ int CmdLine::Parse(int argc, wchar_t* argv[])
         return 1;  //soft error
     }
 
+    if (m_batch)
+    {
+        if ((m_input != 0) || (m_output != 0) || (i < j))
+        {
+            wcout << L"Input and output filenames are specified"
+                  << L" by the jobs in the batch file."
+                  << endl;
+
+            return 1;
+        }
+
+        if (m_list)
+        {
+            ListArgs();
+            return 1;
+        }
+
+        return 0;
+    }
+
     if (m_input == 0)  //not specified as switch
     {
         if (i >= j)  //no args remain
@@ -325,6 +411,54 @@ int CmdLine::Parse(int argc, wchar_t* argv[])
             SynthesizeSaveGraph();
     }
 
+    if (m_chunks > 1)
+    {
+        if ((m_pipeline_stats >= 0) || m_pipeline_stats_json)
+        {
+            wcout << L"Pipeline stats are not available in chunked mode."
+                  << endl;
+
+            return 1;
+        }
+
+        if (m_save_graph_file_ptr)
+        {
+            wcout << L"Unable to save GraphEdit storage file"
+                  << L" in chunked mode."
+                  << endl;
+
+            return 1;
+        }
+
+        if (m_live)
+        {
+            wcout << L"Live mode cannot be combined with chunked mode."
+                  << endl;
+
+            return 1;
+        }
+
+        if ((m_start_time >= 0) || (m_stop_time >= 0))
+        {
+            wcout << L"A time range cannot be combined with chunked mode."
+                  << endl;
+
+            return 1;
+        }
+    }
+
+    if ((m_speed_governor >= 0) && !m_live)
+    {
+        wcout << L"The speed governor requires live mode." << endl;
+        return 1;
+    }
+
+    if ((m_stop_time >= 0) && (m_stop_time <= m_start_time))
+    {
+        wcout << L"Stop time must be greater than start time." << endl;
+        return 1;
+    }
+
     if (i < j)  //not all args consumed
     {
         if (m_list)
@@ -928,6 +1062,95 @@ int CmdLine::ParseLongPost(
         return 2;
     }
 
+    if (_wcsnicmp(arg, L"batch", len) == 0)
+    {
+        if (has_value)
+        {
+            m_batch = arg + len + 1;
+
+            if (wcslen(m_batch) == 0)
+            {
+                wcout << "Empty value specified for batch filename switch."
+                      << endl;
+
+                return -1;  //error
+            }
+
+            return 1;
+        }
+
+        m_batch = *++i;
+
+        if (m_batch == 0)
+        {
+            wcout << "No filename specified for batch switch." << endl;
+            return -1;  //error
+        }
+
+        return 2;
+    }
+
+    if (_wcsnicmp(arg, L"batch-report", len) == 0)
+    {
+        if (has_value)
+        {
+            m_batch_report = arg + len + 1;
+
+            if (wcslen(m_batch_report) == 0)
+            {
+                wcout << "Empty value specified for batch-report switch."
+                      << endl;
+
+                return -1;  //error
+            }
+
+            return 1;
+        }
+
+        m_batch_report = *++i;
+
+        if (m_batch_report == 0)
+        {
+            wcout << "No filename specified for batch-report switch."
+                  << endl;
+
+            return -1;  //error
+        }
+
+        return 2;
+    }
+
+    if (_wcsnicmp(arg, L"pipeline-stats-json", len) == 0)
+    {
+        if (has_value)
+        {
+            m_pipeline_stats_json = arg + len + 1;
+
+            if (wcslen(m_pipeline_stats_json) == 0)
+            {
+                wcout << "Empty value specified for pipeline-stats-json"
+                      << " switch."
+                      << endl;
+
+                return -1;  //error
+            }
+
+            return 1;
+        }
+
+        m_pipeline_stats_json = *++i;
+
+        if (m_pipeline_stats_json == 0)
+        {
+            wcout << "No filename specified for pipeline-stats-json switch."
+                  << endl;
+
+            return -1;  //error
+        }
+
+        return 2;
+    }
+
     if (_wcsnicmp(arg, L"output", len) == 0)
     {
         if (has_value)
@@ -1634,6 +1857,77 @@ int CmdLine::ParseLongPost(
 
     status = ParseOpt(i, arg, len, L"cpu-used", m_cpu_used, -16, 16);
 
+    if (status)
+        return status;
+
+    status = ParseOpt(i, arg, len, L"tile-columns", m_tile_columns, 0, 6);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(
+                i,
+                arg,
+                len,
+                L"frame-parallel",
+                m_frame_parallel,
+                0,
+                1,
+                1);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(
+                i,
+                arg,
+                len,
+                L"speed-governor",
+                m_speed_governor,
+                0,
+                3,
+                0);    //default is no scaling
+
+    if (status)
+        return status;
+
+    status = ParseOpt(
+                i,
+                arg,
+                len,
+                L"batch-jobs",
+                m_batch_jobs,
+                1,
+                kMaxBatchJobs);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(i, arg, len, L"chunks", m_chunks, 0, kMaxChunks);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(i, arg, len, L"start-time", m_start_time, 0, -1);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(i, arg, len, L"stop-time", m_stop_time, 0, -1);
+
+    if (status)
+        return status;
+
+    status = ParseOpt(
+                i,
+                arg,
+                len,
+                L"pipeline-stats",
+                m_pipeline_stats,
+                100,      //we poll the graph every 100 ms
+                3600000,
+                1000);    //default is once per second
+
     if (status)
         return status;
 
@@ -1901,6 +2195,61 @@ int CmdLine::GetCPUUsed() const
     return m_cpu_used;
 }
 
+int CmdLine::GetTileColumns() const
+{
+    return m_tile_columns;
+}
+
+int CmdLine::GetFrameParallel() const
+{
+    return m_frame_parallel;
+}
+
+int CmdLine::GetSpeedGovernor() const
+{
+    return m_speed_governor;
+}
+
+int CmdLine::GetChunks() const
+{
+    return m_chunks;
+}
+
+int CmdLine::GetStartTime() const
+{
+    return m_start_time;
+}
+
+int CmdLine::GetStopTime() const
+{
+    return m_stop_time;
+}
+
+const wchar_t* CmdLine::GetBatchFile() const
+{
+    return m_batch;
+}
+
+const wchar_t* CmdLine::GetBatchReport() const
+{
+    return m_batch_report;
+}
+
+int CmdLine::GetBatchJobs() const
+{
+    return m_batch_jobs;
+}
+
+int CmdLine::GetPipelineStats() const
+{
+    return m_pipeline_stats;
+}
+
+const wchar_t* CmdLine::GetPipelineStatsJson() const
+{
+    return m_pipeline_stats_json;
+}
+
 void CmdLine::PrintVersion() const
 {
     wcout << "makewebm ";
@@ -1920,6 +2269,20 @@ void CmdLine::PrintVersion() const
 
 void CmdLine::ListArgs() const
 {
+    if (m_batch)
+    {
+        wcout << L"batch       : \"" << GetPath(m_batch) << L"\"\n";
+
+        if (m_batch_report)
+            wcout << L"batch-report: \"" << m_batch_report << L"\"\n";
+
+        if (m_batch_jobs >= 0)
+            wcout << L"batch-jobs  : " << m_batch_jobs << L'\n';
+
+        wcout << endl;
+        return;
+    }
+
     wcout << L"input      : ";
 
     if (m_input == 0)
@@ -2219,6 +2582,34 @@ void CmdLine::ListArgs() const
     if (m_cpu_used >= -16)
         wcout << L"cpu-used: " << m_cpu_used << L'\n';
 
+    if (m_tile_columns >= 0)
+        wcout << L"tile-columns: " << m_tile_columns << L'\n';
+
+    if (m_frame_parallel >= 0)
+        wcout << L"frame-parallel: " << m_frame_parallel << L'\n';
+
+    if (m_speed_governor >= 0)
+        wcout << L"speed-governor: " << m_speed_governor << L'\n';
+
+    if (m_chunks >= 0)
+        wcout << L"chunks: " << m_chunks << L'\n';
+
+    if (m_start_time >= 0)
+        wcout << L"start-time: " << m_start_time << L'\n';
+
+    if (m_stop_time >= 0)
+        wcout << L"stop-time: " << m_stop_time << L'\n';
+
+    if (m_pipeline_stats >= 0)
+        wcout << L"pipeline-stats: " << m_pipeline_stats << L'\n';
+
+    if (m_pipeline_stats_json)
+    {
+        wcout << L"pipeline-stats-json: \""
+              << m_pipeline_stats_json
+              << L"\"\n";
+    }
+
     wcout << endl;
 }
 
@@ -2421,3 +2812,138 @@ int CmdLine::ParseOpt(
 
     return n;  //success
 }
+
+
+std::wstring CmdLine::GetChunkArgs() const
+{
+    //We use the numeric form of each value, and always attach the value
+    //to its switch, so that negative values aren't mistaken for switches.
+
+    std::wostringstream os;
+
+    if (m_deadline >= 0)
+        os << L" --deadline=" << m_deadline;
+
+    if (m_decoder_buffer_size >= 0)
+        os << L" --decoder-buffer-size=" << m_decoder_buffer_size;
+
+    if (m_decoder_buffer_initial_size >= 0)
+    {
+        os << L" --decoder-buffer-initial-size="
+           << m_decoder_buffer_initial_size;
+    }
+
+    if (m_decoder_buffer_optimal_size >= 0)
+    {
+        os << L" --decoder-buffer-optimal-size="
+           << m_decoder_buffer_optimal_size;
+    }
+
+    if (m_dropframe_thresh >= 0)
+        os << L" --dropframe-threshold=" << m_dropframe_thresh;
+
+    if (m_end_usage >= 0)
+        os << L" --end-usage=" << m_end_usage;
+
+    if (m_encoder_kind == kVP8Encoder)
+        os << L" --encoder=vp8";
+
+    else if (m_encoder_kind == kVP9Encoder)
+        os << L" --encoder=vp9";
+
+    if (m_error_resilient >= 0)
+        os << L" --error-resilient=" << m_error_resilient;
+
+    if (m_keyframe_frequency >= 0)
+    {
+        os << L" --keyframe-frequency="
+           << std::setprecision(17)
+           << m_keyframe_frequency;
+    }
+
+    if (m_keyframe_mode >= kKeyframeModeDefault)
+        os << L" --keyframe-mode=" << m_keyframe_mode;
+
+    if (m_keyframe_min_interval >= 0)
+        os << L" --keyframe-min-interval=" << m_keyframe_min_interval;
+
+    if (m_keyframe_max_interval >= 0)
+        os << L" --keyframe-max-interval=" << m_keyframe_max_interval;
+
+    if (m_lag_in_frames >= 0)
+        os << L" --lag-in-frames=" << m_lag_in_frames;
+
+    if (m_min_quantizer >= 0)
+        os << L" --min-quantizer=" << m_min_quantizer;
+
+    if (m_max_quantizer >= 0)
+        os << L" --max-quantizer=" << m_max_quantizer;
+
+    if (m_ogg_to_webm >= 0)
+        os << L" --ogg-to-webm=" << m_ogg_to_webm;
+
+    if (m_resize_allowed >= 0)
+        os << L" --resize-allowed=" << m_resize_allowed;
+
+    if (m_resize_up_thresh >= 0)
+        os << L" --resize-up-threshold=" << m_resize_up_thresh;
+
+    if (m_resize_down_thresh >= 0)
+        os << L" --resize-down-threshold=" << m_resize_down_thresh;
+
+    if (m_target_bitrate >= 0)
+        os << L" --target-bitrate=" << m_target_bitrate;
+
+    if (m_thread_count >= 0)
+        os << L" --thread-count=" << m_thread_count;
+
+    if (m_token_partitions >= 0)
+        os << L" --token-partitions=" << m_token_partitions;
+
+    if (m_two_pass >= 0)
+        os << L" --two-pass=" << m_two_pass;
+
+    if (m_two_pass_vbr_bias_pct >= 0)
+        os << L" --two-pass-vbr-bias-pct=" << m_two_pass_vbr_bias_pct;
+
+    if (m_two_pass_vbr_minsection_pct >= 0)
+    {
+        os << L" --two-pass-vbr-minsection-pct="
+           << m_two_pass_vbr_minsection_pct;
+    }
+
+    if (m_two_pass_vbr_maxsection_pct >= 0)
+    {
+        os << L" --two-pass-vbr-maxsection-pct="
+           << m_two_pass_vbr_maxsection_pct;
+    }
+
+    if (m_undershoot_pct >= 0)
+        os << L" --undershoot-pct=" << m_undershoot_pct;
+
+    if (m_overshoot_pct >= 0)
+        os << L" --overshoot-pct=" << m_overshoot_pct;
+
+    if (m_auto_alt_ref >= 0)
+        os << L" --auto-alt-ref=" << m_auto_alt_ref;
+
+    if (m_arnr_maxframes >= 0)
+        os << L" --arnr-maxframes=" << m_arnr_maxframes;
+
+    if (m_arnr_strength >= 0)
+        os << L" --arnr-strength=" << m_arnr_strength;
+
+    if (m_arnr_type >= 0)
+        os << L" --arnr-type=" << m_arnr_type;
+
+    if (m_cpu_used >= -16)
+        os << L" --cpu-used=" << m_cpu_used;
+
+    if (m_tile_columns >= 0)
+        os << L" --tile-columns=" << m_tile_columns;
+
+    if (m_frame_parallel >= 0)
+        os << L" --frame-parallel=" << m_frame_parallel;
+
+    return os.str();
+}
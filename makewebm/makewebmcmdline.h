@@ -20,6 +20,13 @@ public:
 
     CmdLine();
 
+    //Each chunk is encoded by a separate process, and we wait for all of
+    //them (and for the audio encoder and the quit event) at once, so this
+    //is MAXIMUM_WAIT_OBJECTS less two.
+    enum { kMaxChunks = 62 };
+
+    enum { kMaxBatchJobs = 64 };
+
     int Parse(int argc, wchar_t* argv[]);
 
     const wchar_t* GetInputFileName() const;
@@ -66,6 +73,21 @@ public:
     int GetOggToWebm() const;
     int GetCPUUsed() const;
     int GetEncoderKind() const;
+    int GetTileColumns() const;
+    int GetFrameParallel() const;
+    int GetSpeedGovernor() const;  //max scaling, or -1 if off
+    int GetChunks() const;
+    int GetStartTime() const;
+    int GetStopTime() const;
+    const wchar_t* GetBatchFile() const;
+    const wchar_t* GetBatchReport() const;
+    int GetBatchJobs() const;
+    int GetPipelineStats() const;  //interval (in milliseconds)
+    const wchar_t* GetPipelineStatsJson() const;
+
+    //Formats the encoder switches that were specified, so that they can
+    //be passed on to the makewebm instances that encode the chunks.
+    std::wstring GetChunkArgs() const;
 
     static std::wstring GetPath(const wchar_t*);
 
@@ -119,6 +141,17 @@ private:
     int m_arnr_type;
     int m_ogg_to_webm;
     int m_cpu_used;
+    int m_tile_columns;
+    int m_frame_parallel;
+    int m_speed_governor;
+    int m_chunks;
+    int m_start_time;
+    int m_stop_time;
+    const wchar_t* m_batch;
+    const wchar_t* m_batch_report;
+    int m_batch_jobs;
+    int m_pipeline_stats;
+    const wchar_t* m_pipeline_stats_json;
 
     std::wstring m_save_graph_file_str;
     const wchar_t* m_save_graph_file_ptr;
@@ -0,0 +1,421 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "pipelinemonitor.h"
+#include "jsonwriter.h"
+#include "graphutil.h"
+#include <cassert>
+#include <iostream>
+#include <iomanip>
+using std::wcout;
+using std::endl;
+using std::fixed;
+using std::setprecision;
+using std::setw;
+using std::left;
+using std::right;
+using std::string;
+using std::wstring;
+using std::ostringstream;
+using JsonWriter::WriteString;
+using JsonWriter::WriteNumber;
+
+typedef WebmUtil::PipelineStats PipelineStats;
+
+
+PipelineMonitor::PipelineMonitor() :
+    m_open(false),
+    m_interval(0),
+    m_console(false),
+    m_file(0),
+    m_run(0),
+    m_start_us(0),
+    m_last_us(0)
+{
+}
+
+
+PipelineMonitor::~PipelineMonitor()
+{
+    assert(m_stages.empty());
+
+    if (m_file)
+        fclose(m_file);
+}
+
+
+int PipelineMonitor::Open(int interval_ms, bool console, const wchar_t* json)
+{
+    assert(!m_open);
+    assert(interval_ms > 0);
+
+    if (json)
+    {
+        const errno_t e = _wfopen_s(&m_file, json, L"wb");
+
+        if (e)
+        {
+            wcout << L"Unable to create pipeline stats file \""
+                  << json
+                  << L"\"."
+                  << endl;
+
+            m_file = 0;
+            return 1;
+        }
+    }
+
+    m_open = true;
+    m_interval = interval_ms;
+    m_console = console;
+
+    return 0;
+}
+
+
+void PipelineMonitor::Start(IFilterGraph* pGraph)
+{
+    assert(pGraph);
+    assert(m_stages.empty());
+
+    if (!m_open)
+        return;
+
+    ++m_run;
+
+    _COM_SMARTPTR_TYPEDEF(IEnumFilters, __uuidof(IEnumFilters));
+
+    IEnumFiltersPtr e;
+
+    HRESULT hr = pGraph->EnumFilters(&e);
+
+    if (FAILED(hr))
+        return;
+
+    for (;;)
+    {
+        GraphUtil::IBaseFilterPtr f;
+
+        hr = e->Next(1, &f, 0);
+
+        if (hr != S_OK)
+            break;
+
+        const IPipelineStatsPtr pStats(f);
+
+        if (!bool(pStats))
+            continue;
+
+        FILTER_INFO info;
+
+        hr = f->QueryFilterInfo(&info);
+
+        if (FAILED(hr))
+            continue;
+
+        if (info.pGraph)
+            info.pGraph->Release();
+
+        hr = pStats->ResetStats();
+        assert(SUCCEEDED(hr));
+
+        Stage s;
+
+        s.name = info.achName;
+        s.pStats = pStats;
+        s.pEvents = IPipelineEventsPtr(f);
+
+        if (bool(s.pEvents))  //discard those of an earlier run
+        {
+            Event x;
+
+            while (s.pEvents->GetEvent(&x) == S_OK)
+                ;
+        }
+
+        m_stages.push_back(s);
+    }
+
+    m_start_us = PipelineStats::GetMicroseconds();
+    m_last_us = m_start_us;
+}
+
+
+void PipelineMonitor::Poll()
+{
+    if (!m_open)
+        return;
+
+    ReportEvents();
+
+    const long long t = PipelineStats::GetMicroseconds();
+
+    if ((t - m_last_us) < (static_cast<long long>(m_interval) * 1000))
+        return;
+
+    m_last_us = t;
+
+    Report(false);
+}
+
+
+void PipelineMonitor::Stop()
+{
+    if (!m_open)
+        return;
+
+    ReportEvents();
+    Report(true);
+
+    m_stages.clear();  //don't keep the filters alive
+}
+
+
+void PipelineMonitor::Report(bool final_)
+{
+    const long long t = PipelineStats::GetMicroseconds();
+
+    const long long elapsed_us = t - m_start_us;
+    const double elapsed_sec = double(elapsed_us) / 1000000;
+
+    if (m_console)
+    {
+        wcout << L"\n\npipeline stats (pass " << m_run << L", "
+              << fixed << setprecision(1) << elapsed_sec
+              << (final_ ? L" sec, final):\n" : L" sec):\n");
+
+        wcout << left
+              << setw(20) << L"filter"
+              << setw(12) << L"stream"
+              << right
+              << setw(9) << L"in"
+              << setw(9) << L"out"
+              << setw(10) << L"out KB"
+              << setw(9) << L"avg us"
+              << setw(9) << L"p90 us"
+              << setw(9) << L"max us"
+              << setw(7) << L"busy%"
+              << setw(7) << L"queue"
+              << setw(7) << L"max"
+              << setw(8) << L"starved"
+              << L'\n';
+    }
+
+    ostringstream os;
+
+    os << "{\"pass\": " << m_run << ", \"time_sec\": ";
+    WriteNumber(os, elapsed_sec, 3);
+    os << ", \"final\": " << (final_ ? "true" : "false");
+    os << ", \"streams\": [";
+
+    bool bFirst = true;
+
+    typedef stages_t::const_iterator iter_t;
+
+    iter_t i = m_stages.begin();
+    const iter_t j = m_stages.end();
+
+    while (i != j)
+    {
+        const Stage& s = *i++;
+
+        const ULONG n = s.pStats->GetStreamCount();
+
+        for (ULONG k = 0; k < n; ++k)
+        {
+            Snapshot x;
+
+            const HRESULT hr = s.pStats->GetStreamStats(k, &x);
+
+            if (hr != S_OK)  //streams can come and go
+                continue;
+
+            const double busy = (elapsed_us <= 0) ? 0 :
+                                double(x.process_us) * 100 / elapsed_us;
+
+            if (m_console)
+                Print(s.name, x, busy);
+
+            if (m_file)
+            {
+                if (!bFirst)
+                    os << ", ";
+
+                Write(os, s.name, x, busy);
+                bFirst = false;
+            }
+        }
+    }
+
+    if (m_console)
+        wcout << endl;
+
+    if (m_file)
+    {
+        os << "]}\n";
+
+        const string str = os.str();
+
+        fwrite(str.data(), 1, str.length(), m_file);
+        fflush(m_file);  //so that it can be followed while we run
+    }
+}
+
+
+void PipelineMonitor::ReportEvents()
+{
+    typedef stages_t::const_iterator iter_t;
+
+    for (iter_t i = m_stages.begin(); i != m_stages.end(); ++i)
+    {
+        const Stage& s = *i;
+
+        if (!bool(s.pEvents))
+            continue;
+
+        Event x;
+
+        while (s.pEvents->GetEvent(&x) == S_OK)
+            ReportEvent(s.name, x);
+    }
+}
+
+
+void PipelineMonitor::ReportEvent(const wstring& name, const Event& x)
+{
+    const long long elapsed_us = x.time_us - m_start_us;
+    const double elapsed_sec = double(elapsed_us) / 1000000;
+
+    if (m_console)
+    {
+        wcout << L"\nevent (pass " << m_run << L", "
+              << fixed << setprecision(1) << elapsed_sec << L" sec) ["
+              << name << L'/' << x.name << L"] "
+              << x.type << L": " << x.text
+              << endl;
+    }
+
+    if (m_file)
+    {
+        ostringstream os;
+
+        os << "{\"pass\": " << m_run << ", \"time_sec\": ";
+        WriteNumber(os, elapsed_sec, 3);
+
+        os << ", \"event\": ";
+        WriteString(os, x.type);
+
+        os << ", \"filter\": ";
+        WriteString(os, name);
+
+        os << ", \"stream\": ";
+        WriteString(os, x.name);
+
+        os << ", \"text\": ";
+        WriteString(os, x.text);
+
+        os << "}\n";
+
+        const string str = os.str();
+
+        fwrite(str.data(), 1, str.length(), m_file);
+        fflush(m_file);
+    }
+}
+
+
+void PipelineMonitor::Print(
+    const wstring& name,
+    const Snapshot& x,
+    double busy) const
+{
+    long long avg = 0;
+
+    if (x.processed > 0)
+        avg = x.process_us / x.processed;
+
+    wcout << left
+          << setw(20) << name.substr(0, 19)
+          << setw(12) << wstring(x.name).substr(0, 11)
+          << right
+          << setw(9) << x.samples_in
+          << setw(9) << x.samples_out
+          << setw(10) << (x.bytes_out / 1024)
+          << setw(9) << avg
+          << setw(9) << GetPercentile(x, 90)
+          << setw(9) << x.process_max_us
+          << setw(7) << fixed << setprecision(1) << busy
+          << setw(7) << x.queue_depth
+          << setw(7) << x.queue_max
+          << setw(8) << x.starved
+          << L'\n';
+}
+
+
+void PipelineMonitor::Write(
+    ostringstream& os,
+    const wstring& name,
+    const Snapshot& x,
+    double busy) const
+{
+    os << "{\"filter\": ";
+    WriteString(os, name);
+
+    os << ", \"stream\": ";
+    WriteString(os, x.name);
+
+    os << ", \"samples_in\": " << x.samples_in
+       << ", \"bytes_in\": " << x.bytes_in
+       << ", \"samples_out\": " << x.samples_out
+       << ", \"bytes_out\": " << x.bytes_out
+       << ", \"processed\": " << x.processed
+       << ", \"process_us\": " << x.process_us
+       << ", \"process_max_us\": " << x.process_max_us
+       << ", \"process_p90_us\": " << GetPercentile(x, 90)
+       << ", \"busy_pct\": ";
+
+    WriteNumber(os, busy, 1);
+
+    os << ", \"histogram\": [";
+
+    for (int i = 0; i < PipelineStats::kHistogramBuckets; ++i)
+    {
+        if (i > 0)
+            os << ", ";
+
+        os << x.histogram[i];
+    }
+
+    os << "], \"queue_depth\": " << x.queue_depth
+       << ", \"queue_max\": " << x.queue_max
+       << ", \"starved\": " << x.starved
+       << "}";
+}
+
+
+long long PipelineMonitor::GetPercentile(const Snapshot& x, int percent)
+{
+    //The histogram is logarithmic, so what we return is the upper bound
+    //of the bucket that the percentile falls in.
+
+    if (x.processed <= 0)
+        return 0;
+
+    const long long target = (x.processed * percent + 99) / 100;
+    long long count = 0;
+
+    for (int i = 0; i < PipelineStats::kHistogramBuckets; ++i)
+    {
+        count += x.histogram[i];
+
+        if (count >= target)
+            return 1LL << i;
+    }
+
+    return x.process_max_us;  //the counters are read one at a time
+}
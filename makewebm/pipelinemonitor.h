@@ -0,0 +1,98 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <strmif.h>
+#include <comdef.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ipipelinestats.h"
+#include "ipipelineevents.h"
+
+//Reports the throughput of each filter in the graph while it runs, so
+//that the stage that limits the speed of a transcode can be found.
+//
+//Each filter that implements IPipelineStats (the webm filters do) is
+//asked for the counters of its streams.  Once per interval the counters
+//are printed on the console as a table, and/or appended to a file as one
+//line of JSON.  The busy column is the share of the wall time that a
+//stream spent processing samples: the bottleneck is the stage that is
+//busiest, and whose upstream stages are the ones that keep starving.
+//
+//Filters that also implement IPipelineEvents (the VP8/VP9 encoder's
+//speed governor, for instance) report what they decided as it happens;
+//their events are printed, or written as JSON lines of their own, as soon
+//as they're collected.
+
+class PipelineMonitor
+{
+    PipelineMonitor(const PipelineMonitor&);
+    PipelineMonitor& operator=(const PipelineMonitor&);
+
+public:
+
+    PipelineMonitor();
+    ~PipelineMonitor();
+
+    //The filename can be NULL, for console output only.  Returns 0 on
+    //success.
+    int Open(int interval_ms, bool console, const wchar_t* json);
+
+    //Called when the graph starts running (once per pass).  The filters'
+    //counters are reset, so that they cover this run only.
+    void Start(IFilterGraph*);
+
+    //Called periodically while the graph runs.  The events are collected
+    //on every call; the stats once per interval.
+    void Poll();
+
+    //Called once the graph has finished; reports the final counts.
+    void Stop();
+
+private:
+
+    _COM_SMARTPTR_TYPEDEF(IPipelineStats, __uuidof(IPipelineStats));
+    _COM_SMARTPTR_TYPEDEF(IPipelineEvents, __uuidof(IPipelineEvents));
+
+    struct Stage
+    {
+        std::wstring name;  //of the filter
+        IPipelineStatsPtr pStats;
+        IPipelineEventsPtr pEvents;  //if the filter has any
+    };
+
+    typedef std::vector<Stage> stages_t;
+    stages_t m_stages;
+
+    typedef IPipelineStats::Snapshot Snapshot;
+    typedef IPipelineEvents::Event Event;
+
+    bool m_open;
+    int m_interval;  //milliseconds
+    bool m_console;
+    FILE* m_file;
+    int m_run;
+    long long m_start_us;
+    long long m_last_us;
+
+    void Report(bool final_);
+    void ReportEvents();
+    void ReportEvent(const std::wstring&, const Event&);
+    void Print(const std::wstring&, const Snapshot&, double) const;
+
+    void Write(
+        std::ostringstream&,
+        const std::wstring&,
+        const Snapshot&,
+        double) const;
+
+    static long long GetPercentile(const Snapshot&, int percent);
+
+};
@@ -0,0 +1,887 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <uuids.h>
+#include <evcode.h>
+#include "statssink.h"
+#include "cenumpins.h"
+#include "mediatypeutil.h"
+#include "webmtypes.h"
+#include <cassert>
+#include <new>
+
+namespace
+{
+    const wchar_t kInpinId[] = L"input";
+}
+
+
+HRESULT StatsSink::CreateInstance(buffer_t& buf, IBaseFilter** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    IBaseFilter*& p = *pp;
+
+    p = new (std::nothrow) StatsSink(buf);
+
+    return p ? S_OK : E_OUTOFMEMORY;
+}
+
+
+StatsSink::StatsSink(buffer_t& buf) :
+    m_cRef(1),
+    m_state(State_Stopped),
+    m_clock(0),
+    m_buf(buf),
+    m_inpin(this)
+{
+    InitializeCriticalSection(&m_cs);
+
+    m_info.pGraph = 0;
+    m_info.achName[0] = L'\0';
+}
+
+
+StatsSink::~StatsSink()
+{
+    if (m_clock)
+        m_clock->Release();
+
+    DeleteCriticalSection(&m_cs);
+}
+
+
+HRESULT StatsSink::QueryInterface(const IID& iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = static_cast<IBaseFilter*>(this);
+
+    else if ((iid == __uuidof(IBaseFilter)) ||
+             (iid == __uuidof(IMediaFilter)) ||
+             (iid == __uuidof(IPersist)))
+    {
+        pUnk = static_cast<IBaseFilter*>(this);
+    }
+
+    else if (iid == __uuidof(IMediaSeeking))
+        pUnk = static_cast<IMediaSeeking*>(this);
+
+    else if (iid == __uuidof(IAMFilterMiscFlags))
+        pUnk = static_cast<IAMFilterMiscFlags*>(this);
+
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG StatsSink::AddRef()
+{
+    return InterlockedIncrement(&m_cRef);
+}
+
+
+ULONG StatsSink::Release()
+{
+    const LONG n = InterlockedDecrement(&m_cRef);
+
+    if (n > 0)
+        return n;
+
+    delete this;
+    return 0;
+}
+
+
+HRESULT StatsSink::GetClassID(CLSID* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    *p = GUID_NULL;  //not a registered filter
+    return E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::Stop()
+{
+    Lock lock(this);
+
+    m_state = State_Stopped;
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Pause()
+{
+    Lock lock(this);
+
+    if (m_state == State_Stopped)  //start of a new run
+    {
+        m_buf.clear();
+        m_inpin.m_pos = 0;
+    }
+
+    m_state = State_Paused;
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Run(REFERENCE_TIME)
+{
+    Lock lock(this);
+
+    if (m_state == State_Stopped)
+    {
+        m_buf.clear();
+        m_inpin.m_pos = 0;
+    }
+
+    m_state = State_Running;
+    return S_OK;
+}
+
+
+HRESULT StatsSink::GetState(DWORD, FILTER_STATE* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock(this);
+
+    *p = m_state;
+    return S_OK;
+}
+
+
+HRESULT StatsSink::SetSyncSource(IReferenceClock* clock)
+{
+    Lock lock(this);
+
+    if (m_clock)
+        m_clock->Release();
+
+    m_clock = clock;
+
+    if (m_clock)
+        m_clock->AddRef();
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::GetSyncSource(IReferenceClock** pclock)
+{
+    if (pclock == 0)
+        return E_POINTER;
+
+    Lock lock(this);
+
+    IReferenceClock*& clock = *pclock;
+
+    clock = m_clock;
+
+    if (clock)
+        clock->AddRef();
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::EnumPins(IEnumPins** pp)
+{
+    IPin* const pa[1] = { &m_inpin };
+
+    return CEnumPins::CreateInstance(pa, 1, pp);
+}
+
+
+HRESULT StatsSink::FindPin(LPCWSTR id, IPin** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    IPin*& p = *pp;
+    p = 0;
+
+    if (id == 0)
+        return E_INVALIDARG;
+
+    if (wcscmp(id, kInpinId) != 0)
+        return VFW_E_NOT_FOUND;
+
+    p = &m_inpin;
+    p->AddRef();
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::QueryFilterInfo(FILTER_INFO* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock(this);
+
+    enum { size = sizeof(p->achName)/sizeof(WCHAR) };
+    const errno_t e = wcscpy_s(p->achName, size, m_info.achName);
+    e;
+    assert(e == 0);
+
+    p->pGraph = m_info.pGraph;
+
+    if (p->pGraph)
+        p->pGraph->AddRef();
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::JoinFilterGraph(IFilterGraph* pGraph, LPCWSTR name)
+{
+    Lock lock(this);
+
+    //The graph holds a reference to us, so we don't hold one to it.
+
+    m_info.pGraph = pGraph;
+
+    if (name == 0)
+        m_info.achName[0] = L'\0';
+    else
+    {
+        enum { size = sizeof(m_info.achName)/sizeof(WCHAR) };
+        const errno_t e = wcsncpy_s(m_info.achName, size, name, _TRUNCATE);
+        e;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::QueryVendorInfo(LPWSTR* pstr)
+{
+    if (pstr == 0)
+        return E_POINTER;
+
+    *pstr = 0;
+    return E_NOTIMPL;
+}
+
+
+GraphUtil::IMediaSeekingPtr StatsSink::GetUpstreamSeeking() const
+{
+    //The connection only changes while the graph is stopped, and seeking
+    //requests come from the graph (not the streaming thread).
+
+    const GraphUtil::IPinPtr& pPin = m_inpin.m_pPinConnection;
+
+    if (!bool(pPin))
+        return 0;
+
+    return GraphUtil::IMediaSeekingPtr(pPin);
+}
+
+
+HRESULT StatsSink::GetCapabilities(DWORD* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetCapabilities(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::CheckCapabilities(DWORD* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->CheckCapabilities(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::IsFormatSupported(const GUID* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->IsFormatSupported(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::QueryPreferredFormat(GUID* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->QueryPreferredFormat(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetTimeFormat(GUID* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetTimeFormat(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::IsUsingTimeFormat(const GUID* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->IsUsingTimeFormat(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::SetTimeFormat(const GUID* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->SetTimeFormat(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetDuration(LONGLONG* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetDuration(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetStopPosition(LONGLONG* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetStopPosition(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetCurrentPosition(LONGLONG* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetCurrentPosition(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::ConvertTimeFormat(
+    LONGLONG* ptgt,
+    const GUID* ptgtfmt,
+    LONGLONG src,
+    const GUID* psrcfmt)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+
+    if (!bool(pSeek))
+        return E_NOTIMPL;
+
+    return pSeek->ConvertTimeFormat(ptgt, ptgtfmt, src, psrcfmt);
+}
+
+
+HRESULT StatsSink::SetPositions(
+    LONGLONG* pCurr,
+    DWORD dwCurr,
+    LONGLONG* pStop,
+    DWORD dwStop)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+
+    if (!bool(pSeek))
+        return E_NOTIMPL;
+
+    return pSeek->SetPositions(pCurr, dwCurr, pStop, dwStop);
+}
+
+
+HRESULT StatsSink::GetPositions(LONGLONG* pCurr, LONGLONG* pStop)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetPositions(pCurr, pStop) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetAvailable(LONGLONG* pEarliest, LONGLONG* pLatest)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+
+    if (!bool(pSeek))
+        return E_NOTIMPL;
+
+    return pSeek->GetAvailable(pEarliest, pLatest);
+}
+
+
+HRESULT StatsSink::SetRate(double r)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->SetRate(r) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetRate(double* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetRate(p) : E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::GetPreroll(LONGLONG* p)
+{
+    const GraphUtil::IMediaSeekingPtr pSeek(GetUpstreamSeeking());
+    return bool(pSeek) ? pSeek->GetPreroll(p) : E_NOTIMPL;
+}
+
+
+ULONG StatsSink::GetMiscFlags()
+{
+    return AM_FILTER_MISC_FLAGS_IS_RENDERER;
+}
+
+
+StatsSink::Inpin::Inpin(StatsSink* pFilter) :
+    m_pFilter(pFilter),
+    m_pos(0)
+{
+    AM_MEDIA_TYPE mt;
+
+    mt.majortype = MEDIATYPE_Stream;
+    mt.subtype = WebmTypes::MEDIASUBTYPE_VP8_STATS;
+    mt.bFixedSizeSamples = TRUE;
+    mt.bTemporalCompression = FALSE;
+    mt.lSampleSize = 0;
+    mt.formattype = GUID_NULL;
+    mt.pUnk = 0;
+    mt.cbFormat = 0;
+    mt.pbFormat = 0;
+
+    m_preferred_mtv.Add(mt);
+}
+
+
+StatsSink::Inpin::~Inpin()
+{
+}
+
+
+HRESULT StatsSink::Inpin::QueryInterface(const IID& iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = static_cast<IPin*>(this);
+
+    else if (iid == __uuidof(IPin))
+        pUnk = static_cast<IPin*>(this);
+
+    else if ((iid == __uuidof(IStream)) ||
+             (iid == __uuidof(ISequentialStream)))
+    {
+        pUnk = static_cast<IStream*>(this);
+    }
+
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG StatsSink::Inpin::AddRef()
+{
+    return m_pFilter->AddRef();
+}
+
+
+ULONG StatsSink::Inpin::Release()
+{
+    return m_pFilter->Release();
+}
+
+
+HRESULT StatsSink::Inpin::Connect(IPin*, const AM_MEDIA_TYPE*)
+{
+    return E_UNEXPECTED;  //for output pins only
+}
+
+
+HRESULT StatsSink::Inpin::ReceiveConnection(
+    IPin* pin,
+    const AM_MEDIA_TYPE* pmt)
+{
+    if ((pin == 0) || (pmt == 0))
+        return E_POINTER;
+
+    Lock lock(m_pFilter);
+
+    if (m_pFilter->m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    if (bool(m_pPinConnection))
+        return VFW_E_ALREADY_CONNECTED;
+
+    HRESULT hr = QueryAccept(pmt);
+
+    if (hr != S_OK)
+        return VFW_E_TYPE_NOT_ACCEPTED;
+
+    m_connection_mtv.Clear();
+
+    hr = m_connection_mtv.Add(*pmt);
+
+    if (FAILED(hr))
+        return hr;
+
+    m_pPinConnection = pin;
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::Disconnect()
+{
+    Lock lock(m_pFilter);
+
+    if (m_pFilter->m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    if (!bool(m_pPinConnection))
+        return S_FALSE;
+
+    m_pPinConnection = 0;
+    m_connection_mtv.Clear();
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::ConnectedTo(IPin** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    Lock lock(m_pFilter);
+
+    IPin*& p = *pp;
+
+    p = m_pPinConnection;
+
+    if (p == 0)
+        return VFW_E_NOT_CONNECTED;
+
+    p->AddRef();
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::ConnectionMediaType(AM_MEDIA_TYPE* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock(m_pFilter);
+
+    if (!bool(m_pPinConnection))
+        return VFW_E_NOT_CONNECTED;
+
+    return m_connection_mtv.Copy(0, *p);
+}
+
+
+HRESULT StatsSink::Inpin::QueryPinInfo(PIN_INFO* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    PIN_INFO& info = *p;
+
+    info.pFilter = m_pFilter;
+    info.pFilter->AddRef();
+
+    info.dir = PINDIR_INPUT;
+
+    enum { size = sizeof(info.achName)/sizeof(WCHAR) };
+    const errno_t e = wcscpy_s(info.achName, size, kInpinId);
+    e;
+    assert(e == 0);
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::QueryDirection(PIN_DIRECTION* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    *p = PINDIR_INPUT;
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::QueryId(LPWSTR* pid)
+{
+    if (pid == 0)
+        return E_POINTER;
+
+    wchar_t*& id = *pid;
+
+    const size_t len = 1 + wcslen(kInpinId);  //wchar strlen
+    const size_t size = len * sizeof(wchar_t);  //total bytes
+
+    id = (wchar_t*)CoTaskMemAlloc(size);
+
+    if (id == 0)
+        return E_OUTOFMEMORY;
+
+    const errno_t e = wcscpy_s(id, len, kInpinId);
+    e;
+    assert(e == 0);
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::QueryAccept(const AM_MEDIA_TYPE* pmt)
+{
+    if (pmt == 0)
+        return E_INVALIDARG;
+
+    const AM_MEDIA_TYPE& mt = *pmt;
+
+    if (mt.majortype != MEDIATYPE_Stream)
+        return S_FALSE;
+
+    if (mt.subtype != WebmTypes::MEDIASUBTYPE_VP8_STATS)
+        return S_FALSE;
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::EnumMediaTypes(IEnumMediaTypes** pp)
+{
+    return m_preferred_mtv.CreateEnum(this, pp);
+}
+
+
+HRESULT StatsSink::Inpin::QueryInternalConnections(IPin**, ULONG* pn)
+{
+    if (pn == 0)
+        return E_POINTER;
+
+    *pn = 0;  //we're a renderer
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::EndOfStream()
+{
+    Lock lock(m_pFilter);
+
+    if (m_pFilter->m_state == State_Stopped)
+        return S_OK;
+
+    _COM_SMARTPTR_TYPEDEF(IMediaEventSink, __uuidof(IMediaEventSink));
+
+    const IMediaEventSinkPtr pSink(m_pFilter->m_info.pGraph);
+
+    if (!bool(pSink))
+        return S_OK;
+
+    IBaseFilter* const pFilter = m_pFilter;
+
+    return pSink->Notify(EC_COMPLETE, S_OK, (LONG_PTR)pFilter);
+}
+
+
+HRESULT StatsSink::Inpin::BeginFlush()
+{
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::EndFlush()
+{
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::NewSegment(REFERENCE_TIME, REFERENCE_TIME, double)
+{
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::Read(void*, ULONG, ULONG* pcbRead)
+{
+    if (pcbRead)
+        *pcbRead = 0;
+
+    return STG_E_ACCESSDENIED;  //write-only
+}
+
+
+HRESULT StatsSink::Inpin::Write(const void* pv, ULONG cb, ULONG* pcbWritten)
+{
+    if (pcbWritten)
+        *pcbWritten = 0;
+
+    if ((pv == 0) && (cb > 0))
+        return STG_E_INVALIDPOINTER;
+
+    Lock lock(m_pFilter);
+
+    buffer_t& buf = m_pFilter->m_buf;
+
+    const ULONG end = m_pos + cb;
+
+    if (end < m_pos)  //overflow
+        return STG_E_MEDIUMFULL;
+
+    if (end > buf.size())
+        buf.resize(end);
+
+    if (cb > 0)
+        memcpy(&buf[m_pos], pv, cb);
+
+    m_pos = end;
+
+    if (pcbWritten)
+        *pcbWritten = cb;
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::Seek(
+    LARGE_INTEGER move,
+    DWORD origin,
+    ULARGE_INTEGER* pnewpos)
+{
+    Lock lock(m_pFilter);
+
+    const buffer_t& buf = m_pFilter->m_buf;
+
+    LONGLONG pos;
+
+    switch (origin)
+    {
+        case STREAM_SEEK_SET:
+            pos = move.QuadPart;
+            break;
+
+        case STREAM_SEEK_CUR:
+            pos = LONGLONG(m_pos) + move.QuadPart;
+            break;
+
+        case STREAM_SEEK_END:
+            pos = LONGLONG(buf.size()) + move.QuadPart;
+            break;
+
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+
+    if ((pos < 0) || (pos > ULONG(-1)))
+        return STG_E_INVALIDFUNCTION;
+
+    m_pos = static_cast<ULONG>(pos);
+
+    if (pnewpos)
+        pnewpos->QuadPart = m_pos;
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::SetSize(ULARGE_INTEGER size)
+{
+    if (size.QuadPart > ULONG(-1))
+        return STG_E_MEDIUMFULL;
+
+    Lock lock(m_pFilter);
+
+    m_pFilter->m_buf.resize(static_cast<size_t>(size.QuadPart));
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::CopyTo(
+    IStream*,
+    ULARGE_INTEGER,
+    ULARGE_INTEGER*,
+    ULARGE_INTEGER*)
+{
+    return E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::Inpin::Commit(DWORD)
+{
+    return S_OK;  //nothing to flush
+}
+
+
+HRESULT StatsSink::Inpin::Revert()
+{
+    return E_NOTIMPL;
+}
+
+
+HRESULT StatsSink::Inpin::LockRegion(
+    ULARGE_INTEGER,
+    ULARGE_INTEGER,
+    DWORD)
+{
+    return STG_E_INVALIDFUNCTION;
+}
+
+
+HRESULT StatsSink::Inpin::UnlockRegion(
+    ULARGE_INTEGER,
+    ULARGE_INTEGER,
+    DWORD)
+{
+    return STG_E_INVALIDFUNCTION;
+}
+
+
+HRESULT StatsSink::Inpin::Stat(STATSTG* p, DWORD)
+{
+    if (p == 0)
+        return STG_E_INVALIDPOINTER;
+
+    memset(p, 0, sizeof(STATSTG));
+
+    Lock lock(m_pFilter);
+
+    p->type = STGTY_STREAM;
+    p->cbSize.QuadPart = m_pFilter->m_buf.size();
+    p->grfMode = STGM_WRITE;
+
+    return S_OK;
+}
+
+
+HRESULT StatsSink::Inpin::Clone(IStream** pp)
+{
+    if (pp)
+        *pp = 0;
+
+    return E_NOTIMPL;
+}
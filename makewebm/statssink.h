@@ -0,0 +1,210 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <strmif.h>
+#include <vector>
+#include "cmediatypes.h"
+#include "graphutil.h"
+
+//A renderer for the stats stream of a first-pass VPx encoder, that keeps
+//the stats in memory instead of writing them to a file.
+//
+//The encoder writes each stats packet to the pin it's connected to using
+//IStream (the same as it does to the file writer), and here the packets
+//are appended to a buffer supplied by the caller.  Once the first pass
+//has run, that buffer is what gets handed to the last-pass encoder.
+//
+//The sink is a renderer as far as the graph is concerned (so the graph
+//waits for it to reach end-of-stream), and so forwards seeking to the
+//encoder upstream of it.
+
+class StatsSink : public IBaseFilter,
+                  public IMediaSeeking,
+                  public IAMFilterMiscFlags
+{
+    StatsSink(const StatsSink&);
+    StatsSink& operator=(const StatsSink&);
+
+public:
+
+    typedef std::vector<BYTE> buffer_t;
+
+    //The buffer must outlive the filter.
+    static HRESULT CreateInstance(buffer_t&, IBaseFilter**);
+
+    //IUnknown
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+    //IBaseFilter
+
+    HRESULT STDMETHODCALLTYPE GetClassID(CLSID*);
+    HRESULT STDMETHODCALLTYPE Stop();
+    HRESULT STDMETHODCALLTYPE Pause();
+    HRESULT STDMETHODCALLTYPE Run(REFERENCE_TIME);
+    HRESULT STDMETHODCALLTYPE GetState(DWORD, FILTER_STATE*);
+    HRESULT STDMETHODCALLTYPE SetSyncSource(IReferenceClock*);
+    HRESULT STDMETHODCALLTYPE GetSyncSource(IReferenceClock**);
+    HRESULT STDMETHODCALLTYPE EnumPins(IEnumPins**);
+    HRESULT STDMETHODCALLTYPE FindPin(LPCWSTR, IPin**);
+    HRESULT STDMETHODCALLTYPE QueryFilterInfo(FILTER_INFO*);
+    HRESULT STDMETHODCALLTYPE JoinFilterGraph(IFilterGraph*, LPCWSTR);
+    HRESULT STDMETHODCALLTYPE QueryVendorInfo(LPWSTR*);
+
+    //IMediaSeeking
+
+    HRESULT STDMETHODCALLTYPE GetCapabilities(DWORD*);
+    HRESULT STDMETHODCALLTYPE CheckCapabilities(DWORD*);
+    HRESULT STDMETHODCALLTYPE IsFormatSupported(const GUID*);
+    HRESULT STDMETHODCALLTYPE QueryPreferredFormat(GUID*);
+    HRESULT STDMETHODCALLTYPE GetTimeFormat(GUID*);
+    HRESULT STDMETHODCALLTYPE IsUsingTimeFormat(const GUID*);
+    HRESULT STDMETHODCALLTYPE SetTimeFormat(const GUID*);
+    HRESULT STDMETHODCALLTYPE GetDuration(LONGLONG*);
+    HRESULT STDMETHODCALLTYPE GetStopPosition(LONGLONG*);
+    HRESULT STDMETHODCALLTYPE GetCurrentPosition(LONGLONG*);
+
+    HRESULT STDMETHODCALLTYPE ConvertTimeFormat(
+        LONGLONG*,
+        const GUID*,
+        LONGLONG,
+        const GUID*);
+
+    HRESULT STDMETHODCALLTYPE SetPositions(
+        LONGLONG*,
+        DWORD,
+        LONGLONG*,
+        DWORD);
+
+    HRESULT STDMETHODCALLTYPE GetPositions(LONGLONG*, LONGLONG*);
+    HRESULT STDMETHODCALLTYPE GetAvailable(LONGLONG*, LONGLONG*);
+    HRESULT STDMETHODCALLTYPE SetRate(double);
+    HRESULT STDMETHODCALLTYPE GetRate(double*);
+    HRESULT STDMETHODCALLTYPE GetPreroll(LONGLONG*);
+
+    //IAMFilterMiscFlags
+
+    ULONG STDMETHODCALLTYPE GetMiscFlags();
+
+private:
+
+    class Inpin : public IPin, public IStream
+    {
+        Inpin(const Inpin&);
+        Inpin& operator=(const Inpin&);
+
+    public:
+
+        explicit Inpin(StatsSink*);
+        ~Inpin();
+
+        StatsSink* const m_pFilter;
+        GraphUtil::IPinPtr m_pPinConnection;
+        CMediaTypes m_preferred_mtv;
+        CMediaTypes m_connection_mtv;
+        ULONG m_pos;  //write position in the buffer
+
+        //IUnknown
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
+        ULONG STDMETHODCALLTYPE AddRef();
+        ULONG STDMETHODCALLTYPE Release();
+
+        //IPin
+
+        HRESULT STDMETHODCALLTYPE Connect(IPin*, const AM_MEDIA_TYPE*);
+        HRESULT STDMETHODCALLTYPE ReceiveConnection(
+            IPin*,
+            const AM_MEDIA_TYPE*);
+        HRESULT STDMETHODCALLTYPE Disconnect();
+        HRESULT STDMETHODCALLTYPE ConnectedTo(IPin**);
+        HRESULT STDMETHODCALLTYPE ConnectionMediaType(AM_MEDIA_TYPE*);
+        HRESULT STDMETHODCALLTYPE QueryPinInfo(PIN_INFO*);
+        HRESULT STDMETHODCALLTYPE QueryDirection(PIN_DIRECTION*);
+        HRESULT STDMETHODCALLTYPE QueryId(LPWSTR*);
+        HRESULT STDMETHODCALLTYPE QueryAccept(const AM_MEDIA_TYPE*);
+        HRESULT STDMETHODCALLTYPE EnumMediaTypes(IEnumMediaTypes**);
+        HRESULT STDMETHODCALLTYPE QueryInternalConnections(IPin**, ULONG*);
+        HRESULT STDMETHODCALLTYPE EndOfStream();
+        HRESULT STDMETHODCALLTYPE BeginFlush();
+        HRESULT STDMETHODCALLTYPE EndFlush();
+        HRESULT STDMETHODCALLTYPE NewSegment(
+            REFERENCE_TIME,
+            REFERENCE_TIME,
+            double);
+
+        //ISequentialStream
+
+        HRESULT STDMETHODCALLTYPE Read(void*, ULONG, ULONG*);
+        HRESULT STDMETHODCALLTYPE Write(const void*, ULONG, ULONG*);
+
+        //IStream
+
+        HRESULT STDMETHODCALLTYPE Seek(
+            LARGE_INTEGER,
+            DWORD,
+            ULARGE_INTEGER*);
+        HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER);
+        HRESULT STDMETHODCALLTYPE CopyTo(
+            IStream*,
+            ULARGE_INTEGER,
+            ULARGE_INTEGER*,
+            ULARGE_INTEGER*);
+        HRESULT STDMETHODCALLTYPE Commit(DWORD);
+        HRESULT STDMETHODCALLTYPE Revert();
+        HRESULT STDMETHODCALLTYPE LockRegion(
+            ULARGE_INTEGER,
+            ULARGE_INTEGER,
+            DWORD);
+        HRESULT STDMETHODCALLTYPE UnlockRegion(
+            ULARGE_INTEGER,
+            ULARGE_INTEGER,
+            DWORD);
+        HRESULT STDMETHODCALLTYPE Stat(STATSTG*, DWORD);
+        HRESULT STDMETHODCALLTYPE Clone(IStream**);
+
+    };
+
+    explicit StatsSink(buffer_t&);
+    virtual ~StatsSink();
+
+    LONG m_cRef;
+    CRITICAL_SECTION m_cs;
+    FILTER_STATE m_state;
+    FILTER_INFO m_info;
+    IReferenceClock* m_clock;
+    buffer_t& m_buf;
+    Inpin m_inpin;
+
+    class Lock
+    {
+        Lock(const Lock&);
+        Lock& operator=(const Lock&);
+
+        CRITICAL_SECTION& m_cs;
+
+    public:
+
+        explicit Lock(StatsSink* p) : m_cs(p->m_cs)
+        {
+            EnterCriticalSection(&m_cs);
+        }
+
+        ~Lock()
+        {
+            LeaveCriticalSection(&m_cs);
+        }
+
+    };
+
+    GraphUtil::IMediaSeekingPtr GetUpstreamSeeking() const;
+
+};
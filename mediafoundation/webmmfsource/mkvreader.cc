@@ -2,6 +2,7 @@
 #include <cassert>
 #include <algorithm>
 #include <comdef.h>
+#include <new>
 #ifdef _DEBUG
 #include "odbgstream.h"
 using std::endl;
@@ -11,10 +12,26 @@ using std::dec;
 #undef DEBUG_PURGE
 //#define DEBUG_PURGE
 
+namespace
+{
+
+DWORD GetSystemPageSize()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwPageSize;
+}
+
+}  //end anonymous namespace
+
+
 MkvReader::MkvReader(IMFByteStream* pStream) :
     m_pStream(pStream),
     m_async_pos(-1),  //means "no async read in progress"
-    m_async_len(-1)   //as above
+    m_async_len(-1),  //as above
+    m_async_request(0),
+    m_scheduler(GetSystemPageSize())
 {
     const ULONG n = m_pStream->AddRef();
     n;
@@ -45,6 +62,7 @@ MkvReader::MkvReader(IMFByteStream* pStream) :
     hr = m_pStream->GetLength(&length);
 
     m_length = SUCCEEDED(hr) ? length : -1;
+    m_bKnownLength = (m_length >= 0);
     //m_length = -1;  //for debugging
 
     m_avail = 0;
@@ -941,6 +959,45 @@ void MkvReader::Purge(LONGLONG pos)
 }
 
 
+void MkvReader::PurgeAfter(LONGLONG pos)
+{
+    //This is the reverse-playback analog of Purge: we release
+    //the pages at the back of the cache, that start at or
+    //beyond pos.
+
+    assert(pos >= 0);
+
+    int i = 0;
+    enum { max_count = 16 };
+
+    while (!m_cache.empty() && (i < max_count))
+    {
+        const cache_t::value_type page_iter = m_cache.back();
+
+        const Page& page = *page_iter;
+
+        if (page.cRef < 0)  //async read in progress
+            break;
+
+        if (page.cRef > 0)  //locked
+            break;
+
+        assert(page.pos >= 0);
+        assert(page.len > 0);
+
+        if (page.pos < pos)
+            break;
+
+        m_cache.pop_back();
+
+        const free_pages_t::value_type value(page.pos, page_iter);
+        m_free_pages.insert(value);
+
+        ++i;
+    }
+}
+
+
 void MkvReader::Clear()
 {
     while (!m_cache.empty())
@@ -1139,6 +1196,8 @@ HRESULT MkvReader::AsyncReadInit(
     m_async_pos = pos;
     m_async_len = len;
 
+    ++m_async_request;
+
     return AsyncReadContinue(pCB);
 
 #if 0
@@ -1253,130 +1312,83 @@ HRESULT MkvReader::AsyncReadContinue(
     IMFAsyncCallback* pCB)
 {
     assert(pCB);
-    //assert(!m_cache.empty());
 
     LONG& len = m_async_len;
     assert(len > 0);  //TODO: relax this
 
     LONGLONG& pos = m_async_pos;
-    //assert(pos > (*m_cache.front()).pos);
-    //assert((pos % m_info.dwPageSize) == 0);
-    assert((m_length < 0) || (pos < m_length));
-    assert((m_length < 0) || ((pos + len) <= m_length));
-
-    //const LONGLONG end = pos + len;
-
-    typedef cache_t::iterator iter_t;
-    iter_t next;
-
-    //QWORD curr_pos;
-    //HRESULT hr = m_pStream->GetCurrentPosition(&curr_pos);
-    //assert(SUCCEEDED(hr));  //TODO
-    //QWORD next_pos = curr_pos;
-    LONGLONG last_pos = -1;
+    assert(pos >= 0);
 
-    if (m_cache.empty() || (pos < (*m_cache.front()).pos))
-        next = m_cache.begin();
-    else
+    if (m_length >= 0)  //might have just learned the length
     {
-        const iter_t i = m_cache.begin();
-        const iter_t j = m_cache.end();
-
-        next = std::upper_bound(i, j, pos, PageLess());
-        assert(next != i);
-
-        const cache_t::value_type page_iter = *--iter_t(next);
-
-        Page& page = *page_iter;
-        assert(page.cRef >= 0);
-        assert(page.pos <= pos);
-        assert(page.len > 0);
-
-        const LONGLONG page_end = page.pos + page.len;
-
-        if (pos < page_end)  //cache hit
+        if (pos >= m_length)  //EOF
         {
-            Read(page_iter, pos, len, 0);
+            m_avail = m_length;  //kind of bogus
 
-            //if (m_avail < pos)
-            //    m_avail = pos;
+            pos = -1;
+            len = -1;
 
-            //if (next_pos < QWORD(page_end))
-            //    next_pos = page_end;
+            return S_OK;
         }
 
-        last_pos = page_end;
-
-        if (last_pos > m_avail)
-            m_avail = last_pos;
+        if ((pos + len) > m_length)
+            len = static_cast<LONG>(m_length - pos);
     }
 
-    while (len > 0)
-    {
-        if ((next == m_cache.end()) || ((*next)->pos > pos))
-        {
-            iter_t curr;
-
-            const HRESULT hr = AsyncReadPage(next, pos, pCB, curr);
-
-            if (FAILED(hr))
-                return hr;
+    //Start the reads the request still needs (and the read-ahead that
+    //follows it), as many as the scheduler allows.  A page can be
+    //satisfied from the free list without a read, in which case we
+    //schedule again, since the request might now be complete.
 
-            const cache_t::value_type page_iter = *curr;
+    bool bComplete;
+    std::vector<LONGLONG> keys;
 
-            Page& page = *page_iter;
-            assert(page.pos <= pos);
+    for (;;)
+    {
+        keys.clear();
 
-            if (hr == S_FALSE)  //async read in progress
-            {
-                assert(page.cRef < 0);
-                return S_FALSE;  //tell caller to wait for completion
-            }
+        bComplete = m_scheduler.Schedule(pos, len, m_length, *this, keys);
 
-            next = ++iter_t(curr);
-            assert((next == m_cache.end()) || ((*next)->pos > page.pos));
+        bool bReused = false;
 
-            Read(page_iter, pos, len, 0);
+        typedef std::vector<LONGLONG>::const_iterator iter_t;
 
-            //if (m_avail < pos)
-            //    m_avail = pos;
+        iter_t i = keys.begin();
+        const iter_t j = keys.end();
 
-            const LONGLONG page_end = page.pos + page.len;
+        while (i != j)
+        {
+            const HRESULT hr = AsyncReadPage(*i++, pCB);
 
-            //if (next_pos < QWORD(page_end))
-            //    next_pos = page_end;
+            if (FAILED(hr))
+                return hr;
 
-            last_pos = page_end;
+            if (hr == S_OK)
+                bReused = true;
         }
-        else
-        {
-            const cache_t::value_type page_iter = *next++;
 
-            Page& page = *page_iter;
-            assert(page.cRef >= 0);
-            assert(page.pos <= pos);
-            assert(page.len > 0);
-            assert(pos < (page.pos + page.len));
+        if (!bReused)
+            break;
+    }
 
-            Read(page_iter, pos, len, 0);
+    if (!bComplete)
+        return S_FALSE;  //tell caller to wait for completion
 
-            //if (m_avail < pos)
-            //    m_avail = pos;
+    //All of the pages of the request are in the cache.
 
-            const LONGLONG page_end = page.pos + page.len;
+    const DWORD page_size = m_info.dwPageSize;
 
-            //if (next_pos < QWORD(page_end))
-            //    next_pos = page_end;
+    const LONGLONG last_key = page_size * ((pos + len - 1) / page_size);
+    const cache_t::iterator last = Find(last_key);
+    assert(last != m_cache.end());
 
-            last_pos = page_end;
-        }
+    const Page& last_page = **last;
+    assert(last_page.len > 0);
 
-        if (last_pos > m_avail)
-            m_avail = last_pos;
-    }
+    const LONGLONG last_pos = last_page.pos + last_page.len;
 
-    assert(last_pos >= 0);
-    assert(m_avail >= last_pos);
+    if (last_pos > m_avail)
+        m_avail = last_pos;
 
     pos = -1;
     len = -1;
@@ -1397,43 +1409,126 @@ HRESULT MkvReader::AsyncReadContinue(
 
 HRESULT MkvReader::AsyncReadCancel()
 {
+    //The reads in flight are allowed to complete, into the cache.
+
     m_async_len = -1;
     m_async_pos = -1;
 
+    ++m_async_request;
+
     return S_OK;
 }
 
 
+void MkvReader::SetReadAhead(int max_reads, int prefetch_pages)
+{
+    m_scheduler.SetLimits(max_reads, prefetch_pages);
+}
+
+
+int MkvReader::GetReadCount() const
+{
+    return m_scheduler.GetReadCount();
+}
+
+
+class MkvReader::AsyncRead : public IUnknown
+{
+    AsyncRead(const AsyncRead&);
+    AsyncRead& operator=(const AsyncRead&);
+
+    ~AsyncRead()
+    {
+    }
+
+public:
+
+    AsyncRead(LONGLONG key, ULONG request) :
+        m_key(key),
+        m_request(request),
+        m_cRef(1)
+    {
+    }
+
+    const LONGLONG m_key;
+    const ULONG m_request;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(const IID& iid, void** ppv)
+    {
+        if (ppv == 0)
+            return E_POINTER;
+
+        if (iid != __uuidof(IUnknown))
+        {
+            *ppv = 0;
+            return E_NOINTERFACE;
+        }
+
+        *ppv = static_cast<IUnknown*>(this);
+        AddRef();
+
+        return S_OK;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef()
+    {
+        return InterlockedIncrement(&m_cRef);
+    }
+
+    ULONG STDMETHODCALLTYPE Release()
+    {
+        const LONG n = InterlockedDecrement(&m_cRef);
+
+        if (n == 0)
+            delete this;
+
+        return n;
+    }
+
+private:
+
+    LONG m_cRef;
+
+};
+
+
 HRESULT MkvReader::AsyncReadCompletion(IMFAsyncResult* pResult)
 {
     assert(pResult);
-    assert(m_async_pos >= 0);
-    assert((m_length < 0) || (m_async_pos < m_length));
-    assert(m_async_len > 0);
-    assert((m_length < 0) || ((m_async_pos + m_async_len) <= m_length));
-    assert(!m_cache.empty());
 
-    typedef cache_t::iterator iter_t;
+    //The state object is the AsyncRead we passed to BeginRead.
 
-    const iter_t i = m_cache.begin();
-    const iter_t j = m_cache.end();
+    IUnknownPtr pState;
 
-    const iter_t next = std::upper_bound(i, j, m_async_pos, PageLess());
-    assert(next != i);
+    HRESULT hr = pResult->GetState(&pState);
+    assert(SUCCEEDED(hr));
+    assert(bool(pState));
 
-    const iter_t curr = --iter_t(next);
-    const cache_t::value_type page_iter = *curr;
+    if (FAILED(hr) || !bool(pState))
+        return E_FAIL;
+
+    const AsyncRead& r = *static_cast<AsyncRead*>(pState.GetInterfacePtr());
+
+    const reads_t::iterator read_iter = m_reads.find(r.m_key);
+    assert(read_iter != m_reads.end());
+
+    if (read_iter == m_reads.end())  //weird
+        return E_FAIL;
+
+    const pages_vector_t::iterator page_iter = read_iter->second;
+
+    m_reads.erase(read_iter);
+    m_scheduler.OnReadEnd(r.m_key);
 
     Page& page = *page_iter;
-    assert(page.pos >= 0);
-    assert(page.pos <= m_async_pos);
+    assert(page.pos == r.m_key);
     assert(page.cRef < 0);  //async read in progress
 
     page.cRef = 0;  //unmark this page, now that I/O is complete
 
     ULONG cbRead;
 
-    HRESULT hr = m_pStream->EndRead(pResult, &cbRead);
+    hr = m_pStream->EndRead(pResult, &cbRead);
     assert(FAILED(hr) || (cbRead <= m_info.dwPageSize));
 
     if (SUCCEEDED(hr))
@@ -1447,10 +1542,11 @@ HRESULT MkvReader::AsyncReadCompletion(IMFAsyncResult* pResult)
             //such as when we read the very last page of the file.
 
             const LONGLONG length = page.pos + page.len;
-            assert((m_length < 0) || (length <= m_length));
 
-            if (m_length >= 0)  //length is defined
+            if (m_bKnownLength)
             {
+                assert(length <= m_length);
+
                 if (length < m_length)  //weird: fewer bytes than total length
                 {
                     hr = E_FAIL;        //treat this as an I/O error
@@ -1463,74 +1559,90 @@ HRESULT MkvReader::AsyncReadCompletion(IMFAsyncResult* pResult)
 #endif
                 }
             }
-            else //network source with unknown length
+            else if ((m_length < 0) || (length < m_length))
             {
-                m_length = length;
-                assert(m_async_pos <= m_length);
+                //Network source with unknown length.  Read-ahead can go
+                //past the end, and reads can complete in any order, so
+                //the length is the least of the ends that we've seen.
 
-                if ((m_async_pos + m_async_len) > m_length)
-                    m_async_len = static_cast<LONG>(m_length - m_async_pos);
+                m_length = length;  //see AsyncReadContinue
             }
         }
     }
 
     if (FAILED(hr) || (cbRead == 0))
     {
-        m_cache.erase(curr);
-
         page.pos = -1;  //means "we don't have any data on this page"
         page.len = 0;
 
         const free_pages_t::value_type value(page.pos, page_iter);
         m_free_pages.insert(value);
 
-        m_async_len = -1;
-        m_async_pos = -1;
+        //A read that failed only fails the request that started it, and
+        //only if the page is part of that request (rather than read-ahead).
+        //Otherwise the page is simply read again, if it's needed.
 
-        return hr;
+        if (FAILED(hr) &&
+            (r.m_request == m_async_request) &&
+            (m_async_len > 0) &&
+            (r.m_key < (m_async_pos + m_async_len)))
+        {
+            m_async_len = -1;
+            m_async_pos = -1;
+
+            return hr;
+        }
+
+        return S_FALSE;
     }
 
-    const LONGLONG last_pos = page.pos + page.len;
+    //Insert the page into the cache, in position order.
 
-    if (last_pos > m_avail)
-        m_avail = last_pos;
+    const cache_t::iterator next =
+        std::upper_bound(m_cache.begin(), m_cache.end(), page.pos, PageLess());
 
-    Read(page_iter, m_async_pos, m_async_len, 0);
-    assert(m_async_pos >= 0);
-    assert(m_async_len >= 0);
-    assert((m_length < 0) || (m_async_pos <= m_length));
-    assert((m_length < 0) || ((m_async_pos + m_async_len) <= m_length));
+    m_cache.insert(next, page_iter);
 
-    if (m_async_len > 0)
-        return S_FALSE;
+    return S_FALSE;  //AsyncReadContinue decides whether we're done
+}
 
-    m_async_pos = -1;
-    m_async_len = -1;
 
-    return S_OK;
+bool MkvReader::IsCached(long long key) const
+{
+    const cache_t::const_iterator i =
+        std::lower_bound(m_cache.begin(), m_cache.end(), key, PageLess());
+
+    return (i != m_cache.end()) && ((*i)->pos == key);
 }
 
 
-HRESULT MkvReader::AsyncReadPage(
-    cache_t::iterator next,
-    LONGLONG pos,
-    IMFAsyncCallback* pCB,
-    cache_t::iterator& curr)
+MkvReader::cache_t::iterator MkvReader::Find(LONGLONG key)
 {
-    assert(pos >= 0);
-    assert((m_length < 0) || (pos < m_length));
+    const cache_t::iterator i =
+        std::lower_bound(m_cache.begin(), m_cache.end(), key, PageLess());
+
+    if ((i != m_cache.end()) && ((*i)->pos == key))
+        return i;
+
+    return m_cache.end();
+}
+
+
+HRESULT MkvReader::AsyncReadPage(LONGLONG key, IMFAsyncCallback* pCB)
+{
+    assert(key >= 0);
+    assert((m_length < 0) || (key < m_length));
+    assert(!IsCached(key));
+    assert(m_reads.find(key) == m_reads.end());
 
     const DWORD page_size = m_info.dwPageSize;
+    assert((key % page_size) == 0);
 
     //TODO: purge as necessary
 
     if (m_free_pages.empty())
         CreateRegion();
 
-    const LONGLONG key = page_size * LONGLONG(pos / page_size);
-    assert((next == m_cache.end()) || ((*next)->pos > key));
-    assert((m_length < 0) || (key < m_length));
-
     free_pages_t::iterator free_page = m_free_pages.find(key);
 
     if (free_page == m_free_pages.end())  //key not found
@@ -1541,26 +1653,24 @@ HRESULT MkvReader::AsyncReadPage(
     Page& page = *page_iter;
     assert(page.cRef == 0);
 
+    const cache_t::iterator next =
+        std::upper_bound(m_cache.begin(), m_cache.end(), key, PageLess());
+
     if (page.pos == key)  //re-use the free page as is
     {
         assert(page.len > 0);
 
         m_free_pages.erase(free_page);  //page is no longer free
-        curr = m_cache.insert(next, page_iter);
+        m_cache.insert(next, page_iter);
 
         return S_OK;
     }
 
-    HRESULT hr;
-
-#ifdef _DEBUG
-    QWORD new_pos;
+    //With several reads in flight, and pages that are read again after
+    //a read fails, the keys aren't always increasing, so we position the
+    //stream for each read.
 
-    hr = m_pStream->GetCurrentPosition(&new_pos);
-    assert(FAILED(hr) || (QWORD(key) >= new_pos));
-#endif
-
-    hr = m_pStream->SetCurrentPosition(key);
+    HRESULT hr = m_pStream->SetCurrentPosition(key);
 
     if (FAILED(hr))
         return hr;
@@ -1572,27 +1682,30 @@ HRESULT MkvReader::AsyncReadPage(
     //to vary across pages.
     BYTE* const ptr = page.region->ptr + offset * size_t(page_size);
 
-    //we always request the max number of bytes for a page
-    hr = m_pStream->BeginRead(ptr, page_size, pCB, 0);
+    AsyncRead* const pState = new (std::nothrow) AsyncRead(key,
+                                                           m_async_request);
 
-    if (FAILED(hr))
-        return hr;
+    if (pState == 0)
+        return E_OUTOFMEMORY;
 
-    //os << "AsyncReadPage: just called BeginRead; cb=" << page_size
-    //   << "; currpos+cb=" << (key + page_size)
-    //   << "; GetCurrPos=";
+    //we always request the max number of bytes for a page
+    hr = m_pStream->BeginRead(ptr, page_size, pCB, pState);
 
-    //hr = m_pStream->GetCurrentPosition(&new_pos);
-    //assert(SUCCEEDED(hr));
+    pState->Release();  //BeginRead holds its own reference
 
-    //os << new_pos << endl;
+    if (FAILED(hr))
+        return hr;
 
     page.pos = key;
     page.len = 0;    //we don't know actual len until async read completes
     page.cRef = -1;  //means "async read in progress"
 
     m_free_pages.erase(free_page);  //page is no longer free
-    curr = m_cache.insert(next, page_iter);
+
+    const reads_t::value_type value(key, page_iter);
+    m_reads.insert(value);
+
+    m_scheduler.OnReadBegin(key);
 
     return S_FALSE;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "mkvparser.hpp"
+#include "readscheduler.h"
 #include <windows.h>
 #include <mfidl.h>
 #include <deque>
@@ -8,7 +9,8 @@
 //#include <functional>
 #include <map>
 
-class MkvReader : public mkvparser::IMkvReader
+class MkvReader : public mkvparser::IMkvReader,
+                  private WebmUtil::ReadScheduler::Cache
 {
     MkvReader(const MkvReader&);
     MkvReader& operator=(const MkvReader&);
@@ -42,7 +44,14 @@ public:
     HRESULT AsyncReadContinue(IMFAsyncCallback*);
     HRESULT AsyncReadCancel();
 
+    //How many page reads can be in flight at once, and how many pages
+    //past the end of a request to read ahead.  The default is one read
+    //and no read-ahead, which suits a local file.
+    void SetReadAhead(int max_reads, int prefetch_pages);
+    int GetReadCount() const;  //page reads in flight
+
     void Purge(LONGLONG);
+    void PurgeAfter(LONGLONG);
     void Clear();  //purge all
 
     DWORD GetPageSize() const;
@@ -105,6 +114,7 @@ private:
 
     SYSTEM_INFO m_info;
     LONGLONG m_length;
+    bool m_bKnownLength;  //from the stream, rather than a short read
     LONGLONG m_avail;
 
     void Read(
@@ -118,15 +128,25 @@ private:
     //    LONGLONG pos,
     //    cache_t::iterator& curr);
 
-    HRESULT AsyncReadPage(
-        cache_t::iterator next,
-        LONGLONG pos,
-        IMFAsyncCallback* pCB,
-        cache_t::iterator& curr);
+    HRESULT AsyncReadPage(LONGLONG key, IMFAsyncCallback* pCB);
+
+    bool IsCached(long long key) const;  //ReadScheduler::Cache
+    cache_t::iterator Find(LONGLONG key);
 
     //async read
-    LONGLONG m_async_pos;  //key of page supplying async buf
-    LONG m_async_len;      //what remains to be read
+    LONGLONG m_async_pos;  //the request
+    LONG m_async_len;      //as above
+    ULONG m_async_request;  //incremented for each request
+
+    //Pages being read are not in the cache until their read completes.
+    //Each read's state object identifies its page, and the request that
+    //started it.
+    class AsyncRead;
+
+    typedef std::map<LONGLONG, pages_vector_t::iterator> reads_t;
+    reads_t m_reads;
+
+    WebmUtil::ReadScheduler m_scheduler;
 
     void CreateRegion();
     void DestroyRegions();
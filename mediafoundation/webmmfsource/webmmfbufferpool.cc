@@ -0,0 +1,334 @@
+#include "webmmfbufferpool.h"
+#include <mfapi.h>
+#include <mferror.h>
+#include <comdef.h>
+#include <cassert>
+#include <new>
+#ifdef _DEBUG
+#include "odbgstream.h"
+using std::endl;
+#endif
+
+_COM_SMARTPTR_TYPEDEF(IMFSample, __uuidof(IMFSample));
+_COM_SMARTPTR_TYPEDEF(IMFTrackedSample, __uuidof(IMFTrackedSample));
+_COM_SMARTPTR_TYPEDEF(IMFMediaBuffer, __uuidof(IMFMediaBuffer));
+
+
+namespace WebmMfSourceLib
+{
+
+HRESULT WebmMfBufferPool::CreatePool(WebmMfBufferPool** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    WebmMfBufferPool*& pPool = *pp;
+
+    pPool = new (std::nothrow) WebmMfBufferPool;
+
+    if (pPool == 0)
+        return E_OUTOFMEMORY;
+
+    const HRESULT hr = pPool->CLockable::Init();
+
+    if (FAILED(hr))
+    {
+        pPool->Release();
+        pPool = 0;
+    }
+
+    return hr;
+}
+
+
+WebmMfBufferPool::WebmMfBufferPool() :
+    m_hits(0),
+    m_misses(0),
+    m_cRef(1),
+    m_bShutdown(false)
+{
+}
+
+
+WebmMfBufferPool::~WebmMfBufferPool()
+{
+#ifdef _DEBUG
+    odbgstream os;
+    os << "WebmMfBufferPool::dtor: hits=" << m_hits
+       << " misses=" << m_misses
+       << endl;
+#endif
+
+    Purge();
+}
+
+
+HRESULT WebmMfBufferPool::QueryInterface(const IID& iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+    {
+        pUnk = static_cast<IMFAsyncCallback*>(this);  //must be nondelegating
+    }
+    else if (iid == __uuidof(IMFAsyncCallback))
+    {
+        pUnk = static_cast<IMFAsyncCallback*>(this);
+    }
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG WebmMfBufferPool::AddRef()
+{
+    return InterlockedIncrement(&m_cRef);
+}
+
+
+ULONG WebmMfBufferPool::Release()
+{
+    assert(m_cRef > 0);
+    const LONG n = InterlockedDecrement(&m_cRef);
+
+    if (n == 0)
+        delete this;
+
+    return n;
+}
+
+
+HRESULT WebmMfBufferPool::GetParameters(DWORD*, DWORD*)
+{
+    return E_NOTIMPL;  //means "assume default behavior"
+}
+
+
+HRESULT WebmMfBufferPool::Invoke(IMFAsyncResult* pResult)
+{
+    if (pResult == 0)
+        return E_INVALIDARG;
+
+    //The tracked sample is the object of the result.  Its reference count
+    //has dropped to zero, so the only references to its buffers are the
+    //sample's, and ours, unless someone downstream kept a buffer after
+    //releasing the sample.
+
+    IUnknownPtr pUnk;
+
+    HRESULT hr = pResult->GetObject(&pUnk);
+
+    if (FAILED(hr))
+        return hr;
+
+    const IMFSamplePtr pSample(pUnk);
+
+    if (!bool(pSample))
+        return E_INVALIDARG;
+
+    DWORD count;
+
+    hr = pSample->GetBufferCount(&count);
+
+    if (FAILED(hr))
+        return hr;
+
+    std::vector<IMFMediaBufferPtr> buffers;
+    buffers.reserve(count);
+
+    for (DWORD i = 0; i < count; ++i)
+    {
+        IMFMediaBufferPtr pBuffer;
+
+        hr = pSample->GetBufferByIndex(i, &pBuffer);
+
+        if (SUCCEEDED(hr))
+            buffers.push_back(pBuffer);
+    }
+
+    hr = pSample->RemoveAllBuffers();
+    assert(SUCCEEDED(hr));
+
+    Lock lock;
+
+    hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    typedef std::vector<IMFMediaBufferPtr>::iterator iter_t;
+
+    iter_t i = buffers.begin();
+    const iter_t j = buffers.end();
+
+    while (i != j)
+    {
+        IMFMediaBuffer* const pBuffer = *i++;
+
+        //The reference count isn't something to rely on in general, but
+        //these are our own buffers: if ours is the only reference, then
+        //nothing else can read from the buffer after we recycle it.
+
+        const ULONG n = pBuffer->AddRef();
+        pBuffer->Release();
+
+        if (n == 2)  //our smart ptr, and the AddRef above
+            Recycle(pBuffer);
+    }
+
+    return S_OK;
+}
+
+
+HRESULT WebmMfBufferPool::CreateSample(IMFSample** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    IMFSample*& pSample = *pp;
+    pSample = 0;
+
+    IMFTrackedSamplePtr pTracked;
+
+    HRESULT hr = MFCreateTrackedSample(&pTracked);
+
+    if (FAILED(hr))
+        return hr;
+
+    hr = pTracked->SetAllocator(this, 0);
+
+    if (FAILED(hr))
+        return hr;
+
+    return pTracked->QueryInterface(&pSample);
+}
+
+
+HRESULT WebmMfBufferPool::GetBuffer(DWORD cb, IMFMediaBuffer** pp)
+{
+    if (pp == 0)
+        return E_POINTER;
+
+    IMFMediaBuffer*& pBuffer = *pp;
+    pBuffer = 0;
+
+    const int k = GetClass(cb);
+
+    if (k < 0)  //too large to keep
+    {
+        ++m_misses;  //stats only, so no lock
+        return MFCreateMemoryBuffer(cb, &pBuffer);
+    }
+
+    {
+        Lock lock;
+
+        const HRESULT hr = lock.Seize(this);
+
+        if (FAILED(hr))
+            return hr;
+
+        buffers_t& ff = m_free[k];
+
+        if (!ff.empty())
+        {
+            ++m_hits;
+
+            pBuffer = ff.back();  //pass ownership to caller
+            ff.pop_back();
+
+            return pBuffer->SetCurrentLength(0);
+        }
+
+        ++m_misses;
+    }
+
+    return MFCreateMemoryBuffer(DWORD(1) << (k + kMinShift), &pBuffer);
+}
+
+
+void WebmMfBufferPool::Shutdown()
+{
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return;
+
+    m_bShutdown = true;
+    Purge();
+}
+
+
+int WebmMfBufferPool::GetClass(DWORD cb)
+{
+    int k = 0;
+
+    while ((DWORD(1) << (k + kMinShift)) < cb)
+    {
+        if (++k > (kMaxShift - kMinShift))
+            return -1;
+    }
+
+    return k;
+}
+
+
+void WebmMfBufferPool::Recycle(IMFMediaBuffer* pBuffer)
+{
+    assert(pBuffer);
+
+    if (m_bShutdown)
+        return;
+
+    DWORD cbMaxLength;
+
+    HRESULT hr = pBuffer->GetMaxLength(&cbMaxLength);
+
+    if (FAILED(hr))
+        return;
+
+    const int k = GetClass(cbMaxLength);
+
+    //Only buffers that we created are the exact size of a class.
+
+    if ((k < 0) || (cbMaxLength != (DWORD(1) << (k + kMinShift))))
+        return;
+
+    buffers_t& ff = m_free[k];
+
+    if (ff.size() >= kMaxFree)
+        return;
+
+    pBuffer->AddRef();
+    ff.push_back(pBuffer);
+}
+
+
+void WebmMfBufferPool::Purge()
+{
+    for (int k = 0; k <= (kMaxShift - kMinShift); ++k)
+    {
+        buffers_t& ff = m_free[k];
+
+        while (!ff.empty())
+        {
+            IMFMediaBuffer* const pBuffer = ff.back();
+            ff.pop_back();
+
+            pBuffer->Release();
+        }
+    }
+}
+
+}  //end namespace WebmMfSourceLib
@@ -0,0 +1,87 @@
+#pragma once
+#include "clockable.h"
+#include <mfidl.h>
+#include <vector>
+
+namespace WebmMfSourceLib
+{
+
+//Recycles the media buffers of the samples that a stream delivers.
+//
+//Without the pool, each frame costs an MFCreateMemoryBuffer (and a heap
+//block the size of the frame), which at 60 fps video or 20ms audio
+//packets is constant churn in the playback process.  The streams get
+//their samples from CreateSample, which returns a tracked sample with
+//the pool as its allocator.  When the pipeline releases the sample, MF
+//calls the pool back, and the sample's buffers go onto a free list, to
+//be returned by a later call to GetBuffer.
+//
+//Buffers are bucketed by size, in powers of two from 256 bytes to 4MB
+//(a request is rounded up to the next size class), so a recycled buffer
+//always fits.  Frames larger than the largest class get a buffer of
+//their own, which isn't kept.  At most kMaxFree buffers of each class are
+//kept, which bounds the memory that an idle pool holds.
+//
+//The pool has its own reference count: it lives until the stream has
+//called Shutdown and the last of its samples has come back.  Samples can
+//come back on any thread.
+
+class WebmMfBufferPool : public CLockable,
+                         public IMFAsyncCallback
+{
+    WebmMfBufferPool(const WebmMfBufferPool&);
+    WebmMfBufferPool& operator=(const WebmMfBufferPool&);
+
+    WebmMfBufferPool();
+    virtual ~WebmMfBufferPool();
+
+public:
+
+    static HRESULT CreatePool(WebmMfBufferPool**);
+
+    //IUnknown
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+    //IMFAsyncCallback
+
+    HRESULT STDMETHODCALLTYPE GetParameters(DWORD*, DWORD*);
+    HRESULT STDMETHODCALLTYPE Invoke(IMFAsyncResult*);
+
+    //Local methods
+
+    //Returns an empty sample, whose buffers are returned to the pool
+    //when it is released.
+    HRESULT CreateSample(IMFSample**);
+
+    //The buffer's max length is at least cb, and its current length is 0.
+    HRESULT GetBuffer(DWORD cb, IMFMediaBuffer**);
+
+    //Releases the free buffers, and stops keeping the ones that come
+    //back after this.
+    void Shutdown();
+
+    enum { kMinShift = 8 };   //256 bytes
+    enum { kMaxShift = 22 };  //4MB
+    enum { kMaxFree = 32 };   //per size class
+
+    ULONG m_hits;    //buffers that were recycled
+    ULONG m_misses;  //buffers that had to be created
+
+private:
+
+    LONG m_cRef;
+    bool m_bShutdown;
+
+    typedef std::vector<IMFMediaBuffer*> buffers_t;
+    buffers_t m_free[kMaxShift - kMinShift + 1];
+
+    static int GetClass(DWORD cb);  //-1 if there is none
+    void Recycle(IMFMediaBuffer*);
+    void Purge();
+
+};
+
+}  //end namespace WebmMfSourceLib
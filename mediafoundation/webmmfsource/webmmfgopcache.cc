@@ -0,0 +1,167 @@
+#include "webmmfgopcache.h"
+#include <cassert>
+
+namespace WebmMfSourceLib
+{
+
+WebmMfGopCache::WebmMfGopCache(
+    unsigned long max_count,
+    unsigned long max_bytes) :
+    m_hits(0),
+    m_misses(0),
+    m_max_count(max_count),
+    m_max_bytes(max_bytes),
+    m_bytes(0)
+{
+    assert(m_max_count > 0);
+}
+
+
+WebmMfGopCache::~WebmMfGopCache()
+{
+}
+
+
+const WebmMfGopCache::Gop* WebmMfGopCache::Find(
+    long long time_ns,
+    long long end_ns)
+{
+    assert(time_ns >= 0);
+    assert(end_ns > time_ns);
+
+    typedef gops_t::iterator iter_t;
+
+    iter_t i = m_gops.begin();
+    const iter_t j = m_gops.end();
+
+    while (i != j)
+    {
+        const Gop& gop = *i;
+
+        if ((gop.start_ns <= time_ns) && (gop.end_ns >= end_ns))
+        {
+            if (i != m_gops.begin())
+                m_gops.splice(m_gops.begin(), m_gops, i);
+
+            ++m_hits;
+            return &m_gops.front();
+        }
+
+        ++i;
+    }
+
+    ++m_misses;
+    return 0;
+}
+
+
+void WebmMfGopCache::Insert(
+    long long start_ns,
+    long long end_ns,
+    frames_t& frames)
+{
+    assert(start_ns >= 0);
+    assert(end_ns > start_ns);
+
+    if (frames.empty())
+        return;
+
+    unsigned long bytes = 0;
+
+    typedef frames_t::const_iterator frame_iter_t;
+
+    frame_iter_t fi = frames.begin();
+    const frame_iter_t fj = frames.end();
+
+    while (fi != fj)
+    {
+        const Frame& f = *fi++;
+        bytes += static_cast<unsigned long>(f.data.size());
+    }
+
+    if (bytes > m_max_bytes)
+        return;
+
+    typedef gops_t::iterator iter_t;
+
+    iter_t i = m_gops.begin();
+    const iter_t j = m_gops.end();
+
+    while (i != j)
+    {
+        Gop& gop = *i;
+
+        if (gop.start_ns != start_ns)
+        {
+            ++i;
+            continue;
+        }
+
+        if (gop.end_ns >= end_ns)  //what we have already is better
+            return;
+
+        assert(m_bytes >= gop.bytes);
+        m_bytes -= gop.bytes;
+
+        m_gops.erase(i);
+        break;
+    }
+
+    m_gops.push_front(Gop());
+
+    Gop& gop = m_gops.front();
+
+    gop.start_ns = start_ns;
+    gop.end_ns = end_ns;
+    gop.bytes = bytes;
+    gop.frames.swap(frames);
+
+    m_bytes += bytes;
+
+    Evict();
+}
+
+
+void WebmMfGopCache::Evict()
+{
+    while (!m_gops.empty())
+    {
+        if ((m_gops.size() <= m_max_count) && (m_bytes <= m_max_bytes))
+            break;
+
+        const Gop& gop = m_gops.back();
+
+        assert(m_bytes >= gop.bytes);
+        m_bytes -= gop.bytes;
+
+        m_gops.pop_back();
+    }
+}
+
+
+void WebmMfGopCache::Clear()
+{
+    m_gops.clear();
+    m_bytes = 0;
+}
+
+
+unsigned long WebmMfGopCache::GetCount() const
+{
+    return static_cast<unsigned long>(m_gops.size());
+}
+
+
+unsigned long WebmMfGopCache::GetBytes() const
+{
+    return m_bytes;
+}
+
+
+unsigned long WebmMfGopCache::GetMaxBytes() const
+{
+    return m_max_bytes;
+}
+
+
+}  //end namespace WebmMfSourceLib
@@ -0,0 +1,101 @@
+#pragma once
+#include <list>
+#include <vector>
+
+namespace WebmMfSourceLib
+{
+
+//Cache of recently delivered video GOPs, used during reverse playback.
+//
+//When playing in reverse, the source walks the cue points backwards,
+//and for each GOP it sends the blocks in decode (forward) order, starting
+//with the keyframe.  A reverse-capable decoder must decode the entire GOP
+//before it can emit the last frame, so stepping backwards one frame at a
+//time means the same GOP gets requested again and again.  The cache keeps
+//the payload of the GOPs we sent most recently, so that those requests
+//can be satisfied without going back to the MkvReader page cache (which
+//we purge aggressively during reverse play, since the pages that follow
+//the current GOP are not needed again).
+//
+//Memory limits: the cache holds at most max_count GOPs, and at most
+//max_bytes of frame payload (not counting the per-frame bookkeeping).
+//When either limit is exceeded the least recently used GOP is evicted.
+//A single GOP larger than max_bytes is never cached.  The defaults are
+//16 GOPs and 32MB, which for typical 1080p VP8 content (2-5 second
+//GOPs) covers the last 30 seconds or so of reverse play.
+
+class WebmMfGopCache
+{
+    WebmMfGopCache(const WebmMfGopCache&);
+    WebmMfGopCache& operator=(const WebmMfGopCache&);
+
+public:
+
+    enum { kDefaultMaxCount = 16 };
+    enum { kDefaultMaxBytes = 32 * 1024 * 1024 };
+
+    WebmMfGopCache(
+        unsigned long max_count = kDefaultMaxCount,
+        unsigned long max_bytes = kDefaultMaxBytes);
+
+    ~WebmMfGopCache();
+
+    struct Frame
+    {
+        long long time_ns;
+        long long duration_ns;  //negative means unknown
+        bool key;
+        bool invisible;
+
+        //Payload of each frame of the block (normally just one),
+        //stored back-to-back.
+        std::vector<long> sizes;
+        std::vector<unsigned char> data;
+    };
+
+    typedef std::vector<Frame> frames_t;
+
+    struct Gop
+    {
+        long long start_ns;  //time of keyframe (the cue point)
+        long long end_ns;    //frames with time < end_ns are present
+        unsigned long bytes;
+        frames_t frames;
+    };
+
+    //Returns a GOP that starts at or before time_ns, and which contains
+    //all of the frames up to (but not including) end_ns.  The GOP
+    //becomes the most recently used.  The pointer remains valid until
+    //the next call to Insert or Clear.
+    const Gop* Find(long long time_ns, long long end_ns);
+
+    //Takes ownership of the frames (the vector is swapped, not copied).
+    //Any cached GOP with the same start time is replaced if the new
+    //GOP covers at least as much.
+    void Insert(long long start_ns, long long end_ns, frames_t&);
+
+    void Clear();
+
+    unsigned long GetCount() const;
+    unsigned long GetBytes() const;
+    unsigned long GetMaxBytes() const;
+
+    unsigned long m_hits;
+    unsigned long m_misses;
+
+private:
+
+    const unsigned long m_max_count;
+    const unsigned long m_max_bytes;
+
+    //Most recently used GOP is at the front.
+    typedef std::list<Gop> gops_t;
+    gops_t m_gops;
+
+    unsigned long m_bytes;
+
+    void Evict();
+
+};
+
+}  //end namespace WebmMfSourceLib
@@ -131,6 +131,12 @@ WebmMfSource::WebmMfSource(
 
     m_bLive = FAILED(hr);
 
+    //Each read from a network stream costs a round trip, so we keep
+    //several reads in flight, and read ahead of the parser.
+
+    if (m_bLive || m_file.HasSlowSeek() || m_file.IsPartiallyDownloaded())
+        m_file.SetReadAhead(kNetworkReads, kNetworkReadAhead);
+
     m_commands.push_back(Command(Command::kStop, this));
 
     m_thread_state = &WebmMfSource::StateAsyncRead;
@@ -1739,12 +1745,19 @@ HRESULT WebmMfSource::SetRate(BOOL bThin, float rate)
     if (m_pEvents == 0)
         return MF_E_SHUTDOWN;
 
-    if (rate < 0)
-        return MF_E_REVERSE_UNSUPPORTED;  //TODO
+    if ((rate < 0) && !ReverseSupported())
+        return MF_E_REVERSE_UNSUPPORTED;
 
     if (bThin && !ThinningSupported())
         return MF_E_THINNING_UNSUPPORTED;
 
+    //We only change direction while stopped, since the streams must
+    //be re-initialized (with a seek) before they can walk the file
+    //in the other direction.
+
+    if (((rate < 0) != (m_rate < 0)) && !IsStopped())
+        return MF_E_UNSUPPORTED_RATE_TRANSITION;
+
     typedef streams_t::iterator iter_t;
 
     iter_t i = m_streams.begin();
@@ -1832,8 +1845,8 @@ HRESULT WebmMfSource::GetSlowestRate(
     if (m_pEvents == 0)
         return MF_E_SHUTDOWN;
 
-    if (d == MFRATE_REVERSE)
-        return MF_E_REVERSE_UNSUPPORTED;  //TODO
+    if ((d == MFRATE_REVERSE) && !ReverseSupported())
+        return MF_E_REVERSE_UNSUPPORTED;
 
     if (bThin && !ThinningSupported())
         return MF_E_THINNING_UNSUPPORTED;
@@ -1868,8 +1881,8 @@ HRESULT WebmMfSource::GetFastestRate(
     if (m_pEvents == 0)
         return MF_E_SHUTDOWN;
 
-    if (d == MFRATE_REVERSE)
-        return MF_E_REVERSE_UNSUPPORTED;  //TODO
+    if ((d == MFRATE_REVERSE) && !ReverseSupported())
+        return MF_E_REVERSE_UNSUPPORTED;
 
     if (bThin && !ThinningSupported())
         return MF_E_THINNING_UNSUPPORTED;
@@ -1878,7 +1891,7 @@ HRESULT WebmMfSource::GetFastestRate(
         return E_POINTER;
 
     float& r = *pRate;
-    r = 128;  //arbitrary
+    r = (d == MFRATE_REVERSE) ? -128.0F : 128.0F;  //arbitrary
 
     return S_OK;
 }
@@ -1904,8 +1917,8 @@ HRESULT WebmMfSource::IsRateSupported(
     if (m_pEvents == 0)
         return MF_E_SHUTDOWN;
 
-    if (rate < 0)
-        return MF_E_REVERSE_UNSUPPORTED;  //TODO
+    if ((rate < 0) && !ReverseSupported())
+        return MF_E_REVERSE_UNSUPPORTED;
 
     if (bThin && !ThinningSupported())
         return MF_E_THINNING_UNSUPPORTED;
@@ -1921,6 +1934,14 @@ HRESULT WebmMfSource::IsRateSupported(
         return MF_E_UNSUPPORTED_RATE;
     }
 
+    if (rate < -128)
+    {
+        if (pNearestRate)
+            *pNearestRate = -128;
+
+        return MF_E_UNSUPPORTED_RATE;
+    }
+
     if (pNearestRate)
         *pNearestRate = rate;
 
@@ -2583,6 +2604,27 @@ WebmMfSource::thread_state_t WebmMfSource::OnRequestSample()
         return 0;
     }
 
+    hr = pStream->GetCachedSample(r.pToken);
+
+    if (FAILED(hr))
+    {
+        Error(L"OnRequestSample: GetCachedSample failed.", hr);
+        return &WebmMfSource::StateQuit;
+    }
+
+    if (hr == S_OK)  //reverse playback, and GOP was in the stream's cache
+    {
+        if (r.pToken)
+            r.pToken->Release();
+
+        rr.pop_front();
+
+        const BOOL b = SetEvent(m_hRequestSample);
+        assert(b);
+
+        return 0;
+    }
+
     const mkvparser::BlockEntry* const pCurr = pStream->GetCurrBlock();
 
     //Note that pCurr will be null only when we're thinning, or we've done
@@ -2974,6 +3016,12 @@ void WebmMfSource::PurgeCache()
     if (m_bCanSeek && !m_pSegment->GetCues()->DoneParsing())
         return;
 
+    if (m_rate < 0)
+    {
+        PurgeCacheReverse();
+        return;
+    }
+
     typedef streams_t::const_iterator iter_t;
 
     iter_t i = m_streams.begin();
@@ -3024,6 +3072,69 @@ void WebmMfSource::PurgeCache()
 }
 
 
+void WebmMfSource::PurgeCacheReverse()
+{
+    //During reverse playback we walk the file backwards, so the pages
+    //we can throw away are the ones that follow the curr cluster.
+    //(The video stream keeps its own copy of the GOPs it sent
+    //recently, so it won't ask for those pages again.)
+
+    typedef streams_t::const_iterator iter_t;
+
+    iter_t i = m_streams.begin();
+    const iter_t j = m_streams.end();
+
+    using namespace mkvparser;
+
+    LONGLONG pos = -1;  //absolute pos of end of curr cluster
+
+    while (i != j)
+    {
+        const streams_t::value_type& v = *i++;
+
+        const WebmMfStream* const pStream = v.second;
+        assert(pStream);
+
+        if (!pStream->IsSelected())
+            continue;
+
+        const BlockEntry* const pCurr = pStream->GetCurrBlock();
+
+        if ((pCurr != 0) && pCurr->EOS())
+            continue;
+
+        LONGLONG end;
+
+        if (pCurr == 0)  //block object hasn't been parsed yet
+        {
+            const LONGLONG cluster_pos = pStream->GetCurrBlockClusterPosition();
+            assert(cluster_pos >= 0);
+
+            end = m_pSegment->m_start + cluster_pos;
+        }
+        else
+        {
+            const Cluster* const pCurrCluster = pCurr->GetCluster();
+            assert(pCurrCluster);
+            assert(!pCurrCluster->EOS());
+
+            const LONGLONG size = pCurrCluster->GetElementSize();
+
+            if (size <= 0)  //unknown size
+                continue;
+
+            end = pCurrCluster->m_element_start + size;
+        }
+
+        if (end > pos)
+            pos = end;
+    }
+
+    if (pos >= 0)
+        m_file.PurgeAfter(pos);
+}
+
+
 WebmMfSource::thread_state_t
 WebmMfSource::Parse(bool& bDone)
 {
@@ -5484,6 +5595,24 @@ void WebmMfSource::PurgeRequests()
 }
 
 
+bool WebmMfSource::ReverseSupported() const
+{
+    //We play backwards by walking the cue points, so we need
+    //cues, and we need to be able to seek efficiently.
+
+    if (!m_bCanSeek)
+        return false;
+
+    if (m_file.HasSlowSeek())
+        return false;
+
+    if (m_pSegment->GetCues() == 0)
+        return false;
+
+    return HaveVideo();
+}
+
+
 bool WebmMfSource::ThinningSupported() const
 {
 #if 0
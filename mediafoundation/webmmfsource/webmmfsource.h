@@ -111,6 +111,11 @@ private:
 
     LONGLONG GetDuration() const;
 
+    //Page reads in flight, and pages of read-ahead, for a network stream
+    //(see MkvReader::SetReadAhead).
+    enum { kNetworkReads = 8 };
+    enum { kNetworkReadAhead = 32 };
+
     IClassFactory* const m_pClassFactory;
     LONG m_cRef;
     IMFMediaEventQueue* m_pEvents;
@@ -248,6 +253,7 @@ private:
     HRESULT ParseEbmlHeader(LONGLONG&);
 
     void PurgeCache();
+    void PurgeCacheReverse();
     //thread_state_t PreloadCache(bool& bDone);
     //thread_state_t PreloadCache(const mkvparser::BlockEntry*);
     thread_state_t Parse(bool& bDone);
@@ -315,6 +321,7 @@ private:
     void PurgeRequests();
 
     bool ThinningSupported() const;
+    bool ReverseSupported() const;
 
     bool m_bLive;
     bool m_bCanSeek;
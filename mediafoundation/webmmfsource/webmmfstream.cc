@@ -1,5 +1,6 @@
 #include "webmmfsource.h"
 #include "webmmfstream.h"
+#include "webmmfbufferpool.h"
 //#include "mkvparser.hpp"
 #include <mfapi.h>
 #include <mferror.h>
@@ -36,14 +37,18 @@ WebmMfStream::WebmMfStream(
     m_time_ns(-1),
     m_cluster_pos(-1),
     m_rate(1),
-    m_thin_ns(-3)  //means "not thinning"
+    m_thin_ns(-3),  //means "not thinning"
+    m_pBufferPool(0)
 {
     m_pDesc->AddRef();
 
-    const HRESULT hr = MFCreateEventQueue(&m_pEvents);
+    HRESULT hr = MFCreateEventQueue(&m_pEvents);
     assert(SUCCEEDED(hr));
     assert(m_pEvents);
 
+    hr = WebmMfBufferPool::CreatePool(&m_pBufferPool);
+    assert(SUCCEEDED(hr));  //if not, samples are created without the pool
+
     m_curr.Init();
 }
 
@@ -61,6 +66,14 @@ WebmMfStream::~WebmMfStream()
         m_pEvents = 0;
     }
 
+    if (m_pBufferPool)
+    {
+        m_pBufferPool->Shutdown();
+        m_pBufferPool->Release();  //outstanding samples may still hold it
+
+        m_pBufferPool = 0;
+    }
+
     const ULONG n = m_pDesc->Release();
     n;
 }
@@ -309,6 +322,24 @@ HRESULT WebmMfStream::ProcessSample(IMFSample* pSample)
 }
 
 
+HRESULT WebmMfStream::CreateSample(IMFSample** pp) const
+{
+    if (m_pBufferPool)
+        return m_pBufferPool->CreateSample(pp);
+
+    return MFCreateSample(pp);
+}
+
+
+HRESULT WebmMfStream::CreateBuffer(DWORD cb, IMFMediaBuffer** pp) const
+{
+    if (m_pBufferPool)
+        return m_pBufferPool->GetBuffer(cb, pp);
+
+    return MFCreateMemoryBuffer(cb, pp);
+}
+
+
 void WebmMfStream::PurgeSamples()
 {
     while (!m_samples.empty())
@@ -402,6 +433,9 @@ HRESULT WebmMfStream::Shutdown()
 
     m_pEvents = 0;
 
+    if (m_pBufferPool)
+        m_pBufferPool->Shutdown();
+
     return S_OK;
 }
 
@@ -833,7 +867,6 @@ LONGLONG WebmMfStream::GetCurrBlockClusterPosition() const
 void WebmMfStream::SetRate(BOOL bThin, float rate)
 {
     m_rate = rate;
-    assert(m_rate >= 0);  //TODO: implement reverse playback
 
     //m_thin_ns <= -3
     //  in not thinning mode
@@ -5,6 +5,7 @@ namespace WebmMfSourceLib
 {
 
 //class WebmMfSource;
+class WebmMfBufferPool;
 
 class WebmMfStream : public IMFMediaStream
 {
@@ -95,6 +96,10 @@ public:
 
     virtual HRESULT GetSample(IUnknown*) = 0;
 
+    //Returns S_FALSE if the request cannot be satisfied without
+    //first reading from the file.
+    virtual HRESULT GetCachedSample(IUnknown*) = 0;
+
 #if 0
     HRESULT SetFirstBlock(const mkvparser::Cluster*);
 #else
@@ -139,6 +144,11 @@ protected:
 
     HRESULT ProcessSample(IMFSample*);
 
+    //The samples and buffers come from the buffer pool, or are created
+    //directly if there isn't one.
+    HRESULT CreateSample(IMFSample**) const;
+    HRESULT CreateBuffer(DWORD, IMFMediaBuffer**) const;
+
     virtual void OnDeselect() = 0;
     virtual void OnSetCurrBlock() = 0;
 
@@ -158,6 +168,7 @@ protected:
 private:
 
     IMFMediaEventQueue* m_pEvents;
+    WebmMfBufferPool* m_pBufferPool;
 
     typedef std::list<IMFSample*> samples_t;
     samples_t m_samples;
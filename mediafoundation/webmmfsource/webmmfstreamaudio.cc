@@ -295,6 +295,12 @@ void WebmMfStreamAudio::OnSetCurrBlock()
     m_blocks.clear();
     m_sample_extent.clear();
     m_next_index = -1;
+
+    //Audio cannot be rendered backwards, so during reverse playback
+    //we report EOS for the audio stream immediately.
+
+    if (m_rate < 0)
+        m_curr.Init(m_pTrack->GetEOS());
 }
 
 
@@ -840,6 +846,12 @@ const mkvparser::BlockEntry* WebmMfStreamAudio::GetNextBlock() const
 #endif
 
 
+HRESULT WebmMfStreamAudio::GetCachedSample(IUnknown*)
+{
+    return S_FALSE;  //audio samples are always read from the file
+}
+
+
 bool WebmMfStreamAudio::GetSampleExtent(LONGLONG& pos, LONG& len)
 {
     if (m_thin_ns >= -1)  //thinning mode
@@ -1058,7 +1070,7 @@ HRESULT WebmMfStreamAudio::GetSample(IUnknown* pToken)
 
     IMFSamplePtr pSample;
 
-    hr = MFCreateSample(&pSample);
+    hr = CreateSample(&pSample);
     assert(SUCCEEDED(hr));  //TODO
     assert(pSample);
 
@@ -1264,7 +1276,7 @@ HRESULT WebmMfStreamAudio::ReadBlock(
 
         IMFMediaBufferPtr pBuffer;
 
-        HRESULT hr = MFCreateMemoryBuffer(cbBuffer, &pBuffer);
+        HRESULT hr = CreateBuffer(cbBuffer, &pBuffer);
         assert(SUCCEEDED(hr));  //TODO
         assert(pBuffer);
 
@@ -41,6 +41,7 @@ public:
     long NotifyNextCluster(const mkvparser::Cluster*);
 
     HRESULT GetSample(IUnknown* pToken);
+    HRESULT GetCachedSample(IUnknown* pToken);
     HRESULT ReadBlock(IMFSample*, const mkvparser::BlockEntry*) const;
 
 protected:
@@ -7,6 +7,7 @@
 #include <cassert>
 #include <limits>
 #include <cmath>
+#include <cstring>
 #include <comdef.h>
 //#include <vfwmsgs.h>
 #include <propvarutil.h>
@@ -244,7 +245,15 @@ WebmMfStreamVideo::WebmMfStreamVideo(
     const mkvparser::VideoTrack* pTrack) :
     WebmMfStream(pSource, pDesc, pTrack),
     m_pNextBlock(0),
-    m_next_index(-1)
+    m_next_index(-1),
+    m_gop_start_ns(-1),
+    m_gop_end_ns(-1),
+    m_gop_bytes(0),
+    m_pCachedGop(0),
+    m_cached_index(0),
+    m_reverse_frames(0),
+    m_reverse_cached(0),
+    m_reverse_start(0)
 {
 }
 
@@ -258,6 +267,11 @@ void WebmMfStreamVideo::OnDeselect()
 {
     m_pNextBlock = 0;
     m_next_index = -1;
+
+    m_gop_frames.clear();
+    m_gop_bytes = 0;
+    m_pCachedGop = 0;
+    m_cached_index = 0;
 }
 
 
@@ -265,6 +279,21 @@ void WebmMfStreamVideo::OnSetCurrBlock()
 {
     m_pNextBlock = 0;
     m_next_index = -1;
+
+    //If we were given a time (following a seek), then for reverse
+    //playback the first GOP ends at that time; otherwise we
+    //wait until we have the first block.
+
+    m_gop_start_ns = -1;
+    m_gop_end_ns = (m_time_ns >= 0) ? m_time_ns + 1 : -1;
+
+    m_gop_frames.clear();
+    m_gop_bytes = 0;
+    m_pCachedGop = 0;
+    m_cached_index = 0;
+
+    m_reverse_frames = 0;
+    m_reverse_cached = 0;
 }
 
 
@@ -701,7 +730,7 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
 
     IMFSamplePtr pSample;
 
-    HRESULT hr = MFCreateSample(&pSample);
+    HRESULT hr = CreateSample(&pSample);
     assert(SUCCEEDED(hr));  //TODO
     assert(pSample);
 
@@ -716,6 +745,36 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
     const int frame_count = pCurrBlock->GetFrameCount();
     assert(frame_count > 0);  //TODO
 
+    //During reverse playback we keep a copy of each block of the GOP,
+    //so we can send the GOP again without reading from the file.  Once
+    //the GOP is larger than the cache would accept, we stop copying it.
+
+    WebmMfGopCache::Frame* pCacheFrame = 0;
+
+    const unsigned long max_gop_bytes = m_gop_cache.GetMaxBytes();
+
+    if (m_rate < 0)
+    {
+        if (m_gop_start_ns < 0)  //first block following a start or seek
+        {
+            m_gop_start_ns = curr_ns;
+
+            if (m_gop_end_ns < 0)
+                m_gop_end_ns = curr_ns + 1;
+        }
+
+        if (m_gop_bytes <= max_gop_bytes)
+        {
+            m_gop_frames.push_back(WebmMfGopCache::Frame());
+            pCacheFrame = &m_gop_frames.back();
+
+            pCacheFrame->time_ns = curr_ns;
+            pCacheFrame->duration_ns = -1;
+            pCacheFrame->key = pCurrBlock->IsKey();
+            pCacheFrame->invisible = pCurrBlock->IsInvisible();
+        }
+    }
+
     for (int i = 0; i < frame_count; ++i)
     {
         const mkvparser::Block::Frame& f = pCurrBlock->GetFrame(i);
@@ -725,7 +784,7 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
 
         IMFMediaBufferPtr pBuffer;
 
-        hr = MFCreateMemoryBuffer(cbBuffer, &pBuffer);
+        hr = CreateBuffer(cbBuffer, &pBuffer);
         assert(SUCCEEDED(hr));
         assert(pBuffer);
 
@@ -743,13 +802,36 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
         {
             hr = pBuffer->SetCurrentLength(cbBuffer);
             assert(SUCCEEDED(hr));
+
+            if (pCacheFrame)
+                m_gop_bytes += static_cast<unsigned long>(cbBuffer);
+
+            if (pCacheFrame && (m_gop_bytes > max_gop_bytes))
+            {
+                //The cache won't take this GOP, so let go of our copy.
+                m_gop_frames.clear();
+                pCacheFrame = 0;
+            }
+
+            if (pCacheFrame)
+            {
+                pCacheFrame->sizes.push_back(cbBuffer);
+
+                std::vector<unsigned char>& data = pCacheFrame->data;
+                data.insert(data.end(), ptr, ptr + cbBuffer);
+            }
         }
 
         hr = pBuffer->Unlock();
         assert(SUCCEEDED(hr));
 
         if (status < 0)  //error (weird)
+        {
+            if (pCacheFrame)
+                m_gop_frames.pop_back();
+
             return E_FAIL;
+        }
 
         hr = pSample->AddBuffer(pBuffer);
         assert(SUCCEEDED(hr));
@@ -791,7 +873,14 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
 
     const LONGLONG preroll_ns = m_pSource->m_preroll_ns;
 
-    if (bInvisible || ((preroll_ns >= 0) && (curr_ns < preroll_ns)))
+    //During reverse playback, the frames that precede the seek
+    //time are exactly the ones we want rendered.
+
+    const bool bPreroll = (m_rate >= 0) &&
+                          (preroll_ns >= 0) &&
+                          (curr_ns < preroll_ns);
+
+    if (bInvisible || bPreroll)
     {
         //TODO: handle this for audio too
 
@@ -871,6 +960,32 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
     f.UnlockPage(m_pLocked);
     m_pLocked = 0;
 
+    if (m_rate < 0)  //reverse playback
+    {
+        if (pCacheFrame)
+            pCacheFrame->duration_ns = duration_ns;
+
+        ReverseStats(false);
+
+        if (IsEndOfGop(m_pNextBlock))
+        {
+            if (m_gop_bytes <= max_gop_bytes)
+                m_gop_cache.Insert(m_gop_start_ns, m_gop_end_ns, m_gop_frames);
+
+            m_gop_frames.clear();
+            m_gop_bytes = 0;
+
+            PrevGop();
+        }
+        else
+            m_curr.Init(m_pNextBlock);
+
+        m_pNextBlock = 0;
+        m_next_index = -1;
+
+        return ProcessSample(pSample);
+    }
+
     if (m_thin_ns < 0)  //non-thinning mode
     {
         m_curr.Init(m_pNextBlock);
@@ -1076,6 +1191,243 @@ HRESULT WebmMfStreamVideo::GetSample(IUnknown* pToken)
 }
 
 
+HRESULT WebmMfStreamVideo::GetCachedSample(IUnknown* pToken)
+{
+    if (m_rate >= 0)  //only reverse playback uses the GOP cache
+        return S_FALSE;
+
+    if (m_pCachedGop == 0)
+    {
+        //We can only switch to the cache at the start of a GOP,
+        //before we have parsed its first block.
+
+        if (m_curr.pBE)
+            return S_FALSE;
+
+        if ((m_time_ns < 0) || (m_gop_end_ns <= m_time_ns))
+            return S_FALSE;
+
+        m_pCachedGop = m_gop_cache.Find(m_time_ns, m_gop_end_ns);
+
+        if (m_pCachedGop == 0)
+            return S_FALSE;
+
+        m_cached_index = 0;
+        m_gop_start_ns = m_pCachedGop->start_ns;
+        m_gop_frames.clear();
+        m_gop_bytes = 0;
+    }
+
+    typedef WebmMfGopCache::frames_t frames_t;
+    const frames_t& ff = m_pCachedGop->frames;
+
+    assert(m_cached_index < ff.size());
+    const WebmMfGopCache::Frame& frame = ff[m_cached_index];
+
+    IMFSamplePtr pSample;
+
+    HRESULT hr = CreateSample(&pSample);
+    assert(SUCCEEDED(hr));  //TODO
+    assert(pSample);
+
+    if (pToken)
+    {
+        hr = pSample->SetUnknown(MFSampleExtension_Token, pToken);
+        assert(SUCCEEDED(hr));
+    }
+
+    const unsigned char* src = frame.data.empty() ? 0 : &frame.data[0];
+
+    typedef std::vector<long>::const_iterator size_iter_t;
+
+    size_iter_t i = frame.sizes.begin();
+    const size_iter_t j = frame.sizes.end();
+
+    while (i != j)
+    {
+        const long cbBuffer = *i++;
+        assert(cbBuffer > 0);
+
+        IMFMediaBufferPtr pBuffer;
+
+        hr = CreateBuffer(cbBuffer, &pBuffer);
+        assert(SUCCEEDED(hr));
+        assert(pBuffer);
+
+        BYTE* ptr;
+        DWORD cbMaxLength;
+
+        hr = pBuffer->Lock(&ptr, &cbMaxLength, 0);
+        assert(SUCCEEDED(hr));
+        assert(ptr);
+        assert(cbMaxLength >= DWORD(cbBuffer));
+
+        memcpy(ptr, src, cbBuffer);
+        src += cbBuffer;
+
+        hr = pBuffer->SetCurrentLength(cbBuffer);
+        assert(SUCCEEDED(hr));
+
+        hr = pBuffer->Unlock();
+        assert(SUCCEEDED(hr));
+
+        hr = pSample->AddBuffer(pBuffer);
+        assert(SUCCEEDED(hr));
+    }
+
+    if (frame.key)
+    {
+        hr = pSample->SetUINT32(MFSampleExtension_CleanPoint, TRUE);
+        assert(SUCCEEDED(hr));
+    }
+
+    if (m_bDiscontinuity)
+    {
+        hr = pSample->SetUINT32(MFSampleExtension_Discontinuity, TRUE);
+        assert(SUCCEEDED(hr));
+
+        m_bDiscontinuity = false;
+    }
+
+    hr = pSample->SetSampleTime(frame.time_ns / 100);
+    assert(SUCCEEDED(hr));
+
+    if (frame.invisible)
+    {
+        hr = pSample->SetUINT32(WebmTypes::WebMSample_Preroll, TRUE);
+        assert(SUCCEEDED(hr));
+    }
+
+    if (frame.duration_ns >= 0)
+    {
+        hr = pSample->SetSampleDuration(frame.duration_ns / 100);
+        assert(SUCCEEDED(hr));
+    }
+
+    ReverseStats(true);
+
+    ++m_cached_index;
+
+    if ((m_cached_index >= ff.size()) ||
+        (ff[m_cached_index].time_ns >= m_gop_end_ns))
+    {
+        PrevGop();  //resets m_pCachedGop
+    }
+
+    return ProcessSample(pSample);
+}
+
+
+bool WebmMfStreamVideo::IsEndOfGop(
+    const mkvparser::BlockEntry* pNextEntry) const
+{
+    if ((pNextEntry == 0) || pNextEntry->EOS())
+        return true;
+
+    const mkvparser::Block* const pNextBlock = pNextEntry->GetBlock();
+    assert(pNextBlock);
+
+    const mkvparser::Cluster* const pNextCluster = pNextEntry->GetCluster();
+    assert(pNextCluster);
+
+    const LONGLONG next_ns = pNextBlock->GetTime(pNextCluster);
+
+    return (next_ns >= m_gop_end_ns);
+}
+
+
+void WebmMfStreamVideo::PrevGop()
+{
+    //We have sent all of the blocks of the curr GOP.  Now find the
+    //cue point that precedes it, and lazy-init the curr block from
+    //that, the same as we do for thinning.
+
+    assert(m_gop_start_ns >= 0);
+
+    m_pCachedGop = 0;
+    m_cached_index = 0;
+
+    const mkvparser::Segment* const pSegment = m_pTrack->m_pSegment;
+    const mkvparser::Cues* const pCues = pSegment->GetCues();
+
+    using mkvparser::CuePoint;
+
+    const CuePoint* pCP;
+    const CuePoint::TrackPosition* pTP;
+
+    if ((pCues == 0) ||
+        (m_gop_start_ns <= 0) ||
+        !pCues->Find(m_gop_start_ns - 1, m_pTrack, pCP, pTP))
+    {
+        m_curr.Init(m_pTrack->GetEOS());
+        return;
+    }
+
+    assert(pCP);
+    assert(pTP);
+
+    const LONGLONG time_ns = pCP->GetTime(pSegment);
+
+    if (time_ns >= m_gop_start_ns)  //this was the first GOP
+    {
+        m_curr.Init(m_pTrack->GetEOS());
+        return;
+    }
+
+#ifdef _DEBUG
+    if (m_reverse_frames)
+    {
+        const DWORD dt = GetTickCount() - m_reverse_start;
+        const double fps = dt ? (1000.0 * m_reverse_frames / dt) : 0;
+
+        odbgstream os;
+        os << "WebmMfStreamVideo::PrevGop: gop[sec]="
+           << fixed
+           << setprecision(3)
+           << (double(time_ns) / 1000000000)
+           << " frames="
+           << m_reverse_frames
+           << " cached="
+           << m_reverse_cached
+           << " fps="
+           << setprecision(1)
+           << fps
+           << " cache.count="
+           << m_gop_cache.GetCount()
+           << " cache.bytes="
+           << m_gop_cache.GetBytes()
+           << endl;
+    }
+#endif
+
+    m_gop_end_ns = m_gop_start_ns;
+    m_gop_start_ns = time_ns;
+
+    m_time_ns = time_ns;
+    m_cluster_pos = pTP->m_pos;
+
+    m_curr.index = -1;
+    m_curr.pCluster = 0;
+    m_curr.pBE = 0;
+    m_curr.pCP = pCP;
+    m_curr.pTP = pTP;
+
+    m_bDiscontinuity = true;
+}
+
+
+void WebmMfStreamVideo::ReverseStats(bool bCached)
+{
+    if (m_reverse_frames == 0)
+        m_reverse_start = GetTickCount();
+
+    ++m_reverse_frames;
+
+    if (bCached)
+        ++m_reverse_cached;
+}
+
+
 bool WebmMfStreamVideo::GetSampleExtent(LONGLONG&, LONG&)
 {
     return true;
@@ -1,5 +1,6 @@
 #pragma once
 //#include "webmmfstream.h"
+#include "webmmfgopcache.h"
 
 namespace WebmMfSourceLib
 {
@@ -39,6 +40,7 @@ public:
     long NotifyNextCluster(const mkvparser::Cluster*);
 
     HRESULT GetSample(IUnknown* pToken);
+    HRESULT GetCachedSample(IUnknown* pToken);
 
 protected:
 
@@ -50,6 +52,31 @@ private:
     const mkvparser::BlockEntry* m_pNextBlock;
     long m_next_index;
 
+    //Reverse playback.  We send the GOPs in reverse order, but the
+    //blocks within each GOP are sent in decode order.  m_gop_start_ns
+    //is the time of the keyframe of the GOP we're sending now (negative
+    //if not known yet), and m_gop_end_ns is the time at which we stop
+    //sending blocks from this GOP (the start of the GOP we sent before
+    //this one, or just past the start time for the first GOP).
+
+    LONGLONG m_gop_start_ns;
+    LONGLONG m_gop_end_ns;
+
+    WebmMfGopCache m_gop_cache;
+    WebmMfGopCache::frames_t m_gop_frames;  //GOP being read from file
+    unsigned long m_gop_bytes;  //read so far; past the cache's max, not kept
+    const WebmMfGopCache::Gop* m_pCachedGop;  //GOP being sent from cache
+    WebmMfGopCache::frames_t::size_type m_cached_index;
+
+    //Reverse playback statistics
+    ULONG m_reverse_frames;
+    ULONG m_reverse_cached;
+    DWORD m_reverse_start;
+
+    bool IsEndOfGop(const mkvparser::BlockEntry*) const;
+    void PrevGop();
+    void ReverseStats(bool bCached);
+
     static HRESULT GetFrameRate(
         const mkvparser::VideoTrack*,
         UINT32&,
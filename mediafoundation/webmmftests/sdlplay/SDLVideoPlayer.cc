@@ -16,12 +16,20 @@
 
 #include "debugutil.h"
 #include "SDLVideoPlayer.h"
+#include "vorbisoutput.h"
+#include "vpxframeparser.h"
 
 #define TRY_DECODE_THREAD 1
 #define TRY_AUDIO_TIMING 1
 
 #define FF_REFRESH_EVENT (SDL_USEREVENT)
 
+using WebmUtil::PresentationScheduler;
+namespace VorbisOutput = WebmMfVorbisDecLib::VorbisOutput;
+
+// Longest the presentation thread sleeps between checks of the clock (ms).
+const int kMaxPresentationDelay = 10;
+
 struct VORBISFORMAT2  //matroska.org
 {
   DWORD channels;
@@ -45,11 +53,6 @@ SDLVideoPlayer::SDLVideoPlayer():
   m_bits_per_sample(NULL),
   m_audio_mutex(NULL),
   m_audio_cond(NULL),
-  m_scratch_buffer(NULL),
-  m_scratch_size(0),
-  m_vbuffer_read(0),
-  m_vbuffer_write(0),
-  m_vbuffer_size(0),
   m_base_milli(0),
   m_total_samples(0),
   m_inited(false),
@@ -101,6 +104,7 @@ int SDLVideoPlayer::Init()
     {
         m_overlay_buffer[i] = NULL;
     }
+    m_scheduler.Init(OVERLAY_BUFFER_SIZE);
     m_inited = true;
     return 0;
 }
@@ -187,6 +191,15 @@ int SDLVideoPlayer::Exit()
 #endif
   SDL_WaitThread(mythread, NULL);
 
+  const PresentationScheduler::Stats& stats = m_scheduler.GetStats();
+  DBGLOG("frames shown=" << stats.shown
+      << " dropped=" << stats.dropped
+      << " skipped=" << stats.skipped
+      << " discarded=" << stats.discarded
+      << " max drift=" << stats.max_drift << "ms"
+      << " mean drift="
+      << (stats.shown ? stats.total_drift / stats.shown : 0) << "ms");
+
   for(int i = 0; i < OVERLAY_BUFFER_SIZE; ++i)
   {
       if (m_overlay_buffer[i])
@@ -365,56 +378,46 @@ int SDLVideoPlayer::video_decode_loop(void *data)
 
   while (pSDLPlayer->signalquit)
   {
-    //int rv = 0;
-    int delay = 0;
+    int delay = kMaxPresentationDelay;
 
     SDL_LockMutex(pSDLPlayer->m_vbuffer_mutex);
 
-    if (pSDLPlayer->m_vbuffer_size == 0)
-    {
-      delay = 1;
-    }
-    else
-    {
-      unsigned int time = pSDLPlayer->get_playback_milli();
+    // The master clock is the audio clock, when there is audio.
+    const long long time = pSDLPlayer->get_playback_milli();
 
-      if (pSDLPlayer->m_overlay_milli[pSDLPlayer->m_vbuffer_read] > time)
-      {
-        // Frame is not ready to be shown
-        __int64 overlay_milli = pSDLPlayer->m_overlay_milli[pSDLPlayer->m_vbuffer_read];
-        delay = static_cast<int>(overlay_milli - time);
-      }
-      else
-      {
-        pSDLPlayer->m_last_video_milli =
-            pSDLPlayer->m_overlay_milli[pSDLPlayer->m_vbuffer_read];
+    int slot;
+    long long wait;
+    const PresentationScheduler::Action action =
+        pSDLPlayer->m_scheduler.GetNext(time, slot, wait);
 
-        //SDL_LockMutex(affmutex);
-        SDL_DisplayYUVOverlay(
-            pSDLPlayer->m_overlay_buffer[pSDLPlayer->m_vbuffer_read],
-            &pSDLPlayer->drect);
-        //SDL_UnlockMutex(affmutex);
+    SDL_UnlockMutex(pSDLPlayer->m_vbuffer_mutex);
+
+    if (action == PresentationScheduler::kActionShow)
+    {
+      // The decoder doesn't touch a slot until it has been released, so
+      // the overlay can be shown without holding the lock.
+      SDL_DisplayYUVOverlay(pSDLPlayer->m_overlay_buffer[slot],
+                            &pSDLPlayer->drect);
 
-        pSDLPlayer->m_last_video_jitter =
-            time - pSDLPlayer->m_last_video_milli;
+      SDL_LockMutex(pSDLPlayer->m_vbuffer_mutex);
 
-        pSDLPlayer->m_vbuffer_size--;
-        pSDLPlayer->m_vbuffer_read++;
-        if (pSDLPlayer->m_vbuffer_read == OVERLAY_BUFFER_SIZE)
-          pSDLPlayer->m_vbuffer_read = 0;
+      const PresentationScheduler::Stats& stats =
+          pSDLPlayer->m_scheduler.GetStats();
+      pSDLPlayer->m_last_video_milli = time - stats.last_drift;
+      pSDLPlayer->m_last_video_jitter = stats.last_drift;
+      pSDLPlayer->m_scheduler.ReleaseSlot(slot);
 
-        if (pSDLPlayer->m_last_video_jitter > 19)
-        {
-          delay = 1;
-        }
-        else
-        {
-          delay = 20 - static_cast<int>(pSDLPlayer->m_last_video_jitter);
-        }
-      }
+      SDL_UnlockMutex(pSDLPlayer->m_vbuffer_mutex);
+
+      // the next frame may be due already
+      continue;
     }
 
-    SDL_UnlockMutex(pSDLPlayer->m_vbuffer_mutex);
+    if (action == PresentationScheduler::kActionWait &&
+        wait < kMaxPresentationDelay)
+    {
+      delay = static_cast<int>(wait);
+    }
 
     SDL_Delay(delay);
   }
@@ -474,29 +477,26 @@ int SDLVideoPlayer::convert_frame(SDL_Overlay *dst_overlay,
 int SDLVideoPlayer::put_frame(vpx_image_t *img, long long time,
                               int display_width, int display_height)
 {
-  int rv = 0;
-
   SDL_LockMutex(m_vbuffer_mutex);
+  const int slot = m_scheduler.AcquireSlot();
+  SDL_UnlockMutex(m_vbuffer_mutex);
 
-  if (m_vbuffer_size == OVERLAY_BUFFER_SIZE)
+  if (slot < 0)
   {
     // 1 signals we are full
-    rv = 1;
-  }
-  else
-  {
-    // TODO(tomfinegan): check result or make void
-    convert_frame(m_overlay_buffer[m_vbuffer_write], img, display_width,
-                  display_height);
-    m_overlay_milli[m_vbuffer_write] = time;
-    m_vbuffer_size++;
-    m_vbuffer_write++;
-    if (m_vbuffer_write == OVERLAY_BUFFER_SIZE)
-      m_vbuffer_write = 0;
+    return 1;
   }
 
+  // The slot isn't visible to the presentation thread until it's
+  // committed, so convert without holding the lock.
+  // TODO(tomfinegan): check result or make void
+  convert_frame(m_overlay_buffer[slot], img, display_width, display_height);
+
+  SDL_LockMutex(m_vbuffer_mutex);
+  m_scheduler.CommitSlot(slot, time);
   SDL_UnlockMutex(m_vbuffer_mutex);
-  return rv;
+
+  return 0;
 }
 
 int SDLVideoPlayer::setup_vpx_decoder()
@@ -531,16 +531,31 @@ int SDLVideoPlayer::decode_vpx_frame(const unsigned char* data,
 {
 #ifdef TRY_DECODE_THREAD
   jitter;
+
+  // Frames that nothing else references can be skipped entirely when
+  // we're far enough behind the clock.
+  WebmUtil::VpxFrameInfo info;
+  const bool droppable =
+      WebmUtil::ParseVP8Frame(data, size, info) == WebmUtil::kVpxParseOk &&
+      info.droppable;
+
   // Check to see if the decode buffer is full
   SDL_LockMutex(m_vbuffer_mutex);
-  if (m_vbuffer_size == OVERLAY_BUFFER_SIZE)
+  if (m_scheduler.IsFull())
   {
     // 1 signals we are full
     SDL_UnlockMutex(m_vbuffer_mutex);
     return 1;
   }
+  const PresentationScheduler::Decision decision =
+      m_scheduler.Admit(milli, get_playback_milli(), droppable);
   SDL_UnlockMutex(m_vbuffer_mutex);
 
+  if (decision == PresentationScheduler::kSkip)
+  {
+    return 0;
+  }
+
   vpx_dec_iter_t  iter = NULL;
   vpx_image_t    *img;
 
@@ -555,7 +570,12 @@ int SDLVideoPlayer::decode_vpx_frame(const unsigned char* data,
 
   img = vpx_codec_get_frame(&decoder, &iter);
 
-  put_frame(img, milli, m_width, m_height);
+  // Late frames that had to be decoded (later frames depend on them)
+  // aren't worth converting: they would only be dropped.
+  if (img && decision == PresentationScheduler::kDecodeAndQueue)
+  {
+    rv = put_frame(img, milli, m_width, m_height);
+  }
 #else
   vpx_dec_iter_t  iter = NULL;
   vpx_image_t    *img;
@@ -763,38 +783,20 @@ void SDLVideoPlayer::audio_callback(void *userdata, Uint8 *stream, int len)
     unsigned int ulen = len;
     if (bytes_available >= ulen)
     {
-      // TODO Don't use magic numbers here
-      const int float_buf_size = samples_wanted * 2 * 4;
-      if (pPlayer->m_scratch_size < float_buf_size)
-      {
-        delete [] pPlayer->m_scratch_buffer;
-        pPlayer->m_scratch_buffer = new unsigned char[float_buf_size];
-        pPlayer->m_scratch_size = float_buf_size;
-      }
-
-      rv = pPlayer->m_vorbis_decoder.ConsumeOutputSamples(
-          (float*)pPlayer->m_scratch_buffer, samples_wanted);
-
-      const int samples_to_convert = samples_wanted * 2;
-
-      short *ptr = (short*)stream;
-      float *mono = (float *)pPlayer->m_scratch_buffer;
-
-      for (int i=0; i<samples_to_convert; i++)
-      {
-        int val=static_cast<int>(floor(mono[i]*32767.f+.5f));
-
-        if(val>32767){
-          val=32767;
-          //clipflag=1;
-        }
-        if(val<-32768){
-          val=-32768;
-          //clipflag=1;
-        }
-        *ptr=static_cast<short>(val);
-        ptr++;
-      }
+      // Downmixed to stereo, and converted to 16-bit PCM, straight into
+      // SDL's buffer.
+      const VorbisOutput::Renderer render =
+          VorbisOutput::GetRenderer(
+              pPlayer->m_vorbis_decoder.GetVorbisChannels(),
+              2,
+              VorbisOutput::kInt16);
+
+      if (render)
+        rv = pPlayer->m_vorbis_decoder.ConsumeOutputSamples(render,
+                                                            stream,
+                                                            samples_wanted);
+      else
+        memset(stream, 0, len);  // mono, or more than 8 channels
 
 #ifdef TRY_AUDIO_TIMING
       pPlayer->m_total_samples += samples_wanted;
@@ -825,8 +827,15 @@ unsigned int SDLVideoPlayer::get_playback_milli()
 #ifdef TRY_AUDIO_TIMING
   if (m_setup_audio)
   {
+    // |m_total_samples| counts the samples we've handed to SDL; the last
+    // device buffer's worth of them hasn't been heard yet.
+    long long samples_played = m_total_samples - m_spec.samples;
+    if (samples_played < 0)
+    {
+      samples_played = 0;
+    }
     double milliseconds =
-        (((double)m_total_samples) / m_sample_rate) * 1000.0;
+        (((double)samples_played) / m_sample_rate) * 1000.0;
     return (unsigned int)milliseconds;
   }
 #endif
@@ -857,3 +866,13 @@ int SDLVideoPlayer::get_last_time_rendered(long long& video_milli,
 
   return 0;
 }
+
+int SDLVideoPlayer::get_presentation_stats(
+    PresentationScheduler::Stats& stats)
+{
+  SDL_LockMutex(m_vbuffer_mutex);
+  stats = m_scheduler.GetStats();
+  SDL_UnlockMutex(m_vbuffer_mutex);
+
+  return 0;
+}
@@ -9,6 +9,7 @@
 #ifndef __WEBMDSHOW_MEDIAFOUNDATION_WEBMMFTESTS_SDLPLAY_SDLVIDEOPLAYER_H__
 #define __WEBMDSHOW_MEDIAFOUNDATION_WEBMMFTESTS_SDLPLAY_SDLVIDEOPLAYER_H__
 
+#include "presentationscheduler.h"
 #include "vorbisdecoder.h"
 #include "vpx/vpx_decoder.h"
 #include "vpx/vp8dx.h"
@@ -68,6 +69,11 @@ public:
                                long long& video_milli_jitter,
                                long long& audio_milli);
 
+    // A/V drift (video behind the master clock is positive) and dropped
+    // frame counts.
+    int get_presentation_stats(
+        WebmUtil::PresentationScheduler::Stats& stats);
+
 private:
 
     // Video
@@ -85,11 +91,12 @@ private:
 
     SDL_Thread *m_video_thread;
     SDL_mutex *m_vbuffer_mutex;
+    // One overlay per scheduler slot; |m_scheduler| decides which one
+    // to show when (against |get_playback_milli|), and which frames to
+    // drop, or not to decode at all, when we fall behind.  Both are
+    // guarded by |m_vbuffer_mutex|.
     SDL_Overlay *m_overlay_buffer[OVERLAY_BUFFER_SIZE];
-    long long m_overlay_milli[OVERLAY_BUFFER_SIZE];
-    int m_vbuffer_read;
-    int m_vbuffer_write;
-    int m_vbuffer_size;
+    WebmUtil::PresentationScheduler m_scheduler;
 
     long long m_last_video_milli;
     long long m_last_video_jitter;
@@ -103,8 +110,6 @@ private:
     SDL_cond *m_audio_cond;
     SDL_AudioSpec m_wanted_spec;
     SDL_AudioSpec m_spec;
-    unsigned char* m_scratch_buffer;
-    int m_scratch_size;
     long long m_total_samples;
 
     std::queue<AudioFrame*> m_audio_queue;
@@ -68,8 +68,7 @@ WebmMfVorbisDec::WebmMfVorbisDec(IClassFactory* pClassFactory) :
     m_total_samples_decoded(0),
     m_mediatime_decoded(-1),
     m_drain(false),
-    m_post_process_samples(false),
-    m_scratch(NULL, 0)
+    m_render(NULL)
 {
     HRESULT hr = m_pClassFactory->LockServer(TRUE);
     assert(SUCCEEDED(hr));
@@ -392,6 +391,8 @@ HRESULT WebmMfVorbisDec::SetInputType(DWORD dwInputStreamID,
         if (m_output_mediatype)
             m_output_mediatype = 0;
 
+        m_render = NULL;
+
         return S_OK;
     }
 
@@ -451,6 +452,8 @@ HRESULT WebmMfVorbisDec::SetOutputType(DWORD dwOutputStreamID,
         if (m_output_mediatype)
             m_output_mediatype = 0;
 
+        m_render = NULL;
+
         return S_OK;
     }
 
@@ -460,6 +463,13 @@ HRESULT WebmMfVorbisDec::SetOutputType(DWORD dwOutputStreamID,
     if (FormatSupported(false, pmt) == false)
         return MF_E_INVALIDMEDIATYPE;
 
+    // Pick the output stage for this conversion now, so that it doesn't
+    // have to be worked out for each sample.
+    const VorbisOutput::Renderer render = GetRenderer(pmt);
+
+    if (render == NULL)
+        return MF_E_INVALIDMEDIATYPE;
+
     if (dwFlags & MFT_SET_TYPE_TEST_ONLY)
         return S_OK;
 
@@ -488,34 +498,7 @@ HRESULT WebmMfVorbisDec::SetOutputType(DWORD dwOutputStreamID,
     if (FAILED(hr))
         return hr;
 
-    // Check to see if input matches output
-    UINT32 channels_in;
-    hr = m_input_mediatype->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channels_in);
-    if (FAILED(hr))
-        return hr;
-
-    UINT32 channels_out;
-    hr = m_output_mediatype->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS,
-      &channels_out);
-    if (FAILED(hr))
-        return hr;
-
-    if (channels_in == channels_out)
-    {
-        GUID subtype_out;
-        hr = m_output_mediatype->GetGUID(MF_MT_SUBTYPE, &subtype_out);
-        if (FAILED(hr))
-            return hr;
-
-        if (subtype_out != MFAudioFormat_Float)
-        {
-            m_post_process_samples = true;
-        }
-    }
-    else
-    {
-        m_post_process_samples = true;
-    }
+    m_render = render;
 
     CHK(hr, m_output_mediatype->GetUINT32(MF_MT_AUDIO_BLOCK_ALIGNMENT,
                                           &m_block_align));
@@ -832,74 +815,27 @@ HRESULT WebmMfVorbisDec::ProcessLibVorbisOutput(IMFSample* p_sample,
     // requested: shoving it all in just because it fits isn't what we want...
     const DWORD max_bytes_to_consume = samples_to_process * block_align;
     assert(max_bytes_to_consume <= mf_storage_limit);
-    if (!m_post_process_samples)
-    {
-        BYTE* p_mf_buffer_data = NULL;
-        DWORD mf_data_len = 0;
-        status = mf_output_buffer->Lock(&p_mf_buffer_data, &mf_storage_limit,
-                                        &mf_data_len);
-        if (FAILED(status))
-            return status;
 
-        float* const ptr_mf_buffer =
-            reinterpret_cast<float*>(p_mf_buffer_data);
+    // The decoder's samples are rendered straight into the output buffer.
+    BYTE* p_mf_buffer_data = NULL;
+    DWORD mf_data_len = 0;
+    status = mf_output_buffer->Lock(&p_mf_buffer_data, &mf_storage_limit,
+                                    &mf_data_len);
+    if (FAILED(status))
+        return status;
 
-        status = m_vorbis_decoder.ConsumeOutputSamples(ptr_mf_buffer,
-                                                       samples_to_process);
+    assert(m_render);
+    status = m_vorbis_decoder.ConsumeOutputSamples(m_render,
+                                                   p_mf_buffer_data,
+                                                   samples_to_process);
 
-        assert(SUCCEEDED(status));
+    assert(SUCCEEDED(status));
 
-        const HRESULT unlock_status = mf_output_buffer->Unlock();
-        assert(SUCCEEDED(unlock_status));
-        if (FAILED(unlock_status))
-        {
-            return unlock_status;
-        }
-    }
-    else
+    const HRESULT unlock_status = mf_output_buffer->Unlock();
+    assert(SUCCEEDED(unlock_status));
+    if (FAILED(unlock_status))
     {
-        const DWORD vorbis_bytes_to_consume = samples_to_process *
-            m_vorbis_decoder.GetVorbisChannels() * sizeof(float);
-
-        if (m_scratch.size() < vorbis_bytes_to_consume)
-        {
-            m_scratch.reset(
-                new (std::nothrow) unsigned char[vorbis_bytes_to_consume],
-                vorbis_bytes_to_consume);
-            if (!m_scratch)
-            {
-                return E_OUTOFMEMORY;
-            }
-        }
-
-        float* const p_vorbis_float_buffer =
-            reinterpret_cast<float*>(m_scratch.get());
-
-        status = m_vorbis_decoder.ConsumeOutputSamples(p_vorbis_float_buffer,
-                                                       samples_to_process);
-
-        assert(SUCCEEDED(status));
-
-        BYTE* p_mf_buffer_data = NULL;
-        DWORD mf_data_len = 0;
-        status = mf_output_buffer->Lock(&p_mf_buffer_data, &mf_storage_limit,
-                                        &mf_data_len);
-        if (FAILED(status))
-            return status;
-
-        if (!PostProcessSamples(p_vorbis_float_buffer,
-                                samples_to_process,
-                                p_mf_buffer_data))
-        {
-            return E_INVALIDARG;
-        }
-
-        const HRESULT unlock_status = mf_output_buffer->Unlock();
-        assert(SUCCEEDED(unlock_status));
-        if (FAILED(unlock_status))
-        {
-            return unlock_status;
-        }
+        return unlock_status;
     }
 
     const UINT32 bytes_written = max_bytes_to_consume;
@@ -910,167 +846,32 @@ HRESULT WebmMfVorbisDec::ProcessLibVorbisOutput(IMFSample* p_sample,
     return status;
 }
 
-bool WebmMfVorbisDec::PostProcessSamples(float* const p_vorbis_float_buffer,
-                                         UINT32 samples_to_process,
-                                         BYTE* p_mf_buffer_data)
+VorbisOutput::Renderer WebmMfVorbisDec::GetRenderer(IMFMediaType* pmt) const
 {
-    UINT32 channels_to_convert = m_vorbis_decoder.GetVorbisChannels();
+    assert(pmt);
+    assert(m_input_mediatype);
+
+    UINT32 channels_in;
+    HRESULT hr = m_input_mediatype->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS,
+                                              &channels_in);
+    if (FAILED(hr))
+        return NULL;
 
     UINT32 channels_out;
-    HRESULT hr = m_output_mediatype->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS,
-                                               &channels_out);
+    hr = pmt->GetUINT32(MF_MT_AUDIO_NUM_CHANNELS, &channels_out);
     if (FAILED(hr))
-        return false;
-    assert(channels_out <= channels_to_convert);
+        return NULL;
 
     GUID subtype_out;
-    hr = m_output_mediatype->GetGUID(MF_MT_SUBTYPE, &subtype_out);
+    hr = pmt->GetGUID(MF_MT_SUBTYPE, &subtype_out);
     if (FAILED(hr))
-        return false;
+        return NULL;
 
-    if (channels_out < channels_to_convert)
-    {
-        const bool convert_to_short =
-            (subtype_out != MFAudioFormat_Float) ? true : false;
-
-        float* src = static_cast<float*>(p_vorbis_float_buffer);
-        float* dstfl = reinterpret_cast<float*>(p_mf_buffer_data);
-        short* dst16 = reinterpret_cast<short*>(p_mf_buffer_data);
-
-        // TODO(tomfinegan or fgalligan): setup a postprocessing function ptr
-        //                                and always call through the ptr to
-        //                                avoid most of the format checks
-        //                                during playback.
-        for (UINT32 i=0; i<samples_to_process; ++i)
-        {
-            float left = 0.0f;
-            float right = 0.0f;
-
-            if (channels_out == 2)
-            {
-                // Downmix to stereo
-                switch (channels_to_convert)
-                {
-                case 8:
-                    left = src[0] + src[3] + src[2] * 0.7f
-                        + src[4] * 0.7f + src[6] * 0.7f;
-                    right = src[1] + src[3] + src[2] * 0.7f
-                        + src[5] * 0.7f + src[7] * 0.7f;
-                    src += 8;
-                    break;
-                case 7:
-                    left = src[0] + src[3] + src[2] * 0.7f
-                        + src[4] * 0.7f + src[6] * 0.7f;
-                    right = src[1] + src[3] + src[2] * 0.7f
-                        + src[5] * 0.7f + src[6] * 0.7f;
-                    src += 7;
-                    break;
-                case 6:
-                    left = src[0] + src[3] + src[2] * 0.7f + src[4] * 0.7f;
-                    right = src[1] + src[3] + src[2] * 0.7f + src[5] * 0.7f;
-                    src += 6;
-                    break;
-                case 5:
-                    left = src[0] + src[2] * 0.7f + src[3] * 0.7f;
-                    right = src[1] + src[2] * 0.7f + src[4] * 0.7f;
-                    src += 5;
-                    break;
-                case 4:
-                    left = src[0] + src[2] * 0.7f + src[3] * 0.7f;
-                    right = src[1] + src[2] * 0.7f + src[3] * 0.7f;
-                    src += 4;
-                    break;
-                case 3:
-                    left = src[0] + src[2] * 0.7f;
-                    right = src[1] + src[2] * 0.7f;
-                    src += 3;
-                    break;
-                }
-
-                if (convert_to_short)
-                {
-                    int val = static_cast<int>(floor(left * 32767.f + .5f));
-                    if (val > 32767)
-                    {
-                        val = 32767;
-                    }
-                    else if (val < -32768)
-                    {
-                        val = -32768;
-                    }
-                    *dst16++ = static_cast<short>(val);
-
-                    val = static_cast<int>(floor(right * 32767.f + .5f));
-                    if(val > 32767)
-                    {
-                        val = 32767;
-                    }
-                    else if(val < -32768)
-                    {
-                        val = -32768;
-                    }
-                    *dst16++ = static_cast<short>(val);
-                }
-                else
-                {
-                    *dstfl++ = left;
-                    *dstfl++ = right;
-                }
-            }
-            else if (channels_out == 6)
-            {
-                // fold to 5.1
-                if (convert_to_short)
-                {
-                    for (int j=0; j<6; ++j)
-                    {
-                        int val = static_cast<int>(floor(src[j] *
-                                                   32767.f + .5f));
-                        if (val > 32767)
-                        {
-                            val = 32767;
-                        }
-                        else if (val < -32768)
-                        {
-                            val = -32768;
-                        }
-                        *dst16++ = static_cast<short>(val);
-                    }
-                }
-                else
-                {
-                    memcpy(dstfl, src, 6 * sizeof(float));
-                    dstfl += 6;
-                }
-
-                src += channels_to_convert;
-            }
-        }
-    }
-    else if (subtype_out != MFAudioFormat_Float)
-    {
-        const int samples_to_convert =
-            samples_to_process * channels_to_convert;
-
-        float* src = static_cast<float*>(p_vorbis_float_buffer);
-        short* dst16 = reinterpret_cast<short*>(p_mf_buffer_data);
-
-        for (int i=0; i<samples_to_convert; i++)
-        {
-            int val = static_cast<int>(floor(src[i] * 32767.f + .5f));
-            if (val > 32767)
-            {
-                val = 32767;
-            }
-            else if (val < -32768)
-            {
-                val = -32768;
-            }
-            *dst16++ = static_cast<short>(val);
-        }
-    }
+    const VorbisOutput::SampleFormat format =
+        (subtype_out == MFAudioFormat_Float) ? VorbisOutput::kFloat :
+                                               VorbisOutput::kInt16;
 
-    return true;
+    return VorbisOutput::GetRenderer(channels_in, channels_out, format);
 }
 
 REFERENCE_TIME WebmMfVorbisDec::SamplesToMediaTime(UINT64 sample_count) const
@@ -155,21 +155,17 @@ private:
 
     HRESULT ResetMediaType(bool reset_input);
 
-    bool PostProcessSamples(float* const p_vorbis_float_buffer,
-                            UINT32 samples_to_process,
-                            BYTE* p_mf_buffer_data);
+    // Returns the output stage that converts the decoder's samples to the
+    // output type |pmt|, or NULL if there isn't one.
+    VorbisOutput::Renderer GetRenderer(IMFMediaType* pmt) const;
+
     REFERENCE_TIME SamplesToMediaTime(UINT64 num_samples) const;
     UINT64 MediaTimeToSamples(REFERENCE_TIME media_time) const;
 
-    // Scratch buffer used by the filter to convert samples from one format to
-    // another.
-    WebmUtil::auto_array<unsigned char> m_scratch;
-
     bool m_drain;
-    // When |m_post_process_samples| is true the filter will need to process
-    // the output from the decoder because the input format does not match
-    // the output format.
-    bool m_post_process_samples;
+
+    // Renders the decoder's samples in the output format (see SetOutputType).
+    VorbisOutput::Renderer m_render;
 
     IClassFactory* const m_pClassFactory;
 
@@ -0,0 +1,77 @@
+#!/bin/sh
+##
+##  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+##
+##  Use of this source code is governed by a BSD-style license
+##  that can be found in the LICENSE file in the root of the source
+##  tree. An additional intellectual property rights grant can be found
+##  in the file PATENTS.  All contributing project authors may
+##  be found in the AUTHORS file in the root of the source tree.
+##
+##  Builds oggtowebm with the host compiler (Linux or OS X).  Like
+##  webmbench, it builds against the stand-ins for the Windows headers in
+##  common/portable, and it uses common's pooled media sample.
+##
+set -e
+
+readonly TOOL_DIR="$(cd "$(dirname "$0")" && pwd)"
+readonly ROOT_DIR="$(dirname "${TOOL_DIR}")"
+
+CXX="${CXX:-c++}"
+CXXFLAGS="${CXXFLAGS:--O2 -DNDEBUG}"
+OUT="${OUT:-${TOOL_DIR}/oggtowebm}"
+
+build_usage() {
+cat << EOF
+  Usage: ${0##*/} [arguments]
+    --help: Display this message and exit.
+
+  Environment: CXX, CXXFLAGS, OUT (the executable).
+EOF
+}
+
+for arg in "$@"; do
+  case "${arg}" in
+    --help)
+      build_usage
+      exit
+      ;;
+    *)
+      build_usage
+      exit 1
+      ;;
+  esac
+done
+
+# The portable directory comes first, so that its headers shadow the
+# Windows SDK headers (and the two repo headers that can't be built here).
+includes="-I${ROOT_DIR}/common/portable -I${TOOL_DIR} \
+-I${ROOT_DIR}/common -I${ROOT_DIR}/third_party -I${ROOT_DIR}/webmmux \
+-I${ROOT_DIR}/webmoggsource"
+
+sources="${TOOL_DIR}/oggtowebm.cc
+${TOOL_DIR}/oggremuxer.cc
+${TOOL_DIR}/oggfilereader.cc
+${TOOL_DIR}/filestream.cc
+${ROOT_DIR}/common/portable/webmportable.cc
+${ROOT_DIR}/common/memsample.cc
+${ROOT_DIR}/common/oggpacketclock.cc
+${ROOT_DIR}/webmoggsource/oggparser.cc
+${ROOT_DIR}/common/pipelinestats.cc
+${ROOT_DIR}/common/scratchbuf.cc
+${ROOT_DIR}/common/cmediatypes.cc
+${ROOT_DIR}/common/mediatypeutil.cc
+${ROOT_DIR}/common/vorbistypes.cc
+${ROOT_DIR}/common/webmtypes.cc
+${ROOT_DIR}/webmmux/webmmuxcontext.cc
+${ROOT_DIR}/webmmux/webmmuxebmlio.cc
+${ROOT_DIR}/webmmux/webmmuxstream.cc
+${ROOT_DIR}/webmmux/webmmuxstreamaudio.cc
+${ROOT_DIR}/webmmux/webmmuxstreamaudiovorbis.cc
+${ROOT_DIR}/webmmux/webmmuxstreamvideo.cc
+${ROOT_DIR}/webmmux/webmmuxstreamvideovpx.cc"
+
+${CXX} -std=c++11 ${CXXFLAGS} -include webmportable.h ${includes} \
+  ${sources} -o "${OUT}"
+
+echo "${0##*/}: built ${OUT}"
@@ -0,0 +1,255 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "filestream.h"
+#include <cassert>
+#include <unistd.h>
+
+namespace OggToWebm
+{
+
+FileStream::FileStream() :
+    m_cRef(1),
+    m_file(0),
+    m_length(0),
+    m_pos(0),
+    m_error(false),
+    m_reading(false)
+{
+}
+
+
+FileStream::~FileStream()
+{
+    assert(m_cRef == 1);  //the remuxer's own reference
+
+    Close();
+}
+
+
+HRESULT FileStream::Open(const char* filename)
+{
+    if (filename == 0)
+        return E_INVALIDARG;
+
+    if (m_file)
+        return E_UNEXPECTED;
+
+    //The muxer reads back what it has written (to find the cues when it
+    //closes the file), so this is opened for update.
+
+    m_file = fopen(filename, "w+b");
+
+    if (m_file == 0)
+        return E_FAIL;
+
+    m_length = 0;
+    m_pos = 0;
+    m_error = false;
+    m_reading = false;
+
+    return S_OK;
+}
+
+
+HRESULT FileStream::Close()
+{
+    if (m_file == 0)
+        return S_FALSE;
+
+    const int result = fclose(m_file);
+    m_file = 0;
+
+    if ((result != 0) || m_error)
+        return STG_E_MEDIUMFULL;
+
+    return S_OK;
+}
+
+
+LONGLONG FileStream::GetLength() const
+{
+    return m_length;
+}
+
+
+HRESULT FileStream::QueryInterface(REFIID iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = static_cast<IStream*>(this);
+
+    else if (iid == __uuidof(ISequentialStream))
+        pUnk = static_cast<ISequentialStream*>(this);
+
+    else if (iid == __uuidof(IStream))
+        pUnk = static_cast<IStream*>(this);
+
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG FileStream::AddRef()
+{
+    return ++m_cRef;
+}
+
+
+ULONG FileStream::Release()
+{
+    assert(m_cRef > 1);  //owned by the remuxer, not by its clients
+    return --m_cRef;
+}
+
+
+HRESULT FileStream::Read(void* buf, ULONG cb, ULONG* pcbRead)
+{
+    assert(m_file);
+    assert(buf || (cb == 0));
+
+    if (!SetDirection(true))
+        return E_FAIL;
+
+    const size_t n = fread(buf, 1, cb, m_file);
+
+    m_pos += n;
+
+    if (pcbRead)
+        *pcbRead = static_cast<ULONG>(n);
+
+    if (n < cb)
+        return ferror(m_file) ? E_FAIL : S_FALSE;
+
+    return S_OK;
+}
+
+
+HRESULT FileStream::Write(const void* buf, ULONG cb, ULONG* pcbWritten)
+{
+    assert(m_file);
+    assert(buf || (cb == 0));
+
+    if (!SetDirection(false))
+        return STG_E_MEDIUMFULL;
+
+    const size_t n = fwrite(buf, 1, cb, m_file);
+
+    m_pos += n;
+
+    if (m_pos > m_length)
+        m_length = m_pos;
+
+    if (pcbWritten)
+        *pcbWritten = static_cast<ULONG>(n);
+
+    if (n < cb)
+    {
+        m_error = true;  //the muxer asserts instead of checking
+        return STG_E_MEDIUMFULL;
+    }
+
+    return S_OK;
+}
+
+
+HRESULT FileStream::Seek(
+    LARGE_INTEGER move,
+    DWORD origin,
+    ULARGE_INTEGER* pnewpos)
+{
+    assert(m_file);
+
+    LONGLONG pos;
+
+    switch (origin)
+    {
+        case STREAM_SEEK_SET:
+            pos = move.QuadPart;
+            break;
+
+        case STREAM_SEEK_CUR:
+            pos = m_pos + move.QuadPart;
+            break;
+
+        case STREAM_SEEK_END:
+            pos = m_length + move.QuadPart;
+            break;
+
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+
+    if (pos < 0)
+        return STG_E_INVALIDFUNCTION;
+
+    //Seeking to where we already are is the common case; skipping it
+    //keeps stdio from discarding its buffer.
+
+    if (pos != m_pos)
+    {
+        if (fseeko(m_file, pos, SEEK_SET) != 0)
+            return STG_E_INVALIDFUNCTION;
+
+        m_reading = false;  //either direction can follow a seek
+    }
+
+    m_pos = pos;
+
+    if (pnewpos)
+        pnewpos->QuadPart = pos;
+
+    return S_OK;
+}
+
+
+HRESULT FileStream::SetSize(ULARGE_INTEGER size)
+{
+    assert(m_file);
+
+    const LONGLONG len = static_cast<LONGLONG>(size.QuadPart);
+
+    if (fflush(m_file) != 0)
+        return STG_E_MEDIUMFULL;
+
+    if (ftruncate(fileno(m_file), len) != 0)
+        return STG_E_MEDIUMFULL;
+
+    m_length = len;
+
+    return S_OK;
+}
+
+
+bool FileStream::SetDirection(bool reading)
+{
+    //A stdio stream opened for update can't switch between reading and
+    //writing without a seek in between.
+
+    if (reading == m_reading)
+        return true;
+
+    if (fseeko(m_file, m_pos, SEEK_SET) != 0)
+        return false;
+
+    m_reading = reading;
+    return true;
+}
+
+}  //end namespace OggToWebm
@@ -0,0 +1,61 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <cstdio>
+
+namespace OggToWebm
+{
+
+//The file that the muxer writes.  The muxer writes the file front to
+//back, and only seeks back to patch the sizes of the elements it has
+//already written, so the stdio buffer is all the buffering it needs.
+
+class FileStream : public IStream
+{
+    FileStream(const FileStream&);
+    FileStream& operator=(const FileStream&);
+
+public:
+
+    FileStream();
+    virtual ~FileStream();
+
+    HRESULT Open(const char*);
+    HRESULT Close();
+
+    LONGLONG GetLength() const;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+    HRESULT STDMETHODCALLTYPE Read(void*, ULONG, ULONG*);
+    HRESULT STDMETHODCALLTYPE Write(const void*, ULONG, ULONG*);
+
+    HRESULT STDMETHODCALLTYPE Seek(
+        LARGE_INTEGER,
+        DWORD,
+        ULARGE_INTEGER*);
+
+    HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER);
+
+private:
+
+    ULONG m_cRef;
+    FILE* m_file;
+    LONGLONG m_length;
+    LONGLONG m_pos;
+    bool m_error;
+    bool m_reading;  //else writing
+
+    bool SetDirection(bool reading);
+
+};
+
+}  //end namespace OggToWebm
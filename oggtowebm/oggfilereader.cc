@@ -0,0 +1,176 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "oggfilereader.h"
+#include <cassert>
+#include <cstring>
+
+namespace OggToWebm
+{
+
+OggFileReader::OggFileReader() :
+    m_file(0),
+    m_length(0),
+    m_bytes_read(0),
+    m_window(kWindowSize),
+    m_window_pos(0),
+    m_window_len(0)
+{
+}
+
+
+OggFileReader::~OggFileReader()
+{
+    Close();
+}
+
+
+HRESULT OggFileReader::Open(const char* filename)
+{
+    if (filename == 0)
+        return E_INVALIDARG;
+
+    if (m_file)
+        return E_UNEXPECTED;
+
+    m_file = fopen(filename, "rb");
+
+    if (m_file == 0)
+        return E_FAIL;
+
+    setvbuf(m_file, 0, _IONBF, 0);  //the window is our buffer
+
+    if ((fseeko(m_file, 0, SEEK_END) != 0) ||
+        ((m_length = ftello(m_file)) < 0))
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_bytes_read = 0;
+    m_window_pos = 0;
+    m_window_len = 0;
+
+    return S_OK;
+}
+
+
+void OggFileReader::Close()
+{
+    if (m_file == 0)
+        return;
+
+    fclose(m_file);
+    m_file = 0;
+}
+
+
+bool OggFileReader::IsOpen() const
+{
+    return (m_file != 0);
+}
+
+
+long long OggFileReader::GetLength() const
+{
+    return m_length;
+}
+
+
+long long OggFileReader::GetBytesRead() const
+{
+    return m_bytes_read;
+}
+
+
+long OggFileReader::Read(
+    long long pos,
+    long len,
+    unsigned char* buf)
+{
+    if (!IsOpen())
+        return -1;
+
+    if (pos < 0)
+        return -1;
+
+    if (len < 0)
+        return -1;
+
+    if (pos > m_length)
+        return oggparser::E_END_OF_FILE;
+
+    if (len > kWindowSize)  //won't fit, so bypass the window
+    {
+        const long result = ReadFile(pos, len, buf);
+
+        if (result < 0)
+            return result;
+
+        return (result < len) ? oggparser::E_END_OF_FILE : 0;
+    }
+
+    const long long window_end = m_window_pos + m_window_len;
+
+    if ((pos < m_window_pos) || ((pos + len) > window_end))
+    {
+        //Slide the window so that it starts here.  The parser reads
+        //forward, so this is the only place the window will be needed.
+
+        const long result = ReadFile(pos, kWindowSize, &m_window[0]);
+
+        if (result < 0)
+        {
+            m_window_len = 0;
+            return result;
+        }
+
+        m_window_pos = pos;
+        m_window_len = result;
+    }
+
+    const long long off = pos - m_window_pos;
+    const long long avail = m_window_len - off;
+
+    if (avail < len)  //Testing for the End of a File
+    {
+        if (avail > 0)
+            memcpy(buf, &m_window[0] + off, static_cast<size_t>(avail));
+
+        return oggparser::E_END_OF_FILE;
+    }
+
+    memcpy(buf, &m_window[0] + off, len);
+
+    return 0;  //success
+}
+
+
+long OggFileReader::ReadFile(
+    long long pos,
+    long len,
+    unsigned char* buf)
+{
+    assert(m_file);
+    assert(len >= 0);
+
+    if (fseeko(m_file, pos, SEEK_SET) != 0)
+        return oggparser::E_READ_ERROR;
+
+    const size_t n = fread(buf, 1, len, m_file);
+
+    if ((n < size_t(len)) && ferror(m_file))
+        return oggparser::E_READ_ERROR;
+
+    m_bytes_read += n;
+
+    return static_cast<long>(n);
+}
+
+}  //end namespace OggToWebm
@@ -0,0 +1,58 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <cstdio>
+#include <vector>
+#include "oggparser.h"
+
+namespace OggToWebm
+{
+
+//The Ogg parser reads the file a few bytes at a time (a page header is
+//read one field at a time), and reads the segments of a packet a second
+//time when the packet is copied out.  This reader keeps a window of the
+//file in memory, so that those reads are satisfied without going back to
+//the disk, and the file is read once, front to back.
+
+class OggFileReader : public oggparser::IOggReader
+{
+    OggFileReader(const OggFileReader&);
+    OggFileReader& operator=(const OggFileReader&);
+
+public:
+
+    OggFileReader();
+    virtual ~OggFileReader();
+
+    HRESULT Open(const char*);
+    void Close();
+    bool IsOpen() const;
+
+    long long GetLength() const;     //of the file
+    long long GetBytesRead() const;  //from the file (so far)
+
+    long Read(long long pos, long len, unsigned char* buf);
+
+private:
+
+    enum { kWindowSize = 256 * 1024 };  //larger than any Ogg page
+
+    FILE* m_file;
+    long long m_length;
+    long long m_bytes_read;
+
+    std::vector<unsigned char> m_window;
+    long long m_window_pos;
+    long m_window_len;
+
+    long ReadFile(long long pos, long len, unsigned char* buf);
+
+};
+
+}  //end namespace OggToWebm
@@ -0,0 +1,322 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <uuids.h>
+#include <vfwmsgs.h>
+#include "oggremuxer.h"
+#include "oggfilereader.h"
+#include "filestream.h"
+#include "vorbistypes.h"
+#include "webmmuxcontext.h"
+#include "webmmuxstreamaudiovorbis.h"
+#include <cassert>
+#include <new>
+
+using oggparser::OggStream;
+
+namespace OggToWebm
+{
+
+OggRemuxer::OggRemuxer() :
+    m_pReader(0),
+    m_pClock(0)
+{
+}
+
+
+OggRemuxer::~OggRemuxer()
+{
+}
+
+
+HRESULT OggRemuxer::Remux(const char* src, const char* dst, Stats& stats)
+{
+    using namespace WebmMuxLib;
+
+    stats.packets = 0;
+    stats.bytes_in = 0;
+    stats.bytes_out = 0;
+    stats.duration = 0;
+
+    OggFileReader reader;
+
+    HRESULT hr = reader.Open(src);
+
+    if (FAILED(hr))
+        return hr;
+
+    OggStream stream(&reader);
+
+    Packet ident, comment, setup;
+
+    long result = stream.Init(ident, comment, setup);
+
+    if (result < 0)
+    {
+        if (result == oggparser::E_READ_ERROR)
+            return E_FAIL;
+
+        return VFW_E_INVALID_FILE_FORMAT;
+    }
+
+    oggparser::VorbisIdent fmt;
+
+    result = fmt.Read(&reader, ident);
+
+    if ((result < 0) || (fmt.channels == 0) || (fmt.sample_rate == 0))
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    std::vector<BYTE> format;
+    AM_MEDIA_TYPE mt;
+
+    hr = GetMediaType(&reader, fmt, ident, comment, setup, format, mt);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (!StreamAudioVorbis::QueryAccept(mt))
+        return VFW_E_TYPE_NOT_ACCEPTED;
+
+    FileStream file;
+
+    hr = file.Open(dst);
+
+    if (FAILED(hr))
+        return hr;
+
+    WebmUtil::OggPacketClock clock(fmt.sample_rate);
+
+    m_pReader = &reader;
+    m_pClock = &clock;
+
+    assert(m_packets.empty());
+
+    Context ctx;
+
+    StreamAudio* const pAudio = StreamAudioVorbis::CreateStream(ctx, mt);
+
+    if (pAudio == 0)
+        return E_OUTOFMEMORY;
+
+    ctx.SetAudioStream(pAudio);
+    ctx.Open(&file);
+
+    for (;;)
+    {
+        Packet pkt;
+
+        result = stream.GetPacket(pkt);
+
+        if (result < 0)  //error (or EOF)
+        {
+            if (result == oggparser::E_END_OF_FILE)
+                hr = Flush(pAudio, stats);  //packets with no granule pos
+            else if (result == oggparser::E_READ_ERROR)
+                hr = E_FAIL;
+            else
+                hr = VFW_E_INVALID_FILE_FORMAT;
+
+            break;
+        }
+
+        m_packets.push_back(pkt);
+
+        if (pkt.granule_pos < 0)  //wait for the end of its page
+            continue;
+
+        hr = Flush(pAudio, stats);
+
+        if (FAILED(hr))
+            break;
+    }
+
+    pAudio->EndOfStream();
+    ctx.Close();
+
+    ctx.SetAudioStream(0);
+    delete static_cast<Stream*>(pAudio);
+
+    m_packets.clear();
+    m_pReader = 0;
+    m_pClock = 0;
+
+    const HRESULT hrClose = file.Close();
+
+    if (SUCCEEDED(hr) && FAILED(hrClose))
+        hr = hrClose;
+
+    stats.bytes_in = reader.GetBytesRead();
+    stats.bytes_out = file.GetLength();
+    stats.duration = clock.GetTime(clock.GetGranulePos());
+
+    return hr;
+}
+
+
+HRESULT OggRemuxer::GetMediaType(
+    oggparser::IOggReader* pReader,
+    const oggparser::VorbisIdent& fmt,
+    const Packet& ident,
+    const Packet& comment,
+    const Packet& setup,
+    std::vector<BYTE>& format,
+    AM_MEDIA_TYPE& mt)
+{
+    //This is the format that the Ogg source filter offers (see
+    //OggTrackAudio::GetMediaTypes): the three headers follow the
+    //VORBISFORMAT2 struct.
+
+    const long ident_len = ident.GetLength();
+    const long comment_len = comment.GetLength();
+    const long setup_len = setup.GetLength();
+
+    if ((ident_len <= 0) || (comment_len <= 0) || (setup_len <= 0))
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    using VorbisTypes::VORBISFORMAT2;
+
+    const size_t hdr_len = ident_len + comment_len + setup_len;
+
+    format.assign(sizeof(VORBISFORMAT2) + hdr_len, 0);
+
+    VORBISFORMAT2& f = reinterpret_cast<VORBISFORMAT2&>(format[0]);
+
+    f.channels = fmt.channels;
+    f.samplesPerSec = fmt.sample_rate;
+    f.bitsPerSample = 0;
+    f.headerSize[0] = ident_len;
+    f.headerSize[1] = comment_len;
+    f.headerSize[2] = setup_len;
+
+    BYTE* dst = &format[0] + sizeof(VORBISFORMAT2);
+
+    if (ident.Copy(pReader, dst) != ident_len)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    dst += ident_len;
+
+    if (comment.Copy(pReader, dst) != comment_len)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    dst += comment_len;
+
+    if (setup.Copy(pReader, dst) != setup_len)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    mt.majortype = MEDIATYPE_Audio;
+    mt.subtype = VorbisTypes::MEDIASUBTYPE_Vorbis2;
+    mt.bFixedSizeSamples = FALSE;
+    mt.bTemporalCompression = FALSE;
+    mt.lSampleSize = 0;
+    mt.formattype = VorbisTypes::FORMAT_Vorbis2;
+    mt.pUnk = 0;
+    mt.cbFormat = static_cast<ULONG>(format.size());
+    mt.pbFormat = &format[0];
+
+    return S_OK;
+}
+
+
+HRESULT OggRemuxer::Flush(WebmMuxLib::StreamAudio* pAudio, Stats& stats)
+{
+    if (m_packets.empty())
+        return S_OK;
+
+    //The packets are those of one page, and only the last of them has a
+    //granule pos (or none does, if this is EOS and the last page didn't
+    //complete a packet).
+
+    const long count = static_cast<long>(m_packets.size());
+    const long long granule_pos = m_packets.back().granule_pos;
+
+    if (!m_pClock->OnPage(granule_pos, count, m_times))
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    for (long i = 0; i < count; ++i)
+    {
+        const WebmUtil::OggPacketClock::Times& t = m_times[i];
+
+        const HRESULT hr = Send(pAudio, m_packets.front(), t.start, t.stop);
+
+        if (FAILED(hr))
+            return hr;
+
+        m_packets.pop_front();
+        ++stats.packets;
+    }
+
+    assert(m_packets.empty());
+
+    return S_OK;
+}
+
+
+HRESULT OggRemuxer::Send(
+    WebmMuxLib::StreamAudio* pAudio,
+    const Packet& pkt,
+    LONGLONG start,
+    LONGLONG stop)
+{
+    using WebmUtil::MemSample;
+
+    const long len = pkt.GetLength();
+
+    if (len <= 0)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    //The muxer copies the payload, so the sample is back in the pool as
+    //soon as Receive returns, and one buffer (the size of the largest
+    //packet so far) is all that is ever allocated.
+
+    if ((m_pool.get() == 0) || (m_pool->GetSize() < len))
+    {
+        long size = (m_pool.get() == 0) ? 8 * 1024 : m_pool->GetSize();
+
+        while (size < len)
+            size *= 2;
+
+        m_pool.reset(new (std::nothrow) MemSample::Pool(size));
+
+        if (m_pool.get() == 0)
+            return E_OUTOFMEMORY;
+    }
+
+    MemSample* const pSample = m_pool->GetSample();
+
+    if (pSample == 0)
+        return E_OUTOFMEMORY;
+
+    BYTE* buf;
+
+    HRESULT hr = pSample->GetPointer(&buf);
+    assert(SUCCEEDED(hr));
+
+    if (pkt.Copy(m_pReader, buf) != len)
+    {
+        pSample->Release();
+        return VFW_E_INVALID_FILE_FORMAT;
+    }
+
+    hr = pSample->SetActualDataLength(len);
+    assert(SUCCEEDED(hr));
+
+    hr = pSample->SetTime(&start, (stop < 0) ? 0 : &stop);
+    assert(SUCCEEDED(hr));
+
+    hr = pSample->SetSyncPoint(TRUE);
+    assert(SUCCEEDED(hr));
+
+    hr = pAudio->Receive(pSample);
+
+    pSample->Release();
+
+    return hr;
+}
+
+}  //end namespace OggToWebm
@@ -0,0 +1,87 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <list>
+#include <memory>
+#include <vector>
+#include "oggparser.h"
+#include "oggpacketclock.h"
+#include "memsample.h"
+
+namespace WebmMuxLib
+{
+class StreamAudio;
+}
+
+namespace OggToWebm
+{
+
+//Moves the Vorbis packets of an Ogg file into a WebM file, without a
+//filter graph: oggparser::OggStream is the packet source, and a
+//WebmMuxLib::Context is the sink.  The packets are timestamped the way
+//the Ogg source filter does it (the samples of a page are spread evenly
+//over its packets), as for makewebm --ogg-to-webm.
+//
+//The input is read once and the output written once.  What is held in
+//memory is one Ogg page's worth of packets and the muxer's current
+//cluster, so the memory used doesn't grow with the length of the file.
+
+class OggRemuxer
+{
+    OggRemuxer(const OggRemuxer&);
+    OggRemuxer& operator=(const OggRemuxer&);
+
+public:
+
+    struct Stats
+    {
+        long long packets;
+        long long bytes_in;   //read from the Ogg file
+        long long bytes_out;  //of the WebM file
+        long long duration;   //reftime units
+    };
+
+    OggRemuxer();
+    ~OggRemuxer();
+
+    //Returns VFW_E_INVALID_FILE_FORMAT if the input isn't Ogg Vorbis.
+    HRESULT Remux(const char* src, const char* dst, Stats&);
+
+private:
+
+    typedef oggparser::OggStream::Packet Packet;
+    typedef oggparser::OggStream::packets_t packets_t;
+
+    oggparser::IOggReader* m_pReader;
+    WebmUtil::OggPacketClock* m_pClock;
+    std::unique_ptr<WebmUtil::MemSample::Pool> m_pool;
+
+    packets_t m_packets;  //waiting for their page's granule pos
+    WebmUtil::OggPacketClock::times_t m_times;
+
+    static HRESULT GetMediaType(
+        oggparser::IOggReader*,
+        const oggparser::VorbisIdent&,
+        const Packet& ident,
+        const Packet& comment,
+        const Packet& setup,
+        std::vector<BYTE>& format,
+        AM_MEDIA_TYPE&);
+
+    HRESULT Flush(WebmMuxLib::StreamAudio*, Stats&);
+
+    HRESULT Send(
+        WebmMuxLib::StreamAudio*,
+        const Packet&,
+        LONGLONG start,
+        LONGLONG stop);
+
+};
+
+}  //end namespace OggToWebm
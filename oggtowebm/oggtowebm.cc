@@ -0,0 +1,209 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+//Remuxes an Ogg Vorbis file into a WebM file, without DirectShow (see
+//OggRemuxer).  With --runs it also measures how many files per second
+//the remuxer gets through, for comparison with makewebm --ogg-to-webm,
+//which does the same job with a filter graph.  See build.sh for how to
+//build it on Linux.
+
+#include <strmif.h>
+#include "oggremuxer.h"
+#include "pipelinestats.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using OggToWebm::OggRemuxer;
+using WebmUtil::PipelineStats;
+
+namespace
+{
+
+void Usage()
+{
+    printf(
+        "usage: oggtowebm [options] INPUT.ogg OUTPUT.webm\n"
+        "\n"
+        "  --runs=N    remux the file N times, and report the throughput\n"
+        "  --quiet     print nothing unless there is an error\n");
+}
+
+
+bool ParseRuns(const char* arg, int& runs)
+{
+    static const char name[] = "--runs=";
+    const size_t len = sizeof name - 1;
+
+    if (strncmp(arg, name, len) != 0)
+        return false;
+
+    char* end;
+    const long val = strtol(arg + len, &end, 10);
+
+    if ((end == arg + len) || (*end != '\0') || (val < 1) || (val > 100000))
+        return false;
+
+    runs = static_cast<int>(val);
+    return true;
+}
+
+
+const char* GetErrorText(HRESULT hr)
+{
+    switch (hr)
+    {
+        case VFW_E_INVALID_FILE_FORMAT:
+            return "not an Ogg Vorbis file, or it is damaged";
+
+        case VFW_E_TYPE_NOT_ACCEPTED:
+            return "the muxer doesn't accept this Vorbis stream";
+
+        case STG_E_MEDIUMFULL:
+            return "unable to write the output file";
+
+        case E_OUTOFMEMORY:
+            return "out of memory";
+
+        default:
+            return "unable to read the input file, or create the output file";
+    }
+}
+
+
+long long GetPeakResident()  //bytes
+{
+    struct rusage ru;
+
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    return ru.ru_maxrss;
+#else
+    return static_cast<long long>(ru.ru_maxrss) * 1024;
+#endif
+}
+
+}  //end anonymous namespace
+
+
+int main(int argc, char* argv[])
+{
+    int runs = 0;
+    bool quiet = false;
+    const char* src = 0;
+    const char* dst = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        if ((strcmp(arg, "--help") == 0) || (strcmp(arg, "-h") == 0))
+        {
+            Usage();
+            return 0;
+        }
+
+        if (strcmp(arg, "--quiet") == 0)
+            quiet = true;
+
+        else if (strncmp(arg, "--runs", 6) == 0)
+        {
+            if (!ParseRuns(arg, runs))
+            {
+                fprintf(stderr, "oggtowebm: bad value: %s\n", arg);
+                return 1;
+            }
+        }
+
+        else if (strncmp(arg, "--", 2) == 0)
+        {
+            fprintf(stderr, "oggtowebm: unknown option: %s\n", arg);
+            return 1;
+        }
+
+        else if (src == 0)
+            src = arg;
+
+        else if (dst == 0)
+            dst = arg;
+
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (dst == 0)
+    {
+        Usage();
+        return 1;
+    }
+
+    OggRemuxer remuxer;
+    OggRemuxer::Stats stats;
+
+    std::vector<long long> times;  //us
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    do
+    {
+        const long long t = PipelineStats::GetMicroseconds();
+
+        const HRESULT hr = remuxer.Remux(src, dst, stats);
+
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "oggtowebm: %s: %s (0x%08X)\n",
+                    src, GetErrorText(hr), static_cast<unsigned>(hr));
+
+            return 1;
+        }
+
+        times.push_back(PipelineStats::GetMicroseconds() - t);
+    }
+    while (static_cast<int>(times.size()) < runs);
+
+    const long long total_us = PipelineStats::GetMicroseconds() - start_us;
+
+    if (quiet)
+        return 0;
+
+    printf("%s: %lld packets, %.1f sec, %lld bytes read, %lld written\n",
+           dst,
+           stats.packets,
+           double(stats.duration) / 10000000,
+           stats.bytes_in,
+           stats.bytes_out);
+
+    if (runs <= 0)
+        return 0;
+
+    std::sort(times.begin(), times.end());
+
+    const double sec = double(total_us) / 1000000;
+    const double files_per_sec = (sec > 0) ? runs / sec : 0;
+    const double mb_per_sec = files_per_sec * stats.bytes_in / 1000000;
+
+    printf("%d runs: %.1f files/s, %.1f MB/s in, best %.3f ms, "
+           "median %.3f ms, peak resident %.1f MB\n",
+           runs,
+           files_per_sec,
+           mb_per_sec,
+           double(times.front()) / 1000,
+           double(times[times.size() / 2]) / 1000,
+           double(GetPeakResident()) / (1024 * 1024));
+
+    return 0;
+}
@@ -17,8 +17,13 @@
 // webmdshow is windows only at present, we don't use port.h
 //#include "base/port.h"    // Types that only need exist on certain systems
 // add what we needed from port.h
+#ifdef _MSC_VER
 #define GG_LONGLONG(x) x##I64
 #define GG_ULONGLONG(x) x##UI64
+#else  // the portable builds (see webmbench)
+#define GG_LONGLONG(x) x##LL
+#define GG_ULONGLONG(x) x##ULL
+#endif
 
 // webmdshow is windows only at present
 //#ifndef COMPILER_MSVC
@@ -84,6 +84,12 @@ HRESULT Filter::CNondelegating::QueryInterface(const IID& iid, void** ppv) {
   else if (iid == __uuidof(IVP8PostProcessing)) {
     pUnk = static_cast<IVP8PostProcessing*>(m_pFilter);
   }
+  else if (iid == __uuidof(IVP8DecoderQuality)) {
+    pUnk = static_cast<IVP8DecoderQuality*>(m_pFilter);
+  }
+  else if (iid == __uuidof(IPipelineStats)) {
+    pUnk = static_cast<IPipelineStats*>(m_pFilter);
+  }
   else {
 #if 0
     wodbgstream os;
@@ -566,6 +572,109 @@ HRESULT Filter::ApplyPostProcessing() {
   return m_inpin.OnApplyPostProcessing();
 }
 
+HRESULT Filter::SetAdaptiveQuality(BOOL enable) {
+  Lock lock;
+
+  const HRESULT hr = lock.Seize(this);
+
+  if (FAILED(hr))
+    return hr;
+
+  // If this changes the level, the post-processing is updated when the
+  // next frame is received.
+  m_inpin.m_governor.SetEnabled(enable != FALSE);
+
+  return S_OK;
+}
+
+HRESULT Filter::GetAdaptiveQuality(BOOL* pEnable) {
+  if (pEnable == 0)
+    return E_POINTER;
+
+  Lock lock;
+
+  const HRESULT hr = lock.Seize(this);
+
+  if (FAILED(hr))
+    return hr;
+
+  *pEnable = m_inpin.m_governor.IsEnabled() ? TRUE : FALSE;
+
+  return S_OK;
+}
+
+HRESULT Filter::GetQualityStatistics(VP8QualityStatistics* pStats) {
+  if (pStats == 0)
+    return E_POINTER;
+
+  Lock lock;
+
+  const HRESULT hr = lock.Seize(this);
+
+  if (FAILED(hr))
+    return hr;
+
+  typedef WebmUtil::VpxQualityGovernor governor_t;
+  const governor_t& governor = m_inpin.m_governor;
+  const governor_t::Stats& src = governor.GetStats();
+
+  VP8QualityStatistics& tgt = *pStats;
+
+  tgt.Level = governor.GetLevel();
+  tgt.Notifications = src.notifications;
+  tgt.MaxLate = src.max_late;
+  tgt.Frames = src.frames;
+  tgt.Decoded = src.decoded;
+  tgt.Skipped = src.skipped;
+  tgt.StepDowns = src.step_downs;
+  tgt.StepUps = src.step_ups;
+
+  enum { count = sizeof(tgt.FramesAtLevel) / sizeof(tgt.FramesAtLevel[0]) };
+  assert(count == governor_t::kLevelCount);
+
+  for (int i = 0; i < count; ++i)
+    tgt.FramesAtLevel[i] = src.frames_at_level[i];
+
+  return S_OK;
+}
+
+HRESULT Filter::ResetQualityStatistics() {
+  Lock lock;
+
+  const HRESULT hr = lock.Seize(this);
+
+  if (FAILED(hr))
+    return hr;
+
+  m_inpin.m_governor.ResetStats();
+
+  return S_OK;
+}
+
+ULONG Filter::GetStreamCount() {
+  return 2;  // one per pin
+}
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p) {
+  if (p == 0)
+    return E_POINTER;
+
+  const Pin* const pins[] = { &m_inpin, &m_outpin };
+
+  if (index >= GetStreamCount())
+    return E_INVALIDARG;
+
+  pins[index]->m_pipeline_stats.GetSnapshot(*p);
+  return S_OK;
+}
+
+HRESULT Filter::ResetStats() {
+  m_inpin.m_pipeline_stats.Reset();
+  m_outpin.m_pipeline_stats.Reset();
+
+  return S_OK;
+}
+
 void Filter::OnStart() {
   HRESULT hr = m_inpin.Start();
   assert(SUCCEEDED(hr));  // TODO
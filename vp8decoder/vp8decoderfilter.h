@@ -13,13 +13,18 @@
 #include <string>
 
 #include "clockable.h"
+#include "ipipelinestats.h"
 #include "vp8decoderidl.h"
 #include "vp8decoderinpin.h"
 #include "vp8decoderoutpin.h"
 
 namespace VP8DecoderLib {
 
-class Filter : public IBaseFilter, public IVP8PostProcessing, public CLockable {
+class Filter : public IBaseFilter,
+               public IVP8PostProcessing,
+               public IVP8DecoderQuality,
+               public IPipelineStats,
+               public CLockable {
  public:
   struct Config {
     int flags;
@@ -55,6 +60,17 @@ class Filter : public IBaseFilter, public IVP8PostProcessing, public CLockable {
   HRESULT STDMETHODCALLTYPE GetNoiseLevel(int*);
   HRESULT STDMETHODCALLTYPE ApplyPostProcessing();
 
+  // IVP8DecoderQuality
+  HRESULT STDMETHODCALLTYPE SetAdaptiveQuality(BOOL);
+  HRESULT STDMETHODCALLTYPE GetAdaptiveQuality(BOOL*);
+  HRESULT STDMETHODCALLTYPE GetQualityStatistics(VP8QualityStatistics*);
+  HRESULT STDMETHODCALLTYPE ResetQualityStatistics();
+
+  // IPipelineStats
+  ULONG STDMETHODCALLTYPE GetStreamCount();
+  HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+  HRESULT STDMETHODCALLTYPE ResetStats();
+
   // local classes and methods
   FILTER_STATE GetStateLocked() const;
   HRESULT OnDecodeFailureLocked();
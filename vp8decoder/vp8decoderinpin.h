@@ -14,6 +14,7 @@
 
 #include "graphutil.h"
 #include "vp8decoderpin.h"
+#include "vpxqualitygovernor.h"
 
 namespace VP8DecoderLib {
 
@@ -51,12 +52,19 @@ class Inpin : public Pin, public IMemInputPin {
   void Stop();  // from running/paused to stopped
   HRESULT OnApplyPostProcessing();
 
+  // Called (with the filter locked) for each quality report that the
+  // downstream renderer sends to our outpin.
+  void OnQualityNotify(const Quality&);
+
+  WebmUtil::VpxQualityGovernor m_governor;
+
  protected:
   HRESULT GetName(PIN_INFO&) const;
   HRESULT OnDisconnect();
 
  private:
   HRESULT PopulateSample(IMediaSample*, const vpx_image_t*);
+  bool OnQualityFrame(const BYTE*, long);
 
   static void CopyToPlanar(const vpx_image_t* image, IMediaSample* sample,
                            const GUID& subtype_out,
@@ -73,6 +81,7 @@ class Inpin : public Pin, public IMemInputPin {
   bool m_bEndOfStream;
   bool m_bFlush;
   vpx_codec_ctx_t m_ctx;
+  int m_postproc_level;  // governor level of the applied postproc config
 };
 
 }  // namespace VP8DecoderLib
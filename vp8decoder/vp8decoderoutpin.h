@@ -16,7 +16,7 @@
 namespace VP8DecoderLib {
 class Filter;
 
-class Outpin : public Pin, public IMediaSeeking {
+class Outpin : public Pin, public IMediaSeeking, public IQualityControl {
  public:
   explicit Outpin(Filter*);
   virtual ~Outpin();
@@ -63,6 +63,10 @@ class Outpin : public Pin, public IMediaSeeking {
   HRESULT STDMETHODCALLTYPE GetRate(double*);
   HRESULT STDMETHODCALLTYPE GetPreroll(LONGLONG*);
 
+  // IQualityControl
+  HRESULT STDMETHODCALLTYPE Notify(IBaseFilter*, Quality);
+  HRESULT STDMETHODCALLTYPE SetSink(IQualityControl*);
+
   // local functions
   GraphUtil::IMemInputPinPtr m_pInputPin;
   GraphUtil::IMemAllocatorPtr m_pAllocator;
@@ -83,6 +87,8 @@ class Outpin : public Pin, public IMediaSeeking {
 
   void SetDefaultMediaTypes();
 
+  IQualityControl* m_pQualitySink;  // not AddRef'd
+
   static HRESULT QueryAcceptVideoInfo(const AM_MEDIA_TYPE& mt_in,
                                       const AM_MEDIA_TYPE& mt_out);
 
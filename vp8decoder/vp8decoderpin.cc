@@ -21,7 +21,10 @@ using std::endl;
 namespace VP8DecoderLib {
 
 Pin::Pin(Filter* pFilter, PIN_DIRECTION dir, const wchar_t* id)
-    : m_pFilter(pFilter), m_dir(dir), m_id(id) {}
+    : m_pFilter(pFilter),
+      m_dir(dir),
+      m_id(id),
+      m_pipeline_stats(id) {}
 
 Pin::~Pin() { assert(!bool(m_pPinConnection)); }
 
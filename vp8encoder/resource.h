@@ -29,6 +29,8 @@
 #define IDC_CLEAR                       1023
 #define IDC_RELOAD                      1024
 #define IDC_ENCODER_KIND                1025
+#define IDC_TILE_COLUMNS                1026
+#define IDC_FRAME_PARALLEL              1027
 
 // Next default values for new objects
 // 
@@ -36,7 +38,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        102
 #define _APS_NEXT_COMMAND_VALUE         40001
-#define _APS_NEXT_CONTROL_VALUE         1026
+#define _APS_NEXT_CONTROL_VALUE         1028
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif
@@ -13,6 +13,7 @@
 #include "cenumpins.h"
 #include <new>
 #include <cassert>
+#include <cstddef>
 #include <vfwmsgs.h>
 #ifdef _DEBUG
 #include "iidstr.h"
@@ -29,6 +30,16 @@ namespace VP8EncoderLib
 
 extern const CLSID CLSID_PropPage;
 
+//The size that Save wrote for a config that ended at |len|: the struct's
+//size, padded to its alignment.
+static unsigned __int32 GetSavedConfigSize(size_t len)
+{
+    const size_t align = __alignof(Filter::Config);
+    const size_t size = (len + align - 1) / align * align;
+
+    return static_cast<unsigned __int32>(size);
+}
+
 HRESULT CreateFilter(
     IClassFactory* pClassFactory,
     IUnknown* pOuter,
@@ -87,6 +98,16 @@ Filter::Filter(IClassFactory* pClassFactory, IUnknown* pOuter)
 {
     m_pClassFactory->LockServer(TRUE);
 
+    const wchar_t* const ids[kMaxRenditions] =
+    {
+        L"output 1",
+        L"output 2",
+        L"output 3"
+    };
+
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i] = new OutpinRendition(this, i, ids[i]);
+
     const HRESULT hr = CLockable::Init();
     assert(SUCCEEDED(hr));
 
@@ -98,6 +119,9 @@ Filter::Filter(IClassFactory* pClassFactory, IUnknown* pOuter)
     m_outpin_video.SetDefaultMediaTypes();
     m_outpin_preview.SetDefaultMediaTypes();
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i]->SetDefaultMediaTypes();
+
 #ifdef _DEBUG
     odbgstream os;
     os << "vp8enc::filter::ctor" << endl;
@@ -113,6 +137,9 @@ Filter::~Filter()
     os << "vp8enc::filter::dtor" << endl;
 #endif
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+        delete m_outpin_renditions[i];
+
     m_pClassFactory->LockServer(FALSE);
 }
 
@@ -153,6 +180,31 @@ void Filter::Config::Init()
     arnr_type = -1;
     cpu_used = -17;
     static_threshold = -1;
+    tile_columns = -1;
+    frame_parallel = -1;
+
+    rendition_count = 0;
+
+    const int32_t heights[kMaxRenditions] = { 720, 360, 180 };
+
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        Rendition& r = renditions[i];
+
+        r.width = 0;
+        r.height = heights[i];
+        r.target_bitrate = 0;
+    }
+
+    speed_governor = -1;
+    governor_cpu_used_min = -1;
+    governor_cpu_used_max = -1;
+    governor_deadline = -1;
+    governor_scaling = 0;
+
+    preview_max_width = 1280;
+    preview_max_height = 720;
+    preview_max_frame_rate = 30;
 }
 
 
@@ -192,6 +244,22 @@ HRESULT Filter::CNondelegating::QueryInterface(
     {
         pUnk = static_cast<IPersistStream*>(m_pFilter);
     }
+    else if (iid == __uuidof(IVP9Encoder))
+    {
+        pUnk = static_cast<IVP9Encoder*>(m_pFilter);
+    }
+    else if (iid == __uuidof(IVPXSimulcast))
+    {
+        pUnk = static_cast<IVPXSimulcast*>(m_pFilter);
+    }
+    else if (iid == __uuidof(IVPXSpeedGovernor))
+    {
+        pUnk = static_cast<IVPXSpeedGovernor*>(m_pFilter);
+    }
+    else if (iid == __uuidof(IVPXPreview))
+    {
+        pUnk = static_cast<IVPXPreview*>(m_pFilter);
+    }
     else if (iid == __uuidof(IVPXEncoder))
     {
         pUnk = static_cast<IVPXEncoder*>(m_pFilter);
@@ -204,6 +272,14 @@ HRESULT Filter::CNondelegating::QueryInterface(
     {
         pUnk = static_cast<ISpecifyPropertyPages*>(m_pFilter);
     }
+    else if (iid == __uuidof(IPipelineStats))
+    {
+        pUnk = static_cast<IPipelineStats*>(m_pFilter);
+    }
+    else if (iid == __uuidof(IPipelineEvents))
+    {
+        pUnk = static_cast<IPipelineEvents*>(m_pFilter);
+    }
     else
     {
 #if 0
@@ -449,14 +525,19 @@ HRESULT Filter::EnumPins(IEnumPins** pp)
     if (FAILED(hr))
         return hr;
 
-    IPin* pins[3] =
+    IPin* pins[3 + kMaxRenditions] =
     {
         &m_inpin,
         &m_outpin_video,
         &m_outpin_preview
     };
 
-    return CEnumPins::CreateInstance(pins, 3, pp);
+    const int n = GetActiveRenditionCount();
+
+    for (int i = 0; i < n; ++i)
+        pins[3 + i] = m_outpin_renditions[i];
+
+    return CEnumPins::CreateInstance(pins, 3 + n, pp);
 }
 
 
@@ -474,16 +555,21 @@ HRESULT Filter::FindPin(
     if (id1 == 0)
         return E_INVALIDARG;
 
-    Pin* pins[3] =
+    Pin* pins[3 + kMaxRenditions] =
     {
         &m_inpin,
         &m_outpin_video,
         &m_outpin_preview
     };
 
+    const int n = 3 + GetActiveRenditionCount();
+
+    for (int i = 3; i < n; ++i)
+        pins[i] = m_outpin_renditions[i - 3];
+
     Pin** iter = pins;
 
-    for (int i = 0; i < 3; ++i)
+    for (int i = 0; i < n; ++i)
     {
         Pin* const pin = *iter++;
 
@@ -1387,6 +1473,12 @@ HRESULT Filter::SetPassMode(VP8PassMode m)
     if (m == tgt)  //no need for any other checks
         return S_OK;
 
+    //The renditions are encoded in one pass only, so their pins go away
+    //in the other modes.
+
+    if ((m != kPassModeOnePass) && IsRenditionConnected(0))
+        return VFW_E_ALREADY_CONNECTED;
+
     OutpinVideo& outpin = m_outpin_video;
 
     hr = outpin.OnSetPassMode(m);
@@ -1864,6 +1956,9 @@ HRESULT Filter::SetDecimate(int decimate)
     if (m_outpin_video.m_pPinConnection || m_outpin_preview.m_pPinConnection)
         return VFW_E_ALREADY_CONNECTED;
 
+    if (IsRenditionConnected(0))
+        return VFW_E_ALREADY_CONNECTED;
+
     if (decimate < 2)
         decimate = 1;
 
@@ -1880,6 +1975,14 @@ HRESULT Filter::SetDecimate(int decimate)
     if (FAILED(hr))
         return hr;
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        hr = m_outpin_renditions[i]->SetAvgTimePerFrame(avg_time_per_frame);
+
+        if (FAILED(hr))
+            return hr;
+    }
+
     m_decimate = decimate;
     m_bDirty = true;
 
@@ -1921,7 +2024,8 @@ HRESULT Filter::SetEncoderKind(VPXEncoderKind encoder_kind)
 
     if (bool(m_inpin.m_pPinConnection) ||
         bool(m_outpin_video.m_pPinConnection) ||
-        bool (m_outpin_preview.m_pPinConnection))
+        bool (m_outpin_preview.m_pPinConnection) ||
+        IsRenditionConnected(0))
     {
         return VFW_E_ALREADY_CONNECTED;
     }
@@ -1932,6 +2036,9 @@ HRESULT Filter::SetEncoderKind(VPXEncoderKind encoder_kind)
     m_outpin_video.SetDefaultMediaTypes();
     m_outpin_preview.SetDefaultMediaTypes();
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i]->SetDefaultMediaTypes();
+
     return S_OK;
 }
 
@@ -1953,6 +2060,475 @@ HRESULT Filter::GetEncoderKind(VPXEncoderKind* pEncoderKind)
 }
 
 
+HRESULT Filter::SetTileColumns(int val)
+{
+    if (val > 6)
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.tile_columns = (val < 0) ? -1 : val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetTileColumns(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.tile_columns;
+    return S_OK;
+}
+
+
+HRESULT Filter::SetFrameParallel(int val)
+{
+    if (val > 1)
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.frame_parallel = (val < 0) ? -1 : val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetFrameParallel(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.frame_parallel;
+    return S_OK;
+}
+
+
+HRESULT Filter::SetRenditionCount(int count)
+{
+    if ((count < 0) || (count > kMaxRenditions))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    if (IsRenditionConnected(count))  //the pins that would go away
+        return VFW_E_ALREADY_CONNECTED;
+
+    m_cfg.rendition_count = count;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetRenditionCount(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.rendition_count;
+    return S_OK;
+}
+
+
+HRESULT Filter::SetRendition(
+    int index,
+    int width,
+    int height,
+    int target_bitrate)
+{
+    if ((index < 0) || (index >= kMaxRenditions))
+        return E_INVALIDARG;
+
+    if ((width < 0) || (height < 0) || (target_bitrate < 0))
+        return E_INVALIDARG;
+
+    if ((width == 0) && (height == 0))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    OutpinRendition* const pin = m_outpin_renditions[index];
+
+    if (bool(pin->m_pPinConnection))
+        return VFW_E_ALREADY_CONNECTED;
+
+    Config::Rendition& r = m_cfg.renditions[index];
+
+    r.width = width;
+    r.height = height;
+    r.target_bitrate = target_bitrate;
+
+    m_bDirty = true;
+
+    if (bool(m_inpin.m_pPinConnection))
+        pin->OnInpinConnect();  //media types have the new size
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetRendition(
+    int index,
+    int* pWidth,
+    int* pHeight,
+    int* pTargetBitrate)
+{
+    if ((index < 0) || (index >= kMaxRenditions))
+        return E_INVALIDARG;
+
+    if ((pWidth == 0) || (pHeight == 0) || (pTargetBitrate == 0))
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    const Config::Rendition& r = m_cfg.renditions[index];
+
+    *pWidth = r.width;
+    *pHeight = r.height;
+    *pTargetBitrate = r.target_bitrate;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::SetSpeedGovernor(int val)
+{
+    if ((val < 0) || (val > 1))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.speed_governor = val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetSpeedGovernor(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = (m_cfg.speed_governor > 0) ? 1 : 0;
+    return S_OK;
+}
+
+
+HRESULT Filter::SetSpeedGovernorCPUUsed(int min_, int max_)
+{
+    if ((min_ < -1) || (min_ > 16) || (max_ < -1) || (max_ > 16))
+        return E_INVALIDARG;
+
+    if ((min_ >= 0) && (max_ >= 0) && (min_ > max_))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.governor_cpu_used_min = min_;
+    m_cfg.governor_cpu_used_max = max_;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetSpeedGovernorCPUUsed(int* pMin, int* pMax)
+{
+    if ((pMin == 0) || (pMax == 0))
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *pMin = m_cfg.governor_cpu_used_min;
+    *pMax = m_cfg.governor_cpu_used_max;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::SetSpeedGovernorDeadline(int val)
+{
+    if (val < -1)
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.governor_deadline = val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetSpeedGovernorDeadline(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.governor_deadline;
+    return S_OK;
+}
+
+
+HRESULT Filter::SetSpeedGovernorScaling(int val)
+{
+    if ((val < 0) || (val > WebmUtil::SpeedGovernor::kMaxScale))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    m_cfg.governor_scaling = val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetSpeedGovernorScaling(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.governor_scaling;
+    return S_OK;
+}
+
+
+HRESULT Filter::GetSpeedGovernorState(
+    int* pCPUUsed,
+    int* pDeadline,
+    int* pScaling)
+{
+    if ((pCPUUsed == 0) || (pDeadline == 0) || (pScaling == 0))
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    WebmUtil::SpeedGovernor::State s;
+
+    const bool bRunning = m_inpin.GetSpeedGovernorState(s);
+
+    *pCPUUsed = s.cpu_used;
+    *pDeadline = static_cast<int>(s.deadline);
+    *pScaling = s.scale;
+
+    return bRunning ? S_OK : S_FALSE;
+}
+
+
+HRESULT Filter::SetPreviewMaxSize(int width, int height)
+{
+    if ((width < 0) || (height < 0))
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (m_state != State_Stopped)
+        return VFW_E_NOT_STOPPED;
+
+    if (bool(m_outpin_preview.m_pPinConnection))
+        return VFW_E_ALREADY_CONNECTED;
+
+    m_cfg.preview_max_width = width;
+    m_cfg.preview_max_height = height;
+    m_bDirty = true;
+
+    if (bool(m_inpin.m_pPinConnection))
+        m_outpin_preview.OnInpinConnect();  //media types have the new size
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetPreviewMaxSize(int* pWidth, int* pHeight)
+{
+    if ((pWidth == 0) || (pHeight == 0))
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *pWidth = m_cfg.preview_max_width;
+    *pHeight = m_cfg.preview_max_height;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::SetPreviewMaxFrameRate(int val)
+{
+    if (val < 0)
+        return E_INVALIDARG;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    //Unlike the size, this can change while we run.
+
+    m_cfg.preview_max_frame_rate = val;
+    m_bDirty = true;
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetPreviewMaxFrameRate(int* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    *p = m_cfg.preview_max_frame_rate;
+    return S_OK;
+}
+
+
 HRESULT Filter::IsDirty()
 {
     Lock lock;
@@ -1983,7 +2559,8 @@ HRESULT Filter::Load(IStream* pStream)
 
     if (bool(m_inpin.m_pPinConnection) ||
         bool(m_outpin_video.m_pPinConnection) ||
-        bool(m_outpin_preview.m_pPinConnection))
+        bool(m_outpin_preview.m_pPinConnection) ||
+        IsRenditionConnected(0))
     {
         return VFW_E_ALREADY_CONNECTED;
     }
@@ -1999,12 +2576,35 @@ HRESULT Filter::Load(IStream* pStream)
     if (cbRead != 4)
         return E_FAIL;
 
-    if (size != sizeof(Config))
+    //A config saved before the VP9, the simulcast, the speed governor or
+    //the preview settings were added is shorter; those settings keep
+    //their defaults.
+    //Save wrote the whole struct, so its size includes the padding after
+    //its last field.
+
+    size_t len;  //of the fields that were saved
+
+    if (size == sizeof(Config))
+        len = size;
+
+    else if (size == GetSavedConfigSize(offsetof(Config, preview_max_width)))
+        len = offsetof(Config, preview_max_width);
+
+    else if (size == GetSavedConfigSize(offsetof(Config, speed_governor)))
+        len = offsetof(Config, speed_governor);
+
+    else if (size == GetSavedConfigSize(offsetof(Config, rendition_count)))
+        len = offsetof(Config, rendition_count);
+
+    else if (size == GetSavedConfigSize(offsetof(Config, tile_columns)))
+        len = offsetof(Config, tile_columns);
+
+    else
         return E_FAIL;
 
-    Config cfg;
+    BYTE buf[sizeof(Config)];
 
-    hr = pStream->Read(&cfg, size, &cbRead);
+    hr = pStream->Read(buf, size, &cbRead);
 
     if (FAILED(hr))
         return hr;
@@ -2012,6 +2612,11 @@ HRESULT Filter::Load(IStream* pStream)
     if (cbRead != size)
         return E_FAIL;
 
+    Config cfg;
+    cfg.Init();
+
+    memcpy(&cfg, buf, len);
+
     m_cfg = cfg;
 
     m_cfg.pass_mode = -1;
@@ -2021,6 +2626,9 @@ HRESULT Filter::Load(IStream* pStream)
     m_outpin_video.SetDefaultMediaTypes();
     m_outpin_preview.SetDefaultMediaTypes();
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i]->SetDefaultMediaTypes();
+
     return S_OK;
 }
 
@@ -2105,18 +2713,44 @@ HRESULT Filter::OnStart()
         return hr;
     }
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        hr = m_outpin_renditions[i]->Start();
+
+        if (FAILED(hr))
+        {
+            OnStop();
+            return hr;
+        }
+    }
+
     return S_OK;
 }
 
 
 void Filter::OnStop()
 {
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i]->Stop();
+
     m_outpin_preview.Stop();
     m_outpin_video.Stop();
     m_inpin.Stop();
 }
 
 
+bool Filter::IsRenditionConnected(int first) const
+{
+    for (int i = first; i < kMaxRenditions; ++i)
+    {
+        if (bool(m_outpin_renditions[i]->m_pPinConnection))
+            return true;
+    }
+
+    return false;
+}
+
+
 VP8PassMode Filter::GetPassMode() const
 {
     const Config::int32_t m = m_cfg.pass_mode;
@@ -2128,6 +2762,32 @@ VP8PassMode Filter::GetPassMode() const
 }
 
 
+int Filter::GetActiveRenditionCount() const
+{
+    if (GetPassMode() != kPassModeOnePass)
+        return 0;
+
+    return m_cfg.rendition_count;
+}
+
+
+bool Filter::GetStreamTime(REFERENCE_TIME& t) const
+{
+    if ((m_state != State_Running) || (m_clock == 0))
+        return false;
+
+    REFERENCE_TIME now;
+
+    const HRESULT hr = m_clock->GetTime(&now);
+
+    if (FAILED(hr))
+        return false;
+
+    t = now - m_start;
+    return true;
+}
+
+
 HRESULT Filter::GetPages(CAUUID* p)
 {
     if (p == 0)
@@ -2154,4 +2814,55 @@ HRESULT Filter::GetPages(CAUUID* p)
 }
 
 
+ULONG Filter::GetStreamCount()
+{
+    return 3 + kMaxRenditions;  //one per pin
+}
+
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    const Pin* const pins[] =
+    {
+        &m_inpin,
+        &m_outpin_video,
+        &m_outpin_preview,
+        m_outpin_renditions[0],
+        m_outpin_renditions[1],
+        m_outpin_renditions[2]
+    };
+
+    if (index >= GetStreamCount())
+        return E_INVALIDARG;
+
+    pins[index]->m_pipeline_stats.GetSnapshot(*p);
+    return S_OK;
+}
+
+
+HRESULT Filter::ResetStats()
+{
+    m_inpin.m_pipeline_stats.Reset();
+    m_outpin_video.m_pipeline_stats.Reset();
+    m_outpin_preview.m_pipeline_stats.Reset();
+
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_outpin_renditions[i]->m_pipeline_stats.Reset();
+
+    return S_OK;
+}
+
+
+HRESULT Filter::GetEvent(Event* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    return m_events.Get(*p) ? S_OK : S_FALSE;
+}
+
+
 }  //end namespace VP8EncoderLib
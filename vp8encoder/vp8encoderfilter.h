@@ -13,15 +13,23 @@
 #include "vp8encoderinpin.h"
 #include "vp8encoderoutpinvideo.h"
 #include "vp8encoderoutpinpreview.h"
+#include "vp8encoderoutpinrendition.h"
 #include "vp8encoderidl.h"
+#include "ipipelinestats.h"
+#include "ipipelineevents.h"
 
 namespace VP8EncoderLib
 {
 
 class Filter : public IBaseFilter,
-               public IVPXEncoder,
+               public IVP9Encoder,
+               public IVPXSimulcast,
+               public IVPXSpeedGovernor,
+               public IVPXPreview,
                public IPersistStream,
                public ISpecifyPropertyPages,
+               public IPipelineStats,
+               public IPipelineEvents,
                public CLockable
 {
     friend HRESULT CreateFilter(
@@ -175,6 +183,46 @@ public:
     HRESULT STDMETHODCALLTYPE SetEncoderKind(VPXEncoderKind);
     HRESULT STDMETHODCALLTYPE GetEncoderKind(VPXEncoderKind*);
 
+    //IVP9Encoder
+
+    HRESULT STDMETHODCALLTYPE SetTileColumns(int);
+    HRESULT STDMETHODCALLTYPE GetTileColumns(int*);
+
+    HRESULT STDMETHODCALLTYPE SetFrameParallel(int);
+    HRESULT STDMETHODCALLTYPE GetFrameParallel(int*);
+
+    //IVPXSimulcast
+
+    HRESULT STDMETHODCALLTYPE SetRenditionCount(int);
+    HRESULT STDMETHODCALLTYPE GetRenditionCount(int*);
+
+    HRESULT STDMETHODCALLTYPE SetRendition(int, int, int, int);
+    HRESULT STDMETHODCALLTYPE GetRendition(int, int*, int*, int*);
+
+    //IVPXSpeedGovernor
+
+    HRESULT STDMETHODCALLTYPE SetSpeedGovernor(int);
+    HRESULT STDMETHODCALLTYPE GetSpeedGovernor(int*);
+
+    HRESULT STDMETHODCALLTYPE SetSpeedGovernorCPUUsed(int, int);
+    HRESULT STDMETHODCALLTYPE GetSpeedGovernorCPUUsed(int*, int*);
+
+    HRESULT STDMETHODCALLTYPE SetSpeedGovernorDeadline(int);
+    HRESULT STDMETHODCALLTYPE GetSpeedGovernorDeadline(int*);
+
+    HRESULT STDMETHODCALLTYPE SetSpeedGovernorScaling(int);
+    HRESULT STDMETHODCALLTYPE GetSpeedGovernorScaling(int*);
+
+    HRESULT STDMETHODCALLTYPE GetSpeedGovernorState(int*, int*, int*);
+
+    //IVPXPreview
+
+    HRESULT STDMETHODCALLTYPE SetPreviewMaxSize(int, int);
+    HRESULT STDMETHODCALLTYPE GetPreviewMaxSize(int*, int*);
+
+    HRESULT STDMETHODCALLTYPE SetPreviewMaxFrameRate(int);
+    HRESULT STDMETHODCALLTYPE GetPreviewMaxFrameRate(int*);
+
     //IPersistStream
 
     HRESULT STDMETHODCALLTYPE IsDirty();
@@ -186,6 +234,16 @@ public:
 
     HRESULT STDMETHODCALLTYPE GetPages(CAUUID*);
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
+    //IPipelineEvents
+
+    HRESULT STDMETHODCALLTYPE GetEvent(Event*);
+
 private:
     class CNondelegating : public IUnknown
     {
@@ -218,6 +276,7 @@ public:
     Inpin m_inpin;
     OutpinVideo m_outpin_video;
     OutpinPreview m_outpin_preview;
+    OutpinRendition* m_outpin_renditions[kMaxRenditions];
     bool m_bDirty;
 
     struct Config
@@ -258,6 +317,28 @@ public:
         int32_t arnr_type;
         int32_t cpu_used;
         int32_t static_threshold;
+        int32_t tile_columns;    //VP9 only; these two are last, so that
+        int32_t frame_parallel;  //a config saved without them still loads
+
+        struct Rendition
+        {
+            int32_t width;   //0 to follow from the height
+            int32_t height;  //0 to follow from the width
+            int32_t target_bitrate;  //0 to follow from the size
+        };
+
+        int32_t rendition_count;  //IVPXSimulcast; last, for the same
+        Rendition renditions[kMaxRenditions];  //reason as above
+
+        int32_t speed_governor;  //IVPXSpeedGovernor; last, likewise
+        int32_t governor_cpu_used_min;
+        int32_t governor_cpu_used_max;
+        int32_t governor_deadline;
+        int32_t governor_scaling;
+
+        int32_t preview_max_width;  //IVPXPreview; last, likewise
+        int32_t preview_max_height;
+        int32_t preview_max_frame_rate;
 
         void Init();
     };
@@ -266,11 +347,17 @@ public:
     bool m_bForceKeyframe;
     REFERENCE_TIME m_keyframe_interval;
     int m_decimate;
+    WebmUtil::PipelineEvents m_events;
     VP8PassMode GetPassMode() const;
+    int GetActiveRenditionCount() const;
+
+    //The current stream time, if the filter is running with a clock.
+    bool GetStreamTime(REFERENCE_TIME&) const;
 
 private:
     HRESULT OnStart();
     void OnStop();
+    bool IsRenditionConnected(int first) const;
 
 };
 
@@ -11,6 +11,7 @@
 #include "vp8encoderoutpin.h"
 #include "mediatypeutil.h"
 #include "webmtypes.h"
+#include "vp9tiling.h"
 #include "vpx/vp8cx.h"
 #include <vfwmsgs.h>
 #include <uuids.h>
@@ -28,6 +29,53 @@ using std::dec;
 namespace VP8EncoderLib
 {
 
+namespace
+{
+
+//Encodes a frame (or with no image, flushes the encoders) on each of the
+//renditions, one per worker.
+
+class RenditionJob : public WebmUtil::SimulcastWorkers::Job
+{
+    RenditionJob(const RenditionJob&);
+    RenditionJob& operator=(const RenditionJob&);
+
+public:
+    RenditionJob(
+        OutpinRendition* const* renditions,
+        const vpx_image_t* img,
+        vpx_codec_pts_t pts,
+        unsigned long duration,
+        vpx_enc_frame_flags_t flags,
+        unsigned long deadline) :
+        m_renditions(renditions),
+        m_img(img),
+        m_pts(pts),
+        m_duration(duration),
+        m_flags(flags),
+        m_deadline(deadline)
+    {
+    }
+
+    void Run(int index)
+    {
+        OutpinRendition* const pin = m_renditions[index];
+        pin->Encode(m_img, m_pts, m_duration, m_flags, m_deadline);
+    }
+
+private:
+    OutpinRendition* const* const m_renditions;
+    const vpx_image_t* const m_img;
+    const vpx_codec_pts_t m_pts;
+    const unsigned long m_duration;
+    const vpx_enc_frame_flags_t m_flags;
+    const unsigned long m_deadline;
+
+};
+
+}  //end anonymous namespace
+
+
 Inpin::Inpin(Filter* p) :
     Pin(p, PINDIR_INPUT, L"input"),
     m_bEndOfStream(false),
@@ -37,8 +85,11 @@ Inpin::Inpin(Filter* p) :
     m_buflen(0),
     m_last_keyframe_time(0),
     m_frames_received(0),
-    m_decimate_start_time(0)
+    m_decimate_start_time(0),
+    m_bGovernor(false)
 {
+    m_cx_frame.buf = 0;
+
     AM_MEDIA_TYPE mt;
 
     mt.majortype = MEDIATYPE_Video;
@@ -67,6 +118,7 @@ Inpin::Inpin(Filter* p) :
 Inpin::~Inpin()
 {
     PurgePending();
+    ReleaseOutputBuffer();
 
     delete[] m_buf;
 }
@@ -131,7 +183,8 @@ HRESULT Inpin::QueryInternalConnections(
     if (FAILED(hr))
         return hr;
 
-    const ULONG m = 2;  //number of output pins
+    const int nr = m_pFilter->GetActiveRenditionCount();
+    const ULONG m = 2 + nr;  //number of output pins
 
     ULONG& n = *pn;
 
@@ -164,6 +217,12 @@ HRESULT Inpin::QueryInternalConnections(
     pa[1] = &m_pFilter->m_outpin_preview;
     pa[1]->AddRef();
 
+    for (int i = 0; i < nr; ++i)
+    {
+        pa[2 + i] = m_pFilter->m_outpin_renditions[i];
+        pa[2 + i]->AddRef();
+    }
+
     n = m;
     return S_OK;
 }
@@ -211,6 +270,9 @@ HRESULT Inpin::ReceiveConnection(
     m_pFilter->m_outpin_video.OnInpinConnect();
     m_pFilter->m_outpin_preview.OnInpinConnect();
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+        m_pFilter->m_outpin_renditions[i]->OnInpinConnect();
+
     return S_OK;
 }
 
@@ -238,17 +300,31 @@ HRESULT Inpin::EndOfStream()
 
     m_bEndOfStream = true;
 
+    const VP8PassMode m = m_pFilter->GetPassMode();
+
+    if (bMain && (m != kPassModeFirstPass))
+        SetOutputBuffer();
+
+    const int n = static_cast<int>(m_renditions.size());
+
+    RenditionJob job(n ? &m_renditions[0] : 0, 0, 0, 0, 0, 0);
+
+    if (n > 0)
+        m_workers.Begin(&job, n);
+
     const vpx_codec_err_t err = vpx_codec_encode(&m_ctx, 0, 0, 0, 0, 0);
     err;
-    assert(err == VPX_CODEC_OK);  //TODO
 
-    const VP8PassMode m = m_pFilter->GetPassMode();
+    if (n > 0)
+        m_workers.Wait();
+
+    assert(err == VPX_CODEC_OK);  //TODO
 
     OutpinVideo& outpin = m_pFilter->m_outpin_video;
 
     vpx_codec_iter_t iter = 0;
 
-    for (;;)
+    while (bMain)
     {
         const vpx_codec_cx_pkt_t* const pkt =
             vpx_codec_get_cx_data(&m_ctx, &iter);
@@ -276,6 +352,11 @@ HRESULT Inpin::EndOfStream()
 
     if (m != kPassModeFirstPass)
     {
+        hr = DeliverRenditions(lock);
+
+        if (FAILED(hr))
+            return hr;
+
         while (!m_pending.empty())
         {
             if (!bool(outpin.m_pAllocator))
@@ -329,6 +410,21 @@ HRESULT Inpin::EndOfStream()
         assert(SUCCEEDED(hr));  //TODO
     }
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        //We hold the lock.
+
+        if (IPin* pPin = m_pFilter->m_outpin_renditions[i]->m_pPinConnection)
+        {
+            lock.Release();
+
+            hr = pPin->EndOfStream();
+
+            hr = lock.Seize(m_pFilter);
+            assert(SUCCEEDED(hr));  //TODO
+        }
+    }
+
     //We hold the lock.
 
     if (IPin* pPin = outpin.m_pPinConnection)
@@ -371,6 +467,21 @@ HRESULT Inpin::BeginFlush()
         assert(SUCCEEDED(hr));  //TODO
     }
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        //We hold the lock
+
+        if (IPin* pPin = m_pFilter->m_outpin_renditions[i]->m_pPinConnection)
+        {
+            lock.Release();
+
+            hr = pPin->BeginFlush();
+
+            hr = lock.Seize(m_pFilter);
+            assert(SUCCEEDED(hr));  //TODO
+        }
+    }
+
     //We hold the lock
 
     if (IPin* pPin = m_pFilter->m_outpin_video.m_pPinConnection)
@@ -409,6 +520,21 @@ HRESULT Inpin::EndFlush()
         assert(SUCCEEDED(hr));  //TODO
     }
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        //We hold the lock
+
+        if (IPin* pPin = m_pFilter->m_outpin_renditions[i]->m_pPinConnection)
+        {
+            lock.Release();
+
+            hr = pPin->EndFlush();
+
+            hr = lock.Seize(m_pFilter);
+            assert(SUCCEEDED(hr));  //TODO
+        }
+    }
+
     //We hold the lock
 
     if (IPin* pPin = m_pFilter->m_outpin_video.m_pPinConnection)
@@ -448,6 +574,21 @@ HRESULT Inpin::NewSegment(
         assert(SUCCEEDED(hr));  //TODO
     }
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        //We hold the lock
+
+        if (IPin* pPin = m_pFilter->m_outpin_renditions[i]->m_pPinConnection)
+        {
+            lock.Release();
+
+            hr = pPin->NewSegment(st, sp, r);
+
+            hr = lock.Seize(m_pFilter);
+            assert(SUCCEEDED(hr));  //TODO
+        }
+    }
+
     //We hold the lock
 
     if (IPin* pPin = m_pFilter->m_outpin_video.m_pPinConnection)
@@ -632,9 +773,10 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     assert((h % 2) == 0);  //TODO
 
     const long len = pInSample->GetActualDataLength();
-    len;
     assert(len >= 0);
 
+    m_pipeline_stats.OnInput(len);
+
     vpx_img_fmt_t fmt;
 
     const AM_MEDIA_TYPE& mt = m_connection_mtv[0];
@@ -656,6 +798,8 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
         return E_FAIL;
     }
 
+    const vpx_img_fmt_t sample_fmt = fmt;  //before any conversion
+
     BYTE* inbuf;
 
     hr = pInSample->GetPointer(&inbuf);
@@ -715,11 +859,17 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     status;
     assert(status == 0);
 
-    m_pFilter->m_outpin_preview.Render(lock, img);
+    m_pFilter->m_outpin_preview.Render(pInSample, sample_fmt, w, h, st);
 
     OutpinVideo& outpin = m_pFilter->m_outpin_video;
 
-    if (!bool(outpin.m_pPinConnection))
+    //There's work to do if the main output is connected, or any of the
+    //renditions (which OnStart only keeps if their pins are connected).
+    //The main encoder is skipped when only the renditions are connected.
+
+    const bool bMain = bool(outpin.m_pPinConnection);
+
+    if (!bMain && m_renditions.empty())
         return S_OK;
 
     if (st < 0)  //?
@@ -825,7 +975,20 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
 
     vpx_enc_frame_flags_t f = 0;
 
-    if (m_pFilter->m_bForceKeyframe || bDiscontinuity || bFirst)
+    if (!m_renditions.empty())
+    {
+        //Every encoder gets a keyframe at the same frame, so that a player
+        //can switch renditions there.
+
+        const bool bForce =
+            m_pFilter->m_bForceKeyframe || bDiscontinuity || bFirst;
+
+        m_pFilter->m_bForceKeyframe = false;
+
+        if (m_keyframes.IsKeyframe(st, bForce))
+            f |= VPX_EFLAG_FORCE_KF;
+    }
+    else if (m_pFilter->m_bForceKeyframe || bDiscontinuity || bFirst)
     {
         f |= VPX_EFLAG_FORCE_KF;
         m_pFilter->m_bForceKeyframe = false;
@@ -838,18 +1001,55 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
             f |= VPX_EFLAG_FORCE_KF;
     }
 
-    const Filter::Config::int32_t deadline_ = m_pFilter->m_cfg.deadline;
-    const ULONG dl = (deadline_ >= 0) ? deadline_ : kDeadlineGoodQuality;
+    ULONG dl;
+
+    if (m_bGovernor)
+        dl = m_governor.GetState().deadline;
+    else
+    {
+        const Filter::Config::int32_t deadline_ = m_pFilter->m_cfg.deadline;
+        dl = (deadline_ >= 0) ? deadline_ : kDeadlineGoodQuality;
+    }
 
     const __int64 st2 = m_start_reftime / 10000;  // scale to ms
     const unsigned long d2 = (d + 9999) / 10000;  // scale to ms
 
-    const vpx_codec_err_t err = vpx_codec_encode(&m_ctx, img, st2, d2, f, dl);
-    err;
-    assert(err == VPX_CODEC_OK);  //TODO
-
     const VP8PassMode m = m_pFilter->GetPassMode();
 
+    if (m != kPassModeFirstPass)
+        SetOutputBuffer();
+
+    //The renditions are scaled from this same image, and encoded on the
+    //workers while this thread encodes the main output.
+
+    const int n = static_cast<int>(m_renditions.size());
+
+    RenditionJob job(n ? &m_renditions[0] : 0, img, st2, d2, f, dl);
+
+    const __int64 t0 = WebmUtil::PipelineStats::GetMicroseconds();
+
+    if (n > 0)
+        m_workers.Begin(&job, n);
+
+    vpx_codec_err_t err = VPX_CODEC_OK;
+
+    if (bMain)
+    {
+        const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+        err = vpx_codec_encode(&m_ctx, img, st2, d2, f, dl);
+    }
+
+    if (n > 0)
+        m_workers.Wait();
+
+    if (m_bGovernor)
+    {
+        const __int64 t = WebmUtil::PipelineStats::GetMicroseconds() - t0;
+        UpdateGovernor(t, st, d);
+    }
+
+    assert(err == VPX_CODEC_OK);  //TODO
+
     vpx_codec_iter_t iter = 0;
 
     for (;;)
@@ -881,6 +1081,14 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     if (m == kPassModeFirstPass)
         return S_OK;  //nothing else to do
 
+    hr = DeliverRenditions(lock);
+
+    if (FAILED(hr))
+        return hr;
+
+    WebmUtil::PipelineStats& stats = outpin.m_pipeline_stats;
+    stats.OnQueueDepth(static_cast<long>(m_pending.size()));
+
     while (!m_pending.empty())
     {
         if (!bool(outpin.m_pAllocator))
@@ -890,7 +1098,10 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
 
         GraphUtil::IMediaSamplePtr pOutSample;
 
-        hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        {
+            const WebmUtil::PipelineStats::WaitTimer timer(stats);
+            hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        }
 
         if (FAILED(hr))
             return hr;
@@ -951,6 +1162,8 @@ void Inpin::PopulateSample(IMediaSample* p)
 
     m_pending.pop_front();
 
+    m_pFilter->m_outpin_video.m_pipeline_stats.OnOutput(f.len);
+
     HRESULT hr = p->SetPreroll(FALSE);
     assert(SUCCEEDED(hr));
 
@@ -961,6 +1174,59 @@ void Inpin::PopulateSample(IMediaSample* p)
 }
 
 
+void Inpin::SetOutputBuffer()
+{
+    //Hand libvpx a pooled sample frame to put the next compressed frame
+    //in, so that AppendFrame can send that frame downstream as is.  The
+    //frame is kept until a packet lands in it, so an encode that doesn't
+    //produce any output (the encoder is lagging) doesn't cost a frame.
+    //
+    //This is done before each encode, and again after each packet that
+    //lands in the frame (see AppendFrame).  vpx_codec_get_cx_data copies
+    //each packet into the buffer that is set at the time it returns the
+    //packet, and then advances the buffer past it; without a fresh frame,
+    //a second packet from the same encode would be written into the tail
+    //of the frame that was already taken.
+
+    if ((m_cx_frame.buf == 0) && bool(m_pFilter->m_outpin_video.m_pAllocator))
+    {
+        const HRESULT hr = m_pFilter->m_outpin_video.GetFrame(m_cx_frame);
+
+        if (FAILED(hr))
+            m_cx_frame.buf = 0;  //packets will be copied, as before
+    }
+
+    vpx_codec_err_t err;
+
+    if (m_cx_frame.buf == 0)
+        err = vpx_codec_set_cx_data_buf(&m_ctx, 0, 0, 0);
+    else
+    {
+        IVP8Sample::Frame& f = m_cx_frame;
+
+        vpx_fixed_buf_t b;
+
+        b.buf = f.buf + f.off;
+        b.sz = f.buflen - f.off;
+
+        err = vpx_codec_set_cx_data_buf(&m_ctx, &b, 0, 0);
+    }
+
+    err;
+    assert(err == VPX_CODEC_OK);
+}
+
+
+void Inpin::ReleaseOutputBuffer()
+{
+    //Only called once the codec has been destroyed, so that libvpx isn't
+    //still holding on to the buffer.
+
+    delete[] m_cx_frame.buf;
+    m_cx_frame.buf = 0;
+}
+
+
 void Inpin::AppendFrame(const vpx_codec_cx_pkt_t* pkt)
 {
     assert(pkt);
@@ -968,22 +1234,46 @@ void Inpin::AppendFrame(const vpx_codec_cx_pkt_t* pkt)
 
     IVP8Sample::Frame f;
 
-    const HRESULT hr = m_pFilter->m_outpin_video.GetFrame(f);
-    hr;
-    assert(SUCCEEDED(hr));
-    assert(f.buf);
-
     const size_t len_ = pkt->data.frame.sz;
     const long len = static_cast<long>(len_);
 
-    const long size = f.buflen - f.off;
-    size;
-    assert(size >= len);
+    if ((m_cx_frame.buf != 0) &&
+        (pkt->data.frame.buf == m_cx_frame.buf + m_cx_frame.off))
+    {
+        //libvpx wrote the packet into the frame that SetOutputBuffer gave
+        //it, so the frame goes downstream without another copy.
+
+        f = m_cx_frame;
+        m_cx_frame.buf = 0;
+
+        assert((f.buflen - f.off) >= len);
+
+        //The same encode can return another packet (an altref, followed
+        //by the frame that is shown), so arm a fresh frame for it.  If no
+        //packet lands in it, it is kept for the next encode.
+
+        SetOutputBuffer();
+    }
+    else
+    {
+        //No pooled frame was available, or the packet was larger than
+        //the frame, so libvpx left it in its own buffer; it gets copied
+        //into a frame of its own.
+
+        const HRESULT hr = m_pFilter->m_outpin_video.GetFrame(f);
+        hr;
+        assert(SUCCEEDED(hr));
+        assert(f.buf);
+
+        const long size = f.buflen - f.off;
+        size;
+        assert(size >= len);
 
-    BYTE* tgt = f.buf + f.off;
-    //assert(intptr_t(tgt - props.cbPrefix) % props.cbAlign == 0);
+        BYTE* tgt = f.buf + f.off;
+        //assert(intptr_t(tgt - props.cbPrefix) % props.cbAlign == 0);
 
-    memcpy(tgt, pkt->data.frame.buf, len);
+        memcpy(tgt, pkt->data.frame.buf, len);
+    }
 
     f.len = len;
 
@@ -1078,6 +1368,12 @@ HRESULT Inpin::OnDisconnect()
     HRESULT hr = m_pFilter->m_outpin_preview.OnInpinDisconnect();
     assert(SUCCEEDED(hr));
 
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        hr = m_pFilter->m_outpin_renditions[i]->OnInpinDisconnect();
+        assert(SUCCEEDED(hr));
+    }
+
     hr = m_pFilter->m_outpin_video.OnInpinDisconnect();
     assert(SUCCEEDED(hr));
 
@@ -1154,91 +1450,399 @@ HRESULT Inpin::Start()
     // The default downstream filter has a resolution of milliseconds so set
     // the encoder timebase to milliseconds.
 
+    //The renditions are chosen before the main encoder is configured,
+    //since while there are any, the filter places the keyframes (see
+    //SetConfig).
+
+    m_renditions.clear();
+
+    for (int i = 0; i < kMaxRenditions; ++i)
+    {
+        OutpinRendition* const pin = m_pFilter->m_outpin_renditions[i];
+
+        if (pin->IsActive() && bool(pin->m_pPinConnection))
+            m_renditions.push_back(pin);
+    }
+
     SetConfig();
 
-    err = vpx_codec_enc_init(&m_ctx, codec, &tgt, 0);
+    HRESULT hr = InitEncoder(m_ctx, m_cfg);
+
+    if (FAILED(hr))
+    {
+        m_renditions.clear();
+        return hr;
+    }
+
+    hr = StartRenditions();
+
+    if (FAILED(hr))
+    {
+        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        err;
+        assert(err == VPX_CODEC_OK);
+
+        return hr;
+    }
+
+    StartGovernor();
+
+    return S_OK;
+}
+
+
+HRESULT Inpin::StartRenditions()
+{
+    if (m_renditions.empty())
+        return S_OK;
+
+    //Automatic keyframe placement is off on all of the encoders, so the
+    //keyframes are forced where the main encoder's settings say they
+    //should be: at least every kf_max_dist frames or, with automatic
+    //placement disabled, at the fixed keyframe interval.
+
+    const Filter::Config& src = m_pFilter->m_cfg;
+
+    if (src.keyframe_mode == kKeyframeModeDisabled)
+        m_keyframes.Reset(0, m_pFilter->m_keyframe_interval);
+    else
+        m_keyframes.Reset(m_cfg.kf_max_dist, 0);
+
+    typedef renditions_t::iterator iter_t;
+
+    for (iter_t i = m_renditions.begin(); i != m_renditions.end(); ++i)
+    {
+        OutpinRendition* const pin = *i;
+
+        const HRESULT hr = pin->StartEncoder(m_cfg);
+
+        if (FAILED(hr))
+        {
+            StopRenditions();
+            return hr;
+        }
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    const int n = static_cast<int>(m_renditions.size());
+
+    m_workers.Start(n, info.dwNumberOfProcessors > 1);
+
+    return S_OK;
+}
+
+
+HRESULT Inpin::DeliverRenditions(CLockable::Lock& lock)
+{
+    //We hold the lock.  Each rendition drops it while it waits on
+    //downstream, so the filter can be stopped meanwhile, which empties
+    //the list.
+
+    for (size_t i = 0; i < m_renditions.size(); ++i)
+    {
+        OutpinRendition* const pin = m_renditions[i];
+
+        const HRESULT hr = pin->Deliver(lock);
+
+        if (FAILED(hr))  //the lock isn't held
+            return hr;
+    }
+
+    return S_OK;
+}
+
+
+void Inpin::StopRenditions()
+{
+    m_workers.Stop();
+
+    typedef renditions_t::iterator iter_t;
+
+    for (iter_t i = m_renditions.begin(); i != m_renditions.end(); ++i)
+    {
+        OutpinRendition* const pin = *i;
+        pin->StopEncoder();
+    }
+
+    m_renditions.clear();
+}
+
+
+void Inpin::StartGovernor()
+{
+    const Filter::Config& src = m_pFilter->m_cfg;
+
+    m_bGovernor = (src.speed_governor > 0) &&
+                  (m_pFilter->GetPassMode() == kPassModeOnePass);
+
+    if (!m_bGovernor)
+        return;
+
+    //The governor's range is within what the codec allows, and by
+    //default starts from the configured cpu_used (see SetCPUUsed).
+
+    const int cpu_used_max = (src.encoder_kind == kVP9Encoder) ? 8 : 16;
+
+    int cpu_used = src.cpu_used;
+
+    if ((cpu_used < 0) || (cpu_used > cpu_used_max))
+        cpu_used = 0;
+
+    WebmUtil::SpeedGovernor::Settings s;
+
+    s.cpu_used_min = src.governor_cpu_used_min;
+
+    if (s.cpu_used_min < 0)
+        s.cpu_used_min = cpu_used;
+
+    s.cpu_used_max = src.governor_cpu_used_max;
+
+    if ((s.cpu_used_max < 0) || (s.cpu_used_max > cpu_used_max))
+        s.cpu_used_max = cpu_used_max;
+
+    if (s.cpu_used_min > s.cpu_used_max)
+        s.cpu_used_min = s.cpu_used_max;
+
+    s.deadline = (src.deadline >= 0) ? src.deadline : kDeadlineGoodQuality;
+
+    if (src.governor_deadline < 0)
+        s.fast_deadline = kDeadlineRealtime;
+    else if (src.governor_deadline == 0)
+        s.fast_deadline = -1;  //the deadline isn't changed
+    else
+        s.fast_deadline = src.governor_deadline;
+
+    s.max_scale = src.governor_scaling;
+
+    m_governor.Reset(s, cpu_used);
+
+    //The encoders were configured with the filter's own cpu_used (if it
+    //was set), which might be outside of the governor's range.
+
+    WebmUtil::SpeedGovernor::State before = m_governor.GetState();
+    before.cpu_used = src.cpu_used;
+
+    ApplyGovernorState(before);
+}
+
+
+void Inpin::UpdateGovernor(__int64 encode_us, REFERENCE_TIME st, ULONG d)
+{
+    //How late the frame is: how long after its time it was encoded.  A
+    //live source stamps its frames with the stream time at which they
+    //were captured, so this grows as frames queue up in front of us.
+
+    __int64 lateness_us = -1;
+
+    REFERENCE_TIME t;
+
+    if (m_pFilter->GetStreamTime(t) && (t >= st))
+        lateness_us = (t - st) / 10;
+
+    typedef WebmUtil::SpeedGovernor governor_t;
+
+    const governor_t::State before = m_governor.GetState();
+
+    const governor_t::Change c =
+        m_governor.OnFrame(encode_us, d / 10, lateness_us);
+
+    if (c == governor_t::kNone)
+        return;
+
+    ApplyGovernorState(before);
+
+    const std::wstring text = m_governor.Describe(c, before);
+
+    m_pFilter->m_events.Post(L"output", L"speed", text.c_str());
+
+#ifdef _DEBUG
+    wodbgstream os;
+    os << L"vp8enc::inpin::UpdateGovernor: " << text << endl;
+#endif
+}
+
+
+void Inpin::ApplyGovernorState(const WebmUtil::SpeedGovernor::State& before)
+{
+    const WebmUtil::SpeedGovernor::State& s = m_governor.GetState();
+
+    if (s.cpu_used != before.cpu_used)
+    {
+        const vpx_codec_err_t err =
+            vpx_codec_control(&m_ctx, VP8E_SET_CPUUSED, s.cpu_used);
+        err;
+        assert(err == VPX_CODEC_OK);
+
+        typedef renditions_t::iterator iter_t;
+
+        for (iter_t i = m_renditions.begin(); i != m_renditions.end(); ++i)
+        {
+            OutpinRendition* const pin = *i;
+            pin->SetCPUUsed(s.cpu_used);
+        }
+    }
+
+    if (s.scale != before.scale)
+    {
+        //libvpx scales the frames down internally, and the decoder scales
+        //them back up, so the frame size in the media type still holds.
+
+        const VPX_SCALING_MODE modes[] =
+        {
+            VP8E_NORMAL,
+            VP8E_FOURFIVE,
+            VP8E_THREEFIVE,
+            VP8E_ONETWO
+        };
+
+        assert(s.scale >= 0);
+        assert(s.scale <= WebmUtil::SpeedGovernor::kMaxScale);
+
+        vpx_scaling_mode_t mode;
+
+        mode.h_scaling_mode = modes[s.scale];
+        mode.v_scaling_mode = modes[s.scale];
+
+        const vpx_codec_err_t err =
+            vpx_codec_control(&m_ctx, VP8E_SET_SCALEMODE, &mode);
+        err;
+        assert(err == VPX_CODEC_OK);
+    }
+}
+
+
+bool Inpin::GetSpeedGovernorState(WebmUtil::SpeedGovernor::State& s) const
+{
+    s = m_governor.GetState();
+    return m_bGovernor;
+}
+
+
+HRESULT Inpin::InitEncoder(
+    vpx_codec_ctx_t& ctx,
+    const vpx_codec_enc_cfg_t& cfg) const
+{
+    vpx_codec_iface_t* codec;
+
+    switch (m_pFilter->m_cfg.encoder_kind)
+    {
+        case kVP8Encoder:
+        default:
+          codec = &vpx_codec_vp8_cx_algo;
+          break;
+
+        case kVP9Encoder:
+          codec = &vpx_codec_vp9_cx_algo;
+          break;
+    }
+
+    vpx_codec_err_t err = vpx_codec_enc_init(&ctx, codec, &cfg, 0);
 
     if (err != VPX_CODEC_OK)
     {
 #ifdef _DEBUG
-        const char* str = vpx_codec_error_detail(&m_ctx);
+        const char* str = vpx_codec_error_detail(&ctx);
         str;
 #endif
 
         return E_FAIL;
     }
 
-    err = SetTokenPartitions();
+    err = SetTokenPartitions(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetAutoAltRef();
+    err = SetAutoAltRef(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetARNRMaxFrames();
+    err = SetARNRMaxFrames(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetARNRStrength();
+    err = SetARNRStrength(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetARNRType();
+    err = SetARNRType(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetCPUUsed();
+    err = SetCPUUsed(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
         return E_FAIL;
     }
 
-    err = SetStaticThreshold();
+    err = SetStaticThreshold(&ctx);
 
     if (err != VPX_CODEC_OK)
     {
-        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
+        err;
+        assert(err == VPX_CODEC_OK);
+
+        return E_FAIL;
+    }
+
+    err = SetTileColumns(&ctx, cfg);
+
+    if (err != VPX_CODEC_OK)
+    {
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
+        err;
+        assert(err == VPX_CODEC_OK);
+
+        return E_FAIL;
+    }
+
+    err = SetFrameParallel(&ctx);
+
+    if (err != VPX_CODEC_OK)
+    {
+        const vpx_codec_err_t err = vpx_codec_destroy(&ctx);
         err;
         assert(err == VPX_CODEC_OK);
 
@@ -1248,13 +1852,20 @@ HRESULT Inpin::Start()
     return S_OK;
 }
 
+
 void Inpin::Stop()
 {
+    m_bGovernor = false;
+
+    StopRenditions();
+
     const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
     err;
     assert(err == VPX_CODEC_OK);
 
     memset(&m_ctx, 0, sizeof m_ctx);
+
+    ReleaseOutputBuffer();
 }
 
 
@@ -1309,6 +1920,20 @@ void Inpin::SetConfig()
 
     if (src.threads >= 0)
         tgt.g_threads = src.threads;
+    else if (src.encoder_kind == kVP9Encoder)
+    {
+        //libvpx defaults to a single thread.  For VP9, use one thread
+        //per tile column that the width allows (see SetTileColumns), up
+        //to the number of processors.
+
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        const int n = static_cast<int>(info.dwNumberOfProcessors);
+        const int w = static_cast<int>(tgt.g_w);
+
+        tgt.g_threads = WebmUtil::GetVP9AutoThreadCount(w, n);
+    }
 
     if (src.error_resilient >= 0)
         tgt.g_error_resilient = src.error_resilient;
@@ -1423,10 +2048,16 @@ void Inpin::SetConfig()
 
     if (src.keyframe_max_interval >= 0)
         tgt.kf_max_dist = src.keyframe_max_interval;
+
+    //With simulcast renditions, the filter places the keyframes, so that
+    //they are at the same frames in every rendition (see Receive).
+
+    if (!m_renditions.empty())
+        tgt.kf_mode = VPX_KF_DISABLED;
 }
 
 
-vpx_codec_err_t Inpin::SetTokenPartitions()
+vpx_codec_err_t Inpin::SetTokenPartitions(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1437,10 +2068,10 @@ vpx_codec_err_t Inpin::SetTokenPartitions()
         static_cast<vp8e_token_partitions>(src.token_partitions);
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_TOKEN_PARTITIONS, token_partitions);
+        ctx, VP8E_SET_TOKEN_PARTITIONS, token_partitions);
 }
 
-vpx_codec_err_t Inpin::SetAutoAltRef()
+vpx_codec_err_t Inpin::SetAutoAltRef(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1448,10 +2079,10 @@ vpx_codec_err_t Inpin::SetAutoAltRef()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_ENABLEAUTOALTREF, src.auto_alt_ref);
+        ctx, VP8E_SET_ENABLEAUTOALTREF, src.auto_alt_ref);
 }
 
-vpx_codec_err_t Inpin::SetARNRMaxFrames()
+vpx_codec_err_t Inpin::SetARNRMaxFrames(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1459,10 +2090,10 @@ vpx_codec_err_t Inpin::SetARNRMaxFrames()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_ARNR_MAXFRAMES, src.arnr_max_frames);
+        ctx, VP8E_SET_ARNR_MAXFRAMES, src.arnr_max_frames);
 }
 
-vpx_codec_err_t Inpin::SetARNRStrength()
+vpx_codec_err_t Inpin::SetARNRStrength(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1470,10 +2101,10 @@ vpx_codec_err_t Inpin::SetARNRStrength()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_ARNR_STRENGTH, src.arnr_strength);
+        ctx, VP8E_SET_ARNR_STRENGTH, src.arnr_strength);
 }
 
-vpx_codec_err_t Inpin::SetARNRType()
+vpx_codec_err_t Inpin::SetARNRType(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1481,10 +2112,10 @@ vpx_codec_err_t Inpin::SetARNRType()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_ARNR_TYPE, src.arnr_type);
+        ctx, VP8E_SET_ARNR_TYPE, src.arnr_type);
 }
 
-vpx_codec_err_t Inpin::SetCPUUsed()
+vpx_codec_err_t Inpin::SetCPUUsed(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1492,10 +2123,10 @@ vpx_codec_err_t Inpin::SetCPUUsed()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_CPUUSED, src.cpu_used);
+        ctx, VP8E_SET_CPUUSED, src.cpu_used);
 }
 
-vpx_codec_err_t Inpin::SetStaticThreshold()
+vpx_codec_err_t Inpin::SetStaticThreshold(vpx_codec_ctx_t* ctx) const
 {
     const Filter::Config& src = m_pFilter->m_cfg;
 
@@ -1503,7 +2134,45 @@ vpx_codec_err_t Inpin::SetStaticThreshold()
         return VPX_CODEC_OK;
 
     return vpx_codec_control(
-        &m_ctx, VP8E_SET_STATIC_THRESHOLD, src.static_threshold);
+        ctx, VP8E_SET_STATIC_THRESHOLD, src.static_threshold);
+}
+
+vpx_codec_err_t Inpin::SetTileColumns(
+    vpx_codec_ctx_t* ctx,
+    const vpx_codec_enc_cfg_t& cfg) const
+{
+    const Filter::Config& src = m_pFilter->m_cfg;
+
+    if (src.encoder_kind != kVP9Encoder)
+        return VPX_CODEC_OK;
+
+    int log2 = src.tile_columns;
+
+    if (log2 < 0)  //auto: a column for each thread
+    {
+        const int w = static_cast<int>(cfg.g_w);
+        const int n = static_cast<int>(cfg.g_threads);
+
+        log2 = WebmUtil::GetVP9AutoLog2TileColumns(w, n);
+    }
+
+    return vpx_codec_control(ctx, VP9E_SET_TILE_COLUMNS, log2);
+}
+
+vpx_codec_err_t Inpin::SetFrameParallel(vpx_codec_ctx_t* ctx) const
+{
+    const Filter::Config& src = m_pFilter->m_cfg;
+
+    if (src.encoder_kind != kVP9Encoder)
+        return VPX_CODEC_OK;
+
+    if (src.frame_parallel < 0)
+        return VPX_CODEC_OK;
+
+    const unsigned int val = src.frame_parallel;
+
+    return vpx_codec_control(
+        ctx, VP9E_SET_FRAME_PARALLEL_DECODING, val);
 }
 
 BYTE* Inpin::ConvertYUY2ToYV12(
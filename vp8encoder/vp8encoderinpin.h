@@ -11,11 +11,16 @@
 #include "graphutil.h"
 #include "vpx/vpx_encoder.h"
 #include "ivp8sample.h"
+#include "simulcast.h"
+#include "speedgovernor.h"
 #include <list>
+#include <vector>
 
 namespace VP8EncoderLib
 {
 
+class OutpinRendition;
+
 class Inpin : public Pin, public IMemInputPin
 {
     Inpin(const Inpin&);
@@ -85,6 +90,13 @@ public:
 
     HRESULT OnApplySettings(std::wstring&);
 
+    //Initializes an encoder with cfg, and applies the filter's settings
+    //to it (the main encoder's, and each rendition's).
+    HRESULT InitEncoder(vpx_codec_ctx_t&, const vpx_codec_enc_cfg_t&) const;
+
+    //Where the speed governor is; returns false if it isn't running.
+    bool GetSpeedGovernorState(WebmUtil::SpeedGovernor::State&) const;
+
 protected:
     //HRESULT GetName(PIN_INFO&) const;
     std::wstring GetName() const;
@@ -105,17 +117,50 @@ private:
     typedef std::list<IVP8Sample::Frame> frames_t;
     frames_t m_pending;  //waiting to be pushed downstream
 
+    //The pooled frame that libvpx has been told to write the next
+    //compressed frame into (see SetOutputBuffer).
+    IVP8Sample::Frame m_cx_frame;
+
+    void SetOutputBuffer();
+    void ReleaseOutputBuffer();
+
     void AppendFrame(const vpx_codec_cx_pkt_t*);
     void PopulateSample(IMediaSample*);
 
     void SetConfig();
-    vpx_codec_err_t SetTokenPartitions();
-    vpx_codec_err_t SetAutoAltRef();
-    vpx_codec_err_t SetARNRMaxFrames();
-    vpx_codec_err_t SetARNRStrength();
-    vpx_codec_err_t SetARNRType();
-    vpx_codec_err_t SetCPUUsed();
-    vpx_codec_err_t SetStaticThreshold();
+    vpx_codec_err_t SetTokenPartitions(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetAutoAltRef(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetARNRMaxFrames(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetARNRStrength(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetARNRType(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetCPUUsed(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetStaticThreshold(vpx_codec_ctx_t*) const;
+    vpx_codec_err_t SetTileColumns(
+        vpx_codec_ctx_t*,
+        const vpx_codec_enc_cfg_t&) const;
+    vpx_codec_err_t SetFrameParallel(vpx_codec_ctx_t*) const;
+
+    //The simulcast renditions being encoded (those connected when the
+    //filter started), the workers that encode them, and the keyframe
+    //placement they share with the main encoder.
+    typedef std::vector<OutpinRendition*> renditions_t;
+    renditions_t m_renditions;
+    WebmUtil::SimulcastWorkers m_workers;
+    WebmUtil::SimulcastKeyframes m_keyframes;
+
+    HRESULT StartRenditions();
+    HRESULT DeliverRenditions(CLockable::Lock&);
+    void StopRenditions();
+
+    //The speed governor (IVPXSpeedGovernor), in one-pass mode, when it's
+    //enabled.  Its cpu_used applies to every encoder, and its deadline
+    //to every frame; its scaling to the main encoder only.
+    WebmUtil::SpeedGovernor m_governor;
+    bool m_bGovernor;
+
+    void StartGovernor();
+    void UpdateGovernor(__int64 encode_us, REFERENCE_TIME st, ULONG d);
+    void ApplyGovernorState(const WebmUtil::SpeedGovernor::State&);
 
     BYTE* m_buf;
     size_t m_buflen;
@@ -69,6 +69,9 @@ public:
     HRESULT SetAvgTimePerFrame(__int64 AvgTimePerFrame);
     virtual void SetDefaultMediaTypes() = 0;
 
+    //The size of the frames on this pin; the input's size by default.
+    virtual void GetFrameSize(LONG& width, LONG& height) const;
+
 protected:
     virtual HRESULT PostConnect(IPin*) = 0;
     HRESULT InitAllocator(IMemInputPin*, IMemAllocator*);
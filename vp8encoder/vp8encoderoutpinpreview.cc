@@ -13,10 +13,12 @@
 #include "vp8encoderoutpinpreview.h"
 #include "cmediasample.h"
 #include "mediatypeutil.h"
+#include "libyuv_util.h"
 #include <vfwmsgs.h>
 #include <amvideo.h>
 #include <dvdmedia.h>
 #include <cassert>
+#include <new>
 #ifdef _DEBUG
 #include "odbgstream.h"
 #include "iidstr.h"
@@ -30,14 +32,114 @@ using std::wstring;
 namespace VP8EncoderLib
 {
 
+namespace
+{
+
+//Holds the input sample until the preview's thread has rendered it.
+
+class PreviewJob : public WebmUtil::PreviewWorker::Job
+{
+    PreviewJob(const PreviewJob&);
+    PreviewJob& operator=(const PreviewJob&);
+
+public:
+    PreviewJob(
+        OutpinPreview* pin,
+        IMediaSample* pSample,
+        vpx_img_fmt_t fmt,
+        LONG w,
+        LONG h) :
+        m_pin(pin),
+        m_pSample(pSample),
+        m_fmt(fmt),
+        m_w(w),
+        m_h(h)
+    {
+    }
+
+    void Run()
+    {
+        m_pin->RenderSample(m_pSample, m_fmt, m_w, m_h);
+    }
+
+private:
+    OutpinPreview* const m_pin;
+    GraphUtil::IMediaSamplePtr m_pSample;
+    const vpx_img_fmt_t m_fmt;
+    const LONG m_w;
+    const LONG m_h;
+
+};
+
+}  //end anonymous namespace
+
+
 OutpinPreview::OutpinPreview(Filter* pFilter) :
-    Outpin(pFilter, L"preview")
+    Outpin(pFilter, L"preview"),
+    m_frame_rate(-1),
+    m_width(0),
+    m_height(0),
+    m_stride(0),
+    m_converted(0),
+    m_scaled(0)
 {
 }
 
 
 OutpinPreview::~OutpinPreview()
 {
+    m_worker.Stop();
+    FreeImages();
+}
+
+
+HRESULT OutpinPreview::Start()
+{
+    const HRESULT hr = Outpin::Start();
+
+    if (hr != S_OK)  //not connected
+        return hr;
+
+    GetFrameSize(m_width, m_height);
+    m_stride = GetBMIH().biWidth;
+
+    m_frame_rate = -1;  //the pacer is reset by the first Render
+
+    if (!m_worker.Start())
+    {
+        Outpin::Stop();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+
+void OutpinPreview::Stop()
+{
+    //The allocator is decommitted first, so that the preview's thread
+    //isn't left waiting for a sample.
+
+    Outpin::Stop();
+
+    m_worker.Stop();
+    FreeImages();
+}
+
+
+void OutpinPreview::FreeImages()
+{
+    if (m_converted)
+    {
+        vpx_img_free(m_converted);
+        m_converted = 0;
+    }
+
+    if (m_scaled)
+    {
+        vpx_img_free(m_scaled);
+        m_scaled = 0;
+    }
 }
 
 
@@ -147,6 +249,27 @@ std::wstring OutpinPreview::GetName() const
 }
 
 
+void OutpinPreview::GetFrameSize(LONG& w, LONG& h) const
+{
+    Outpin::GetFrameSize(w, h);  //the input's
+
+    const Filter::Config& cfg = m_pFilter->m_cfg;
+
+    int ww, hh;
+
+    WebmUtil::GetPreviewFrameSize(
+        w,
+        h,
+        cfg.preview_max_width,
+        cfg.preview_max_height,
+        ww,
+        hh);
+
+    w = ww;
+    h = hh;
+}
+
+
 void OutpinPreview::SetDefaultMediaTypes()
 {
     m_preferred_mtv.Clear();
@@ -192,10 +315,13 @@ HRESULT OutpinPreview::PostConnect(IPin* p)
 
 
 void OutpinPreview::Render(
-    CLockable::Lock& lock,
-    const vpx_image_t* img)
+    IMediaSample* pSample,
+    vpx_img_fmt_t fmt,
+    LONG w,
+    LONG h,
+    REFERENCE_TIME st)
 {
-    assert(img);
+    assert(pSample);
 
     if (!bool(m_pPinConnection))
         return;
@@ -206,22 +332,56 @@ void OutpinPreview::Render(
     if (!bool(m_pAllocator))
         return;
 
-    HRESULT hr = lock.Release();
-    assert(SUCCEEDED(hr));
+    const int rate = m_pFilter->m_cfg.preview_max_frame_rate;
 
-    GraphUtil::IMediaSamplePtr pOutSample;
+    if (rate != m_frame_rate)  //can change while we run
+    {
+        m_frame_rate = rate;
+        m_pacer.Reset((rate > 0) ? (10000000 / rate) : 0);
+    }
+
+    if (!m_pacer.IsDue(st))
+        return;
+
+    if (m_worker.IsBusy())  //the preview can't keep up, so drop this one
+    {
+        m_pipeline_stats.OnStarved();
+        return;
+    }
 
-    const HRESULT hrGetBuffer = m_pAllocator->GetBuffer(
-                                    &pOutSample,
-                                    0,
-                                    0,
-                                    AM_GBF_NOWAIT);
+    PreviewJob* const job =
+        new (std::nothrow) PreviewJob(this, pSample, fmt, w, h);
 
-    hr = lock.Seize(m_pFilter);
-    assert(SUCCEEDED(hr));  //TODO
+    if (job == 0)
+        return;
+
+    if (!m_worker.Post(job))
+        m_pipeline_stats.OnStarved();
+}
+
+
+void OutpinPreview::RenderSample(
+    GraphUtil::IMediaSamplePtr& pInSample,
+    vpx_img_fmt_t fmt,
+    LONG w,
+    LONG h)
+{
+    //The pin's allocator and downstream pin don't change while the
+    //filter runs, so we can use them without the filter lock.
 
-    if (FAILED(hrGetBuffer))
+    assert(bool(pInSample));
+    assert(bool(m_pAllocator));
+    assert(bool(m_pInputPin));
+
+    GraphUtil::IMediaSamplePtr pOutSample;
+
+    HRESULT hr = m_pAllocator->GetBuffer(&pOutSample, 0, 0, AM_GBF_NOWAIT);
+
+    if (FAILED(hr))  //downstream can't keep up, so drop this one
+    {
+        m_pipeline_stats.OnStarved();
         return;
+    }
 
     assert(bool(pOutSample));
 
@@ -229,80 +389,141 @@ void OutpinPreview::Render(
 
     hr = pOutSample->GetMediaType(&pmt);
 
-    if (SUCCEEDED(hr) && (pmt != 0))
+    if (SUCCEEDED(hr) && (pmt != 0))  //downstream changed the stride
     {
         assert(QueryAccept(pmt) == S_OK);
-        m_connection_mtv.Clear();
-        m_connection_mtv.Add(*pmt);
+
+        if (pmt->formattype == FORMAT_VideoInfo)
+        {
+            const VIDEOINFOHEADER& vih = (VIDEOINFOHEADER&)(*pmt->pbFormat);
+            m_stride = vih.bmiHeader.biWidth;
+        }
+        else if (pmt->formattype == FORMAT_VideoInfo2)
+        {
+            const VIDEOINFOHEADER2& vih = (VIDEOINFOHEADER2&)(*pmt->pbFormat);
+            m_stride = vih.bmiHeader.biWidth;
+        }
 
         MediaTypeUtil::Free(pmt);
         pmt = 0;
     }
 
-    unsigned int wIn = img->d_w;
-    unsigned int hIn = img->d_h;
+    long lenOut;
 
-    const BITMAPINFOHEADER& bmih = GetBMIH();
+    {
+        const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
 
-    LONG strideOut = bmih.biWidth;
-    assert(strideOut);
-    assert((strideOut % 2) == 0);
+        BYTE* pInBuf;
 
-    //Y
+        hr = pInSample->GetPointer(&pInBuf);
+        assert(SUCCEEDED(hr));
+        assert(pInBuf);
 
-    const BYTE* pInY = img->planes[VPX_PLANE_Y];
-    assert(pInY);
+        vpx_image_t img_;
+        const vpx_image_t* img;
 
-    BYTE* pOutBuf;
+        if (fmt == VPX_IMG_FMT_YUY2)
+        {
+            const bool b = webmdshow::LibyuvConvertYUY2ToI420(
+                            pInBuf,
+                            2 * w,
+                            w,
+                            h,
+                            &m_converted);
 
-    hr = pOutSample->GetPointer(&pOutBuf);
-    assert(SUCCEEDED(hr));
-    assert(pOutBuf);
+            if (!b)
+                return;
 
-    BYTE* pOut = pOutBuf;
+            img = m_converted;
+        }
+        else
+        {
+            img = vpx_img_wrap(&img_, fmt, w, h, 1, pInBuf);
+            assert(img);
+        }
 
-    const int strideInY = img->stride[VPX_PLANE_Y];
+        if ((LONG(img->d_w) != m_width) || (LONG(img->d_h) != m_height))
+        {
+            const bool b = webmdshow::LibyuvScaleI420(
+                            m_width,
+                            m_height,
+                            img,
+                            &m_scaled);
 
-    for (unsigned int y = 0; y < hIn; ++y)
-    {
-        memcpy(pOut, pInY, wIn);
-        pInY += strideInY;
-        pOut += strideOut;
-    }
+            if (!b)
+                return;
 
-    strideOut /= 2;
+            img = m_scaled;
+        }
 
-    wIn = (wIn + 1) / 2;
-    hIn = (hIn + 1) / 2;
+        unsigned int wIn = img->d_w;
+        unsigned int hIn = img->d_h;
 
-    const BYTE* pInV = img->planes[VPX_PLANE_V];
-    assert(pInV);
+        LONG strideOut = m_stride;
+        assert(strideOut >= LONG(wIn));
+        assert((strideOut % 2) == 0);
 
-    const int strideInV = img->stride[VPX_PLANE_V];
+        BYTE* pOutBuf;
 
-    const BYTE* pInU = img->planes[VPX_PLANE_U];
-    assert(pInU);
+        hr = pOutSample->GetPointer(&pOutBuf);
+        assert(SUCCEEDED(hr));
+        assert(pOutBuf);
 
-    const int strideInU = img->stride[VPX_PLANE_U];
+        BYTE* pOut = pOutBuf;
 
-    //V
+        //Y
 
-    for (unsigned int y = 0; y < hIn; ++y)
-    {
-        memcpy(pOut, pInV, wIn);
-        pInV += strideInV;
-        pOut += strideOut;
-    }
+        const BYTE* pInY = img->planes[VPX_PLANE_Y];
+        assert(pInY);
 
-    //U
+        const int strideInY = img->stride[VPX_PLANE_Y];
 
-    for (unsigned int y = 0; y < hIn; ++y)
-    {
-        memcpy(pOut, pInU, wIn);
-        pInU += strideInU;
-        pOut += strideOut;
+        for (unsigned int y = 0; y < hIn; ++y)
+        {
+            memcpy(pOut, pInY, wIn);
+            pInY += strideInY;
+            pOut += strideOut;
+        }
+
+        strideOut /= 2;
+
+        wIn = (wIn + 1) / 2;
+        hIn = (hIn + 1) / 2;
+
+        const BYTE* pInV = img->planes[VPX_PLANE_V];
+        assert(pInV);
+
+        const int strideInV = img->stride[VPX_PLANE_V];
+
+        const BYTE* pInU = img->planes[VPX_PLANE_U];
+        assert(pInU);
+
+        const int strideInU = img->stride[VPX_PLANE_U];
+
+        //V
+
+        for (unsigned int y = 0; y < hIn; ++y)
+        {
+            memcpy(pOut, pInV, wIn);
+            pInV += strideInV;
+            pOut += strideOut;
+        }
+
+        //U
+
+        for (unsigned int y = 0; y < hIn; ++y)
+        {
+            memcpy(pOut, pInU, wIn);
+            pInU += strideInU;
+            pOut += strideOut;
+        }
+
+        const ptrdiff_t lenOut_ = pOut - pOutBuf;
+        lenOut = static_cast<long>(lenOut_);
     }
 
+    pInSample = 0;  //upstream can have it back
+
     hr = pOutSample->SetTime(0, 0);
     assert(SUCCEEDED(hr));
 
@@ -312,9 +533,6 @@ void OutpinPreview::Render(
     hr = pOutSample->SetPreroll(FALSE);
     assert(SUCCEEDED(hr));
 
-    const ptrdiff_t lenOut_ = pOut - pOutBuf;
-    const long lenOut = static_cast<long>(lenOut_);
-
     hr = pOutSample->SetActualDataLength(lenOut);
     assert(SUCCEEDED(hr));
 
@@ -322,13 +540,9 @@ void OutpinPreview::Render(
 
     hr = pOutSample->SetMediaTime(0, 0);
 
-    hr = lock.Release();
-    assert(SUCCEEDED(hr));
+    m_pipeline_stats.OnOutput(lenOut);
 
     hr = m_pInputPin->Receive(pOutSample);
-
-    hr = lock.Seize(m_pFilter);
-    assert(SUCCEEDED(hr));  //TODO
 }
 
 
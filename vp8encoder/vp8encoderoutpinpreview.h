@@ -8,11 +8,19 @@
 
 #pragma once
 #include "vp8encoderoutpin.h"
+#include "videopreview.h"
+#include "vpx/vpx_image.h"
 
 namespace VP8EncoderLib
 {
 class Filter;
 
+//The preview output (IVPXPreview): the input, scaled down to fit within
+//the preview's maximum size, at no more than its maximum frame rate.
+//The preview is rendered on a thread of its own, from a reference to the
+//input sample, so the encoding thread neither copies nor scales it, and
+//never waits for it; while the thread is busy, frames aren't previewed.
+
 class OutpinPreview : public Outpin
 {
     OutpinPreview(const OutpinPreview&);
@@ -25,6 +33,9 @@ public:
     explicit OutpinPreview(Filter*);
     virtual ~OutpinPreview();
 
+    HRESULT Start();  //from stopped to running/paused
+    void Stop();      //from running/paused to stopped
+
     //IUnknown interface:
 
     HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
@@ -39,13 +50,46 @@ public:
 
     //local functions
 
-    void Render(CLockable::Lock&, const vpx_image_t*);
+    //Called with the filter lock held, for each input sample (a |fmt|
+    //image, |w| by |h|, starting at |st|).  If the frame is due, and the
+    //preview's thread is idle, the thread is handed a reference to the
+    //sample.
+    void Render(
+        IMediaSample*,
+        vpx_img_fmt_t fmt,
+        LONG w,
+        LONG h,
+        REFERENCE_TIME st);
+
     void SetDefaultMediaTypes();
+    void GetFrameSize(LONG&, LONG&) const;
+
+    //Renders the sample; runs on the preview's thread, without the filter
+    //lock.  The sample is released before downstream receives the frame.
+    void RenderSample(
+        GraphUtil::IMediaSamplePtr&,
+        vpx_img_fmt_t,
+        LONG w,
+        LONG h);
 
 protected:
     virtual HRESULT PostConnect(IPin*);
     void GetSubtype(GUID&) const;
 
+private:
+    WebmUtil::PreviewWorker m_worker;
+    WebmUtil::PreviewPacer m_pacer;
+    int m_frame_rate;  //that the pacer was reset for
+
+    //Only the preview's thread touches these while the filter runs.
+    LONG m_width;
+    LONG m_height;
+    LONG m_stride;  //of the samples downstream gives us
+    vpx_image_t* m_converted;  //from YUY2
+    vpx_image_t* m_scaled;
+
+    void FreeImages();
+
 };
 
 
@@ -0,0 +1,424 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <comdef.h>
+#include "vp8encoderfilter.h"
+#include "vp8encoderoutpinrendition.h"
+#include "libyuv_util.h"
+#include "simulcast.h"
+#include "vp9tiling.h"
+#include "vpx/vp8cx.h"
+#include <vfwmsgs.h>
+#include <cassert>
+#include <sstream>
+#ifdef _DEBUG
+#include "odbgstream.h"
+using std::endl;
+#endif
+
+namespace VP8EncoderLib
+{
+
+OutpinRendition::OutpinRendition(
+    Filter* pFilter,
+    int index,
+    const wchar_t* id) :
+    OutpinVideo(pFilter, id),
+    m_index(index),
+    m_bEncoding(false),
+    m_bDone(false),
+    m_bDiscontinuity(true),
+    m_img(0)
+{
+    assert(m_index >= 0);
+    assert(m_index < kMaxRenditions);
+
+    memset(&m_ctx, 0, sizeof m_ctx);
+}
+
+
+OutpinRendition::~OutpinRendition()
+{
+    StopEncoder();
+}
+
+
+std::wstring OutpinRendition::GetName() const
+{
+    const std::wstring name = OutpinVideo::GetName();
+
+    if (!bool(m_pFilter->m_inpin.m_pPinConnection))
+        return name;
+
+    LONG w, h;
+    GetFrameSize(w, h);
+
+    std::wostringstream os;
+    os << name << L' ' << w << L'x' << h;
+
+    return os.str();
+}
+
+
+bool OutpinRendition::IsActive() const
+{
+    return (m_index < m_pFilter->GetActiveRenditionCount());
+}
+
+
+void OutpinRendition::GetFrameSize(LONG& w, LONG& h) const
+{
+    Outpin::GetFrameSize(w, h);  //the input's
+
+    const Filter::Config::Rendition& r = m_pFilter->m_cfg.renditions[m_index];
+
+    int ww, hh;
+
+    if (WebmUtil::GetSimulcastFrameSize(w, h, r.width, r.height, ww, hh))
+    {
+        w = ww;
+        h = hh;
+    }
+}
+
+
+void OutpinRendition::OnInpinConnect()
+{
+    assert(!bool(m_pPinConnection));
+
+    //The renditions are only encoded in one-pass mode, so unlike the
+    //main output, there's no stats output to offer.
+
+    Outpin::OnInpinConnect();
+}
+
+
+HRESULT OutpinRendition::PostConnect(IPin* p)
+{
+    return PostConnectVideo(p);
+}
+
+
+HRESULT OutpinRendition::StartEncoder(const vpx_codec_enc_cfg_t& cfg)
+{
+    assert(!m_bEncoding);
+
+    m_bDone = false;
+    m_bDiscontinuity = true;
+
+    PurgePending();
+
+    LONG w, h;
+    GetFrameSize(w, h);
+
+    m_cfg = cfg;
+
+    m_cfg.g_w = w;
+    m_cfg.g_h = h;
+
+    const Filter::Config& src = m_pFilter->m_cfg;
+    const Filter::Config::Rendition& r = src.renditions[m_index];
+
+    if (r.target_bitrate > 0)
+        m_cfg.rc_target_bitrate = r.target_bitrate;
+    else
+    {
+        m_cfg.rc_target_bitrate = WebmUtil::GetSimulcastTargetBitrate(
+                                    cfg.g_w,
+                                    cfg.g_h,
+                                    cfg.rc_target_bitrate,
+                                    w,
+                                    h);
+    }
+
+    if ((src.threads < 0) && (src.encoder_kind == kVP9Encoder))
+    {
+        //As for the main encoder (Inpin::SetConfig), but a smaller frame
+        //has fewer tile columns to give threads.
+
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        const int n = static_cast<int>(info.dwNumberOfProcessors);
+
+        m_cfg.g_threads = WebmUtil::GetVP9AutoThreadCount(w, n);
+    }
+
+    //The input pin decides where the keyframes go, for all of the
+    //encoders at once.
+
+    m_cfg.kf_mode = VPX_KF_DISABLED;
+
+    const HRESULT hr = m_pFilter->m_inpin.InitEncoder(m_ctx, m_cfg);
+
+    if (FAILED(hr))
+        return hr;
+
+    m_bEncoding = true;
+    return S_OK;
+}
+
+
+void OutpinRendition::StopEncoder()
+{
+    if (m_bEncoding)
+    {
+        const vpx_codec_err_t err = vpx_codec_destroy(&m_ctx);
+        err;
+        assert(err == VPX_CODEC_OK);
+
+        memset(&m_ctx, 0, sizeof m_ctx);
+
+        m_bEncoding = false;
+    }
+
+    if (m_img)
+    {
+        vpx_img_free(m_img);
+        m_img = 0;
+    }
+
+    PurgePending();
+}
+
+
+bool OutpinRendition::IsEncoding() const
+{
+    return m_bEncoding;
+}
+
+
+void OutpinRendition::SetCPUUsed(int cpu_used)
+{
+    if (!m_bEncoding)
+        return;
+
+    const vpx_codec_err_t err =
+        vpx_codec_control(&m_ctx, VP8E_SET_CPUUSED, cpu_used);
+    err;
+    assert(err == VPX_CODEC_OK);
+}
+
+
+void OutpinRendition::Encode(
+    const vpx_image_t* img,
+    vpx_codec_pts_t pts,
+    unsigned long d,
+    vpx_enc_frame_flags_t f,
+    unsigned long dl)
+{
+    if (!m_bEncoding || m_bDone)
+        return;
+
+    const vpx_image_t* src = 0;
+
+    if (img)
+    {
+        const bool b = webmdshow::LibyuvScaleI420(
+                        m_cfg.g_w,
+                        m_cfg.g_h,
+                        img,
+                        &m_img);
+
+        if (!b)
+            return;  //the frame is dropped
+
+        src = m_img;
+    }
+
+    const vpx_codec_err_t err = vpx_codec_encode(&m_ctx, src, pts, d, f, dl);
+
+    if (err != VPX_CODEC_OK)
+    {
+        assert(err == VPX_CODEC_OK);  //TODO
+        return;
+    }
+
+    vpx_codec_iter_t iter = 0;
+
+    for (;;)
+    {
+        const vpx_codec_cx_pkt_t* const pkt =
+            vpx_codec_get_cx_data(&m_ctx, &iter);
+
+        if (pkt == 0)
+            break;
+
+        if (pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+            AppendFrame(pkt);
+    }
+}
+
+
+void OutpinRendition::AppendFrame(const vpx_codec_cx_pkt_t* pkt)
+{
+    assert(pkt);
+    assert(pkt->kind == VPX_CODEC_CX_FRAME_PKT);
+
+    if (!bool(m_pAllocator))
+        return;
+
+    IVP8Sample::Frame f;
+
+    HRESULT hr = GetFrame(f);  //the allocator is locked, not the filter
+
+    if (FAILED(hr))
+        return;
+
+    assert(f.buf);
+
+    const long len = static_cast<long>(pkt->data.frame.sz);
+
+    const long size = f.buflen - f.off;
+    size;
+    assert(size >= len);
+
+    memcpy(f.buf + f.off, pkt->data.frame.buf, len);
+
+    f.len = len;
+
+    f.start = pkt->data.frame.pts * 10000; // scale to 100 ns ticks
+    assert(f.start >= 0);
+
+    f.stop = -1;  //don't send stop time
+
+    f.key = (pkt->data.frame.flags & VPX_FRAME_IS_KEY) ? true : false;
+
+    m_pending.push_back(f);
+}
+
+
+HRESULT OutpinRendition::Deliver(CLockable::Lock& lock)
+{
+    if (m_bDone)
+    {
+        PurgePending();
+        return S_FALSE;
+    }
+
+    m_pipeline_stats.OnQueueDepth(static_cast<long>(m_pending.size()));
+
+    while (!m_pending.empty())
+    {
+        if (!bool(m_pAllocator) || !bool(m_pInputPin))
+            return OnDownstreamFailure(VFW_E_NO_ALLOCATOR);
+
+        lock.Release();
+
+        GraphUtil::IMediaSamplePtr pOutSample;
+        HRESULT hrGetBuffer;
+
+        {
+            const WebmUtil::PipelineStats::WaitTimer timer(m_pipeline_stats);
+            hrGetBuffer = m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        }
+
+        HRESULT hr = lock.Seize(m_pFilter);
+
+        if (FAILED(hr))
+            return hr;
+
+        if (!m_bEncoding)  //the filter was stopped meanwhile
+            return S_FALSE;
+
+        if (FAILED(hrGetBuffer))
+            return OnDownstreamFailure(hrGetBuffer);
+
+        assert(bool(pOutSample));
+
+        PopulateSample(pOutSample);  //consume pending frame
+
+        if (!bool(m_pInputPin))
+            return OnDownstreamFailure(VFW_E_NOT_CONNECTED);
+
+        lock.Release();
+
+        const HRESULT hrReceive = m_pInputPin->Receive(pOutSample);
+
+        hr = lock.Seize(m_pFilter);
+
+        if (FAILED(hr))
+            return hr;
+
+        if (hrReceive != S_OK)
+            return OnDownstreamFailure(hrReceive);
+    }
+
+    return S_OK;
+}
+
+
+HRESULT OutpinRendition::OnDownstreamFailure(HRESULT hr)
+{
+#ifdef _DEBUG
+    odbgstream os;
+    os << "vp8enc::rendition: index="
+       << m_index
+       << " hr=0x"
+       << std::hex
+       << hr
+       << std::dec
+       << "; not encoding this rendition any further"
+       << endl;
+#else
+    hr;
+#endif
+
+    m_bDone = true;
+    PurgePending();
+
+    return S_FALSE;
+}
+
+
+void OutpinRendition::PopulateSample(IMediaSample* p)
+{
+    assert(p);
+    assert(!m_pending.empty());
+
+    _COM_SMARTPTR_TYPEDEF(IVP8Sample, __uuidof(IVP8Sample));
+
+    const IVP8SamplePtr pSample(p);
+    assert(bool(pSample));
+
+    IVP8Sample::Frame& f = pSample->GetFrame();
+    assert(f.buf == 0);  //should have already been reclaimed
+
+    f = m_pending.front();
+    assert(f.buf);
+
+    m_pending.pop_front();
+
+    m_pipeline_stats.OnOutput(f.len);
+
+    HRESULT hr = p->SetPreroll(FALSE);
+    assert(SUCCEEDED(hr));
+
+    hr = p->SetDiscontinuity(m_bDiscontinuity ? TRUE : FALSE);
+    assert(SUCCEEDED(hr));
+
+    m_bDiscontinuity = false;
+}
+
+
+void OutpinRendition::PurgePending()
+{
+    while (!m_pending.empty())
+    {
+        IVP8Sample::Frame& f = m_pending.front();
+        assert(f.buf);
+
+        delete[] f.buf;
+
+        m_pending.pop_front();
+    }
+}
+
+
+}  //end namespace VP8EncoderLib
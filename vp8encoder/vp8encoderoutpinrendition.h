@@ -0,0 +1,98 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "vp8encoderoutpinvideo.h"
+#include "clockable.h"
+#include "vpx/vpx_encoder.h"
+#include "ivp8sample.h"
+#include <list>
+
+namespace VP8EncoderLib
+{
+class Filter;
+
+enum { kMaxRenditions = 3 };
+
+//A simulcast output (IVPXSimulcast): the input, scaled down and encoded
+//at another size and bitrate.  Each rendition pin has an encoder of its
+//own.  The input pin runs it, on a worker thread, alongside the main
+//encoder; Encode only touches this pin's own state, so it can run
+//without the filter lock.
+
+class OutpinRendition : public OutpinVideo
+{
+    OutpinRendition(const OutpinRendition&);
+    OutpinRendition& operator=(const OutpinRendition&);
+
+protected:
+    std::wstring GetName() const;
+
+public:
+    OutpinRendition(Filter*, int index, const wchar_t* id);
+    virtual ~OutpinRendition();
+
+    const int m_index;
+
+    //local functions
+
+    bool IsActive() const;  //listed among the filter's pins
+    void GetFrameSize(LONG&, LONG&) const;
+    void OnInpinConnect();
+
+    //The encoder is configured as the main one (cfg), less the size,
+    //the bitrate and the keyframe placement.
+    HRESULT StartEncoder(const vpx_codec_enc_cfg_t& cfg);
+    void StopEncoder();
+    bool IsEncoding() const;
+
+    //For the speed governor; called between frames.
+    void SetCPUUsed(int);
+
+    //Scales the image to this rendition's size and encodes it, or with
+    //no image, flushes the encoder.  The frames it produces are kept
+    //until Deliver.
+    void Encode(
+        const vpx_image_t*,
+        vpx_codec_pts_t,
+        unsigned long duration,
+        vpx_enc_frame_flags_t,
+        unsigned long deadline);
+
+    //Sends the pending frames downstream.  Called with the filter lock
+    //held, which is released while waiting for a sample and while
+    //downstream receives it.  Once downstream refuses a frame, this
+    //rendition isn't encoded any further (until the next start); the
+    //other renditions carry on.  Only fails if the lock can't be seized
+    //again, in which case it isn't held.
+    HRESULT Deliver(CLockable::Lock&);
+
+    void PurgePending();
+
+protected:
+    HRESULT PostConnect(IPin*);
+
+private:
+    bool m_bEncoding;
+    bool m_bDone;  //downstream refused a frame
+    bool m_bDiscontinuity;
+    vpx_codec_ctx_t m_ctx;
+    vpx_codec_enc_cfg_t m_cfg;
+    vpx_image_t* m_img;  //scaled
+
+    typedef std::list<IVP8Sample::Frame> frames_t;
+    frames_t m_pending;
+
+    void AppendFrame(const vpx_codec_cx_pkt_t*);
+    void PopulateSample(IMediaSample*);
+    HRESULT OnDownstreamFailure(HRESULT);
+
+};
+
+
+}  //end namespace VP8EncoderLib
@@ -38,6 +38,12 @@ OutpinVideo::OutpinVideo(Filter* pFilter) :
 }
 
 
+OutpinVideo::OutpinVideo(Filter* pFilter, const wchar_t* id) :
+    Outpin(pFilter, id)
+{
+}
+
+
 OutpinVideo::~OutpinVideo()
 {
 }
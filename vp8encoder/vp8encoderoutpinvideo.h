@@ -27,6 +27,11 @@ public:
     explicit OutpinVideo(Filter*);
     virtual ~OutpinVideo();
 
+protected:
+    OutpinVideo(Filter*, const wchar_t* id);  //for the rendition pins
+
+public:
+
     //IUnknown interface:
 
     HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
@@ -275,6 +275,8 @@ void PropPage::Initialize(HWND hWnd)
     GetKeyframeMinInterval(hWnd);
     GetKeyframeMaxInterval(hWnd);
     GetEncoderKind(hWnd);
+    GetTileColumns(hWnd);
+    GetFrameParallel(hWnd);
 }
 
 
@@ -512,6 +514,8 @@ HRESULT PropPage::Apply()
     SetKeyframeMinInterval();
     SetKeyframeMaxInterval();
     SetEncoderKind();
+    SetTileColumns();
+    SetFrameParallel();
 
     m_bDirty = false;
 
@@ -715,6 +719,8 @@ HRESULT PropPage::Clear()
     SetText(hWnd, IDC_KEYFRAME_MIN_INTERVAL);
     SetText(hWnd, IDC_KEYFRAME_MAX_INTERVAL);
     ComboBox_SetCurSel(GetDlgItem(hWnd, IDC_ENCODER_KIND), 0);  //VP8
+    SetText(hWnd, IDC_TILE_COLUMNS);
+    SetText(hWnd, IDC_FRAME_PARALLEL);
 
     m_hWnd = hWnd;
     m_bDirty = false;
@@ -1570,4 +1576,42 @@ HRESULT PropPage::SetEncoderKind()
     return S_OK;
 }
 
+
+HRESULT PropPage::GetTileColumns(HWND hWnd)
+{
+    return GetIntValue(
+            hWnd,
+            &IVP9Encoder::GetTileColumns,
+            IDC_TILE_COLUMNS,
+            L"tile columns");
+}
+
+
+HRESULT PropPage::SetTileColumns()
+{
+    return SetIntValue(
+            &IVP9Encoder::SetTileColumns,
+            IDC_TILE_COLUMNS,
+            L"tile columns");
+}
+
+
+HRESULT PropPage::GetFrameParallel(HWND hWnd)
+{
+    return GetIntValue(
+            hWnd,
+            &IVP9Encoder::GetFrameParallel,
+            IDC_FRAME_PARALLEL,
+            L"frame parallel");
+}
+
+
+HRESULT PropPage::SetFrameParallel()
+{
+    return SetIntValue(
+            &IVP9Encoder::SetFrameParallel,
+            IDC_FRAME_PARALLEL,
+            L"frame parallel");
+}
+
 }  //end namespace VP8EncoderLib
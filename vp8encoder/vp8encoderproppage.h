@@ -49,7 +49,7 @@ private:
     LONG m_cRef;
     IPropertyPageSite* m_pSite;
     bool m_bDirty;
-    IVPXEncoder* m_pVPX;
+    IVP9Encoder* m_pVPX;
     HWND m_hWnd;
 
     static INT_PTR CALLBACK DialogProc(HWND, UINT, WPARAM, LPARAM);
@@ -59,7 +59,7 @@ private:
     static DWORD SetText(HWND, int);
     DWORD GetText(int, std::wstring&) const;
 
-    typedef HRESULT (STDMETHODCALLTYPE IVPXEncoder::* pfnGetValue)(int*);
+    typedef HRESULT (STDMETHODCALLTYPE IVP9Encoder::* pfnGetValue)(int*);
 
     HRESULT GetIntValue(
                 HWND,
@@ -67,7 +67,7 @@ private:
                 int code,
                 const wchar_t*);
 
-    typedef HRESULT (STDMETHODCALLTYPE IVPXEncoder::* pfnSetValue)(int);
+    typedef HRESULT (STDMETHODCALLTYPE IVP9Encoder::* pfnSetValue)(int);
 
     HRESULT SetIntValue(
                 pfnSetValue,
@@ -140,6 +140,12 @@ private:
     HRESULT GetEncoderKind(HWND);
     HRESULT SetEncoderKind();
 
+    HRESULT GetTileColumns(HWND);
+    HRESULT SetTileColumns();
+
+    HRESULT GetFrameParallel(HWND);
+    HRESULT SetFrameParallel();
+
     void Initialize(HWND);
     void InitializeEndUsage(HWND);
     void InitializeKeyframeMode(HWND);
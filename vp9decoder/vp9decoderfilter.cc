@@ -77,6 +77,8 @@ HRESULT Filter::CNondelegating::QueryInterface(const IID& iid, void** ppv) {
              iid == __uuidof(IMediaFilter) ||
              iid == __uuidof(IPersist)) {
     pUnk = static_cast<IBaseFilter*>(m_pFilter);
+  } else if (iid == __uuidof(IPipelineStats)) {
+    pUnk = static_cast<IPipelineStats*>(m_pFilter);
   } else {
     pUnk = 0;
     return E_NOINTERFACE;
@@ -430,6 +432,30 @@ HRESULT Filter::QueryVendorInfo(LPWSTR* pstr) {
   return E_NOTIMPL;
 }
 
+ULONG Filter::GetStreamCount() {
+  return 2;  // one per pin
+}
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p) {
+  if (p == 0)
+    return E_POINTER;
+
+  const Pin* const pins[] = { &m_inpin, &m_outpin };
+
+  if (index >= GetStreamCount())
+    return E_INVALIDARG;
+
+  pins[index]->m_pipeline_stats.GetSnapshot(*p);
+  return S_OK;
+}
+
+HRESULT Filter::ResetStats() {
+  m_inpin.m_pipeline_stats.Reset();
+  m_outpin.m_pipeline_stats.Reset();
+
+  return S_OK;
+}
+
 void Filter::OnStart() {
   HRESULT hr = m_inpin.Start();
   assert(SUCCEEDED(hr));  // TODO
@@ -13,12 +13,15 @@
 #include <string>
 
 #include "clockable.h"
+#include "ipipelinestats.h"
 #include "vp9decoderinpin.h"
 #include "vp9decoderoutpin.h"
 
 namespace VP9DecoderLib {
 
-class Filter : public IBaseFilter, public CLockable {
+class Filter : public IBaseFilter,
+               public IPipelineStats,
+               public CLockable {
  public:
   // IUnknown
   HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
@@ -39,6 +42,11 @@ class Filter : public IBaseFilter, public CLockable {
   HRESULT STDMETHODCALLTYPE JoinFilterGraph(IFilterGraph*, LPCWSTR);
   HRESULT STDMETHODCALLTYPE QueryVendorInfo(LPWSTR*);
 
+  // IPipelineStats
+  ULONG STDMETHODCALLTYPE GetStreamCount();
+  HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+  HRESULT STDMETHODCALLTYPE ResetStats();
+
   FILTER_STATE GetStateLocked() const;
   HRESULT OnDecodeFailureLocked();
   void OnDecodeSuccessLocked(bool is_key);
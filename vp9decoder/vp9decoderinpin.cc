@@ -435,7 +435,14 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
   const long len = pInSample->GetActualDataLength();
   assert(len >= 0);
 
-  const vpx_codec_err_t err = vpx_codec_decode(&m_ctx, buf, len, 0, 0);
+  m_pipeline_stats.OnInput(len);
+
+  vpx_codec_err_t err;
+
+  {
+    const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+    err = vpx_codec_decode(&m_ctx, buf, len, 0, 0);
+  }
 
   if (err != VPX_CODEC_OK)
     return m_pFilter->OnDecodeFailureLocked();
@@ -451,7 +458,12 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
 
   GraphUtil::IMediaSamplePtr pOutSample;
 
-  hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+  {
+    const WebmUtil::PipelineStats::WaitTimer timer(
+        outpin.m_pipeline_stats);
+
+    hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+  }
 
   if (FAILED(hr))
     return S_FALSE;
@@ -521,29 +533,33 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
     return E_FAIL;
   }
 
-  if (mt.subtype == MEDIASUBTYPE_NV12)
-    CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
+  {
+    const WebmUtil::PipelineStats::Timer timer(outpin.m_pipeline_stats);
 
-  else if (mt.subtype == MEDIASUBTYPE_YV12)
-    CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
+    if (mt.subtype == MEDIASUBTYPE_NV12)
+      CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
 
-  else if (mt.subtype == WebmTypes::MEDIASUBTYPE_I420)
-    CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YV12)
+      CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
 
-  else if (mt.subtype == MEDIASUBTYPE_UYVY)
-    CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == WebmTypes::MEDIASUBTYPE_I420)
+      CopyToPlanar(f, pOutSample, mt.subtype, *bmih_ptr);
 
-  else if (mt.subtype == MEDIASUBTYPE_YUY2)
-    CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_UYVY)
+      CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
 
-  else if (mt.subtype == MEDIASUBTYPE_YUYV)
-    CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YUY2)
+      CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
 
-  else if (mt.subtype == MEDIASUBTYPE_YVYU)
-    CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YUYV)
+      CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
 
-  else
-    return E_FAIL;
+    else if (mt.subtype == MEDIASUBTYPE_YVYU)
+      CopyToPacked(f, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+
+    else
+      return E_FAIL;
+  }
 
   __int64 st, sp;
 
@@ -582,7 +598,12 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
 
   lock.Release();
 
-  return outpin.m_pInputPin->Receive(pOutSample);
+  hr = outpin.m_pInputPin->Receive(pOutSample);
+
+  if (hr == S_OK)
+    outpin.m_pipeline_stats.OnOutput(pOutSample->GetActualDataLength());
+
+  return hr;
 }
 
 HRESULT Inpin::ReceiveMultiple(IMediaSample** pSamples,
@@ -15,6 +15,7 @@
 
 #include "cmediatypes.h"
 #include "graphutil.h"
+#include "pipelinestats.h"
 
 namespace VP9DecoderLib {
 
@@ -37,12 +38,16 @@ class Pin : public IPin {
   CMediaTypes m_preferred_mtv;
   CMediaTypes m_connection_mtv;  // only one of these
   GraphUtil::IPinPtr m_pPinConnection;
+  WebmUtil::PipelineStats m_pipeline_stats;
 
  protected:
   virtual HRESULT GetName(PIN_INFO&) const = 0;
   virtual HRESULT OnDisconnect();
   Pin(Filter* pFilter, PIN_DIRECTION dir, const wchar_t* id)
-      : m_pFilter(pFilter), m_dir(dir), m_id(id) {}
+      : m_pFilter(pFilter),
+        m_dir(dir),
+        m_id(id),
+        m_pipeline_stats(id) {}
   virtual ~Pin() {}
 
  private:
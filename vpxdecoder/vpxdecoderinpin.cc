@@ -29,6 +29,7 @@
 #include "mediatypeutil.h"
 #include "vpxdecoderfilter.h"
 #include "vpxdecoderoutpin.h"
+#include "vpxframeparser.h"
 #include "webmtypes.h"
 
 #ifdef _DEBUG
@@ -54,6 +55,8 @@ Inpin::Inpin(Filter* p)
     : Pin(p, PINDIR_INPUT, L"input"),
       m_bEndOfStream(false),
       m_bFlush(false),
+      m_codec(WebmUtil::kVpxCodecVP8),
+      m_postproc_level(WebmUtil::VpxQualityGovernor::kLevelFull),
       scaled_frame(NULL) {
   AM_MEDIA_TYPE mt;
 
@@ -454,7 +457,17 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
   const long len = pInSample->GetActualDataLength();
   assert(len >= 0);
 
-  const vpx_codec_err_t err = vpx_codec_decode(&m_ctx, buf, len, 0, 0);
+  m_pipeline_stats.OnInput(len);
+
+  if (!OnQualityFrame(buf, len))
+    return S_OK;  // skipped: no later frame depends on this one
+
+  vpx_codec_err_t err;
+
+  {
+    const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+    err = vpx_codec_decode(&m_ctx, buf, len, 0, 0);
+  }
 
   if (err != VPX_CODEC_OK)
     return m_pFilter->OnDecodeFailureLocked();
@@ -470,7 +483,12 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
 
   GraphUtil::IMediaSamplePtr pOutSample;
 
-  hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+  {
+    const WebmUtil::PipelineStats::WaitTimer timer(
+        outpin.m_pipeline_stats);
+
+    hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+  }
 
   if (FAILED(hr))
     return S_FALSE;
@@ -546,35 +564,38 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
     return E_FAIL;
   }
 
-  // Scale (if necessary).
-  const uint32_t out_width = bmih_ptr->biWidth;
-  const uint32_t out_height = std::abs(bmih_ptr->biHeight);
-  if (frame->d_h != out_height || frame->d_w != out_width) {
-    if (!webmdshow::LibyuvScaleI420(out_width, out_height,
-                                    frame, &scaled_frame)) {
-      assert(false && "webmdshow::LibyuvScale failed.");
-      return E_FAIL;
+  // Scale (if necessary), and color convert into the output buffer.
+  {
+    const WebmUtil::PipelineStats::Timer timer(outpin.m_pipeline_stats);
+
+    const uint32_t out_width = bmih_ptr->biWidth;
+    const uint32_t out_height = std::abs(bmih_ptr->biHeight);
+    if (frame->d_h != out_height || frame->d_w != out_width) {
+      if (!webmdshow::LibyuvScaleI420(out_width, out_height,
+                                      frame, &scaled_frame)) {
+        assert(false && "webmdshow::LibyuvScale failed.");
+        return E_FAIL;
+      }
+      frame = scaled_frame;
     }
-    frame = scaled_frame;
-  }
 
-  // Color convert (if necessary).
-  if (mt.subtype == MEDIASUBTYPE_NV12)
-    CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
-  else if (mt.subtype == MEDIASUBTYPE_YV12)
-    CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
-  else if (mt.subtype == WebmTypes::MEDIASUBTYPE_I420)
-    CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
-  else if (mt.subtype == MEDIASUBTYPE_UYVY)
-    CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
-  else if (mt.subtype == MEDIASUBTYPE_YUY2)
-    CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
-  else if (mt.subtype == MEDIASUBTYPE_YUYV)
-    CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
-  else if (mt.subtype == MEDIASUBTYPE_YVYU)
-    CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
-  else
-    return E_FAIL;
+    if (mt.subtype == MEDIASUBTYPE_NV12)
+      CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YV12)
+      CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
+    else if (mt.subtype == WebmTypes::MEDIASUBTYPE_I420)
+      CopyToPlanar(frame, pOutSample, mt.subtype, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_UYVY)
+      CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YUY2)
+      CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YUYV)
+      CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else if (mt.subtype == MEDIASUBTYPE_YVYU)
+      CopyToPacked(frame, pOutSample, mt.subtype, *rc_ptr, *bmih_ptr);
+    else
+      return E_FAIL;
+  }
 
   __int64 st, sp;
 
@@ -613,7 +634,12 @@ HRESULT Inpin::Receive(IMediaSample* pInSample) {
 
   lock.Release();
 
-  return outpin.m_pInputPin->Receive(pOutSample);
+  hr = outpin.m_pInputPin->Receive(pOutSample);
+
+  if (hr == S_OK)
+    outpin.m_pipeline_stats.OnOutput(pOutSample->GetActualDataLength());
+
+  return hr;
 }
 
 HRESULT Inpin::ReceiveMultiple(IMediaSample** pSamples,
@@ -903,6 +929,49 @@ void Inpin::CopyToPacked(const vpx_image_t* f, IMediaSample* pOutSample,
   assert(SUCCEEDED(hr));
 }
 
+bool Inpin::OnQualityFrame(const BYTE* buf, long len) {
+  typedef WebmUtil::VpxQualityGovernor governor_t;
+
+  // The frame is only parsed when the governor might skip it.
+  WebmUtil::VpxFrameInfo info;
+  const WebmUtil::VpxFrameInfo* info_ptr = 0;
+
+  if (m_governor.GetLevel() >= governor_t::kLevelSkipDroppable) {
+    const int status = WebmUtil::ParseVpxFrame(m_codec, buf, len, info);
+
+    if (status == WebmUtil::kVpxParseOk)
+      info_ptr = &info;
+  }
+
+  const bool decode = m_governor.OnFrame(info_ptr);
+
+  // The level might have changed, either just now or in OnQualityNotify.
+  if (m_codec == WebmUtil::kVpxCodecVP8 &&
+      m_governor.GetLevel() != m_postproc_level) {
+    const HRESULT hr = OnApplyPostProcessing();
+    hr;
+    assert(SUCCEEDED(hr));
+  }
+
+  return decode;
+}
+
+void Inpin::OnQualityNotify(const Quality& q) {
+  // A new level takes effect on the streaming thread, when the next frame
+  // is received.
+  const bool changed = m_governor.OnNotify(q.Late);
+  changed;
+
+#ifdef _DEBUG
+  if (changed) {
+    odbgstream os;
+    os << "vpxdec::inpin::OnQualityNotify: late[ms]="
+       << double(q.Late) / 10000
+       << " level=" << m_governor.GetLevel() << endl;
+  }
+#endif
+}
+
 HRESULT Inpin::ReceiveCanBlock() {
   Filter::Lock lock;
 
@@ -948,8 +1017,10 @@ HRESULT Inpin::Start() {
     // it, so here it remains.
     flags = VPX_CODEC_USE_POSTPROC;
     vpx = &vpx_codec_vp8_dx_algo;
+    m_codec = WebmUtil::kVpxCodecVP8;
   } else if (m_connection_mtv[0].subtype == WebmTypes::MEDIASUBTYPE_VP90) {
     vpx = &vpx_codec_vp9_dx_algo;
+    m_codec = WebmUtil::kVpxCodecVP9;
   } else {
     return E_FAIL;
   }
@@ -961,6 +1032,9 @@ HRESULT Inpin::Start() {
   if (err != VPX_CODEC_OK)
     return E_FAIL;
 
+  m_governor.Reset();
+  m_postproc_level = WebmUtil::VpxQualityGovernor::kLevelFull;
+
   if (m_connection_mtv[0].subtype == WebmTypes::MEDIASUBTYPE_VP80) {
     const HRESULT hr = OnApplyPostProcessing();
 
@@ -978,6 +1052,20 @@ void Inpin::Stop() {
   err;
   assert(err == VPX_CODEC_OK);
 
+#ifdef _DEBUG
+  const WebmUtil::VpxQualityGovernor::Stats& s = m_governor.GetStats();
+
+  odbgstream os;
+  os << "vpxdec::inpin::Stop: frames=" << s.frames
+     << " decoded=" << s.decoded
+     << " skipped=" << s.skipped
+     << " notifications=" << s.notifications
+     << " max_late[ms]=" << double(s.max_late) / 10000
+     << " step_downs=" << s.step_downs
+     << " step_ups=" << s.step_ups
+     << endl;
+#endif
+
   if (scaled_frame != NULL) {
     vpx_img_free(scaled_frame);
     scaled_frame = NULL;
@@ -992,9 +1080,21 @@ HRESULT Inpin::OnApplyPostProcessing() {
   tgt.deblocking_level = src.deblock;
   tgt.noise_level = src.noise;
 
+  // Under load, the post-processing is the first thing to go.
+  const int level = m_governor.GetLevel();
+
+  if (level >= WebmUtil::VpxQualityGovernor::kLevelNoPostProc)
+    tgt.post_proc_flag = VP8_NOFILTERING;
+  else if (level == WebmUtil::VpxQualityGovernor::kLevelReducedPostProc)
+    tgt.post_proc_flag &= VP8_DEBLOCK;
+
   const vpx_codec_err_t err = vpx_codec_control(&m_ctx, VP8_SET_POSTPROC, &tgt);
 
-  return (err == VPX_CODEC_OK) ? S_OK : E_FAIL;
+  if (err != VPX_CODEC_OK)
+    return E_FAIL;
+
+  m_postproc_level = level;
+  return S_OK;
 }
 
 }  // namespace VPXDecoderLib
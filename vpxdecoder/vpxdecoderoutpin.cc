@@ -30,7 +30,8 @@ using std::wstring;
 
 namespace VPXDecoderLib {
 
-Outpin::Outpin(Filter* pFilter) : Pin(pFilter, PINDIR_OUTPUT, L"output") {
+Outpin::Outpin(Filter* pFilter)
+    : Pin(pFilter, PINDIR_OUTPUT, L"output"), m_pQualitySink(0) {
   SetDefaultMediaTypes();
 }
 
@@ -79,6 +80,8 @@ HRESULT Outpin::QueryInterface(const IID& iid, void** ppv) {
     pUnk = static_cast<IPin*>(this);
   } else if (iid == __uuidof(IMediaSeeking)) {
     pUnk = static_cast<IMediaSeeking*>(this);
+  } else if (iid == __uuidof(IQualityControl)) {
+    pUnk = static_cast<IQualityControl*>(this);
   } else {
 #if _DEBUG
     wodbgstream os;
@@ -711,6 +714,38 @@ HRESULT Outpin::GetPreroll(LONGLONG* p) {
   return E_FAIL;
 }
 
+HRESULT Outpin::Notify(IBaseFilter*, Quality q) {
+  Filter::Lock lock;
+
+  const HRESULT hr = lock.Seize(m_pFilter);
+
+  if (FAILED(hr))
+    return hr;
+
+  if (IQualityControl* const pSink = m_pQualitySink) {
+    lock.Release();
+    return pSink->Notify(m_pFilter, q);
+  }
+
+  // We handle lateness ourselves, by shedding decoder work, rather than
+  // passing the report upstream to the splitter.
+  m_pFilter->m_inpin.OnQualityNotify(q);
+
+  return S_OK;
+}
+
+HRESULT Outpin::SetSink(IQualityControl* pSink) {
+  Filter::Lock lock;
+
+  const HRESULT hr = lock.Seize(m_pFilter);
+
+  if (FAILED(hr))
+    return hr;
+
+  m_pQualitySink = pSink;
+  return S_OK;
+}
+
 HRESULT Outpin::GetName(PIN_INFO& info) const {
   wstring name;
 
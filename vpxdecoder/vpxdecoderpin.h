@@ -15,6 +15,7 @@
 
 #include "cmediatypes.h"
 #include "graphutil.h"
+#include "pipelinestats.h"
 
 namespace VPXDecoderLib {
 class Filter;
@@ -27,6 +28,7 @@ class Pin : public IPin {
   CMediaTypes m_preferred_mtv;
   CMediaTypes m_connection_mtv;  // only one of these
   GraphUtil::IPinPtr m_pPinConnection;
+  WebmUtil::PipelineStats m_pipeline_stats;
 
   // IPin interface:
   HRESULT STDMETHODCALLTYPE Disconnect();
@@ -0,0 +1,173 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include "allocstats.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+namespace
+{
+
+//Each block is prefixed with its size, so that the live bytes can be
+//tracked without asking the C library.  The prefix keeps the alignment
+//that malloc guarantees.
+
+union Prefix
+{
+    size_t size;
+    long double align_;
+};
+
+std::atomic<long long> s_allocs(0);
+std::atomic<long long> s_bytes(0);
+std::atomic<long long> s_live(0);
+std::atomic<long long> s_base(0);
+std::atomic<long long> s_peak(0);
+
+
+void* Allocate(size_t size)
+{
+    Prefix* const p = static_cast<Prefix*>(malloc(sizeof(Prefix) + size));
+
+    if (p == 0)
+        return 0;
+
+    p->size = size;
+
+    ++s_allocs;
+    s_bytes += size;
+
+    const long long live = (s_live += size);
+    long long peak = s_peak.load();
+
+    while ((live > peak) && !s_peak.compare_exchange_weak(peak, live))
+    {
+    }
+
+    return p + 1;
+}
+
+
+void Free(void* ptr)
+{
+    if (ptr == 0)
+        return;
+
+    Prefix* const p = static_cast<Prefix*>(ptr) - 1;
+
+    s_live -= p->size;
+    free(p);
+}
+
+}  //end anonymous namespace
+
+
+void* operator new(size_t size)
+{
+    void* const p = Allocate(size);
+
+    if (p == 0)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    return Allocate(size);
+}
+
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return Allocate(size);
+}
+
+
+void operator delete(void* p) throw()
+{
+    Free(p);
+}
+
+
+void operator delete[](void* p) throw()
+{
+    Free(p);
+}
+
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+    Free(p);
+}
+
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+    Free(p);
+}
+
+
+void operator delete(void* p, size_t) throw()
+{
+    Free(p);
+}
+
+
+void operator delete[](void* p, size_t) throw()
+{
+    Free(p);
+}
+
+
+namespace WebmBench
+{
+
+void AllocStats::Begin()
+{
+    const long long live = s_live.load();
+
+    s_allocs = 0;
+    s_bytes = 0;
+    s_base = live;
+    s_peak = live;
+}
+
+
+void AllocStats::Get(Counts& c)
+{
+    c.allocs = s_allocs;
+    c.bytes = s_bytes;
+    c.peak_bytes = s_peak - s_base;
+}
+
+
+long long AllocStats::GetPeakResident()
+{
+    rusage u;
+
+    if (getrusage(RUSAGE_SELF, &u) != 0)
+        return -1;
+
+#ifdef __APPLE__
+    return u.ru_maxrss;  //bytes
+#else
+    return static_cast<long long>(u.ru_maxrss) * 1024;  //kilobytes
+#endif
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,38 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+
+namespace WebmBench
+{
+
+//Counts the heap allocations made through operator new (which is
+//replaced in allocstats.cc), so that a change that makes the muxer or
+//the parser allocate per frame shows up even when it doesn't show up in
+//the timings.
+
+namespace AllocStats
+{
+    struct Counts
+    {
+        long long allocs;      //calls to operator new
+        long long bytes;       //total requested
+        long long peak_bytes;  //most bytes live at once, above the base
+    };
+
+    //Starts counting from zero; the bytes now live become the base.
+    void Begin();
+
+    void Get(Counts&);
+
+    //The high-water mark of the resident set of the process, in bytes.
+    long long GetPeakResident();
+
+}  //end namespace AllocStats
+
+}  //end namespace WebmBench
@@ -0,0 +1,134 @@
+#!/bin/sh
+##
+##  Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+##
+##  Use of this source code is governed by a BSD-style license
+##  that can be found in the LICENSE file in the root of the source
+##  tree. An additional intellectual property rights grant can be found
+##  in the file PATENTS.  All contributing project authors may
+##  be found in the AUTHORS file in the root of the source tree.
+##
+##  Builds webmbench with the host compiler (Linux or OS X), against the
+##  stand-ins for the Windows headers in common/portable.
+##
+##  The demux benchmark needs libwebm's mkvparser, which (as for the
+##  Visual Studio projects) is expected in a libwebm checkout next to this
+##  repository.  LIBWEBM_DIR overrides where to find it.  Without it only
+##  the mux benchmark is built.
+##
+##  The encode benchmark (--encode) needs libvorbis, which third_party only
+##  has as Windows libraries; it is built if pkg-config can find the host's
+##  libvorbisenc.
+##
+##  The VP9 encode benchmark (--vp9) likewise needs the host's libvpx
+##  (pkg-config vpx), built with VP9 encoding.
+##
+set -e
+
+readonly BENCH_DIR="$(cd "$(dirname "$0")" && pwd)"
+readonly ROOT_DIR="$(dirname "${BENCH_DIR}")"
+
+CXX="${CXX:-c++}"
+CXXFLAGS="${CXXFLAGS:--O2 -DNDEBUG}"
+LIBWEBM_DIR="${LIBWEBM_DIR:-${ROOT_DIR}/../libwebm}"
+OUT="${OUT:-${BENCH_DIR}/webmbench}"
+
+build_usage() {
+cat << EOF
+  Usage: ${0##*/} [arguments]
+    --help: Display this message and exit.
+    --mux-only: Don't build the demux benchmark, even if libwebm exists.
+
+  Environment: CXX, CXXFLAGS, LIBWEBM_DIR, OUT (the executable).
+EOF
+}
+
+mux_only=no
+
+for arg in "$@"; do
+  case "${arg}" in
+    --help)
+      build_usage
+      exit
+      ;;
+    --mux-only)
+      mux_only=yes
+      ;;
+    *)
+      build_usage
+      exit 1
+      ;;
+  esac
+done
+
+# The portable directory comes first, so that its headers shadow the
+# Windows SDK headers (and the two repo headers that can't be built here).
+includes="-I${ROOT_DIR}/common/portable -I${BENCH_DIR} -I${ROOT_DIR}/common \
+-I${ROOT_DIR}/third_party -I${ROOT_DIR}/webmmux"
+
+sources="${BENCH_DIR}/webmbench.cc
+${BENCH_DIR}/allocstats.cc
+${BENCH_DIR}/ebmlbench.cc
+${BENCH_DIR}/memstream.cc
+${BENCH_DIR}/muxbench.cc
+${BENCH_DIR}/renderbench.cc
+${BENCH_DIR}/synthmedia.cc
+${ROOT_DIR}/common/portable/webmportable.cc
+${ROOT_DIR}/common/memsample.cc
+${ROOT_DIR}/common/pipelinestats.cc
+${ROOT_DIR}/common/scratchbuf.cc
+${ROOT_DIR}/common/vorbisoutput.cc
+${ROOT_DIR}/common/cmediatypes.cc
+${ROOT_DIR}/common/mediatypeutil.cc
+${ROOT_DIR}/common/vorbistypes.cc
+${ROOT_DIR}/common/webmtypes.cc
+${ROOT_DIR}/webmmux/webmmuxcontext.cc
+${ROOT_DIR}/webmmux/webmmuxebmlio.cc
+${ROOT_DIR}/webmmux/webmmuxstream.cc
+${ROOT_DIR}/webmmux/webmmuxstreamaudio.cc
+${ROOT_DIR}/webmmux/webmmuxstreamaudiovorbis.cc
+${ROOT_DIR}/webmmux/webmmuxstreamvideo.cc
+${ROOT_DIR}/webmmux/webmmuxstreamvideovpx.cc"
+
+if [ "${mux_only}" = "no" ] && [ -f "${LIBWEBM_DIR}/mkvparser.hpp" ]; then
+  includes="${includes} -I${ROOT_DIR}/libmkvparser -I${LIBWEBM_DIR}"
+  sources="${sources}
+${BENCH_DIR}/demuxbench.cc
+${ROOT_DIR}/libmkvparser/mkvparserstream.cc
+${ROOT_DIR}/libmkvparser/mkvparserstreamaudio.cc
+${ROOT_DIR}/libmkvparser/mkvparserstreamreader.cc
+${ROOT_DIR}/libmkvparser/mkvparserstreamvideo.cc
+${LIBWEBM_DIR}/mkvparser.cpp"
+else
+  echo "${0##*/}: libwebm not found in ${LIBWEBM_DIR}; mux benchmark only."
+  CXXFLAGS="${CXXFLAGS} -DWEBMBENCH_NO_DEMUX"
+fi
+
+libs=""
+
+if pkg-config --exists vorbisenc 2>/dev/null; then
+  includes="${includes} $(pkg-config --cflags vorbisenc)"
+  libs="$(pkg-config --libs vorbisenc) -lpthread"
+  sources="${sources}
+${BENCH_DIR}/encodebench.cc
+${ROOT_DIR}/common/vorbisencodepipeline.cc"
+else
+  echo "${0##*/}: libvorbisenc not found; no encode benchmark."
+  CXXFLAGS="${CXXFLAGS} -DWEBMBENCH_NO_ENCODE"
+fi
+
+if pkg-config --exists vpx 2>/dev/null; then
+  includes="${includes} $(pkg-config --cflags vpx)"
+  libs="${libs} $(pkg-config --libs vpx) -lpthread"
+  sources="${sources}
+${BENCH_DIR}/vp9encodebench.cc
+${ROOT_DIR}/common/vp9tiling.cc"
+else
+  echo "${0##*/}: libvpx not found; no VP9 encode benchmark."
+  CXXFLAGS="${CXXFLAGS} -DWEBMBENCH_NO_VP9"
+fi
+
+${CXX} -std=c++11 ${CXXFLAGS} -include webmportable.h ${includes} \
+  ${sources} ${libs} -o "${OUT}"
+
+echo "${0##*/}: built ${OUT}"
@@ -0,0 +1,300 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <vfwmsgs.h>
+#include "demuxbench.h"
+#include "webmbench.h"
+#include "pipelinestats.h"
+#include "mkvparser.hpp"
+#include "mkvparserstreamreader.h"
+#include "mkvparserstreamvideo.h"
+#include "mkvparserstreamaudio.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
+
+using WebmUtil::MemSample;
+using WebmUtil::PipelineStats;
+
+namespace
+{
+
+//Reads the file from memory.  Frames are always copied into the samples
+//(the samples don't implement IExternalBufferSample), as they are by the
+//webmsource filter.
+
+class MemReader : public mkvparser::IStreamReader
+{
+    MemReader(const MemReader&);
+    MemReader& operator=(const MemReader&);
+
+public:
+
+    MemReader(const BYTE* data, long long length) :
+        m_data(data),
+        m_length(length)
+    {
+    }
+
+    ~MemReader()
+    {
+    }
+
+    int Read(long long pos, long len, unsigned char* buf)
+    {
+        if ((pos < 0) || (len < 0) || ((pos + len) > m_length))
+            return -1;
+
+        if (len > 0)
+            memcpy(buf, m_data + pos, len);
+
+        return 0;
+    }
+
+    int Length(long long* total, long long* available)
+    {
+        if (total)
+            *total = m_length;
+
+        if (available)
+            *available = m_length;
+
+        return 0;
+    }
+
+private:
+
+    const BYTE* const m_data;
+    const long long m_length;
+
+};
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+DemuxBench::DemuxBench(const BYTE* data, long long length) :
+    m_data(data),
+    m_length(length)
+{
+}
+
+
+DemuxBench::~DemuxBench()
+{
+    while (!m_pools.empty())
+    {
+        delete m_pools.back();
+        m_pools.pop_back();
+    }
+}
+
+
+HRESULT DemuxBench::Run(int runs, Result& result)
+{
+    assert(runs > 0);
+
+    long long frames, us;
+
+    HRESULT hr = RunOnce(frames, us);  //warm-up: creates the sample pools
+
+    if (FAILED(hr))
+        return hr;
+
+    std::vector<long long> times;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        AllocStats::Begin();
+
+        hr = RunOnce(frames, us);
+
+        if (FAILED(hr))
+            return hr;
+
+        AllocStats::Get(result.allocs);
+        times.push_back(us);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    result.bytes = m_length;
+    result.frames = frames;
+    result.best_us = times.front();
+    result.median_us = times[times.size() / 2];
+
+    return S_OK;
+}
+
+
+HRESULT DemuxBench::RunOnce(long long& frames, long long& us)
+{
+    using namespace mkvparser;
+
+    frames = 0;
+    us = 0;
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    MemReader reader(m_data, m_length);
+
+    EBMLHeader h;
+    long long pos;
+
+    long long status = h.Parse(&reader, pos);
+
+    if (status != 0)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    Segment* p;
+
+    status = Segment::CreateInstance(&reader, pos, p);
+
+    if (status != 0)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    const std::unique_ptr<Segment> pSegment(p);
+
+    status = pSegment->ParseHeaders();
+
+    if (status != 0)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    const Tracks* const pTracks = pSegment->GetTracks();
+
+    if (pTracks == 0)
+        return VFW_E_INVALID_FILE_FORMAT;
+
+    typedef std::vector<mkvparser::Stream*> streams_t;
+    streams_t streams;
+
+    const unsigned long n = pTracks->GetTracksCount();
+
+    for (unsigned long i = 0; i < n; ++i)
+    {
+        const Track* const pTrack = pTracks->GetTrackByIndex(i);
+
+        if (pTrack == 0)
+            continue;
+
+        const long long type = pTrack->GetType();
+
+        if (type == 1)  //video
+        {
+            typedef mkvparser::VideoTrack VT;
+            const VT* const t = static_cast<const VT*>(pTrack);
+
+            if (VideoStream* s = VideoStream::CreateInstance(t))
+                streams.push_back(s);
+        }
+        else if (type == 2)  //audio
+        {
+            typedef mkvparser::AudioTrack AT;
+            const AT* const t = static_cast<const AT*>(pTrack);
+
+            if (AudioStream* s = AudioStream::CreateInstance(t))
+                streams.push_back(s);
+        }
+    }
+
+    HRESULT hr = streams.empty() ? VFW_E_INVALID_FILE_FORMAT : S_OK;
+
+    typedef streams_t::size_type size_type;
+
+    for (size_type i = 0; SUCCEEDED(hr) && (i < streams.size()); ++i)
+    {
+        mkvparser::Stream* const pStream = streams[i];
+
+        if (i >= m_pools.size())
+        {
+            ALLOCATOR_PROPERTIES props;
+            memset(&props, 0, sizeof props);
+
+            pStream->UpdateAllocatorProperties(props);
+
+            MemSample::Pool* const pPool =
+                new (std::nothrow) MemSample::Pool(props.cbBuffer);
+            assert(pPool);
+
+            m_pools.push_back(pPool);
+        }
+
+        MemSample::Pool& pool = *m_pools[i];
+
+        mkvparser::Stream::samples_t samples;
+
+        for (;;)  //as webmsource's Outpin::PopulateSamples
+        {
+            long count;
+
+            for (;;)
+            {
+                hr = pStream->GetSampleCount(count);
+
+                if (hr != VFW_E_BUFFER_UNDERFLOW)
+                    break;
+
+                if (pSegment->LoadCluster() < 0)
+                {
+                    hr = E_FAIL;
+                    break;
+                }
+            }
+
+            if (hr != S_OK)  //EOS, or error
+                break;
+
+            for (long idx = 0; idx < count; ++idx)
+                samples.push_back(pool.GetSample());
+
+            for (;;)
+            {
+                hr = pStream->PopulateSamples(samples);
+
+                if (hr != VFW_E_BUFFER_UNDERFLOW)
+                    break;
+
+                if (pSegment->LoadCluster() < 0)
+                {
+                    hr = E_FAIL;
+                    break;
+                }
+            }
+
+            if (hr == S_OK)
+                frames += count;
+
+            mkvparser::Stream::Clear(samples);
+
+            if ((hr != S_OK) && (hr != 2))  //2 means try again
+                break;
+        }
+
+        if (hr == S_FALSE)  //EOS
+            hr = S_OK;
+
+        pStream->Stop();
+    }
+
+    while (!streams.empty())
+    {
+        delete streams.back();
+        streams.pop_back();
+    }
+
+    us = PipelineStats::GetMicroseconds() - start_us;
+
+    return hr;
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,49 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "memsample.h"
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Result;
+
+//Parses a file in memory with libwebm's mkvparser, and pulls every frame
+//of every track through the mkvparser::Stream classes into media
+//samples, the way the webmsource and webmsplit output pins do (but one
+//track after the other, on one thread).
+
+class DemuxBench
+{
+    DemuxBench(const DemuxBench&);
+    DemuxBench& operator=(const DemuxBench&);
+
+public:
+
+    DemuxBench(const BYTE* data, long long length);
+    ~DemuxBench();
+
+    //Returns S_OK, or an error if the file can't be parsed.
+    HRESULT Run(int runs, Result&);
+
+private:
+
+    const BYTE* const m_data;
+    const long long m_length;
+
+    //One pool per track, since each track asks for its own buffer size.
+    typedef std::vector<WebmUtil::MemSample::Pool*> pools_t;
+    pools_t m_pools;
+
+    HRESULT RunOnce(long long& frames, long long& us);
+
+};
+
+}  //end namespace WebmBench
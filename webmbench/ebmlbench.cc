@@ -0,0 +1,457 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "ebmlbench.h"
+#include "webmbench.h"
+#include "ebmlwriter.h"
+#include "pipelinestats.h"
+#include "webmconstants.h"
+#include <algorithm>
+#include <cassert>
+
+using WebmUtil::EbmlElementID;
+using WebmUtil::EbmlFloat;
+using WebmUtil::EbmlMaster;
+using WebmUtil::EbmlUInt;
+using WebmUtil::EbmlVarUInt;
+using WebmUtil::EbmlVoid;
+using WebmUtil::EbmlWriter;
+using WebmUtil::PipelineStats;
+
+namespace
+{
+
+//What the muxer writes for a 640x360, 30 fps VP8 stream, and a 44.1 kHz
+//stereo Vorbis stream.
+
+const uint32 kTimecodeScale = 1000000;
+const wchar_t kMuxingApp[] = L"webmmux-1.0.0.0";
+const wchar_t kWritingApp[] = L"webmbench";
+const uint16 kWidth = 640;
+const uint16 kHeight = 360;
+const float kFramerate = 30;
+const float kSampleRate = 44100;
+const uint8 kChannels = 2;
+
+//Clusters are about a second apart.
+const unsigned long kClusterInterval = 1000;
+
+
+uint64 GetTrackUID(int uid)
+{
+    return (static_cast<uint64>(uid) * 0x9E3779B97F4A7C15ULL) | 1;
+}
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+const char* EbmlBench::GetName(Element e)
+{
+    switch (e)
+    {
+        case kInfo:
+            return "info";
+
+        case kTracks:
+            return "tracks";
+
+        case kCluster:
+        default:
+            return "cluster";
+    }
+}
+
+
+EbmlBench::EbmlBench(int count) :
+    m_count(count)
+{
+    assert(m_count > 0);
+    m_file.SetStream(&m_stream);
+}
+
+
+EbmlBench::~EbmlBench()
+{
+    m_file.SetStream(0);
+}
+
+
+const std::vector<unsigned char>& EbmlBench::GetOutput() const
+{
+    return m_output;
+}
+
+
+void EbmlBench::Run(int runs, Element e, bool compiled, Result& result)
+{
+    assert(runs > 0);
+
+    RunOnce(e, compiled);  //warm-up: grows the buffer and the stream
+
+    std::vector<long long> times;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        AllocStats::Begin();
+        times.push_back(RunOnce(e, compiled));
+        AllocStats::Get(result.allocs);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    if (e == kCluster)
+    {
+        const BYTE* const data = m_stream.GetData();
+        m_output.assign(data, data + m_stream.GetLength());
+    }
+    else
+    {
+        const uint8* const data = m_buf.GetBufferPtr();
+        m_output.assign(data, data + m_buf.GetBufferLength());
+    }
+
+    result.bytes = static_cast<long long>(m_output.size());
+    result.frames = m_count;
+    result.best_us = times.front();
+    result.median_us = times[times.size() / 2];
+}
+
+
+long long EbmlBench::RunOnce(Element e, bool compiled)
+{
+    m_stream.Rewind();
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        switch (e)
+        {
+            case kInfo:
+                m_buf.Reset();
+
+                if (compiled)
+                    WriteInfo();
+                else
+                    WriteInfoOld();
+
+                break;
+
+            case kTracks:
+                m_buf.Reset();
+
+                if (compiled)
+                    WriteTracks(i);
+                else
+                    WriteTracksOld(i);
+
+                break;
+
+            case kCluster:
+            default:
+                if (compiled)
+                    WriteCluster(i * kClusterInterval);
+                else
+                    WriteClusterOld(i * kClusterInterval);
+
+                break;
+        }
+    }
+
+    return PipelineStats::GetMicroseconds() - start_us;
+}
+
+
+//What Context::InitInfo did before the EbmlWriter (except that the Void
+//element was filled with 0x0F, rather than 0; FinalInfo overwrites it).
+
+void EbmlBench::WriteInfoOld()
+{
+    m_buf.WriteID4(WebmUtil::kEbmlSegmentInfoID);
+
+    const uint64 size_pos = m_buf.GetBufferLength();
+    m_buf.Serialize2UInt(0);
+
+    const uint64 num_bytes_to_ignore = 4 + sizeof(uint16);
+
+    m_buf.WriteID3(WebmUtil::kEbmlTimeCodeScaleID);
+    m_buf.Write1UInt(4);
+    m_buf.Serialize4UInt(kTimecodeScale);
+
+    m_buf.WriteID1(WebmUtil::kEbmlVoidID);
+    m_buf.Write1UInt(5);
+
+    for (int32 i = 0; i < 5; ++i)
+        m_buf.Serialize1UInt(0);
+
+    m_buf.WriteID2(WebmUtil::kEbmlMuxingAppID);
+    m_buf.Write1UTF8(kMuxingApp);
+
+    m_buf.WriteID2(WebmUtil::kEbmlWritingAppID);
+    m_buf.Write1UTF8(kWritingApp);
+
+    const uint64 len = m_buf.GetBufferLength() - num_bytes_to_ignore;
+    m_buf.RewriteUInt(size_pos, len, sizeof(uint16));
+}
+
+
+//What Context::InitInfo does now.
+
+void EbmlBench::WriteInfo()
+{
+    typedef EbmlMaster<WebmUtil::kEbmlSegmentInfoID, 2> Info;
+    typedef EbmlUInt<WebmUtil::kEbmlTimeCodeScaleID, 4> TimecodeScale;
+    typedef EbmlVoid<5> DurationSpace;
+
+    enum
+    {
+        kLength = Info::kHeaderLength +
+                  TimecodeScale::kLength +
+                  DurationSpace::kLength
+    };
+
+    EbmlWriter w(m_buf.Append(kLength), kLength);
+
+    w.Begin<Info>();
+    w.Write<TimecodeScale>(kTimecodeScale);
+    w.WriteVoid<5>();
+
+    m_buf.WriteID2(WebmUtil::kEbmlMuxingAppID);
+    m_buf.Write1UTF8(kMuxingApp);
+
+    m_buf.WriteID2(WebmUtil::kEbmlWritingAppID);
+    m_buf.Write1UTF8(kWritingApp);
+
+    const uint64 size_pos =
+        EbmlElementID<WebmUtil::kEbmlSegmentInfoID>::kLength;
+
+    const uint64 len = m_buf.GetBufferLength() - Info::kHeaderLength;
+    m_buf.RewriteUInt(size_pos, len, sizeof(uint16));
+}
+
+
+//What Context::WriteTrack, and the WriteTrackEntry of StreamVideoVPx and
+//StreamAudioVorbis, did before the EbmlWriter (without the Vorbis
+//headers, which are copied in the same way by both).
+
+void EbmlBench::WriteTracksOld(int uid)
+{
+    m_buf.WriteID4(WebmUtil::kEbmlTracksID);
+
+    const uint64 tracks_len_offset = m_buf.GetBufferLength();
+    m_buf.Serialize2UInt(0);
+
+    for (int tn = 1; tn <= 2; ++tn)
+    {
+        const bool video = (tn == 1);
+
+        const uint64 entry_start_len = m_buf.GetBufferLength();
+
+        m_buf.WriteID1(WebmUtil::kEbmlTrackEntryID);
+
+        const uint64 entry_len_offset = m_buf.GetBufferLength();
+        m_buf.Serialize2UInt(0);
+
+        m_buf.WriteID1(WebmUtil::kEbmlTrackNumberID);
+        m_buf.Write1UInt(1);
+        m_buf.Serialize1UInt(static_cast<uint8>(tn));
+
+        m_buf.WriteID2(WebmUtil::kEbmlTrackUIDID);
+        m_buf.Write1UInt(8);
+        m_buf.Serialize8UInt(GetTrackUID(uid * 2 + tn));
+
+        m_buf.WriteID1(WebmUtil::kEbmlTrackTypeID);
+        m_buf.Write1UInt(1);
+        m_buf.Serialize1UInt(video ?
+                             WebmUtil::kEbmlTrackTypeVideo :
+                             WebmUtil::kEbmlTrackTypeAudio);
+
+        m_buf.WriteID1(WebmUtil::kEbmlCodecIDID);
+        m_buf.Write1String(video ? "V_VP8" : "A_VORBIS");
+
+        const uint64 settings_start_len = m_buf.GetBufferLength();
+
+        m_buf.WriteID1(video ?
+                       WebmUtil::kEbmlVideoSettingsID :
+                       WebmUtil::kEbmlAudioSettingsID);
+
+        const uint64 settings_len_offset = m_buf.GetBufferLength();
+        m_buf.Serialize2UInt(0);
+
+        if (video)
+        {
+            m_buf.WriteID1(WebmUtil::kEbmlVideoWidth);
+            m_buf.Write1UInt(2);
+            m_buf.Serialize2UInt(kWidth);
+
+            m_buf.WriteID1(WebmUtil::kEbmlVideoHeight);
+            m_buf.Write1UInt(2);
+            m_buf.Serialize2UInt(kHeight);
+
+            m_buf.WriteID3(WebmUtil::kEbmlVideoFrameRate);
+            m_buf.Write1UInt(4);
+            m_buf.Serialize4Float(kFramerate);
+        }
+        else
+        {
+            m_buf.WriteID1(WebmUtil::kEbmlSamplingFrequencyID);
+            m_buf.Write1UInt(4);
+            m_buf.Serialize4Float(kSampleRate);
+
+            m_buf.WriteID1(WebmUtil::kEbmlChannelsID);
+            m_buf.Write1UInt(1);
+            m_buf.Serialize1UInt(kChannels);
+        }
+
+        const uint64 settings_len = m_buf.GetBufferLength() -
+                                    (settings_start_len + 1 + sizeof(uint16));
+        m_buf.RewriteUInt(settings_len_offset, settings_len, sizeof(uint16));
+
+        const uint64 entry_len =
+            m_buf.GetBufferLength() - (entry_start_len + 1 + sizeof(uint16));
+        m_buf.RewriteUInt(entry_len_offset, entry_len, sizeof(uint16));
+    }
+
+    const uint64 tracks_len = m_buf.GetBufferLength() - (4 + sizeof(uint16));
+    m_buf.RewriteUInt(tracks_len_offset, tracks_len, sizeof(uint16));
+}
+
+
+//What they do now.
+
+void EbmlBench::WriteTracks(int uid)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlTracksID, 2> Tracks;
+    typedef EbmlMaster<WebmUtil::kEbmlTrackEntryID, 2> TrackEntry;
+    typedef EbmlUInt<WebmUtil::kEbmlTrackNumberID, 1> TrackNumber;
+    typedef EbmlUInt<WebmUtil::kEbmlTrackUIDID, 8> TrackUID;
+    typedef EbmlUInt<WebmUtil::kEbmlTrackTypeID, 1> TrackType;
+
+    //The sizes of the entries are patched in, after the ID.
+    typedef EbmlElementID<WebmUtil::kEbmlTrackEntryID> TrackEntryID;
+
+    Tracks::Store(m_buf.Append(Tracks::kHeaderLength));
+
+    for (int tn = 1; tn <= 2; ++tn)
+    {
+        const bool video = (tn == 1);
+
+        const uint64 entry_start_len = m_buf.GetBufferLength();
+
+        TrackEntry::Store(m_buf.Append(TrackEntry::kHeaderLength));
+
+        TrackNumber::Store(m_buf.Append(TrackNumber::kLength), tn);
+        TrackUID::Store(m_buf.Append(TrackUID::kLength),
+                        GetTrackUID(uid * 2 + tn));
+        TrackType::Store(m_buf.Append(TrackType::kLength),
+                         video ?
+                            WebmUtil::kEbmlTrackTypeVideo :
+                            WebmUtil::kEbmlTrackTypeAudio);
+
+        m_buf.WriteID1(WebmUtil::kEbmlCodecIDID);
+        m_buf.Write1String(video ? "V_VP8" : "A_VORBIS");
+
+        if (video)
+        {
+            typedef EbmlMaster<WebmUtil::kEbmlVideoSettingsID, 2> Video;
+            typedef EbmlUInt<WebmUtil::kEbmlVideoWidth, 2> Width;
+            typedef EbmlUInt<WebmUtil::kEbmlVideoHeight, 2> Height;
+            typedef EbmlFloat<WebmUtil::kEbmlVideoFrameRate> FrameRate;
+
+            enum
+            {
+                kLength = Video::kHeaderLength +
+                          Width::kLength +
+                          Height::kLength +
+                          FrameRate::kLength
+            };
+
+            EbmlWriter w(m_buf.Append(kLength), kLength);
+
+            uint8* const settings = w.Begin<Video>();
+            w.Write<Width>(kWidth);
+            w.Write<Height>(kHeight);
+            w.WriteFloat<FrameRate>(kFramerate);
+            w.End<Video>(settings);
+        }
+        else
+        {
+            typedef EbmlMaster<WebmUtil::kEbmlAudioSettingsID, 2> Audio;
+            typedef EbmlFloat<WebmUtil::kEbmlSamplingFrequencyID> Frequency;
+            typedef EbmlUInt<WebmUtil::kEbmlChannelsID, 1> Channels;
+
+            enum
+            {
+                kLength = Audio::kHeaderLength +
+                          Frequency::kLength +
+                          Channels::kLength
+            };
+
+            EbmlWriter w(m_buf.Append(kLength), kLength);
+
+            uint8* const settings = w.Begin<Audio>();
+            w.WriteFloat<Frequency>(kSampleRate);
+            w.Write<Channels>(kChannels);
+            w.End<Audio>(settings);
+        }
+
+        const uint64 entry_len = m_buf.GetBufferLength() -
+                                 (entry_start_len + TrackEntry::kHeaderLength);
+
+        m_buf.RewriteUInt(entry_start_len + TrackEntryID::kLength,
+                          entry_len,
+                          sizeof(uint16));
+    }
+
+    const uint64 tracks_len_offset =
+        EbmlElementID<WebmUtil::kEbmlTracksID>::kLength;
+
+    const uint64 tracks_len = m_buf.GetBufferLength() - Tracks::kHeaderLength;
+    m_buf.RewriteUInt(tracks_len_offset, tracks_len, sizeof(uint16));
+}
+
+
+//What Context::CreateNewCluster did before the EbmlWriter.
+
+void EbmlBench::WriteClusterOld(unsigned long timecode)
+{
+    m_file.WriteID4(WebmUtil::kEbmlClusterID);
+    m_file.Serialize4UInt(0x1FFFFFFF);
+
+    m_file.WriteID1(WebmUtil::kEbmlTimeCodeID);
+
+    const BYTE timecode_size = m_file.GetSerializeUIntSize(timecode);
+
+    m_file.Write1UInt(timecode_size);
+    m_file.SerializeUInt(timecode, timecode_size);
+}
+
+
+//What it does now (see WriteClusterHeader in webmmuxcontext.cc).
+
+void EbmlBench::WriteCluster(unsigned long timecode)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlClusterID, 4> ClusterHeader;
+    typedef EbmlVarUInt<WebmUtil::kEbmlTimeCodeID> Timecode;
+
+    const BYTE timecode_size = m_file.GetSerializeUIntSize(timecode);
+
+    uint8 buf[ClusterHeader::kHeaderLength + Timecode::kMaxLength];
+    EbmlWriter w(buf, sizeof(buf));
+
+    w.Begin<ClusterHeader>();
+    w.WriteVarUInt<WebmUtil::kEbmlTimeCodeID>(timecode, timecode_size);
+
+    m_file.Write(buf, w.GetLength());
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,74 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "memstream.h"
+#include "scratchbuf.h"
+#include "webmmuxebmlio.h"
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Result;
+
+//Measures the serialization of the EBML headers that the muxer writes
+//itself: the Info and Tracks elements (into the context's scratch
+//buffer), and the headers of clusters (into the file, which here is a
+//stream in memory).  Each is written over and over, with the same values
+//that WebmMuxLib::Context and its streams would use.
+//
+//The compile-time element types of common/ebmlwriter.h are compared with
+//the path they replaced: an EbmlScratchBuf or EbmlIO::File call per ID,
+//size and value, with the sizes of the masters patched in afterwards.
+
+class EbmlBench
+{
+    EbmlBench(const EbmlBench&);
+    EbmlBench& operator=(const EbmlBench&);
+
+public:
+
+    enum Element
+    {
+        kInfo,
+        kTracks,  //a VP8 and a Vorbis track
+        kCluster
+    };
+
+    static const char* GetName(Element);
+
+    explicit EbmlBench(int count);  //elements per run
+    ~EbmlBench();
+
+    void Run(int runs, Element, bool compiled, Result&);
+
+    //What the last run wrote: the last Info or Tracks element, or all the
+    //cluster headers.
+    const std::vector<unsigned char>& GetOutput() const;
+
+private:
+
+    const int m_count;
+    WebmUtil::EbmlScratchBuf m_buf;
+    MemStream m_stream;
+    EbmlIO::File m_file;
+    std::vector<unsigned char> m_output;
+
+    long long RunOnce(Element, bool compiled);  //returns elapsed microseconds
+
+    void WriteInfoOld();
+    void WriteInfo();
+    void WriteTracksOld(int uid);
+    void WriteTracks(int uid);
+    void WriteClusterOld(unsigned long timecode);
+    void WriteCluster(unsigned long timecode);
+
+};
+
+}  //end namespace WebmBench
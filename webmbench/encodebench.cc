@@ -0,0 +1,256 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "encodebench.h"
+#include "webmbench.h"
+#include "pipelinestats.h"
+#include "vorbisencodepipeline.h"
+#include "vorbis/vorbisenc.h"
+#include "vorbis/codec.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using WebmUtil::PipelineStats;
+using WebmUtil::VorbisEncodePipeline;
+
+namespace
+{
+
+//The quality that the filter asks for (see Inpin::ReceiveConnection).
+const float kQuality = 1.0f;
+
+
+void Consume(
+    VorbisEncodePipeline::packets_t& packets,
+    long long& bytes,
+    unsigned int& digest)
+{
+    while (!packets.empty())
+    {
+        const VorbisEncodePipeline::Packet& p = packets.front();
+
+        bytes += p.data.size();
+
+        for (size_t i = 0; i < p.data.size(); ++i)
+            digest = (digest ^ p.data[i]) * 16777619u;  //FNV-1a
+
+        digest = (digest ^ static_cast<unsigned int>(p.granulepos)) *
+                 16777619u;
+
+        packets.pop_front();
+    }
+}
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+EncodeBench::EncodeBench(
+    int sample_rate,
+    int channels,
+    int seconds,
+    int chunk) :
+    m_sample_rate(sample_rate),
+    m_channels(channels),
+    m_chunk(chunk),
+    m_frames(static_cast<long long>(sample_rate) * seconds),
+    m_pcm(static_cast<size_t>(sample_rate) * channels)
+{
+    //A chord that is different in each channel, with noise, and a
+    //percussive burst four times a second, so that the encoder switches
+    //between long and short blocks.
+
+    unsigned int x = 1;
+
+    for (int i = 0; i < sample_rate; ++i)
+    {
+        const int beat = i % (sample_rate / 4);
+        const float burst = (beat < 256) ? float(256 - beat) / 256 : 0;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            x = x * 1103515245 + 12345;
+            const float noise = float(int(x >> 16) % 2000 - 1000) / 1000;
+
+            const double t = double(i) / sample_rate;
+            const double f = 110 * (c + 2);
+
+            const double tone =
+                0.2 * sin(2 * 3.14159265358979 * f * t) +
+                0.1 * sin(2 * 3.14159265358979 * 1.5 * f * t);
+
+            m_pcm[i * channels + c] =
+                float(tone) + (0.02f + 0.5f * burst) * noise;
+        }
+    }
+}
+
+
+EncodeBench::~EncodeBench()
+{
+}
+
+
+bool EncodeBench::Run(
+    int runs,
+    bool threaded,
+    Result& result,
+    Times& t)
+{
+    assert(runs > 0);
+
+    long long wall_us, caller_us, bytes;
+    unsigned int digest;
+
+    if (!RunOnce(threaded, wall_us, caller_us, bytes, digest))  //warm-up
+        return false;
+
+    std::vector<long long> times;
+    long long best_us = -1;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        AllocStats::Begin();
+
+        if (!RunOnce(threaded, wall_us, caller_us, bytes, digest))
+            return false;
+
+        AllocStats::Get(result.allocs);
+
+        times.push_back(wall_us);
+
+        if ((best_us < 0) || (wall_us < best_us))
+        {
+            best_us = wall_us;
+            t.caller_us = caller_us;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+
+    result.bytes = bytes;
+    result.frames = m_frames;
+    result.best_us = times.front();
+    result.median_us = times[times.size() / 2];
+
+    t.digest = digest;
+
+    return true;
+}
+
+
+bool EncodeBench::RunOnce(
+    bool threaded,
+    long long& wall_us,
+    long long& caller_us,
+    long long& bytes,
+    unsigned int& digest)
+{
+    //The same setup as the filter's, when its input pin connects.
+
+    vorbis_info info;
+    vorbis_info_init(&info);
+
+    if (vorbis_encode_init_vbr(&info, m_channels, m_sample_rate, kQuality))
+    {
+        vorbis_info_clear(&info);
+        return false;
+    }
+
+    vorbis_dsp_state dsp;
+    int status = vorbis_analysis_init(&dsp, &info);
+    assert(status == 0);
+
+    vorbis_comment comment;
+    vorbis_comment_init(&comment);
+
+    ogg_packet ident, comment_pkt, code;
+
+    status = vorbis_analysis_headerout(
+                &dsp,
+                &comment,
+                &ident,
+                &comment_pkt,
+                &code);
+    assert(status == 0);
+
+    vorbis_block block;
+    status = vorbis_block_init(&dsp, &block);
+    assert(status == 0);
+
+    VorbisEncodePipeline pipeline;
+
+    bool ok = pipeline.Start(&dsp,
+                             &block,
+                             m_channels,
+                             threaded,
+                             m_sample_rate / 2,  //as the filter does
+                             0);
+
+    VorbisEncodePipeline::packets_t packets;
+
+    bytes = 0;
+    digest = 2166136261u;
+    caller_us = 0;
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    for (long long pos = 0; ok && (pos < m_frames); )
+    {
+        //The clip is the one second of PCM, over and over.
+
+        const long offset = static_cast<long>(pos % m_sample_rate);
+
+        long n = m_chunk;
+
+        if (n > m_sample_rate - offset)
+            n = m_sample_rate - offset;
+
+        if (n > m_frames - pos)
+            n = static_cast<long>(m_frames - pos);
+
+        const long long t0 = PipelineStats::GetMicroseconds();
+
+        ok = pipeline.Write(&m_pcm[offset * m_channels], n) &&
+             pipeline.Read(packets, false);
+
+        caller_us += PipelineStats::GetMicroseconds() - t0;
+
+        Consume(packets, bytes, digest);
+
+        pos += n;
+    }
+
+    if (ok)
+    {
+        const long long t0 = PipelineStats::GetMicroseconds();
+
+        ok = pipeline.WriteEnd() && pipeline.Read(packets, true);
+
+        caller_us += PipelineStats::GetMicroseconds() - t0;
+
+        Consume(packets, bytes, digest);
+    }
+
+    wall_us = PipelineStats::GetMicroseconds() - start_us;
+
+    pipeline.Stop();
+
+    vorbis_block_clear(&block);
+    vorbis_dsp_clear(&dsp);
+    vorbis_comment_clear(&comment);
+    vorbis_info_clear(&info);
+
+    return ok;
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,63 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Result;
+
+//Measures the Vorbis encoder filter's analysis stage, through the
+//pipeline that it uses (common/vorbisencodepipeline.cc), with and without
+//the pipeline's worker thread.  The PCM is synthetic, and is delivered in
+//chunks the size of an audio packet, as a capture source would deliver
+//it to the filter; this needs libvorbis (see build.sh).
+//
+//Besides the time the whole encode takes, it measures how long the
+//delivering thread spends in the pipeline (its calls to Write and Read),
+//which is the time that it isn't free to do its own work upstream, and
+//it checks that the packets are the same both ways.
+
+class EncodeBench
+{
+    EncodeBench(const EncodeBench&);
+    EncodeBench& operator=(const EncodeBench&);
+
+public:
+
+    EncodeBench(int sample_rate, int channels, int seconds, int chunk);
+    ~EncodeBench();
+
+    struct Times
+    {
+        long long caller_us;   //in the delivering thread, in the best run
+        unsigned int digest;   //of the packets
+    };
+
+    //Returns false if libvorbis can't encode this format.
+    bool Run(int runs, bool threaded, Result&, Times&);
+
+private:
+
+    const int m_sample_rate;
+    const int m_channels;
+    const int m_chunk;
+    const long long m_frames;  //the length of the clip
+    std::vector<float> m_pcm;  //one second, interleaved
+
+    bool RunOnce(bool threaded,
+                 long long& wall_us,
+                 long long& caller_us,
+                 long long& bytes,
+                 unsigned int& digest);
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,186 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "memstream.h"
+#include <cassert>
+#include <cstring>
+
+namespace WebmBench
+{
+
+MemStream::MemStream() :
+    m_cRef(1),
+    m_length(0),
+    m_pos(0)
+{
+}
+
+
+MemStream::~MemStream()
+{
+    assert(m_cRef == 1);  //the benchmark's own reference
+}
+
+
+void MemStream::Rewind()
+{
+    m_length = 0;
+    m_pos = 0;
+}
+
+
+const BYTE* MemStream::GetData() const
+{
+    return m_buf.empty() ? 0 : &m_buf[0];
+}
+
+
+LONGLONG MemStream::GetLength() const
+{
+    return m_length;
+}
+
+
+HRESULT MemStream::QueryInterface(REFIID iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = static_cast<IStream*>(this);
+
+    else if (iid == __uuidof(ISequentialStream))
+        pUnk = static_cast<ISequentialStream*>(this);
+
+    else if (iid == __uuidof(IStream))
+        pUnk = static_cast<IStream*>(this);
+
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG MemStream::AddRef()
+{
+    return ++m_cRef;
+}
+
+
+ULONG MemStream::Release()
+{
+    assert(m_cRef > 1);  //owned by the benchmark, not by its clients
+    return --m_cRef;
+}
+
+
+HRESULT MemStream::Read(void* buf, ULONG cb, ULONG* pcbRead)
+{
+    assert(buf || (cb == 0));
+
+    LONGLONG n = m_length - m_pos;
+
+    if (n < 0)
+        n = 0;
+    else if (n > cb)
+        n = cb;
+
+    if (n > 0)
+        memcpy(buf, &m_buf[0] + m_pos, static_cast<size_t>(n));
+
+    m_pos += n;
+
+    if (pcbRead)
+        *pcbRead = static_cast<ULONG>(n);
+
+    return (n < cb) ? S_FALSE : S_OK;
+}
+
+
+HRESULT MemStream::Write(const void* buf, ULONG cb, ULONG* pcbWritten)
+{
+    assert(buf || (cb == 0));
+
+    const LONGLONG end = m_pos + cb;
+
+    if (end > LONGLONG(m_buf.size()))
+        m_buf.resize(static_cast<size_t>(end));
+
+    if (cb > 0)
+        memcpy(&m_buf[0] + m_pos, buf, cb);
+
+    m_pos = end;
+
+    if (end > m_length)
+        m_length = end;
+
+    if (pcbWritten)
+        *pcbWritten = cb;
+
+    return S_OK;
+}
+
+
+HRESULT MemStream::Seek(
+    LARGE_INTEGER move,
+    DWORD origin,
+    ULARGE_INTEGER* pnewpos)
+{
+    LONGLONG pos;
+
+    switch (origin)
+    {
+        case STREAM_SEEK_SET:
+            pos = move.QuadPart;
+            break;
+
+        case STREAM_SEEK_CUR:
+            pos = m_pos + move.QuadPart;
+            break;
+
+        case STREAM_SEEK_END:
+            pos = m_length + move.QuadPart;
+            break;
+
+        default:
+            return STG_E_INVALIDFUNCTION;
+    }
+
+    if (pos < 0)
+        return STG_E_INVALIDFUNCTION;
+
+    m_pos = pos;  //can be past the end, as for a file
+
+    if (pnewpos)
+        pnewpos->QuadPart = pos;
+
+    return S_OK;
+}
+
+
+HRESULT MemStream::SetSize(ULARGE_INTEGER size)
+{
+    const LONGLONG len = static_cast<LONGLONG>(size.QuadPart);
+
+    if (len > LONGLONG(m_buf.size()))
+        m_buf.resize(static_cast<size_t>(len));
+
+    m_length = len;
+
+    return S_OK;
+}
+
+}  //end namespace WebmBench
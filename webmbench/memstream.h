@@ -0,0 +1,58 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <vector>
+
+namespace WebmBench
+{
+
+//The file that the muxer writes.  The stream is kept in memory, so that
+//the benchmark measures the muxer and not the disk.  The buffer keeps its
+//capacity when the stream is rewound, so that only the first run pays for
+//growing it.
+
+class MemStream : public IStream
+{
+    MemStream(const MemStream&);
+    MemStream& operator=(const MemStream&);
+
+public:
+
+    MemStream();
+    virtual ~MemStream();
+
+    void Rewind();  //empties the stream
+
+    const BYTE* GetData() const;
+    LONGLONG GetLength() const;
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+    HRESULT STDMETHODCALLTYPE Read(void*, ULONG, ULONG*);
+    HRESULT STDMETHODCALLTYPE Write(const void*, ULONG, ULONG*);
+
+    HRESULT STDMETHODCALLTYPE Seek(
+        LARGE_INTEGER,
+        DWORD,
+        ULARGE_INTEGER*);
+
+    HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER);
+
+private:
+
+    ULONG m_cRef;
+    std::vector<BYTE> m_buf;
+    LONGLONG m_length;
+    LONGLONG m_pos;
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,167 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "muxbench.h"
+#include "synthmedia.h"
+#include "webmbench.h"
+#include "pipelinestats.h"
+#include "webmmuxcontext.h"
+#include "webmmuxstreamvideovpx.h"
+#include "webmmuxstreamaudiovorbis.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <vector>
+
+using WebmUtil::MemSample;
+using WebmUtil::PipelineStats;
+
+namespace WebmBench
+{
+
+MuxBench::MuxBench(const SynthMedia& media) :
+    m_media(media),
+    m_video_pool(std::max<long>(media.GetMaxVideoBytes(), 1)),
+    m_audio_pool(std::max<long>(media.GetMaxAudioBytes(), 1))
+{
+}
+
+
+MuxBench::~MuxBench()
+{
+}
+
+
+const MemStream& MuxBench::GetFile() const
+{
+    return m_file;
+}
+
+
+void MuxBench::Run(int runs, Result& result)
+{
+    assert(runs > 0);
+
+    RunOnce();  //warm-up: grows the sample pools and the file buffer
+
+    std::vector<long long> times;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        AllocStats::Begin();
+        times.push_back(RunOnce());
+        AllocStats::Get(result.allocs);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    result.bytes = m_file.GetLength();
+    result.frames = static_cast<long long>(m_media.GetPackets().size());
+    result.best_us = times.front();
+    result.median_us = times[times.size() / 2];
+}
+
+
+long long MuxBench::RunOnce()
+{
+    using namespace WebmMuxLib;
+
+    m_file.Rewind();
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    Context ctx;
+
+    StreamVideo* pVideo = 0;
+    StreamAudio* pAudio = 0;
+
+    if (m_media.HasVideo())
+    {
+        const AM_MEDIA_TYPE& mt = m_media.GetVideoType();
+
+        pVideo = new (std::nothrow) StreamVideoVPx(ctx, mt);
+        assert(pVideo);
+
+        ctx.SetVideoStream(pVideo);
+    }
+
+    if (m_media.HasAudio())
+    {
+        const AM_MEDIA_TYPE& mt = m_media.GetAudioType();
+
+        pAudio = StreamAudioVorbis::CreateStream(ctx, mt);
+        assert(pAudio);
+
+        ctx.SetAudioStream(pAudio);
+    }
+
+    ctx.Open(&m_file);
+
+    const SynthMedia::packets_t& packets = m_media.GetPackets();
+
+    typedef SynthMedia::packets_t::const_iterator iter_t;
+
+    for (iter_t i = packets.begin(); i != packets.end(); ++i)
+    {
+        const SynthMedia::Packet& p = *i;
+
+        MemSample::Pool& pool = p.video ? m_video_pool : m_audio_pool;
+        MemSample* const pSample = pool.GetSample();
+
+        BYTE* buf;
+
+        HRESULT hr = pSample->GetPointer(&buf);
+        assert(SUCCEEDED(hr));
+
+        if (p.video)
+            m_media.WriteFrameHeader(p, buf);
+
+        REFERENCE_TIME start = p.start;
+        REFERENCE_TIME stop = p.stop;
+
+        hr = pSample->SetTime(&start, &stop);
+        assert(SUCCEEDED(hr));
+
+        hr = pSample->SetSyncPoint(p.key ? TRUE : FALSE);
+        assert(SUCCEEDED(hr));
+
+        hr = pSample->SetActualDataLength(p.size);
+        assert(SUCCEEDED(hr));
+
+        Stream* const pStream = p.video ?
+                                static_cast<Stream*>(pVideo) :
+                                static_cast<Stream*>(pAudio);
+
+        hr = pStream->Receive(pSample);
+        assert(hr == S_OK);
+        (void)hr;  //only checked by the asserts
+
+        pSample->Release();  //the muxer keeps its own reference
+    }
+
+    if (pVideo)
+        pVideo->EndOfStream();
+
+    if (pAudio)
+        pAudio->EndOfStream();
+
+    ctx.Close();
+
+    const long long stop_us = PipelineStats::GetMicroseconds();
+
+    ctx.SetVideoStream(0);
+    ctx.SetAudioStream(0);
+
+    delete static_cast<Stream*>(pVideo);
+    delete static_cast<Stream*>(pAudio);
+
+    return stop_us - start_us;
+}
+
+}  //end namespace WebmBench
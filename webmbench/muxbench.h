@@ -0,0 +1,49 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "memsample.h"
+#include "memstream.h"
+
+namespace WebmBench
+{
+
+class SynthMedia;
+struct Result;
+
+//Muxes the synthetic packets with WebmMuxLib::Context, the way the
+//webmmux filter does (but on one thread, in timestamp order), into a
+//stream in memory.
+
+class MuxBench
+{
+    MuxBench(const MuxBench&);
+    MuxBench& operator=(const MuxBench&);
+
+public:
+
+    explicit MuxBench(const SynthMedia&);
+    ~MuxBench();
+
+    void Run(int runs, Result&);
+
+    //The file written by the last run.
+    const MemStream& GetFile() const;
+
+private:
+
+    const SynthMedia& m_media;
+    MemStream m_file;
+    WebmUtil::MemSample::Pool m_video_pool;
+    WebmUtil::MemSample::Pool m_audio_pool;
+
+    long long RunOnce();  //returns elapsed microseconds
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,278 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include "renderbench.h"
+#include "webmbench.h"
+#include "pipelinestats.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using WebmUtil::PipelineStats;
+namespace VorbisOutput = WebmMfVorbisDecLib::VorbisOutput;
+
+namespace
+{
+
+//Frames that libvorbis returns per packet, for a 2048-sample window.
+const int kBlockFrames = 1024;
+
+//The WAVE order of the Vorbis planes (see VorbisDecoder::GetChannelMask).
+const int kWaveOrder[9][8] =
+{
+    { 0 },
+    { 0 },
+    { 0, 1 },
+    { 0, 2, 1 },
+    { 0, 1, 2, 3 },
+    { 0, 2, 1, 3, 4 },
+    { 0, 2, 1, 5, 3, 4 },
+    { 0, 2, 1, 6, 5, 3, 4 },
+    { 0, 2, 1, 7, 5, 6, 3, 4 }
+};
+
+
+short ToShort(float x)
+{
+    int val = static_cast<int>(floor(x * 32767.f + .5f));
+
+    if (val > 32767)
+        val = 32767;
+    else if (val < -32768)
+        val = -32768;
+
+    return static_cast<short>(val);
+}
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+RenderBench::RenderBench(int sample_rate, int seconds) :
+    m_frames(static_cast<long long>(sample_rate) * seconds),
+    m_planes(8, std::vector<float>(sample_rate + kBlockFrames))
+{
+    //A different tone in each channel, at about -6 dBFS, with a little
+    //noise so that the values aren't too regular.
+
+    unsigned int x = 1;
+
+    for (int c = 0; c < 8; ++c)
+    {
+        std::vector<float>& p = m_planes[c];
+        const double w = 2 * 3.14159265358979 * (220 * (c + 1)) / sample_rate;
+
+        for (size_t i = 0; i < p.size(); ++i)
+        {
+            x = x * 1103515245 + 12345;
+            const float noise = float(int(x >> 16) % 1000) / 100000;
+
+            p[i] = float(0.5 * sin(w * double(i))) + noise;
+        }
+
+        m_ptrs.push_back(&p[0]);
+    }
+
+    m_out.resize(kBlockFrames * 8 * sizeof(float));
+    m_interleaved.reserve(kBlockFrames * 8);
+}
+
+
+RenderBench::~RenderBench()
+{
+}
+
+
+bool RenderBench::Run(
+    int runs,
+    int channels_in,
+    int channels_out,
+    SampleFormat format,
+    bool fused,
+    Result& result)
+{
+    assert(runs > 0);
+
+    if (VorbisOutput::GetRenderer(channels_in, channels_out, format) == 0)
+        return false;
+
+    RunOnce(channels_in, channels_out, format, fused);  //warm-up
+
+    std::vector<long long> times;
+
+    for (int i = 0; i < runs; ++i)
+    {
+        AllocStats::Begin();
+        times.push_back(RunOnce(channels_in, channels_out, format, fused));
+        AllocStats::Get(result.allocs);
+    }
+
+    std::sort(times.begin(), times.end());
+
+    const int sample_size = VorbisOutput::GetSampleSize(format);
+
+    result.bytes = m_frames * channels_out * sample_size;
+    result.frames = m_frames;
+    result.best_us = times.front();
+    result.median_us = times[times.size() / 2];
+
+    return true;
+}
+
+
+long long RenderBench::RunOnce(
+    int channels_in,
+    int channels_out,
+    SampleFormat format,
+    bool fused)
+{
+    const VorbisOutput::Renderer render =
+        VorbisOutput::GetRenderer(channels_in, channels_out, format);
+    assert(render);
+
+    const int period = static_cast<int>(m_planes[0].size()) - kBlockFrames;
+
+    const long long start_us = PipelineStats::GetMicroseconds();
+
+    int offset = 0;
+
+    for (long long done = 0; done < m_frames; done += kBlockFrames)
+    {
+        const int frames =
+            static_cast<int>(std::min<long long>(kBlockFrames,
+                                                 m_frames - done));
+
+        if (fused)
+            render(&m_ptrs[0], channels_in, offset, frames, &m_out[0]);
+        else
+            RenderOld(channels_in, channels_out, format, offset, frames);
+
+        offset += frames;
+
+        if (offset >= period)
+            offset -= period;
+    }
+
+    return PipelineStats::GetMicroseconds() - start_us;
+}
+
+
+//What VorbisDecoder::ReorderAndInterleave_ and
+//WebmMfVorbisDec::PostProcessSamples did before the renderers.
+
+void RenderBench::RenderOld(
+    int channels_in,
+    int channels_out,
+    SampleFormat format,
+    int offset,
+    int frames)
+{
+    const int* const order = kWaveOrder[channels_in];
+
+    for (int i = offset; i < offset + frames; ++i)
+    {
+        for (int c = 0; c < channels_in; ++c)
+            m_interleaved.push_back(m_ptrs[order[c]][i]);
+    }
+
+    const float* src = &m_interleaved[0];
+    float* dstfl = reinterpret_cast<float*>(&m_out[0]);
+    short* dst16 = reinterpret_cast<short*>(&m_out[0]);
+
+    const bool convert_to_short = (format == VorbisOutput::kInt16);
+
+    if (channels_out == channels_in)
+    {
+        const int n = frames * channels_in;
+
+        if (convert_to_short)
+        {
+            for (int i = 0; i < n; ++i)
+                *dst16++ = ToShort(src[i]);
+        }
+        else
+            memcpy(dstfl, src, n * sizeof(float));
+    }
+    else if (channels_out == 6)
+    {
+        for (int i = 0; i < frames; ++i)
+        {
+            for (int c = 0; c < 6; ++c)
+            {
+                if (convert_to_short)
+                    *dst16++ = ToShort(src[c]);
+                else
+                    *dstfl++ = src[c];
+            }
+
+            src += channels_in;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < frames; ++i)
+        {
+            float left = 0.0f;
+            float right = 0.0f;
+
+            switch (channels_in)
+            {
+            case 8:
+                left = src[0] + src[3] + src[2] * 0.7f
+                    + src[4] * 0.7f + src[6] * 0.7f;
+                right = src[1] + src[3] + src[2] * 0.7f
+                    + src[5] * 0.7f + src[7] * 0.7f;
+                break;
+            case 7:
+                left = src[0] + src[3] + src[2] * 0.7f
+                    + src[4] * 0.7f + src[6] * 0.7f;
+                right = src[1] + src[3] + src[2] * 0.7f
+                    + src[5] * 0.7f + src[6] * 0.7f;
+                break;
+            case 6:
+                left = src[0] + src[3] + src[2] * 0.7f + src[4] * 0.7f;
+                right = src[1] + src[3] + src[2] * 0.7f + src[5] * 0.7f;
+                break;
+            case 5:
+                left = src[0] + src[2] * 0.7f + src[3] * 0.7f;
+                right = src[1] + src[2] * 0.7f + src[4] * 0.7f;
+                break;
+            case 4:
+                left = src[0] + src[2] * 0.7f + src[3] * 0.7f;
+                right = src[1] + src[2] * 0.7f + src[3] * 0.7f;
+                break;
+            case 3:
+                left = src[0] + src[2] * 0.7f;
+                right = src[1] + src[2] * 0.7f;
+                break;
+            }
+
+            src += channels_in;
+
+            if (convert_to_short)
+            {
+                *dst16++ = ToShort(left);
+                *dst16++ = ToShort(right);
+            }
+            else
+            {
+                *dstfl++ = left;
+                *dstfl++ = right;
+            }
+        }
+    }
+
+    //The decoder erased what was consumed from the front of the vector.
+    m_interleaved.erase(m_interleaved.begin(), m_interleaved.end());
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,62 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "vorbisoutput.h"
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Result;
+
+//Measures the output stage of the Vorbis decoder MFT: rendering the float
+//planes that libvorbis returns into the interleaved buffer of a media
+//sample, for one combination of channels and sample format.  The planes
+//are synthetic (libvorbis isn't needed), and are rendered in blocks the
+//size of a long Vorbis window.
+//
+//The fused renderers in common/vorbisoutput.cc are compared with the path
+//they replaced: reorder and interleave into a vector, then downmix and
+//convert in a second pass.
+
+class RenderBench
+{
+    RenderBench(const RenderBench&);
+    RenderBench& operator=(const RenderBench&);
+
+public:
+
+    typedef WebmMfVorbisDecLib::VorbisOutput::SampleFormat SampleFormat;
+
+    RenderBench(int sample_rate, int seconds);
+    ~RenderBench();
+
+    //Returns false if the combination isn't supported.
+    bool Run(
+        int runs,
+        int channels_in,
+        int channels_out,
+        SampleFormat,
+        bool fused,
+        Result&);
+
+private:
+
+    const long long m_frames;  //the length of the clip
+    std::vector<std::vector<float> > m_planes;  //one second, all channels
+    std::vector<const float*> m_ptrs;
+    std::vector<char> m_out;
+    std::vector<float> m_interleaved;  //for the old path
+
+    long long RunOnce(int, int, SampleFormat, bool fused);
+    void RenderOld(int, int, SampleFormat, int offset, int frames);
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,349 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#include <strmif.h>
+#include <amvideo.h>
+#include <uuids.h>
+#include "synthmedia.h"
+#include "webmbench.h"
+#include "webmtypes.h"
+#include "vorbistypes.h"
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+
+enum
+{
+    kMinPacket = 16,     //holds a VP8 frame header
+    kKeyframeScale = 4,  //a keyframe is this much larger than a delta
+    kSetupHeader = 3400  //typical size of a Vorbis setup header
+};
+
+
+//Varies the packet sizes by up to +/-25%, the same way on every run.
+
+class Jitter
+{
+public:
+
+    Jitter() : m_x(0x2545F491)
+    {
+    }
+
+    long operator()(long size)
+    {
+        m_x = m_x * 1103515245 + 12345;
+        const long r = static_cast<long>((m_x >> 16) & 0x7FFF);  //0..32767
+
+        const long long delta = (static_cast<long long>(size) / 2) * r / 32767;
+        const long result = static_cast<long>(size - size / 4 + delta);
+
+        return std::max<long>(result, kMinPacket);
+    }
+
+private:
+
+    unsigned int m_x;
+
+};
+
+
+bool EarlierPacket(
+    const WebmBench::SynthMedia::Packet& lhs,
+    const WebmBench::SynthMedia::Packet& rhs)
+{
+    if (lhs.start < rhs.start)
+        return true;
+
+    if (lhs.start > rhs.start)
+        return false;
+
+    return (lhs.video && !rhs.video);  //video first, as the muxer prefers
+}
+
+
+void Append(std::vector<BYTE>& v, const void* p, size_t n)
+{
+    const BYTE* const b = static_cast<const BYTE*>(p);
+    v.insert(v.end(), b, b + n);
+}
+
+
+void AppendUInt32(std::vector<BYTE>& v, DWORD x)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        v.push_back(static_cast<BYTE>(x));
+        x >>= 8;
+    }
+}
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+SynthMedia::SynthMedia(const Options& options) :
+    m_options(options),
+    m_payload(0),
+    m_max_video(0),
+    m_max_audio(0)
+{
+    memset(&m_vmt, 0, sizeof m_vmt);
+    memset(&m_amt, 0, sizeof m_amt);
+
+    InitVideoType();
+    InitAudioType();
+    InitPackets();
+}
+
+
+SynthMedia::~SynthMedia()
+{
+}
+
+
+bool SynthMedia::HasVideo() const
+{
+    return m_options.video;
+}
+
+
+bool SynthMedia::HasAudio() const
+{
+    return m_options.audio;
+}
+
+
+const SynthMedia::packets_t& SynthMedia::GetPackets() const
+{
+    return m_packets;
+}
+
+
+long long SynthMedia::GetPayloadBytes() const
+{
+    return m_payload;
+}
+
+
+long SynthMedia::GetMaxVideoBytes() const
+{
+    return m_max_video;
+}
+
+
+long SynthMedia::GetMaxAudioBytes() const
+{
+    return m_max_audio;
+}
+
+
+const AM_MEDIA_TYPE& SynthMedia::GetVideoType() const
+{
+    return m_vmt;
+}
+
+
+const AM_MEDIA_TYPE& SynthMedia::GetAudioType() const
+{
+    return m_amt;
+}
+
+
+void SynthMedia::InitVideoType()
+{
+    const Options& o = m_options;
+
+    m_vfmt.resize(sizeof(VIDEOINFOHEADER));
+
+    VIDEOINFOHEADER& vih = (VIDEOINFOHEADER&)(m_vfmt[0]);
+
+    vih.AvgTimePerFrame = static_cast<REFERENCE_TIME>(10000000 / o.fps);
+
+    BITMAPINFOHEADER& bmih = vih.bmiHeader;
+
+    bmih.biSize = sizeof(BITMAPINFOHEADER);
+    bmih.biWidth = o.width;
+    bmih.biHeight = o.height;
+    bmih.biPlanes = 1;
+    bmih.biCompression = WebmTypes::MEDIASUBTYPE_VP80.Data1;
+
+    m_vmt.majortype = MEDIATYPE_Video;
+    m_vmt.subtype = WebmTypes::MEDIASUBTYPE_VP80;
+    m_vmt.bTemporalCompression = TRUE;
+    m_vmt.formattype = FORMAT_VideoInfo;
+    m_vmt.cbFormat = static_cast<ULONG>(m_vfmt.size());
+    m_vmt.pbFormat = &m_vfmt[0];
+}
+
+
+void SynthMedia::InitAudioType()
+{
+    const Options& o = m_options;
+
+    //The three Vorbis headers are only checked for their type bytes and
+    //lengths, by the muxer and the parser both.
+
+    std::vector<BYTE> ident;
+
+    Append(ident, "\x01vorbis", 7);
+    AppendUInt32(ident, 0);  //version
+    ident.push_back(static_cast<BYTE>(o.channels));
+    AppendUInt32(ident, o.sample_rate);
+    AppendUInt32(ident, 0);  //bitrate maximum
+    AppendUInt32(ident, o.audio_bytes * 8 * o.sample_rate / o.audio_frame);
+    AppendUInt32(ident, 0);  //bitrate minimum
+    ident.push_back(0xB8);   //block sizes 256 and 2048
+    ident.push_back(1);      //framing
+    assert(ident.size() == 30);
+
+    static const char vendor[] = "webmbench";
+
+    std::vector<BYTE> comment;
+
+    Append(comment, "\x03vorbis", 7);
+    AppendUInt32(comment, sizeof vendor - 1);
+    Append(comment, vendor, sizeof vendor - 1);
+    AppendUInt32(comment, 0);  //no user comments
+    comment.push_back(1);      //framing
+
+    std::vector<BYTE> setup;
+
+    Append(setup, "\x05vorbis", 7);
+    setup.resize(kSetupHeader, 0x5A);
+
+    using VorbisTypes::VORBISFORMAT2;
+
+    m_afmt.resize(sizeof(VORBISFORMAT2));
+
+    VORBISFORMAT2& fmt = (VORBISFORMAT2&)(m_afmt[0]);
+
+    fmt.channels = o.channels;
+    fmt.samplesPerSec = o.sample_rate;
+    fmt.bitsPerSample = 0;
+    fmt.headerSize[0] = static_cast<DWORD>(ident.size());
+    fmt.headerSize[1] = static_cast<DWORD>(comment.size());
+    fmt.headerSize[2] = static_cast<DWORD>(setup.size());
+
+    Append(m_afmt, &ident[0], ident.size());
+    Append(m_afmt, &comment[0], comment.size());
+    Append(m_afmt, &setup[0], setup.size());
+
+    m_amt.majortype = MEDIATYPE_Audio;
+    m_amt.subtype = VorbisTypes::MEDIASUBTYPE_Vorbis2;
+    m_amt.formattype = VorbisTypes::FORMAT_Vorbis2;
+    m_amt.cbFormat = static_cast<ULONG>(m_afmt.size());
+    m_amt.pbFormat = &m_afmt[0];
+}
+
+
+void SynthMedia::InitPackets()
+{
+    const Options& o = m_options;
+
+    Jitter jitter;
+    packets_t video, audio;
+
+    if (o.video)
+    {
+        const long long n = static_cast<long long>(o.seconds * o.fps);
+
+        //Keyframes are larger, but the sizes still average video_bytes.
+
+        const int k = o.keyframe_interval;
+        const long delta = static_cast<long>(
+            static_cast<long long>(o.video_bytes) * k /
+            (k + kKeyframeScale - 1));
+
+        for (long long i = 0; i < n; ++i)
+        {
+            Packet p;
+
+            p.video = true;
+            p.key = ((i % k) == 0);
+            p.size = jitter(p.key ? delta * kKeyframeScale : delta);
+            p.start = static_cast<REFERENCE_TIME>(i * 10000000 / o.fps);
+            p.stop = static_cast<REFERENCE_TIME>((i + 1) * 10000000 / o.fps);
+
+            m_max_video = std::max(m_max_video, p.size);
+            video.push_back(p);
+        }
+    }
+
+    if (o.audio)
+    {
+        const long long n =
+            static_cast<long long>(o.seconds) * o.sample_rate / o.audio_frame;
+
+        for (long long i = 0; i < n; ++i)
+        {
+            const long long samples = i * o.audio_frame;
+
+            Packet p;
+
+            p.video = false;
+            p.key = true;
+            p.size = jitter(o.audio_bytes);
+            p.start = samples * 10000000 / o.sample_rate;
+            p.stop = (samples + o.audio_frame) * 10000000 / o.sample_rate;
+
+            m_max_audio = std::max(m_max_audio, p.size);
+            audio.push_back(p);
+        }
+    }
+
+    m_packets.resize(video.size() + audio.size());
+
+    std::merge(
+        video.begin(),
+        video.end(),
+        audio.begin(),
+        audio.end(),
+        m_packets.begin(),
+        &EarlierPacket);
+
+    typedef packets_t::const_iterator iter_t;
+
+    for (iter_t i = m_packets.begin(); i != m_packets.end(); ++i)
+        m_payload += i->size;
+}
+
+
+void SynthMedia::WriteFrameHeader(const Packet& p, BYTE* buf) const
+{
+    assert(p.video);
+    assert(p.size >= kMinPacket);
+
+    //The frame tag: frame type (0 = key), version 0, shown, and the size
+    //of the first partition (here, the whole frame).
+
+    const DWORD part = std::min<DWORD>(p.size - 10, 0x7FFFF);
+    const DWORD tag = (p.key ? 0 : 1) | (1 << 4) | (part << 5);
+
+    buf[0] = static_cast<BYTE>(tag);
+    buf[1] = static_cast<BYTE>(tag >> 8);
+    buf[2] = static_cast<BYTE>(tag >> 16);
+
+    if (!p.key)
+        return;
+
+    buf[3] = 0x9D;  //start code
+    buf[4] = 0x01;
+    buf[5] = 0x2A;
+    buf[6] = static_cast<BYTE>(m_options.width);
+    buf[7] = static_cast<BYTE>((m_options.width >> 8) & 0x3F);
+    buf[8] = static_cast<BYTE>(m_options.height);
+    buf[9] = static_cast<BYTE>((m_options.height >> 8) & 0x3F);
+}
+
+}  //end namespace WebmBench
@@ -0,0 +1,79 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Options;
+
+//The synthetic input: the media types of the video (VP8) and audio
+//(Vorbis) streams, and the packets, in the order of their timestamps, as
+//an encoder would deliver them to the muxer.  The packet sizes vary
+//about their average, but the schedule is the same on every run (and
+//every machine), so that the results can be compared.
+
+class SynthMedia
+{
+    SynthMedia(const SynthMedia&);
+    SynthMedia& operator=(const SynthMedia&);
+
+public:
+
+    explicit SynthMedia(const Options&);
+    ~SynthMedia();
+
+    bool HasVideo() const;
+    bool HasAudio() const;
+
+    struct Packet
+    {
+        bool video;
+        bool key;
+        long size;
+        REFERENCE_TIME start;
+        REFERENCE_TIME stop;
+    };
+
+    typedef std::vector<Packet> packets_t;
+    const packets_t& GetPackets() const;
+
+    long long GetPayloadBytes() const;
+    long GetMaxVideoBytes() const;
+    long GetMaxAudioBytes() const;
+
+    const AM_MEDIA_TYPE& GetVideoType() const;
+    const AM_MEDIA_TYPE& GetAudioType() const;
+
+    //Writes the start of a VP8 frame header, so that the payload looks
+    //like a frame of the right type.
+    void WriteFrameHeader(const Packet&, BYTE*) const;
+
+private:
+
+    const Options& m_options;
+    packets_t m_packets;
+    long long m_payload;
+    long m_max_video;
+    long m_max_audio;
+
+    AM_MEDIA_TYPE m_vmt;
+    std::vector<BYTE> m_vfmt;
+
+    AM_MEDIA_TYPE m_amt;
+    std::vector<BYTE> m_afmt;
+
+    void InitVideoType();
+    void InitAudioType();
+    void InitPackets();
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,58 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include <vector>
+
+namespace WebmBench
+{
+
+struct Result;
+
+//Measures how the VP9 encoder scales with threads, when it is configured
+//the way the encoder filter configures it: the tile columns are the
+//filter's automatic setting for the thread count (common/vp9tiling.h).
+//The frames are synthetic (a textured background, with a block that
+//moves across it), and are made before the clock starts; this needs
+//libvpx (see build.sh).
+
+class VP9EncodeBench
+{
+    VP9EncodeBench(const VP9EncodeBench&);
+    VP9EncodeBench& operator=(const VP9EncodeBench&);
+
+public:
+
+    VP9EncodeBench(int width, int height, double fps, int frames);
+    ~VP9EncodeBench();
+
+    //Returns false if libvpx can't encode at this size.  The tile column
+    //setting (log2) that was used is returned in log2_tile_columns.
+    bool Run(int runs, int threads, Result&, int& log2_tile_columns);
+
+private:
+
+    const int m_width;
+    const int m_height;
+    const double m_fps;
+    const int m_frames;
+
+    //A few frames of I420, which the clip cycles through; enough that
+    //the motion search has something to find.
+    std::vector<std::vector<unsigned char> > m_images;
+
+    void Synthesize(int index, std::vector<unsigned char>&) const;
+
+    bool RunOnce(int threads,
+                 int log2_tile_columns,
+                 long long& us,
+                 long long& bytes);
+
+};
+
+}  //end namespace WebmBench
@@ -0,0 +1,809 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+//Measures the throughput of the muxer (WebmMuxLib::Context and EbmlIO)
+//and of the parser (libwebm's mkvparser, through the mkvparser::Stream
+//classes), without DirectShow: synthetic VP8 and Vorbis packets are
+//muxed into memory, and the result is demuxed again.  See build.sh for
+//how to build it on Linux.
+
+#include <strmif.h>
+#include "webmbench.h"
+#include "synthmedia.h"
+#include "muxbench.h"
+#include "renderbench.h"
+#include "ebmlbench.h"
+#ifndef WEBMBENCH_NO_ENCODE
+#include "encodebench.h"
+#endif
+#ifndef WEBMBENCH_NO_VP9
+#include "vp9encodebench.h"
+#endif
+#ifndef WEBMBENCH_NO_DEMUX
+#include "demuxbench.h"
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using std::string;
+using namespace WebmBench;
+
+namespace
+{
+
+void Usage()
+{
+    printf(
+        "usage: webmbench [options]\n"
+        "\n"
+        "  --seconds=N              length of the clip (default 60)\n"
+        "  --runs=N                 timed runs (default 5)\n"
+        "  --size=WxH               video frame size (default 640x360)\n"
+        "  --fps=N                  video frame rate (default 30)\n"
+        "  --video-bytes=N          average video frame (default 8000)\n"
+        "  --keyframe-interval=N    in frames (default 150)\n"
+        "  --sample-rate=N          audio sample rate (default 44100)\n"
+        "  --channels=N             1 or 2 (default 2)\n"
+        "  --audio-frame=N          samples per audio packet (default 1024)\n"
+        "  --audio-bytes=N          average audio packet (default 256)\n"
+        "  --no-video               audio only\n"
+        "  --no-audio               video only\n"
+        "  --mux-only               skip the demux benchmark\n"
+        "  --render                 benchmark the Vorbis decoder's output\n"
+        "                           stage (5.1 and 7.1), instead of the\n"
+        "                           muxer and the parser\n"
+        "  --encode                 benchmark the Vorbis encoder's analysis\n"
+        "                           pipeline (stereo, 5.1 and 7.1), with\n"
+        "                           and without its worker thread; needs\n"
+        "                           libvorbis (see build.sh)\n"
+        "  --vp9                    benchmark the VP9 encoder with 1 to 16\n"
+        "                           threads, at --size and --fps, with the\n"
+        "                           filter's automatic tile columns; needs\n"
+        "                           libvpx (try --size=1920x1080\n"
+        "                           --seconds=5 --runs=1)\n"
+        "  --ebml                   benchmark the serialization of the\n"
+        "                           muxer's Info, Tracks and cluster\n"
+        "                           headers, before and after the\n"
+        "                           compile-time EBML writer\n"
+        "  --output=FILE            save the muxed file\n"
+        "  --json                   one line of JSON, instead of text\n");
+}
+
+
+bool GetValue(const char* arg, const char* name, const char*& value)
+{
+    const size_t len = strlen(name);
+
+    if (strncmp(arg, name, len) != 0)
+        return false;
+
+    if (arg[len] != '=')
+        return false;
+
+    value = arg + len + 1;
+    return true;
+}
+
+
+bool ParseInt(const char* str, long long min, long long max, long long& val)
+{
+    char* end;
+    val = strtoll(str, &end, 10);
+
+    if ((end == str) || (*end != '\0'))
+        return false;
+
+    return (val >= min) && (val <= max);
+}
+
+
+int Parse(int argc, char* argv[], Options& o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+        const char* value;
+        long long n;
+        bool ok = true;
+
+        if (GetValue(arg, "--seconds", value))
+        {
+            ok = ParseInt(value, 1, 24 * 3600, n);
+            o.seconds = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--runs", value))
+        {
+            ok = ParseInt(value, 1, 1000, n);
+            o.runs = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--size", value))
+        {
+            int w, h;
+            char c;
+
+            ok = (sscanf(value, "%dx%d%c", &w, &h, &c) == 2) &&
+                 (w >= 16) && (w <= 16383) && (h >= 16) && (h <= 16383);
+
+            o.width = w;
+            o.height = h;
+        }
+        else if (GetValue(arg, "--fps", value))
+        {
+            ok = ParseInt(value, 1, 240, n);
+            o.fps = static_cast<double>(n);
+        }
+        else if (GetValue(arg, "--video-bytes", value))
+        {
+            ok = ParseInt(value, 16, 16 * 1024 * 1024, n);
+            o.video_bytes = static_cast<long>(n);
+        }
+        else if (GetValue(arg, "--keyframe-interval", value))
+        {
+            ok = ParseInt(value, 1, 100000, n);
+            o.keyframe_interval = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--sample-rate", value))
+        {
+            ok = ParseInt(value, 8000, 192000, n);
+            o.sample_rate = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--channels", value))
+        {
+            ok = ParseInt(value, 1, 2, n);  //as the parser's limit
+            o.channels = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--audio-frame", value))
+        {
+            ok = ParseInt(value, 64, 8192, n);
+            o.audio_frame = static_cast<int>(n);
+        }
+        else if (GetValue(arg, "--audio-bytes", value))
+        {
+            ok = ParseInt(value, 16, 65536, n);
+            o.audio_bytes = static_cast<long>(n);
+        }
+        else if (GetValue(arg, "--output", value))
+            o.output = value;
+        else if (strcmp(arg, "--no-video") == 0)
+            o.video = false;
+        else if (strcmp(arg, "--no-audio") == 0)
+            o.audio = false;
+        else if (strcmp(arg, "--mux-only") == 0)
+            o.demux = false;
+        else if (strcmp(arg, "--render") == 0)
+            o.render = true;
+        else if (strcmp(arg, "--encode") == 0)
+            o.encode = true;
+        else if (strcmp(arg, "--vp9") == 0)
+            o.vp9 = true;
+        else if (strcmp(arg, "--ebml") == 0)
+            o.ebml = true;
+        else if (strcmp(arg, "--json") == 0)
+            o.json = true;
+        else if ((strcmp(arg, "--help") == 0) || (strcmp(arg, "-h") == 0))
+        {
+            Usage();
+            return -1;
+        }
+        else
+        {
+            fprintf(stderr, "webmbench: unknown option \"%s\"\n", arg);
+            return 1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "webmbench: bad value in \"%s\"\n", arg);
+            return 1;
+        }
+    }
+
+    if (!o.video && !o.audio)
+    {
+        fprintf(stderr, "webmbench: nothing to mux\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+
+double GetMBps(const Result& r)
+{
+    if (r.best_us <= 0)
+        return 0;
+
+    return double(r.bytes) / r.best_us;  //bytes/us = MB/s (10^6 bytes)
+}
+
+
+void Print(const char* name, const Result& r)
+{
+    printf("%-6s %8.1f MB/s  best %8.3f ms  median %8.3f ms  "
+           "%7lld allocs  %8.1f KB allocated  %8.1f KB peak heap\n",
+           name,
+           GetMBps(r),
+           double(r.best_us) / 1000,
+           double(r.median_us) / 1000,
+           r.allocs.allocs,
+           double(r.allocs.bytes) / 1024,
+           double(r.allocs.peak_bytes) / 1024);
+}
+
+
+void Write(const char* name, const Result& r)
+{
+    printf(", \"%s\": {\"mb_per_sec\": %.3f, \"best_us\": %lld, "
+           "\"median_us\": %lld, \"bytes\": %lld, \"frames\": %lld, "
+           "\"allocs\": %lld, \"alloc_bytes\": %lld, \"peak_heap\": %lld}",
+           name,
+           GetMBps(r),
+           r.best_us,
+           r.median_us,
+           r.bytes,
+           r.frames,
+           r.allocs.allocs,
+           r.allocs.bytes,
+           r.allocs.peak_bytes);
+}
+
+
+//The conversions that the Vorbis decoder MFT makes for 5.1 and 7.1
+//streams: to the same channels, folded to 5.1, or downmixed to stereo.
+
+int Render(const Options& o)
+{
+    using WebmMfVorbisDecLib::VorbisOutput::kFloat;
+    using WebmMfVorbisDecLib::VorbisOutput::kInt16;
+
+    struct Case
+    {
+        int channels_in;
+        int channels_out;
+        RenderBench::SampleFormat format;
+    };
+
+    const Case cases[] =
+    {
+        { 6, 6, kFloat },
+        { 6, 2, kFloat },
+        { 6, 2, kInt16 },
+        { 8, 8, kFloat },
+        { 8, 6, kFloat },
+        { 8, 6, kInt16 },
+        { 8, 2, kFloat },
+        { 8, 2, kInt16 }
+    };
+
+    const int n = sizeof(cases) / sizeof(cases[0]);
+
+    RenderBench bench(o.sample_rate, o.seconds);
+
+    if (o.json)
+        printf("{\"seconds\": %d, \"runs\": %d, \"render\": [",
+               o.seconds,
+               o.runs);
+    else
+        printf("%d sec of %d Hz Vorbis output, %d runs\n\n"
+               "                     old path         fused\n",
+               o.seconds,
+               o.sample_rate,
+               o.runs);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const Case& c = cases[i];
+
+        Result old_result;
+        Result fused_result;
+
+        if (!bench.Run(o.runs,
+                       c.channels_in,
+                       c.channels_out,
+                       c.format,
+                       false,
+                       old_result) ||
+            !bench.Run(o.runs,
+                       c.channels_in,
+                       c.channels_out,
+                       c.format,
+                       true,
+                       fused_result))
+        {
+            fprintf(stderr, "webmbench: unsupported conversion\n");
+            return 1;
+        }
+
+        //frames/us = Mframes/s
+
+        const double old_rate =
+            double(old_result.frames) / std::max(old_result.best_us, 1LL);
+
+        const double fused_rate =
+            double(fused_result.frames) / std::max(fused_result.best_us, 1LL);
+
+        const char* const format = (c.format == kFloat) ? "float" : "int16";
+
+        if (o.json)
+            printf("%s{\"channels_in\": %d, \"channels_out\": %d, "
+                   "\"format\": \"%s\", \"old_mframes_per_sec\": %.3f, "
+                   "\"fused_mframes_per_sec\": %.3f, "
+                   "\"old_allocs\": %lld, \"fused_allocs\": %lld}",
+                   (i > 0) ? ", " : "",
+                   c.channels_in,
+                   c.channels_out,
+                   format,
+                   old_rate,
+                   fused_rate,
+                   old_result.allocs.allocs,
+                   fused_result.allocs.allocs);
+        else
+            printf("%d -> %d %-5s  %8.1f Mframe/s  %8.1f Mframe/s  %5.2fx\n",
+                   c.channels_in,
+                   c.channels_out,
+                   format,
+                   old_rate,
+                   fused_rate,
+                   fused_rate / old_rate);
+    }
+
+    if (o.json)
+        printf("]}\n");
+
+    return 0;
+}
+
+
+//The EBML elements that WebmMuxLib::Context serializes itself, rather
+//than copying (as it does the frames), written the old way and with the
+//EbmlWriter element types.  Both must write the same bytes.
+
+int Ebml(const Options& o)
+{
+    const EbmlBench::Element elements[] =
+    {
+        EbmlBench::kInfo,
+        EbmlBench::kTracks,
+        EbmlBench::kCluster
+    };
+
+    const int n = sizeof(elements) / sizeof(elements[0]);
+
+    const int count = 100000;  //of each element, per run
+
+    EbmlBench bench(count);
+
+    if (o.json)
+        printf("{\"count\": %d, \"runs\": %d, \"ebml\": [",
+               count,
+               o.runs);
+    else
+        printf("%d of each element, %d runs\n\n"
+               "                 old path         compiled\n",
+               count,
+               o.runs);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const EbmlBench::Element e = elements[i];
+
+        Result old_result;
+        bench.Run(o.runs, e, false, old_result);
+
+        const std::vector<unsigned char> old_output = bench.GetOutput();
+
+        Result compiled_result;
+        bench.Run(o.runs, e, true, compiled_result);
+
+        if (bench.GetOutput() != old_output)
+        {
+            fprintf(stderr,
+                    "webmbench: the %s elements differ\n",
+                    EbmlBench::GetName(e));
+            return 1;
+        }
+
+        //elements/us = Melements/s
+
+        const double old_rate =
+            double(old_result.frames) / std::max(old_result.best_us, 1LL);
+
+        const double compiled_rate =
+            double(compiled_result.frames) /
+            std::max(compiled_result.best_us, 1LL);
+
+        if (o.json)
+            printf("%s{\"element\": \"%s\", \"bytes\": %lld, "
+                   "\"old_melements_per_sec\": %.3f, "
+                   "\"compiled_melements_per_sec\": %.3f, "
+                   "\"old_allocs\": %lld, \"compiled_allocs\": %lld}",
+                   (i > 0) ? ", " : "",
+                   EbmlBench::GetName(e),
+                   compiled_result.bytes,
+                   old_rate,
+                   compiled_rate,
+                   old_result.allocs.allocs,
+                   compiled_result.allocs.allocs);
+        else
+            printf("%-8s  %8.2f Melem/s  %8.2f Melem/s  %5.2fx\n",
+                   EbmlBench::GetName(e),
+                   old_rate,
+                   compiled_rate,
+                   compiled_rate / old_rate);
+    }
+
+    if (o.json)
+        printf("]}\n");
+
+    return 0;
+}
+
+
+#ifndef WEBMBENCH_NO_ENCODE
+
+//The channel layouts that a capture source or a decoder upstream of the
+//encoder filter would deliver.
+
+int Encode(const Options& o)
+{
+    const int layouts[] = { 2, 6, 8 };
+    const int n = sizeof(layouts) / sizeof(layouts[0]);
+
+    if (o.json)
+        printf("{\"seconds\": %d, \"runs\": %d, \"sample_rate\": %d, "
+               "\"encode\": [",
+               o.seconds,
+               o.runs,
+               o.sample_rate);
+    else
+        printf("%d sec of %d Hz PCM, delivered %d frames at a time, "
+               "%d runs\n\n"
+               "                serial                  "
+               "threaded\n"
+               "          encode   in Receive      encode   in Receive\n",
+               o.seconds,
+               o.sample_rate,
+               o.audio_frame,
+               o.runs);
+
+    for (int i = 0; i < n; ++i)
+    {
+        const int channels = layouts[i];
+
+        EncodeBench bench(o.sample_rate, channels, o.seconds, o.audio_frame);
+
+        Result serial_result;
+        Result threaded_result;
+
+        EncodeBench::Times serial;
+        EncodeBench::Times threaded;
+
+        if (!bench.Run(o.runs, false, serial_result, serial) ||
+            !bench.Run(o.runs, true, threaded_result, threaded))
+        {
+            fprintf(stderr,
+                    "webmbench: libvorbis can't encode %d channels at %d Hz\n",
+                    channels,
+                    o.sample_rate);
+            return 1;
+        }
+
+        const bool same = (serial.digest == threaded.digest) &&
+                          (serial_result.bytes == threaded_result.bytes);
+
+        if (o.json)
+            printf("%s{\"channels\": %d, \"serial_us\": %lld, "
+                   "\"serial_caller_us\": %lld, \"threaded_us\": %lld, "
+                   "\"threaded_caller_us\": %lld, \"bytes\": %lld, "
+                   "\"identical\": %s}",
+                   (i > 0) ? ", " : "",
+                   channels,
+                   serial_result.best_us,
+                   serial.caller_us,
+                   threaded_result.best_us,
+                   threaded.caller_us,
+                   serial_result.bytes,
+                   same ? "true" : "false");
+        else
+            printf("%d ch  %8.1f ms  %8.1f ms  %8.1f ms  %8.1f ms  %s\n",
+                   channels,
+                   double(serial_result.best_us) / 1000,
+                   double(serial.caller_us) / 1000,
+                   double(threaded_result.best_us) / 1000,
+                   double(threaded.caller_us) / 1000,
+                   same ? "identical" : "PACKETS DIFFER");
+
+        if (!same)
+        {
+            if (o.json)
+                printf("]}\n");
+
+            return 1;
+        }
+    }
+
+    if (o.json)
+        printf("]}\n");
+
+    return 0;
+}
+
+#endif  //WEBMBENCH_NO_ENCODE
+
+
+#ifndef WEBMBENCH_NO_VP9
+
+//The thread counts that a VP9 encode on a desktop or a server would use;
+//the speedup is relative to the first.
+
+int EncodeVP9(const Options& o)
+{
+    const int counts[] = { 1, 2, 4, 8, 16 };
+    const int n = sizeof(counts) / sizeof(counts[0]);
+
+    const int frames = static_cast<int>(o.seconds * o.fps);
+
+    if (o.json)
+        printf("{\"seconds\": %d, \"runs\": %d, \"width\": %d, "
+               "\"height\": %d, \"frames\": %d, \"vp9\": [",
+               o.seconds,
+               o.runs,
+               o.width,
+               o.height,
+               frames);
+    else
+        printf("%d frames of %dx%d VP9, %d runs\n\n"
+               "threads  tile cols      encode        fps   speedup\n",
+               frames,
+               o.width,
+               o.height,
+               o.runs);
+
+    VP9EncodeBench bench(o.width, o.height, o.fps, frames);
+
+    long long base_us = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        const int threads = counts[i];
+
+        Result result;
+        int log2_tile_columns;
+
+        if (!bench.Run(o.runs, threads, result, log2_tile_columns))
+        {
+            if (o.json)
+                printf("]}\n");
+
+            fprintf(stderr,
+                    "webmbench: libvpx can't encode %dx%d VP9\n",
+                    o.width,
+                    o.height);
+            return 1;
+        }
+
+        if (i == 0)
+            base_us = result.best_us;
+
+        const double sec = double(result.best_us) / 1000000;
+        const double fps = (sec > 0) ? frames / sec : 0;
+
+        const double speedup =
+            (result.best_us > 0) ? double(base_us) / result.best_us : 0;
+
+        if (o.json)
+            printf("%s{\"threads\": %d, \"tile_columns\": %d, "
+                   "\"us\": %lld, \"bytes\": %lld, \"speedup\": %.2f}",
+                   (i > 0) ? ", " : "",
+                   threads,
+                   1 << log2_tile_columns,
+                   result.best_us,
+                   result.bytes,
+                   speedup);
+        else
+            printf("%7d  %9d  %8.1f ms  %9.2f  %7.2fx\n",
+                   threads,
+                   1 << log2_tile_columns,
+                   double(result.best_us) / 1000,
+                   fps,
+                   speedup);
+    }
+
+    if (o.json)
+        printf("]}\n");
+
+    return 0;
+}
+
+#endif  //WEBMBENCH_NO_VP9
+
+}  //end anonymous namespace
+
+
+namespace WebmBench
+{
+
+Options::Options() :
+    seconds(60),
+    runs(5),
+    video(true),
+    width(640),
+    height(360),
+    fps(30),
+    video_bytes(8000),
+    keyframe_interval(150),
+    audio(true),
+    sample_rate(44100),
+    channels(2),
+    audio_frame(1024),
+    audio_bytes(256),
+#ifdef WEBMBENCH_NO_DEMUX
+    demux(false),
+#else
+    demux(true),
+#endif
+    render(false),
+    encode(false),
+    vp9(false),
+    ebml(false),
+    json(false),
+    output(0)
+{
+}
+
+}  //end namespace WebmBench
+
+
+int main(int argc, char* argv[])
+{
+    Options o;
+
+    const int status = Parse(argc, argv, o);
+
+    if (status)
+        return (status < 0) ? 0 : status;
+
+    if (o.render)
+        return Render(o);
+
+    if (o.ebml)
+        return Ebml(o);
+
+    if (o.encode)
+    {
+#ifdef WEBMBENCH_NO_ENCODE
+        fprintf(stderr, "webmbench: built without libvorbis; see build.sh\n");
+        return 1;
+#else
+        return Encode(o);
+#endif
+    }
+
+    if (o.vp9)
+    {
+#ifdef WEBMBENCH_NO_VP9
+        fprintf(stderr, "webmbench: built without libvpx; see build.sh\n");
+        return 1;
+#else
+        return EncodeVP9(o);
+#endif
+    }
+
+    const SynthMedia media(o);
+
+    //The parser sizes its video buffers for RGB32 frames, so a frame
+    //can't be larger than that.
+
+    const long long max_frame = 4LL * o.width * o.height;
+
+    if (media.GetMaxVideoBytes() > max_frame)
+    {
+        fprintf(stderr, "webmbench: --video-bytes is too large\n");
+        return 1;
+    }
+
+    MuxBench mux(media);
+
+    Result mux_result;
+    mux.Run(o.runs, mux_result);
+
+    if (o.output)
+    {
+        const MemStream& f = mux.GetFile();
+
+        FILE* const file = fopen(o.output, "wb");
+
+        const size_t n = static_cast<size_t>(f.GetLength());
+
+        bool ok = (file != 0) && (fwrite(f.GetData(), 1, n, file) == n);
+
+        if (file && (fclose(file) != 0))
+            ok = false;
+
+        if (!ok)
+        {
+            fprintf(stderr, "webmbench: unable to write \"%s\"\n", o.output);
+            return 1;
+        }
+    }
+
+    Result demux_result = Result();
+    bool demuxed = false;
+
+#ifndef WEBMBENCH_NO_DEMUX
+    if (o.demux)
+    {
+        const MemStream& f = mux.GetFile();
+
+        DemuxBench demux(f.GetData(), f.GetLength());
+
+        const HRESULT hr = demux.Run(o.runs, demux_result);
+
+        if (FAILED(hr))
+        {
+            fprintf(stderr, "webmbench: unable to demux (0x%08X)\n", hr);
+            return 1;
+        }
+
+        demuxed = true;
+    }
+#endif
+
+    const long long peak = AllocStats::GetPeakResident();
+
+    if (o.json)
+    {
+        printf("{\"seconds\": %d, \"runs\": %d, \"packets\": %lld, "
+               "\"payload_bytes\": %lld",
+               o.seconds,
+               o.runs,
+               static_cast<long long>(media.GetPackets().size()),
+               media.GetPayloadBytes());
+
+        Write("mux", mux_result);
+
+        if (demuxed)
+            Write("demux", demux_result);
+
+        printf(", \"peak_resident\": %lld}\n", peak);
+        return 0;
+    }
+
+    printf("%d sec clip", o.seconds);
+
+    if (o.video)
+        printf(", VP8 %dx%d %.0f fps %ld bytes/frame",
+               o.width,
+               o.height,
+               o.fps,
+               o.video_bytes);
+
+    if (o.audio)
+        printf(", Vorbis %d Hz %d ch %ld bytes/packet",
+               o.sample_rate,
+               o.channels,
+               o.audio_bytes);
+
+    printf("\n%lld packets, %.1f MB payload, %.1f MB file, %d runs\n\n",
+           static_cast<long long>(media.GetPackets().size()),
+           double(media.GetPayloadBytes()) / 1000000,
+           double(mux_result.bytes) / 1000000,
+           o.runs);
+
+    Print("mux", mux_result);
+
+    if (demuxed)
+        Print("demux", demux_result);
+
+    printf("\npeak resident %.1f MB\n", double(peak) / 1000000);
+
+    return 0;
+}
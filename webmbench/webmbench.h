@@ -0,0 +1,56 @@
+// Copyright (c) 2014 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+#pragma once
+#include "allocstats.h"
+
+namespace WebmBench
+{
+
+struct Options
+{
+    Options();  //the defaults
+
+    int seconds;            //length of the synthetic clip
+    int runs;               //timed runs, after one warm-up run
+
+    bool video;
+    int width;
+    int height;
+    double fps;
+    long video_bytes;       //average size of a frame
+    int keyframe_interval;  //frames
+
+    bool audio;
+    int sample_rate;
+    int channels;
+    int audio_frame;        //samples per packet
+    long audio_bytes;       //average size of a packet
+
+    bool demux;
+    bool render;            //benchmark the Vorbis output stage instead
+    bool encode;            //or the Vorbis encoder's analysis pipeline
+    bool vp9;               //or the VP9 encoder's thread scaling
+    bool ebml;              //or the muxer's EBML header writers
+    bool json;
+    const char* output;     //where to save the muxed file, if anywhere
+};
+
+
+//What one benchmark (mux or demux) measured.
+
+struct Result
+{
+    long long bytes;         //size of the file
+    long long frames;        //blocks written, or samples delivered
+    long long best_us;       //the fastest run
+    long long median_us;
+    AllocStats::Counts allocs;  //in the last run
+};
+
+}  //end namespace WebmBench
@@ -14,6 +14,7 @@
 #include <comdef.h>
 
 #include "comreg.h"
+#include "ebmlwriter.h"
 #include "scratchbuf.h"
 #include "versionhandling.h"
 #include "webmconstants.h"
@@ -26,15 +27,50 @@ using std::endl;
 
 using std::wstring;
 using std::wostringstream;
+using WebmUtil::EbmlElementID;
+using WebmUtil::EbmlFloat;
+using WebmUtil::EbmlMaster;
+using WebmUtil::EbmlUInt;
+using WebmUtil::EbmlVarUInt;
+using WebmUtil::EbmlVoid;
+using WebmUtil::EbmlWriter;
 
 enum { kAudioClusterSizeInTimeMs = 5000 };  //TODO: parameterize this
 
+namespace
+{
+
+//Writes the header of a cluster, in one write: its ID, its size (in N
+//bytes, as unknown; it's patched in once the cluster is finished, unless
+//we're live), and its timecode (in |timecode_size| bytes).
+
+template <int N>
+void WriteClusterHeader(
+    EbmlIO::File& file,
+    ULONG timecode,
+    int timecode_size)
+{
+    typedef EbmlMaster<WebmUtil::kEbmlClusterID, N> ClusterHeader;
+    typedef EbmlVarUInt<WebmUtil::kEbmlTimeCodeID> Timecode;
+
+    uint8 buf[ClusterHeader::kHeaderLength + Timecode::kMaxLength];
+    EbmlWriter w(buf, sizeof(buf));
+
+    w.Begin<ClusterHeader>();
+    w.WriteVarUInt<WebmUtil::kEbmlTimeCodeID>(timecode, timecode_size);
+
+    file.Write(buf, w.GetLength());
+}
+
+}  //end anonymous namespace
+
 namespace WebmMuxLib
 {
 
 extern HMODULE s_hModule;
 
 Context::Context() :
+   m_pipeline_stats(L"outpin"),
    m_bLiveMux(false),
    m_bBufferData(false),
    m_pVideo(0),
@@ -189,71 +225,58 @@ ULONG Context::GetTimecode() const
 
 void Context::WriteEbmlHeader()
 {
-    m_buf.WriteID4(WebmUtil::kEbmlID);
+    // The whole header is known at compile time, so it's built on the
+    // stack, and written to the file at once.
 
-    // store the header size offset for later correction
-    const uint64 offset_header_size = m_buf.GetBufferLength();
-    m_buf.Write1UInt(0xF); // temp size
-
-    // We must exclude |num_bytes_to_ignore| from the size we obtain from
-    // |m_buf|.  The value from |m_buf| includes the bytes storing
-    // kEbmlID and the size written into the buffer-- using it would result in
-    // an invalid WebM file.
-    const uint64 num_bytes_to_ignore = 4 + sizeof(uint8);
-
-    // EBML Version
-    m_buf.WriteID2(WebmUtil::kEbmlVersionID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(1);  // EBML Version = 1
-
-    // EBML Read Version
-    m_buf.WriteID2(WebmUtil::kEbmlReadVersionID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(1);  // EBML Read Version = 1
-
-    // EBML Max ID Length
-    m_buf.WriteID2(WebmUtil::kEbmlMaxIDLengthID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(4);  // EBML Max ID Length = 4
-
-    // EBML Max Size Length
-    m_buf.WriteID2(WebmUtil::kEbmlMaxSizeLengthID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(8);  // EBML Max Size Length = 8
-
-    // Doc Type
-    m_buf.WriteID2(WebmUtil::kEbmlDocTypeID);
-    m_buf.Write1String("webm");
+    typedef EbmlMaster<WebmUtil::kEbmlID, 1> Header;
+    typedef EbmlUInt<WebmUtil::kEbmlVersionID, 1> Version;
+    typedef EbmlUInt<WebmUtil::kEbmlReadVersionID, 1> ReadVersion;
+    typedef EbmlUInt<WebmUtil::kEbmlMaxIDLengthID, 1> MaxIDLength;
+    typedef EbmlUInt<WebmUtil::kEbmlMaxSizeLengthID, 1> MaxSizeLength;
+    typedef EbmlUInt<WebmUtil::kEbmlDocTypeVersionID, 1> DocTypeVersion;
+    typedef EbmlUInt<WebmUtil::kEbmlDocTypeReadVersionID, 1> DocTypeReadVersion;
 
     // Pad our doc type (so it can be changed to matroska easily)
-    m_buf.WriteID1(WebmUtil::kEbmlVoidID);
-    const int32 void_element_size = 9;
-    m_buf.Write1UInt(void_element_size);
-    for (int32 i = 0; i < void_element_size; ++i)
+    typedef EbmlVoid<9> DocTypePadding;
+
+    static const char kDocType[] = "webm";
+
+    enum
     {
-        m_buf.Serialize1UInt(0);
-    }
+        kDocTypeLength = sizeof(kDocType) - 1,
 
-    // Doc Type Version
-    m_buf.WriteID2(WebmUtil::kEbmlDocTypeVersionID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(2);  // Doc Type Version
+        kLength = Header::kHeaderLength +
+                  Version::kLength +
+                  ReadVersion::kLength +
+                  MaxIDLength::kLength +
+                  MaxSizeLength::kLength +
+                  EbmlElementID<WebmUtil::kEbmlDocTypeID>::kLength + 1 +
+                  kDocTypeLength +
+                  DocTypePadding::kLength +
+                  DocTypeVersion::kLength +
+                  DocTypeReadVersion::kLength
+    };
 
-    // Doc Type Read Version
-    m_buf.WriteID2(WebmUtil::kEbmlDocTypeReadVersionID);
-    m_buf.Write1UInt(1);      // element size
-    m_buf.Serialize1UInt(2);  // Doc Type Read Version
+    uint8 buf[kLength];
+    EbmlWriter w(buf, kLength);
 
-    // patch in the actual length of the EBML header
-    const uint64 actual_header_length =
-        m_buf.GetBufferLength() - num_bytes_to_ignore;
-    assert(actual_header_length < 255);
-    m_buf.RewriteUInt(offset_header_size, actual_header_length, 1);
+    uint8* const header = w.Begin<Header>();
 
-    // dump |m_buf| into the out file
-    m_file.Write(m_buf.GetBufferPtr(),
-                 static_cast<ULONG>(m_buf.GetBufferLength()));
-    m_buf.Reset();
+    w.Write<Version>(1);        // EBML Version = 1
+    w.Write<ReadVersion>(1);    // EBML Read Version = 1
+    w.Write<MaxIDLength>(4);    // EBML Max ID Length = 4
+    w.Write<MaxSizeLength>(8);  // EBML Max Size Length = 8
+
+    w.WriteString<WebmUtil::kEbmlDocTypeID>(kDocType, kDocTypeLength);
+    w.WriteVoid<9>();
+
+    w.Write<DocTypeVersion>(2);
+    w.Write<DocTypeReadVersion>(2);
+
+    w.End<Header>(header);
+    assert(w.GetLength() == kLength);
+
+    m_file.Write(buf, kLength);
 }
 
 
@@ -314,11 +337,14 @@ void Context::FinalInfo()
 {
     m_file.SetPosition(m_duration_pos);
 
-    m_file.WriteID2(WebmUtil::kEbmlDurationID); // Duration ID
-    m_file.Write1UInt(4);                       // payload size
+    typedef EbmlFloat<WebmUtil::kEbmlDurationID> Duration;
 
     const float duration = static_cast<float>(m_max_timecode);
-    m_file.Serialize4Float(duration);
+
+    uint8 buf[Duration::kLength];
+    Duration::Store(buf, duration);
+
+    m_file.Write(buf, Duration::kLength);
 }
 
 
@@ -410,19 +436,34 @@ void Context::WriteSeekEntry(ULONG id, __int64 pos_)
     const __int64 start_pos = m_file.GetPosition();
 #endif
 
-    m_file.WriteID2(WebmUtil::kEbmlSeekEntryID);
-    m_file.Write1UInt(18);  // payload size
+    typedef EbmlMaster<WebmUtil::kEbmlSeekEntryID, 1> SeekEntry;
+    typedef EbmlUInt<WebmUtil::kEbmlSeekIDID, 4> SeekID;
+    typedef EbmlUInt<WebmUtil::kEbmlSeekPositionID, 8> SeekPosition;
+
+    enum
+    {
+        kLength = SeekEntry::kHeaderLength +
+                  SeekID::kLength +
+                  SeekPosition::kLength
+    };
+
+    static_assert(kLength == 21, "see InitSeekHead");
 
-    m_file.WriteID2(WebmUtil::kEbmlSeekIDID);
-    m_file.Write1UInt(4);   // payload size is 4 bytes
-    m_file.WriteID4(id);
+    assert(id & 0x10000000);  //always write 4 bytes
+    assert(id <= 0x1FFFFFFE);
 
     const __int64 pos = pos_ - m_segment_pos - 12;
     assert(pos >= 0);
 
-    m_file.WriteID2(WebmUtil::kEbmlSeekPositionID);
-    m_file.Write1UInt(8);        // payload size is 8 bytes
-    m_file.Serialize8UInt(pos);  // payload
+    uint8 buf[kLength];
+    EbmlWriter w(buf, kLength);
+
+    uint8* const entry = w.Begin<SeekEntry>();
+    w.Write<SeekID>(id);
+    w.Write<SeekPosition>(pos);
+    w.End<SeekEntry>(entry);
+
+    m_file.Write(buf, kLength);
 
 #ifdef _DEBUG
     const __int64 stop_pos = m_file.GetPosition();
@@ -436,36 +477,41 @@ void Context::InitInfo()
     if (!m_bLiveMux)
         m_info_pos = m_file.GetPosition();
 
-    m_buf.WriteID4(WebmUtil::kEbmlSegmentInfoID);
+    typedef EbmlMaster<WebmUtil::kEbmlSegmentInfoID, 2> Info;
+    typedef EbmlUInt<WebmUtil::kEbmlTimeCodeScaleID, 4> TimecodeScale;
 
-    const uint64 size_pos = m_buf.GetBufferLength();
-    // pad with 0; we're going to patch the size into the buffer
-    m_buf.Serialize2UInt(0);
+    // Room for the duration, which FinalInfo writes over this.
+    typedef EbmlVoid<5> DurationSpace;
 
-    // We must exclude |num_bytes_to_ignore| from the size we obtain from
-    // |m_buf|.  The value from |m_buf| includes the bytes storing
-    // kEbmlSegmentInfoID and the size written into the buffer-- using it
-    // would result in invalid segment info.
-    const uint64 num_bytes_to_ignore = 4 + sizeof(uint16);
+    static_assert(static_cast<int>(DurationSpace::kLength) ==
+                  EbmlFloat<WebmUtil::kEbmlDurationID>::kLength,
+                  "the duration must fit in its space");
+
+    assert(m_buf.GetBufferLength() == 0);
+
+    const int32 len = Info::kHeaderLength +
+                      TimecodeScale::kLength +
+                      (m_bLiveMux ? 0 : DurationSpace::kLength);
 
-    m_buf.WriteID3(WebmUtil::kEbmlTimeCodeScaleID);
-    m_buf.Write1UInt(4);  // payload size
-    m_buf.Serialize4UInt(m_timecode_scale);
+    EbmlWriter w(m_buf.Append(len), len);
+
+    w.Begin<Info>();  // the size is patched in below
+    w.Write<TimecodeScale>(m_timecode_scale);
 
     if (!m_bLiveMux)
     {
         // remember where duration is
-        m_duration_pos = m_file.GetPosition() + m_buf.GetBufferLength();
-        m_buf.WriteID1(WebmUtil::kEbmlVoidID);
-        m_buf.Write1UInt(5);  // (Duration ID - Void ID) + payload
-
-        // reserve space in the buffer
-        for (int32 i = 0; i < 5; ++i)
-        {
-            m_buf.Serialize1UInt(0xF);
-        }
+        m_duration_pos = m_file.GetPosition() + w.GetLength();
+        w.WriteVoid<5>();
     }
 
+    assert(w.GetLength() == len);
+
+    // The size field follows the ID, and doesn't count the header.
+    const uint64 size_pos =
+        EbmlElementID<WebmUtil::kEbmlSegmentInfoID>::kLength;
+    const uint64 num_bytes_to_ignore = Info::kHeaderLength;
+
     // MuxingApp
     m_buf.WriteID2(WebmUtil::kEbmlMuxingAppID);
 
@@ -502,19 +548,21 @@ void Context::WriteTrack()
 
     assert(m_bBufferData == false);
 
-    m_buf.WriteID4(WebmUtil::kEbmlTracksID);
+    assert(m_buf.GetBufferLength() == 0);
+
+    // reserve two bytes for the size of the tracks element
+    typedef EbmlMaster<WebmUtil::kEbmlTracksID, 2> Tracks;
+    Tracks::Store(m_buf.Append(Tracks::kHeaderLength));
 
     // store tracks element offset for patching later
-    const uint64 track_len_offset = m_buf.GetBufferLength();
+    const uint64 track_len_offset =
+        EbmlElementID<WebmUtil::kEbmlTracksID>::kLength;
 
     // We must exclude |num_bytes_to_ignore| from the size we obtain from
     // |m_buf|.  The value from |m_buf| includes the bytes storing
     // kEbmlTracksID and the size written into the buffer-- using it
     // would result in invalid segment info.
-    const uint64 num_bytes_to_ignore = 4 + sizeof(uint16);
-
-    // reserve two bytes for the size of the tracks element
-    m_buf.Serialize2UInt(0);
+    const uint64 num_bytes_to_ignore = Tracks::kHeaderLength;
 
     int track_num = 0;
 
@@ -1137,38 +1185,22 @@ void Context::CreateNewCluster(const StreamVideo::VideoFrame* pvf_stop)
     }
 
     // Write cluster header
-    m_file.WriteID4(WebmUtil::kEbmlClusterID);
-    if (!m_bLiveMux)
-    {
-        // Use a 8-byte cluster header
-        m_file.Serialize4UInt(0x1FFFFFFF);  // temp cluster size; rewritten
-                                            // below if |m_bLiveMux| is false
-    }
-    else
-    {
-        // Use a 5-byte cluster header
-        m_file.Serialize1UInt(0xFF);
-    }
-
-    m_file.WriteID1(WebmUtil::kEbmlTimeCodeID);
-
-    BYTE timecode_size;
-
     if (!m_bLiveMux)
     {
-        timecode_size = m_file.GetSerializeUIntSize(c.m_timecode);
+        // Use a 8-byte cluster header; the temp cluster size is
+        // rewritten below
+        const BYTE timecode_size = m_file.GetSerializeUIntSize(c.m_timecode);
         assert(timecode_size <= 8);
+
+        WriteClusterHeader<4>(m_file, c.m_timecode, timecode_size);
     }
     else
     {
-        // To facilitate easy rewriting of timecodes, always write 8 byte
-        // timecodes in live mux mode.
-        timecode_size = 8;
+        // Use a 5-byte cluster header.  To facilitate easy rewriting of
+        // timecodes, always write 8 byte timecodes in live mux mode.
+        WriteClusterHeader<1>(m_file, c.m_timecode, 8);
     }
 
-    m_file.Write1UInt(timecode_size);
-    m_file.SerializeUInt(c.m_timecode, timecode_size);
-
     const __int64 off = c.m_pos - m_segment_pos - 12;
     assert(off >= 0);
 
@@ -1340,38 +1372,22 @@ void Context::CreateNewClusterAudioOnly()
     c.m_timecode = af_first_time;
 
     // Write cluster header
-    m_file.WriteID4(WebmUtil::kEbmlClusterID);
-    if (!m_bLiveMux)
-    {
-        // Use a 7-byte cluster header
-        m_file.SerializeUInt(0x3FFFFF, 3);  // temp cluster size; rewritten
-                                            // below if |m_bLiveMux| is false
-    }
-    else
-    {
-        // Use a 5-byte cluster header
-        m_file.Serialize1UInt(0xFF);
-    }
-
-    m_file.WriteID1(WebmUtil::kEbmlTimeCodeID);
-
-    BYTE timecode_size;
-
     if (!m_bLiveMux)
     {
-        timecode_size = m_file.GetSerializeUIntSize(c.m_timecode);
+        // Use a 7-byte cluster header; the temp cluster size is
+        // rewritten below
+        const BYTE timecode_size = m_file.GetSerializeUIntSize(c.m_timecode);
         assert(timecode_size <= 8);
+
+        WriteClusterHeader<3>(m_file, c.m_timecode, timecode_size);
     }
     else
     {
-        // To facilitate easy rewriting of timecodes, always write 8 byte
-        // timecodes in live mux mode.
-        timecode_size = 8;
+        // Use a 5-byte cluster header.  To facilitate easy rewriting of
+        // timecodes, always write 8 byte timecodes in live mux mode.
+        WriteClusterHeader<1>(m_file, c.m_timecode, 8);
     }
 
-    m_file.Write1UInt(timecode_size);
-    m_file.SerializeUInt(c.m_timecode, timecode_size);
-
     const __int64 off = c.m_pos - m_segment_pos - 12;
     assert(off >= 0);
 
@@ -1497,6 +1513,8 @@ void Context::WriteVideoFrame(
     if (ft > m_max_timecode)
        m_max_timecode = ft;
 
+    m_pipeline_stats.OnOutput(pf->GetSize());
+
     vframes.pop_front();
     pf->Release();
 
@@ -1531,6 +1549,8 @@ void Context::WriteAudioFrame(Cluster& c, ULONG& cFrames)
    if (ft > m_max_timecode)
       m_max_timecode = ft;
 
+   m_pipeline_stats.OnOutput(pf->GetSize());
+
    aframes.pop_front();
    pf->Release();
 
@@ -8,10 +8,12 @@
 
 #pragma once
 #include "scratchbuf.h"
+#include "pipelinestats.h"
 #include "webmmuxebmlio.h"
 #include "webmmuxstreamvideo.h"
 #include "webmmuxstreamaudio.h"
 #include <list>
+#include <string>
 
 namespace WebmMuxLib
 {
@@ -27,6 +29,9 @@ public:
    WebmUtil::EbmlScratchBuf m_buf;
    std::wstring m_writing_app;
 
+   //Frames (and their payload bytes) written to the file.
+   WebmUtil::PipelineStats m_pipeline_stats;
+
    Context();
    ~Context();
 
@@ -98,8 +98,6 @@ BYTE EbmlIO::File::GetSerializeUIntSize(__int64 val)
 
         if (val < max)
             return static_cast<BYTE>(size);
-
-        ++size;
     }
 
     return 8;
@@ -149,6 +149,10 @@ HRESULT Filter::nondelegating_t::QueryInterface(
     {
         pUnk = static_cast<IWebmMux*>(m_pFilter);
     }
+    else if (iid == __uuidof(IPipelineStats))
+    {
+        pUnk = static_cast<IPipelineStats*>(m_pFilter);
+    }
     else
     {
 #if 0
@@ -1346,6 +1350,51 @@ HRESULT Filter::GetMuxMode(WebmMuxMode* pMuxMode)
 }
 
 
+ULONG Filter::GetStreamCount()
+{
+    return 3;  //video and audio inpins, and the file
+}
+
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    //The counters are atomic, so there's no need to seize the
+    //filter lock (which a streaming thread holds while it writes
+    //frames to the file).
+
+    switch (index)
+    {
+        case 0:
+            m_inpin_video.m_pipeline_stats.GetSnapshot(*p);
+            return S_OK;
+
+        case 1:
+            m_inpin_audio.m_pipeline_stats.GetSnapshot(*p);
+            return S_OK;
+
+        case 2:
+            m_ctx.m_pipeline_stats.GetSnapshot(*p);
+            return S_OK;
+
+        default:
+            return E_INVALIDARG;
+    }
+}
+
+
+HRESULT Filter::ResetStats()
+{
+    m_inpin_video.m_pipeline_stats.Reset();
+    m_inpin_audio.m_pipeline_stats.Reset();
+    m_ctx.m_pipeline_stats.Reset();
+
+    return S_OK;
+}
+
+
 HRESULT Filter::OnEndOfStream()
 {
 #if 1
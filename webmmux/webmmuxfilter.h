@@ -15,6 +15,7 @@
 #include "webmmuxcontext.h"
 #include "clockable.h"
 #include "webmmuxidl.h"
+#include "ipipelinestats.h"
 
 namespace WebmMuxLib
 {
@@ -23,6 +24,7 @@ class Filter : public IBaseFilter,
                public IMediaSeeking,
                public IAMFilterMiscFlags,
                public IWebmMux,
+               public IPipelineStats,
                public CLockable
 {
     friend HRESULT CreateInstance(
@@ -107,6 +109,12 @@ public:
     HRESULT STDMETHODCALLTYPE SetMuxMode(WebmMuxMode);
     HRESULT STDMETHODCALLTYPE GetMuxMode(WebmMuxMode*);
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
 private:
 
     class nondelegating_t : public IUnknown
@@ -29,6 +29,7 @@ namespace WebmMuxLib
 
 Inpin::Inpin(Filter* p, const wchar_t* id) :
     Pin(p, id, PINDIR_INPUT),
+    m_pipeline_stats(id),
     m_pStream(0)
 {
     m_hSample = CreateEvent(0, 0, 0, 0);
@@ -421,7 +422,14 @@ HRESULT Inpin::Receive(IMediaSample* pSample)
     if (m_bFlush)
         return S_FALSE;
 
-    hr = m_pStream->Receive(pSample);
+    m_pipeline_stats.OnInput(pSample->GetActualDataLength());
+
+    {
+        const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+        hr = m_pStream->Receive(pSample);
+    }
+
+    m_pipeline_stats.OnQueueDepth(m_pStream->GetQueueDepth());
 
     if (hr != S_OK)
         return hr;
@@ -475,6 +483,8 @@ HRESULT Inpin::Wait(CLockable::Lock& lock)
     wodbgstream os;
 #endif
 
+    bool bStarved = false;
+
     for (;;)
     {
         if (m_bFlush)
@@ -522,6 +532,12 @@ HRESULT Inpin::Wait(CLockable::Lock& lock)
         assert(bool(m_pPinConnection));
         assert(!m_bEndOfStream);
 
+        if (!bStarved)  //count each sample once, however often we wake
+        {
+            m_pipeline_stats.OnStarved();
+            bStarved = true;
+        }
+
         lock.Release();
 
         DWORD index;
@@ -614,7 +630,12 @@ HRESULT Inpin::ReceiveMultiple(
         }
 #endif
 
-        const HRESULT hr = m_pStream->Receive(pSample);
+        m_pipeline_stats.OnInput(pSample->GetActualDataLength());
+
+        {
+            const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+            hr = m_pStream->Receive(pSample);
+        }
 
         if (hr != S_OK)
         {
@@ -627,6 +648,8 @@ HRESULT Inpin::ReceiveMultiple(
         ++m;
     }
 
+    m_pipeline_stats.OnQueueDepth(m_pStream->GetQueueDepth());
+
     const BOOL b = SetEvent(m_hSample);  //notify other pin
     assert(b);
 
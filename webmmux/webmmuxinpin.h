@@ -9,6 +9,7 @@
 #pragma once
 #include "webmmuxpin.h"
 #include "clockable.h"
+#include "pipelinestats.h"
 
 namespace WebmMuxLib
 {
@@ -90,6 +91,11 @@ public:
 
     HANDLE m_hSample;
 
+    //Samples in, time spent parsing (and writing, when the frame can be
+    //written immediately), frames pending in the stream, and how often
+    //we had to wait for the other stream to catch up.
+    WebmUtil::PipelineStats m_pipeline_stats;
+
 protected:
 
    virtual HRESULT OnReceiveConnection(IPin*, const AM_MEDIA_TYPE&);
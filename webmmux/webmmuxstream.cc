@@ -7,6 +7,7 @@
 // be found in the AUTHORS file in the root of the source tree.
 
 #include <strmif.h>
+#include "ebmlwriter.h"
 #include "webmconstants.h"
 #include "webmmuxstream.h"
 #include "webmmuxcontext.h"
@@ -65,25 +66,28 @@ int Stream::GetTrackNumber() const
 
 void Stream::WriteTrackEntry(int tn)
 {
+    typedef WebmUtil::EbmlMaster<WebmUtil::kEbmlTrackEntryID, 2> TrackEntry;
+
     WebmUtil::EbmlScratchBuf& entry_buf = m_context.m_buf;
 
     // we need the starting length of |entry_buf| to properly calculate
     // |num_bytes_to_ignore|
     const uint64 buf_start_len = entry_buf.GetBufferLength();
 
-    entry_buf.WriteID1(WebmUtil::kEbmlTrackEntryID);
-
     // store entry offset for patching later
-    const uint64 entry_len_offset = entry_buf.GetBufferLength();
+    const uint64 entry_len_offset =
+        buf_start_len +
+        WebmUtil::EbmlElementID<WebmUtil::kEbmlTrackEntryID>::kLength;
 
     // We must exclude |num_bytes_to_ignore| from the size we obtain from
     // |entry_buf|.  The value from |entry_buf| includes the bytes storing
     // all preceding data in the track entry -- using it as-is would result
     // in an invalid tracks element.
-    const uint64 num_bytes_to_ignore = buf_start_len + 1 + sizeof(uint16);
+    const uint64 num_bytes_to_ignore =
+        buf_start_len + TrackEntry::kHeaderLength;
 
     // reserve 2 bytes for patching in the size...
-    entry_buf.Serialize2UInt(0);
+    TrackEntry::Store(entry_buf.Append(TrackEntry::kHeaderLength));
 
     WriteTrackNumber(tn);
     WriteTrackUID();
@@ -109,9 +113,8 @@ void Stream::WriteTrackNumber(int tn_)
     m_trackNumber = tn_;
     const uint8 track_num = static_cast<uint8>(tn_);
 
-    buf.WriteID1(WebmUtil::kEbmlTrackNumberID);
-    buf.Write1UInt(1);
-    buf.Serialize1UInt(track_num);
+    typedef WebmUtil::EbmlUInt<WebmUtil::kEbmlTrackNumberID, 1> TrackNumber;
+    TrackNumber::Store(buf.Append(TrackNumber::kLength), track_num);
 }
 
 
@@ -121,9 +124,8 @@ void Stream::WriteTrackUID()
 
     const TrackUID_t uid = CreateTrackUID();
 
-    buf.WriteID2(WebmUtil::kEbmlTrackUIDID);
-    buf.Write1UInt(8);
-    buf.Serialize8UInt(uid);
+    typedef WebmUtil::EbmlUInt<WebmUtil::kEbmlTrackUIDID, 8> TrackUID;
+    TrackUID::Store(buf.Append(TrackUID::kLength), uid);
 }
 
 
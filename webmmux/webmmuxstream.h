@@ -28,6 +28,7 @@ public:
     virtual int EndOfStream() = 0;
     virtual void Flush() = 0;
     virtual bool Wait() const = 0;
+    virtual long GetQueueDepth() const = 0;  //frames not yet written
 
     void SetTrackNumber(int);
     int GetTrackNumber() const;
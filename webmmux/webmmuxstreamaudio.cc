@@ -7,6 +7,7 @@
 // be found in the AUTHORS file in the root of the source tree.
 
 #include <strmif.h>
+#include "ebmlwriter.h"
 #include "webmconstants.h"
 #include "webmmuxcontext.h"
 #include <cstdlib>
@@ -49,6 +50,12 @@ bool StreamAudio::Wait() const
 }
 
 
+long StreamAudio::GetQueueDepth() const
+{
+    return static_cast<long>(m_frames.size());
+}
+
+
 const void* StreamAudio::GetFormat(ULONG& cb) const
 {
     cb = m_cFormat;
@@ -60,52 +67,45 @@ void StreamAudio::WriteTrackType()
 {
     WebmUtil::EbmlScratchBuf& buf = m_context.m_buf;
 
-    buf.WriteID1(WebmUtil::kEbmlTrackTypeID);
-    buf.Write1UInt(1);
-    buf.Serialize1UInt(WebmUtil::kEbmlTrackTypeAudio);
+    typedef WebmUtil::EbmlUInt<WebmUtil::kEbmlTrackTypeID, 1> TrackType;
+    TrackType::Store(buf.Append(TrackType::kLength),
+                     WebmUtil::kEbmlTrackTypeAudio);
 }
 
 
 void StreamAudio::WriteTrackSettings()
 {
-    WebmUtil::EbmlScratchBuf& buf = m_context.m_buf;
+    using WebmUtil::EbmlFloat;
+    using WebmUtil::EbmlMaster;
+    using WebmUtil::EbmlUInt;
 
-    // we need the starting length of |buf| to properly calculate
-    // |num_bytes_to_ignore|
-    const uint64 buf_start_len = buf.GetBufferLength();
+    typedef EbmlMaster<WebmUtil::kEbmlAudioSettingsID, 2> Audio;
+    typedef EbmlFloat<WebmUtil::kEbmlSamplingFrequencyID> SamplingFrequency;
+    typedef EbmlUInt<WebmUtil::kEbmlChannelsID, 1> Channels;
 
-    buf.WriteID1(WebmUtil::kEbmlAudioSettingsID);
-
-    // store audio settings offset for patching later
-    const uint64 audio_len_offset = buf.GetBufferLength();
-
-    // We must exclude |num_bytes_to_ignore| from the size we obtain from
-    // |buf|.  The value from |buf| includes the bytes storing all preceding
-    // data in the track entry -- using it as-is would result in an invalid
-    // tracks element.
-    const uint64 num_bytes_to_ignore = buf_start_len + 1 + sizeof(uint16);
-
-    // reserve 2 bytes for size of settings
-    buf.Serialize2UInt(0);
+    enum
+    {
+        kLength = Audio::kHeaderLength +
+                  SamplingFrequency::kLength +
+                  Channels::kLength
+    };
 
     const uint32 samples_per_sec_ = GetSamplesPerSec();
     assert(samples_per_sec_ > 0);
 
     const float samples_per_sec = static_cast<float>(samples_per_sec_);
 
-    buf.WriteID1(WebmUtil::kEbmlSamplingFrequencyID);
-    buf.Write1UInt(4);
-    buf.Serialize4Float(samples_per_sec);
-
     const uint8 channels = GetChannels();
     assert(channels > 0);
 
-    buf.WriteID1(WebmUtil::kEbmlChannelsID);
-    buf.Write1UInt(1);
-    buf.Serialize1UInt(channels);
+    // The settings are all known up front, so they're written in place,
+    // size and all.
+    WebmUtil::EbmlWriter w(m_context.m_buf.Append(kLength), kLength);
 
-    const uint64 audio_len = buf.GetBufferLength() - num_bytes_to_ignore;
-    buf.RewriteUInt(audio_len_offset, audio_len, sizeof(uint16));
+    uint8* const audio = w.Begin<Audio>();
+    w.WriteFloat<SamplingFrequency>(samples_per_sec);
+    w.Write<Channels>(channels);
+    w.End<Audio>(audio);
 }
 
 
@@ -35,6 +35,7 @@ protected:
 public:
     void Flush();
     bool Wait() const;
+    long GetQueueDepth() const;
 
     class AudioFrame : public Frame
     {
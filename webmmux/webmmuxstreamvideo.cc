@@ -7,6 +7,7 @@
 // be found in the AUTHORS file in the root of the source tree.
 
 #include <strmif.h>
+#include "ebmlwriter.h"
 #include "webmconstants.h"
 #include "webmmuxcontext.h"
 #include "mediatypeutil.h"
@@ -112,9 +113,9 @@ void StreamVideo::WriteTrackType()
 {
     WebmUtil::EbmlScratchBuf& buf = m_context.m_buf;
 
-    buf.WriteID1(WebmUtil::kEbmlTrackTypeID);
-    buf.Write1UInt(1);
-    buf.Serialize1UInt(WebmUtil::kEbmlTrackTypeVideo);
+    typedef WebmUtil::EbmlUInt<WebmUtil::kEbmlTrackTypeID, 1> TrackType;
+    TrackType::Store(buf.Append(TrackType::kLength),
+                     WebmUtil::kEbmlTrackTypeVideo);
 }
 
 
@@ -124,6 +125,12 @@ bool StreamVideo::Wait() const
 }
 
 
+long StreamVideo::GetQueueDepth() const
+{
+    return static_cast<long>(m_vframes.size());
+}
+
+
 StreamVideo::frames_t& StreamVideo::GetFrames()
 {
     return m_vframes;
@@ -27,6 +27,7 @@ protected:
 public:
     void Flush();
     bool Wait() const;
+    long GetQueueDepth() const;
 
     class VideoFrame : public Frame
     {
@@ -7,6 +7,7 @@
 // be found in the AUTHORS file in the root of the source tree.
 
 #include <strmif.h>
+#include "ebmlwriter.h"
 #include "webmconstants.h"
 #include "webmmuxcontext.h"
 #include "webmmuxstreamvideovpx.h"
@@ -160,25 +161,14 @@ void StreamVideoVPx::WriteTrackCodecName()
 
 void StreamVideoVPx::WriteTrackSettings()
 {
-    WebmUtil::EbmlScratchBuf& buf = m_context.m_buf;
-
-    // we need the starting length of |buf| to properly calculate
-    // |num_bytes_to_ignore|
-    const uint64 buf_start_len = buf.GetBufferLength();
-
-    buf.WriteID1(WebmUtil::kEbmlVideoSettingsID);
+    using WebmUtil::EbmlFloat;
+    using WebmUtil::EbmlMaster;
+    using WebmUtil::EbmlUInt;
 
-    // store length offset for patching later
-    const uint64 len_offset = buf.GetBufferLength();
-
-    // We must exclude |num_bytes_to_ignore| from the size we obtain from
-    // |buf|.  The value from |buf| includes the bytes storing all preceding
-    // data in the track entry -- using it as-is would result in an invalid
-    // tracks element.
-    const uint64 num_bytes_to_ignore = buf_start_len + 1 + sizeof(uint16);
-
-    // reserve 2 bytes for patching in the size...
-    buf.Serialize2UInt(0);
+    typedef EbmlMaster<WebmUtil::kEbmlVideoSettingsID, 2> Video;
+    typedef EbmlUInt<WebmUtil::kEbmlVideoWidth, 2> Width;
+    typedef EbmlUInt<WebmUtil::kEbmlVideoHeight, 2> Height;
+    typedef EbmlFloat<WebmUtil::kEbmlVideoFrameRate> FrameRate;
 
     const BITMAPINFOHEADER& bmih = GetBitmapInfoHeader();
     assert(bmih.biSize >= sizeof(BITMAPINFOHEADER));
@@ -190,25 +180,27 @@ void StreamVideoVPx::WriteTrackSettings()
     const uint16 width = static_cast<uint16>(bmih.biWidth);
     const uint16 height = static_cast<uint16>(bmih.biHeight);
 
-    buf.WriteID1(WebmUtil::kEbmlVideoWidth);
-    buf.Write1UInt(2);
-    buf.Serialize2UInt(width);
+    const float framerate = GetFramerate();
 
-    buf.WriteID1(WebmUtil::kEbmlVideoHeight);
-    buf.Write1UInt(2);
-    buf.Serialize2UInt(height);
+    const int32 len = Video::kHeaderLength +
+                      Width::kLength +
+                      Height::kLength +
+                      ((framerate > 0) ? FrameRate::kLength : 0);
 
-    const float framerate = GetFramerate();
+    // The settings are all known up front, so they're written in place,
+    // size and all.
+    WebmUtil::EbmlWriter w(m_context.m_buf.Append(len), len);
+
+    uint8* const video = w.Begin<Video>();
+
+    w.Write<Width>(width);
+    w.Write<Height>(height);
 
     if (framerate > 0)
-    {
-        buf.WriteID3(WebmUtil::kEbmlVideoFrameRate);
-        buf.Write1UInt(4);
-        buf.Serialize4Float(framerate);
-    }
+        w.WriteFloat<FrameRate>(framerate);
 
-    const uint64 video_len = buf.GetBufferLength() - num_bytes_to_ignore;
-    buf.RewriteUInt(len_offset, video_len, sizeof(uint16));
+    w.End<Video>(video);
+    assert(w.GetLength() == len);
 }
 
 
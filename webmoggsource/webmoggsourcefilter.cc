@@ -166,6 +166,10 @@ HRESULT Filter::nondelegating_t::QueryInterface(
     {
         pUnk = static_cast<IAMFilterMiscFlags*>(m_pFilter);
     }
+    else if (iid == __uuidof(IPipelineStats))
+    {
+        pUnk = static_cast<IPipelineStats*>(m_pFilter);
+    }
     else
     {
 #if 0
@@ -715,6 +719,70 @@ ULONG Filter::GetMiscFlags()
 }
 
 
+ULONG Filter::GetStreamCount()
+{
+    //One stream per outpin (that is, per track).
+
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return 0;
+
+    return static_cast<ULONG>(m_pins.size());
+}
+
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (index >= m_pins.size())
+        return E_INVALIDARG;
+
+    const Outpin* const pin = m_pins[index];
+    assert(pin);
+
+    pin->m_pipeline_stats.GetSnapshot(*p);
+    return S_OK;
+}
+
+
+HRESULT Filter::ResetStats()
+{
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    typedef pins_t::iterator iter_t;
+
+    iter_t i = m_pins.begin();
+    const iter_t j = m_pins.end();
+
+    while (i != j)
+    {
+        Outpin* const pin = *i++;
+        assert(pin);
+
+        pin->m_pipeline_stats.Reset();
+    }
+
+    return S_OK;
+}
+
+
 void Filter::OnStart()
 {
     typedef pins_t::iterator iter_t;
@@ -10,6 +10,7 @@
 #include <strmif.h>
 #include <string>
 #include "clockable.h"
+#include "ipipelinestats.h"
 #include "oggfile.h"
 #include <vector>
 
@@ -21,6 +22,7 @@ class Outpin;
 class Filter : public IBaseFilter,
                public IFileSourceFilter,
                public IAMFilterMiscFlags,
+               public IPipelineStats,
                public CLockable
 {
     friend HRESULT CreateInstance(
@@ -67,6 +69,12 @@ public:
 
     ULONG STDMETHODCALLTYPE GetMiscFlags();
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
 #if 0  //TODO
 
     //local classes and methods
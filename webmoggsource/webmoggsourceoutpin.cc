@@ -1175,8 +1175,13 @@ unsigned Outpin::Main()
 
         long nProcessed;
 
+        m_pipeline_stats.OnQueueDepth(nSamples);
+
         hr = m_pInputPin->ReceiveMultiple(pSamples, nSamples, &nProcessed);
 
+        for (long i = 0; i < nProcessed; ++i)
+            m_pipeline_stats.OnOutput(pSamples[i]->GetActualDataLength());
+
         if (hr != S_OK)  //TODO: signal error to FGM
             break;
 
@@ -1226,7 +1231,12 @@ HRESULT Outpin::PopulateSamples(OggTrack::samples_t& samples)
         {
             IMediaSample* sample;
 
-            hr = m_pAllocator->GetBuffer(&sample, 0, 0, 0);
+            {
+                const WebmUtil::PipelineStats::WaitTimer timer(
+                    m_pipeline_stats);
+
+                hr = m_pAllocator->GetBuffer(&sample, 0, 0, 0);
+            }
 
             if (hr != S_OK)
                 return E_FAIL;  //we're done
@@ -1239,7 +1249,10 @@ HRESULT Outpin::PopulateSamples(OggTrack::samples_t& samples)
         if (FAILED(hr))
             return hr;
 
-        hr = m_pTrack->PopulateSamples(samples);
+        {
+            const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+            hr = m_pTrack->PopulateSamples(samples);
+        }
 
         if (FAILED(hr))
             return hr;
@@ -24,7 +24,8 @@ Pin::Pin(
     : m_pFilter(pFilter),
       m_dir(dir),
       m_id(id),
-      m_connection(0)
+      m_connection(0),
+      m_pipeline_stats(id)
 {
 }
 
@@ -11,6 +11,7 @@
 #include <string>
 #include "mkvfile.h"
 #include "clockable.h"
+#include "ipipelinestats.h"
 #include <vector>
 
 namespace mkvparser
@@ -28,6 +29,7 @@ class Outpin;
 class Filter : public IBaseFilter,
                public IFileSourceFilter,
                public IAMFilterMiscFlags,
+               public IPipelineStats,
                public CLockable
 {
     friend HRESULT CreateInstance(
@@ -74,6 +76,12 @@ public:
 
     ULONG STDMETHODCALLTYPE GetMiscFlags();
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
 
     //local classes and methods
 
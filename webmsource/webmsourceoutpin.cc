@@ -1144,8 +1144,13 @@ unsigned Outpin::Main()
 
         long nProcessed;
 
+        m_pipeline_stats.OnQueueDepth(nSamples);
+
         hr = m_pInputPin->ReceiveMultiple(pSamples, nSamples, &nProcessed);
 
+        for (long i = 0; i < nProcessed; ++i)
+            m_pipeline_stats.OnOutput(pSamples[i]->GetActualDataLength());
+
         //TODO: there is a potential problem here.  If the upstream decoder
         //rejects the sample (problem with bitstream, etc), then this
         //terminates this streaming thread, but the filter isn't in the
@@ -1218,7 +1223,12 @@ HRESULT Outpin::PopulateSamples(mkvparser::Stream::samples_t& samples)
         {
             IMediaSample* sample;
 
-            hr = m_pAllocator->GetBuffer(&sample, 0, 0, 0);
+            {
+                const WebmUtil::PipelineStats::WaitTimer timer(
+                    m_pipeline_stats);
+
+                hr = m_pAllocator->GetBuffer(&sample, 0, 0, 0);
+            }
 
             if (hr != S_OK)
                 return E_FAIL;  //we're done
@@ -1231,18 +1241,22 @@ HRESULT Outpin::PopulateSamples(mkvparser::Stream::samples_t& samples)
         if (FAILED(hr))
             return hr;
 
-        for (;;)
         {
-            hr = m_pStream->PopulateSamples(samples);
+            const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
 
-            if (SUCCEEDED(hr))
-                break;
+            for (;;)
+            {
+                hr = m_pStream->PopulateSamples(samples);
 
-            if (hr != VFW_E_BUFFER_UNDERFLOW)
-                return hr;
+                if (SUCCEEDED(hr))
+                    break;
 
-            const long status = pSegment->LoadCluster();
-            assert(status >= 0);
+                if (hr != VFW_E_BUFFER_UNDERFLOW)
+                    return hr;
+
+                const long status = pSegment->LoadCluster();
+                assert(status >= 0);
+            }
         }
 
         if (hr != 2)
@@ -8,6 +8,7 @@
 
 #pragma once
 #include "cmediatypes.h"
+#include "pipelinestats.h"
 #include <string>
 
 namespace WebmSource
@@ -32,6 +33,7 @@ public:
     CMediaTypes m_preferred_mtv;
     CMediaTypes m_connection_mtv;  //only one of these
     IPin* m_connection;
+    WebmUtil::PipelineStats m_pipeline_stats;
 
     //IUnknown interface:
 
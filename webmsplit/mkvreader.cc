@@ -12,19 +12,260 @@
 #include <cassert>
 #include <algorithm>
 #include <vfwmsgs.h>
+#include <vector>
+#include <new>
 #include "clockable.h"
 #pragma warning(default:4702)
 
 namespace WebmSplit
 {
 
-MkvReader::MkvReader() : m_sync_read(true)
+//The count of samples downstream that refer to each page in place, and
+//their total.  The reader and each FrameLock hold a reference, so that
+//a sample released after the reader has decommitted (or been destroyed)
+//still has counts to decrement.
+
+class MkvReader::ExtLocks
+{
+    ExtLocks(const ExtLocks&);
+    ExtLocks& operator=(const ExtLocks&);
+
+public:
+    static ExtLocks* Create(long count);
+
+    void AddRef();
+    void Release();
+
+    volatile LONG* GetCount(long index);
+    LONG GetTotal() const;
+
+    void Lock(volatile LONG*);
+    void Unlock(volatile LONG*);
+
+private:
+    explicit ExtLocks(LONG*);
+    ~ExtLocks();
+
+    volatile LONG m_cRef;
+    volatile LONG m_total;  //pages locked downstream, summed over samples
+    LONG* const m_counts;
+
+};
+
+
+MkvReader::ExtLocks* MkvReader::ExtLocks::Create(long count)
+{
+    assert(count > 0);
+
+    LONG* const counts = new (std::nothrow) LONG[count];
+
+    if (counts == 0)
+        return 0;
+
+    std::fill(counts, counts + count, 0L);
+
+    ExtLocks* const p = new (std::nothrow) ExtLocks(counts);
+
+    if (p == 0)
+        delete[] counts;
+
+    return p;
+}
+
+
+MkvReader::ExtLocks::ExtLocks(LONG* counts) :
+    m_cRef(1),
+    m_total(0),
+    m_counts(counts)
+{
+}
+
+
+MkvReader::ExtLocks::~ExtLocks()
+{
+    assert(m_total == 0);
+    delete[] m_counts;
+}
+
+
+void MkvReader::ExtLocks::AddRef()
+{
+    InterlockedIncrement(&m_cRef);
+}
+
+
+void MkvReader::ExtLocks::Release()
+{
+    if (InterlockedDecrement(&m_cRef) == 0)
+        delete this;
+}
+
+
+volatile LONG* MkvReader::ExtLocks::GetCount(long index)
+{
+    return m_counts + index;
+}
+
+
+LONG MkvReader::ExtLocks::GetTotal() const
+{
+    return m_total;
+}
+
+
+void MkvReader::ExtLocks::Lock(volatile LONG* pCount)
+{
+    InterlockedIncrement(pCount);
+    InterlockedIncrement(&m_total);
+}
+
+
+void MkvReader::ExtLocks::Unlock(volatile LONG* pCount)
+{
+    const LONG n = InterlockedDecrement(pCount);
+    assert(n >= 0);
+    (void)n;
+
+    InterlockedDecrement(&m_total);
+}
+
+
+//Keeps the pages spanned by a frame locked, while a sample that refers
+//to the frame in place is outstanding downstream.  The final release
+//happens on whatever thread releases the sample, so the page counts
+//are adjusted without holding the filter lock.  The lock holds its own
+//references to the page buffers and to the counts, and doesn't refer to
+//the reader or its Page entries, so it's safe for it to outlive them.
+
+class MkvReader::FrameLock : public IUnknown
+{
+    FrameLock(const FrameLock&);
+    FrameLock& operator=(const FrameLock&);
+
+public:
+    typedef std::vector<Page*> pages_t;
+
+    FrameLock(ExtLocks*, const pages_t&);
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(const IID&, void**);
+    ULONG STDMETHODCALLTYPE AddRef();
+    ULONG STDMETHODCALLTYPE Release();
+
+private:
+    ~FrameLock();
+
+    struct Entry
+    {
+        volatile LONG* pCount;
+        GraphUtil::IMediaSamplePtr pSample;  //keeps the memory valid
+    };
+
+    typedef std::vector<Entry> entries_t;
+
+    LONG m_cRef;
+    ExtLocks* const m_pExtLocks;
+    entries_t m_entries;
+
+};
+
+
+MkvReader::FrameLock::FrameLock(ExtLocks* pExtLocks, const pages_t& pages) :
+    m_cRef(1),
+    m_pExtLocks(pExtLocks)
+{
+    assert(m_pExtLocks);
+    m_pExtLocks->AddRef();
+
+    m_entries.reserve(pages.size());
+
+    typedef pages_t::const_iterator iter_t;
+
+    iter_t i = pages.begin();
+    const iter_t j = pages.end();
+
+    while (i != j)
+    {
+        const Page* const pPage = *i++;
+        assert(pPage);
+        assert(pPage->pExtRef);
+        assert(pPage->pSample);
+
+        Entry e;
+
+        e.pCount = pPage->pExtRef;
+        e.pSample = pPage->pSample;
+
+        m_pExtLocks->Lock(e.pCount);
+        m_entries.push_back(e);
+    }
+}
+
+
+MkvReader::FrameLock::~FrameLock()
+{
+    typedef entries_t::const_iterator iter_t;
+
+    iter_t i = m_entries.begin();
+    const iter_t j = m_entries.end();
+
+    while (i != j)
+    {
+        const Entry& e = *i++;
+        m_pExtLocks->Unlock(e.pCount);
+    }
+
+    m_entries.clear();  //release the page buffers
+    m_pExtLocks->Release();
+}
+
+
+HRESULT MkvReader::FrameLock::QueryInterface(const IID& iid, void** ppv)
+{
+    if (ppv == 0)
+        return E_POINTER;
+
+    IUnknown*& pUnk = reinterpret_cast<IUnknown*&>(*ppv);
+
+    if (iid == __uuidof(IUnknown))
+        pUnk = this;
+    else
+    {
+        pUnk = 0;
+        return E_NOINTERFACE;
+    }
+
+    pUnk->AddRef();
+    return S_OK;
+}
+
+
+ULONG MkvReader::FrameLock::AddRef()
+{
+    return InterlockedIncrement(&m_cRef);
+}
+
+
+ULONG MkvReader::FrameLock::Release()
+{
+    if (LONG n = InterlockedDecrement(&m_cRef))
+        return n;
+
+    delete this;
+    return 0;
+}
+
+
+MkvReader::MkvReader() :
+    m_pExtLocks(0),
+    m_sync_read(true)
 {
 }
 
 
 MkvReader::~MkvReader()
 {
+    if (m_pExtLocks)
+        m_pExtLocks->Release();
 }
 
 
@@ -106,12 +347,13 @@ HRESULT MkvReader::Commit()
     //no thread synchronization is performed.
 
     assert(m_pages.empty());
+    assert(m_empty_pages.empty());
     assert(m_free_pages.empty());
 
     if (m_pAllocator == 0)
         return VFW_E_NO_ALLOCATOR;
 
-    const HRESULT hr = m_pAllocator->Commit();
+    HRESULT hr = m_pAllocator->Commit();
 
     if (FAILED(hr))
         return hr;
@@ -119,16 +361,55 @@ HRESULT MkvReader::Commit()
     const long n = m_props.cBuffers;
     assert(n > 0);
 
+    assert(m_pExtLocks == 0);
+    m_pExtLocks = ExtLocks::Create(n);
+
+    if (m_pExtLocks == 0)
+    {
+        m_pAllocator->Decommit();
+        return E_OUTOFMEMORY;
+    }
+
     for (long i = 0; i < n; ++i)
     {
         Page page;
 
         page.cRef = 0;
+        page.pExtRef = m_pExtLocks->GetCount(i);
         page.pSample = 0;
 
+        //We acquire all of the buffers up front (instead of lazily, as
+        //pages are needed), so that the pages can be sorted by address.
+        //FindFreePage uses that ordering to load consecutive file pages
+        //into consecutive memory pages, which allows most frames to be
+        //delivered downstream without a copy (see LockFrame).  A buffer
+        //still held by a sample from before the last Decommit isn't
+        //waited for here; its page stays empty until FillEmptyPage.
+
+        hr = m_pAllocator->GetBuffer(&page.pSample, 0, 0, AM_GBF_NOWAIT);
+
+        if (FAILED(hr))
+        {
+            page.pSample = 0;
+            m_empty_pages.push_back(page);
+
+            continue;
+        }
+
+        assert(page.pSample);
+
+        LONGLONG st = -10000000;  //means "page not loaded"
+        LONGLONG sp = 0;
+
+        hr = page.pSample->SetTime(&st, &sp);
+        assert(SUCCEEDED(hr));
+        assert(page.GetPos() < 0);
+
         m_pages.push_back(page);
     }
 
+    m_pages.sort(PointerLess());
+
     typedef pages_list_t::iterator iter_t;
 
     iter_t iter = m_pages.begin();
@@ -153,24 +434,30 @@ HRESULT MkvReader::Decommit()
     //to stopped, but after any other threads have been destroyed.  Therefore
     //no thread synchronization is performed.
 
+    //Samples downstream that still refer to pages in place keep their
+    //own references to the page buffers (which the allocator frees only
+    //once they're all returned), and to the counts, so the pages can be
+    //let go here without waiting for them.
+
     m_free_pages.clear();
+    m_cache.clear();
+    m_empty_pages.clear();
 
     while (!m_pages.empty())
     {
         Page& page = m_pages.front();
         assert(page.cRef == 0);
 
-        if (page.pSample)
-        {
-            const ULONG n = page.pSample->Release();
-            n;
-
-            page.pSample = 0;
-        }
-
+        page.pSample = 0;
         m_pages.pop_front();
     }
 
+    if (m_pExtLocks)
+    {
+        m_pExtLocks->Release();
+        m_pExtLocks = 0;
+    }
+
     if (m_pAllocator == 0)
         return S_OK;
 
@@ -313,21 +600,26 @@ int MkvReader::InsertPage(
 {
     FreeOne(next);
 
-    if (m_free_pages.empty())  //error: all samples are busy
+    if (m_free_pages.empty())  //all samples are busy
+    {
+        //If some buffers are still downstream, try again once they've
+        //been released (we don't block here, holding the filter lock).
+
+        if (!m_empty_pages.empty())
+            return mkvparser::E_BUFFER_NOT_FULL;
+
         return -1;  //generic error
+    }
 
     const DWORD page_size = m_props.cbBuffer;
 
     const LONGLONG page_pos = page_size * LONGLONG(pos / page_size);
     assert((next == m_cache.end()) || ((*next)->GetPos() > page_pos));
 
-    free_pages_t::iterator free_page = m_free_pages.find(page_pos);
-
-    if (free_page == m_free_pages.end())
-        free_page = m_free_pages.begin();
+    const free_pages_t::iterator free_page = FindFreePage(next, page_pos);
 
     const pages_list_t::iterator page_iter = free_page->second;
-    assert(page_iter->cRef == 0);
+    assert(!page_iter->IsLocked());
 
     if (page_iter->GetPos() == page_pos)
     {
@@ -368,31 +660,25 @@ int MkvReader::InsertPage(
     if ((page_end <= total) && (page_end > available))
         return mkvparser::E_BUFFER_NOT_FULL;
 
-    HRESULT hr;
-
     Page& page = *page_iter;
-
-    if (page.pSample == 0)
-    {
-        hr = m_pAllocator->GetBuffer(&page.pSample, 0, 0, 0);
-        assert(SUCCEEDED(hr));
-        assert(page.pSample);
-    }
+    assert(page.pSample);  //free pages always have a buffer
 
     LONGLONG st = page_pos * 10000000;
     LONGLONG sp = page_end * 10000000;
 
-    hr = page.pSample->SetTime(&st, &sp);
+    HRESULT hr = page.pSample->SetTime(&st, &sp);
     assert(SUCCEEDED(hr));
 
     hr = m_pSource->SyncReadAligned(page.pSample);
 
     if (FAILED(hr))  //VFW_S_WRONG_STATE
     {
-        const ULONG cRef = page.pSample->Release();
-        cRef;
+        //The page's buffer is given back; it becomes an empty page.
+
+        m_free_pages.erase(free_page);
 
         page.pSample = 0;
+        m_empty_pages.splice(m_empty_pages.end(), m_pages, page_iter);
 
         return -1;  //generic error value
     }
@@ -446,7 +732,7 @@ void MkvReader::PurgeOne()
         const cache_t::value_type page_iter = m_cache.front();
         const Page& page = *page_iter;
 
-        if (page.cRef <= 0)
+        if (!page.IsLocked())
         {
             m_cache.pop_front();
 
@@ -461,7 +747,7 @@ void MkvReader::PurgeOne()
         const cache_t::value_type page_iter = m_cache.back();
         const Page& page = *page_iter;
 
-        if (page.cRef <= 0)
+        if (!page.IsLocked())
         {
             m_cache.pop_back();
 
@@ -481,7 +767,7 @@ void MkvReader::PurgeOne()
             const cache_t::value_type page_iter = *cache_iter;
             const Page& page = *page_iter;
 
-            if (page.cRef == 0)
+            if (!page.IsLocked())
             {
                 m_cache.erase(cache_iter);
 
@@ -511,7 +797,10 @@ LONGLONG MkvReader::Page::GetPos() const
 
     const HRESULT hr = pSample->GetTime(&st, &sp);
     assert(SUCCEEDED(hr));
-    assert(st >= 0);
+
+    if (st < 0)  //buffer acquired during Commit, but not loaded yet
+        return -1;
+
     assert((st % 10000000) == 0);
 
     const LONGLONG pos = st / 10000000;
@@ -519,6 +808,89 @@ LONGLONG MkvReader::Page::GetPos() const
 }
 
 
+BYTE* MkvReader::Page::GetPointer() const
+{
+    if (pSample == 0)
+        return 0;
+
+    BYTE* ptr;
+
+    const HRESULT hr = pSample->GetPointer(&ptr);
+    assert(SUCCEEDED(hr));
+    assert(ptr);
+
+    return ptr;
+}
+
+
+bool MkvReader::Page::IsLocked() const
+{
+    return ((cRef > 0) || (*pExtRef > 0));
+}
+
+
+MkvReader::free_pages_t::iterator
+MkvReader::FindFreePage(cache_t::iterator next, LONGLONG page_pos)
+{
+    assert(!m_free_pages.empty());
+
+    typedef free_pages_t::iterator iter_t;
+
+    {
+        const iter_t i = m_free_pages.find(page_pos);
+
+        if (i != m_free_pages.end())  //page is already loaded
+            return i;
+    }
+
+    //If the file page that precedes page_pos is in the cache, then try
+    //to use the memory page that immediately follows it.  The pages list
+    //is sorted by address, so that's the next page in the list.
+
+    if (next == m_cache.begin())
+        return m_free_pages.begin();
+
+    const cache_t::value_type prev_iter = *--cache_t::iterator(next);
+    const Page& prev = *prev_iter;
+
+    const LONG page_size = m_props.cbBuffer;
+
+    if ((prev.GetPos() + page_size) != page_pos)
+        return m_free_pages.begin();
+
+    const BYTE* const prev_ptr = prev.GetPointer();
+
+    if (prev_ptr == 0)
+        return m_free_pages.begin();
+
+    pages_list_t::iterator page_iter = prev_iter;
+
+    if (++page_iter == m_pages.end())
+        return m_free_pages.begin();
+
+    const Page& page = *page_iter;
+
+    if (page.IsLocked() || (page.GetPointer() != (prev_ptr + page_size)))
+        return m_free_pages.begin();
+
+    typedef std::pair<iter_t, iter_t> range_t;
+
+    const range_t r = m_free_pages.equal_range(page.GetPos());
+
+    iter_t i = r.first;
+
+    while (i != r.second)
+    {
+        if (i->second == page_iter)
+            return i;
+
+        ++i;
+    }
+
+    return m_free_pages.begin();  //page is busy
+}
+
+
 HRESULT MkvReader::Wait(
     CLockable& lock,
     LONGLONG start_pos,
@@ -547,16 +919,10 @@ HRESULT MkvReader::Wait(
 
     Page& page = *page_iter;
     assert(page.cRef == 0);
+    assert(page.pSample);  //free pages always have a buffer
 
     HRESULT hr;
 
-    if (page.pSample == 0)
-    {
-        hr = m_pAllocator->GetBuffer(&page.pSample, 0, 0, 0);
-        assert(SUCCEEDED(hr));
-        assert(page.pSample);
-    }
-
 #if 0
     LONGLONG total, avail;
 
@@ -628,14 +994,8 @@ HRESULT MkvReader::Wait(
             break;
     }
 
-    const ULONG cRef = page.pSample->Release();
-    cRef;
-
     page.pSample = 0;
-    assert(page.GetPos() < 0);
-
-    const free_pages_t::value_type value(-1, page_iter);
-    m_free_pages.insert(value);
+    m_empty_pages.splice(m_empty_pages.end(), m_pages, page_iter);
 
     return VFW_E_TIMEOUT;
 }
@@ -658,6 +1018,12 @@ void MkvReader::FreeOne(cache_t::iterator& next)
     if (!m_free_pages.empty())
         return;
 
+    //A buffer that has come back from downstream is used before any page
+    //is purged from the cache.
+
+    if (FillEmptyPage())
+        return;
+
     LONGLONG next_pos;
 
     if (next == m_cache.end())
@@ -711,6 +1077,55 @@ void MkvReader::FreeOne(cache_t::iterator& next)
 }
 
 
+bool MkvReader::FillEmptyPage()
+{
+    //An empty page is one whose buffer couldn't be acquired without
+    //waiting, because a sample from before the last Decommit still held
+    //it (or whose buffer was given back after a failed read).  We never
+    //wait for a buffer, since we're called with the filter lock held, and
+    //downstream (a paused renderer, say) might hold on to it for a while.
+
+    if (m_empty_pages.empty())
+        return false;
+
+    const pages_list_t::iterator page_iter = m_empty_pages.begin();
+
+    Page& page = *page_iter;
+    assert(page.pSample == 0);
+    assert(page.cRef == 0);
+
+    HRESULT hr = m_pAllocator->GetBuffer(&page.pSample, 0, 0, AM_GBF_NOWAIT);
+
+    if (FAILED(hr))
+    {
+        page.pSample = 0;
+        return false;
+    }
+
+    assert(page.pSample);
+
+    LONGLONG st = -10000000;  //means "page not loaded"
+    LONGLONG sp = 0;
+
+    hr = page.pSample->SetTime(&st, &sp);
+    assert(SUCCEEDED(hr));
+
+    //Keep the pages list sorted by address (see FindFreePage).
+
+    typedef pages_list_t::iterator iter_t;
+
+    const iter_t pos =
+        std::upper_bound(m_pages.begin(), m_pages.end(), page, PointerLess());
+
+    m_pages.splice(pos, m_empty_pages, page_iter);
+
+    const free_pages_t::value_type value(-1, page_iter);
+    m_free_pages.insert(value);
+
+    return true;
+}
+
+
 HRESULT MkvReader::LockPages(const mkvparser::BlockEntry* pBE)
 {
     if (pBE == 0)
@@ -854,4 +1269,101 @@ void MkvReader::UnlockPages(const mkvparser::BlockEntry* pBE)
 }
 
 
+HRESULT MkvReader::LockFrame(
+    const mkvparser::Block::Frame& f,
+    unsigned char*& ptr,
+    IUnknown*& pOwner)
+{
+    //The caller has already locked the pages of the block (via LockPages),
+    //so all of the pages spanned by the frame are in the cache.  We just
+    //need to check whether they're adjacent in memory too.
+
+    ptr = 0;
+    pOwner = 0;
+
+    if (m_sync_read)  //cache isn't being used
+        return S_FALSE;
+
+    if ((f.pos < 0) || (f.len <= 0))
+        return S_FALSE;
+
+    if (m_cache.empty())
+        return S_FALSE;
+
+    const LONG page_size = m_props.cbBuffer;
+
+    LONGLONG pos = f.pos;
+    long len = f.len;
+
+    typedef cache_t::iterator iter_t;
+
+    const iter_t i = m_cache.begin();
+    const iter_t j = m_cache.end();
+
+    iter_t next = std::upper_bound(i, j, pos, PageLess());
+
+    if (next == i)
+        return S_FALSE;
+
+    --next;  //page containing pos
+
+    FrameLock::pages_t pages;
+
+    BYTE* base = 0;
+    const BYTE* expected = 0;
+
+    while (len > 0)
+    {
+        if (next == j)
+            return S_FALSE;
+
+        const cache_t::value_type page_iter = *next++;
+        Page& page = *page_iter;
+
+        const LONGLONG page_pos = page.GetPos();
+
+        if ((page_pos > pos) || (pos >= (page_pos + page_size)))
+            return S_FALSE;  //not resident (should not happen)
+
+        BYTE* const page_ptr = page.GetPointer();
+
+        if (page_ptr == 0)
+            return S_FALSE;
+
+        if (pages.empty())
+            base = page_ptr + static_cast<LONG>(pos - page_pos);
+
+        else if (page_ptr != expected)
+            return S_FALSE;  //frame spans non-contiguous pages: copy
+
+        expected = page_ptr + page_size;
+        pages.push_back(&page);
+
+        Read(page_iter, pos, len, 0);
+    }
+
+    //Don't let downstream hold more than half of the cache, so that there
+    //are always pages to purge; past that, frames are copied instead.
+    //(Without a bound, a filter that queues samples could starve the
+    //cache, and the parser would fail to load pages.)
+
+    const LONG max_ext_pages = static_cast<LONG>(m_pages.size() / 2);
+    const LONG ext_pages = static_cast<LONG>(pages.size());
+
+    if ((m_pExtLocks->GetTotal() + ext_pages) > max_ext_pages)
+        return S_FALSE;
+
+    FrameLock* const pLock =
+        new (std::nothrow) FrameLock(m_pExtLocks, pages);
+
+    if (pLock == 0)
+        return S_FALSE;
+
+    ptr = base;
+    pOwner = pLock;  //caller owns the reference
+
+    return S_OK;
+}
+
+
 } //end namespace WebmSplit
@@ -38,6 +38,11 @@ public:
     HRESULT LockPages(const mkvparser::BlockEntry*);
     void UnlockPages(const mkvparser::BlockEntry*);
 
+    HRESULT LockFrame(
+        const mkvparser::Block::Frame&,
+        unsigned char*&,
+        IUnknown*&);
+
     HRESULT Wait(CLockable&, LONGLONG pos, LONG size, DWORD timeout_ms);
 
     HRESULT BeginFlush();
@@ -53,13 +58,22 @@ private:
     struct Page
     {
         int cRef;
+        volatile LONG* pExtRef;  //samples delivered downstream, in place
         GraphUtil::IMediaSamplePtr pSample;
 
         LONGLONG GetPos() const;
+        BYTE* GetPointer() const;
+        bool IsLocked() const;
     };
 
+    class ExtLocks;
+    class FrameLock;
+
+    ExtLocks* m_pExtLocks;
+
     typedef std::list<Page> pages_list_t;
-    pages_list_t m_pages;
+    pages_list_t m_pages;        //sorted by address
+    pages_list_t m_empty_pages;  //no buffer yet (it's still downstream)
 
     typedef std::multimap<LONGLONG, pages_list_t::iterator> free_pages_t;
     free_pages_t m_free_pages;
@@ -85,6 +99,14 @@ private:
         }
     };
 
+    struct PointerLess
+    {
+        bool operator()(const Page& lhs, const Page& rhs) const
+        {
+            return (lhs.GetPointer() < rhs.GetPointer());
+        }
+    };
+
     HRESULT Commit();
     HRESULT Decommit();
 
@@ -98,6 +120,9 @@ private:
 
     void FreeOne(cache_t::iterator&);
     void PurgeOne();
+    bool FillEmptyPage();
+
+    free_pages_t::iterator FindFreePage(cache_t::iterator, LONGLONG);
 
 #if 0 //def _DEBUG
     LONGLONG m_total;
@@ -91,7 +91,8 @@ Filter::Filter(IClassFactory* pClassFactory, IUnknown* pOuter)
       m_seekBase_ns(-1),
       m_currTime(kNoSeek),
       m_inpin(this),
-      m_cStarvation(-1)  //means "not starving"
+      m_cStarvation(-1),  //means "not starving"
+      m_cStreamingWaiters(0)
 {
     m_pClassFactory->LockServer(TRUE);
 
@@ -102,6 +103,9 @@ Filter::Filter(IClassFactory* pClassFactory, IUnknown* pOuter)
     m_hNewCluster = CreateEvent(0, 0, 0, 0);
     assert(m_hNewCluster);  //TODO
 
+    m_hYield = CreateEvent(0, 0, 0, 0);
+    assert(m_hYield);  //TODO
+
     m_info.pGraph = 0;
     m_info.achName[0] = L'\0';
 
@@ -125,6 +129,13 @@ Filter::~Filter()
 
     assert(m_pSegment == 0);
 
+    if (m_hYield)
+    {
+        const BOOL b = CloseHandle(m_hYield);
+        b;
+        assert(b);
+    }
+
     m_pClassFactory->LockServer(FALSE);
 }
 
@@ -241,6 +252,10 @@ HRESULT Filter::CNondelegating::QueryInterface(
     {
         pUnk = static_cast<IBaseFilter*>(m_pFilter);
     }
+    else if (iid == __uuidof(IPipelineStats))
+    {
+        pUnk = static_cast<IPipelineStats*>(m_pFilter);
+    }
     else
     {
 #if 0
@@ -736,6 +751,71 @@ HRESULT Filter::QueryVendorInfo(LPWSTR* pstr)
 }
 
 
+ULONG Filter::GetStreamCount()
+{
+    //The inpin pulls from the source, so it has nothing to report;
+    //there's one stream per outpin (that is, per track).
+
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return 0;
+
+    return static_cast<ULONG>(m_outpins.size());
+}
+
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    if (index >= m_outpins.size())
+        return E_INVALIDARG;
+
+    const Outpin* const pin = m_outpins[index];
+    assert(pin);
+
+    pin->m_pipeline_stats.GetSnapshot(*p);
+    return S_OK;
+}
+
+
+HRESULT Filter::ResetStats()
+{
+    Lock lock;
+
+    const HRESULT hr = lock.Seize(this);
+
+    if (FAILED(hr))
+        return hr;
+
+    typedef outpins_t::iterator iter_t;
+
+    iter_t i = m_outpins.begin();
+    const iter_t j = m_outpins.end();
+
+    while (i != j)
+    {
+        Outpin* const pin = *i++;
+        assert(pin);
+
+        pin->m_pipeline_stats.Reset();
+    }
+
+    return S_OK;
+}
+
+
 HRESULT Filter::Open()
 {
     if (m_pSegment)
@@ -1017,7 +1097,15 @@ unsigned Filter::Main()
 
     for (;;)
     {
-        Sleep(0);
+        //Instead of yielding the processor after each cluster, wait for
+        //any streaming thread that is blocked on the lock to seize it.
+        //(A mutex is not handed off to a waiter when released, so without
+        //this we'd likely just re-seize the lock ourselves.)  The wait is
+        //bounded because the waiter might be seizing the lock for some
+        //other reason, or have given up.
+
+        if (m_cStreamingWaiters > 0)
+            WaitForSingleObject(m_hYield, 10);
 
 #if 0
         LONGLONG cluster_pos, new_pos;
@@ -1075,6 +1163,10 @@ unsigned Filter::Main()
         }
 
         const bool bDone = m_pSegment->DoneParsing();
+
+        const BOOL b = ResetEvent(m_hYield);  //lock is still held
+        b;
+        assert(b);
 #endif
 
         OnNewCluster();
@@ -1170,6 +1262,25 @@ void Filter::OnStarvation(ULONG count)
 }
 
 
+HRESULT Filter::SeizeStreamingLock(Lock& lock)
+{
+    //Called by an outpin's streaming thread.  Announce that we're waiting,
+    //so that the parser thread defers to us (see Main).
+
+    InterlockedIncrement(&m_cStreamingWaiters);
+
+    const HRESULT hr = lock.Seize(this);
+
+    InterlockedDecrement(&m_cStreamingWaiters);
+
+    const BOOL b = SetEvent(m_hYield);
+    b;
+    assert(b);
+
+    return hr;
+}
+
+
 void Filter::SetCurrPosition(
     LONGLONG currTime,
     DWORD dwCurr,
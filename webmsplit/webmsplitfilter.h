@@ -12,6 +12,7 @@
 #include <vector>
 #include "webmsplitinpin.h"
 #include "clockable.h"
+#include "ipipelinestats.h"
 
 namespace mkvparser
 {
@@ -26,6 +27,7 @@ namespace WebmSplit
 class Outpin;
 
 class Filter : public IBaseFilter,
+               public IPipelineStats,
                public CLockable
 {
     friend HRESULT CreateInstance(
@@ -63,6 +65,12 @@ public:
     HRESULT STDMETHODCALLTYPE JoinFilterGraph(IFilterGraph*, LPCWSTR);
     HRESULT STDMETHODCALLTYPE QueryVendorInfo(LPWSTR*);
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
     //local classes and methods
 
 private:
@@ -111,6 +119,8 @@ public:
     HRESULT OnDisconnectInpin();
     void OnStarvation(ULONG);
 
+    HRESULT SeizeStreamingLock(Lock&);
+
     HRESULT Open();
     void CreateOutpin(mkvparser::Stream*);
 
@@ -122,6 +132,9 @@ private:
     HANDLE m_hNewCluster;
     long m_cStarvation;
 
+    HANDLE m_hYield;  //signalled when a streaming thread seizes the lock
+    volatile LONG m_cStreamingWaiters;
+
     static unsigned __stdcall ThreadProc(void*);
     unsigned Main();
 
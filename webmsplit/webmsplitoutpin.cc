@@ -47,6 +47,17 @@ Outpin::Outpin(
 
     m_hNewCluster = CreateEvent(0, 0, 0, 0);
     assert(m_hNewCluster);  //TODO
+
+    LARGE_INTEGER freq;
+
+    const BOOL b = QueryPerformanceFrequency(&freq);
+    b;
+    assert(b);
+
+    m_freq = freq.QuadPart;
+    assert(m_freq > 0);
+
+    memset(&m_stats, 0, sizeof m_stats);
 }
 
 
@@ -160,6 +171,8 @@ void Outpin::StartThread()
     b = ResetEvent(m_hNewCluster);
     assert(b);
 
+    memset(&m_stats, 0, sizeof m_stats);
+
     const uintptr_t h = _beginthreadex(
                             0,  //security
                             0,  //stack size
@@ -195,6 +208,23 @@ void Outpin::StopThread()
 
     m_hThread = 0;
 
+#ifdef _DEBUG
+    const Stats& x = m_stats;
+
+    wodbgstream os;
+    os << L"WebmSplit::Outpin::StopThread: pin=" << m_id
+       << L" batches=" << x.batches
+       << L" blocks=" << x.blocks
+       << L" samples=" << x.samples
+       << L" max_batch=" << x.max_batch
+       << L" avg_batch="
+       << (x.batches ? double(x.blocks) / x.batches : 0.0)
+       << L" lock_us(avg)="
+       << (x.locks ? x.lock_us / x.locks : 0)
+       << L" lock_us(max)=" << x.max_lock_us
+       << endl;
+#endif
+
     hr = m_pPinConnection->EndFlush();
     assert(SUCCEEDED(hr));
 
@@ -427,18 +457,57 @@ HRESULT Outpin::Connect(
 
     GraphUtil::IMemAllocatorPtr pAllocator;
 
-    hr = pInputPin->GetAllocator(&pAllocator);
+    //We prefer our own allocator, because its samples can be made to
+    //point directly into the page cache of the reader, which avoids
+    //copying the frame (see MkvReader::LockFrame).  Those samples are
+    //read-only, so we only use our allocator if downstream accepts that.
 
-    if (FAILED(hr))
+    hr = CMediaSample::CreateAllocator(&pAllocator);
+
+    if (SUCCEEDED(hr))
     {
-        //hr = CMemAllocator::CreateInstance(&pAllocator);
-        hr = CMediaSample::CreateAllocator(&pAllocator);
+        hr = InitAllocator(pInputPin, pAllocator, TRUE);  //read-only
 
         if (FAILED(hr))
-            return VFW_E_NO_ALLOCATOR;
+            pAllocator = 0;
     }
 
-    assert(bool(pAllocator));
+    if (!bool(pAllocator))
+    {
+        hr = pInputPin->GetAllocator(&pAllocator);
+
+        if (FAILED(hr))
+        {
+            //hr = CMemAllocator::CreateInstance(&pAllocator);
+            hr = CMediaSample::CreateAllocator(&pAllocator);
+
+            if (FAILED(hr))
+                return VFW_E_NO_ALLOCATOR;
+        }
+
+        assert(bool(pAllocator));
+
+        hr = InitAllocator(pInputPin, pAllocator, 0);  //allow writes
+
+        if (FAILED(hr))
+            return hr;
+    }
+
+    m_pPinConnection = pin;
+    m_pAllocator = pAllocator;
+    m_pInputPin = pInputPin;
+
+    return S_OK;
+}
+
+
+HRESULT Outpin::InitAllocator(
+    IMemInputPin* pInputPin,
+    IMemAllocator* pAllocator,
+    BOOL bReadOnly)
+{
+    assert(pInputPin);
+    assert(pAllocator);
 
     ALLOCATOR_PROPERTIES props, actual;
 
@@ -447,7 +516,7 @@ HRESULT Outpin::Connect(
     props.cbAlign = -1;     //applies to prefix, too
     props.cbPrefix = -1;    //imediasample::getbuffer does NOT include prefix
 
-    hr = pInputPin->GetAllocatorRequirements(&props);
+    HRESULT hr = pInputPin->GetAllocatorRequirements(&props);
 
     m_pStream->UpdateAllocatorProperties(props);
 
@@ -456,15 +525,11 @@ HRESULT Outpin::Connect(
     if (FAILED(hr))
         return hr;
 
-    hr = pInputPin->NotifyAllocator(pAllocator, 0);  //allow writes
+    hr = pInputPin->NotifyAllocator(pAllocator, bReadOnly);
 
     if (FAILED(hr) && (hr != E_NOTIMPL))
         return hr;
 
-    m_pPinConnection = pin;
-    m_pAllocator = pAllocator;
-    m_pInputPin = pInputPin;
-
     return S_OK;
 }
 
@@ -1365,13 +1430,17 @@ unsigned Outpin::Main()
 
         long nProcessed;
 
+        m_pipeline_stats.OnQueueDepth(nSamples);
+
         hr = m_pInputPin->ReceiveMultiple(pSamples, nSamples, &nProcessed);
 
+        for (long i = 0; i < nProcessed; ++i)
+            m_pipeline_stats.OnOutput(pSamples[i]->GetActualDataLength());
+
         if (hr != S_OK)  //downstream filter says we're done
             break;
 
         mkvparser::Stream::Clear(samples);
-        Sleep(0);
     }
 
     mkvparser::Stream::Clear(samples);
@@ -1381,76 +1450,136 @@ unsigned Outpin::Main()
 
 HRESULT Outpin::PopulateSamples(mkvparser::Stream::samples_t& samples)
 {
+    //We populate a batch of blocks while holding the lock just once.  The
+    //buffers for the batch are requested without waiting, because we must
+    //not block on the allocator while holding the filter lock.  If there
+    //are no buffers even for the first block then we release the lock, wait
+    //for buffers, and then try again.
+
+    typedef mkvparser::Stream::samples_t samples_t;
+    samples_t block;
+
     for (;;)
     {
         assert(samples.empty());
+        assert(block.empty());
 
         Filter::Lock lock;
 
-        HRESULT hr = lock.Seize(m_pFilter);
+        HRESULT hr = m_pFilter->SeizeStreamingLock(lock);
 
         if (FAILED(hr))
             return hr;
 
-        long count;
+        LARGE_INTEGER t0;
+
+        BOOL b = QueryPerformanceCounter(&t0);
+        assert(b);
+
+        const LONGLONG dt_max = (m_freq * kMaxBatchTime) / 1000;
 
-        hr = m_pStream->GetSampleCount(count);
+        long nBlocks = 0;
 
-        if (SUCCEEDED(hr))
+        for (;;)
         {
-            if (hr != S_OK)  //EOS
-                return hr;
+            long count;
 
-            hr = lock.Release();
-            assert(SUCCEEDED(hr));
+            hr = m_pStream->GetSampleCount(count);
 
-            //We have a count.  Now get some (empty) buffers.
+            if (hr != S_OK)  //EOS or underflow
+                break;
 
-            samples.reserve(count);
+            hr = GetBuffers(count, AM_GBF_NOWAIT, block);
 
-            for (long idx = 0; idx < count; ++idx)
+            if (hr != S_OK)  //no buffers available right now
             {
-                IMediaSample* sample;
+                if (!samples.empty())
+                    break;  //send what we have
 
-                hr = m_pAllocator->GetBuffer(&sample, 0, 0, 0);
+                UpdateLockStats(t0.QuadPart);
 
-                if (hr != S_OK)
-                    return E_FAIL;  //we're done
-
-                samples.push_back(sample);
-            }
+                hr = lock.Release();
+                assert(SUCCEEDED(hr));
 
-            hr = lock.Seize(m_pFilter);
+                {
+                    const WebmUtil::PipelineStats::WaitTimer timer(
+                        m_pipeline_stats);
 
-            if (FAILED(hr))
-                return hr;
+                    hr = GetBuffers(count, 0, block);
+                }
 
-            //We have buffers.  Now populate them.
+                if (hr != S_OK)
+                    return E_FAIL;  //we're done
 
-            hr = m_pStream->PopulateSamples(samples);
+                hr = m_pFilter->SeizeStreamingLock(lock);
 
-            if (SUCCEEDED(hr))
-            {
-                if (hr != 2)
+                if (FAILED(hr))
+                {
+                    mkvparser::Stream::Clear(block);
                     return hr;
+                }
 
-                hr = lock.Release();
-                assert(SUCCEEDED(hr));
+                b = QueryPerformanceCounter(&t0);
+                assert(b);
+            }
 
-                mkvparser::Stream::Clear(samples);
+            {
+                const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+                hr = m_pStream->PopulateSamples(block);
+            }
+
+            if (hr == 2)  //no samples (or count changed), but not EOS
+            {
+                mkvparser::Stream::Clear(block);
                 continue;
             }
-            else
+
+            if (hr != S_OK)  //EOS, or error
             {
-                assert(SUCCEEDED(hr));
-                return hr;
+                mkvparser::Stream::Clear(block);
+                break;
             }
+
+            samples.insert(samples.end(), block.begin(), block.end());
+            block.clear();
+
+            if (++nBlocks >= kMaxBatchBlocks)
+                break;
+
+            LARGE_INTEGER t;
+
+            b = QueryPerformanceCounter(&t);
+            assert(b);
+
+            if ((t.QuadPart - t0.QuadPart) >= dt_max)
+                break;
+        }
+
+        if (!samples.empty())
+        {
+            Stats& x = m_stats;
+
+            ++x.batches;
+            x.blocks += nBlocks;
+            x.samples += static_cast<ULONG>(samples.size());
+
+            if (ULONG(nBlocks) > x.max_batch)
+                x.max_batch = nBlocks;
+
+            UpdateLockStats(t0.QuadPart);
+            return S_OK;  //EOS or error will be reported on next call
         }
 
         if (hr != VFW_E_BUFFER_UNDERFLOW)
+        {
+            UpdateLockStats(t0.QuadPart);
             return hr;
+        }
 
         m_pFilter->OnStarvation(m_pStream->GetClusterCount());
+        m_pipeline_stats.OnStarved();
+
+        UpdateLockStats(t0.QuadPart);
 
         hr = lock.Release();
         assert(SUCCEEDED(hr));
@@ -1470,6 +1599,66 @@ HRESULT Outpin::PopulateSamples(mkvparser::Stream::samples_t& samples)
 }
 
 
+HRESULT Outpin::GetBuffers(
+    long count,
+    DWORD flags,
+    mkvparser::Stream::samples_t& samples)
+{
+    assert(count > 0);
+    assert(samples.empty());
+
+    samples.reserve(count);
+
+    for (long idx = 0; idx < count; ++idx)
+    {
+        IMediaSample* sample;
+
+        const HRESULT hr = m_pAllocator->GetBuffer(&sample, 0, 0, flags);
+
+        if (hr != S_OK)
+        {
+            mkvparser::Stream::Clear(samples);
+            return FAILED(hr) ? hr : E_FAIL;
+        }
+
+        samples.push_back(sample);
+    }
+
+    return S_OK;
+}
+
+
+void Outpin::UpdateLockStats(LONGLONG t0)
+{
+    //lock is still held
+
+    LARGE_INTEGER t;
+
+    const BOOL b = QueryPerformanceCounter(&t);
+    b;
+    assert(b);
+
+    const LONGLONG dt = t.QuadPart - t0;
+    assert(dt >= 0);
+
+    const ULONGLONG us = (ULONGLONG(dt) * 1000000) / m_freq;
+
+    Stats& x = m_stats;
+
+    ++x.locks;
+    x.lock_us += us;
+
+    if (us > x.max_lock_us)
+        x.max_lock_us = us;
+}
+
+
+void Outpin::GetStats(Stats& x) const
+{
+    x = m_stats;
+}
+
+
 mkvparser::Stream* Outpin::GetStream() const
 {
     return m_pStream;
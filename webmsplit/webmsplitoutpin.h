@@ -35,6 +35,9 @@ protected:
 
     HRESULT PopulateSamples(mkvparser::Stream::samples_t&);
 
+    HRESULT GetBuffers(long, DWORD, mkvparser::Stream::samples_t&);
+    void UpdateLockStats(LONGLONG t0);
+
     mkvparser::Stream* m_pStream;
     GraphUtil::IMemAllocatorPtr m_pAllocator;
     GraphUtil::IMemInputPinPtr m_pInputPin;
@@ -124,6 +127,28 @@ public:
     mkvparser::Stream* GetStream() const;
     void OnNewCluster();
 
+    //Blocks are delivered downstream in batches (one ReceiveMultiple per
+    //batch), of up to kMaxBatchBlocks blocks, or as many blocks as can be
+    //populated in kMaxBatchTime ms.  The filter lock is held while the
+    //batch is populated.
+
+    enum { kMaxBatchBlocks = 8 };
+    enum { kMaxBatchTime = 5 };  //ms
+
+    struct Stats
+    {
+        ULONG batches;         //number of calls to ReceiveMultiple
+        ULONG blocks;          //total blocks delivered
+        ULONG samples;         //total samples (frames) delivered
+        ULONG max_batch;       //most blocks in a single batch
+        ULONG locks;           //number of times the lock was held
+        ULONGLONG lock_us;     //total time the lock was held
+        ULONGLONG max_lock_us; //longest time the lock was held
+    };
+
+    //Filter lock must be held.
+    void GetStats(Stats&) const;
+
 private:
     static unsigned __stdcall ThreadProc(void*);
     unsigned Main();
@@ -131,6 +156,11 @@ private:
     void StartThread();
     void StopThread();
 
+    Stats m_stats;
+    LONGLONG m_freq;  //QueryPerformanceFrequency
+
+    HRESULT InitAllocator(IMemInputPin*, IMemAllocator*, BOOL bReadOnly);
+
 };
 
 }  //end namespace WebmSplit
@@ -9,6 +9,7 @@
 #pragma once
 #include "cmediatypes.h"
 #include "graphutil.h"
+#include "pipelinestats.h"
 #include <string>
 
 namespace WebmSplit
@@ -31,6 +32,7 @@ public:
     CMediaTypes m_preferred_mtv;
     CMediaTypes m_connection_mtv;  //only one of these
     GraphUtil::IPinPtr m_pPinConnection;
+    WebmUtil::PipelineStats m_pipeline_stats;
 
     //IUnknown interface:
 
@@ -697,7 +697,12 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     }
 #endif
 
-    Decode(pInSample);
+    m_pipeline_stats.OnInput(pInSample->GetActualDataLength());
+
+    {
+        const WebmUtil::PipelineStats::Timer timer(m_pipeline_stats);
+        Decode(pInSample);
+    }
 
     hr = lock.Release();
     assert(SUCCEEDED(hr));
@@ -879,12 +884,18 @@ HRESULT Inpin::PopulateSamples()
     //Filter is NOT locked
 
     const Outpin& outpin = m_pFilter->m_outpin;
+    WebmUtil::PipelineStats& stats = m_pFilter->m_outpin.m_pipeline_stats;
 
     for (;;)
     {
         GraphUtil::IMediaSamplePtr pOutSample;
 
-        HRESULT hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        HRESULT hr;
+
+        {
+            const WebmUtil::PipelineStats::WaitTimer timer(stats);
+            hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        }
 
         if (FAILED(hr))
             return hr;
@@ -929,9 +940,13 @@ HRESULT Inpin::PopulateSamples()
         if (actual < target)
             return S_OK;
 
-        PopulateSample(pOutSample, target, *pwfx);
+        {
+            const WebmUtil::PipelineStats::Timer timer(stats);
+            PopulateSample(pOutSample, target, *pwfx);
+        }
 
         m_buffers.push_back(pOutSample.Detach());
+        stats.OnQueueDepth(static_cast<long>(m_buffers.size()));
 
         const BOOL b = SetEvent(m_hSamples);
         assert(b);
@@ -978,14 +978,19 @@ unsigned Outpin::Main()
                << endl;
 #endif
 
+            const long len = pSample->GetActualDataLength();
             const HRESULT hrReceive = m_pInputPin->Receive(pSample);
 
             if (hrReceive == S_OK)
+            {
+                m_pipeline_stats.OnOutput(len);
                 continue;
+            }
 
             inpin.OnCompletion();
         }
 
+        const WebmUtil::PipelineStats::WaitTimer timer(m_pipeline_stats);
         const DWORD dw = WaitForSingleObject(hSamples, INFINITE);
 
         if (dw == WAIT_FAILED)
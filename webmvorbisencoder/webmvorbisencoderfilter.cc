@@ -137,6 +137,10 @@ HRESULT Filter::CNondelegating::QueryInterface(
     {
         pUnk = static_cast<IBaseFilter*>(m_pFilter);
     }
+    else if (iid == __uuidof(IPipelineStats))
+    {
+        pUnk = static_cast<IPipelineStats*>(m_pFilter);
+    }
     else
     {
 #if 0
@@ -519,6 +523,36 @@ HRESULT Filter::QueryVendorInfo(LPWSTR* pstr)
 }
 
 
+ULONG Filter::GetStreamCount()
+{
+    return 2;  //one per pin
+}
+
+
+HRESULT Filter::GetStreamStats(ULONG index, Snapshot* p)
+{
+    if (p == 0)
+        return E_POINTER;
+
+    const Pin* const pins[] = { &m_inpin, &m_outpin };
+
+    if (index >= GetStreamCount())
+        return E_INVALIDARG;
+
+    pins[index]->m_pipeline_stats.GetSnapshot(*p);
+    return S_OK;
+}
+
+
+HRESULT Filter::ResetStats()
+{
+    m_inpin.m_pipeline_stats.Reset();
+    m_outpin.m_pipeline_stats.Reset();
+
+    return S_OK;
+}
+
+
 void Filter::OnStart()
 {
     m_inpin.Start();
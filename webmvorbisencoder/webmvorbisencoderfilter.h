@@ -12,11 +12,13 @@
 #include "webmvorbisencoderinpin.h"
 #include "webmvorbisencoderoutpin.h"
 #include "clockable.h"
+#include "ipipelinestats.h"
 
 namespace WebmVorbisEncoderLib
 {
 
 class Filter : public IBaseFilter,
+               public IPipelineStats,
                public CLockable
 {
     friend HRESULT CreateInstance(
@@ -54,6 +56,12 @@ public:
     HRESULT STDMETHODCALLTYPE JoinFilterGraph(IFilterGraph*, LPCWSTR);
     HRESULT STDMETHODCALLTYPE QueryVendorInfo(LPWSTR*);
 
+    //IPipelineStats
+
+    ULONG STDMETHODCALLTYPE GetStreamCount();
+    HRESULT STDMETHODCALLTYPE GetStreamStats(ULONG, Snapshot*);
+    HRESULT STDMETHODCALLTYPE ResetStats();
+
 private:
     class CNondelegating : public IUnknown
     {
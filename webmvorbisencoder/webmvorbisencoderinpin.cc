@@ -369,9 +369,8 @@ HRESULT Inpin::EndOfStream()
 
     m_bEndOfStream = true;
 
-    const int status = vorbis_analysis_wrote(&m_dsp_state, 0);  //means "EOS"
-    status;
-    assert(status == 0);
+    if (!m_pipeline.WriteEnd())
+        return E_FAIL;
 
     hr = lock.Release();
     assert(SUCCEEDED(hr));
@@ -379,7 +378,7 @@ HRESULT Inpin::EndOfStream()
     if (FAILED(hr))
         return hr;
 
-    return PopulateSamples();
+    return PopulateSamples(true);  //wait for the last packet
 }
 
 
@@ -516,6 +515,11 @@ HRESULT Inpin::EndFlush()
             pSample->Release();
     }
 
+    //The packets that were encoded during the flush are discarded too.
+
+    WebmUtil::VorbisEncodePipeline::packets_t packets;
+    m_pipeline.Read(packets, false);
+
     Outpin& outpin = m_pFilter->m_outpin;
 
     if (IPin* const pPin = outpin.m_pPinConnection)
@@ -807,7 +811,15 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     }
 #endif
 
-    Encode(pInSample);
+    //Only the analysis is timed (by the pipeline, on whichever thread
+    //runs it); handing the samples over is not a stage of its own.
+
+    m_pipeline_stats.OnInput(pInSample->GetActualDataLength());
+
+    hr = Encode(pInSample);
+
+    if (FAILED(hr))
+        return hr;
 
     hr = lock.Release();
     assert(SUCCEEDED(hr));
@@ -815,18 +827,18 @@ HRESULT Inpin::Receive(IMediaSample* pInSample)
     if (FAILED(hr))
         return hr;
 
-    return PopulateSamples();
+    return PopulateSamples(false);
 }
 
 
-void Inpin::Encode(IMediaSample* s)
+HRESULT Inpin::Encode(IMediaSample* s)
 {
     assert(s);
 
     const long len = s->GetActualDataLength();
 
     if (len <= 0)
-        return;
+        return S_OK;
 
     const int channels = m_info.channels;
     assert(channels > 0);
@@ -837,54 +849,53 @@ void Inpin::Encode(IMediaSample* s)
     const long block_count = len / block_align;
     assert(block_count > 0);  //distinguished value 0 means "end of stream"
 
-    const long sample_count = len / sizeof(float);
-    assert(sample_count > 0);
-
     BYTE* buf;
 
     HRESULT hr = s->GetPointer(&buf);
     assert(SUCCEEDED(hr));
     assert(buf);
 
-    const float* const src_begin = reinterpret_cast<float*>(buf);
-    const float* src = src_begin;
-
-    const float* const src_end = src_begin + sample_count;
-    src_end;
-
-    float** dst = vorbis_analysis_buffer(&m_dsp_state, block_count);
-    assert(dst);
+    const float* const src = reinterpret_cast<float*>(buf);
 
     //TODO: verify left-right channel order issue
     //TODO: extend to channels > 2
 
-    for (int block = 0; block < block_count; ++block)
-        for (int channel = 0; channel < channels; ++channel)
-        {
-            memcpy(dst[channel] + block, src, sizeof(float));
-            ++src;
-        }
+    //The pipeline deinterleaves the samples into the analysis buffer (on
+    //its worker thread, if it has one).
 
-    assert(src == src_end);
-    assert((src_end - src_begin) / channels == block_count);
+    if (!m_pipeline.Write(src, block_count))
+        return E_FAIL;
 
-    const int status = vorbis_analysis_wrote(&m_dsp_state, block_count);
-    status;
-    assert(status == 0);
+    return S_OK;
 }
 
 
-HRESULT Inpin::PopulateSamples()
+HRESULT Inpin::PopulateSamples(bool wait)
 {
     //Filter is NOT locked
 
-    const Outpin& outpin = m_pFilter->m_outpin;
+    Outpin& outpin = m_pFilter->m_outpin;
+    WebmUtil::PipelineStats& stats = outpin.m_pipeline_stats;
 
-    for (;;)
+    //The packets that the pipeline has encoded so far.  If we're at the
+    //end of the stream, wait for the rest of them.
+
+    typedef WebmUtil::VorbisEncodePipeline::packets_t packets_t;
+    packets_t packets;
+
+    if (!m_pipeline.Read(packets, wait))
+        return E_FAIL;
+
+    while (!packets.empty())
     {
         GraphUtil::IMediaSamplePtr pOutSample;
 
-        HRESULT hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        HRESULT hr;
+
+        {
+            const WebmUtil::PipelineStats::WaitTimer timer(stats);
+            hr = outpin.m_pAllocator->GetBuffer(&pOutSample, 0, 0, 0);
+        }
 
         if (FAILED(hr))
             return hr;
@@ -921,37 +932,22 @@ HRESULT Inpin::PopulateSamples()
         //if (!bool(outpin.m_pAllocator))  //weird
         //    return S_FALSE;
 
-        int status = vorbis_analysis_blockout(&m_dsp_state, &m_block);
+        //NOTE: this assumes that if we request EOS, then the encoder
+        //pushes out at least one packet, with the EOS indication
+        //specified.
 
-        if (status < 0)  //error
-            return E_FAIL;
-
-        if (status == 0)  //no block available
-        {
-#if 0  //see test below
-            //NOTE: commenting out this branch assumes
-            //that if we request EOS, then the encoder pushes
-            //out at least one packet, with the EOS indication
-            //specified.
-
-            if (m_bEndOfStream)
-            {
-                m_buffers.push_back(0);
-
-                const BOOL b = SetEvent(m_hSamples);
-                b;
-                assert(b);
-            }
-#endif
-            return S_OK;
-        }
-
-        //status=1 means "success, more blocks available"
+        const WebmUtil::VorbisEncodePipeline::Packet& p = packets.front();
+        assert(!p.data.empty());
 
         ogg_packet pkt;
 
-        status = vorbis_analysis(&m_block, &pkt);
-        assert(status == 0);
+        pkt.packet = const_cast<unsigned char*>(&p.data[0]);
+        pkt.bytes = static_cast<long>(p.data.size());
+        pkt.b_o_s = 0;
+        pkt.e_o_s = p.eos ? 1 : 0;
+        pkt.granulepos = p.granulepos;
+        pkt.packetno = p.packetno;
+
         //TODO: vet seq no.
 
         PopulateSample(pOutSample, pkt);
@@ -961,13 +957,19 @@ HRESULT Inpin::PopulateSamples()
         if (pkt.e_o_s)
             m_buffers.push_back(0);
 
+        stats.OnQueueDepth(static_cast<long>(m_buffers.size()));
+
         const BOOL b = SetEvent(m_hSamples);
         b;
         assert(b);
 
         if (pkt.e_o_s)
             return S_OK;
+
+        packets.pop_front();
     }
+
+    return S_OK;
 }
 
 
@@ -1077,6 +1079,9 @@ int Inpin::GetSample(IMediaSample** ppSample)
     pSample = m_buffers.front();
     m_buffers.pop_front();
 
+    m_pFilter->m_outpin.m_pipeline_stats.OnQueueDepth(
+        static_cast<long>(m_buffers.size()));
+
     if (pSample)
         return 1;
 
@@ -1132,6 +1137,8 @@ HRESULT Inpin::OnDisconnect()
 
     if (m_info.channels > 0)
     {
+        m_pipeline.Stop();
+
         vorbis_block_clear(&m_block);
         vorbis_dsp_clear(&m_dsp_state);
         vorbis_info_clear(&m_info);
@@ -1198,12 +1205,40 @@ void Inpin::Start()
 
         result = vorbis_block_init(&m_dsp_state, &m_block);
         assert(result == 0);
+
+        //The analysis gets a thread of its own if there's another core
+        //for it to run on.  The output is the same either way.
+
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+
+        const bool threaded = (info.dwNumberOfProcessors > 1);
+        const long max_pending = m_info.rate / 2;  //frames
+
+        if (!m_pipeline.Start(&m_dsp_state,
+                              &m_block,
+                              m_info.channels,
+                              threaded,
+                              max_pending,
+                              &m_pipeline_stats))
+        {
+            const bool b = m_pipeline.Start(&m_dsp_state,
+                                            &m_block,
+                                            m_info.channels,
+                                            false,  //no thread
+                                            max_pending,
+                                            &m_pipeline_stats);
+            b;
+            assert(b);
+        }
     }
 }
 
 
 void Inpin::Stop()
 {
+    m_pipeline.Stop();  //waits for the worker
+
     while (!m_buffers.empty())
     {
         IMediaSample* const pSample = m_buffers.front();
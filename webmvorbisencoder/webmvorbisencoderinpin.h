@@ -9,6 +9,7 @@
 #pragma once
 #include "webmvorbisencoderpin.h"
 #include "graphutil.h"
+#include "vorbisencodepipeline.h"
 #include "vorbis/codec.h"
 #include <vector>
 #include <deque>
@@ -111,6 +112,10 @@ private:
     vorbis_dsp_state m_dsp_state;
     vorbis_block m_block;
 
+    //Runs the analysis on a worker thread, while the graph is running
+    //(see Start), so that Receive only has to queue the PCM.
+    WebmUtil::VorbisEncodePipeline m_pipeline;
+
     LONGLONG m_first_reftime;
     LONGLONG m_start_reftime;
     LONGLONG m_start_samples;
@@ -125,8 +130,8 @@ private:
         const ogg_packet& comment,
         const ogg_packet& code);
 
-    void Encode(IMediaSample*);
-    HRESULT PopulateSamples();
+    HRESULT Encode(IMediaSample*);
+    HRESULT PopulateSamples(bool wait);
     void PopulateSample(IMediaSample*, const ogg_packet&);
 
 };
@@ -963,6 +963,8 @@ unsigned Outpin::Main()
                << endl;
 #endif
 
+            m_pipeline_stats.OnOutput(pSample->GetActualDataLength());
+
             const HRESULT hrReceive = m_pInputPin->Receive(pSample);
 
             if (hrReceive == S_OK)
@@ -971,6 +973,7 @@ unsigned Outpin::Main()
             inpin.OnCompletion();
         }
 
+        const WebmUtil::PipelineStats::WaitTimer timer(m_pipeline_stats);
         const DWORD dw = WaitForSingleObject(hSamples, INFINITE);
 
         if (dw == WAIT_FAILED)
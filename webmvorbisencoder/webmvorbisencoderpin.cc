@@ -25,7 +25,8 @@ Pin::Pin(
     const wchar_t* id) :
     //m_pFilter(pFilter),
     m_dir(dir),
-    m_id(id)
+    m_id(id),
+    m_pipeline_stats(id)
 {
 }
 
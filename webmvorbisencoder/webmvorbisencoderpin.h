@@ -10,6 +10,7 @@
 #include "cmediatypes.h"
 #include "graphutil.h"
 #include "clockable.h"
+#include "pipelinestats.h"
 #include <string>
 
 namespace WebmVorbisEncoderLib
@@ -32,6 +33,7 @@ public:
     CMediaTypes m_preferred_mtv;
     CMediaTypes m_connection_mtv;  //only one of these
     GraphUtil::IPinPtr m_pPinConnection;
+    WebmUtil::PipelineStats m_pipeline_stats;
 
     //IUnknown interface:
 